@@ -3,10 +3,23 @@
 #include <debug.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include "devices/pci.h"
+#include "devices/ramdisk.h"
 #include "devices/timer.h"
+#include "devices/virtio-blk.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "threads/mmu.h"
+#endif
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -14,6 +27,7 @@
 /* ATA command block port addresses. */
 #define reg_data(CHANNEL) ((CHANNEL)->reg_base + 0)     /* Data. */
 #define reg_error(CHANNEL) ((CHANNEL)->reg_base + 1)    /* Error. */
+#define reg_features(CHANNEL) reg_error (CHANNEL)       /* Features (w/o). */
 #define reg_nsect(CHANNEL) ((CHANNEL)->reg_base + 2)    /* Sector Count. */
 #define reg_lbal(CHANNEL) ((CHANNEL)->reg_base + 3)     /* LBA 0:7. */
 #define reg_lbam(CHANNEL) ((CHANNEL)->reg_base + 4)     /* LBA 15:8. */
@@ -32,6 +46,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +62,66 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+#define CMD_READ_DMA 0xc8               /* READ DMA. */
+#define CMD_WRITE_DMA 0xca              /* WRITE DMA. */
+#define CMD_READ_SECTOR_EXT 0x24        /* READ SECTOR EXT (LBA48). */
+#define CMD_READ_DMA_EXT 0x25           /* READ DMA EXT. */
+#define CMD_READ_MULTIPLE_EXT 0x29      /* READ MULTIPLE EXT. */
+#define CMD_WRITE_SECTOR_EXT 0x34       /* WRITE SECTOR EXT. */
+#define CMD_WRITE_DMA_EXT 0x35          /* WRITE DMA EXT. */
+#define CMD_WRITE_MULTIPLE_EXT 0x39     /* WRITE MULTIPLE EXT. */
+#define CMD_SET_FEATURES 0xef           /* SET FEATURES. */
+#define CMD_FLUSH_CACHE 0xe7            /* FLUSH CACHE. */
+#define CMD_FLUSH_CACHE_EXT 0xea        /* FLUSH CACHE EXT (LBA48). */
+
+/* SET FEATURES의 features register 값. */
+#define FEAT_WCACHE_ON 0x02             /* write cache를 켠다. */
+
+/*** GrilledSalmon ***/
+/* Bus-master IDE 레지스터. 채널마다 8바이트씩 BAR4 뒤에 붙어 있다. */
+#define reg_bm_command(CHANNEL) ((CHANNEL)->bm_base + 0) /* Command. */
+#define reg_bm_status(CHANNEL) ((CHANNEL)->bm_base + 2)  /* Status. */
+#define reg_bm_prdt(CHANNEL) ((CHANNEL)->bm_base + 4)    /* PRDT 물리 주소. */
+
+/* Bus-master Command 레지스터 비트. */
+#define BM_CMD_START 0x01       /* 전송 시작/정지. */
+#define BM_CMD_READ 0x08        /* 1=디스크에서 메모리로. */
+
+/* Bus-master Status 레지스터 비트 (1을 써서 지운다). */
+#define BM_STA_ACTIVE 0x01      /* 전송 중. */
+#define BM_STA_ERR 0x02         /* 전송 오류. */
+#define BM_STA_INTR 0x04        /* 디스크가 인터럽트를 올렸다. */
+
+/* Physical Region Descriptor.  한 항목은 64 kB 경계를 넘지 않는
+   물리적으로 연속된 구간 하나를 가리킨다. */
+struct prd {
+	uint32_t addr;              /* 구간의 물리 주소 (짝수). */
+	uint16_t size;              /* 바이트 수, 0이면 64 kB. */
+	uint16_t flags;             /* PRD_EOT면 마지막 항목. */
+};
+#define PRD_EOT 0x8000
+/* 한 명령으로 묶는 요청 수의 상한. */
+#define MERGE_MAX 8
+
+/* 채널당 PRDT 항목 수. 묶인 요청마다 64 kB 경계에 걸쳐 두 번까지
+   끊기고 모두 합쳐 128 kB를 넘지 않으므로 MERGE_MAX + 2개면 되며,
+   테이블 정렬을 위해 2의 거듭제곱으로 둔다. */
+#define PRD_CNT 16
+
+/* deadline scheduler에서 read가 기다릴 수 있는 최대 tick 수 (50 ms). */
+#define DEADLINE_READ_TICKS (TIMER_FREQ / 20 > 0 ? TIMER_FREQ / 20 : 1)
+
+/*** GrilledSalmon ***/
+/* prio scheduler에서 기다리는 요청의 우선순위가 한 단계 오르는 tick 수 (20 ms).
+   PRI_MIN의 요청도 PRI_MAX만큼 기다리면 누구에게도 밀리지 않는다. */
+#define PRIO_AGE_TICKS (TIMER_FREQ / 50 > 0 ? TIMER_FREQ / 50 : 1)
+
+/*** GrilledSalmon ***/
+/* 요청 latency histogram의 칸 수. I번째 칸은 2^I 이상 2^(I+1) 미만 cycle. */
+#define DISK_LATENCY_BUCKETS 40
 
 /* An ATA device. */
 struct disk {
@@ -59,8 +134,37 @@ struct disk {
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	bool dma;                   /*** GrilledSalmon ***/ /* DMA 전송을 지원하는가. */
+	size_t multiple;            /* PIO 인터럽트 한 번에 옮기는 sector 수. */
+	bool lba48;                 /* 48-bit LBA 명령을 지원하는가. */
+	bool write_cache;           /* write cache를 켰다. disk_flush가 FLUSH를 보낸다. */
+	long long flush_cnt;        /* 보낸 FLUSH CACHE 수. */
+
+	/*** GrilledSalmon ***/
+	/* 통계. 시간은 TSC cycle이고, 인터럽트를 끄고 바꾼다. */
+	long long req_cnt;          /* 끝난 요청 수. */
+	long long cmd_cnt;          /* 디스크에 보낸 명령 수. */
+	uint64_t busy_cycles;       /* 디스크가 명령을 처리한 시간의 합. */
+	uint64_t latency_cycles;    /* 요청마다 submit에서 완료까지 걸린 시간의 합. */
+	long long latency[DISK_LATENCY_BUCKETS];    /* 그 log2 histogram. */
+	int depth;                  /* 기다리거나 처리 중인 요청 수. */
+	int max_depth;              /* depth의 최댓값. */
+	uint64_t depth_area;        /* depth를 시간으로 적분한 값. */
+	uint64_t depth_since;       /* depth_area를 마지막으로 더한 시각. */
+	uint64_t seek_sectors;      /* 명령 사이에 head가 옮겨 간 sector 수의 합. */
+	disk_sector_t last_end;     /* 마지막 명령이 끝난 sector. */
+
+	/*** GrilledSalmon ***/
+	/* NULL이 아니면 이 자리는 IDE 대신 virtio-blk 장치가 맡는다. */
+	struct virtio_blk *vblk;
+	uint64_t busy_since;        /* virtio, RAM: depth가 0에서 올라간 시각. */
+	struct ramdisk *ram;        /* NULL이 아니면 메모리에 담는 디스크다. */
 };
 
+/*** GrilledSalmon ***/
+/* SET MULTIPLE MODE로 설정할 블록 크기의 상한 (sector 수). */
+#define MULTIPLE_MAX 16
+
 /* An ATA channel (aka controller).
    Each channel can control up to two disks. */
 struct channel {
@@ -68,38 +172,115 @@ struct channel {
 	uint16_t reg_base;          /* Base I/O port. */
 	uint8_t irq;                /* Interrupt in use. */
 
-	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
+
+	/*** GrilledSalmon ***/
+	uint16_t bm_base;           /* Bus-master I/O 포트, 0이면 PIO만 쓴다. */
+	struct prd *prdt;           /* 이 채널의 PRD 테이블. */
+
+	/* 요청 큐. 인터럽트를 끄고 접근한다. */
+	struct list queue;          /* 기다리는 struct disk_request. */
+	struct list batch;          /* 한 명령으로 처리 중인 요청들, sector 순. */
+	size_t batch_cnt;           /* batch의 sector 수. */
+	size_t done_cnt;            /* batch에서 옮긴 sector 수 (PIO). */
+	struct list_elem *cur;      /* PIO가 채우는 batch의 요청. */
+	size_t cur_done;            /* cur에서 옮긴 sector 수. */
+	bool use_dma;               /* batch를 DMA로 보냈다. */
+	uint64_t head;              /* 마지막 명령이 끝난 (장치, sector). */
+	uint64_t cmd_start;         /* batch를 디스크에 보낸 시각 (TSC). */
+
+	/* 장치 검사. disk_init이 채널마다 스레드를 띄워 동시에 한다. */
+	bool probed;                /* 검사가 끝났으면 true. */
+	struct semaphore probe_done; /* 검사가 끝나면 올라가고 그대로 둔다. */
+};
+
+/*** GrilledSalmon ***/
+/* I/O scheduler. add는 요청을 채널의 큐에 넣고, pick은 큐가 비어 있지
+   않을 때 다음에 보낼 요청을 고른다. 둘 다 인터럽트를 끄고 불린다. */
+struct iosched {
+	const char *name;
+	void (*add) (struct channel *, struct disk_request *);
+	struct disk_request *(*pick) (struct channel *);
 };
 
 /* We support the two "legacy" ATA channels found in a standard PC. */
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
 
+/*** GrilledSalmon ***/
+/* -ramdisk로 RAM disk를 붙일 자리와 그 크기 (MB). 크기가 0이면 원래
+   디스크의 크기, 원래 디스크가 없으면 RAMDISK_DEFAULT_MB를 쓴다. */
+static bool ram_wanted[CHANNEL_CNT][2];
+static unsigned ram_mb[CHANNEL_CNT][2];
+
+/*** GrilledSalmon ***/
+/* 통계를 세기 시작한 시각 (TSC). */
+static uint64_t stats_start;
+
+/*** GrilledSalmon ***/
+/* 채널별 PRD 테이블. 테이블 크기로 정렬해 두면 64 kB 경계를
+   넘지 않는다는 bus-master 요구 사항이 저절로 만족된다. */
+static struct prd prdts[CHANNEL_CNT][PRD_CNT]
+	__attribute__ ((aligned (PRD_CNT * sizeof (struct prd))));
+
+static uint16_t find_bus_master (void);
+static bool build_prdt (struct channel *);
+static const struct iosched *iosched;
+
+static void transfer (struct disk *, disk_sector_t, void *, size_t,
+		bool write);
+static void start_request (struct channel *);
+static void transfer_block (struct channel *);
+static void advance_request (struct channel *);
+
+static void print_disk_timing (struct disk *);
+static void account_request (struct disk_request *, uint64_t now);
+static void attach_virtio (struct virtio_blk *);
+static void attach_ramdisk (struct disk *, unsigned mb);
+static void depth_update (struct disk *, uint64_t now);
+
+static void probe_channel (void *);
 static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
+static void set_multiple_mode (struct disk *, size_t max);
+static void set_write_cache (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static bool select_sector (struct disk *, disk_sector_t, size_t);
+static uint8_t rw_command (const struct disk *, bool lba48, bool dma,
+		bool write);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
 
 static void wait_until_idle (const struct disk *);
 static bool wait_while_busy (const struct disk *);
+static bool spin_while_busy (const struct disk *);
 static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
 
+/*** GrilledSalmon ***/
+/* 끝났지만 아직 done을 부르지 않은 요청들. 인터럽트를 꺼서 지킨다. */
+static struct list done_list;
+static struct work done_work;
+static void run_done (void *aux);
+
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
 	size_t chan_no;
+	uint16_t bm_base = find_bus_master ();
+	struct virtio_blk *vb;
+
+	stats_start = rdtsc ();
+	list_init (&done_list);
+	work_init (&done_work, run_done, NULL);
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
 		struct channel *c = &channels[chan_no];
@@ -119,9 +300,13 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		c->bm_base = bm_base != 0 ? bm_base + chan_no * 8 : 0;
+		c->prdt = prdts[chan_no];
+		list_init (&c->queue);
+		list_init (&c->batch);
+		c->head = 0;
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -134,24 +319,38 @@ disk_init (void) {
 			d->capacity = 0;
 
 			d->read_cnt = d->write_cnt = 0;
+			d->dma = false;
+			d->multiple = 1;
+			d->lba48 = false;
+			memset (d->latency, 0, sizeof d->latency);
+			d->req_cnt = d->cmd_cnt = 0;
+			d->busy_cycles = d->latency_cycles = 0;
+			d->depth = d->max_depth = 0;
+			d->depth_area = 0;
+			d->depth_since = stats_start;
+			d->seek_sectors = 0;
+			d->last_end = 0;
+			d->vblk = NULL;
+			d->ram = NULL;
 		}
 
 		/* Register interrupt handler. */
 		intr_register_ext (c->irq, interrupt_handler, c->name);
 
-		/* Reset hardware. */
-		reset_channel (c);
-
-		/* Distinguish ATA hard disks from other devices. */
-		if (check_device_type (&c->devices[0]))
-			check_device_type (&c->devices[1]);
-
-		/* Read hard disk identity information. */
-		for (dev_no = 0; dev_no < 2; dev_no++)
-			if (c->devices[dev_no].is_ata)
-				identify_ata_device (&c->devices[dev_no]);
+		/* Reset and identify the hardware in the background.  The
+		   reset sleeps for at least 150 ms per channel, so the
+		   channels are probed at the same time, and disk_get()
+		   waits only for the channel it asks about. */
+		c->probed = false;
+		sema_init (&c->probe_done, 0);
+		if (thread_create (c->name, PRI_DEFAULT, probe_channel, c) == TID_ERROR)
+			probe_channel (c);
 	}
 
+	/*** GrilledSalmon ***/
+	while ((vb = virtio_blk_probe ()) != NULL)
+		attach_virtio (vb);
+
 	/* DO NOT MODIFY BELOW LINES. */
 	register_disk_inspect_intr ();
 }
@@ -166,13 +365,78 @@ disk_print_stats (void) {
 
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
-			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
+			if (d != NULL) {
+				printf ("%s: %lld reads, %lld writes",
 						d->name, d->read_cnt, d->write_cnt);
+				if (d->flush_cnt > 0)
+					printf (", %lld flushes", d->flush_cnt);
+				printf ("\n");
+				print_disk_timing (d);
+			}
 		}
 	}
 }
 
+/*** GrilledSalmon ***/
+/* D의 시간 통계를 출력한다. 장치가 바빴던 비율과 요청 latency(평균과
+   p99의 상한)를 보면 병목이 디스크인지 커널인지 알 수 있다. */
+static void
+print_disk_timing (struct disk *d) {
+	enum intr_level old_level;
+	uint64_t now, elapsed;
+	long long p99_rank, seen = 0;
+	int b;
+
+	if (d->req_cnt == 0)
+		return;
+
+	old_level = intr_disable ();
+	now = rdtsc ();
+	depth_update (d, now);
+	intr_set_level (old_level);
+
+	elapsed = now - stats_start > 0 ? now - stats_start : 1;
+	p99_rank = d->req_cnt - d->req_cnt / 100;
+	for (b = 0; b < DISK_LATENCY_BUCKETS - 1; b++) {
+		seen += d->latency[b];
+		if (seen >= p99_rank)
+			break;
+	}
+
+	printf ("  %lld requests in %lld commands, %lld sectors/request, "
+			"busy %llu%%\n",
+			d->req_cnt, d->cmd_cnt,
+			(d->read_cnt + d->write_cnt) / d->req_cnt,
+			(unsigned long long) (d->busy_cycles * 100 / elapsed));
+	printf ("  latency avg %llu cycles, p99 < %llu cycles; "
+			"queue depth avg %llu.%02llu, max %d; "
+			"seek avg %llu sectors\n",
+			(unsigned long long) (d->latency_cycles / d->req_cnt),
+			1ULL << (b + 1),
+			(unsigned long long) (d->depth_area / elapsed),
+			(unsigned long long) (d->depth_area * 100 / elapsed % 100),
+			d->max_depth,
+			(unsigned long long) (d->seek_sectors / d->cmd_cnt));
+}
+
+/* D의 queue 깊이가 NOW까지 그대로였다고 보고 depth_area에 더한다.
+   인터럽트를 끄고 부른다. */
+static void
+depth_update (struct disk *d, uint64_t now) {
+	d->depth_area += (uint64_t) d->depth * (now - d->depth_since);
+	d->depth_since = now;
+}
+
+/* Stores the number of sectors read from and written to D in
+   *READ_CNT and *WRITE_CNT. */
+void
+disk_get_stats (struct disk *d, long long *read_cnt, long long *write_cnt) {
+	ASSERT (d != NULL);
+
+	*read_cnt = d->read_cnt;
+	*write_cnt = d->write_cnt;
+}
+
 /* Returns the disk numbered DEV_NO--either 0 or 1 for master or
    slave, respectively--within the channel numbered CHAN_NO.
 
@@ -187,8 +451,21 @@ disk_get (int chan_no, int dev_no) {
 	ASSERT (dev_no == 0 || dev_no == 1);
 
 	if (chan_no < (int) CHANNEL_CNT) {
-		struct disk *d = &channels[chan_no].devices[dev_no];
-		if (d->is_ata)
+		struct channel *c = &channels[chan_no];
+		struct disk *d = &c->devices[dev_no];
+
+		/* virtio-blk 장치는 disk_init에서 이미 붙였다. */
+		if (d->vblk != NULL && !ram_wanted[chan_no][dev_no])
+			return d;
+		/* 검사 중인 채널은 끝날 때까지 기다린다. 인터럽트 안에서는
+		   기다릴 수 없으므로 아직 없는 것으로 본다. */
+		if (!c->probed) {
+			if (intr_context ())
+				return NULL;
+			sema_down (&c->probe_done);
+			sema_up (&c->probe_done);
+		}
+		if (d->is_ata || d->ram != NULL || d->vblk != NULL)
 			return d;
 	}
 	return NULL;
@@ -210,21 +487,24 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
+	disk_read_multiple (d, sec_no, buffer, 1);
+}
 
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes, using a single READ command.  CNT must be between 1 and
+   DISK_MAX_SECTORS.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt) {
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	TRACE (disk_read, sec_no, cnt);
+	transfer (d, sec_no, buffer, cnt, false);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -234,27 +514,701 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
-	struct channel *c;
+	disk_write_multiple (d, sec_no, buffer, 1);
+}
 
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes,
+   using a single WRITE command.  CNT must be between 1 and
+   DISK_MAX_SECTORS.  Returns after the disk has acknowledged
+   receiving all of the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, const void *buffer,
+		size_t cnt) {
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
-	lock_release (&c->lock);
+	TRACE (disk_write, sec_no, cnt);
+	transfer (d, sec_no, (void *) buffer, cnt, true);
 }
-
+
+/*** GrilledSalmon ***/
+/* Asynchronous requests. */
+
+/* R을 DISK의 SECTOR부터 CNT개 sector를 BUFFER와 주고받는 요청으로
+   초기화한다. WRITE가 true면 디스크에 쓴다. 전송이 끝나면 인터럽트
+   처리기 안에서 DONE(R)이 불린다. */
+void
+disk_request_init (struct disk_request *r, struct disk *d,
+		disk_sector_t sector, void *buffer, size_t cnt, bool write,
+		disk_done_func *done, void *aux) {
+	r->disk = d;
+	r->sector = sector;
+	r->buffer = buffer;
+	r->cnt = cnt;
+	r->write = write;
+	r->done = done;
+	r->aux = aux;
+	r->flush = false;
+}
+
+/* R을 디스크 채널의 큐에 넣고 기다리지 않고 돌아온다. 채널이 놀고
+   있으면 바로 디스크에 보낸다. R과 R->buffer는 R->done이 불릴 때까지
+   살아 있어야 하며, 인터럽트 처리기가 접근하므로 R->buffer는 커널
+   주소여야 한다. 인터럽트 처리기 안에서 불러도 된다. */
+void
+disk_submit (struct disk_request *r) {
+	struct channel *c;
+	enum intr_level old_level;
+
+	ASSERT (r->disk != NULL);
+	ASSERT (r->flush || (r->buffer != NULL && is_kernel_vaddr (r->buffer)));
+	ASSERT (r->flush || (r->cnt > 0 && r->cnt <= DISK_MAX_SECTORS));
+	ASSERT (r->done != NULL);
+
+#ifdef USERPROG
+	/* 보낸 스레드의 프로세스, 또는 그 스레드가 대신 일하는 프로세스에 센다. */
+	if (!intr_context ()) {
+		struct thread *t = thread_current ();
+
+		if (t->io_owner != NULL)
+			t = t->io_owner;
+		if (r->write)
+			t->rusage.oublock += r->cnt;
+		else
+			t->rusage.inblock += r->cnt;
+	}
+#endif
+
+	/*** GrilledSalmon ***/
+	/* 보낸 스레드의 지금 우선순위. lock을 기다리는 스레드에게 donation을 받고
+	   있으면 그만큼 오른 값이다. 인터럽트 처리기가 보낸 요청은 보통으로 둔다. */
+	r->priority = PRI_DEFAULT;
+	if (!intr_context ()) {
+		struct thread *t = thread_current ();
+
+#ifdef USERPROG
+		if (t->io_owner != NULL && t->io_owner->priority > t->priority)
+			t = t->io_owner;
+#endif
+		r->priority = t->priority;
+	}
+
+	c = r->disk->channel;
+	old_level = intr_disable ();
+	r->submitted = timer_ticks ();
+	r->submit_tsc = rdtsc ();
+	depth_update (r->disk, r->submit_tsc);
+	if (++r->disk->depth > r->disk->max_depth)
+		r->disk->max_depth = r->disk->depth;
+	if (r->disk->ram != NULL) {
+		/*** GrilledSalmon ***/
+		/* RAM disk는 그 자리에서 복사하고 바로 끝낸다. */
+		struct disk *d = r->disk;
+
+		if (d->depth == 1)
+			d->busy_since = r->submit_tsc;
+		d->cmd_cnt++;
+		intr_set_level (old_level);
+		ramdisk_transfer (d->ram, r->sector, r->buffer, r->cnt, r->write);
+		old_level = intr_disable ();
+		disk_request_complete (r);
+	} else if (r->disk->vblk != NULL) {
+		/* virtio-blk는 요청을 여러 개 한꺼번에 받으므로 바로 넘긴다.
+		   장치가 요청을 받고 있는 시간을 busy로 센다. */
+		struct disk *d = r->disk;
+
+		if (d->depth == 1)
+			d->busy_since = r->submit_tsc;
+		d->cmd_cnt++;
+		d->seek_sectors += r->sector > d->last_end
+			? r->sector - d->last_end : d->last_end - r->sector;
+		d->last_end = r->sector + r->cnt;
+		virtio_blk_submit (d->vblk, r);
+	} else {
+		iosched->add (c, r);
+		start_request (c);
+	}
+	intr_set_level (old_level);
+}
+
+/* 동기 전송의 완료 callback. */
+static void
+wake_waiter (struct disk_request *r) {
+	sema_up (r->aux);
+}
+
+/* 커널 주소 BUFFER로 요청을 하나 보내고 끝날 때까지 기다린다. */
+static void
+submit_and_wait (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt, bool write) {
+	struct disk_request r;
+	struct semaphore done;
+
+	sema_init (&done, 0);
+	disk_request_init (&r, d, sec_no, buffer, cnt, write, wake_waiter, &done);
+	disk_submit (&r);
+	sema_down (&done);
+}
+
+/*** GrilledSalmon ***/
+/* D의 write cache에 남은 쓰기를 모두 디스크 표면에 내린다. 리턴하면 그 전에
+   끝난 disk_write는 전원이 나가도 남는다. 큐에서 FLUSH CACHE 명령 하나로
+   다른 요청들 사이에 끼어 나가므로, 부른 뒤에 보낸 쓰기까지 기다리지는 않는다.
+   write cache를 켜지 않은 IDE 디스크, RAM disk, FLUSH feature를 쓰지 않는
+   virtio-blk는 쓰기가 끝날 때 이미 남으므로 바로 리턴한다. fsync와 journal
+   commit처럼 순서가 중요한 곳에서만 부른다. */
+void
+disk_flush (struct disk *d) {
+	struct disk_request r;
+	struct semaphore done;
+
+	if (!d->write_cache || d->ram != NULL || d->vblk != NULL)
+		return;
+	sema_init (&done, 0);
+	disk_request_init (&r, d, 0, NULL, 0, true, wake_waiter, &done);
+	r.flush = true;
+	disk_submit (&r);
+	sema_down (&done);
+}
+
+/* disk_read_multiple과 disk_write_multiple이 함께 쓴다.
+   사용자 주소 BUFFER(direct I/O 경로)는 인터럽트 처리기에서 쓸 수
+   없으므로 페이지마다 커널 주소로 바꿔 보내고, sector가 페이지에
+   걸치거나 매핑되지 않은 페이지가 있으면 bounce buffer를 거친다. */
+static void
+transfer (struct disk *d, disk_sector_t sec_no, void *buffer, size_t cnt,
+		bool write) {
+	uint8_t *p = buffer;
+	uint8_t *bounce;
+
+	if (is_kernel_vaddr (p)) {
+		submit_and_wait (d, sec_no, p, cnt, write);
+		return;
+	}
+
+#ifdef USERPROG
+	while (cnt > 0 && pg_ofs (p) % DISK_SECTOR_SIZE == 0) {
+		size_t n = (PGSIZE - pg_ofs (p)) / DISK_SECTOR_SIZE;
+		void *kva = pml4_get_page (thread_current ()->pml4, p);
+
+		if (kva == NULL)
+			break;
+		if (n > cnt)
+			n = cnt;
+		submit_and_wait (d, sec_no, kva, n, write);
+		sec_no += n;
+		p += n * DISK_SECTOR_SIZE;
+		cnt -= n;
+	}
+	if (cnt == 0)
+		return;
+#endif
+
+	bounce = malloc (cnt * DISK_SECTOR_SIZE);
+	if (bounce == NULL)
+		PANIC ("%s: out of memory for bounce buffer", d->name);
+	if (write)
+		memcpy (bounce, p, cnt * DISK_SECTOR_SIZE);
+	submit_and_wait (d, sec_no, bounce, cnt, write);
+	if (!write)
+		memcpy (p, bounce, cnt * DISK_SECTOR_SIZE);
+	free (bounce);
+}
+
+/* I/O schedulers. */
+
+/* R의 (장치, sector). 한 채널의 두 디스크를 한 줄로 세운다. */
+static uint64_t
+request_key (const struct disk_request *r) {
+	return ((uint64_t) r->disk->dev_no << 32) | r->sector;
+}
+
+/* list_less_func: sector 순. */
+static bool
+request_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct disk_request *a = list_entry (a_, struct disk_request, elem);
+	const struct disk_request *b = list_entry (b_, struct disk_request, elem);
+
+	return request_key (a) < request_key (b);
+}
+
+/* fifo: 들어온 순서대로 보낸다. */
+static void
+fifo_add (struct channel *c, struct disk_request *r) {
+	list_push_back (&c->queue, &r->elem);
+}
+
+static struct disk_request *
+fifo_pick (struct channel *c) {
+	return list_entry (list_front (&c->queue), struct disk_request, elem);
+}
+
+/* clook: 큐를 sector 순으로 두고 헤드가 지나온 자리에서 위로만 훑다가,
+   끝에 닿으면 가장 낮은 sector로 돌아간다. 같은 sector는 들어온 순서를
+   지킨다. */
+static void
+clook_add (struct channel *c, struct disk_request *r) {
+	list_insert_ordered (&c->queue, &r->elem, request_less, NULL);
+}
+
+static struct disk_request *
+clook_pick (struct channel *c) {
+	struct list_elem *e;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		if (request_key (r) >= c->head)
+			return r;
+	}
+	return list_entry (list_front (&c->queue), struct disk_request, elem);
+}
+
+/* deadline: clook처럼 보내지만, DEADLINE_READ_TICKS보다 오래 기다린
+   read가 있으면 가장 오래된 것부터 먼저 보낸다. 쓰기가 몰려도 read를
+   기다리는 프로세스가 굶지 않는다. */
+static struct disk_request *
+deadline_pick (struct channel *c) {
+	struct disk_request *oldest = NULL;
+	struct list_elem *e;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		if (!r->write && (oldest == NULL || r->submitted < oldest->submitted))
+			oldest = r;
+	}
+	if (oldest != NULL
+			&& timer_elapsed (oldest->submitted) >= DEADLINE_READ_TICKS)
+		return oldest;
+	return clook_pick (c);
+}
+
+/*** GrilledSalmon ***/
+/* R이 기다린 시간만큼 올린 우선순위. */
+static int
+prio_effective (const struct disk_request *r) {
+	int64_t pri = r->priority + timer_elapsed (r->submitted) / PRIO_AGE_TICKS;
+
+	return pri < PRI_MAX ? pri : PRI_MAX;
+}
+
+/* prio: 보낸 스레드의 우선순위가 높은 요청부터 보낸다. 우선순위가 같으면
+   read를 먼저, 그래도 같으면 clook 순서로 보낸다. 기다리는 요청은
+   PRIO_AGE_TICKS마다 우선순위가 한 단계씩 올라서, nice가 낮은 스레드가
+   쓰기를 몰아 넣어도 높은 우선순위의 read가 그 뒤에 줄 서지 않고, 낮은
+   우선순위의 요청도 언젠가는 나간다. */
+static struct disk_request *
+prio_pick (struct channel *c) {
+	struct disk_request *best = NULL;
+	int best_score = -1;
+	struct list_elem *e;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		int score = prio_effective (r) * 4 + !r->write * 2
+			+ (request_key (r) >= c->head);
+
+		if (score > best_score) {
+			best = r;
+			best_score = score;
+		}
+	}
+	return best;
+}
+
+static const struct iosched iosched_list[] = {
+	{"fifo", fifo_add, fifo_pick},
+	{"clook", clook_add, clook_pick},
+	{"deadline", clook_add, deadline_pick},
+	{"prio", clook_add, prio_pick},
+};
+
+/* 지금 쓰는 I/O scheduler. */
+static const struct iosched *iosched = &iosched_list[3];
+
+/* NAME의 I/O scheduler를 쓴다. 디스크를 쓰기 전, 커널 옵션을 읽을 때
+   부른다. 그런 scheduler가 없으면 false를 반환한다. */
+bool
+disk_set_scheduler (const char *name) {
+	size_t i;
+
+	for (i = 0; i < sizeof iosched_list / sizeof *iosched_list; i++)
+		if (!strcmp (name, iosched_list[i].name)) {
+			iosched = &iosched_list[i];
+			return true;
+		}
+	return false;
+}
+
+/*** GrilledSalmon ***/
+/* "C:D[:MB],..." 꼴의 SPEC이 가리키는 자리에 RAM disk를 쓴다. 커널
+   옵션을 읽을 때 disk_init보다 먼저 부른다. 커널이 든 hd0:0은 받지 않는다.
+   SPEC이 잘못되었으면 false를 반환한다. */
+bool
+disk_set_ramdisk (const char *spec) {
+	const char *p = spec;
+
+	while (*p != '\0') {
+		int chan_no, dev_no;
+		unsigned mb = 0;
+
+		if (p[0] < '0' || p[0] > '1' || p[1] != ':' || p[2] < '0' || p[2] > '1')
+			return false;
+		chan_no = p[0] - '0';
+		dev_no = p[2] - '0';
+		if (chan_no == 0 && dev_no == 0)
+			return false;
+		p += 3;
+		if (*p == ':') {
+			if (!isdigit (*++p))
+				return false;
+			while (isdigit (*p))
+				mb = mb * 10 + (*p++ - '0');
+			if (mb == 0 || mb > 1024)
+				return false;
+		}
+		if (*p == ',')
+			p++;
+		else if (*p != '\0')
+			return false;
+		ram_wanted[chan_no][dev_no] = true;
+		ram_mb[chan_no][dev_no] = mb;
+	}
+	return p != spec;
+}
+
+/* C의 큐에서 방향과 디스크가 같고 END에서 시작하며 ROOM개 이하의
+   sector를 옮기는 요청을 찾는다. 없으면 NULL. */
+static struct disk_request *
+find_follower (struct channel *c, struct disk *d, disk_sector_t end,
+		bool write, size_t room) {
+	struct list_elem *e;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		if (r->disk == d && r->write == write && r->sector == end
+				&& r->cnt <= room && !r->flush)
+			return r;
+	}
+	return NULL;
+}
+
+/* C의 큐에서 scheduler가 고른 요청과, 그 뒤로 디스크에서 바로 이어지는
+   요청들을 MERGE_MAX개까지 묶어 한 번의 명령으로 디스크에 보낸다.
+   인터럽트를 끄고 부르며, 인터럽트 처리기에서도 불리므로 잠들지 않는다.
+   DMA를 쓸 수 있으면 DMA로, 아니면 PIO로 보낸다. */
+static void
+start_request (struct channel *c) {
+	struct disk_request *r, *next;
+	struct disk *d;
+	disk_sector_t end;
+	size_t merged = 1;
+	bool lba48;
+	uint8_t command;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!list_empty (&c->batch) || list_empty (&c->queue))
+		return;
+	r = iosched->pick (c);
+	d = r->disk;
+	list_remove (&r->elem);
+	list_push_back (&c->batch, &r->elem);
+	c->batch_cnt = r->cnt;
+
+	/*** GrilledSalmon ***/
+	/* FLUSH CACHE는 옮길 데이터가 없고 다 내리면 인터럽트를 한 번 올린다.
+	   advance_request는 batch_cnt가 0인 쓰기로 보고 끝낸다. */
+	if (r->flush) {
+		c->cmd_start = rdtsc ();
+		d->cmd_cnt++;
+		c->cur = list_begin (&c->batch);
+		c->cur_done = 0;
+		c->done_cnt = 0;
+		c->use_dma = false;
+		select_device_wait (d);
+		outb (reg_command (c), d->lba48 ? CMD_FLUSH_CACHE_EXT : CMD_FLUSH_CACHE);
+		return;
+	}
+
+	end = r->sector + r->cnt;
+	while (merged < MERGE_MAX
+			&& (next = find_follower (c, d, end, r->write,
+					DISK_MAX_SECTORS - c->batch_cnt)) != NULL) {
+		list_remove (&next->elem);
+		list_push_back (&c->batch, &next->elem);
+		c->batch_cnt += next->cnt;
+		end += next->cnt;
+		merged++;
+	}
+	c->head = ((uint64_t) d->dev_no << 32) | end;
+	c->cmd_start = rdtsc ();
+	d->cmd_cnt++;
+	d->seek_sectors += r->sector > d->last_end
+		? r->sector - d->last_end : d->last_end - r->sector;
+	d->last_end = end;
+	c->cur = list_begin (&c->batch);
+	c->cur_done = 0;
+	c->done_cnt = 0;
+	c->use_dma = d->dma && build_prdt (c);
+
+	lba48 = select_sector (d, r->sector, c->batch_cnt);
+	command = rw_command (d, lba48, c->use_dma, r->write);
+	if (c->use_dma) {
+		uint8_t dir = r->write ? 0 : BM_CMD_READ;
+
+		outb (reg_bm_command (c), 0);
+		outl (reg_bm_prdt (c), vtop (c->prdt));
+		outb (reg_bm_status (c), BM_STA_ERR | BM_STA_INTR);
+		outb (reg_bm_command (c), dir);
+		outb (reg_command (c), command);
+		outb (reg_bm_command (c), dir | BM_CMD_START);
+	} else if (r->write) {
+		outb (reg_command (c), command);
+		/* 첫 블록은 인터럽트 없이 DRQ를 보고 보낸다. 나머지 블록은
+		   디스크가 앞 블록을 받았다는 인터럽트를 올릴 때마다 보낸다. */
+		if (!spin_while_busy (d))
+			PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name,
+					r->sector);
+		transfer_block (c);
+	} else
+		/* The device raises an interrupt as each block of d->multiple
+		   sectors (the last one may be shorter) becomes ready in the
+		   data register. */
+		outb (reg_command (c), command);
+}
+
+/* C에서 진행 중인 PIO 전송의 다음 블록(최대 d->multiple개 sector)을
+   data register와 주고받는다. 묶인 요청의 buffer를 차례로 채운다. */
+static void
+transfer_block (struct channel *c) {
+	struct disk_request *first = list_entry (list_front (&c->batch),
+			struct disk_request, elem);
+	size_t n = first->disk->multiple;
+
+	if (n > c->batch_cnt - c->done_cnt)
+		n = c->batch_cnt - c->done_cnt;
+	for (; n > 0; n--) {
+		struct disk_request *r = list_entry (c->cur, struct disk_request, elem);
+		uint8_t *p = (uint8_t *) r->buffer + c->cur_done * DISK_SECTOR_SIZE;
+
+		if (r->write)
+			output_sector (c, p);
+		else
+			input_sector (c, p);
+		c->done_cnt++;
+		if (++c->cur_done == r->cnt) {
+			c->cur = list_next (c->cur);
+			c->cur_done = 0;
+		}
+	}
+}
+
+/* C에서 진행 중인 전송에 대한 인터럽트를 처리한다. 전송이 끝났으면
+   다음 요청을 디스크에 보낸 뒤 끝난 요청들의 callback을 부른다. */
+static void
+advance_request (struct channel *c) {
+	struct disk_request *r = list_entry (list_front (&c->batch),
+			struct disk_request, elem);
+	struct disk *d = r->disk;
+	struct list_elem *e;
+	uint64_t now;
+	uint8_t status;
+
+	if (c->use_dma) {
+		uint8_t bm_status = inb (reg_bm_status (c));
+
+		outb (reg_bm_command (c), r->write ? 0 : BM_CMD_READ);
+		outb (reg_bm_status (c), BM_STA_ERR | BM_STA_INTR);
+		status = inb (reg_status (c));      /* Acknowledge interrupt. */
+		if ((bm_status & BM_STA_ERR) || (status & STA_ERR))
+			PANIC ("%s: disk %s failed (DMA), sector=%"PRDSNu, d->name,
+					r->write ? "write" : "read", r->sector);
+	} else {
+		status = inb (reg_status (c));      /* Acknowledge interrupt. */
+		if (status & STA_ERR)
+			PANIC ("%s: disk %s failed, sector=%"PRDSNu, d->name,
+					r->flush ? "flush" : r->write ? "write" : "read",
+					r->sector + (disk_sector_t) c->done_cnt);
+		if (!r->write || c->done_cnt < c->batch_cnt) {
+			if (!spin_while_busy (d))
+				PANIC ("%s: disk %s failed, sector=%"PRDSNu, d->name,
+						r->write ? "write" : "read",
+						r->sector + (disk_sector_t) c->done_cnt);
+			transfer_block (c);
+			/* 쓰기는 마지막 블록을 받았다는 인터럽트가 한 번 더 온다. */
+			if (r->write || c->done_cnt < c->batch_cnt)
+				return;
+		}
+	}
+
+	if (r->flush)
+		d->flush_cnt++;
+	else if (r->write)
+		d->write_cnt += c->batch_cnt;
+	else
+		d->read_cnt += c->batch_cnt;
+
+	now = rdtsc ();
+	d->busy_cycles += now - c->cmd_start;
+	depth_update (d, now);
+	for (e = list_begin (&c->batch); e != list_end (&c->batch);
+			e = list_next (e))
+		account_request (list_entry (e, struct disk_request, elem), now);
+
+	/* done은 bottom half에서 부른다. 다음 요청을 먼저 보내 디스크를 쉬지 않게
+	   한다. */
+	while (!list_empty (&c->batch))
+		list_push_back (&done_list, list_pop_front (&c->batch));
+	start_request (c);
+	bh_schedule (&done_work);
+}
+
+/*** GrilledSalmon ***/
+/* 인터럽트 처리기가 끝낸 요청들의 done을 부르는 bottom half. done이 요청을
+   풀어 줄 수 있으므로 하나씩 done_list에서 떼어 낸 다음 부른다. */
+static void
+run_done (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct disk_request *r = NULL;
+
+		if (!list_empty (&done_list))
+			r = list_entry (list_pop_front (&done_list), struct disk_request, elem);
+		intr_set_level (old_level);
+		if (r == NULL)
+			break;
+		r->done (r);
+	}
+}
+
+/* 끝난 요청 R의 latency를 R->disk의 통계에 더한다. */
+static void
+account_request (struct disk_request *r, uint64_t now) {
+	struct disk *d = r->disk;
+	uint64_t cycles = now - r->submit_tsc;
+	int bucket = 0;
+
+	d->latency_cycles += cycles;
+	while (cycles > 1 && bucket < DISK_LATENCY_BUCKETS - 1) {
+		cycles >>= 1;
+		bucket++;
+	}
+	d->latency[bucket]++;
+	d->req_cnt++;
+	d->depth--;
+}
+
+/*** GrilledSalmon ***/
+/* IDE 채널을 거치지 않는 드라이버가 R을 끝냈을 때 인터럽트 처리기 안에서
+   부른다. 통계를 센 다음 R->done을 bottom half에서 부르도록 넘긴다. */
+void
+disk_request_complete (struct disk_request *r) {
+	struct disk *d = r->disk;
+	uint64_t now = rdtsc ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (r->write)
+		d->write_cnt += r->cnt;
+	else
+		d->read_cnt += r->cnt;
+	depth_update (d, now);
+	account_request (r, now);
+	if (d->depth == 0)
+		d->busy_cycles += now - d->busy_since;
+	list_push_back (&done_list, &r->elem);
+	bh_schedule (&done_work);
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
 
+/* Resets channel C_, finds out which of its devices are ATA disks
+   and identifies them, then lets disk_get() callers through.  Runs
+   in its own thread, started by disk_init(). */
+static void
+probe_channel (void *c_) {
+	struct channel *c = c_;
+	int dev_no;
+
+	reset_channel (c);
+
+	/* Distinguish ATA hard disks from other devices. */
+	if (check_device_type (&c->devices[0]))
+		check_device_type (&c->devices[1]);
+
+	/* Read hard disk identity information. */
+	for (dev_no = 0; dev_no < 2; dev_no++)
+		if (c->devices[dev_no].is_ata && c->devices[dev_no].vblk == NULL)
+			identify_ata_device (&c->devices[dev_no]);
+	for (dev_no = 0; dev_no < 2; dev_no++)
+		if (ram_wanted[c - channels][dev_no])
+			attach_ramdisk (&c->devices[dev_no], ram_mb[c - channels][dev_no]);
+
+	c->probed = true;
+	sema_up (&c->probe_done);
+}
+
+/*** GrilledSalmon ***/
+/* virtio-blk 장치 VB를 struct disk 자리에 붙인다. utils/pintos --virtio가
+   fs, scratch, swap 디스크를 VIRTIO_BLK_SLOT_BASE부터의 PCI slot에 꽂으므로
+   slot 순서대로 hd0:1, hd1:0, hd1:1을 맡기고, 다른 slot의 장치는 남은
+   자리 중 앞의 것에 붙인다. hd0:0은 BIOS가 커널을 읽는 IDE 디스크다. */
+static void
+attach_virtio (struct virtio_blk *vb) {
+	static const int places[][2] = { {0, 1}, {1, 0}, {1, 1} };
+	const int place_cnt = sizeof places / sizeof *places;
+	int want = virtio_blk_pci_slot (vb) - VIRTIO_BLK_SLOT_BASE;
+	struct disk *d = NULL;
+	int i;
+
+	if (want >= 0 && want < place_cnt
+			&& channels[places[want][0]].devices[places[want][1]].vblk == NULL)
+		d = &channels[places[want][0]].devices[places[want][1]];
+	for (i = 0; d == NULL && i < place_cnt; i++)
+		if (channels[places[i][0]].devices[places[i][1]].vblk == NULL)
+			d = &channels[places[i][0]].devices[places[i][1]];
+	if (d == NULL) {
+		printf ("virtio-blk: no disk slot left for pci 0:%d\n",
+				virtio_blk_pci_slot (vb));
+		return;
+	}
+
+	d->vblk = vb;
+	d->capacity = virtio_blk_capacity (vb);
+	printf ("%s: virtio-blk at pci 0:%d, %'"PRDSNu" sectors\n",
+			d->name, virtio_blk_pci_slot (vb), d->capacity);
+}
+
+/*** GrilledSalmon ***/
+/* D의 자리에 MB 메가바이트의 RAM disk를 붙인다. MB가 0이면 원래 있던
+   디스크와 같은 크기로 만든다. 원래 디스크는 다시 쓰지 않는다. */
+static void
+attach_ramdisk (struct disk *d, unsigned mb) {
+	disk_sector_t capacity = mb * (1024 * 1024 / DISK_SECTOR_SIZE);
+
+	if (mb == 0)
+		capacity = d->is_ata || d->vblk != NULL ? d->capacity
+			: RAMDISK_DEFAULT_MB * (1024 * 1024 / DISK_SECTOR_SIZE);
+	d->ram = ramdisk_create (capacity);
+	if (d->ram == NULL) {
+		printf ("%s: out of memory for RAM disk\n", d->name);
+		return;
+	}
+	d->capacity = capacity;
+	printf ("%s: RAM disk, %'"PRDSNu" sectors\n", d->name, capacity);
+}
+
 /* Resets an ATA channel and waits for any devices present on it
    to finish the reset. */
 static void
@@ -365,6 +1319,30 @@ identify_ata_device (struct disk *d) {
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	/*** GrilledSalmon ***/
+	/* Word 83의 bit 10은 48-bit LBA 지원 여부이고, 그때의 용량은 word
+	   100-103에 있다. disk_sector_t로 셀 수 있는 데까지만 쓴다. */
+	if (id[83] & (1 << 10)) {
+		d->lba48 = true;
+		if (id[102] != 0 || id[103] != 0)
+			d->capacity = UINT32_MAX;
+		else if ((id[100] | ((uint32_t) id[101] << 16)) > d->capacity)
+			d->capacity = id[100] | ((uint32_t) id[101] << 16);
+	}
+
+	/*** GrilledSalmon ***/
+	/* Word 49의 bit 8은 DMA 지원 여부다. */
+	d->dma = c->bm_base != 0 && (id[49] & (1 << 8)) != 0;
+
+	/* Word 47의 하위 바이트는 READ/WRITE MULTIPLE 블록 크기의 상한이다. */
+	set_multiple_mode (d, id[47] & 0xff);
+
+	/*** GrilledSalmon ***/
+	/* Word 82의 bit 5는 write cache, word 83의 bit 12는 FLUSH CACHE 지원
+	   여부다. FLUSH로 내릴 수 있을 때만 cache를 켠다. */
+	if ((id[82] & (1 << 5)) && (id[83] & (1 << 12)))
+		set_write_cache (d);
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -376,13 +1354,54 @@ identify_ata_device (struct disk *d) {
 		printf ("%"PRDSNu" kB", d->capacity / (1024 / DISK_SECTOR_SIZE));
 	else
 		printf ("%"PRDSNu" byte", d->capacity * DISK_SECTOR_SIZE);
-	printf (") disk, model \"");
+	printf (") disk, %s%s, model \"", d->dma ? "DMA" : "PIO",
+			d->write_cache ? ", write cache" : "");
 	print_ata_string ((char *) &id[27], 40);
 	printf ("\", serial \"");
 	print_ata_string ((char *) &id[10], 20);
 	printf ("\"\n");
 }
 
+/*** GrilledSalmon ***/
+/* D가 PIO 인터럽트 한 번에 MAX 이하의 가장 큰 2의 거듭제곱만큼 sector를
+   옮기도록 SET MULTIPLE MODE를 보낸다. MAX가 2보다 작거나 디스크가
+   거절하면 d->multiple은 1로 남고 sector마다 인터럽트를 받는다. */
+static void
+set_multiple_mode (struct disk *d, size_t max) {
+	struct channel *c = d->channel;
+	size_t n = MULTIPLE_MAX;
+
+	while (n > max)
+		n /= 2;
+	if (n < 2)
+		return;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), n);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	if ((inb (reg_alt_status (c)) & STA_ERR) == 0)
+		d->multiple = n;
+}
+
+/*** GrilledSalmon ***/
+/* SET FEATURES로 D의 write cache를 켠다. 그러면 쓰기 명령은 cache에 담기는
+   대로 끝나고, 디스크 표면에 남는 것은 disk_flush가 보장한다. 디스크가
+   거절하면 d->write_cache는 false로 남고 쓰기마다 표면까지 기다린다. */
+static void
+set_write_cache (struct disk *d) {
+	struct channel *c = d->channel;
+
+	select_device_wait (d);
+	outb (reg_features (c), FEAT_WCACHE_ON);
+	issue_pio_command (c, CMD_SET_FEATURES);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	if ((inb (reg_alt_status (c)) & STA_ERR) == 0)
+		d->write_cache = true;
+}
+
 /* Prints STRING, which consists of SIZE bytes in a funky format:
    each pair of bytes is in reverse order.  Does not print
    trailing whitespace and/or nulls. */
@@ -403,22 +1422,56 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
-static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+   writes SEC_NO and the transfer length CNT to the disk's sector
+   selection registers.  (We use LBA mode.)
+   Returns true if the range lies beyond 28-bit LBA and was
+   programmed for a 48-bit (EXT) command instead. */
+static bool
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
+	ASSERT (sec_no + cnt <= d->capacity);
+	ASSERT (d->lba48 || sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	if (sec_no + cnt > (1UL << 28)) {
+		/* LBA48: 각 레지스터에 높은 바이트를 먼저, 낮은 바이트를
+		   나중에 쓴다. disk_sector_t는 32비트라 LBA 47:32는 0이다. */
+		outb (reg_nsect (c), cnt >> 8);
+		outb (reg_lbal (c), sec_no >> 24);
+		outb (reg_lbam (c), 0);
+		outb (reg_lbah (c), 0);
+		outb (reg_nsect (c), cnt);
+		outb (reg_lbal (c), sec_no);
+		outb (reg_lbam (c), sec_no >> 8);
+		outb (reg_lbah (c), sec_no >> 16);
+		outb (reg_device (c),
+				DEV_MBS | DEV_LBA | (d->dev_no == 1 ? DEV_DEV : 0));
+		return true;
+	}
+	outb (reg_nsect (c), cnt);	/* 256 wraps to 0, which means 256. */
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
 	outb (reg_device (c),
 			DEV_MBS | DEV_LBA | (d->dev_no == 1 ? DEV_DEV : 0) | (sec_no >> 24));
+	return false;
+}
+
+/*** GrilledSalmon ***/
+/* D에 보낼 읽기/쓰기 명령을 고른다. LBA48이면 EXT 명령, DMA면 DMA 명령,
+   multiple mode가 켜져 있으면 MULTIPLE 명령이다. */
+static uint8_t
+rw_command (const struct disk *d, bool lba48, bool dma, bool write) {
+	if (dma)
+		return lba48 ? (write ? CMD_WRITE_DMA_EXT : CMD_READ_DMA_EXT)
+			: (write ? CMD_WRITE_DMA : CMD_READ_DMA);
+	if (d->multiple > 1)
+		return lba48 ? (write ? CMD_WRITE_MULTIPLE_EXT : CMD_READ_MULTIPLE_EXT)
+			: (write ? CMD_WRITE_MULTIPLE : CMD_READ_MULTIPLE);
+	return lba48 ? (write ? CMD_WRITE_SECTOR_EXT : CMD_READ_SECTOR_EXT)
+		: (write ? CMD_WRITE_SECTOR_RETRY : CMD_READ_SECTOR_RETRY);
 }
 
 /* Writes COMMAND to channel C and prepares for receiving a
@@ -447,6 +1500,86 @@ output_sector (struct channel *c, const void *sector) {
 	outsw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
 }
 
+/*** GrilledSalmon ***/
+/* Bus-master DMA. */
+
+/* Bus 0에서 legacy 포트를 쓰는 bus-master IDE 컨트롤러를 찾아
+   bus mastering을 켜고 I/O 포트(BAR4)를 반환한다.
+   찾지 못하면 0을 반환하며, 이때 모든 전송은 PIO로 이루어진다. */
+static uint16_t
+find_bus_master (void) {
+	int dev, func;
+
+	for (dev = 0; dev < 32; dev++)
+		for (func = 0; func < 8; func++) {
+			uint32_t id = pci_read_config (0, dev, func, 0x00);
+			uint32_t class, bar4;
+			uint8_t prog_if;
+
+			if ((id & 0xffff) == 0xffff) {
+				if (func == 0)
+					break;
+				continue;
+			}
+
+			/* Class 0x01 (mass storage), subclass 0x01 (IDE).
+			   Prog IF의 bit 7은 bus master 지원, bit 0과 2는 각 채널이
+			   native 모드라는 뜻인데 우리는 legacy 포트만 다룬다. */
+			class = pci_read_config (0, dev, func, 0x08);
+			prog_if = class >> 8;
+			if ((class >> 16) != 0x0101 || !(prog_if & 0x80)
+					|| (prog_if & 0x05) != 0)
+				continue;
+
+			bar4 = pci_read_config (0, dev, func, 0x20);
+			if (!(bar4 & 1) || (bar4 & 0xfffc) == 0)
+				continue;
+
+			/* Command 레지스터의 I/O space(bit 0)와 bus master(bit 2). */
+			pci_write_config (0, dev, func, 0x04,
+					pci_read_config (0, dev, func, 0x04) | 0x05);
+			printf ("ide: bus master at pci 0:%d.%d, port %#x\n",
+					dev, func, bar4 & 0xfffc);
+			return bar4 & 0xfffc;
+		}
+	return 0;
+}
+
+/* 채널 C에 묶인 요청들의 buffer를 차례로 가리키도록 PRD 테이블을
+   채운다. 커널 주소는 물리적으로 연속이므로 요청마다 64 kB 경계에서만
+   끊는다. 주소가 짝수가 아니거나 4 GB 위에 있으면 false를 반환하고
+   호출자는 PIO로 돌아간다. */
+static bool
+build_prdt (struct channel *c) {
+	struct list_elem *e;
+	size_t n = 0;
+
+	for (e = list_begin (&c->batch); e != list_end (&c->batch);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		uint64_t pa = vtop (r->buffer);
+		size_t size = r->cnt * DISK_SECTOR_SIZE;
+
+		if ((pa & 1) != 0 || pa + size > 0x100000000ULL)
+			return false;
+		while (size > 0) {
+			size_t chunk = 0x10000 - (pa & 0xffff);
+
+			if (chunk > size)
+				chunk = size;
+			ASSERT (n < PRD_CNT);
+			c->prdt[n].addr = pa;
+			c->prdt[n].size = chunk;      /* 64 kB는 0으로 잘린다. */
+			c->prdt[n].flags = 0;
+			n++;
+			pa += chunk;
+			size -= chunk;
+		}
+	}
+	c->prdt[n - 1].flags = PRD_EOT;
+	return true;
+}
+
 /* Low-level ATA primitives. */
 
 /* Wait up to 10 seconds for the controller to become idle, that
@@ -461,7 +1594,7 @@ wait_until_idle (const struct disk *d) {
 	for (i = 0; i < 1000; i++) {
 		if ((inb (reg_status (d->channel)) & (STA_BSY | STA_DRQ)) == 0)
 			return;
-		timer_usleep (10);
+		timer_udelay (10);
 	}
 
 	printf ("%s: idle timeout\n", d->name);
@@ -491,6 +1624,23 @@ wait_while_busy (const struct disk *d) {
 	return false;
 }
 
+/*** GrilledSalmon ***/
+/* wait_while_busy처럼 BSY가 풀리기를 기다렸다가 DRQ를 반환하지만
+   잠들지 않고 최대 1초 동안 바쁘게 기다린다. 인터럽트 처리기에서 쓴다. */
+static bool
+spin_while_busy (const struct disk *d) {
+	struct channel *c = d->channel;
+	int i;
+
+	for (i = 0; i < 1000000; i++) {
+		uint8_t status = inb (reg_alt_status (c));
+		if (!(status & STA_BSY))
+			return (status & STA_DRQ) != 0;
+		timer_udelay (1);
+	}
+	return false;
+}
+
 /* Program D's channel so that D is now the selected disk. */
 static void
 select_device (const struct disk *d) {
@@ -500,7 +1650,7 @@ select_device (const struct disk *d) {
 		dev |= DEV_DEV;
 	outb (reg_device (c), dev);
 	inb (reg_alt_status (c));
-	timer_nsleep (400);
+	timer_ndelay (400);
 }
 
 /* Select disk D in its channel, as select_device(), but wait for
@@ -519,7 +1669,9 @@ interrupt_handler (struct intr_frame *f) {
 
 	for (c = channels; c < channels + CHANNEL_CNT; c++)
 		if (f->vec_no == c->irq) {
-			if (c->expecting_interrupt) {
+			if (!list_empty (&c->batch))
+				advance_request (c);
+			else if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
 			} else
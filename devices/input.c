@@ -13,31 +13,50 @@ input_init (void) {
 }
 
 /* Adds a key to the input buffer.
-   Interrupts must be off and the buffer must not be full. */
+   Interrupts must be off and the buffer must not be full.
+   The serial port stops receiving once the buffer becomes full. */
 void
 input_putc (uint8_t key) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (!intq_full (&buffer));
 
 	intq_putc (&buffer, key);
-	serial_notify ();
+	if (intq_full (&buffer))
+		serial_notify ();
 }
 
 /* Retrieves a key from the input buffer.
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t
 input_getc (void) {
-	enum intr_level old_level;
 	uint8_t key;
 
-	old_level = intr_disable ();
-	key = intq_getc (&buffer);
-	serial_notify ();
-	intr_set_level (old_level);
-
+	input_read (&key, 1);
 	return key;
 }
 
+/*** GrilledSalmon ***/
+/* Retrieves up to N keys from the input buffer into KEYS and
+   returns how many were retrieved.  Waits for a key to be pressed
+   if the buffer is empty, then takes every key already there.
+   Interrupts stay on while the keys are copied; they are turned
+   off only to let the serial port receive again if the buffer
+   was full. */
+size_t
+input_read (uint8_t *keys, size_t n) {
+	enum intr_level old_level;
+	bool was_full;
+	size_t cnt;
+
+	cnt = intq_read (&buffer, keys, n, &was_full);
+	if (was_full) {
+		old_level = intr_disable ();
+		serial_notify ();
+		intr_set_level (old_level);
+	}
+	return cnt;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -46,3 +65,18 @@ input_full (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	return intq_full (&buffer);
 }
+
+/*** GrilledSalmon ***/
+/* 읽을 key가 있으면 true. E가 NULL이 아니면 먼저 E를 input buffer에 걸어
+   key가 들어올 때 SEMA가 올라가게 한다. */
+bool
+input_poll (struct wait_entry *e, struct semaphore *sema) {
+	enum intr_level old_level = intr_disable ();
+	bool ready;
+
+	if (e != NULL)
+		wait_entry_add (&buffer.pollers, e, sema);
+	ready = !intq_empty (&buffer);
+	intr_set_level (old_level);
+	return ready;
+}
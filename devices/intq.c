@@ -2,104 +2,127 @@
 #include <debug.h>
 #include "threads/thread.h"
 
-static int next (int pos);
-static void wait (struct intq *q, struct thread **waiter);
-static void signal (struct intq *q, struct thread **waiter);
+static unsigned load_head (const struct intq *);
+static unsigned load_tail (const struct intq *);
+static void wait_not_empty (struct intq *);
 
 /* Initializes interrupt queue Q. */
 void
 intq_init (struct intq *q) {
 	lock_init (&q->lock);
-	q->not_full = q->not_empty = NULL;
+	q->not_empty = NULL;
+	wait_queue_init (&q->pollers);
 	q->head = q->tail = 0;
 }
 
 /* Returns true if Q is empty, false otherwise. */
 bool
 intq_empty (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	return q->head == q->tail;
+	return load_head (q) == load_tail (q);
 }
 
 /* Returns true if Q is full, false otherwise. */
 bool
 intq_full (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	return next (q->head) == q->tail;
+	return load_head (q) - load_tail (q) == INTQ_BUFSIZE;
 }
 
-/* Removes a byte from Q and returns it.
-   Q must not be empty if called from an interrupt handler.
-   Otherwise, if Q is empty, first sleeps until a byte is
-   added. */
+/* Removes a byte from Q and returns it.  If Q is empty, first
+   sleeps until a byte is added.  Must not be called from an
+   interrupt handler. */
 uint8_t
 intq_getc (struct intq *q) {
 	uint8_t byte;
 
-	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_empty (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
-		wait (q, &q->not_empty);
-		lock_release (&q->lock);
-	}
-
-	byte = q->buf[q->tail];
-	q->tail = next (q->tail);
-	signal (q, &q->not_full);
+	intq_read (q, &byte, 1, NULL);
 	return byte;
 }
 
-/* Adds BYTE to the end of Q.
-   Q must not be full if called from an interrupt handler.
-   Otherwise, if Q is full, first sleeps until a byte is
-   removed. */
+/*** GrilledSalmon ***/
+/* Removes up to N bytes from Q into BUFFER and returns how many
+   were removed.  If Q is empty, first sleeps until a byte is
+   added, so at least one byte is returned when N > 0.  Everything
+   already queued is taken at once.  If WAS_FULL is non-null, it
+   is set to whether Q may have become full before the bytes were
+   removed, so that the caller can let a producer that stopped on
+   a full queue go on.  Must not be called from an interrupt
+   handler. */
+size_t
+intq_read (struct intq *q, uint8_t *buffer, size_t n, bool *was_full) {
+	unsigned head, tail, old_tail;
+	size_t cnt = 0;
+
+	ASSERT (!intr_context ());
+
+	if (was_full != NULL)
+		*was_full = false;
+	if (n == 0)
+		return 0;
+
+	lock_acquire (&q->lock);
+	wait_not_empty (q);
+	head = load_head (q);
+	tail = old_tail = q->tail;
+	while (cnt < n && tail != head)
+		buffer[cnt++] = q->buf[tail++ % INTQ_BUFSIZE];
+	/* 읽은 칸을 다 읽은 다음에 넘겨준다. */
+	__atomic_store_n (&q->tail, tail, __ATOMIC_SEQ_CST);
+	/* 넘겨주기 전에 producer가 큐를 채웠으면 지금 head가 old_tail보다
+	   INTQ_BUFSIZE 이상 앞서 있다. 넘겨준 뒤에 넣은 것은 가득 찬 것을 보지
+	   않았으니 한 번 더 알려도 해가 없다. */
+	if (was_full != NULL)
+		*was_full = load_head (q) - old_tail >= INTQ_BUFSIZE;
+	lock_release (&q->lock);
+	return cnt;
+}
+
+/* Adds BYTE to the end of Q, and wakes up the thread waiting for
+   a byte, if any.  Interrupts must be off and Q must not be full. */
 void
 intq_putc (struct intq *q, uint8_t byte) {
+	unsigned head = q->head;
+
 	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_full (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
-		wait (q, &q->not_full);
-		lock_release (&q->lock);
-	}
+	ASSERT (head - load_tail (q) < INTQ_BUFSIZE);
 
-	q->buf[q->head] = byte;
-	q->head = next (q->head);
-	signal (q, &q->not_empty);
-}
+	q->buf[head % INTQ_BUFSIZE] = byte;
+	/* 바이트를 다 쓴 다음에 보이게 한다. */
+	__atomic_store_n (&q->head, head + 1, __ATOMIC_RELEASE);
 
-/* Returns the position after POS within an intq. */
-static int
-next (int pos) {
-	return (pos + 1) % INTQ_BUFSIZE;
+	if (q->not_empty != NULL) {
+		thread_unblock (q->not_empty);
+		q->not_empty = NULL;
+	}
+	wait_queue_wake (&q->pollers);
 }
 
-/* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
-static void
-wait (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (!intr_context ());
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && intq_empty (q))
-			|| (waiter == &q->not_full && intq_full (q)));
+/* Q's head, as published by the producer. */
+static unsigned
+load_head (const struct intq *q) {
+	return __atomic_load_n (&q->head, __ATOMIC_ACQUIRE);
+}
 
-	*waiter = thread_current ();
-	thread_block ();
+/* Q's tail, as published by the consumer. */
+static unsigned
+load_tail (const struct intq *q) {
+	return __atomic_load_n (&q->tail, __ATOMIC_ACQUIRE);
 }
 
-/* WAITER must be the address of Q's not_empty or not_full
-   member, and the associated condition must be true.  If a
-   thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
+/* Sleeps until Q is not empty.  The producer runs with interrupts
+   off, so checking and blocking with interrupts off cannot miss
+   its wakeup.  Q's lock must be held. */
 static void
-signal (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && !intq_empty (q))
-			|| (waiter == &q->not_full && !intq_full (q)));
+wait_not_empty (struct intq *q) {
+	enum intr_level old_level;
 
-	if (*waiter != NULL) {
-		thread_unblock (*waiter);
-		*waiter = NULL;
+	ASSERT (lock_held_by_current_thread (&q->lock));
+
+	if (!intq_empty (q))
+		return;
+	old_level = intr_disable ();
+	while (intq_empty (q)) {
+		q->not_empty = thread_current ();
+		thread_block ();
 	}
+	intr_set_level (old_level);
 }
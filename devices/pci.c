@@ -0,0 +1,23 @@
+#include "devices/pci.h"
+#include "threads/io.h"
+
+/*** GrilledSalmon ***/
+/* PCI configuration space의 주소 포트와 데이터 포트. */
+#define PCI_CONFIG_ADDR 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+
+/* PCI configuration space에서 BUS:DEV.FUNC의 레지스터 REG를 읽는다. */
+uint32_t
+pci_read_config (int bus, int dev, int func, int reg) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | (bus << 16) | (dev << 11)
+			| (func << 8) | (reg & 0xfc));
+	return inl (PCI_CONFIG_DATA);
+}
+
+/* PCI configuration space에서 BUS:DEV.FUNC의 레지스터 REG에 VALUE를 쓴다. */
+void
+pci_write_config (int bus, int dev, int func, int reg, uint32_t value) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | (bus << 16) | (dev << 11)
+			| (func << 8) | (reg & 0xfc));
+	outl (PCI_CONFIG_DATA, value);
+}
@@ -0,0 +1,84 @@
+/* ramdisk.c: Memory-backed block device. */
+
+#include "devices/ramdisk.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+
+/*** GrilledSalmon ***/
+/* 디스크 내용을 page 단위로 커널 풀에 둔다. page는 처음 쓸 때 잡으므로
+   쓰지 않은 곳은 메모리를 차지하지 않고 0으로 읽힌다. 디스크 장치를 거치지
+   않아서 VM과 파일 시스템의 커널 쪽 비용만 잴 수 있다. */
+
+/* page 하나에 드는 sector 수. */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+struct ramdisk {
+	disk_sector_t capacity;
+	size_t page_cnt;
+	uint8_t **pages;            /* NULL이면 아직 쓴 적 없는 page. */
+	struct lock alloc_lock;     /* 같은 page를 두 번 잡지 않게 한다. */
+};
+
+/* CAPACITY개 sector의 빈 RAM disk를 만든다. 메모리가 없으면 NULL. */
+struct ramdisk *
+ramdisk_create (disk_sector_t capacity) {
+	struct ramdisk *rd = malloc (sizeof *rd);
+
+	if (rd == NULL)
+		return NULL;
+	rd->capacity = capacity;
+	rd->page_cnt = DIV_ROUND_UP (capacity, SECTORS_PER_PAGE);
+	rd->pages = kvcalloc (rd->page_cnt, sizeof *rd->pages);
+	if (rd->pages == NULL) {
+		free (rd);
+		return NULL;
+	}
+	lock_init (&rd->alloc_lock);
+	return rd;
+}
+
+/* RD의 SECTOR부터 CNT개 sector를 BUFFER와 주고받는다. WRITE면 RD에 쓴다.
+   처음 쓰는 page를 잡아야 할 수 있으므로 인터럽트 처리기에서는 부르지
+   않는다. */
+void
+ramdisk_transfer (struct ramdisk *rd, disk_sector_t sector, void *buffer,
+		size_t cnt, bool write) {
+	uint8_t *p = buffer;
+
+	ASSERT (!intr_context ());
+	ASSERT (sector <= rd->capacity && cnt <= rd->capacity - sector);
+
+	while (cnt > 0) {
+		size_t idx = sector / SECTORS_PER_PAGE;
+		size_t ofs = sector % SECTORS_PER_PAGE;
+		size_t n = SECTORS_PER_PAGE - ofs;
+		size_t bytes;
+
+		if (n > cnt)
+			n = cnt;
+		bytes = n * DISK_SECTOR_SIZE;
+		if (write) {
+			if (rd->pages[idx] == NULL) {
+				lock_acquire (&rd->alloc_lock);
+				if (rd->pages[idx] == NULL
+						&& (rd->pages[idx] = palloc_get_page (PAL_ZERO)) == NULL)
+					PANIC ("ramdisk: out of memory");
+				lock_release (&rd->alloc_lock);
+			}
+			memcpy (rd->pages[idx] + ofs * DISK_SECTOR_SIZE, p, bytes);
+		} else if (rd->pages[idx] != NULL)
+			memcpy (p, rd->pages[idx] + ofs * DISK_SECTOR_SIZE, bytes);
+		else
+			memset (p, 0, bytes);
+		sector += n;
+		p += bytes;
+		cnt -= n;
+	}
+}
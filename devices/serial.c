@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -33,6 +33,14 @@
 #define MCR_REG (IO_BASE + 4)   /* MODEM Control Register. */
 #define LSR_REG (IO_BASE + 5)   /* Line Status Register (read-only). */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable the 16-byte FIFOs. */
+#define FCR_CLEAR_RX 0x02       /* Clear the receive FIFO. */
+#define FCR_CLEAR_TX 0x04       /* Clear the transmit FIFO. */
+
+/* Size of the 16550A transmit FIFO, in bytes. */
+#define UART_FIFO_SIZE 16
+
 /* Interrupt Enable Register bits. */
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
@@ -51,12 +59,24 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/*** GrilledSalmon ***/
+/* Data to be transmitted: a ring of TXQ_SIZE bytes.  txq_head and
+   txq_tail only ever grow, so txq_head - txq_tail bytes are queued.
+   Writers append with interrupts off; serial_interrupt() alone
+   advances txq_tail, a FIFO-full burst at a time. */
+#define TXQ_SIZE 4096           /* Must be a power of 2. */
+static uint8_t txq[TXQ_SIZE];
+static size_t txq_head;
+static size_t txq_tail;
+
+/* Thread waiting for room in txq, if any. */
+static struct thread *txq_waiter;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
+static size_t txq_used (void);
+static void tx_burst (void);
 static intr_handler_func serial_interrupt;
 
 /* Initializes the serial port device for polling mode.
@@ -70,7 +90,7 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	txq_head = txq_tail = 0;
 	mode = POLL;
 }
 
@@ -86,6 +106,8 @@ serial_init_queue (void) {
 	ASSERT (mode == POLL);
 
 	intr_register_ext (0x20 + 4, serial_interrupt, "serial");
+	/* Let each transmit interrupt move a whole FIFO's worth. */
+	outb (FCR_REG, FCR_ENABLE | FCR_CLEAR_RX | FCR_CLEAR_TX);
 	mode = QUEUE;
 	old_level = intr_disable ();
 	write_ier ();
@@ -95,27 +117,54 @@ serial_init_queue (void) {
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
+	serial_putbuf (&byte, 1);
+}
+
+/*** GrilledSalmon ***/
+/* Sends the N bytes in BUFFER to the serial port.  The bytes are
+   copied into the transmit ring as large chunks, and the port is
+   kicked at once if it is idle.  When the ring is full a thread
+   with interrupts on sleeps until serial_interrupt() has drained
+   half of it; with interrupts off we can't wait, so the oldest
+   byte is sent by polling instead. */
+void
+serial_putbuf (const void *buffer, size_t n) {
+	const uint8_t *p = buffer;
 	enum intr_level old_level = intr_disable ();
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
-		   use dumb polling to transmit a byte. */
+		   use dumb polling to transmit. */
 		if (mode == UNINIT)
 			init_poll ();
-		putc_poll (byte);
-	} else {
-		/* Otherwise, queue a byte and update the interrupt enable
-		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
-		}
+		while (n-- > 0)
+			putc_poll (*p++);
+		intr_set_level (old_level);
+		return;
+	}
 
-		intq_putc (&txq, byte);
+	while (n > 0) {
+		size_t room = TXQ_SIZE - txq_used ();
+		size_t ofs = txq_head % TXQ_SIZE;
+		size_t chunk = n;
+
+		if (room == 0) {
+			if (old_level == INTR_ON && !intr_context ()) {
+				txq_waiter = thread_current ();
+				thread_block ();
+			} else
+				putc_poll (txq[txq_tail++ % TXQ_SIZE]);
+			continue;
+		}
+		if (chunk > room)
+			chunk = room;
+		if (chunk > TXQ_SIZE - ofs)
+			chunk = TXQ_SIZE - ofs;
+		memcpy (txq + ofs, p, chunk);
+		txq_head += chunk;
+		p += chunk;
+		n -= chunk;
+		tx_burst ();
 		write_ier ();
 	}
 
@@ -127,8 +176,23 @@ serial_putc (uint8_t byte) {
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
-	while (!intq_empty (&txq))
-		putc_poll (intq_getc (&txq));
+	while (txq_used () > 0)
+		putc_poll (txq[txq_tail++ % TXQ_SIZE]);
+	intr_set_level (old_level);
+}
+
+/*** GrilledSalmon ***/
+/* Flushes queued output and switches to polling, so that output
+   during a kernel panic reaches the port even though interrupts
+   stay off. */
+void
+serial_panic (void) {
+	enum intr_level old_level = intr_disable ();
+
+	if (mode == QUEUE) {
+		serial_flush ();
+		mode = POLL;
+	}
 	intr_set_level (old_level);
 }
 
@@ -171,7 +235,7 @@ write_ier (void) {
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
-	if (!intq_empty (&txq))
+	if (txq_used () > 0)
 		ier |= IER_XMIT;
 
 	/* Enable receive interrupt if we have room to store any
@@ -182,6 +246,25 @@ write_ier (void) {
 	outb (IER_REG, ier);
 }
 
+/* Returns the number of bytes waiting in txq. */
+static size_t
+txq_used (void) {
+	return txq_head - txq_tail;
+}
+
+/* If the transmitter is idle, fills its FIFO from txq. */
+static void
+tx_burst (void) {
+	size_t n;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if ((inb (LSR_REG) & LSR_THRE) == 0)
+		return;
+	for (n = 0; n < UART_FIFO_SIZE && txq_used () > 0; n++)
+		outb (THR_REG, txq[txq_tail++ % TXQ_SIZE]);
+}
+
 /* Polls the serial port until it's ready,
    and then transmits BYTE. */
 static void
@@ -205,10 +288,14 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 	while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
 		input_putc (inb (RBR_REG));
 
-	/* As long as we have a byte to transmit, and the hardware is
-	   ready to accept a byte for transmission, transmit a byte. */
-	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-		outb (THR_REG, intq_getc (&txq));
+	/* If the transmitter is idle, refill its FIFO, and wake a
+	   writer waiting for room once half the ring is free. */
+	if (mode == QUEUE)
+		tx_burst ();
+	if (txq_waiter != NULL && txq_used () <= TXQ_SIZE / 2) {
+		thread_unblock (txq_waiter);
+		txq_waiter = NULL;
+	}
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
@@ -1,12 +1,19 @@
 #include "devices/timer.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include <syscall-nr.h>
+#include "threads/bootsnap.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,57 +24,273 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency and its count for one tick, rounded to
+   nearest. */
+#define PIT_HZ 1193180
+#define PIT_PERIOD ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/*** GrilledSalmon ***/
+/* idle일 때 8254를 mode 0 (one-shot)으로 바꿔 다음 할 일이 있는 tick까지 인터럽트
+   없이 잔다. 16 bit counter라 한 번에 이만큼까지 잘 수 있다. */
+#define ONESHOT_MAX_TICKS (0xffff / PIT_PERIOD)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* one-shot으로 맞춘 tick 수. 0이면 매 tick 인터럽트가 오는 보통 mode. */
+static int64_t oneshot_ticks;
+
+/*** GrilledSalmon ***/
+/* TSC로 재는 nanosecond 시계. timer_calibrate()가 TSC를 tick에 맞춰 재서 채운다.
+   모든 프로세스에 CLOCK_PAGE로 읽기 전용 매핑되어 user도 system call 없이 읽는다. */
+#define CLOCK_CALIBRATE_TICKS 1
+#define NSEC_PER_TICK (1000000000 / TIMER_FREQ)
+static struct clock_page *clock_page;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* If nonzero, timer_calibrate() uses this many loops per second
+   instead of measuring.  Set by the "-loops=N" kernel option. */
+unsigned timer_loops_per_sec;
+
+/*** GrilledSalmon ***/
+/* busy_wait()의 속도를 TSC로 잴 때 한 번에 도는 횟수와 재는 횟수. */
+#define LOOPS_PROBE (1u << 16)
+#define LOOPS_PROBE_CNT 3
+
 static intr_handler_func timer_interrupt;
+static void pit_periodic (void);
+static void timer_advance (int64_t n);
 static bool too_many_loops (unsigned loops);
+static uint64_t clock_calibrate (uint64_t cached);
+static uint64_t tsc_hz_from_cpuid (void);
+static unsigned loops_from_tsc (uint64_t tsc_per_tick);
+static unsigned loops_from_ticks (void);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void real_time_delay (int64_t num, int32_t denom);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	pit_periodic ();
+	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+}
+
+/* 8254가 TIMER_FREQ번씩 인터럽트를 걸게 한다. */
+static void
+pit_periodic (void) {
+	uint16_t count = PIT_PERIOD;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
+}
 
-	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+/*** GrilledSalmon ***/
+/* idle 스레드가 인터럽트를 끈 채 부른다. 타이머 휠에 다음 할 일이 있는 tick이
+   두 tick 이상 뒤면 8254를 그때 한 번만 인터럽트를 걸도록 맞춘 뒤, 인터럽트를
+   켜고 잠든다. 인터럽트를 켠 채 돌아온다. */
+void
+timer_idle (void) {
+	int64_t n;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	n = workqueue_next_wakeup (thread_next_wakeup (ONESHOT_MAX_TICKS));
+	if (n > 1) {
+		uint16_t count = n * PIT_PERIOD;
+
+		outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+		outb (0x40, count & 0xff);
+		outb (0x40, count >> 8);
+		oneshot_ticks = n;
+	}
+	asm volatile ("sti; hlt" : : : "memory");
+}
+
+/* timer가 아닌 외부 인터럽트가 들어올 때 intr_handler()가 부른다. one-shot으로
+   자던 중이면 그동안 지난 tick을 세고 보통 mode로 돌아간다. 남은 counter에서
+   tick 하나가 못 되는 부분은 버린다. */
+void
+timer_wake (void) {
+	int64_t n = oneshot_ticks, elapsed;
+	uint16_t count;
+
+	ASSERT (intr_context ());
+	if (n == 0)
+		return;
+
+	outb (0x43, 0x00);    /* CW: latch counter 0. */
+	count = inb (0x40);
+	count |= inb (0x40) << 8;
+	if (count <= n * PIT_PERIOD)
+		elapsed = (n * PIT_PERIOD - count) / PIT_PERIOD;
+	else {
+		/* 이미 0을 지나 감았다. 걸려 있는 timer 인터럽트가 마지막 tick을
+		   센다. */
+		elapsed = n - 1;
+	}
+
+	oneshot_ticks = 0;
+	pit_periodic ();
+	timer_advance (elapsed);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
+/*** GrilledSalmon ***/
+/* 먼저 TSC 시계를 맞추고, busy_wait()의 속도를 TSC로 재서 loops_per_tick을 구한다.
+   tick을 기다리는 일이 많아야 한 번뿐이다. -loops=N이 있으면 재지 않는다. TSC로
+   구하지 못하면 tick마다 재 보는 원래 방법을 쓴다. 지난 부팅이 남긴 snapshot이
+   있으면 (threads/bootsnap.c) 둘 다 재지 않는다. */
 void
 timer_calibrate (void) {
-	unsigned high_bit, test_bit;
+	uint64_t tsc_per_tick = 0;
+	unsigned cached_loops = 0;
+	bool cached;
 
 	ASSERT (intr_get_level () == INTR_ON);
 	printf ("Calibrating timer...  ");
 
+	cached = bootsnap_get (&tsc_per_tick, &cached_loops);
+	tsc_per_tick = clock_calibrate (tsc_per_tick);
+	if (timer_loops_per_sec != 0)
+		loops_per_tick = timer_loops_per_sec / TIMER_FREQ;
+	else if (cached)
+		loops_per_tick = cached_loops;
+	else
+		loops_per_tick = loops_from_tsc (tsc_per_tick);
+	if (loops_per_tick == 0)
+		loops_per_tick = loops_from_ticks ();
+	if (timer_loops_per_sec == 0)
+		bootsnap_set (tsc_per_tick, loops_per_tick);
+
+	printf ("%'"PRIu64" loops/s%s.\n", (uint64_t) loops_per_tick * TIMER_FREQ,
+			cached && timer_loops_per_sec == 0 ? " (boot snapshot)" : "");
+}
+
+/* busy_wait()을 LOOPS_PROBE번 도는 데 드는 TSC cycle을 재서 한 tick
+   (TSC_PER_TICK cycle)에 도는 횟수를 리턴한다. 인터럽트가 끼지 않도록 끄고,
+   몇 번 재서 가장 빠른 값을 쓴다. 잴 수 없으면 0. */
+static unsigned
+loops_from_tsc (uint64_t tsc_per_tick) {
+	uint64_t best = UINT64_MAX;
+	uint64_t loops;
+
+	for (int i = 0; i < LOOPS_PROBE_CNT; i++) {
+		enum intr_level old_level = intr_disable ();
+		uint64_t start = rdtsc ();
+		uint64_t cycles;
+
+		busy_wait (LOOPS_PROBE);
+		cycles = rdtsc () - start;
+		intr_set_level (old_level);
+		if (cycles < best)
+			best = cycles;
+	}
+	if (best == 0 || tsc_per_tick == 0)
+		return 0;
+	loops = tsc_per_tick * LOOPS_PROBE / best;
+	return loops <= UINT_MAX ? loops : 0;
+}
+
+/* loops_per_tick을 timer tick에 맞춰 재 본다. 잴 때마다 새 tick을 기다린다. */
+static unsigned
+loops_from_ticks (void) {
+	unsigned loops, high_bit, test_bit;
+
 	/* Approximate loops_per_tick as the largest power-of-two
 	   still less than one timer tick. */
-	loops_per_tick = 1u << 10;
-	while (!too_many_loops (loops_per_tick << 1)) {
-		loops_per_tick <<= 1;
-		ASSERT (loops_per_tick != 0);
+	loops = 1u << 10;
+	while (!too_many_loops (loops << 1)) {
+		loops <<= 1;
+		ASSERT (loops != 0);
 	}
 
 	/* Refine the next 8 bits of loops_per_tick. */
-	high_bit = loops_per_tick;
+	high_bit = loops;
 	for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
 		if (!too_many_loops (high_bit | test_bit))
-			loops_per_tick |= test_bit;
+			loops |= test_bit;
+	return loops;
+}
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+/* CPUID leaf 0x15가 알려 주는 TSC의 주파수 (Hz). 모르면 0. */
+static uint64_t
+tsc_hz_from_cpuid (void) {
+	uint32_t eax = 0, ebx, ecx = 0, edx;
+
+	asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	if (eax < 0x15)
+		return 0;
+	eax = 0x15;
+	ecx = 0;
+	asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	if (eax == 0 || ebx == 0 || ecx == 0)
+		return 0;
+	return (uint64_t) ecx * ebx / eax;
+}
+
+/* TSC가 한 tick에 몇 번 세는지 구해 clock_page를 채우고 그 값을 리턴한다.
+   CACHED가 0이 아니면 그 값을 쓴다. 아니면 CPUID가 TSC 주파수를 알려 주면
+   그대로 쓰고, 아니면 tick 하나 동안 잰다. 잰 경우에는 tick 경계의 TSC 값을 그
+   tick의 시각으로 삼는다. */
+static uint64_t
+clock_calibrate (uint64_t cached) {
+	struct clock_page *cp = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	uint64_t tsc, tsc_per_tick = cached != 0 ? cached
+		: tsc_hz_from_cpuid () / TIMER_FREQ;
+	int64_t start = ticks;
+
+	if (tsc_per_tick != 0)
+		tsc = rdtsc ();
+	else {
+		while (ticks == start)
+			barrier ();
+		tsc = rdtsc ();
+		start = ticks;
+		while (ticks < start + CLOCK_CALIBRATE_TICKS)
+			barrier ();
+		tsc_per_tick = (rdtsc () - tsc) / CLOCK_CALIBRATE_TICKS;
+	}
+
+	cp->shift = 32;
+	cp->mult = ((uint64_t) NSEC_PER_TICK << cp->shift) / tsc_per_tick;
+	cp->tsc_base = tsc - start * tsc_per_tick;
+	clock_page = cp;
+	return tsc_per_tick;
+}
+
+/* Returns the number of nanoseconds since the OS booted.  Before
+   timer_calibrate(), only has tick resolution. */
+uint64_t
+timer_nanos (void) {
+	const struct clock_page *cp = clock_page;
+
+	if (cp == NULL)
+		return timer_ticks () * NSEC_PER_TICK;
+	return ((unsigned __int128) (rdtsc () - cp->tsc_base) * cp->mult) >> cp->shift;
+}
+
+/* Converts CYCLES of the TSC to nanoseconds, or returns 0 before
+   timer_calibrate(). */
+uint64_t
+timer_cycles_to_nanos (uint64_t cycles) {
+	const struct clock_page *cp = clock_page;
+
+	if (cp == NULL)
+		return 0;
+	return ((unsigned __int128) cycles * cp->mult) >> cp->shift;
+}
+
+/* Returns the kernel address of the clock page, or a null pointer
+   before timer_calibrate(). */
+void *
+timer_clock_page (void) {
+	return clock_page;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -114,6 +337,25 @@ timer_nsleep (int64_t ns) {
 	real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Busy-waits for approximately US microseconds.  Interrupts need
+   not be turned on.
+
+   Busy waiting wastes CPU cycles, and busy waiting with
+   interrupts off for the interval between timer ticks or longer
+   will cause timer ticks to be lost.  Thus, use timer_usleep()
+   instead if interrupts are enabled. */
+void
+timer_udelay (int64_t us) {
+	real_time_delay (us, 1000 * 1000);
+}
+
+/* Busy-waits for approximately NS nanoseconds.  Interrupts need
+   not be turned on.  See timer_udelay(). */
+void
+timer_ndelay (int64_t ns) {
+	real_time_delay (ns, 1000 * 1000 * 1000);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
@@ -122,27 +364,46 @@ timer_print_stats (void) {
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED) {
-	// 틱은 인터럽트가 발생할 때마다 틱은 증가한다.
-	ticks++;
-	thread_tick ();
-
-	/* P1_advanced_scheduler */
-	if (thread_mlfqs) {
-		mlfqs_increment();
-		if (ticks % 4 == 0) {
-			mlfqs_priority(thread_current());
-			if (ticks % TIMER_FREQ == 0) {
-				mlfqs_load_avg();
-				mlfqs_recalc();
+timer_interrupt (struct intr_frame *args) {
+	int64_t n = 1;
+
+	if (profile_enabled)
+		profile_sample (args);
+
+	/* one-shot으로 잔 만큼의 tick이 한꺼번에 지났다. */
+	if (oneshot_ticks > 0) {
+		n = oneshot_ticks;
+		oneshot_ticks = 0;
+		pit_periodic ();
+	}
+	timer_advance (n);
+}
+
+/* N tick을 센다. 그동안 한 tick씩 하던 일을 차례로 한다. */
+static void
+timer_advance (int64_t n) {
+	while (n-- > 0) {
+		// 틱은 인터럽트가 발생할 때마다 틱은 증가한다.
+		ticks++;
+		thread_tick ();
+
+		/* P1_advanced_scheduler */
+		if (thread_mlfqs) {
+			mlfqs_increment();
+			if (ticks % 4 == 0) {
+				mlfqs_priority(thread_current());
+				if (ticks % TIMER_FREQ == 0) {
+					mlfqs_load_avg();
+					mlfqs_recalc();
+				}
 			}
 		}
 	}
 
 	/* P1_alarm */
-	// next tict to awake값이 흐른 tick보다 작거나 같아지면 thread awake 함수를 호출한다.
-	if (get_next_tick_to_awake() <= ticks)
-		thread_awake(ticks);
+	// 타이머 휠을 현재 tick까지 전진시키고, 이번 tick에 깨어날 스레드들을 깨운다.
+	thread_awake(ticks);
+	workqueue_tick (ticks);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -201,3 +462,12 @@ real_time_sleep (int64_t num, int32_t denom) {
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* Busy-wait for approximately NUM/DENOM seconds. */
+static void
+real_time_delay (int64_t num, int32_t denom) {
+	/* Scale the numerator and denominator down by 1000 to avoid
+	   the possibility of overflow. */
+	ASSERT (denom % 1000 == 0);
+	busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+}
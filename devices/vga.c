@@ -30,6 +30,7 @@ static void cls (void);
 static void newline (void);
 static void move_cursor (void);
 static void find_cursor (size_t *x, size_t *y);
+static void put_run (const char *, size_t);
 
 /* Initializes the VGA text display. */
 static void
@@ -91,6 +92,107 @@ vga_putc (int c) {
 	intr_set_level (old_level);
 }
 
+/*** GrilledSalmon ***/
+/* Writes the N characters in BUFFER to the VGA text display, like
+   calling vga_putc() on each of them, but scrolls at most once per
+   form feed-free run and updates the hardware cursor only at the
+   end. */
+void
+vga_putbuf (const char *buffer, size_t n) {
+	enum intr_level old_level = intr_disable ();
+
+	init ();
+	while (n > 0) {
+		const char *ff = memchr (buffer, '\f', n);
+		size_t run = ff != NULL ? (size_t) (ff - buffer) : n;
+
+		put_run (buffer, run);
+		if (ff != NULL) {
+			cls ();
+			run++;
+		}
+		buffer += run;
+		n -= run;
+	}
+	move_cursor ();
+
+	intr_set_level (old_level);
+}
+
+/* Moves column *X past C, as vga_putc() would, and returns true
+   if that advances to the next line. */
+static bool
+advance (size_t *x, char c) {
+	switch (c) {
+		case '\n':
+			*x = 0;
+			return true;
+
+		case '\b':
+			if (*x > 0)
+				(*x)--;
+			return false;
+
+		case '\r':
+			*x = 0;
+			return false;
+
+		case '\t':
+			*x = ROUND_UP (*x + 1, 8);
+			break;
+
+		default:
+			++*x;
+			break;
+	}
+	if (*x >= COL_CNT) {
+		*x = 0;
+		return true;
+	}
+	return false;
+}
+
+/* Writes the N characters in BUFFER, none of which is a form
+   feed.  A first pass counts the lines the run advances, so the
+   screen is scrolled once by exactly as many rows as needed; the
+   second pass then writes each character straight to its final
+   row, dropping those that would have scrolled off the top. */
+static void
+put_run (const char *buffer, size_t n) {
+	size_t lines = 0;
+	size_t x = cx;
+	size_t scroll;
+	long y;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		if (advance (&x, buffer[i]))
+			lines++;
+
+	scroll = cy + lines >= ROW_CNT ? cy + lines - (ROW_CNT - 1) : 0;
+	if (scroll >= ROW_CNT)
+		for (y = 0; y < ROW_CNT; y++)
+			clear_row (y);
+	else if (scroll > 0) {
+		memmove (&fb[0], &fb[scroll], sizeof fb[0] * (ROW_CNT - scroll));
+		for (y = ROW_CNT - scroll; y < ROW_CNT; y++)
+			clear_row (y);
+	}
+
+	y = (long) cy - (long) scroll;
+	for (i = 0; i < n; i++) {
+		char c = buffer[i];
+
+		if (y >= 0 && c != '\n' && c != '\b' && c != '\r' && c != '\t') {
+			fb[y][cx][0] = c;
+			fb[y][cx][1] = GRAY_ON_BLACK;
+		}
+		if (advance (&cx, c))
+			y++;
+	}
+	cy = y;
+}
+
 /* Clears the screen and moves the cursor to the upper left. */
 static void
 cls (void) {
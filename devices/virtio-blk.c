@@ -0,0 +1,346 @@
+/* virtio-blk.c: Legacy virtio PCI block device driver. */
+
+#include "devices/virtio-blk.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdio.h>
+#include "devices/pci.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/*** GrilledSalmon ***/
+/* QEMU의 -device virtio-blk-pci를 legacy 인터페이스(BAR0의 I/O 포트)로
+   다룬다. 요청 하나는 header, buffer, status의 descriptor 세 개를 쓰고,
+   queue에 자리가 있는 만큼 여러 요청을 한꺼번에 장치에 맡긴다. IDE처럼
+   명령 하나씩 기다리지 않으므로 I/O scheduler와 요청 합치기를 거치지
+   않는다.
+
+   See the "Virtual I/O Device (VIRTIO) Version 1.0" specification,
+   section 4.1.4.8 "Legacy Interfaces: A Note on PCI Device Layout"
+   and section 5.2 "Block Device". */
+
+/* Transitional virtio-blk의 PCI ID. */
+#define VIRTIO_VENDOR 0x1af4
+#define VIRTIO_BLK_DEVICE 0x1001
+
+/* Legacy virtio 레지스터. BAR0의 I/O 포트에서의 offset이다. */
+#define VIRTIO_DEVICE_FEATURES 0x00     /* 장치 feature (32 bit). */
+#define VIRTIO_GUEST_FEATURES 0x04      /* 쓰기로 한 feature (32 bit). */
+#define VIRTIO_QUEUE_PFN 0x08           /* queue의 물리 page 번호 (32 bit). */
+#define VIRTIO_QUEUE_SIZE 0x0c          /* queue의 descriptor 수 (16 bit). */
+#define VIRTIO_QUEUE_SELECT 0x0e        /* 다룰 queue (16 bit). */
+#define VIRTIO_QUEUE_NOTIFY 0x10        /* 새 요청을 알린다 (16 bit). */
+#define VIRTIO_STATUS 0x12              /* 장치 상태 (8 bit). */
+#define VIRTIO_ISR 0x13                 /* 읽으면 인터럽트를 내린다 (8 bit). */
+#define VIRTIO_BLK_CAPACITY 0x14        /* sector 수 (64 bit). */
+
+/* VIRTIO_STATUS bit. */
+#define STATUS_ACKNOWLEDGE 0x01
+#define STATUS_DRIVER 0x02
+#define STATUS_DRIVER_OK 0x04
+#define STATUS_FAILED 0x80
+
+/* Legacy queue에서 used ring이 놓이는 정렬. */
+#define VRING_ALIGN 4096
+
+/* Virtqueue descriptor. */
+struct vring_desc {
+	uint64_t addr;              /* buffer의 물리 주소. */
+	uint32_t len;               /* 바이트 수. */
+	uint16_t flags;             /* VRING_DESC_F_*. */
+	uint16_t next;              /* VRING_DESC_F_NEXT면 다음 descriptor. */
+};
+#define VRING_DESC_F_NEXT 1     /* next로 이어진다. */
+#define VRING_DESC_F_WRITE 2    /* 장치가 쓰는 buffer다. */
+
+/* 드라이버가 장치에 넘기는 요청의 첫 descriptor 번호들. */
+struct vring_avail {
+	uint16_t flags;
+	uint16_t idx;               /* 다음에 채울 칸. 계속 늘어난다. */
+	uint16_t ring[];
+};
+
+/* 장치가 끝낸 요청. */
+struct vring_used_elem {
+	uint32_t id;                /* 첫 descriptor 번호. */
+	uint32_t len;               /* 장치가 쓴 바이트 수. */
+};
+
+struct vring_used {
+	uint16_t flags;
+	uint16_t idx;               /* 장치가 다음에 채울 칸. */
+	struct vring_used_elem ring[];
+};
+
+/* 블록 요청 header. */
+struct virtio_blk_req {
+	uint32_t type;              /* VIRTIO_BLK_T_*. */
+	uint32_t reserved;
+	uint64_t sector;
+};
+#define VIRTIO_BLK_T_IN 0       /* 읽기. */
+#define VIRTIO_BLK_T_OUT 1      /* 쓰기. */
+#define VIRTIO_BLK_S_OK 0       /* status byte: 성공. */
+
+/* 요청 칸. I번째 칸은 descriptor 3I, 3I+1, 3I+2를 쓴다. 장치가 header와
+   status를 DMA로 읽고 쓰므로 커널 주소에 둔다. */
+struct vblk_slot {
+	struct virtio_blk_req hdr;
+	uint8_t status;
+	struct disk_request *r;     /* 맡긴 요청. NULL이면 빈 칸. */
+};
+
+/* 요청 칸 수의 상한. */
+#define SLOT_MAX 64
+
+/* 찾을 수 있는 장치 수의 상한. */
+#define VIRTIO_BLK_MAX 4
+
+/* virtio-blk 장치 하나. slot과 queue는 인터럽트를 끄고 만진다. */
+struct virtio_blk {
+	int pci_slot;               /* PCI bus 0의 device 번호. */
+	uint16_t io_base;           /* BAR0 I/O 포트. */
+	uint8_t irq;                /* PIC line. */
+	disk_sector_t capacity;
+
+	uint16_t qsize;             /* descriptor 수. */
+	void *ring;                 /* desc, avail, used를 담은 page들. */
+	size_t ring_pages;
+	struct vring_desc *desc;
+	struct vring_avail *avail;
+	struct vring_used *used;
+	uint16_t last_used;         /* 처리한 used->idx. */
+
+	struct vblk_slot *slots;
+	size_t slot_cnt;
+	uint8_t free_slots[SLOT_MAX];   /* 빈 칸 번호의 stack. */
+	size_t free_cnt;
+	struct list waiting;        /* 칸이 없어 기다리는 struct disk_request. */
+};
+
+static struct virtio_blk devices[VIRTIO_BLK_MAX];
+static size_t device_cnt;
+
+/* virtio_blk_probe가 다음에 볼 PCI device 번호. */
+static int next_pci_slot;
+
+/* 처리기를 등록한 PIC line. */
+static bool irq_registered[16];
+
+static bool setup_device (struct virtio_blk *, int pci_slot);
+static void start_request (struct virtio_blk *, struct disk_request *);
+static void interrupt_handler (struct intr_frame *);
+
+/* PCI bus 0에서 다음 virtio-blk 장치를 찾아 초기화해 돌려준다. 더 없으면
+   NULL이다. disk_init이 부른다. */
+struct virtio_blk *
+virtio_blk_probe (void) {
+	while (next_pci_slot < 32 && device_cnt < VIRTIO_BLK_MAX) {
+		int dev = next_pci_slot++;
+		uint32_t id = pci_read_config (0, dev, 0, 0x00);
+		struct virtio_blk *vb = &devices[device_cnt];
+
+		if ((id & 0xffff) != VIRTIO_VENDOR || (id >> 16) != VIRTIO_BLK_DEVICE)
+			continue;
+		if (setup_device (vb, dev)) {
+			device_cnt++;
+			return vb;
+		}
+	}
+	return NULL;
+}
+
+/* VB가 꽂힌 PCI slot. */
+int
+virtio_blk_pci_slot (const struct virtio_blk *vb) {
+	return vb->pci_slot;
+}
+
+/* VB의 크기 (sector 수). */
+disk_sector_t
+virtio_blk_capacity (const struct virtio_blk *vb) {
+	return vb->capacity;
+}
+
+/* PCI slot DEV의 장치를 reset 하고 queue 0을 VB로 잡는다. 쓸 수 없는
+   장치면 메시지를 찍고 false를 리턴한다. */
+static bool
+setup_device (struct virtio_blk *vb, int dev) {
+	uint32_t bar0 = pci_read_config (0, dev, 0, 0x10);
+	uint8_t irq = pci_read_config (0, dev, 0, 0x3c) & 0xff;
+	size_t used_ofs, i;
+
+	if (!(bar0 & 1)) {
+		printf ("virtio-blk: pci 0:%d has no legacy I/O BAR\n", dev);
+		return false;
+	}
+	/* 14와 15는 IDE 채널이 쓴다. */
+	if (irq >= 16 || irq == 14 || irq == 15) {
+		printf ("virtio-blk: pci 0:%d uses unusable irq %d\n", dev, irq);
+		return false;
+	}
+
+	vb->pci_slot = dev;
+	vb->io_base = bar0 & 0xfffc;
+	vb->irq = irq;
+	/* Command 레지스터의 I/O space(bit 0)와 bus master(bit 2). */
+	pci_write_config (0, dev, 0, 0x04,
+			pci_read_config (0, dev, 0, 0x04) | 0x05);
+
+	outb (vb->io_base + VIRTIO_STATUS, 0);
+	outb (vb->io_base + VIRTIO_STATUS, STATUS_ACKNOWLEDGE);
+	outb (vb->io_base + VIRTIO_STATUS, STATUS_ACKNOWLEDGE | STATUS_DRIVER);
+	/* 쓰는 feature가 없다. */
+	outl (vb->io_base + VIRTIO_GUEST_FEATURES, 0);
+	vb->capacity = inl (vb->io_base + VIRTIO_BLK_CAPACITY);
+	if (inl (vb->io_base + VIRTIO_BLK_CAPACITY + 4) != 0)
+		vb->capacity = UINT32_MAX;
+
+	outw (vb->io_base + VIRTIO_QUEUE_SELECT, 0);
+	vb->qsize = inw (vb->io_base + VIRTIO_QUEUE_SIZE);
+	if (vb->qsize < 3) {
+		printf ("virtio-blk: pci 0:%d has no request queue\n", dev);
+		goto fail;
+	}
+	used_ofs = ROUND_UP (vb->qsize * sizeof (struct vring_desc)
+			+ sizeof (struct vring_avail) + (vb->qsize + 1) * sizeof (uint16_t),
+			VRING_ALIGN);
+	vb->ring_pages = DIV_ROUND_UP (used_ofs + sizeof (struct vring_used)
+			+ vb->qsize * sizeof (struct vring_used_elem) + sizeof (uint16_t),
+			PGSIZE);
+	vb->ring = palloc_get_multiple (PAL_ZERO, vb->ring_pages);
+	vb->slot_cnt = vb->qsize / 3 < SLOT_MAX ? vb->qsize / 3 : SLOT_MAX;
+	vb->slots = calloc (vb->slot_cnt, sizeof *vb->slots);
+	if (vb->ring == NULL || vb->slots == NULL) {
+		printf ("virtio-blk: pci 0:%d: out of memory\n", dev);
+		if (vb->ring != NULL)
+			palloc_free_multiple (vb->ring, vb->ring_pages);
+		free (vb->slots);
+		goto fail;
+	}
+	vb->desc = vb->ring;
+	vb->avail = (struct vring_avail *) (vb->desc + vb->qsize);
+	vb->used = (struct vring_used *) ((uint8_t *) vb->ring + used_ofs);
+	vb->last_used = 0;
+	/* 칸마다 descriptor 세 개를 미리 이어 둔다. */
+	for (i = 0; i < vb->slot_cnt; i++) {
+		struct vblk_slot *s = &vb->slots[i];
+		struct vring_desc *d = &vb->desc[i * 3];
+
+		d[0].addr = vtop (&s->hdr);
+		d[0].len = sizeof s->hdr;
+		d[0].flags = VRING_DESC_F_NEXT;
+		d[0].next = i * 3 + 1;
+		d[1].flags = VRING_DESC_F_NEXT;
+		d[1].next = i * 3 + 2;
+		d[2].addr = vtop (&s->status);
+		d[2].len = sizeof s->status;
+		d[2].flags = VRING_DESC_F_WRITE;
+		vb->free_slots[i] = i;
+	}
+	vb->free_cnt = vb->slot_cnt;
+	list_init (&vb->waiting);
+	outl (vb->io_base + VIRTIO_QUEUE_PFN, vtop (vb->ring) / VRING_ALIGN);
+
+	if (!irq_registered[irq]) {
+		intr_register_ext (0x20 + irq, interrupt_handler, "virtio-blk");
+		irq_registered[irq] = true;
+	}
+	outb (vb->io_base + VIRTIO_STATUS,
+			STATUS_ACKNOWLEDGE | STATUS_DRIVER | STATUS_DRIVER_OK);
+	return true;
+
+fail:
+	outb (vb->io_base + VIRTIO_STATUS, STATUS_FAILED);
+	return false;
+}
+
+/* R을 VB에 맡긴다. 빈 칸이 없으면 칸이 날 때까지 기다리게 둔다.
+   disk_submit이 인터럽트를 끄고 부른다. */
+void
+virtio_blk_submit (struct virtio_blk *vb, struct disk_request *r) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (vb->free_cnt == 0)
+		list_push_back (&vb->waiting, &r->elem);
+	else
+		start_request (vb, r);
+}
+
+/* 빈 칸에 R을 채우고 장치에 알린다. */
+static void
+start_request (struct virtio_blk *vb, struct disk_request *r) {
+	size_t i = vb->free_slots[--vb->free_cnt];
+	struct vblk_slot *s = &vb->slots[i];
+	struct vring_desc *buf = &vb->desc[i * 3 + 1];
+
+	s->hdr.type = r->write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+	s->hdr.reserved = 0;
+	s->hdr.sector = r->sector;
+	s->status = 0xff;
+	s->r = r;
+	/* 커널 주소는 물리적으로도 연속이므로 buffer는 descriptor 하나로 된다. */
+	buf->addr = vtop (r->buffer);
+	buf->len = r->cnt * DISK_SECTOR_SIZE;
+	buf->flags = VRING_DESC_F_NEXT | (r->write ? 0 : VRING_DESC_F_WRITE);
+
+	vb->avail->ring[vb->avail->idx % vb->qsize] = i * 3;
+	barrier ();
+	vb->avail->idx++;
+	barrier ();
+	outw (vb->io_base + VIRTIO_QUEUE_NOTIFY, 0);
+}
+
+/* VB가 끝낸 요청을 거둬 disk_request_complete로 돌려주고, 기다리던
+   요청을 빈 칸에 채운다. */
+static void
+reap (struct virtio_blk *vb) {
+	struct list done;
+
+	list_init (&done);
+	while (vb->last_used != vb->used->idx) {
+		struct vring_used_elem *e;
+		struct vblk_slot *s;
+		size_t i;
+
+		barrier ();
+		e = &vb->used->ring[vb->last_used % vb->qsize];
+		i = e->id / 3;
+		ASSERT (i < vb->slot_cnt && vb->slots[i].r != NULL);
+		s = &vb->slots[i];
+		if (s->status != VIRTIO_BLK_S_OK)
+			PANIC ("virtio-blk: pci 0:%d: %s failed, sector=%"PRDSNu,
+					vb->pci_slot, s->r->write ? "write" : "read", s->r->sector);
+		list_push_back (&done, &s->r->elem);
+		s->r = NULL;
+		vb->free_slots[vb->free_cnt++] = i;
+		vb->last_used++;
+	}
+
+	while (vb->free_cnt > 0 && !list_empty (&vb->waiting))
+		start_request (vb, list_entry (list_pop_front (&vb->waiting),
+					struct disk_request, elem));
+	/* done이 요청을 다시 보낼 수 있으므로 칸을 정리한 뒤에 부른다. */
+	while (!list_empty (&done))
+		disk_request_complete (list_entry (list_pop_front (&done),
+					struct disk_request, elem));
+}
+
+/* 같은 line을 나눠 쓰는 장치를 모두 본다. ISR을 읽어야 line이 내려간다. */
+static void
+interrupt_handler (struct intr_frame *f) {
+	size_t i;
+
+	for (i = 0; i < device_cnt; i++) {
+		struct virtio_blk *vb = &devices[i];
+
+		if (f->vec_no == 0x20u + vb->irq
+				&& (inb (vb->io_base + VIRTIO_ISR) & 1) != 0)
+			reap (vb);
+	}
+}
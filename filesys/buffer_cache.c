@@ -0,0 +1,531 @@
+/* buffer_cache.c: Write-back cache of file system disk sectors. */
+
+#include "filesys/buffer_cache.h"
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/csum.h"
+#include "filesys/filesys.h"
+#include "filesys/page_cache.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/*** GrilledSalmon ***/
+/* 캐시 칸 하나. sector와 used, accessed, pin_cnt는 bc_lock이, valid와 dirty,
+ * data는 칸의 lock이 보호한다. pin 한 스레드만 칸의 lock을 잡으므로 pin_cnt가
+ * 0인 칸은 bc_lock만 잡고 바꿀 수 있다. */
+struct bc_entry {
+	disk_sector_t sector;		/* 담고 있는 sector. */
+	bool used;					/* sector에 배정되었다. */
+	bool valid;					/* data에 sector의 내용이 있다. */
+	bool dirty;					/* 디스크에 아직 쓰지 않은 내용이 있다. */
+	bool accessed;				/* clock의 second chance. */
+	bool held;					/* journal이 commit 할 때까지 디스크에 쓰지 않는다. */
+	int pin_cnt;				/* 0보다 크면 다른 sector에 내주지 않는다. */
+	struct lock lock;
+	uint8_t *data;
+	bool frequent;				/* 2Q: am에 있다. 아니면 a1in에 있다. */
+	struct list_elem q_elem;	/* 2Q: a1in 또는 am의 원소. bc_lock이 보호한다. */
+};
+
+size_t bc_sectors = BC_DEFAULT_SECTORS;
+
+/*** GrilledSalmon ***/
+/* -bc-policy=NAME으로 고를 수 있는 교체 정책. 모두 bc_lock을 잡고 부른다.
+ * VICTIM은 내줄 칸을 고르고(모두 pin 되어 있으면 NULL) INSERT는 그 칸에 새 sector가
+ * 들어온 뒤에, HIT는 캐시에 있던 sector를 다시 찾았을 때 부른다. */
+struct bc_policy {
+	const char *name;
+	struct bc_entry *(*victim) (void);
+	void (*insert) (struct bc_entry *);
+	void (*hit) (struct bc_entry *);
+};
+
+static struct bc_entry *victim_clock (void);
+static struct bc_entry *victim_2q (void);
+static void insert_2q (struct bc_entry *);
+static void hit_2q (struct bc_entry *);
+static void policy_nop (struct bc_entry *e UNUSED) {}
+
+static const struct bc_policy bc_policies[] = {
+	{ "clock", victim_clock, policy_nop, policy_nop },
+	{ "2q", victim_2q, insert_2q, hit_2q },
+};
+static const struct bc_policy *bc_policy = &bc_policies[0];
+
+/* 2Q: 처음 들어온 sector는 a1in(FIFO)에, a1in에서 내준 뒤 ghost에 이름이 남아
+ * 있는 동안 다시 찾은 sector는 am(LRU)에 둔다. a1in이 캐시의 A1IN_PCT%보다 길면
+ * a1in에서 내주므로 한 번 훑고 지나가는 sector는 am을 밀어내지 못한다. ghost는
+ * a1in에서 내준 sector 번호를 캐시의 GHOST_PCT%만큼 기억하는 원형 큐다. */
+#define A1IN_PCT 25
+#define GHOST_PCT 50
+#define NO_SECTOR ((disk_sector_t) -1)
+static struct list a1in, am;
+static size_t a1in_cnt, a1in_max;
+static disk_sector_t *ghosts;
+static size_t ghost_head, ghost_max;
+
+static struct bc_entry *entries;
+static size_t clock_hand;
+static struct lock bc_lock;
+static struct condition bc_unpinned;	/* 모든 칸이 pin 되어 있을 때 기다린다. */
+
+/* 미리 읽을 sector의 원형 큐. bc_lock이 보호하고, 가득 차면 새 요청은 버린다. */
+#define RA_QUEUE_SIZE 32
+static disk_sector_t ra_queue[RA_QUEUE_SIZE];
+static size_t ra_head, ra_cnt;
+static struct work ra_work;		/* 큐를 비우는 work. */
+
+/* 통계. bc_lock이 보호한다. */
+static size_t hit_cnt, miss_cnt, ra_cnt_total;
+
+static void bc_readahead_work (void *aux);
+
+/* Initializes the buffer cache. */
+void
+bc_init (void) {
+	uint8_t *data;
+	size_t i;
+
+	if (bc_sectors == 0)
+		bc_sectors = 1;
+	entries = calloc (bc_sectors, sizeof *entries);
+	data = malloc (bc_sectors * DISK_SECTOR_SIZE);
+	ghost_max = bc_sectors * GHOST_PCT / 100 > 0 ? bc_sectors * GHOST_PCT / 100 : 1;
+	ghosts = malloc (ghost_max * sizeof *ghosts);
+	if (entries == NULL || data == NULL || ghosts == NULL)
+		PANIC ("buffer cache allocation failed");
+	/* 빈 칸은 모두 a1in에서 시작해 가장 먼저 내준다. */
+	list_init (&a1in);
+	list_init (&am);
+	for (i = 0; i < bc_sectors; i++) {
+		lock_init (&entries[i].lock);
+		entries[i].data = data + i * DISK_SECTOR_SIZE;
+		list_push_back (&a1in, &entries[i].q_elem);
+	}
+	a1in_cnt = bc_sectors;
+	a1in_max = bc_sectors * A1IN_PCT / 100 > 0 ? bc_sectors * A1IN_PCT / 100 : 1;
+	for (i = 0; i < ghost_max; i++)
+		ghosts[i] = NO_SECTOR;
+	ghost_head = 0;
+	lock_init (&bc_lock);
+	cond_init (&bc_unpinned);
+	clock_hand = 0;
+	ra_head = ra_cnt = 0;
+	work_init (&ra_work, bc_readahead_work, NULL);
+}
+
+/* SECTOR를 담은 칸을 리턴한다. 없으면 NULL. bc_lock을 잡고 불러야 한다. */
+static struct bc_entry *
+bc_lookup (disk_sector_t sector) {
+	size_t i;
+
+	for (i = 0; i < bc_sectors; i++)
+		if (entries[i].used && entries[i].sector == sector)
+			return &entries[i];
+	return NULL;
+}
+
+/* Selects the buffer cache replacement policy called NAME.
+ * Returns false if there is no such policy.  bc_init 전에 부른다. */
+bool
+bc_set_policy (const char *name) {
+	size_t i;
+
+	for (i = 0; i < sizeof bc_policies / sizeof *bc_policies; i++)
+		if (!strcmp (name, bc_policies[i].name)) {
+			bc_policy = &bc_policies[i];
+			return true;
+		}
+	return false;
+}
+
+/* clock으로 내줄 칸을 고른다. 최근에 쓰인 칸은 한 번 넘어가고, 모든 칸이
+ * pin 되어 있으면 NULL을 리턴한다. */
+static struct bc_entry *
+victim_clock (void) {
+	size_t scanned;
+
+	for (scanned = 0; scanned < 2 * bc_sectors; scanned++) {
+		struct bc_entry *e = &entries[clock_hand];
+
+		clock_hand = (clock_hand + 1) % bc_sectors;
+		if (e->pin_cnt > 0 || e->held)
+			continue;
+		if (e->used && e->accessed) {
+			e->accessed = false;
+			continue;
+		}
+		return e;
+	}
+	return NULL;
+}
+
+/*** GrilledSalmon ***/
+/* 2Q: Q의 앞(가장 오래된 쪽)부터 내줄 수 있는 칸을 찾는다. */
+static struct bc_entry *
+queue_victim (struct list *q) {
+	struct list_elem *el;
+
+	for (el = list_begin (q); el != list_end (q); el = list_next (el)) {
+		struct bc_entry *e = list_entry (el, struct bc_entry, q_elem);
+
+		if (e->pin_cnt == 0 && !e->held)
+			return e;
+	}
+	return NULL;
+}
+
+/* 2Q: a1in이 제 몫보다 길면 a1in의 FIFO 앞에서, 아니면 am의 LRU 앞에서 고른다.
+ * 그쪽이 모두 pin 되어 있으면 다른 쪽에서 고른다. a1in에서 내주는 sector는
+ * ghost에 번호를 남긴다. */
+static struct bc_entry *
+victim_2q (void) {
+	bool from_a1in = a1in_cnt > a1in_max;
+	struct bc_entry *e = queue_victim (from_a1in ? &a1in : &am);
+
+	if (e == NULL)
+		e = queue_victim (from_a1in ? &am : &a1in);
+	if (e == NULL)
+		return NULL;
+	list_remove (&e->q_elem);
+	if (!e->frequent) {
+		a1in_cnt--;
+		if (e->used) {
+			ghosts[ghost_head] = e->sector;
+			ghost_head = (ghost_head + 1) % ghost_max;
+		}
+	}
+	return e;
+}
+
+/* 2Q: 새 sector가 들어온 E를 ghost에 이름이 있으면 am 끝에, 없으면 a1in 끝에
+ * 넣는다. */
+static void
+insert_2q (struct bc_entry *e) {
+	size_t i;
+
+	e->frequent = false;
+	for (i = 0; i < ghost_max; i++)
+		if (ghosts[i] == e->sector) {
+			ghosts[i] = NO_SECTOR;
+			e->frequent = true;
+			break;
+		}
+	if (e->frequent)
+		list_push_back (&am, &e->q_elem);
+	else {
+		list_push_back (&a1in, &e->q_elem);
+		a1in_cnt++;
+	}
+}
+
+/* 2Q: am에 있는 E를 다시 찾으면 LRU 끝으로 옮긴다. a1in에서는 짧은 동안 몰려
+ * 오는 참조를 한 번으로 치므로 옮기지 않는다. */
+static void
+hit_2q (struct bc_entry *e) {
+	if (e->frequent) {
+		list_remove (&e->q_elem);
+		list_push_back (&am, &e->q_elem);
+	}
+}
+
+/* bc_policy로 내줄 칸을 고른다. 모든 칸이 pin 되어 있으면 NULL을 리턴한다.
+ * 고른 칸이 dirty면 디스크에 써 둔다. bc_lock을 잡고 불러야 한다. */
+static struct bc_entry *
+bc_victim (void) {
+	struct bc_entry *e = bc_policy->victim ();
+
+	if (e == NULL)
+		return NULL;
+	/* 쓰는 동안 다른 스레드가 옛 sector를 디스크에서 읽지 않게 bc_lock을 잡은 채 쓴다. */
+	if (e->used && e->dirty) {
+		csum_update (e->sector, e->data);
+		disk_write (filesys_disk, e->sector, e->data);
+	}
+#ifdef VM
+	/* 내준 sector는 유저 풀의 빈 frame에 남겨 두었다가 다시 읽을 때 가져온다. */
+	if (e->used && e->valid)
+		page_cache_sector_put (e->sector, e->data);
+#endif
+	return e;
+}
+
+/* SECTOR의 칸을 pin 하고 lock을 잡아서 리턴한다. 없으면 칸을 하나 내주는데
+ * 그때 valid는 false다. 다 쓰면 bc_put으로 놓는다. */
+static struct bc_entry *
+bc_get (disk_sector_t sector) {
+	struct bc_entry *e;
+
+	lock_acquire (&bc_lock);
+	e = bc_lookup (sector);
+	if (e != NULL) {
+		hit_cnt++;
+		bc_policy->hit (e);
+	} else
+		miss_cnt++;
+	while ((e = bc_lookup (sector)) == NULL) {
+		e = bc_victim ();
+		if (e != NULL) {
+			e->sector = sector;
+			e->used = true;
+			e->valid = false;
+#ifdef VM
+			e->valid = page_cache_sector_take (sector, e->data);
+#endif
+			e->dirty = false;
+			e->held = false;
+			bc_policy->insert (e);
+			break;
+		}
+		cond_wait (&bc_unpinned, &bc_lock);
+	}
+	e->pin_cnt++;
+	e->accessed = true;
+	lock_release (&bc_lock);
+
+	lock_acquire (&e->lock);
+	return e;
+}
+
+/* bc_get으로 받은 칸 E를 놓는다. */
+static void
+bc_put (struct bc_entry *e) {
+	lock_release (&e->lock);
+	lock_acquire (&bc_lock);
+	if (--e->pin_cnt == 0)
+		cond_signal (&bc_unpinned, &bc_lock);
+	lock_release (&bc_lock);
+}
+
+/* SECTOR의 OFS부터 SIZE 바이트를 BUFFER로 읽는다. */
+void
+bc_read (disk_sector_t sector, void *buffer, size_t ofs, size_t size) {
+	struct bc_entry *e;
+
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+	e = bc_get (sector);
+	if (!e->valid) {
+		disk_read (filesys_disk, sector, e->data);
+		csum_verify (sector, e->data);
+		e->valid = true;
+	}
+	memcpy (buffer, e->data + ofs, size);
+	bc_put (e);
+}
+
+/*** GrilledSalmon ***/
+/* SECTOR부터 연달아 놓인 CNT개의 sector 전체를 BUFFER로 읽는다. 캐시에 있는
+ * sector는 복사하고, 없는 sector는 칸을 내주지 않고 이어진 것끼리 한 번의
+ * disk_read_multiple로 BUFFER에 바로 읽는다. 없다고 본 뒤에 누가 캐시에 쓰더라도
+ * 그 쓰기보다 먼저 읽은 것이 된다. dirty 칸은 bc_lock을 잡고 디스크에 쓴 다음에야
+ * 캐시에서 빠지므로 옛 내용을 읽는 일은 없다. */
+void
+bc_read_direct (disk_sector_t sector, void *buffer, size_t cnt) {
+	uint8_t *p = buffer;
+
+	ASSERT (cnt <= DISK_MAX_SECTORS);
+	while (cnt > 0) {
+		size_t run = 0;
+
+		lock_acquire (&bc_lock);
+		while (run < cnt && bc_lookup (sector + run) == NULL)
+			run++;
+		miss_cnt += run;
+		lock_release (&bc_lock);
+
+		if (run == 0) {
+			bc_read (sector, p, 0, DISK_SECTOR_SIZE);
+			run = 1;
+		} else {
+			disk_read_multiple (filesys_disk, sector, p, run);
+			for (size_t i = 0; i < run; i++)
+				csum_verify (sector + i, p + i * DISK_SECTOR_SIZE);
+		}
+		sector += run;
+		p += run * DISK_SECTOR_SIZE;
+		cnt -= run;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* BUFFER의 CNT개 sector를 SECTOR부터 연달아 디스크에 쓴다. 캐시에 있는 sector는
+ * 캐시에 쓰고, 없는 sector는 칸을 내주지 않고 이어진 것끼리 한 번의
+ * disk_write_multiple로 쓴다. 쓰는 동안 bc_lock을 잡고 있으므로 다른 스레드가
+ * 그 sector를 옛 내용으로 캐시에 올리지 못한다. page cache에 남은 옛 사본은
+ * 버린다. */
+void
+bc_write_direct (disk_sector_t sector, const void *buffer, size_t cnt) {
+	const uint8_t *p = buffer;
+
+	ASSERT (cnt <= DISK_MAX_SECTORS);
+	while (cnt > 0) {
+		size_t run = 0;
+
+		lock_acquire (&bc_lock);
+		while (run < cnt && bc_lookup (sector + run) == NULL)
+			run++;
+		if (run > 0) {
+			for (size_t i = 0; i < run; i++)
+				csum_update (sector + i, p + i * DISK_SECTOR_SIZE);
+			disk_write_multiple (filesys_disk, sector, p, run);
+#ifdef VM
+			for (size_t i = 0; i < run; i++)
+				page_cache_sector_take (sector + i, NULL);
+#endif
+		}
+		lock_release (&bc_lock);
+
+		if (run == 0) {
+			bc_write (sector, p, 0, DISK_SECTOR_SIZE);
+			run = 1;
+		}
+		sector += run;
+		p += run * DISK_SECTOR_SIZE;
+		cnt -= run;
+	}
+}
+
+/* bc_write와 bc_write_held가 함께 쓴다. */
+static void
+write_sector (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size, bool hold) {
+	struct bc_entry *e;
+
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+	e = bc_get (sector);
+	if (!e->valid) {
+		if (ofs != 0 || size != DISK_SECTOR_SIZE) {
+			disk_read (filesys_disk, sector, e->data);
+			csum_verify (sector, e->data);
+		}
+		e->valid = true;
+	}
+	memcpy (e->data + ofs, buffer, size);
+	e->dirty = true;
+	if (hold)
+		e->held = true;
+	bc_put (e);
+}
+
+/* BUFFER의 SIZE 바이트를 SECTOR의 OFS부터 쓴다. 디스크에는 칸을 내줄 때나
+ * bc_flush에서 쓴다. sector 전체를 덮어쓰면 먼저 읽지 않는다. */
+void
+bc_write (disk_sector_t sector, const void *buffer, size_t ofs, size_t size) {
+	write_sector (sector, buffer, ofs, size, false);
+}
+
+/*** GrilledSalmon ***/
+/* bc_write처럼 쓰지만 bc_checkpoint 할 때까지 칸을 내주지도 bc_flush로 쓰지도
+ * 않는다. journal이 commit 전에 metadata가 제자리에 쓰이지 않게 할 때 쓴다. */
+void
+bc_write_held (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size) {
+	write_sector (sector, buffer, ofs, size, true);
+}
+
+/* bc_write_held로 붙잡은 SECTOR를 디스크 제자리에 쓰고 놓아준다. */
+void
+bc_checkpoint (disk_sector_t sector) {
+	struct bc_entry *e = bc_get (sector);
+
+	ASSERT (e->valid);
+	if (e->dirty) {
+		csum_update (sector, e->data);
+		disk_write (filesys_disk, sector, e->data);
+		e->dirty = false;
+	}
+	e->held = false;
+	bc_put (e);
+}
+
+/* dirty인 칸을 모두 디스크에 쓴다. journal이 붙잡은 칸은 건너뛴다. 그 뒤에
+ * 바뀐 checksum도 쓴다. */
+void
+bc_flush (void) {
+	size_t i;
+
+	for (i = 0; i < bc_sectors; i++) {
+		struct bc_entry *e = &entries[i];
+
+		lock_acquire (&bc_lock);
+		if (!e->used) {
+			lock_release (&bc_lock);
+			continue;
+		}
+		e->pin_cnt++;
+		lock_release (&bc_lock);
+
+		lock_acquire (&e->lock);
+		if (e->dirty && !e->held) {
+			csum_update (e->sector, e->data);
+			disk_write (filesys_disk, e->sector, e->data);
+			e->dirty = false;
+		}
+		bc_put (e);
+	}
+	csum_flush ();
+}
+
+/* SECTOR를 work queue가 나중에 읽어 두도록 큐에 넣는다. 이미 캐시에 있거나
+ * 큐가 가득 차 있으면 아무것도 하지 않는다. 기다리지 않고 바로 리턴한다. */
+void
+bc_readahead (disk_sector_t sector) {
+	lock_acquire (&bc_lock);
+	if (bc_lookup (sector) == NULL && ra_cnt < RA_QUEUE_SIZE) {
+		ra_queue[(ra_head + ra_cnt) % RA_QUEUE_SIZE] = sector;
+		ra_cnt++;
+		work_queue (&ra_work, WQ_NORMAL);
+	}
+	lock_release (&bc_lock);
+}
+
+/* 큐에 들어온 sector를 큐가 빌 때까지 차례로 캐시에 읽어 둔다. 읽는 동안
+ * 칸의 lock을 잡고 있으므로 같은 sector를 읽으려는 스레드는 디스크를 다시
+ * 읽지 않고 기다린다. */
+static void
+bc_readahead_work (void *aux UNUSED) {
+	for (;;) {
+		disk_sector_t sector;
+		struct bc_entry *e;
+
+		lock_acquire (&bc_lock);
+		if (ra_cnt == 0) {
+			lock_release (&bc_lock);
+			return;
+		}
+		sector = ra_queue[ra_head];
+		ra_head = (ra_head + 1) % RA_QUEUE_SIZE;
+		ra_cnt--;
+		lock_release (&bc_lock);
+
+		e = bc_get (sector);
+		if (!e->valid) {
+			disk_read (filesys_disk, sector, e->data);
+			csum_verify (sector, e->data);
+			e->valid = true;
+			ra_cnt_total++;
+		}
+		bc_put (e);
+	}
+}
+
+/* 통계를 HITS, MISSES, READAHEAD에 담는다. */
+void
+bc_get_stats (size_t *hits, size_t *misses, size_t *readahead) {
+	*hits = hit_cnt;
+	*misses = miss_cnt;
+	*readahead = ra_cnt_total;
+}
+
+/* Prints buffer cache statistics. */
+void
+bc_print_stats (void) {
+	if (entries == NULL)
+		return;
+	printf ("Buffer cache: %zu hits, %zu misses, %zu sectors read ahead\n",
+			hit_cnt, miss_cnt, ra_cnt_total);
+}
@@ -0,0 +1,152 @@
+/* csum.c: Per-sector CRC32C checksums of file system data. */
+
+#include "filesys/csum.h"
+#include <bitmap.h>
+#include <crc32c.h>
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/*** GrilledSalmon ***/
+/* buffer cache가 디스크에서 읽어 온 sector를 확인하고, 디스크에 쓸 때 새
+ * checksum을 적어 둔다. checksum은 journal 뒤의 영역에 sector 번호 순서대로
+ * 4 byte씩 놓인다. 0은 "모름"이라 확인하지 않으므로 checksum 없이 쓰인
+ * sector나 포맷 직후의 sector도 읽을 수 있다. 맞지 않으면 경고만 찍고 센다.
+ * checksum sector는 FAT처럼 처음 볼 때 읽고, 바뀐 것은 bc_flush가 끝날 때
+ * csum_flush가 디스크에 쓴다. csum_lock만 잡고 디스크를 직접 읽고 쓰므로
+ * bc_lock을 잡은 채 불러도 된다. */
+static disk_sector_t csum_start;   /* 0이면 checksum을 쓰지 않는다. */
+static size_t csum_sectors;
+static uint32_t **tables;          /* checksum sector i의 사본. NULL이면 아직 읽지 않았다. */
+static struct bitmap *dirty_map;   /* 바뀌었지만 디스크에 쓰지 않은 checksum sector. */
+static struct lock csum_lock;
+static long mismatch_cnt;
+
+bool csum_format_enabled;
+
+/* START부터 SECTORS개의 checksum 영역을 쓴다. SECTORS가 0이면 끈다. */
+void
+csum_init (disk_sector_t start, size_t sectors) {
+	size_t i;
+
+	lock_init (&csum_lock);
+	/* 포맷하면 마운트할 때 읽은 boot sector로 한 번 부른 뒤 다시 부른다. */
+	if (tables != NULL) {
+		for (i = 0; i < csum_sectors; i++)
+			free (tables[i]);
+		free (tables);
+		bitmap_destroy (dirty_map);
+		tables = NULL;
+	}
+	csum_start = 0;
+	if (start == 0 || sectors == 0)
+		return;
+	tables = calloc (sectors, sizeof *tables);
+	dirty_map = bitmap_create (sectors);
+	if (tables == NULL || dirty_map == NULL)
+		PANIC ("checksum init failed");
+	csum_start = start;
+	csum_sectors = sectors;
+}
+
+/* 방금 포맷한 디스크의 checksum 영역을 모두 "모름"으로 비운다. */
+void
+csum_format (void) {
+	static uint8_t zeros[DISK_SECTOR_SIZE];
+	size_t i;
+
+	if (csum_start == 0)
+		return;
+	lock_acquire (&csum_lock);
+	for (i = 0; i < csum_sectors; i++) {
+		free (tables[i]);
+		tables[i] = NULL;
+		disk_write (filesys_disk, csum_start + i, zeros);
+	}
+	bitmap_set_all (dirty_map, false);
+	lock_release (&csum_lock);
+}
+
+/* SECTOR의 checksum이 든 칸을 돌려준다. SECTOR를 덮는 checksum이 없으면
+ * NULL이다. csum_lock을 잡고 부른다. */
+static uint32_t *
+csum_slot (disk_sector_t sector) {
+	size_t idx = sector / CSUM_PER_SECTOR;
+
+	ASSERT (lock_held_by_current_thread (&csum_lock));
+	if (idx >= csum_sectors
+			|| (sector >= csum_start && sector < csum_start + csum_sectors))
+		return NULL;
+	if (tables[idx] == NULL) {
+		tables[idx] = malloc (DISK_SECTOR_SIZE);
+		if (tables[idx] == NULL)
+			PANIC ("checksum load failed");
+		disk_read (filesys_disk, csum_start + idx, tables[idx]);
+	}
+	return &tables[idx][sector % CSUM_PER_SECTOR];
+}
+
+/* 디스크에서 읽은 SECTOR의 내용 DATA가 적어 둔 checksum과 맞는지 본다.
+ * 맞지 않으면 경고를 찍고 false를 리턴한다. */
+bool
+csum_verify (disk_sector_t sector, const void *data) {
+	uint32_t *slot, crc;
+	bool ok = true;
+
+	if (csum_start == 0)
+		return true;
+	crc = crc32c (0, data, DISK_SECTOR_SIZE);
+	lock_acquire (&csum_lock);
+	slot = csum_slot (sector);
+	if (slot != NULL && *slot != 0 && *slot != crc) {
+		mismatch_cnt++;
+		ok = false;
+	}
+	lock_release (&csum_lock);
+	if (!ok)
+		printf ("checksum mismatch in sector %"PRDSNu"\n", sector);
+	return ok;
+}
+
+/* SECTOR에 DATA를 쓰기 전에 부른다. */
+void
+csum_update (disk_sector_t sector, const void *data) {
+	uint32_t *slot, crc;
+
+	if (csum_start == 0)
+		return;
+	crc = crc32c (0, data, DISK_SECTOR_SIZE);
+	lock_acquire (&csum_lock);
+	slot = csum_slot (sector);
+	if (slot != NULL && *slot != crc) {
+		*slot = crc;
+		bitmap_mark (dirty_map, sector / CSUM_PER_SECTOR);
+	}
+	lock_release (&csum_lock);
+}
+
+/* 바뀐 checksum sector를 디스크에 쓴다. */
+void
+csum_flush (void) {
+	size_t i;
+
+	if (csum_start == 0)
+		return;
+	lock_acquire (&csum_lock);
+	for (i = bitmap_scan (dirty_map, 0, 1, true); i != BITMAP_ERROR;
+			i = bitmap_scan (dirty_map, i + 1, 1, true)) {
+		bitmap_reset (dirty_map, i);
+		disk_write (filesys_disk, csum_start + i, tables[i]);
+	}
+	lock_release (&csum_lock);
+}
+
+/* checksum 통계를 찍는다. checksum을 쓰지 않는 디스크면 찍지 않는다. */
+void
+csum_print_stats (void) {
+	if (csum_start != 0)
+		printf ("Checksum: %ld mismatches\n", mismatch_cnt);
+}
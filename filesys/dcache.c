@@ -0,0 +1,198 @@
+/* dcache.c: Cache of directory name lookups. */
+
+#include "filesys/dcache.h"
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/rcu.h"
+#include "threads/synch.h"
+
+/*** GrilledSalmon ***/
+/* (부모 디렉터리 sector, 이름)에서 자식 inode sector로 가는 항목. NEGATIVE면
+ * 그 이름이 없다는 것을 기억한다. 디렉터리 inode가 닫혀서 dir_index가
+ * 사라져도 남아 있으므로, 같은 경로를 다시 열 때 디렉터리를 읽지 않는다.
+ *
+ * 찾기는 lock 없이 RCU 읽기 구간 안에서 한다. 항목은 한 번 table에 걸면
+ * 고치지 않는다. 바꿀 때는 새 항목으로 갈아 끼우고, 옛 항목은 DEAD로 표시한
+ * 뒤 call_rcu로 푼다. 고치는 쪽은 dcache_lock을 잡는다. LRU 순서는 reader가
+ * 고칠 수 없으므로 reader는 REFERENCED만 세우고, 버릴 항목을 고를 때
+ * REFERENCED인 항목은 한 번 앞으로 돌려 보낸다 (second chance). */
+struct dcache_entry {
+	struct dcache_entry *next;          /* 같은 bucket의 다음 항목. */
+	struct list_elem lru_elem;          /* 앞쪽이 최근에 넣은 것. */
+	struct rcu_head rcu;
+	disk_sector_t parent;
+	char name[NAME_MAX + 1];
+	disk_sector_t child;
+	bool negative;
+	bool referenced;                    /* 마지막으로 돌려 보낸 뒤 찾은 적이 있다. */
+	bool dead;                          /* table에서 빠졌다. */
+};
+
+#define DCACHE_BUCKETS 128
+
+static struct dcache_entry *buckets[DCACHE_BUCKETS];
+static struct list dcache_lru;
+static size_t dcache_cnt;
+static struct lock dcache_lock;
+
+static struct dcache_entry **
+dcache_bucket (disk_sector_t parent, const char *name) {
+	return &buckets[(hash_string (name) ^ hash_u64 (parent)) % DCACHE_BUCKETS];
+}
+
+/* Initializes the name cache. */
+void
+dcache_init (void) {
+	list_init (&dcache_lru);
+	dcache_cnt = 0;
+	lock_init (&dcache_lock);
+}
+
+/* (PARENT, NAME)의 항목을 찾는다. 없으면 NULL. RCU 읽기 구간 안이나
+ * dcache_lock을 잡고 불러야 한다. NAME은 NAME_MAX 이하여야 한다. */
+static struct dcache_entry *
+dcache_find (disk_sector_t parent, const char *name) {
+	struct dcache_entry *de;
+
+	for (de = rcu_dereference (*dcache_bucket (parent, name)); de != NULL;
+			de = rcu_dereference (de->next))
+		if (de->parent == parent && !strcmp (de->name, name))
+			return de;
+	return NULL;
+}
+
+static void
+dcache_free (struct rcu_head *head) {
+	free (rcu_entry (head, struct dcache_entry, rcu));
+}
+
+/* DE를 table에서 빼고 reader가 모두 지나간 뒤 푼다. dcache_lock을 잡고
+ * 불러야 한다. */
+static void
+dcache_delete (struct dcache_entry *de) {
+	struct dcache_entry **p = dcache_bucket (de->parent, de->name);
+
+	while (*p != de)
+		p = &(*p)->next;
+	rcu_assign_pointer (*p, de->next);
+	__atomic_store_n (&de->dead, true, __ATOMIC_RELEASE);
+	list_remove (&de->lru_elem);
+	dcache_cnt--;
+	call_rcu (&de->rcu, dcache_free);
+}
+
+/* 가장 오래전에 넣었고 그 뒤로 찾지 않은 항목을 버린다. dcache_lock을 잡고
+ * 불러야 한다. */
+static void
+dcache_evict (void) {
+	for (;;) {
+		struct dcache_entry *de = list_entry (list_back (&dcache_lru),
+				struct dcache_entry, lru_elem);
+
+		if (!__atomic_exchange_n (&de->referenced, false, __ATOMIC_RELAXED)) {
+			dcache_delete (de);
+			return;
+		}
+		list_remove (&de->lru_elem);
+		list_push_front (&dcache_lru, &de->lru_elem);
+	}
+}
+
+/* PARENT 디렉터리의 NAME을 cache에서 찾는다. 있으면 자식 inode를 열어 *INODE에
+ * 넣는다. lock 없이 찾으므로 연 뒤에 항목이 아직 살아 있는지 다시 본다.
+ * dir_remove는 항목을 바꾼 다음에야 inode를 지우므로, 그때 살아 있었다면 연
+ * inode는 그 이름의 것이다. 그 사이에 바뀌었으면 모르는 것으로 친다. */
+enum dcache_result
+dcache_open (disk_sector_t parent, const char *name, struct inode **inode) {
+	struct dcache_entry *de;
+	enum dcache_result result = DCACHE_MISS;
+
+	*inode = NULL;
+	if (strlen (name) > NAME_MAX)
+		return DCACHE_MISS;
+	rcu_read_lock ();
+	de = dcache_find (parent, name);
+	if (de != NULL) {
+		__atomic_store_n (&de->referenced, true, __ATOMIC_RELAXED);
+		if (de->negative)
+			result = DCACHE_NEGATIVE;
+		else if ((*inode = inode_open (de->child)) != NULL) {
+			if (!__atomic_load_n (&de->dead, __ATOMIC_ACQUIRE))
+				result = DCACHE_HIT;
+			else {
+				inode_close (*inode);
+				*inode = NULL;
+			}
+		}
+	}
+	rcu_read_unlock ();
+	return result;
+}
+
+/* (PARENT, NAME)을 CHILD로 기억한다. NEGATIVE면 없다고 기억한다. 가득 차면
+ * 항목 하나를 버리고, 메모리가 없으면 옛 항목만 버린다. */
+static void
+dcache_set (disk_sector_t parent, const char *name, disk_sector_t child,
+		bool negative) {
+	struct dcache_entry *de, *old, **bucket;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	de = malloc (sizeof *de);
+	lock_acquire (&dcache_lock);
+	old = dcache_find (parent, name);
+	if (old != NULL)
+		dcache_delete (old);
+	if (de == NULL) {
+		lock_release (&dcache_lock);
+		return;
+	}
+	if (dcache_cnt >= DCACHE_MAX)
+		dcache_evict ();
+	de->parent = parent;
+	strlcpy (de->name, name, sizeof de->name);
+	de->child = child;
+	de->negative = negative;
+	de->referenced = false;
+	de->dead = false;
+	bucket = dcache_bucket (parent, name);
+	de->next = *bucket;
+	rcu_assign_pointer (*bucket, de);
+	list_push_front (&dcache_lru, &de->lru_elem);
+	dcache_cnt++;
+	lock_release (&dcache_lock);
+}
+
+/* PARENT 디렉터리의 NAME이 CHILD sector의 inode임을 기억한다. */
+void
+dcache_insert (disk_sector_t parent, const char *name, disk_sector_t child) {
+	dcache_set (parent, name, child, false);
+}
+
+/* PARENT 디렉터리에 NAME이 없음을 기억한다. */
+void
+dcache_insert_negative (disk_sector_t parent, const char *name) {
+	dcache_set (parent, name, 0, true);
+}
+
+/* PARENT 디렉터리의 항목을 모두 버린다. PARENT sector에 새 디렉터리를 만들 때
+ * 옛 디렉터리의 항목이 남아 있지 않게 부른다. */
+void
+dcache_purge (disk_sector_t parent) {
+	struct list_elem *e;
+
+	lock_acquire (&dcache_lock);
+	for (e = list_begin (&dcache_lru); e != list_end (&dcache_lru);) {
+		struct dcache_entry *de = list_entry (e, struct dcache_entry, lru_elem);
+
+		e = list_next (e);
+		if (de->parent == parent)
+			dcache_delete (de);
+	}
+	lock_release (&dcache_lock);
+}
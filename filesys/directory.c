@@ -2,10 +2,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <hash.h>
+#include <syscall-nr.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "filesys/fat.h"
+#include "filesys/dcache.h"
 
 /* A directory. */
 struct dir {
@@ -20,10 +27,45 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/*** GrilledSalmon ***/
+/* 디렉터리 inode 하나의 이름 색인. 처음 lookup할 때 항목을 한 번 다 읽어
+ * 만들고, 그 뒤로는 dir_add와 dir_remove가 고쳐 간다. lock은 색인과 함께
+ * 디렉터리 파일의 항목도 보호해서 lookup과 쓰기가 한 번에 일어나게 한다. */
+struct dir_index {
+	struct lock lock;
+	struct hash names;                  /* struct dir_index_entry들. */
+	off_t free_hint;                    /* 이보다 앞의 칸은 모두 쓰고 있다. */
+};
+
+struct dir_index_entry {
+	struct hash_elem elem;
+	char name[NAME_MAX + 1];
+	disk_sector_t inode_sector;
+	off_t ofs;                          /* 디렉터리 파일 안 항목의 위치. */
+};
+
+/* dir_index를 처음 만들 때 두 스레드가 같이 만들지 않게 한다. */
+static struct lock dir_index_create_lock;
+
+/* struct dir 전용 object cache */
+static struct kmem_cache *dir_cache;
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	lock_init (&dir_index_create_lock);
+	dir_cache = kmem_cache_create ("dir", sizeof (struct dir), 0, NULL);
+	if (dir_cache == NULL)
+		PANIC ("dir cache creation failed");
+	dcache_init ();
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
 dir_create (disk_sector_t sector, size_t entry_cnt) {
+	/* 이 sector에 있던 옛 디렉터리의 이름이 cache에 남아 있으면 안 된다. */
+	dcache_purge (sector);
 	return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
 }
 
@@ -31,27 +73,34 @@ dir_create (disk_sector_t sector, size_t entry_cnt) {
  * it takes ownership.  Returns a null pointer on failure. */
 struct dir *
 dir_open (struct inode *inode) {
-	struct dir *dir = calloc (1, sizeof *dir);
+	struct dir *dir = kmem_cache_alloc (dir_cache);
 	if (inode != NULL && dir != NULL) {
 		dir->inode = inode;
 		dir->pos = 0;
+		inode_set_journaled (inode);
 		return dir;
 	} else {
 		inode_close (inode);
-		free (dir);
+		kmem_cache_free (dir_cache, dir);
 		return NULL;
 	}
 }
 
+/* Returns the sector of the root directory's inode. */
+disk_sector_t
+dir_root_sector (void) {
+#ifdef EFILESYS
+	return cluster_to_sector(ROOT_DIR_CLUSTER);
+#else
+	return ROOT_DIR_SECTOR;
+#endif
+}
+
 /* Opens the root directory and returns a directory for it.
  * Return true if successful, false on failure. */
 struct dir *
 dir_open_root (void) {
-#ifdef EFILESYS
-	return dir_open (inode_open (cluster_to_sector(ROOT_DIR_CLUSTER)));
-#else
-	return dir_open (inode_open (ROOT_DIR_SECTOR));
-#endif
+	return dir_open (inode_open (dir_root_sector ()));
 }
 
 /* Opens and returns a new directory for the same inode as DIR.
@@ -66,7 +115,7 @@ void
 dir_close (struct dir *dir) {
 	if (dir != NULL) {
 		inode_close (dir->inode);
-		free (dir);
+		kmem_cache_free (dir_cache, dir);
 	}
 }
 
@@ -76,13 +125,113 @@ dir_get_inode (struct dir *dir) {
 	return dir->inode;
 }
 
+/*** GrilledSalmon ***/
+static uint64_t
+dir_index_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_string (hash_entry (e, struct dir_index_entry, elem)->name);
+}
+
+static bool
+dir_index_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return strcmp (hash_entry (a, struct dir_index_entry, elem)->name,
+			hash_entry (b, struct dir_index_entry, elem)->name) < 0;
+}
+
+static void
+dir_index_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct dir_index_entry, elem));
+}
+
+/* 이름 색인 IDX에 IE를 NAME의 항목으로 넣는다. */
+static void
+dir_index_fill (struct dir_index *idx, struct dir_index_entry *ie,
+		const char *name, disk_sector_t inode_sector, off_t ofs) {
+	strlcpy (ie->name, name, sizeof ie->name);
+	ie->inode_sector = inode_sector;
+	ie->ofs = ofs;
+	hash_insert (&idx->names, &ie->elem);
+}
+
+/* 이름 색인 IDX에 항목 하나를 넣는다. 메모리가 없으면 false. */
+static bool
+dir_index_insert (struct dir_index *idx, const char *name,
+		disk_sector_t inode_sector, off_t ofs) {
+	struct dir_index_entry *ie = malloc (sizeof *ie);
+
+	if (ie == NULL)
+		return false;
+	dir_index_fill (idx, ie, name, inode_sector, ofs);
+	return true;
+}
+
+/* IDX에서 NAME의 항목을 찾는다. 없으면 NULL. */
+static struct dir_index_entry *
+dir_index_find (struct dir_index *idx, const char *name) {
+	struct dir_index_entry key;
+	struct hash_elem *e;
+
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&idx->names, &key.elem);
+	return e != NULL ? hash_entry (e, struct dir_index_entry, elem) : NULL;
+}
+
+/* Frees a directory name index.  IDX may be null. */
+void
+dir_index_destroy (struct dir_index *idx) {
+	if (idx != NULL) {
+		hash_destroy (&idx->names, dir_index_free);
+		free (idx);
+	}
+}
+
+/* DIR의 이름 색인을 리턴한다. 없으면 디렉터리 항목을 한 번 다 읽어서 만든다.
+ * 메모리가 모자라면 NULL을 리턴하고, 그때는 예전처럼 항목을 차례로 읽는다. */
+static struct dir_index *
+dir_index_get (const struct dir *dir) {
+	struct dir_index **slot = inode_dir_index (dir->inode);
+	struct dir_index *idx;
+	struct dir_entry e;
+	off_t ofs;
+
+	lock_acquire (&dir_index_create_lock);
+	idx = *slot;
+	if (idx == NULL && (idx = malloc (sizeof *idx)) != NULL) {
+		lock_init (&idx->lock);
+		idx->free_hint = -1;
+		if (!hash_init (&idx->names, dir_index_hash, dir_index_less, NULL)) {
+			free (idx);
+			idx = NULL;
+		}
+		for (ofs = 0; idx != NULL
+				&& inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+				ofs += sizeof e) {
+			if (!e.in_use) {
+				if (idx->free_hint < 0)
+					idx->free_hint = ofs;
+			} else if (!dir_index_insert (idx, e.name, e.inode_sector, ofs)) {
+				dir_index_destroy (idx);
+				idx = NULL;
+			}
+		}
+		if (idx != NULL) {
+			if (idx->free_hint < 0)
+				idx->free_hint = ofs;
+			*slot = idx;
+		}
+	}
+	lock_release (&dir_index_create_lock);
+	return idx;
+}
+
 /* Searches DIR for a file with the given NAME.
  * If successful, returns true, sets *EP to the directory entry
  * if EP is non-null, and sets *OFSP to the byte offset of the
  * directory entry if OFSP is non-null.
  * otherwise, returns false and ignores EP and OFSP. */
+/* IDX가 있으면 색인에서 찾는다. 부르는 쪽이 IDX->lock을 잡고 있어야 한다. */
 static bool
-lookup (const struct dir *dir, const char *name,
+lookup (const struct dir *dir, struct dir_index *idx, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
 	struct dir_entry e;
 	size_t ofs;
@@ -90,6 +239,21 @@ lookup (const struct dir *dir, const char *name,
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	if (idx != NULL) {
+		struct dir_index_entry *ie = dir_index_find (idx, name);
+
+		if (ie == NULL)
+			return false;
+		if (ep != NULL) {
+			ep->inode_sector = ie->inode_sector;
+			strlcpy (ep->name, ie->name, sizeof ep->name);
+			ep->in_use = true;
+		}
+		if (ofsp != NULL)
+			*ofsp = ie->ofs;
+		return true;
+	}
+
 	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
 		if (e.in_use && !strcmp (name, e.name)) {
@@ -110,14 +274,39 @@ bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
 	struct dir_entry e;
+	struct dir_index *idx;
+	disk_sector_t parent;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
+	/* 이름 cache가 답을 알면 디렉터리를 읽지 않는다. */
+	parent = inode_get_inumber (dir->inode);
+	switch (dcache_open (parent, name, inode)) {
+		case DCACHE_HIT:
+			return true;
+		case DCACHE_NEGATIVE:
+			return false;
+		case DCACHE_MISS:
+			break;
+	}
+
+	idx = dir_index_get (dir);
+	if (idx != NULL)
+		lock_acquire (&idx->lock);
+	if (lookup (dir, idx, name, &e, NULL))
 		*inode = inode_open (e.inode_sector);
 	else
 		*inode = NULL;
+	/* 색인의 lock을 잡고 있을 때만 기억한다. 그래야 dir_add나 dir_remove가 고친
+	 * 항목을 옛 결과로 덮어쓰지 않는다. */
+	if (idx != NULL) {
+		if (*inode != NULL)
+			dcache_insert (parent, name, e.inode_sector);
+		else
+			dcache_insert_negative (parent, name);
+		lock_release (&idx->lock);
+	}
 
 	return *inode != NULL;
 }
@@ -131,6 +320,8 @@ dir_lookup (const struct dir *dir, const char *name,
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	struct dir_entry e;
+	struct dir_index *idx;
+	struct dir_index_entry *ie = NULL;
 	off_t ofs;
 	bool success = false;
 
@@ -141,8 +332,16 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
+	idx = dir_index_get (dir);
+	if (idx != NULL)
+		lock_acquire (&idx->lock);
+
 	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
+	if (lookup (dir, idx, name, NULL, NULL))
+		goto done;
+
+	/* 쓴 뒤에 색인에 못 넣는 일이 없게 미리 잡아 둔다. */
+	if (idx != NULL && (ie = malloc (sizeof *ie)) == NULL)
 		goto done;
 
 	/* Set OFS to offset of free slot.
@@ -152,7 +351,9 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	 * inode_read_at() will only return a short read at end of file.
 	 * Otherwise, we'd need to verify that we didn't get a short
 	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	/* 색인이 있으면 free_hint 앞의 칸은 모두 쓰고 있으니 거기서부터 찾는다. */
+	for (ofs = idx != NULL ? idx->free_hint : 0;
+			inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
 		if (!e.in_use)
 			break;
@@ -162,8 +363,18 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	if (success && idx != NULL) {
+		idx->free_hint = ofs + sizeof e;
+		dir_index_fill (idx, ie, name, inode_sector, ofs);
+		ie = NULL;
+	}
+	if (success)
+		dcache_insert (inode_get_inumber (dir->inode), name, inode_sector);
 	
 done:
+	if (idx != NULL)
+		lock_release (&idx->lock);
+	free (ie);
 	return success;
 }
 
@@ -173,6 +384,7 @@ done:
 bool
 dir_remove (struct dir *dir, const char *name) {
 	struct dir_entry e;
+	struct dir_index *idx;
 	struct inode *inode = NULL;
 	bool success = false;
 	off_t ofs;
@@ -180,8 +392,12 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	idx = dir_index_get (dir);
+	if (idx != NULL)
+		lock_acquire (&idx->lock);
+
 	/* Find directory entry. */
-	if (!lookup (dir, name, &e, &ofs))
+	if (!lookup (dir, idx, name, &e, &ofs))
 		goto done;
 
 	/* Open inode. */
@@ -193,12 +409,23 @@ dir_remove (struct dir *dir, const char *name) {
 	e.in_use = false;
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
+	if (idx != NULL) {
+		struct dir_index_entry *ie = dir_index_find (idx, name);
+
+		hash_delete (&idx->names, &ie->elem);
+		free (ie);
+		if (ofs < idx->free_hint)
+			idx->free_hint = ofs;
+	}
+	dcache_insert_negative (inode_get_inumber (dir->inode), name);
 
 	/* Remove inode. */
 	inode_remove (inode);
 	success = true;
 
 done:
+	if (idx != NULL)
+		lock_release (&idx->lock);
 	inode_close (inode);
 	return success;
 }
@@ -219,3 +446,43 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	}
 	return false;
 }
+
+/*** GrilledSalmon ***/
+/* 디렉터리 INODE의 *POS부터 쓰고 있는 항목을 최대 CNT개 ENTS에 담고 *POS를
+ * 마지막으로 본 항목 뒤로 옮긴다. dir_readdir처럼 항목마다 inode_read_at을
+ * 부르지 않고 한 page 분량의 항목을 한 번에 읽는다. 담은 수를 리턴하며 끝이면
+ * 0. */
+size_t
+dir_read_entries (struct inode *inode, off_t *pos, struct dirent *ents,
+		size_t cnt) {
+	const size_t per_chunk = PGSIZE / sizeof (struct dir_entry);
+	disk_sector_t root = dir_root_sector ();
+	struct dir_entry *chunk;
+	size_t n = 0;
+
+	chunk = palloc_get_page (0);
+	if (chunk == NULL)
+		return 0;
+	while (n < cnt) {
+		off_t bytes = inode_read_at (inode, chunk,
+				per_chunk * sizeof *chunk, *pos);
+		size_t got = bytes / sizeof *chunk;
+		size_t i;
+
+		for (i = 0; i < got && n < cnt; i++) {
+			struct dir_entry *e = &chunk[i];
+
+			if (!e->in_use)
+				continue;
+			ents[n].inumber = e->inode_sector;
+			ents[n].is_dir = e->inode_sector == root;
+			strlcpy (ents[n].name, e->name, sizeof ents[n].name);
+			n++;
+		}
+		*pos += i * sizeof *chunk;
+		if (got < per_chunk)
+			break;
+	}
+	palloc_free_page (chunk);
+	return n;
+}
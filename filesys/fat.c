@@ -3,9 +3,16 @@
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
 #include "filesys/directory.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/journal.h"
+#include "filesys/fsstat.h"
+#include "filesys/csum.h"
 
 /* Should be less than DISK_SECTOR_SIZE */
 struct fat_boot {
@@ -15,22 +22,62 @@ struct fat_boot {
 	unsigned int fat_start;
 	unsigned int fat_sectors; /* Size of FAT in sectors. */
 	unsigned int root_dir_cluster;
+	unsigned int log_start;   /* First sector of the metadata journal. */
+	unsigned int log_sectors; /* 0이면 journal 없이 포맷한 디스크. */
+	unsigned int inode_format; /* FAT_INODE_EXTENTS면 extent로 찾는다. */
+	unsigned int csum_start;   /* sector checksum 영역. journal 바로 뒤다. */
+	unsigned int csum_sectors; /* 0이면 checksum 없이 포맷한 디스크. */
 };
 
+/* struct fat_boot의 inode_format. */
+#define FAT_INODE_CHAIN 0
+#define FAT_INODE_EXTENTS 1
+
 /* FAT FS */
 struct fat_fs {
 	struct fat_boot bs;
-	unsigned int *fat;
+	/*** GrilledSalmon ***/
+	/* FAT sector i의 사본. NULL이면 아직 읽지 않았다. 마운트할 때 FAT 전체를
+	 * 읽지 않고, 항목을 처음 볼 때 그 sector만 buffer cache로 읽는다. */
+	cluster_t **sectors;
+	bool fresh;                 /* 방금 포맷해서 읽지 않은 sector도 0이다. */
 	unsigned int fat_length;
 	disk_sector_t data_start;
 	cluster_t last_clst;
 	struct lock write_lock;
+	/*** GrilledSalmon ***/
+	/* FAT에서 값이 0이 아닌 (쓰고 있는) cluster의 bit가 켜져 있다. fat_put이
+	 * fat과 맞춰 두고, 빈 cluster는 bitmap_scan_and_flip_next로 next fit 한다.
+	 * scanned_map에 없는 FAT sector의 cluster는 모두 쓰는 중으로 본다. */
+	struct bitmap *used_map;
+	size_t free_cnt;            /* scan 한 sector 안의 빈 cluster 수. */
+	/* used_map에 반영한 FAT sector. */
+	struct bitmap *scanned_map;
+	/* fat_put 등으로 바뀌었지만 아직 buffer cache에 쓰지 않은 FAT sector. */
+	struct bitmap *dirty_map;
 };
 
 static struct fat_fs *fat_fs;
 
+/*** GrilledSalmon ***/
+/* FAT 항목의 맨 위 bit. 켜져 있으면 그 cluster에 아직 아무것도 쓴 적이 없어서
+ * 디스크 내용과 상관없이 0으로 읽힌다. EOChain이 28 bit이므로 chain 값과
+ * 겹치지 않고, fat_get은 이 bit를 떼고 돌려준다. */
+#define FAT_UNWRITTEN 0x80000000
+
+/* FAT sector 하나에 든 항목 수. */
+#define FAT_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
+unsigned int fat_format_cluster_sectors = SECTORS_PER_CLUSTER;
+bool fat_format_extents = false;
+
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_map_init (bool fresh);
+static cluster_t *fat_load (size_t idx);
+static bool fat_scan_more (void);
+static void fat_zero_disk (void);
+static void fat_mark_dirty (cluster_t clst);
 
 void
 fat_init (void) {
@@ -39,12 +86,7 @@ fat_init (void) {
 		PANIC ("FAT init failed");
 
 	// Read boot sector from the disk
-	unsigned int *bounce = malloc (DISK_SECTOR_SIZE);
-	if (bounce == NULL)
-		PANIC ("FAT init failed");
-	disk_read (filesys_disk, FAT_BOOT_SECTOR, bounce);
-	memcpy (&fat_fs->bs, bounce, sizeof (fat_fs->bs));
-	free (bounce);
+	bc_read (FAT_BOOT_SECTOR, &fat_fs->bs, 0, sizeof (fat_fs->bs));
 
 	// Extract FAT info
 	if (fat_fs->bs.magic != FAT_MAGIC)
@@ -54,31 +96,18 @@ fat_init (void) {
 
 void
 fat_open (void) {
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
-	if (fat_fs->fat == NULL)
-		PANIC ("FAT load failed");
-
-	// Load FAT directly from the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i,
-			           buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
-		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
-			free (bounce);
-		}
-	}
+	/* 방금 포맷했으면 메모리의 FAT이 최신이고, 디스크의 FAT은 아직 journal에
+	 * 붙잡혀 있다. */
+	if (fat_fs->sectors != NULL)
+		return;
+
+	/* 죽기 전에 commit 된 metadata를 FAT을 읽기 전에 제자리에 써 둔다. */
+	journal_recover ();
+
+	/*** GrilledSalmon ***/
+	/* FAT은 여기서 읽지 않는다. fat_load가 필요한 sector만 읽으므로 디스크가
+	 * 커져도 마운트 시간과 메모리는 쓰는 만큼만 는다. */
+	fat_map_init (false);
 }
 
 void
@@ -88,30 +117,32 @@ fat_close (void) {
 	if (bounce == NULL)
 		PANIC ("FAT close failed");
 	memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
-	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
+	bc_write (FAT_BOOT_SECTOR, bounce, 0, DISK_SECTOR_SIZE);
 	free (bounce);
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
+	// Write the changed part of FAT
+	fat_flush ();
+}
+
+/*** GrilledSalmon ***/
+/* 바뀐 FAT sector만 journal에 쓴다. 디스크에는 journal이 commit 할 때 쓴다. */
+void
+fat_flush (void) {
 	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
+	size_t i;
+
+	lock_acquire (&fat_fs->write_lock);
+	for (i = bitmap_scan (fat_fs->dirty_map, 0, 1, true); i != BITMAP_ERROR;
+			i = bitmap_scan (fat_fs->dirty_map, i + 1, 1, true)) {
+		off_t bytes_left = fat_size_in_bytes - (off_t) i * DISK_SECTOR_SIZE;
+
+		if (bytes_left > DISK_SECTOR_SIZE)
+			bytes_left = DISK_SECTOR_SIZE;
+		bitmap_reset (fat_fs->dirty_map, i);
+		journal_write (fat_fs->bs.fat_start + i, fat_fs->sectors[i], 0,
+				bytes_left);
 	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /*** GrilledSalmon ***/
@@ -120,11 +151,12 @@ fat_create (void) {
 	// Create FAT boot
 	fat_boot_create ();
 	fat_fs_init ();
+	journal_format ();
+	csum_format ();
 
 	// Create FAT table
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
-	if (fat_fs->fat == NULL)
-		PANIC ("FAT creation failed");
+	fat_map_init (true);
+	fat_zero_disk ();
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -141,16 +173,31 @@ fat_create (void) {
 
 void
 fat_boot_create (void) {
+	/*** GrilledSalmon ***/
+	/* cluster 크기는 2의 거듭제곱만 받는다. cluster가 클수록 FAT과 chain이 짧아진다. */
+	unsigned int spc = fat_format_cluster_sectors;
+	if (spc == 0 || spc > SECTORS_PER_CLUSTER_MAX || (spc & (spc - 1)) != 0)
+		spc = SECTORS_PER_CLUSTER;
+
+	/*** GrilledSalmon ***/
+	/* checksum 영역은 디스크의 모든 sector를 덮는다. */
+	unsigned int csum_sectors = csum_format_enabled
+	    ? DIV_ROUND_UP (disk_size (filesys_disk), CSUM_PER_SECTOR) : 0;
 	unsigned int fat_sectors =
-	    (disk_size (filesys_disk) - 1)
-	    / (DISK_SECTOR_SIZE / sizeof (cluster_t) * SECTORS_PER_CLUSTER + 1) + 1;
+	    (disk_size (filesys_disk) - 1 - JOURNAL_SECTORS - csum_sectors)
+	    / (DISK_SECTOR_SIZE / sizeof (cluster_t) * spc + 1) + 1;
 	fat_fs->bs = (struct fat_boot){
 	    .magic = FAT_MAGIC,
-	    .sectors_per_cluster = SECTORS_PER_CLUSTER,
+	    .sectors_per_cluster = spc,
 	    .total_sectors = disk_size (filesys_disk),
 	    .fat_start = 1,
 	    .fat_sectors = fat_sectors,
 	    .root_dir_cluster = ROOT_DIR_CLUSTER,
+	    .log_start = 1 + fat_sectors,
+	    .log_sectors = JOURNAL_SECTORS,
+	    .inode_format = fat_format_extents ? FAT_INODE_EXTENTS : FAT_INODE_CHAIN,
+	    .csum_start = csum_sectors ? 1 + fat_sectors + JOURNAL_SECTORS : 0,
+	    .csum_sectors = csum_sectors,
 	};
 }
 
@@ -159,8 +206,142 @@ void
 fat_fs_init (void) {
 	/* TODO: Your code goes here. */
     lock_init(&fat_fs->write_lock);
-	fat_fs->fat_length = fat_fs->bs.total_sectors - (fat_fs->bs.fat_sectors + 1);
-	fat_fs->data_start = 1 + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors
+			- (fat_fs->bs.fat_sectors + 1 + fat_fs->bs.log_sectors
+				+ fat_fs->bs.csum_sectors))
+		/ fat_fs->bs.sectors_per_cluster;
+	/* journal과 checksum 영역은 FAT과 data 사이에 있다. */
+	fat_fs->data_start = 1 + fat_fs->bs.fat_sectors + fat_fs->bs.log_sectors
+		+ fat_fs->bs.csum_sectors;
+	journal_init (fat_fs->bs.log_start, fat_fs->bs.log_sectors);
+	csum_init (fat_fs->bs.csum_start, fat_fs->bs.csum_sectors);
+}
+
+/*** GrilledSalmon ***/
+/* sector 사본 표와 used_map을 만든다. FRESH면 방금 포맷한 FAT이라 모든
+ * cluster가 비어 있고, 아니면 FAT sector를 읽는 대로 used_map에 반영한다.
+ * cluster 0은 "cluster 없음"을 뜻하므로 내주지 않는다. */
+static void
+fat_map_init (bool fresh) {
+	/* 포맷한 뒤 다시 열면 전에 만든 것을 버린다. */
+	if (fat_fs->sectors != NULL) {
+		for (size_t i = 0; i < fat_fs->bs.fat_sectors; i++)
+			free (fat_fs->sectors[i]);
+		kvfree (fat_fs->sectors);
+	}
+	if (fat_fs->used_map != NULL)
+		bitmap_destroy (fat_fs->used_map);
+	if (fat_fs->scanned_map != NULL)
+		bitmap_destroy (fat_fs->scanned_map);
+	if (fat_fs->dirty_map != NULL)
+		bitmap_destroy (fat_fs->dirty_map);
+	fat_fs->sectors = kvcalloc (fat_fs->bs.fat_sectors, sizeof *fat_fs->sectors);
+	fat_fs->used_map = bitmap_create (fat_fs->fat_length);
+	fat_fs->scanned_map = bitmap_create (fat_fs->bs.fat_sectors);
+	fat_fs->dirty_map = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->sectors == NULL || fat_fs->used_map == NULL
+			|| fat_fs->scanned_map == NULL || fat_fs->dirty_map == NULL)
+		PANIC ("FAT bitmap creation failed");
+	fat_fs->fresh = fresh;
+	bitmap_set_all (fat_fs->used_map, !fresh);
+	bitmap_set_all (fat_fs->scanned_map, fresh);
+	bitmap_mark (fat_fs->used_map, 0);
+	fat_fs->free_cnt = fresh ? fat_fs->fat_length - 1 : 0;
+}
+
+/* 디스크에 남은 옛 FAT을 0으로 덮어쓴다. 포맷할 때만 부르므로 journal을
+ * 거치지 않고 DISK_MAX_SECTORS씩 한 번의 disk 명령으로 쓴다. */
+static void
+fat_zero_disk (void) {
+	size_t max = fat_fs->bs.fat_sectors < DISK_MAX_SECTORS
+		? fat_fs->bs.fat_sectors : DISK_MAX_SECTORS;
+	void *zeros = calloc (max, DISK_SECTOR_SIZE);
+	size_t i;
+
+	if (zeros == NULL)
+		PANIC ("FAT creation failed");
+	for (i = 0; i < fat_fs->bs.fat_sectors; ) {
+		size_t cnt = fat_fs->bs.fat_sectors - i;
+
+		if (cnt > max)
+			cnt = max;
+		disk_write_multiple (filesys_disk, fat_fs->bs.fat_start + i, zeros, cnt);
+		i += cnt;
+	}
+	free (zeros);
+}
+
+/* FAT sector IDX의 사본을 돌려준다. 처음이면 buffer cache로 읽고, 아직
+ * used_map에 반영하지 않았으면 빈 cluster를 used_map과 free_cnt에 넣는다.
+ * fat_put 등은 write_lock을 잡고 부르고, fat_get은 잡지 않고 부른다. */
+static cluster_t *
+fat_load (size_t idx) {
+	bool held = lock_held_by_current_thread (&fat_fs->write_lock);
+	cluster_t *s;
+
+	ASSERT (idx < fat_fs->bs.fat_sectors);
+
+	if (!held)
+		lock_acquire (&fat_fs->write_lock);
+	s = fat_fs->sectors[idx];
+	if (s == NULL) {
+		s = malloc (DISK_SECTOR_SIZE);
+		if (s == NULL)
+			PANIC ("FAT load failed");
+		if (fat_fs->fresh)
+			memset (s, 0, DISK_SECTOR_SIZE);
+		else
+			bc_read (fat_fs->bs.fat_start + idx, s, 0, DISK_SECTOR_SIZE);
+
+		if (!bitmap_test (fat_fs->scanned_map, idx)) {
+			cluster_t first = idx * FAT_PER_SECTOR;
+
+			for (size_t i = 0; i < FAT_PER_SECTOR; i++) {
+				cluster_t clst = first + i;
+
+				if (clst >= fat_fs->fat_length)
+					break;
+				if (clst != 0 && s[i] == 0) {
+					bitmap_reset (fat_fs->used_map, clst);
+					fat_fs->free_cnt++;
+				}
+			}
+			bitmap_mark (fat_fs->scanned_map, idx);
+		}
+		fat_fs->sectors[idx] = s;
+	}
+	if (!held)
+		lock_release (&fat_fs->write_lock);
+	return s;
+}
+
+/* CLST의 FAT 항목. */
+static inline cluster_t *
+fat_entry (cluster_t clst) {
+	size_t idx = clst / FAT_PER_SECTOR;
+	cluster_t *s = fat_fs->sectors[idx];
+
+	ASSERT (clst < fat_fs->fat_length);
+
+	if (s == NULL)
+		s = fat_load (idx);
+	return &s[clst % FAT_PER_SECTOR];
+}
+
+/* 아직 used_map에 반영하지 않은 FAT sector를 하나 읽는다. 남은 것이 없으면
+ * false. write_lock을 잡고 불러야 한다. */
+static bool
+fat_scan_more (void) {
+	size_t idx = bitmap_scan (fat_fs->scanned_map, 0, 1, false);
+
+	ASSERT (lock_held_by_current_thread (&fat_fs->write_lock));
+
+	if (idx == BITMAP_ERROR)
+		return false;
+	/* 사본은 있지만 반영하지 않은 sector는 없다. */
+	ASSERT (fat_fs->sectors[idx] == NULL);
+	fat_load (idx);
+	return true;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -174,29 +355,46 @@ fat_fs_init (void) {
 cluster_t
 fat_create_chain (cluster_t clst) {
 	/* TODO: Your code goes here. */
-	cluster_t empty_clst = NULL;
+	return fat_create_run (clst, 1);
+}
+
+/*** GrilledSalmon ***/
+/* 디스크에서 연속된 빈 cluster CNT개를 찾아 CLST 뒤에 한 번에 잇는다.
+ * CLST가 0이면 새 chain을 만든다. 붙인 cluster 중 첫 번째를 리턴하고,
+ * 연속된 빈 cluster가 CNT개 없으면 아무것도 바꾸지 않고 0을 리턴한다. */
+cluster_t
+fat_create_run (cluster_t clst, size_t cnt) {
+	size_t first;
+	cluster_t next_clst;
+	uint64_t start = fsstat_begin ();
+
+	ASSERT (cnt > 0);
+
     lock_acquire(&fat_fs->write_lock);
-	/* Find Empty Cluster */
-	for (int i=2; i<fat_fs->fat_length; i++) {
-		if (fat_get(i) == NULL) {
-			empty_clst = i;
-			break;
+	/* Find Empty Clusters.  빈 cluster가 모자라면 찾아보지 않는다.  지금까지
+	 * 읽은 FAT sector에서 못 찾으면 읽지 않은 sector를 하나씩 더 본다. */
+	while (fat_fs->free_cnt < cnt
+			|| (first = bitmap_scan_and_flip_next (fat_fs->used_map, cnt, false))
+				== BITMAP_ERROR) {
+		if (!fat_scan_more ()) {
+			lock_release(&fat_fs->write_lock);
+			fsstat_end (FSSTAT_ALLOC, start);
+			return 0;
 		}
 	}
-	if (empty_clst == NULL) {	/* There are no empty clusters. */
-		lock_release(&fat_fs->write_lock);
-      return NULL;
-	}
+	fat_fs->free_cnt -= cnt;
 
-	if (clst == 0) {	/* Create a New Chain */
-		fat_put(empty_clst, EOChain);
-	} else {
-		cluster_t next_clst = fat_get(clst);
-		fat_put(clst, empty_clst);
-		fat_put(empty_clst, next_clst);
-	}
+	/* Create a New Chain, or splice the run in after CLST. */
+	next_clst = clst == 0 ? EOChain : fat_get(clst);
+	for (size_t i = 0; i + 1 < cnt; i++)
+		fat_put(first + i, first + i + 1);
+	fat_put(first + cnt - 1, next_clst);
+	if (clst != 0)
+		fat_put(clst, first);
     lock_release(&fat_fs->write_lock);
-	return empty_clst;
+	fsstat_add (FSSTAT_CLUSTERS_ALLOCATED, cnt);
+	fsstat_end (FSSTAT_ALLOC, start);
+	return first;
 }
 
 /*** haein ***/
@@ -225,7 +423,24 @@ fat_remove_chain (cluster_t clst, cluster_t pclst) {
 void
 fat_put (cluster_t clst, cluster_t val) {
 	/* TODO: Your code goes here. */
-	(fat_fs->fat)[clst] = val;
+	/* 다음 cluster만 바꾸고 FAT_UNWRITTEN은 그대로 둔다. 비울 때는 함께 지운다. */
+	cluster_t *e = fat_entry (clst);
+
+	if (val == 0)
+		*e = 0;
+	else
+		*e = (*e & FAT_UNWRITTEN) | val;
+	fat_mark_dirty (clst);
+
+	/*** GrilledSalmon ***/
+	/* used_map도 맞춘다. fat_create_chain은 bit를 먼저 켜고 free_cnt를 줄여 둔다. */
+	if (bitmap_test (fat_fs->used_map, clst) != (val != 0)) {
+		bitmap_set (fat_fs->used_map, clst, val != 0);
+		if (val != 0)
+			fat_fs->free_cnt--;
+		else
+			fat_fs->free_cnt++;
+	}
 }
 
 /*** Dongdongbro ***/
@@ -233,21 +448,70 @@ fat_put (cluster_t clst, cluster_t val) {
 cluster_t
 fat_get (cluster_t clst) {
 	/* TODO: Your code goes here. */
-	cluster_t get_value = (fat_fs->fat)[clst];
+	cluster_t get_value = *fat_entry (clst) & ~FAT_UNWRITTEN;
 	return get_value;
 }
 
+/*** GrilledSalmon ***/
+/* CLST부터 연속된 CNT개 cluster를 아직 쓰지 않은 것으로 표시한다. 새로 잡은
+ * cluster를 0으로 채우는 대신 부른다. */
+void
+fat_mark_unwritten (cluster_t clst, size_t cnt) {
+	lock_acquire (&fat_fs->write_lock);
+	for (size_t i = 0; i < cnt; i++) {
+		*fat_entry (clst + i) |= FAT_UNWRITTEN;
+		fat_mark_dirty (clst + i);
+	}
+	lock_release (&fat_fs->write_lock);
+}
+
+/* CLST에 내용을 쓰기 시작했다. */
+void
+fat_mark_written (cluster_t clst) {
+	lock_acquire (&fat_fs->write_lock);
+	*fat_entry (clst) &= ~FAT_UNWRITTEN;
+	fat_mark_dirty (clst);
+	lock_release (&fat_fs->write_lock);
+}
+
+/* CLST의 항목이 든 FAT sector를 dirty로 표시한다. 그 sector의 사본은
+ * fat_entry가 이미 읽어 두었다. */
+static void
+fat_mark_dirty (cluster_t clst) {
+	bitmap_mark (fat_fs->dirty_map, clst / FAT_PER_SECTOR);
+}
+
+/* CLST를 아직 쓴 적이 없어서 0으로 읽어야 하면 true. */
+bool
+fat_unwritten (cluster_t clst) {
+	return (*fat_entry (clst) & FAT_UNWRITTEN) != 0;
+}
+
+/*** GrilledSalmon ***/
+/* 마운트한 파일 시스템의 cluster 하나의 sector 수. */
+unsigned int
+fat_cluster_sectors (void) {
+	return fat_fs->bs.sectors_per_cluster;
+}
+
+/* 새로 만드는 inode가 extent로 cluster를 찾아야 하면 true. */
+bool
+fat_extents (void) {
+	return fat_fs->bs.inode_format == FAT_INODE_EXTENTS;
+}
+
 /*** Dongdongbro ***/
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
 	/* TODO: Your code goes here. */
-	return fat_fs->data_start + clst;
+	return fat_fs->data_start + clst * fat_fs->bs.sectors_per_cluster;
 }
 
 /*** GrilledSalmon ***/	
 /*** Convert a sector # to a cluster #***/
+/* cluster 중간의 sector를 주면 그 sector가 속한 cluster를 돌려준다. */
 cluster_t
 sector_to_cluster (disk_sector_t sector) {
-	return sector - fat_fs->data_start;
+	return (sector - fat_fs->data_start) / fat_fs->bs.sectors_per_cluster;
 }
\ No newline at end of file
@@ -1,32 +1,54 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
+#include "filesys/buffer_cache.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/ipc.h"
+#include "userprog/pipe.h"
+#endif
+#ifdef VM
+#include "vm/shm.h"
+#endif
+#include <string.h>
+
+/* struct file 전용 object cache */
+static struct kmem_cache *file_cache;
 
 /* An open file. */
 // struct file {
 // 	struct inode *inode;        /* File's inode. */
 // 	off_t pos;                  /* Current position. */
 // 	bool deny_write;            /* Has file_deny_write() been called? */
-// 	int dupCount;               /* dupCount 가 0일때만 파일 종료 */
 // };
 
+/* Initializes the file module. */
+void
+file_init (void) {
+	file_cache = kmem_cache_create ("file", sizeof (struct file), 0, NULL);
+	if (file_cache == NULL)
+		PANIC ("file cache creation failed");
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) {
-	struct file *file = calloc (1, sizeof *file);
+	struct file *file = kmem_cache_alloc (file_cache);
 	if (inode != NULL && file != NULL) {
+		memset (file, 0, sizeof *file);
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
-
-		file->dupCount = 0;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
-		free (file);
+		kmem_cache_free (file_cache, file);
 		return NULL;
 	}
 }
@@ -45,21 +67,86 @@ file_duplicate (struct file *file) {
 	struct file *nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
+		nfile->ra_next = file->ra_next;
+		nfile->direct = file->direct;
+		nfile->dir = file->dir;
 		if (file->deny_write)
 			file_deny_write (nfile);
-
-		nfile->dupCount = file->dupCount;
 	}
 	return nfile;
 }
 
-/* Closes FILE. */
+/*** GrilledSalmon ***/
+/* FILE의 참조를 하나 늘려 그대로 돌려준다. dup2와 fork가 struct file을 복사하지
+ * 않고 같이 쓸 때 부른다. 참조마다 file_close를 한 번씩 불러야 한다. */
+struct file *
+file_share (struct file *file) {
+	__atomic_add_fetch (&file->ref_cnt, 1, __ATOMIC_RELAXED);
+	return file;
+}
+
+/*** GrilledSalmon ***/
+/* PIPE의 쓰는 쪽(WRITE_END) 또는 읽는 쪽을 가리키는 struct file을 만든다.
+ * inode가 없으므로 read, write 외의 파일 연산에 넘기면 안 된다. */
+struct file *
+file_open_pipe (struct pipe *pipe, bool write_end) {
+	struct file *file = kmem_cache_alloc (file_cache);
+	if (file != NULL) {
+		memset (file, 0, sizeof *file);
+		file->pipe = pipe;
+		file->pipe_write = write_end;
+		file->ref_cnt = 1;
+	}
+	return file;
+}
+
+/*** GrilledSalmon ***/
+/* shared memory segment SEG를 가리키는 struct file을 만든다. SEG의 참조 하나를
+ * 넘겨받는다. pipe처럼 inode가 없다. */
+struct file *
+file_open_shm (struct shm_seg *seg) {
+	struct file *file = kmem_cache_alloc (file_cache);
+	if (file != NULL) {
+		memset (file, 0, sizeof *file);
+		file->shm = seg;
+		file->ref_cnt = 1;
+	}
+	return file;
+}
+
+/*** GrilledSalmon ***/
+/* 메시지 channel CH를 가리키는 struct file을 만든다. 이 file이 닫히면 CH도
+ * 풀린다. pipe처럼 inode가 없다. */
+struct file *
+file_open_chan (struct ipc_chan *ch) {
+	struct file *file = kmem_cache_alloc (file_cache);
+	if (file != NULL) {
+		memset (file, 0, sizeof *file);
+		file->chan = ch;
+		file->ref_cnt = 1;
+	}
+	return file;
+}
+
+/* Closes FILE.  If FILE was shared with file_share(), only drops
+ * one reference; the last one closes it. */
 void
 file_close (struct file *file) {
-	if (file != NULL) {
+	if (file != NULL
+			&& __atomic_sub_fetch (&file->ref_cnt, 1, __ATOMIC_ACQ_REL) == 0) {
+#ifdef USERPROG
+		if (file->pipe != NULL)
+			pipe_close (file->pipe, file->pipe_write);
+		if (file->chan != NULL)
+			ipc_close (file->chan);
+#endif
+#ifdef VM
+		if (file->shm != NULL)
+			shm_seg_put (file->shm);
+#endif
 		file_allow_write (file);
 		inode_close (file->inode);
-		free (file);
+		kmem_cache_free (file_cache, file);
 	}
 }
 
@@ -76,8 +163,26 @@ file_get_inode (struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
+	bool sequential = file->pos == file->ra_next;
 	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
+	file->ra_next = file->pos;
+
+	/*** GrilledSalmon ***/
+	/* 직전 read에 이어서 읽었으면 다음 sector들을 미리 읽어 둔다. */
+	if (sequential && bytes_read > 0)
+		inode_readahead (file->inode, file->pos, BC_READAHEAD_SECTORS);
+	return bytes_read;
+}
+
+/*** GrilledSalmon ***/
+/* file_read처럼 읽지만 inode_read_direct로 buffer cache를 거치지 않는다.
+ * 캐시를 채우지 않으므로 미리 읽기도 하지 않는다. */
+off_t
+file_read_direct (struct file *file, void *buffer, off_t size) {
+	off_t bytes_read = inode_read_direct (file->inode, buffer, size, file->pos);
+	file->pos += bytes_read;
+	file->ra_next = file->pos;
 	return bytes_read;
 }
 
@@ -100,11 +205,24 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
+	if (file->dir)
+		return 0;
 	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
 }
 
+/*** GrilledSalmon ***/
+/* file_write처럼 쓰지만 inode_write_direct로 buffer cache를 거치지 않는다. */
+off_t
+file_write_direct (struct file *file, const void *buffer, off_t size) {
+	if (file->dir)
+		return 0;
+	off_t bytes_written = inode_write_direct (file->inode, buffer, size, file->pos);
+	file->pos += bytes_written;
+	return bytes_written;
+}
+
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually written,
@@ -115,9 +233,62 @@ file_write (struct file *file, const void *buffer, off_t size) {
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
 		off_t file_ofs) {
+	if (file->dir)
+		return 0;
 	return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/*** GrilledSalmon ***/
+/* FILE을 적어도 LENGTH 바이트로 늘리고 디스크 공간을 미리 잡아 둔다.
+ * 늘어난 부분은 0으로 읽힌다. file position은 바뀌지 않는다.
+ * Returns true if successful. */
+bool
+file_allocate (struct file *file, off_t length) {
+	if (file->dir)
+		return false;
+	return inode_allocate (file->inode, length);
+}
+
+/* SRC의 SRC_OFS부터 SIZE 바이트를 DST의 DST_OFS로 커널 안에서 복사한다.
+ * 유저 버퍼를 거치지 않고 커널 페이지 하나로 한 페이지씩 옮기며, 목적지의
+ * cluster는 처음에 한 번에 잡아 둔다. 두 파일의 file position은 바뀌지 않는다.
+ * Returns the number of bytes actually copied,
+ * which may be less than SIZE if end of SRC is reached. */
+off_t
+file_copy_range (struct file *src, off_t src_ofs,
+		struct file *dst, off_t dst_ofs, off_t size) {
+	off_t length = inode_length (src->inode);
+	off_t copied = 0;
+	uint8_t *bounce;
+
+	if (src_ofs >= length || size <= 0 || dst->dir)
+		return 0;
+	if (size > length - src_ofs)
+		size = length - src_ofs;
+
+	bounce = palloc_get_page (0);
+	if (bounce == NULL)
+		return 0;
+
+	/* 실패해도 상관없다. inode_write_at이 필요한 만큼 다시 늘린다. */
+	inode_allocate (dst->inode, dst_ofs + size);
+
+	while (copied < size) {
+		off_t chunk = size - copied < PGSIZE ? size - copied : PGSIZE;
+		off_t got = inode_read_at (src->inode, bounce, chunk, src_ofs + copied);
+		off_t put;
+
+		if (got <= 0)
+			break;
+		put = inode_write_at (dst->inode, bounce, got, dst_ofs + copied);
+		copied += put;
+		if (put < got)
+			break;
+	}
+	palloc_free_page (bounce);
+	return copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void
@@ -2,17 +2,46 @@
 #include <debug.h>
 #include <stdio.h>
 #include <string.h>
+#include <syscall-nr.h>
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "devices/disk.h"
 #include "filesys/fat.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/journal.h"
+#include "filesys/csum.h"
+#include "filesys/tmpfs.h"
+#include "filesys/procfs.h"
+#include "devices/timer.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
 
 static void do_format (void);
+static void filesys_syncd (void *aux);
+static struct work sync_work;
+#ifdef EFILESYS
+static void filesys_defragd (void *aux);
+static struct work defrag_work;
+#endif
+
+/*** GrilledSalmon ***/
+/* filesys_syncd가 journal을 commit 하고 buffer cache를 디스크에 쓰는 주기. */
+#define SYNC_INTERVAL TIMER_FREQ
+
+/* true면 defragd를 띄운다 (-defrag). */
+bool filesys_defrag;
+
+/* defragd가 디스크가 쉬는지 보는 주기. 한 주기 동안 아무도 디스크를 쓰지
+ * 않았으면 파일 하나를 옮긴다. */
+#define DEFRAG_INTERVAL (TIMER_FREQ / 2)
+
+/* defragd가 연속된 cluster로 옮긴 파일 수. */
+static size_t defrag_moved;
 
 /* Initializes the file system module.
  * If FORMAT is true, reformats the file system. */
@@ -22,7 +51,14 @@ filesys_init (bool format) {
 	if (filesys_disk == NULL)
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
+	bc_init ();
+	/* fat_init이 디스크의 journal 위치로 다시 잡는다. */
+	journal_init (0, 0);
 	inode_init ();
+	file_init ();
+	dir_init ();
+	tmpfs_init ();
+	procfs_init ();
 
 #ifdef EFILESYS
 	fat_init ();
@@ -40,6 +76,75 @@ filesys_init (bool format) {
 
 	free_map_open ();
 #endif
+
+	work_init (&sync_work, filesys_syncd, NULL);
+	work_queue_delayed (&sync_work, WQ_NORMAL, SYNC_INTERVAL);
+#ifdef EFILESYS
+	if (filesys_defrag) {
+		work_init (&defrag_work, filesys_defragd, NULL);
+		work_queue_delayed (&defrag_work, WQ_LOW, DEFRAG_INTERVAL);
+	}
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* 꺼질 때까지 기다리지 않도록 SYNC_INTERVAL마다 work queue에서 filesys_sync
+ * 한다. 죽더라도 마지막 주기 이후의 변경만 잃고, metadata는 commit 단위로 맞게
+ * 남는다. */
+static void
+filesys_syncd (void *aux UNUSED) {
+	filesys_sync ();
+	work_queue_delayed (&sync_work, WQ_NORMAL, SYNC_INTERVAL);
+}
+
+#ifdef EFILESYS
+/*** GrilledSalmon ***/
+/* fat_create_chain은 처음 보이는 빈 cluster를 주므로 여러 파일에 번갈아 덧붙이면
+ * 파일이 조각난다. defragd는 가장 낮은 work queue에서 돌면서, 지난 주기 동안
+ * 디스크를 읽고 쓴 것이 없을 때만 root 디렉터리의 다음 파일 하나를
+ * inode_relocate로 연속된 cluster에 옮긴다. 열려 있는 파일은 건너뛴다. */
+static void
+defrag_step (void) {
+	static long long last = -1;
+	static off_t pos = 0;
+	long long reads, writes;
+	struct dirent ent;
+	struct dir *dir;
+
+	disk_get_stats (filesys_disk, &reads, &writes);
+	if (reads + writes != last) {
+		last = reads + writes;
+		return;
+	}
+
+	dir = dir_open_root ();
+	if (dir == NULL)
+		return;
+	if (dir_read_entries (dir_get_inode (dir), &pos, &ent, 1) == 0)
+		pos = 0;
+	else if (inode_relocate (ent.inumber))
+		defrag_moved++;
+	dir_close (dir);
+	/* 옮기느라 쓴 I/O는 다음 주기를 막지 않는다. */
+	disk_get_stats (filesys_disk, &reads, &writes);
+	last = reads + writes;
+}
+
+/* 한 주기마다 defrag_step을 하고 다음 주기에 다시 돈다. 다음 주기는 이번
+ * 일이 끝난 뒤에 넣으므로 두 worker가 함께 돌지 않는다. */
+static void
+filesys_defragd (void *aux UNUSED) {
+	defrag_step ();
+	work_queue_delayed (&defrag_work, WQ_LOW, DEFRAG_INTERVAL);
+}
+#endif
+
+/* 바뀐 FAT과 metadata를 journal로 commit 하고 dirty data를 디스크에 쓴다.
+ * 리턴하면 그때까지 끝난 쓰기는 죽어도 남는다. */
+void
+filesys_sync (void) {
+	inode_flush ();
+	journal_commit ();
 }
 
 /* Shuts down the file system module, writing any unwritten data
@@ -52,6 +157,10 @@ filesys_done (void) {
 #else
 	free_map_close ();
 #endif
+	filesys_sync ();
+	if (filesys_defrag)
+		printf ("Defrag: %zu files relocated\n", defrag_moved);
+	csum_print_stats ();
 }
 
 /*** haein ***/
@@ -62,6 +171,14 @@ filesys_done (void) {
 bool
 filesys_create (const char *name, off_t initial_size) {
 	disk_sector_t inode_sector = 0;
+
+	/*** GrilledSalmon ***/
+	if (tmpfs_name (name) != NULL)
+		return tmpfs_create (tmpfs_name (name), initial_size);
+	if (procfs_name (name) != NULL)
+		return false;
+
+	journal_begin ();
 	struct dir *dir = dir_open_root ();
 	bool success = (dir != NULL
 #ifdef EFILESYS
@@ -79,6 +196,7 @@ filesys_create (const char *name, off_t initial_size) {
 #endif
 	}
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
@@ -90,14 +208,36 @@ filesys_create (const char *name, off_t initial_size) {
  * or if an internal memory allocation fails. */
 struct file *
 filesys_open (const char *name) {
-	struct dir *dir = dir_open_root ();
+	struct dir *dir;
 	struct inode *inode = NULL;
+	/*** GrilledSalmon ***/
+	/* "/"는 root 디렉터리 자체를 연다. getdents로 항목을 읽는다. */
+	bool is_root = strcmp (name, "/") == 0;
+	struct file *file;
 
-	if (dir != NULL)
-		dir_lookup (dir, name, &inode);
+	if (tmpfs_name (name) != NULL)
+		return file_open (tmpfs_open (tmpfs_name (name)));
+	if (procfs_name (name) != NULL) {
+		/* procfs 파일은 읽기만 한다. */
+		file = file_open (procfs_open (procfs_name (name)));
+		if (file != NULL)
+			file_deny_write (file);
+		return file;
+	}
+
+	dir = dir_open_root ();
+	if (dir != NULL) {
+		if (is_root)
+			inode = inode_reopen (dir_get_inode (dir));
+		else
+			dir_lookup (dir, name, &inode);
+	}
 	dir_close (dir);
 
-	return file_open (inode);
+	file = file_open (inode);
+	if (file != NULL)
+		file->dir = is_root;
+	return file;
 }
 
 /* Deletes the file named NAME.
@@ -106,13 +246,61 @@ filesys_open (const char *name) {
  * or if an internal memory allocation fails. */
 bool
 filesys_remove (const char *name) {
+	/*** GrilledSalmon ***/
+	if (tmpfs_name (name) != NULL)
+		return tmpfs_remove (tmpfs_name (name));
+	if (procfs_name (name) != NULL)
+		return false;
+
+	journal_begin ();
 	struct dir *dir = dir_open_root ();
 	bool success = dir != NULL && dir_remove (dir, name);
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
 
+/*** GrilledSalmon ***/
+/* NAME인 파일의 속성을 ST에 담는다. 이름은 dcache로 찾고 속성은 열린 inode에서
+ * 읽으므로, 둘 다 cache에 있으면 디스크를 읽지 않는다. 없는 파일이면 false. */
+bool
+filesys_stat (const char *name, struct stat *st) {
+	struct dir *dir;
+	struct inode *inode = NULL;
+
+	if (tmpfs_name (name) != NULL)
+		inode = tmpfs_open (tmpfs_name (name));
+	else if (procfs_name (name) != NULL)
+		inode = procfs_open (procfs_name (name));
+	else {
+		dir = dir_open_root ();
+		if (dir != NULL) {
+			if (strcmp (name, "/") == 0)
+				inode = inode_reopen (dir_get_inode (dir));
+			else
+				dir_lookup (dir, name, &inode);
+		}
+		dir_close (dir);
+	}
+
+	if (inode == NULL)
+		return false;
+	filesys_stat_inode (inode, st);
+	inode_close (inode);
+	return true;
+}
+
+/* 열린 INODE의 속성을 ST에 담는다. 하드 링크가 없으므로 이름은 항상 하나다. */
+void
+filesys_stat_inode (struct inode *inode, struct stat *st) {
+	memset (st, 0, sizeof *st);
+	st->size = inode_length (inode);
+	st->inumber = inode_get_inumber (inode);
+	st->type = st->inumber == (int) dir_root_sector () ? S_IFDIR : S_IFREG;
+	st->nlink = 1;
+}
+
 /* Formats the file system. */
 static void
 do_format (void) {
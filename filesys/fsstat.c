@@ -0,0 +1,109 @@
+/* fsstat.c: File system counters and latency histograms. */
+
+#include "filesys/fsstat.h"
+#include <stdio.h>
+#include <string.h>
+#include "devices/disk.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/filesys.h"
+#include "threads/interrupt.h"
+#include "intrinsic.h"
+
+/*** GrilledSalmon ***/
+/* 연산마다 호출 수와 걸린 TSC cycle의 log2 histogram을 모은다. 어디서나 부를 수
+ * 있도록 lock 대신 잠깐 interrupt를 끄고 센다. buffer cache와 디스크 통계는
+ * 그쪽에서 세던 것을 fsstat_get이 모아 온다. */
+static long ops[FSSTAT_OPS];
+static long latency[FSSTAT_OPS][FSSTAT_BUCKETS];
+static long counters[FSSTAT_COUNTERS];
+
+static const char *op_names[FSSTAT_OPS] = {
+	[FSSTAT_READ] = "read",
+	[FSSTAT_WRITE] = "write",
+	[FSSTAT_MAP] = "map",
+	[FSSTAT_ALLOC] = "alloc",
+};
+
+/* 잴 연산을 시작한다. 리턴값을 fsstat_end에 넘긴다. */
+uint64_t
+fsstat_begin (void) {
+	return rdtsc ();
+}
+
+/* fsstat_begin이 START를 리턴한 뒤로 걸린 시간을 OP의 histogram에 더한다. */
+void
+fsstat_end (enum fsstat_op op, uint64_t start) {
+	uint64_t cycles = rdtsc () - start;
+	enum intr_level old_level;
+	int bucket = 0;
+
+	while (cycles > 1 && bucket < FSSTAT_BUCKETS - 1) {
+		cycles >>= 1;
+		bucket++;
+	}
+
+	old_level = intr_disable ();
+	ops[op]++;
+	latency[op][bucket]++;
+	intr_set_level (old_level);
+}
+
+/* COUNTER에 N을 더한다. */
+void
+fsstat_add (enum fsstat_counter counter, long n) {
+	enum intr_level old_level = intr_disable ();
+	counters[counter] += n;
+	intr_set_level (old_level);
+}
+
+/* 지금까지의 통계를 ST에 담는다. */
+void
+fsstat_get (struct fsstat *st) {
+	enum intr_level old_level;
+	size_t hits, misses, readahead;
+	long long reads = 0, writes = 0;
+
+	bc_get_stats (&hits, &misses, &readahead);
+	if (filesys_disk != NULL)
+		disk_get_stats (filesys_disk, &reads, &writes);
+
+	old_level = intr_disable ();
+	memcpy (st->ops, ops, sizeof ops);
+	memcpy (st->latency, latency, sizeof latency);
+	st->bytes_read = counters[FSSTAT_BYTES_READ];
+	st->bytes_written = counters[FSSTAT_BYTES_WRITTEN];
+	st->chain_lookups = counters[FSSTAT_CHAIN_LOOKUPS];
+	st->chain_steps = counters[FSSTAT_CHAIN_STEPS];
+	st->clusters_allocated = counters[FSSTAT_CLUSTERS_ALLOCATED];
+	intr_set_level (old_level);
+
+	st->bc_hits = hits;
+	st->bc_misses = misses;
+	st->bc_readahead = readahead;
+	st->sectors_read = reads;
+	st->sectors_written = writes;
+}
+
+/* Prints file system statistics. */
+void
+fsstat_print (void) {
+	static struct fsstat st;
+	int op, b;
+
+	if (filesys_disk == NULL)
+		return;
+	fsstat_get (&st);
+	printf ("File system: %ld bytes read, %ld bytes written, "
+			"%ld chain walks of %ld steps, %ld clusters allocated\n",
+			st.bytes_read, st.bytes_written, st.chain_lookups,
+			st.chain_steps, st.clusters_allocated);
+	for (op = 0; op < FSSTAT_OPS; op++) {
+		if (st.ops[op] == 0)
+			continue;
+		printf ("  %s: %ld calls, log2 cycles", op_names[op], st.ops[op]);
+		for (b = 0; b < FSSTAT_BUCKETS; b++)
+			if (st.latency[op][b] != 0)
+				printf (" %d:%ld", b, st.latency[op][b]);
+		printf ("\n");
+	}
+}
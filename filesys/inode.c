@@ -1,23 +1,57 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
+#include <ohash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/synch.h"
 #include "filesys/fat.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/directory.h"
+#include "filesys/journal.h"
+#include "filesys/fsstat.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/*** GrilledSalmon ***/
+/* 이 크기까지의 파일은 cluster를 잡지 않고 inode sector 안에 내용을 둔다.
+ * 작은 파일은 data cluster 하나와 디스크 읽기 한 번을 아낀다. EFILESYS에서만 쓴다. */
+#define INODE_INLINE_MAX (DISK_SECTOR_SIZE - 16)
+#define INODE_INLINE 0x1                /* 내용이 inline_data에 있다. */
+#define INODE_EXTENTS 0x2               /* cluster를 extents로 찾는다. */
+
+/* 파일의 LOGICAL번째 cluster부터 CNT개가 디스크의 START부터 연속으로 있다. */
+struct extent {
+	uint32_t logical;
+	cluster_t start;
+	uint32_t cnt;
+};
+
+/* inode sector에 담을 수 있는 extent 수. */
+#define INODE_EXTENT_MAX ((INODE_INLINE_MAX - 4) / sizeof (struct extent))
+
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
 	disk_sector_t start;                /* First data sector. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	uint32_t flags;                     /* INODE_INLINE 등. */
+	union {
+		uint8_t inline_data[INODE_INLINE_MAX]; /* INODE_INLINE이면 파일 내용. */
+		struct {                        /* INODE_EXTENTS면 logical 순으로. */
+			uint32_t extent_cnt;
+			struct extent extents[INODE_EXTENT_MAX];
+		};
+		uint32_t written;               /* EFILESYS가 아니면 앞에서부터 내용을 쓴
+		                                   data sector 수. 그 뒤는 0으로 읽는다. */
+	};
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -30,12 +64,37 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct ohash_elem elem;             /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rw;                   /* 읽기는 공유, 쓰기(길이 변경 포함)는 배타 */
 	struct inode_disk data;             /* Inode content. */
+	struct dir_index *dir_index;        /* 디렉터리면 이름 색인. directory.c가 만든다. */
+	struct page_index *page_index;      /* mmap 한 page의 frame들. page_cache.c가 만든다. */
+	bool journaled;                     /* 내용을 journal로 쓴다. 디렉터리가 그렇다. */
+	bool dirty;                         /* data를 바꾸고 아직 inode sector에 쓰지 않았다. */
+	unsigned write_gen;                 /* 내용이나 길이가 바뀔 때마다 늘어난다. */
+	/*** GrilledSalmon ***/
+	/* tmpfs inode는 디스크에 없고 내용을 이 page들에 둔다. open_inodes에도 없다.
+	 * mem_pages[i]가 NULL이면 그 page는 아직 쓴 적 없어 0으로 읽는다. */
+	bool mem;
+	uint8_t **mem_pages;
+	size_t mem_page_cnt;
+#ifdef EFILESYS
+	/*** GrilledSalmon ***/
+	/* 파일의 cluster chain 앞부분. chain[i]가 i번째 cluster이고 필요할 때까지
+	 * 늘려 간다. reader끼리도 늘릴 수 있으므로 rw와 별도로 chain_lock이 보호한다. */
+	struct lock chain_lock;
+	cluster_t *chain;
+	size_t chain_len;
+	size_t chain_cap;
+	/* 길이에 필요한 것보다 chain 뒤에 더 잡아 둔 cluster 수. 덧붙이는 쓰기가
+	 * 이 cluster들을 차례로 쓰고, 마지막으로 닫을 때 남은 것을 돌려준다. */
+	size_t reserved;
+	size_t prealloc;                    /* 다음에 더 잡을 cluster 수. */
+#endif
 };
 
 #ifndef EFILESYS
@@ -54,36 +113,344 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 		return -1;
 }
 #else
+/* cluster 하나의 바이트 수. 포맷할 때 정한다. */
+#define CLUSTER_BYTES (DISK_SECTOR_SIZE * fat_cluster_sectors ())
+
+/* 파일을 늘릴 때 뒤에 더 잡아 둘 cluster 수. 늘릴 때마다 두 배로 키운다. */
+#define PREALLOC_MIN 8
+#define PREALLOC_MAX 64
+
+/*** GrilledSalmon ***/
+/* INODE의 N번째 cluster를 리턴한다. chain이 그 전에 끝나면 0. 처음 찾는
+ * cluster만 FAT을 따라가고 찾은 것은 inode->chain에 기억해 두므로,
+ * 순차로 읽으면 sector마다 chain을 처음부터 따라가지 않는다. */
+static cluster_t
+chain_lookup (struct inode *inode, size_t n) {
+	cluster_t clst;
+
+	lock_acquire (&inode->chain_lock);
+	if (inode->chain_len == 0) {
+		inode->chain = malloc (sizeof *inode->chain);
+		if (inode->chain != NULL) {
+			inode->chain[0] = sector_to_cluster (inode->data.start);
+			inode->chain_len = inode->chain_cap = 1;
+		}
+	}
+	if (inode->chain_len == 0) {
+		/* 메모리가 없으면 예전처럼 처음부터 따라간다. */
+		lock_release (&inode->chain_lock);
+		clst = sector_to_cluster (inode->data.start);
+		while (n-- > 0 && clst != EOChain)
+			clst = fat_get (clst);
+		return clst != EOChain ? clst : 0;
+	}
+
+	clst = inode->chain[inode->chain_len - 1];
+	if (inode->chain_len <= n)
+		fsstat_add (FSSTAT_CHAIN_LOOKUPS, 1);
+	while (inode->chain_len <= n) {
+		fsstat_add (FSSTAT_CHAIN_STEPS, 1);
+		clst = fat_get (clst);
+		if (clst == EOChain || clst == 0)
+			break;
+		if (inode->chain_len == inode->chain_cap) {
+			cluster_t *chain = realloc (inode->chain,
+					2 * inode->chain_cap * sizeof *chain);
+			if (chain == NULL) {
+				/* 더 기억하지 못하면 나머지는 따라가기만 한다. */
+				n -= inode->chain_len;
+				while (n-- > 0 && clst != EOChain && clst != 0)
+					clst = fat_get (clst);
+				lock_release (&inode->chain_lock);
+				return clst != EOChain ? clst : 0;
+			}
+			inode->chain = chain;
+			inode->chain_cap *= 2;
+		}
+		inode->chain[inode->chain_len++] = clst;
+	}
+	clst = n < inode->chain_len ? inode->chain[n] : 0;
+	lock_release (&inode->chain_lock);
+	return clst;
+}
+
+/* FAT이 CLST 바로 뒤에 새 cluster를 끼워 넣었으니, 기억해 둔 chain에서 CLST
+ * 뒤의 cluster들은 버린다. */
+static void
+chain_truncate_after (struct inode *inode, cluster_t clst) {
+	size_t i;
+
+	lock_acquire (&inode->chain_lock);
+	for (i = 0; i < inode->chain_len; i++)
+		if (inode->chain[i] == clst) {
+			inode->chain_len = i + 1;
+			break;
+		}
+	lock_release (&inode->chain_lock);
+}
+
+/*** GrilledSalmon ***/
+/* -extents로 포맷하면 inode가 자기 cluster들을 (logical, start, cnt) extent로
+ * 기억해서 N번째 cluster를 extent 몇 개 위의 이분 탐색으로 찾는다. 연속으로
+ * 잡은 큰 파일은 extent 하나가 된다. FAT chain도 언제나 함께 맞춰 두므로
+ * extent가 INODE_EXTENT_MAX개를 넘으면 extent를 버리고 chain으로 돌아간다. */
+
+/* D의 extent에서 N번째 cluster를 찾는다. 없으면 0. */
+static cluster_t
+extent_lookup (const struct inode_disk *d, size_t n) {
+	size_t lo = 0, hi = d->extent_cnt;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		const struct extent *e = &d->extents[mid];
+
+		if (n < e->logical)
+			hi = mid;
+		else if (n >= e->logical + e->cnt)
+			lo = mid + 1;
+		else
+			return e->start + (n - e->logical);
+	}
+	return 0;
+}
+
+/* chain 끝에 이은 FIRST부터 CNT개 cluster를 D의 extent에 더한다. */
+static void
+extent_append (struct inode_disk *d, cluster_t first, size_t cnt) {
+	struct extent *last;
+
+	if (!(d->flags & INODE_EXTENTS))
+		return;
+	last = d->extent_cnt > 0 ? &d->extents[d->extent_cnt - 1] : NULL;
+	if (last != NULL && last->start + last->cnt == first) {
+		last->cnt += cnt;
+		return;
+	}
+	if (d->extent_cnt == INODE_EXTENT_MAX) {
+		d->flags &= ~INODE_EXTENTS;
+		return;
+	}
+	d->extents[d->extent_cnt++] = (struct extent) {
+		.logical = last != NULL ? last->logical + last->cnt : 0,
+		.start = first,
+		.cnt = cnt,
+	};
+}
+
+/* D의 extent에 앞의 N개 cluster만 남긴다. */
+static void
+extent_truncate (struct inode_disk *d, size_t n) {
+	while (d->extent_cnt > 0) {
+		struct extent *last = &d->extents[d->extent_cnt - 1];
+
+		if (last->logical < n) {
+			if (last->logical + last->cnt > n)
+				last->cnt = n - last->logical;
+			break;
+		}
+		d->extent_cnt--;
+	}
+}
+
+/* INODE의 N번째 cluster. 없으면 0. */
+static cluster_t
+nth_cluster (struct inode *inode, size_t n) {
+	if (inode->data.flags & INODE_EXTENTS)
+		return extent_lookup (&inode->data, n);
+	return chain_lookup (inode, n);
+}
+
+/* 미리 잡아 두고 쓰지 않은 cluster를 FAT에 돌려준다. */
+static void
+release_reserved (struct inode *inode) {
+	size_t keep = inode_length (inode) / CLUSTER_BYTES;
+	cluster_t last;
+
+	if (inode->reserved == 0)
+		return;
+	last = nth_cluster (inode, keep);
+	if (last != 0) {
+		chain_truncate_after (inode, last);
+		fat_remove_chain (fat_get (last), last);
+		extent_truncate (&inode->data, keep + 1);
+		inode->dirty = true;
+	}
+	inode->reserved = 0;
+}
+
 /*** GrilledSalmon ***/
+/* INODE의 내용이 inode sector 안에 있으면 true. 그런 inode는 chain이 없으므로
+ * byte_to_sector를 부르면 안 된다. */
+static bool
+inode_is_inline (const struct inode *inode) {
+	return (inode->data.flags & INODE_INLINE) != 0;
+}
+
+/* inline INODE의 OFFSET부터 SIZE 바이트를 BUFFER로 읽는다. */
+static off_t
+inline_read (struct inode *inode, void *buffer, off_t size, off_t offset) {
+	off_t left = inode_length (inode) - offset;
+
+	if (left <= 0 || size <= 0)
+		return 0;
+	if (size > left)
+		size = left;
+	memcpy (buffer, inode->data.inline_data + offset, size);
+	return size;
+}
+
+/* BUFFER의 SIZE 바이트를 inline INODE의 OFFSET부터 쓴다. inode sector는 닫거나
+ * filesys_sync 할 때 한 번에 쓴다. 길이는 미리 늘려 두어야 한다. */
+static off_t
+inline_write (struct inode *inode, const void *buffer, off_t size,
+		off_t offset) {
+	off_t left = inode_length (inode) - offset;
+
+	if (left <= 0 || size <= 0)
+		return 0;
+	if (size > left)
+		size = left;
+	memcpy (inode->data.inline_data + offset, buffer, size);
+	inode->dirty = true;
+	return size;
+}
+
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
 	if (pos > inode->data.length) {
 		return -1;
 	}
 
-	int nth_cluster = pos / DISK_SECTOR_SIZE / SECTORS_PER_CLUSTER;
-	cluster_t clst = sector_to_cluster(inode->data.start);
+	uint64_t start = fsstat_begin ();
+	int nth = pos / CLUSTER_BYTES;
+	cluster_t clst = nth_cluster (inode, nth);
 
-	for (int i=0; i<nth_cluster; i++) {
-		clst = fat_get(clst);
-	}
+	fsstat_end (FSSTAT_MAP, start);
+	if (clst == 0)
+		return -1;
 
 	/* cluster 내에서의 offset */
-	off_t clst_ofs = pos - nth_cluster*SECTORS_PER_CLUSTER*DISK_SECTOR_SIZE;
+	off_t clst_ofs = pos - nth*CLUSTER_BYTES;
 
 	return cluster_to_sector(clst) + clst_ofs/DISK_SECTOR_SIZE;
 }
 #endif
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+static void inode_setup (struct inode *, disk_sector_t);
+
+/*** GrilledSalmon ***/
+/* tmpfs INODE의 OFFSET부터 SIZE 바이트를 BUFFER로 읽는다. */
+static off_t
+mem_read (struct inode *inode, void *buffer_, off_t size, off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t left = inode_length (inode) - offset;
+	off_t bytes_read = 0;
+
+	if (left <= 0 || size <= 0)
+		return 0;
+	if (size > left)
+		size = left;
+	while (bytes_read < size) {
+		size_t idx = offset / PGSIZE;
+		size_t page_ofs = offset % PGSIZE;
+		off_t chunk = PGSIZE - page_ofs;
+
+		if (chunk > size - bytes_read)
+			chunk = size - bytes_read;
+		if (idx < inode->mem_page_cnt && inode->mem_pages[idx] != NULL)
+			memcpy (buffer + bytes_read, inode->mem_pages[idx] + page_ofs, chunk);
+		else
+			memset (buffer + bytes_read, 0, chunk);
+		offset += chunk;
+		bytes_read += chunk;
+	}
+	return bytes_read;
+}
+
+/* BUFFER의 SIZE 바이트를 tmpfs INODE의 OFFSET부터 쓰고 필요하면 길이를
+ * 늘린다. 처음 쓰는 page는 그때 잡는다. page가 모자라면 쓴 만큼만 리턴한다. */
+static off_t
+mem_write (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	size_t need = DIV_ROUND_UP (offset + size, PGSIZE);
+	off_t bytes_written = 0;
+
+	if (size <= 0)
+		return 0;
+	if (need > inode->mem_page_cnt) {
+		uint8_t **pages = realloc (inode->mem_pages, need * sizeof *pages);
+
+		if (pages == NULL)
+			return 0;
+		memset (pages + inode->mem_page_cnt, 0,
+				(need - inode->mem_page_cnt) * sizeof *pages);
+		inode->mem_pages = pages;
+		inode->mem_page_cnt = need;
+	}
+	while (bytes_written < size) {
+		size_t idx = offset / PGSIZE;
+		size_t page_ofs = offset % PGSIZE;
+		off_t chunk = PGSIZE - page_ofs;
+
+		if (chunk > size - bytes_written)
+			chunk = size - bytes_written;
+		if (inode->mem_pages[idx] == NULL) {
+			inode->mem_pages[idx] = palloc_get_page (PAL_ZERO);
+			if (inode->mem_pages[idx] == NULL)
+				break;
+		}
+		memcpy (inode->mem_pages[idx] + page_ofs, buffer + bytes_written, chunk);
+		offset += chunk;
+		bytes_written += chunk;
+	}
+	if (offset > inode->data.length)
+		inode->data.length = offset;
+	return bytes_written;
+}
+
+/* tmpfs INODE의 page를 모두 돌려준다. */
+static void
+mem_release (struct inode *inode) {
+	for (size_t i = 0; i < inode->mem_page_cnt; i++)
+		if (inode->mem_pages[i] != NULL)
+			palloc_free_page (inode->mem_pages[i]);
+	free (inode->mem_pages);
+	inode->mem_pages = NULL;
+	inode->mem_page_cnt = 0;
+}
+
+/* Open inodes indexed by sector, so that opening a single inode
+ * twice returns the same `struct inode'. */
+static struct ohash open_inodes;
+
+/* open_inodes와 각 inode의 open_cnt를 보호한다. */
+static struct lock open_inodes_lock;
+
+/* 열린 struct inode들. -memstat에 나온다. */
+static struct mem_tag inode_tag = MEM_TAG ("inode");
+
+/*** GrilledSalmon ***/
+static uint64_t
+open_inode_hash (const struct ohash_elem *e, void *aux UNUSED) {
+	const struct inode *inode = ohash_entry (e, struct inode, elem);
+	return hash_u64 (inode->sector);
+}
+
+static bool
+open_inode_eq (const struct ohash_elem *a, const struct ohash_elem *b,
+		void *aux UNUSED) {
+	return ohash_entry (a, struct inode, elem)->sector
+		== ohash_entry (b, struct inode, elem)->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	if (!ohash_init (&open_inodes, open_inode_hash, open_inode_eq, NULL))
+		PANIC ("open inode table allocation failed");
+	lock_init (&open_inodes_lock);
 }
 
 /*** haein ***/
@@ -107,35 +474,51 @@ inode_create (disk_sector_t sector, off_t length) {
 	if (disk_inode != NULL) {
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		static char zeros[DISK_SECTOR_SIZE];
 #ifdef EFILESYS
+		/* 길이 L인 파일은 L / CLUSTER_BYTES + 1개 cluster를 가진다. 0으로 채우는
+		 * 대신 쓴 적 없다고 표시만 하므로 크기와 상관없이 inode sector 하나만 쓴다. */
+		size_t cnt = length / CLUSTER_BYTES + 1;
 		cluster_t startclst = 0;
-		bool first = true;
-		while (length >= 0) {
-			startclst = fat_create_chain(startclst); // Create Chain
-			if (startclst == 0) { // Creation Fail
-				return false;
-			}
-			if (first) {
-				disk_inode->start = cluster_to_sector(startclst);
-				first = false;
+		cluster_t clst;
+
+		/* 작은 파일은 cluster 없이 inode sector에 담는다. */
+		if (length <= INODE_INLINE_MAX) {
+			disk_inode->flags = INODE_INLINE;
+			cnt = 0;
+		} else if (fat_extents ())
+			disk_inode->flags = INODE_EXTENTS;
+
+		/* 연속으로 한 번에 잡아 보고 안 되면 하나씩 잇는다. */
+		clst = cnt > 0 ? fat_create_run (0, cnt) : 0;
+		if (clst != 0) {
+			startclst = clst;
+			fat_mark_unwritten (clst, cnt);
+			extent_append (disk_inode, clst, cnt);
+		} else
+			for (clst = 0; cnt > 0; cnt--) {
+				clst = fat_create_chain (clst); // Create Chain
+				if (clst == 0) { // Creation Fail
+					if (startclst != 0)
+						fat_remove_chain (startclst, 0);
+					free (disk_inode);
+					return false;
+				}
+				if (startclst == 0)
+					startclst = clst;
+				fat_mark_unwritten (clst, 1);
+				extent_append (disk_inode, clst, 1);
 			}
-			disk_write (filesys_disk, cluster_to_sector(startclst), zeros); // write zeros on statclst sector
-			length -= DISK_SECTOR_SIZE;
-		}
+		if (startclst != 0)
+			disk_inode->start = cluster_to_sector (startclst);
 
-		disk_write (filesys_disk, sector, disk_inode); // write on sector once from disk_inode
+		journal_write (sector, disk_inode, 0, DISK_SECTOR_SIZE); // write on sector once from disk_inode
 		success = true;
 #else
+		/* data sector는 0으로 채우지 않는다. written이 0이므로 처음 쓸 때까지
+		 * 디스크를 읽지 않고 0을 준다. */
 		size_t sectors = bytes_to_sectors (length); // 오프셋의 섹터 넘버
 		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
+			bc_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 			success = true; 
 		}
 #endif
@@ -149,39 +532,141 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	/* struct inode는 커서 스택에 두지 않는다. open_inodes_lock이 보호한다. */
+	static struct inode key;
+	struct ohash_elem *e;
 	struct inode *inode;
 
+	lock_acquire (&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	key.sector = sector;
+	e = ohash_find (&open_inodes, &key.elem);
+	if (e != NULL) {
+		inode = ohash_entry (e, struct inode, elem);
+		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+		return inode; 
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = malloc_tagged (&inode_tag, sizeof *inode);
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
+		return NULL;
+	}
+
+	/* Initialize.  다른 스레드가 같은 sector를 중복으로 열지 않도록
+	 * 해시에 넣고 읽어오는 동안 lock을 잡고 있는다. */
+	inode_setup (inode, sector);
+	ohash_insert (&open_inodes, &inode->elem);
+	bc_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	lock_release (&open_inodes_lock);
+	return inode;
+}
+
+/*** GrilledSalmon ***/
+/* inode_open과 같지만 SECTOR가 파일의 디스크 inode가 아니면 열지 않고 NULL을
+ * 리턴한다. checkpoint 이미지처럼 유저가 건넨 inode 번호를 열 때 쓴다. root
+ * 디렉터리도 열지 않는다. */
+struct inode *
+inode_open_checked (disk_sector_t sector) {
+	struct inode *inode;
+
+	if (sector == dir_root_sector () || sector >= disk_size (filesys_disk))
+		return NULL;
+	inode = inode_open (sector);
+	if (inode != NULL && (inode->removed || inode->data.magic != INODE_MAGIC)) {
+		inode_close (inode);
+		return NULL;
+	}
+	return inode;
+}
+
+/*** GrilledSalmon ***/
+/* 길이 0인 tmpfs inode를 만들어 연다. 내용은 커널 page에만 있고 디스크에는
+ * 아무것도 쓰지 않으며, 마지막으로 닫으면 사라진다. INUMBER는 디스크 sector와
+ * 겹치지 않는 번호여야 한다. 메모리가 없으면 NULL. */
+struct inode *
+inode_create_mem (disk_sector_t inumber) {
+	struct inode *inode = malloc_tagged (&inode_tag, sizeof *inode);
+
 	if (inode == NULL)
 		return NULL;
+	inode_setup (inode, inumber);
+	memset (&inode->data, 0, sizeof inode->data);
+	inode->data.magic = INODE_MAGIC;
+	inode->mem = true;
+	return inode;
+}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+/* 새로 연 INODE의 필드를 SECTOR의 inode로 초기화한다. data는 부르는 쪽이
+ * 채운다. */
+static void
+inode_setup (struct inode *inode, disk_sector_t sector) {
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
-	return inode;
+	/* 페이지 폴트로 같은 inode를 다시 읽는 경우가 있으므로 reader 우선으로 둔다. */
+	rwlock_init (&inode->rw, false);
+	inode->dir_index = NULL;
+	inode->page_index = NULL;
+	inode->journaled = false;
+	inode->dirty = false;
+	inode->write_gen = 0;
+#ifdef EFILESYS
+	lock_init (&inode->chain_lock);
+	inode->chain = NULL;
+	inode->chain_len = inode->chain_cap = 0;
+	inode->reserved = inode->prealloc = 0;
+#endif
+	inode->mem = false;
+	inode->mem_pages = NULL;
+	inode->mem_page_cnt = 0;
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 data가 바뀌었으면 inode sector에 쓴다. buffer cache를 거치는 journal로
+ * 쓰므로 같은 commit 안에서 여러 번 바뀌어도 디스크에는 한 번 쓰인다. INODE의
+ * rw를 잡고 있거나 마지막 opener가 부른다. */
+static void
+inode_write_back (struct inode *inode) {
+	if (inode->dirty) {
+		inode->dirty = false;
+		journal_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* 열린 inode 중 data가 바뀐 것들을 inode sector에 쓴다. filesys_sync가 journal을
+ * commit 하기 전에 불러서 바뀐 길이와 cluster가 FAT과 같은 commit에 들어가게 한다. */
+void
+inode_flush (void) {
+	struct ohash_iterator i;
+
+	lock_acquire (&open_inodes_lock);
+	ohash_first (&i, &open_inodes);
+	while (ohash_next (&i)) {
+		struct inode *inode = ohash_entry (ohash_cur (&i), struct inode, elem);
+
+		if (!inode->dirty)
+			continue;
+		rwlock_acquire_read (&inode->rw);
+		inode_write_back (inode);
+		rwlock_release_read (&inode->rw);
+	}
+	lock_release (&open_inodes_lock);
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -202,24 +687,48 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	lock_acquire (&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-		disk_write (filesys_disk, inode->sector, &inode->data);
+		/* Remove from open_inodes and release lock. */
+		if (!inode->mem)
+			ohash_delete (&open_inodes, &inode->elem);
+		lock_release (&open_inodes_lock);
 		/* Deallocate blocks if removed. */
-		if (inode->removed) {
+		if (inode->mem)
+			mem_release (inode);
+		else if (inode->removed) {
 #ifdef EFILESYS
 			fat_remove_chain(sector_to_cluster(inode->sector), 0);
-			fat_remove_chain(sector_to_cluster(inode->data.start), 0);
+			if (!inode_is_inline (inode))
+				fat_remove_chain(sector_to_cluster(inode->data.start), 0);
 #else
 			free_map_release (inode->sector, 1);
 			free_map_release (inode->data.start,
 					bytes_to_sectors (inode->data.length)); 
 #endif
 		}
+		else {
+#ifdef EFILESYS
+			release_reserved (inode);
+#endif
+			/* 지운 inode의 sector는 이미 돌려주었으니 쓸 필요가 없다. */
+			inode_write_back (inode);
+		}
 
-		free (inode); 
-	}
+#ifdef EFILESYS
+		free (inode->chain);
+#endif
+		dir_index_destroy (inode->dir_index);
+		free_tagged (&inode_tag, inode);
+	} else
+		lock_release (&open_inodes_lock);
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 내용이 metadata라서 journal로 써야 한다고 표시한다. */
+void
+inode_set_journaled (struct inode *inode) {
+	inode->journaled = true;
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -230,15 +739,77 @@ inode_remove (struct inode *inode) {
 	inode->removed = true;
 }
 
-/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
- * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
-off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
+/*** GrilledSalmon ***/
+/* Returns true if INODE has been removed. */
+bool
+inode_is_removed (const struct inode *inode) {
+	return inode->removed;
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 쓰기 세대. 내용이나 길이가 바뀔 때마다 늘어나므로 두 번 읽은 값이
+ * 같으면 그 사이에 쓰기가 없었다. inode가 열려 있는 동안만 의미가 있다. */
+unsigned
+inode_write_gen (const struct inode *inode) {
+	return inode->write_gen;
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 data SECTOR에 아직 아무것도 쓰지 않았으면 true. 그런 sector는 디스크를
+ * 읽지 않고 0으로 읽는다. EFILESYS는 cluster마다 FAT에 표시하고, 아니면 inode의
+ * written 뒤가 그렇다. */
+static bool
+sector_unwritten (const struct inode *inode UNUSED, disk_sector_t sector) {
+#ifdef EFILESYS
+	return fat_unwritten (sector_to_cluster (sector));
+#else
+	return sector - inode->data.start >= inode->data.written;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 OFFSET에 있는 SECTOR부터, SIZE 바이트 안에서 디스크에 연달아 놓인
+ * 온전한 sector가 몇 개인지 센다. 한 번의 disk 명령으로 옮길 수 있는 만큼만
+ * 세고, 읽을 때는(WRITE가 아니면) 쓴 적 없는 sector에서 멈춘다. 적어도 1을
+ * 리턴한다. */
+static size_t
+direct_run (struct inode *inode, disk_sector_t sector, off_t offset,
+		off_t size, bool write) {
+	size_t n = 1;
+
+	while (n < DISK_MAX_SECTORS
+			&& (off_t) (n + 1) * DISK_SECTOR_SIZE <= size
+			&& offset + (off_t) (n + 1) * DISK_SECTOR_SIZE
+				<= inode_length (inode)) {
+		disk_sector_t next = byte_to_sector (inode,
+				offset + (off_t) n * DISK_SECTOR_SIZE);
+
+		if (next != sector + n || (!write && sector_unwritten (inode, next)))
+			break;
+		n++;
+	}
+	return n;
+}
+
+/* inode_read_at과 inode_read_direct가 함께 쓴다. DIRECT면 sector 전체를 읽는
+ * chunk는 buffer cache에 없을 때 디스크에서 BUFFER로 바로 읽는데, 디스크에서
+ * 이어지는 sector는 한 번에 읽는다. */
+static off_t
+read_at (struct inode *inode, void *buffer_, off_t size, off_t offset,
+		bool direct) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
+	uint64_t start = fsstat_begin ();
 
+	rwlock_acquire_read (&inode->rw);
+	if (inode->mem)
+		bytes_read = mem_read (inode, buffer, size, offset);
+	else
+#ifdef EFILESYS
+	if (inode_is_inline (inode))
+		bytes_read = inline_read (inode, buffer, size, offset);
+	else
+#endif
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -254,85 +825,283 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		/* 쓴 적 없는 sector는 디스크를 읽지 않고 0을 준다. */
+		if (sector_unwritten (inode, sector_idx))
+			memset (buffer + bytes_read, 0, chunk_size);
+		else if (direct && chunk_size == DISK_SECTOR_SIZE) {
+			size_t run = direct_run (inode, sector_idx, offset, size, false);
+
+			bc_read_direct (sector_idx, buffer + bytes_read, run);
+			chunk_size = run * DISK_SECTOR_SIZE;
+		} else
+			/* buffer cache에서 caller의 buffer로 복사한다. */
+			bc_read (sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+	rwlock_release_read (&inode->rw);
 
+	fsstat_add (FSSTAT_BYTES_READ, bytes_read);
+	fsstat_end (FSSTAT_READ, start);
 	return bytes_read;
 }
 
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
+ * Returns the number of bytes actually read, which may be less
+ * than SIZE if an error occurs or end of file is reached. */
+off_t
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) {
+	return read_at (inode, buffer, size, offset, false);
+}
+
+/*** GrilledSalmon ***/
+/* inode_read_at처럼 읽지만, buffer cache에 없는 sector 전체는 캐시에 올리지 않고
+ * 디스크에서 BUFFER로 바로 읽는다. 큰 순차 read가 캐시를 밀어내지 않고 복사도
+ * 한 번 줄인다. 읽는 동안 BUFFER에서 page fault가 나면 안 된다. */
+off_t
+inode_read_direct (struct inode *inode, void *buffer, off_t size, off_t offset) {
+	return read_at (inode, buffer, size, offset, true);
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 OFFSET부터 최대 SECTORS개 sector를 buffer cache에 미리 읽어 두도록
+ * 요청한다. 파일 끝을 넘어서는 읽지 않고, 읽기를 기다리지 않는다. */
+void
+inode_readahead (struct inode *inode, off_t offset, size_t sectors) {
+	off_t length;
+
+	rwlock_acquire_read (&inode->rw);
+	length = inode->mem ? 0 : inode_length (inode);
+#ifdef EFILESYS
+	/* inline 파일은 inode와 함께 이미 읽혀 있다. */
+	if (inode_is_inline (inode))
+		length = 0;
+#endif
+	offset = ROUND_DOWN (offset, DISK_SECTOR_SIZE);
+	for (; sectors > 0 && offset < length; sectors--) {
+		disk_sector_t sector = byte_to_sector (inode, offset);
+
+		if (!sector_unwritten (inode, sector))
+			bc_readahead (sector);
+		offset += DISK_SECTOR_SIZE;
+	}
+	rwlock_release_read (&inode->rw);
+}
+
+#ifndef EFILESYS
+/*** GrilledSalmon ***/
+/* INODE의 written 뒤에 있는 SECTOR에 처음 쓰기 전에 부른다. 그 사이에 건너뛴
+ * sector들은 buffer cache에서 0으로 채우고, SECTOR의 일부만 쓰면(WHOLE이 아니면)
+ * 나머지를 디스크에서 읽지 않도록 SECTOR도 0으로 채운다. written은 inode를
+ * 마지막으로 닫을 때 inode sector와 함께 디스크에 남는다. */
+static void
+sector_begin_write (struct inode *inode, disk_sector_t sector, bool whole) {
+	static char zeros[DISK_SECTOR_SIZE];
+	uint32_t idx = sector - inode->data.start;
+
+	for (uint32_t i = inode->data.written; i < idx; i++)
+		bc_write (inode->data.start + i, zeros, 0, DISK_SECTOR_SIZE);
+	if (!whole)
+		bc_write (sector, zeros, 0, DISK_SECTOR_SIZE);
+	inode->data.written = idx + 1;
+	inode->dirty = true;
+}
+#endif
+
+#ifdef EFILESYS
+/*** GrilledSalmon ***/
+/* 쓴 적 없는 CLST에 처음 쓰기 전에 부른다. buffer cache의 cluster 칸들을 디스크를
+ * 읽지 않고 0으로 채운 뒤 쓴 것으로 표시한다. */
+static void
+cluster_begin_write (cluster_t clst) {
+	static char zeros[DISK_SECTOR_SIZE];
+	disk_sector_t sector = cluster_to_sector (clst);
+
+	for (size_t i = 0; i < fat_cluster_sectors (); i++)
+		bc_write (sector + i, zeros, 0, DISK_SECTOR_SIZE);
+	fat_mark_written (clst);
+}
+
 /*** haein&GrilledSalmon ***/
+/* INODE를 NEW_LENGTH까지 늘린다. inode_create가 길이 L인 파일에 L / CLUSTER_BYTES + 1개
+ * cluster를 주므로, 새로 필요한 cluster만 먼저 연속으로 한 번에 잡아 보고 안 되면
+ * 하나씩 잇는다. 새 cluster는 0으로 채우지 않고 쓴 적 없다고 표시만 한다.
+ * SPECULATIVE면 덧붙이는 쓰기로 보고 다음 쓰기들이 쓸 cluster까지 같은 run으로
+ * 잡아 둔다. 한 번에 cluster 하나씩 잡으면 여러 파일에 번갈아 덧붙일 때 디스크가
+ * 조각나기 때문이다.
+ * 디스크가 모자라면 잡은 cluster까지만 늘리고 false를 리턴한다. */
+/*** GrilledSalmon ***/
+/* inline INODE의 내용을 새 cluster로 옮기고 보통 파일로 바꾼다. */
 static bool
-file_growth(struct inode *inode, off_t new_length) {
+inline_promote (struct inode *inode) {
+	cluster_t clst = fat_create_chain (0);
+
+	if (clst == 0)
+		return false;
+	fat_mark_unwritten (clst, 1);
+	cluster_begin_write (clst);
+	bc_write (cluster_to_sector (clst), inode->data.inline_data, 0,
+			INODE_INLINE_MAX);
+	inode->data.start = cluster_to_sector (clst);
+	inode->data.flags &= ~INODE_INLINE;
+	memset (inode->data.inline_data, 0, INODE_INLINE_MAX);
+	if (fat_extents ()) {
+		inode->data.flags |= INODE_EXTENTS;
+		extent_append (&inode->data, clst, 1);
+	}
+	inode->dirty = true;
+	return true;
+}
+
+/* INODE를 NEW_LENGTH 바이트로 늘린다. SPECULATIVE면 뒤에 cluster를 더 잡아
+ * 둔다. RUN_ONLY면 늘어나는 cluster를 한 번에 이어서 잡지 못할 때 하나씩 잇지
+ * 않고 아무것도 바꾸지 않은 채 false. */
+static bool
+file_growth(struct inode *inode, off_t new_length, bool speculative,
+		bool run_only) {
 	off_t origin_length = inode_length(inode);
-	off_t growth = 0; // 늘어난 크기
-	cluster_t last_clst = sector_to_cluster(byte_to_sector(inode, origin_length));
-	static char zeros[DISK_SECTOR_SIZE];
+	size_t need = new_length / CLUSTER_BYTES - origin_length / CLUSTER_BYTES;
+	size_t kept = inode->reserved;
+	size_t added = 0;
+	cluster_t last_clst;
+	cluster_t clst;
+
+	/* inline으로 담을 수 있으면 길이만 늘린다. 늘어난 부분은 원래 0이다. */
+	if (inode_is_inline (inode)) {
+		if (new_length <= INODE_INLINE_MAX) {
+			inode->data.length = new_length;
+			inode->dirty = true;
+			return true;
+		}
+		if (!inline_promote (inode))
+			return false;
+	}
 
-	/* Update file length */
+	/* Update file length.  덧붙이는 쓰기마다 길이가 바뀌므로 inode sector는
+	 * 닫거나 filesys_sync 할 때 한 번만 쓴다. */
 	inode->data.length = new_length;
+	inode->dirty = true;
 
-	if (origin_length%DISK_SECTOR_SIZE == 0 || ((new_length) > (origin_length - origin_length%DISK_SECTOR_SIZE + DISK_SECTOR_SIZE))) {
-		/* Extend File */
-		while (growth < new_length - origin_length) {
-			last_clst = fat_create_chain(last_clst);
-			if (last_clst == NULL) { /* Creation Fail */
-				if (origin_length%DISK_SECTOR_SIZE == 0) {
-					inode->data.length = origin_length + growth;	
-				} else {
-					inode->data.length = origin_length + growth - growth%DISK_SECTOR_SIZE + DISK_SECTOR_SIZE;
-				}
-				return false;
-			}
-			disk_write (filesys_disk, cluster_to_sector(last_clst), zeros); 
-			growth += DISK_SECTOR_SIZE;
+	/* 미리 잡아 둔 cluster부터 쓴다. */
+	if (need <= inode->reserved) {
+		inode->reserved -= need;
+		return true;
+	}
+	need -= kept;
+	last_clst = nth_cluster (inode, origin_length / CLUSTER_BYTES + kept);
+	inode->reserved = 0;
+
+	/* Extend File */
+	chain_truncate_after (inode, last_clst);
+	if (speculative) {
+		inode->prealloc = inode->prealloc == 0 ? PREALLOC_MIN
+			: inode->prealloc * 2 > PREALLOC_MAX ? PREALLOC_MAX
+			: inode->prealloc * 2;
+		clst = fat_create_run (last_clst, need + inode->prealloc);
+		if (clst != 0) {
+			fat_mark_unwritten (clst, need + inode->prealloc);
+			extent_append (&inode->data, clst, need + inode->prealloc);
+			inode->reserved = inode->prealloc;
+			return true;
 		}
 	}
+	clst = fat_create_run (last_clst, need);
+	if (clst != 0) {
+		fat_mark_unwritten (clst, need);
+		extent_append (&inode->data, clst, need);
+		return true;
+	}
+	if (run_only) {
+		inode->data.length = origin_length;
+		inode->reserved = kept;
+		return false;
+	}
+
+	while (added < need) {
+		chain_truncate_after (inode, last_clst);
+		clst = fat_create_chain (last_clst);
+		if (clst == 0) { /* Creation Fail */
+			inode->data.length = ROUND_DOWN (origin_length, CLUSTER_BYTES)
+				+ (kept + added) * CLUSTER_BYTES;
+			return false;
+		}
+		fat_mark_unwritten (clst, 1);
+		extent_append (&inode->data, clst, 1);
+		last_clst = clst;
+		added++;
+	}
 	return true;
 }
+#endif
+
+/*** GrilledSalmon ***/
+/* INODE의 SECTOR부터 CNT개 sector를 buffer cache를 거치지 않고 통째로 쓰기 전에
+ * 부른다. 그중 쓴 적 없는 것을 쓴 것으로 표시한다. 통째로 덮이는 cluster는 0으로
+ * 채울 필요가 없고, 일부만 덮이는 cluster는 캐시에서 0으로 채운다. */
+static void
+direct_begin_write (struct inode *inode UNUSED, disk_sector_t sector, size_t cnt) {
+#ifdef EFILESYS
+	disk_sector_t end = sector + cnt;
+	unsigned spc = fat_cluster_sectors ();
+
+	while (sector < end) {
+		cluster_t clst = sector_to_cluster (sector);
+		disk_sector_t first = cluster_to_sector (clst);
+
+		if (fat_unwritten (clst)) {
+			if (first == sector && first + spc <= end)
+				fat_mark_written (clst);
+			else
+				cluster_begin_write (clst);
+		}
+		sector = first + spc;
+	}
+#else
+	uint32_t idx = sector - inode->data.start;
+
+	if (sector_unwritten (inode, sector))
+		sector_begin_write (inode, sector, true);
+	if (inode->data.written < idx + cnt) {
+		inode->data.written = idx + cnt;
+		inode->dirty = true;
+	}
+#endif
+}
 
-/*** haein&GrilledSalmon ***/
-/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
- * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
-// 버퍼의 크기 바이트를 inode의 오프셋에서 시작하여 INODE에 씁니다. 
-off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
-		off_t offset) {
+/* inode_write_at과 inode_write_direct가 함께 쓴다. DIRECT면 sector 전체를 덮는
+ * chunk는 buffer cache에 칸을 잡지 않고 BUFFER에서 디스크로 바로 쓰는데,
+ * 디스크에서 이어지는 sector는 한 번에 쓴다. journal로 쓰는 inode는 늘 캐시를
+ * 거친다. */
+static off_t
+write_at (struct inode *inode, const void *buffer_, off_t size, off_t offset,
+		bool direct) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
+	uint64_t start = fsstat_begin ();
 
-	if (inode->deny_write_cnt)
+	rwlock_acquire_write (&inode->rw);
+	if (inode->deny_write_cnt) {
+		rwlock_release_write (&inode->rw);
 		return 0;
+	}
+	if (inode->mem) {
+		bytes_written = mem_write (inode, buffer, size, offset);
+		goto done;
+	}
 
 #ifdef EFILESYS
 	/* File Growth Check */
 	if (offset + size > inode_length(inode)) {
-		file_growth(inode, offset+size);
+		file_growth(inode, offset+size, true, false);
 	}
-#endif
 
+	if (inode_is_inline (inode))
+		bytes_written = inline_write (inode, buffer, size, offset);
+	else
+#endif
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset); // write할 inode의 offset에 대응되는 sector의 인덱스
@@ -348,26 +1117,25 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
+		if (direct && chunk_size == DISK_SECTOR_SIZE && !inode->journaled) {
+			size_t run = direct_run (inode, sector_idx, offset, size, true);
 
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
+			direct_begin_write (inode, sector_idx, run);
+			bc_write_direct (sector_idx, buffer + bytes_written, run);
+			chunk_size = run * DISK_SECTOR_SIZE;
+		} else {
+			if (sector_unwritten (inode, sector_idx))
+#ifdef EFILESYS
+				cluster_begin_write (sector_to_cluster (sector_idx));
+#else
+				sector_begin_write (inode, sector_idx,
+						chunk_size == DISK_SECTOR_SIZE);
+#endif
+			/* buffer cache에 쓴다. sector의 일부만 쓰면 bc_write가 나머지를 먼저 읽어 둔다. */
+			if (inode->journaled)
+				journal_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
+				bc_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 		}
 
 		/* Advance. */
@@ -375,18 +1143,238 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
+done:
+	if (bytes_written > 0)
+		inode->write_gen++;
+	rwlock_release_write (&inode->rw);
 
+	fsstat_add (FSSTAT_BYTES_WRITTEN, bytes_written);
+	fsstat_end (FSSTAT_WRITE, start);
 	return bytes_written;
 }
 
+/*** haein&GrilledSalmon ***/
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+ * Returns the number of bytes actually written, which may be
+ * less than SIZE if end of file is reached or an error occurs.
+ * (Normally a write at end of file would extend the inode, but
+ * growth is not yet implemented.) */
+// 버퍼의 크기 바이트를 inode의 오프셋에서 시작하여 INODE에 씁니다. 
+off_t
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
+		off_t offset) {
+	return write_at (inode, buffer, size, offset, false);
+}
+
+/*** GrilledSalmon ***/
+/* inode_write_at처럼 쓰지만 sector 전체를 덮는 부분은 buffer cache에 올리지 않고
+ * 디스크에 바로 쓴다. 캐시에 있던 sector는 캐시에 써서 맞춘다. 한 번 쓰고 다시
+ * 읽지 않을 큰 쓰기가 캐시를 밀어내지 않는다. 쓰는 동안 BUFFER에서 page fault가
+ * 나면 안 된다. */
+off_t
+inode_write_direct (struct inode *inode, const void *buffer, off_t size,
+		off_t offset) {
+	return write_at (inode, buffer, size, offset, true);
+}
+
+/*** GrilledSalmon ***/
+/* INODE가 적어도 LENGTH 바이트가 되도록 늘리고 늘어난 부분의 cluster를 미리
+ * 잡아 0으로 채운다. 이미 그보다 길면 아무것도 하지 않는다. 쓰기가 막혀 있거나
+ * 디스크가 모자라면 false. */
+bool
+inode_allocate (struct inode *inode, off_t length) {
+	bool success = true;
+
+	rwlock_acquire_write (&inode->rw);
+	if (inode->deny_write_cnt)
+		success = false;
+	else if (length > inode_length (inode)) {
+		if (inode->mem) {
+			/* 늘어난 page는 처음 쓸 때 잡는다. */
+			inode->data.length = length;
+			success = true;
+		} else
+#ifdef EFILESYS
+		success = file_growth (inode, length, false, false);
+#else
+		/* 연속 할당하는 free map에서는 파일을 늘릴 수 없다. */
+		success = false;
+#endif
+		if (success)
+			inode->write_gen++;
+	}
+	rwlock_release_write (&inode->rw);
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* inode_allocate()와 같지만 늘어나는 cluster를 디스크에서 한 번에 이어서 잡을
+ * 수 없으면 늘리지 않고 false. 쓰기 금지는 보지 않는다. 파일을 쓰기 금지해
+ * 두고 sector에 바로 읽고 쓰는 주인(swap file)이 부른다. */
+bool
+inode_allocate_run (struct inode *inode, off_t length) {
+	bool success = true;
+
+	rwlock_acquire_write (&inode->rw);
+	if (length > inode_length (inode)) {
+#ifdef EFILESYS
+		success = !inode->mem && file_growth (inode, length, false, true);
+#else
+		success = false;
+#endif
+		if (success)
+			inode->write_gen++;
+	}
+	rwlock_release_write (&inode->rw);
+	return success;
+}
+
+/* INODE의 OFFSET 바이트가 든 sector를 리턴하고, 그 sector부터 파일 안에서
+ * 디스크에 이어져 있는 sector 수를 *CNT에 담는다. OFFSET이 파일 밖이거나
+ * 내용이 디스크에 따로 있지 않으면 (inline, tmpfs) -1. */
+disk_sector_t
+inode_map (struct inode *inode, off_t offset, size_t *cnt) {
+	size_t total, idx;
+	disk_sector_t sector = -1;
+
+	rwlock_acquire_read (&inode->rw);
+	total = bytes_to_sectors (inode_length (inode));
+	idx = offset / DISK_SECTOR_SIZE;
+	if (offset < 0 || offset >= inode_length (inode) || inode->mem)
+		goto done;
+#ifdef EFILESYS
+	if (inode_is_inline (inode))
+		goto done;
+	{
+		const size_t spc = fat_cluster_sectors ();
+		size_t n = idx / spc;
+		cluster_t clst = nth_cluster (inode, n);
+
+		if (clst == 0)
+			goto done;
+		sector = cluster_to_sector (clst) + idx % spc;
+		*cnt = spc - idx % spc;
+		while (idx + *cnt < total && nth_cluster (inode, ++n) == ++clst)
+			*cnt += spc;
+	}
+#else
+	sector = inode->data.start + idx;
+	*cnt = total - idx;
+#endif
+	if (idx + *cnt > total)
+		*cnt = total - idx;
+done:
+	rwlock_release_read (&inode->rw);
+	return sector;
+}
+
+#ifdef EFILESYS
+/*** GrilledSalmon ***/
+/* SECTOR의 inode를 아무도 열고 있지 않고 data cluster chain이 여러 조각이면
+ * 연속된 cluster로 옮긴다. 내용은 bc_write_direct로 새 cluster에 먼저 쓰고,
+ * FAT과 inode의 바뀐 start는 한 transaction 안에서 바꾸므로 도중에 죽어도 옛
+ * chain이나 새 chain 중 하나가 온전히 남는다. 옮기는 동안 inode를 열어 rw를
+ * 잡고 있으므로 그 사이에 연 쪽은 옮기기가 끝난 뒤에 읽고 쓴다. 옮겼으면 true. */
+bool
+inode_relocate (disk_sector_t sector) {
+	const size_t spc = fat_cluster_sectors ();
+	struct inode *inode;
+	cluster_t old_start, first, clst, prev;
+	size_t cnt = 0, frags = 0;
+	uint8_t *bounce = NULL;
+	bool moved = false;
+
+	inode = inode_open (sector);
+	if (inode == NULL)
+		return false;
+	lock_acquire (&open_inodes_lock);
+	if (inode->open_cnt > 1) {
+		lock_release (&open_inodes_lock);
+		inode_close (inode);
+		return false;
+	}
+	lock_release (&open_inodes_lock);
+
+	/* 이제부터 연 쪽은 rw에서 기다린다. */
+	rwlock_acquire_write (&inode->rw);
+	if (inode->removed || inode->journaled || inode->data.magic != INODE_MAGIC
+			|| inode_is_inline (inode))
+		goto done;
+
+	/* chain의 길이와 조각 수를 센다. */
+	old_start = sector_to_cluster (inode->data.start);
+	for (prev = 0, clst = old_start; clst != EOChain && clst != 0;
+			prev = clst, clst = fat_get (clst)) {
+		if (prev == 0 || clst != prev + 1)
+			frags++;
+		cnt++;
+	}
+	if (frags <= 1)
+		goto done;
+
+	first = fat_create_run (0, cnt);
+	if (first == 0)
+		goto done;
+	bounce = palloc_get_page (0);
+	if (bounce == NULL) {
+		fat_remove_chain (first, 0);
+		goto done;
+	}
+
+	journal_begin ();
+	clst = old_start;
+	for (size_t i = 0; i < cnt; i++, clst = fat_get (clst)) {
+		disk_sector_t from = cluster_to_sector (clst);
+		disk_sector_t to = cluster_to_sector (first + i);
+
+		if (fat_unwritten (clst)) {
+			fat_mark_unwritten (first + i, 1);
+			continue;
+		}
+		for (size_t copied = 0; copied < spc; ) {
+			size_t run = spc - copied;
+
+			if (run > PGSIZE / DISK_SECTOR_SIZE)
+				run = PGSIZE / DISK_SECTOR_SIZE;
+			bc_read_direct (from + copied, bounce, run);
+			bc_write_direct (to + copied, bounce, run);
+			copied += run;
+		}
+	}
+	fat_remove_chain (old_start, 0);
+	inode->data.start = cluster_to_sector (first);
+	if (inode->data.flags & INODE_EXTENTS) {
+		inode->data.extent_cnt = 1;
+		inode->data.extents[0] = (struct extent) {
+			.logical = 0, .start = first, .cnt = cnt };
+	}
+	lock_acquire (&inode->chain_lock);
+	free (inode->chain);
+	inode->chain = NULL;
+	inode->chain_len = inode->chain_cap = 0;
+	lock_release (&inode->chain_lock);
+	inode->dirty = true;
+	inode_write_back (inode);
+	journal_end ();
+	moved = true;
+
+done:
+	palloc_free_page (bounce);
+	rwlock_release_write (&inode->rw);
+	inode_close (inode);
+	return moved;
+}
+#endif
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_acquire_write (&inode->rw);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write (&inode->rw);
 }
 
 /* Re-enables writes to INODE.
@@ -394,9 +1382,11 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_acquire_write (&inode->rw);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write (&inode->rw);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -404,3 +1394,20 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/*** GrilledSalmon ***/
+/* INODE에 붙은 디렉터리 이름 색인의 자리를 리턴한다. 색인은 inode가 메모리에
+ * 있는 동안 유지되고 마지막 inode_close에서 dir_index_destroy로 해제된다. */
+struct dir_index **
+inode_dir_index (struct inode *inode) {
+	return &inode->dir_index;
+}
+
+/*** GrilledSalmon ***/
+/* INODE의 page cache 색인 자리를 리턴한다. page_cache.c가 frame을 처음 넣을 때
+ * 만들고 마지막 frame이 빠질 때 해제한다. frame이 있는 동안은 그 page들이 파일을
+ * 열어 두고 있으므로 inode도 메모리에 있다. */
+struct page_index **
+inode_page_index (struct inode *inode) {
+	return &inode->page_index;
+}
@@ -0,0 +1,210 @@
+/* journal.c: Ordered metadata journal for the FAT file system. */
+
+#include "filesys/journal.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "filesys/fat.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/csum.h"
+#include "threads/synch.h"
+
+/*** GrilledSalmon ***/
+/* FAT sector, inode sector, 디렉터리 내용처럼 어긋나면 파일 시스템이 깨지는
+ * sector는 journal_write로 쓴다. 이 sector들은 buffer cache에 붙잡혀 있다가
+ * commit에서 (1) 일반 data를 디스크에 쓰고 (2) log 칸에 복사한 뒤 (3) header에
+ * sector 목록을 써서 commit을 확정하고 (4) 제자리에 쓴 다음 (5) header를 비운다.
+ * (3) 전에 죽으면 옛 상태가, 뒤에 죽으면 fat_open의 journal_recover가 log를
+ * 다시 써서 새 상태가 남는다.
+ *
+ * 디스크의 write cache가 켜져 있으면 쓰기가 끝나도 표면에 남았다는 보장이
+ * 없고 순서도 바뀔 수 있다. 그래서 (3), (4), (5) 앞에서 disk_flush로 앞의
+ * 쓰기를 내린다. commit 사이의 쓰기는 cache 속도로 끝난다. */
+
+/* Identifies a committed journal header. */
+#define JOURNAL_MAGIC 0x4a524e4c
+
+/* 한 transaction에 담을 수 있는 최대 sector 수. */
+#define JOURNAL_MAX (JOURNAL_SECTORS - 1)
+
+/* On-disk journal header, the first sector of the journal.
+ * Must be exactly DISK_SECTOR_SIZE bytes long. */
+struct journal_header {
+	uint32_t magic;                     /* JOURNAL_MAGIC이면 commit 된 것. */
+	uint32_t cnt;                       /* log 칸에 든 sector 수. */
+	disk_sector_t sectors[JOURNAL_MAX]; /* i번째 log 칸이 쓰일 제자리. */
+	uint8_t unused[DISK_SECTOR_SIZE - 8 - 4 * JOURNAL_MAX];
+};
+
+static disk_sector_t log_start;         /* header sector. 0이면 journal 없음. */
+static size_t log_max;                  /* 이번 마운트의 transaction 크기. */
+
+/* 지금 transaction. journal_lock이 보호한다. */
+static struct journal_header running;
+static struct lock journal_lock;
+static struct condition journal_idle;   /* 진행 중인 작업이 없거나 commit이 끝났다. */
+static int outstanding;                 /* journal_begin 하고 아직 안 끝낸 작업 수. */
+static bool committing;
+
+static uint8_t bounce[DISK_SECTOR_SIZE];
+
+/*** GrilledSalmon ***/
+/* log 칸 전체를 한 번의 disk 명령으로 옮길 때 쓴다. */
+static uint8_t log_bounce[JOURNAL_MAX * DISK_SECTOR_SIZE];
+
+static void commit (void);
+
+/* Initializes the journal to the SECTORS sectors starting at START.
+ * SECTORS가 0이면 journal 없이 옛날처럼 바로 buffer cache에 쓴다. */
+void
+journal_init (disk_sector_t start, size_t sectors) {
+	ASSERT (sizeof running == DISK_SECTOR_SIZE);
+
+	lock_init (&journal_lock);
+	cond_init (&journal_idle);
+	outstanding = 0;
+	committing = false;
+	running.cnt = 0;
+
+	/* 붙잡힌 sector가 buffer cache의 절반을 넘지 않게 한다. */
+	log_start = sectors > 1 ? start : 0;
+	log_max = sectors > 1 ? sectors - 1 : 0;
+	if (log_max > JOURNAL_MAX)
+		log_max = JOURNAL_MAX;
+	if (log_max > bc_sectors / 2)
+		log_max = bc_sectors / 2;
+	if (log_max == 0)
+		log_start = 0;
+}
+
+/* 새로 포맷한 journal을 비워 둔다. */
+void
+journal_format (void) {
+	if (log_start != 0) {
+		memset (bounce, 0, sizeof bounce);
+		disk_write (filesys_disk, log_start, bounce);
+	}
+}
+
+/* commit은 되었지만 제자리에 다 쓰지 못한 transaction을 다시 쓴다. 다른 것이
+ * 디스크를 읽기 전에, 마운트할 때 한 번 부른다. */
+void
+journal_recover (void) {
+	static struct journal_header header;
+
+	if (log_start == 0)
+		return;
+	disk_read (filesys_disk, log_start, &header);
+	if (header.magic != JOURNAL_MAGIC || header.cnt > JOURNAL_MAX)
+		return;
+	if (header.cnt > 0)
+		disk_read_multiple (filesys_disk, log_start + 1, log_bounce, header.cnt);
+	for (uint32_t i = 0; i < header.cnt; i++) {
+		csum_update (header.sectors[i], log_bounce + i * DISK_SECTOR_SIZE);
+		disk_write (filesys_disk, header.sectors[i],
+				log_bounce + i * DISK_SECTOR_SIZE);
+	}
+	csum_flush ();
+	disk_flush (filesys_disk);
+	journal_format ();
+}
+
+/* 함께 디스크에 남아야 하는 변경 묶음을 시작한다. 묶음이 끝날 때까지 commit은
+ * 기다리므로, 묶음 안에서 다시 journal_begin 하면 안 된다. */
+void
+journal_begin (void) {
+	lock_acquire (&journal_lock);
+	while (committing)
+		cond_wait (&journal_idle, &journal_lock);
+	outstanding++;
+	lock_release (&journal_lock);
+}
+
+/* journal_begin으로 시작한 묶음을 끝낸다. */
+void
+journal_end (void) {
+	lock_acquire (&journal_lock);
+	ASSERT (outstanding > 0);
+	if (--outstanding == 0)
+		cond_broadcast (&journal_idle, &journal_lock);
+	lock_release (&journal_lock);
+}
+
+/* BUFFER의 SIZE 바이트를 metadata sector SECTOR의 OFS부터 쓴다. 디스크의
+ * 제자리에는 commit 된 다음에야 쓰인다. transaction이 가득 찼으면 먼저
+ * 지금까지의 것을 commit 한다. */
+void
+journal_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size) {
+	uint32_t i;
+
+	if (log_start == 0) {
+		bc_write (sector, buffer, ofs, size);
+		return;
+	}
+
+	lock_acquire (&journal_lock);
+	for (i = 0; i < running.cnt; i++)
+		if (running.sectors[i] == sector)
+			break;
+	if (i == running.cnt) {
+		if (running.cnt == log_max)
+			commit ();
+		running.sectors[running.cnt++] = sector;
+	}
+	bc_write_held (sector, buffer, ofs, size);
+	lock_release (&journal_lock);
+}
+
+/* 진행 중인 묶음이 끝나기를 기다렸다가 바뀐 FAT과 지금 transaction을 commit
+ * 하고 dirty data를 디스크에 쓴다. 여러 작업의 변경이 한 번에 commit 된다. */
+void
+journal_commit (void) {
+	lock_acquire (&journal_lock);
+	while (committing)
+		cond_wait (&journal_idle, &journal_lock);
+	committing = true;
+	while (outstanding > 0)
+		cond_wait (&journal_idle, &journal_lock);
+	lock_release (&journal_lock);
+
+#ifdef EFILESYS
+	/* fat_flush가 journal_write를 부르므로 journal_lock 없이 부른다. */
+	fat_flush ();
+#endif
+
+	lock_acquire (&journal_lock);
+	commit ();
+	committing = false;
+	cond_broadcast (&journal_idle, &journal_lock);
+	lock_release (&journal_lock);
+}
+
+/* 지금 transaction을 디스크에 쓴다. journal_lock을 잡고 불러야 한다. */
+static void
+commit (void) {
+	uint32_t i;
+
+	/* Ordered: metadata가 가리킬 data를 먼저 쓴다. 붙잡힌 sector는 건너뛴다. */
+	bc_flush ();
+	if (running.cnt == 0) {
+		disk_flush (filesys_disk);
+		return;
+	}
+
+	for (i = 0; i < running.cnt; i++)
+		bc_read (running.sectors[i], log_bounce + i * DISK_SECTOR_SIZE, 0,
+				DISK_SECTOR_SIZE);
+	disk_write_multiple (filesys_disk, log_start + 1, log_bounce, running.cnt);
+	disk_flush (filesys_disk);
+	running.magic = JOURNAL_MAGIC;
+	disk_write (filesys_disk, log_start, &running);
+	disk_flush (filesys_disk);
+
+	for (i = 0; i < running.cnt; i++)
+		bc_checkpoint (running.sectors[i]);
+	disk_flush (filesys_disk);
+	journal_format ();
+	running.cnt = 0;
+}
@@ -1,6 +1,17 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
 #include "vm/vm.h"
+#include "filesys/page_cache.h"
+#include "filesys/inode.h"
+#include "lib/kernel/radix.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "threads/thread.h"
+#include "threads/synch.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+#include <stdio.h>
+#include <string.h>
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
@@ -13,38 +24,386 @@ static const struct page_operations page_cache_op = {
 	.type = VM_PAGE_CACHE,
 };
 
-tid_t page_cache_workerd;
+static void page_cache_kworkerd (void *aux);
+
+static struct work flush_work;
+
+/*** GrilledSalmon ***/
+/* page_cache_kworkerd가 dirty page를 찾아 쓰는 주기와 한 번에 쓰는 최대 frame 수. */
+#define FLUSH_INTERVAL TIMER_FREQ
+#define FLUSH_BATCH 16
 
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	/* page_cache_kworkerd는 FLUSH_INTERVAL마다 work queue에서 돈다. */
+	work_init (&flush_work, page_cache_kworkerd, NULL);
+	work_queue_delayed (&flush_work, WQ_NORMAL, FLUSH_INTERVAL);
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED, void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
-
+	page->va = NULL;
+	page->frame = NULL;
+	page->writable = false;
+	page->page_cache.base = 0;
+	page->page_cache.valid = 0;
+	return true;
 }
 
 /* Utilze the Swap in mechanism to implement readhead */
+/* 담은 sector는 모두 디스크와 같아서 evict 되면 버린다. 다시 읽어 들이는 일은 없다. */
 static bool
-page_cache_readahead (struct page *page, void *kva) {
+page_cache_readahead (struct page *page UNUSED, void *kva UNUSED) {
+	return false;
+}
+
+#ifdef VM
+/*** GrilledSalmon ***/
+/* buffer cache가 내준 sector를 담은 page들. base sector로 찾는다. buffer cache는
+ * dirty 칸을 디스크에 쓴 다음에야 내주므로 여기 있는 sector는 모두 clean이다.
+ * buffer cache가 같은 sector의 칸을 다시 만들 때 내용을 가져가면서 여기서 뺀다.
+ * 그래서 한 sector는 두 곳 중 한 곳에만 있다. 비게 된 page는 frame을 그대로 두고
+ * pc_empty에 넣었다가 다음 group에 다시 쓴다. pc_lock이 pc_groups, pc_empty와
+ * 각 page의 page_cache를 보호한다. buffer cache는 bc_lock을 잡은 채 부르고,
+ * pc_lock을 잡고 frame_lock을 잡는다. */
+#define PC_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+static struct lock pc_lock;
+static struct hash pc_groups;
+static struct list pc_empty;
+static bool pc_ready;           /* vm_init이 frame을 줄 준비를 마쳤다. */
+
+/* 통계. pc_lock이 보호한다. */
+static size_t pc_frames, pc_stored, pc_hits, pc_dropped;
+
+static uint64_t
+pc_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct page, page_cache.elem)->page_cache.base);
+}
+
+static bool
+pc_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+	return hash_entry (a, struct page, page_cache.elem)->page_cache.base
+		< hash_entry (b, struct page, page_cache.elem)->page_cache.base;
+}
+
+/* BASE의 page. 없으면 NULL. pc_lock을 잡고 불러야 한다. */
+static struct page *
+pc_lookup (disk_sector_t base) {
+	struct page key;
+	struct hash_elem *e;
+
+	key.page_cache.base = base;
+	e = hash_find (&pc_groups, &key.page_cache.elem);
+	return e != NULL ? hash_entry (e, struct page, page_cache.elem) : NULL;
+}
+
+void
+page_cache_sector_init (void) {
+	lock_init (&pc_lock);
+	if (!hash_init (&pc_groups, pc_hash, pc_less, NULL))
+		PANIC ("page cache allocation failed");
+	list_init (&pc_empty);
+	pc_ready = true;
+}
+
+/* SECTOR가 있으면 BUFFER에 복사하고 여기서 빼고 true를 리턴한다. BUFFER가
+ * NULL이면 복사하지 않고 버리기만 한다. */
+bool
+page_cache_sector_take (disk_sector_t sector, void *buffer) {
+	disk_sector_t base = sector - sector % PC_SECTORS;
+	unsigned bit = 1u << (sector % PC_SECTORS);
+	struct page *page;
+	bool found = false;
+
+	if (!pc_ready)
+		return false;
+	lock_acquire (&pc_lock);
+	page = pc_lookup (base);
+	if (page != NULL && (page->page_cache.valid & bit)) {
+		if (buffer != NULL)
+			memcpy (buffer, page->frame->kva + (sector - base) * DISK_SECTOR_SIZE,
+					DISK_SECTOR_SIZE);
+		page->page_cache.valid &= ~bit;
+		if (page->page_cache.valid == 0) {
+			hash_delete (&pc_groups, &page->page_cache.elem);
+			list_push_back (&pc_empty, &page->page_cache.empty_elem);
+		}
+		if (buffer != NULL)
+			pc_hits++;
+		found = true;
+	}
+	lock_release (&pc_lock);
+	return found;
+}
+
+/* buffer cache가 내준 clean SECTOR의 내용 BUFFER를 담아 둔다. 담을 page가 없고
+ * 유저 풀에도 빈 page가 없으면 버린다. bc_lock을 잡고 있을 수 있어서 evict 하지
+ * 않는다. */
+void
+page_cache_sector_put (disk_sector_t sector, const void *buffer) {
+	disk_sector_t base = sector - sector % PC_SECTORS;
+	struct page *page;
+
+	if (!pc_ready)
+		return;
+	lock_acquire (&pc_lock);
+	page = pc_lookup (base);
+	if (page == NULL && !list_empty (&pc_empty))
+		page = list_entry (list_pop_front (&pc_empty), struct page, page_cache.empty_elem);
+	else if (page == NULL) {
+		page = kmem_cache_alloc (vm_page_cache);
+		if (page != NULL) {
+			page_cache_initializer (page, VM_PAGE_CACHE, NULL);
+			if (vm_cache_frame_get (page))
+				pc_frames++;
+			else {
+				kmem_cache_free (vm_page_cache, page);
+				page = NULL;
+			}
+		}
+	}
+	if (page == NULL) {
+		pc_dropped++;
+		lock_release (&pc_lock);
+		return;
+	}
+	if (page->page_cache.valid == 0) {
+		page->page_cache.base = base;
+		hash_insert (&pc_groups, &page->page_cache.elem);
+	}
+	memcpy (page->frame->kva + (sector - base) * DISK_SECTOR_SIZE, buffer,
+			DISK_SECTOR_SIZE);
+	page->page_cache.valid |= 1u << (sector - base);
+	pc_stored++;
+	lock_release (&pc_lock);
 }
 
+/* Prints page cache statistics. */
+void
+page_cache_print_stats (void) {
+	if (pc_ready && pc_stored > 0)
+		printf ("Page cache: %zu frames, %zu sectors stored, %zu hits, %zu dropped\n",
+				pc_frames, pc_stored, pc_hits, pc_dropped);
+}
+#endif
+
 /* Utilze the Swap out mechanism to implement writeback */
+/* clock이 고른 PAGE를 pc_groups나 pc_empty에서 뺀다. 담은 sector는 clean이라 쓸
+ * 것이 없다. 이 뒤로는 아무도 frame을 읽지 않고, PAGE는 vm_evict_batch가 해제한다. */
 static bool
-page_cache_writeback (struct page *page) {
+page_cache_writeback (struct page *page UNUSED) {
+#ifdef VM
+	lock_acquire (&pc_lock);
+	if (page->page_cache.valid != 0)
+		hash_delete (&pc_groups, &page->page_cache.elem);
+	else
+		list_remove (&page->page_cache.empty_elem);
+	page->page_cache.valid = 0;
+	pc_frames--;
+	lock_release (&pc_lock);
+#endif
+	return true;
 }
 
 /* Destory the page_cache. */
+/* page_cache_writeback이 이미 떼어 두었다. */
 static void
-page_cache_destroy (struct page *page) {
+page_cache_destroy (struct page *page UNUSED) {
 }
 
+#ifdef VM
+/*** GrilledSalmon ***/
+/* 디스크에서 A가 B보다 앞에 있으면 true. inode 번호가 곧 그 파일이 놓인 곳이고
+ * 파일 안에서는 offset 순이다. */
+static bool
+flush_before (const struct frame *a, const struct frame *b) {
+	disk_sector_t sa = inode_get_inumber (a->inode);
+	disk_sector_t sb = inode_get_inumber (b->inode);
+
+	return sa != sb ? sa < sb : a->file_ofs < b->file_ofs;
+}
+#endif
+
 /* Worker thread for page cache */
+/* mmap 한 파일의 dirty page를 주기적으로 미리 파일에 써 둔다. 그러면 munmap과
+ * exit의 file_backed_destroy, eviction은 대부분 clean page만 만나서 바로 끝나고,
+ * 디스크에는 sector 순으로 모아서 쓰인다. 한 번에 FLUSH_BATCH개를 다 채웠으면
+ * 더 남았을 수 있으니 쉬지 않고 이어서 쓴다. */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+#ifdef VM
+	struct frame *frames[FLUSH_BATCH];
+	size_t cnt, i, j;
+
+	do {
+		cnt = vm_flush_pick (frames, FLUSH_BATCH);
+		for (i = 1; i < cnt; i++) {
+			struct frame *frame = frames[i];
+
+			for (j = i; j > 0 && flush_before (frame, frames[j - 1]); j--)
+				frames[j] = frames[j - 1];
+			frames[j] = frame;
+		}
+		for (i = 0; i < cnt; i++)
+			inode_write_at (frames[i]->inode, frames[i]->kva,
+					frames[i]->file_bytes, frames[i]->file_ofs);
+		vm_flush_done (frames, cnt);
+	} while (cnt == FLUSH_BATCH);
+#endif
+	work_queue_delayed (&flush_work, WQ_NORMAL, FLUSH_INTERVAL);
+}
+
+/*** GrilledSalmon ***/
+/* mmap 한 파일 하나의 page가 있는 frame들. page 번호(file_ofs / PGSIZE)로 찾는
+ * radix tree이고 inode_page_index에 달려 있다. frame_lock이 보호한다. frame은
+ * 처음 읽을 때 들어오고, evict 되거나 마지막 page가 떠나서 해제될 때 빠진다.
+ * frame이 하나도 없으면 index도 해제한다. */
+struct page_index {
+	struct inode *inode;
+	struct radix_tree frames;
+	struct list_elem elem;          /* page_indexes */
+};
+
+/* frame의 tag. DIRTY는 쓸 수 있게 매핑된 적이 있어서 고쳐졌을 수 있는 frame이고,
+ * 그런 매핑이 다 없어진 뒤 write-back daemon이 clean인 것을 보면 지운다.
+ * WRITEBACK은 daemon이 파일에 쓰는 중인 frame이다. */
+#define TAG_DIRTY 0
+#define TAG_WRITEBACK 1
+
+/* frame이 있는 page_index들. */
+static struct list page_indexes;
+
+/* page_cache_next_dirty가 다음에 볼 index와 그 안의 page 번호. NULL이면
+ * page_indexes의 처음부터 본다. */
+static struct list_elem *flush_cursor;
+static uint64_t flush_pos;
+
+void
+page_cache_share_init (void) {
+	list_init (&page_indexes);
+	flush_cursor = NULL;
+}
+
+/* FRAME이 있는 page_index. */
+static struct page_index *
+frame_index_of (struct frame *frame) {
+	ASSERT (frame->inode != NULL);
+	return *inode_page_index (frame->inode);
+}
+
+/* OFS가 있는 page의 번호. */
+static uint64_t
+page_no (off_t ofs) {
+	ASSERT (ofs % PGSIZE == 0);
+	return ofs / PGSIZE;
+}
+
+/* INODE의 OFS부터를 담은 frame을 리턴한다. 없으면 NULL이다. */
+struct frame *
+page_cache_lookup (struct inode *inode, off_t ofs) {
+	struct page_index *pi = *inode_page_index (inode);
+
+	return pi != NULL ? radix_lookup (&pi->frames, page_no (ofs)) : NULL;
+}
+
+/* 비어 있는 PI를 해제한다. */
+static void
+page_index_free (struct page_index *pi) {
+	ASSERT (radix_empty (&pi->frames));
+
+	if (flush_cursor == &pi->elem) {
+		flush_cursor = list_next (flush_cursor);
+		flush_pos = 0;
+	}
+	list_remove (&pi->elem);
+	*inode_page_index (pi->inode) = NULL;
+	radix_destroy (&pi->frames);
+	free (pi);
+}
+
+/* FRAME의 inode, file_ofs 위치로 FRAME을 넣는다. 이미 같은 위치의 frame이
+ * 있거나 메모리가 모자라면 넣지 않고 false를 리턴한다. */
+bool
+page_cache_insert (struct frame *frame) {
+	struct page_index **pip = inode_page_index (frame->inode);
+	struct page_index *pi = *pip;
+
+	if (pi == NULL) {
+		pi = malloc (sizeof *pi);
+		if (pi == NULL)
+			return false;
+		pi->inode = frame->inode;
+		radix_init (&pi->frames);
+		list_push_back (&page_indexes, &pi->elem);
+		*pip = pi;
+	}
+	if (radix_insert (&pi->frames, page_no (frame->file_ofs), frame))
+		return true;
+	if (radix_empty (&pi->frames))
+		page_index_free (pi);
+	return false;
+}
+
+/* FRAME을 빼고 inode를 NULL로 만든다. */
+void
+page_cache_remove (struct frame *frame) {
+	struct page_index *pi = frame_index_of (frame);
+
+	radix_delete (&pi->frames, page_no (frame->file_ofs));
+	if (radix_empty (&pi->frames))
+		page_index_free (pi);
+	frame->inode = NULL;
+}
+
+/* page cache에 있는 FRAME을 쓸 수 있게 매핑했다. */
+void
+page_cache_mark_dirty (struct frame *frame) {
+	radix_tag_set (&frame_index_of (frame)->frames, page_no (frame->file_ofs), TAG_DIRTY);
+}
+
+/* FRAME이 clean이고 더는 쓸 수 있게 매핑되어 있지 않다. */
+void
+page_cache_clear_dirty (struct frame *frame) {
+	radix_tag_clear (&frame_index_of (frame)->frames, page_no (frame->file_ofs), TAG_DIRTY);
+}
+
+/* FRAME을 파일에 쓰기 시작하거나(WRITEBACK이 true) 다 썼다. */
+void
+page_cache_set_writeback (struct frame *frame, bool writeback) {
+	struct radix_tree *frames = &frame_index_of (frame)->frames;
+	uint64_t no = page_no (frame->file_ofs);
+
+	if (writeback)
+		radix_tag_set (frames, no, TAG_WRITEBACK);
+	else
+		radix_tag_clear (frames, no, TAG_WRITEBACK);
+}
+
+/* DIRTY tag가 있는 frame을 하나씩 리턴한다. 지난번에 리턴한 것 다음부터 inode
+ * 순, 그 안에서는 offset 순으로 훑고, 끝까지 다 보면 NULL을 한 번 리턴한 뒤
+ * 처음으로 돌아간다. tag가 없는 page는 tree를 내려가지 않고 건너뛴다. */
+struct frame *
+page_cache_next_dirty (void) {
+	struct list_elem *e = flush_cursor != NULL ? flush_cursor : list_begin (&page_indexes);
+
+	for (; e != list_end (&page_indexes); e = list_next (e)) {
+		struct page_index *pi = list_entry (e, struct page_index, elem);
+		void *frame;
+		uint64_t no;
+
+		flush_cursor = e;
+		if (radix_gang_lookup (&pi->frames, flush_pos, &frame, &no, 1, TAG_DIRTY) == 1) {
+			flush_pos = no + 1;
+			return frame;
+		}
+		flush_pos = 0;
+	}
+	flush_cursor = NULL;
+	flush_pos = 0;
+	return NULL;
 }
@@ -0,0 +1,256 @@
+/* procfs.c: Read-only files made from kernel statistics. */
+
+#include "filesys/procfs.h"
+#include <console.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/disk.h"
+#include "devices/kbd.h"
+#include "devices/timer.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/fsstat.h"
+#include "filesys/inode.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/rcu.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vmalloc.h"
+#include "threads/workqueue.h"
+#ifdef USERPROG
+#include "userprog/exception.h"
+#include "userprog/sysprof.h"
+#endif
+#ifdef VM
+#include "filesys/page_cache.h"
+#include "vm/anon.h"
+#include "vm/vm.h"
+#include "vm/zswap.h"
+#endif
+
+/*** GrilledSalmon ***/
+/* PROCFS_PREFIX 아래의 파일들. 열 때마다 그 순간의 커널 통계로 내용을 만들어
+ * inode_create_mem의 inode에 담아 주므로, 돌고 있는 workload를 끄지 않고도
+ * 보통의 open, read로 볼 수 있다. 새 값을 보려면 다시 연다. 내용은 꺼질 때
+ * 찍던 *_print_stats()의 출력을 console_capture로 받은 것이라 형식이 같다.
+ *
+ *   stat, meminfo, diskstats, locks, syscalls, vmstat   시스템 전체.
+ *   PID/stat, self/stat                                스레드 하나.
+ *
+ * 파일은 쓸 수 없고 만들거나 지울 수도 없다. 디렉터리로 읽을 수는 없다. */
+
+/* procfs inode 번호의 시작. 디스크 sector, tmpfs 번호와 겹치지 않는다. */
+#define PROCFS_INUMBER_BASE 0x50000000
+
+/* 파일 하나의 최대 크기. 넘치는 출력은 버린다. */
+#define PROCFS_BUF_SIZE (16 * 1024)
+
+struct procfs_file {
+	const char *name;
+	void (*show) (void);
+};
+
+static void show_stat (void);
+static void show_meminfo (void);
+static void show_diskstats (void);
+#ifdef VM
+static void show_vmstat (void);
+#endif
+
+static const struct procfs_file procfs_files[] = {
+	{ "stat", show_stat },
+	{ "meminfo", show_meminfo },
+	{ "diskstats", show_diskstats },
+	{ "locks", lockstat_print },
+#ifdef USERPROG
+	{ "syscalls", sysprof_print },
+#endif
+#ifdef VM
+	{ "vmstat", show_vmstat },
+#endif
+};
+#define PROCFS_FILE_CNT (sizeof procfs_files / sizeof *procfs_files)
+
+/* console capture는 한 번에 하나뿐이므로 파일을 하나씩 만든다. */
+static struct lock procfs_lock;
+static char *procfs_buf;
+static disk_sector_t next_inumber;
+
+/* Initializes procfs. */
+void
+procfs_init (void) {
+	lock_init (&procfs_lock);
+	next_inumber = PROCFS_INUMBER_BASE;
+}
+
+/* PATH가 PROCFS_PREFIX 아래의 이름이면 그 이름을, 아니면 NULL을 리턴한다. */
+const char *
+procfs_name (const char *path) {
+	size_t len = strlen (PROCFS_PREFIX);
+
+	if (strlen (path) < len || memcmp (path, PROCFS_PREFIX, len) != 0)
+		return NULL;
+	return path + len;
+}
+
+static void
+show_stat (void) {
+	timer_print_stats ();
+	thread_print_stats ();
+	workqueue_print_stats ();
+	rcu_print_stats ();
+	intr_print_stats ();
+	console_print_stats ();
+	kbd_print_stats ();
+}
+
+static void
+show_meminfo (void) {
+	palloc_print_stats ();
+	pml4_print_stats ();
+	malloc_print_stats ();
+	vmalloc_print_stats ();
+	kmem_print_stats ();
+	mem_tag_print_stats ();
+}
+
+static void
+show_diskstats (void) {
+	disk_print_stats ();
+	bc_print_stats ();
+	fsstat_print ();
+}
+
+#ifdef VM
+static void
+show_vmstat (void) {
+	exception_print_stats ();
+	anon_print_stats ();
+	zswap_print_stats ();
+	ksm_print_stats ();
+	kswapd_print_stats ();
+	page_cache_print_stats ();
+}
+#endif
+
+static const char *
+status_name (enum thread_status status) {
+	switch (status) {
+		case THREAD_RUNNING: return "running";
+		case THREAD_READY: return "ready";
+		case THREAD_BLOCKED: return "blocked";
+		default: return "dying";
+	}
+}
+
+/* "PID/stat"이나 "self/stat"의 PID를 리턴한다. 아니면 TID_ERROR. */
+static tid_t
+parse_pid_stat (const char *name) {
+	tid_t pid = 0;
+	const char *p;
+
+	if (!strcmp (name, "self/stat"))
+		return thread_tid ();
+	for (p = name; *p >= '0' && *p <= '9'; p++) {
+		if (pid > 100000000)
+			return TID_ERROR;
+		pid = pid * 10 + (*p - '0');
+	}
+	if (p == name || strcmp (p, "/stat"))
+		return TID_ERROR;
+	return pid;
+}
+
+/* PID인 스레드의 통계를 출력한다. 끝났거나 없는 스레드면 false. 스레드가
+ * 출력하는 사이에 끝날 수 있으므로 인터럽트를 끄고 먼저 복사해 둔다. */
+static bool
+show_pid_stat (tid_t pid) {
+	struct thread_schedstat sched;
+	struct rusage ru;
+	enum thread_status status;
+	enum intr_level old_level;
+	char name[sizeof ((struct thread *) 0)->name];
+	struct thread *t;
+	int priority;
+
+	old_level = intr_disable ();
+	t = thread_find (pid);
+	if (t != NULL) {
+		strlcpy (name, t->name, sizeof name);
+		status = t->status;
+		priority = t->priority;
+		sched = t->sched;
+		ru = t->rusage;
+	}
+	intr_set_level (old_level);
+	if (t == NULL)
+		return false;
+
+	printf ("pid %d\nname %s\nstate %s\npriority %d\n",
+			pid, name, status_name (status), priority);
+	printf ("voluntary_switches %ld\ninvoluntary_switches %ld\n"
+			"wakeups %ld\nwakeup_cycles %llu\nready_cycles %llu\n",
+			sched.nvcsw, sched.nivcsw, sched.wakeups,
+			(unsigned long long) sched.wakeup_cycles,
+			(unsigned long long) sched.ready_cycles);
+	printf ("minflt %ld\nmajflt %ld\nnevict %ld\nnstack %ld\n"
+			"inblock %ld\noublock %ld\nrchar %lld\nwchar %lld\n",
+			ru.minflt, ru.majflt, ru.nevict, ru.nstack,
+			ru.inblock, ru.oublock, ru.rchar, ru.wchar);
+	return true;
+}
+
+/* NAME의 내용을 procfs_buf에 만들고 길이를 리턴한다. 없는 이름이면 -1.
+ * procfs_lock을 잡고 불러야 한다. */
+static off_t
+generate (const char *name) {
+	const struct procfs_file *f;
+	tid_t pid = TID_ERROR;
+	size_t len;
+	bool found;
+
+	for (f = procfs_files; f < procfs_files + PROCFS_FILE_CNT; f++)
+		if (!strcmp (name, f->name))
+			break;
+	if (f == procfs_files + PROCFS_FILE_CNT
+			&& (pid = parse_pid_stat (name)) == TID_ERROR)
+		return -1;
+
+	console_capture (procfs_buf, PROCFS_BUF_SIZE);
+	if (f < procfs_files + PROCFS_FILE_CNT) {
+		f->show ();
+		found = true;
+	} else
+		found = show_pid_stat (pid);
+	len = console_capture_end ();
+	return found ? (off_t) len : -1;
+}
+
+/* 파일 NAME의 지금 내용을 담은 inode를 열어 리턴한다. 내용은 닫으면
+ * 사라진다. 없는 이름이거나 메모리가 모자라면 NULL. */
+struct inode *
+procfs_open (const char *name) {
+	struct inode *inode = NULL;
+	off_t len;
+
+	lock_acquire (&procfs_lock);
+	if (procfs_buf == NULL)
+		procfs_buf = malloc (PROCFS_BUF_SIZE);
+	if (procfs_buf == NULL)
+		goto done;
+	len = generate (name);
+	if (len < 0)
+		goto done;
+	inode = inode_create_mem (next_inumber++);
+	if (inode != NULL && inode_write_at (inode, procfs_buf, len, 0) != len) {
+		inode_close (inode);
+		inode = NULL;
+	}
+
+done:
+	lock_release (&procfs_lock);
+	return inode;
+}
@@ -4,5 +4,12 @@ filesys_SRC += filesys/free-map.c	# Free sector bitmap.
 filesys_SRC += filesys/file.c		# Files.
 filesys_SRC += filesys/directory.c	# Directories.
 filesys_SRC += filesys/inode.c		# File headers.
+filesys_SRC += filesys/buffer_cache.c	# Sector buffer cache.
+filesys_SRC += filesys/dcache.c		# Directory name cache.
+filesys_SRC += filesys/tmpfs.c		# In-memory scratch files.
+filesys_SRC += filesys/procfs.c		# Kernel statistics files.
+filesys_SRC += filesys/journal.c	# Metadata journal.
+filesys_SRC += filesys/csum.c		# Sector checksums.
+filesys_SRC += filesys/fsstat.c		# I/O statistics.
 filesys_SRC += filesys/fsutil.c		# Utilities.
 filesys_SRC += filesys/page_cache.c		# Page cache.
@@ -0,0 +1,140 @@
+/* tmpfs.c: In-memory file system for scratch files. */
+
+#include "filesys/tmpfs.h"
+#include <hash.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/*** GrilledSalmon ***/
+/* TMPFS_PREFIX 아래의 파일들. 내용은 inode_create_mem으로 만든 inode의 커널
+ * page에 있어서 cluster를 잡지도, 디스크에 쓰지도 않는다. tmpfs가 파일마다
+ * inode를 하나씩 열어 두고 지울 때 닫으므로, 지운 뒤에도 열고 있던 쪽은
+ * 마지막으로 닫을 때까지 계속 쓸 수 있다. 재부팅하면 모두 사라진다. */
+struct tmpfs_entry {
+	struct hash_elem elem;
+	char name[NAME_MAX + 1];
+	struct inode *inode;
+};
+
+/* tmpfs inode 번호의 시작. 디스크 sector 번호와 겹치지 않는다. */
+#define TMPFS_INUMBER_BASE 0x40000000
+
+static struct hash tmpfs_files;
+static struct lock tmpfs_lock;
+static disk_sector_t next_inumber;
+
+static uint64_t
+tmpfs_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_string (hash_entry (e, struct tmpfs_entry, elem)->name);
+}
+
+static bool
+tmpfs_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return strcmp (hash_entry (a, struct tmpfs_entry, elem)->name,
+			hash_entry (b, struct tmpfs_entry, elem)->name) < 0;
+}
+
+/* Initializes tmpfs. */
+void
+tmpfs_init (void) {
+	if (!hash_init (&tmpfs_files, tmpfs_hash, tmpfs_less, NULL))
+		PANIC ("tmpfs allocation failed");
+	lock_init (&tmpfs_lock);
+	next_inumber = TMPFS_INUMBER_BASE;
+}
+
+/* PATH가 TMPFS_PREFIX 아래의 이름이면 그 이름을, 아니면 NULL을 리턴한다. */
+const char *
+tmpfs_name (const char *path) {
+	size_t len = strlen (TMPFS_PREFIX);
+
+	if (strlen (path) < len || memcmp (path, TMPFS_PREFIX, len) != 0)
+		return NULL;
+	return path + len;
+}
+
+/* NAME의 항목을 찾는다. tmpfs_lock을 잡고 불러야 한다. */
+static struct tmpfs_entry *
+tmpfs_find (const char *name) {
+	struct tmpfs_entry key;
+	struct hash_elem *e;
+
+	if (strlen (name) > NAME_MAX)
+		return NULL;
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&tmpfs_files, &key.elem);
+	return e != NULL ? hash_entry (e, struct tmpfs_entry, elem) : NULL;
+}
+
+/* INITIAL_SIZE 바이트의 파일 NAME을 만든다. 늘어난 부분은 처음 쓸 때까지
+ * 메모리를 쓰지 않는다. 이미 있거나 이름이 잘못되었거나 메모리가 없으면 false. */
+bool
+tmpfs_create (const char *name, off_t initial_size) {
+	struct tmpfs_entry *te;
+	bool success = false;
+
+	if (*name == '\0' || strlen (name) > NAME_MAX || strchr (name, '/'))
+		return false;
+
+	lock_acquire (&tmpfs_lock);
+	if (tmpfs_find (name) != NULL)
+		goto done;
+	te = malloc (sizeof *te);
+	if (te == NULL)
+		goto done;
+	te->inode = inode_create_mem (next_inumber);
+	if (te->inode == NULL) {
+		free (te);
+		goto done;
+	}
+	if (initial_size > 0 && !inode_allocate (te->inode, initial_size)) {
+		inode_close (te->inode);
+		free (te);
+		goto done;
+	}
+	next_inumber++;
+	strlcpy (te->name, name, sizeof te->name);
+	hash_insert (&tmpfs_files, &te->elem);
+	success = true;
+
+done:
+	lock_release (&tmpfs_lock);
+	return success;
+}
+
+/* 파일 NAME의 inode를 열어 리턴한다. 없으면 NULL. */
+struct inode *
+tmpfs_open (const char *name) {
+	struct tmpfs_entry *te;
+	struct inode *inode = NULL;
+
+	lock_acquire (&tmpfs_lock);
+	te = tmpfs_find (name);
+	if (te != NULL)
+		inode = inode_reopen (te->inode);
+	lock_release (&tmpfs_lock);
+	return inode;
+}
+
+/* 파일 NAME을 지운다. 내용은 마지막으로 연 쪽이 닫을 때 사라진다. 없으면 false. */
+bool
+tmpfs_remove (const char *name) {
+	struct tmpfs_entry *te;
+
+	lock_acquire (&tmpfs_lock);
+	te = tmpfs_find (name);
+	if (te != NULL)
+		hash_delete (&tmpfs_files, &te->elem);
+	lock_release (&tmpfs_lock);
+
+	if (te == NULL)
+		return false;
+	inode_remove (te->inode);
+	inode_close (te->inode);
+	free (te);
+	return true;
+}
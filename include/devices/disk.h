@@ -2,6 +2,9 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -11,6 +14,10 @@
  * Good enough for disks up to 2 TB. */
 typedef uint32_t disk_sector_t;
 
+/* Most sectors a single disk_read_multiple() or
+ * disk_write_multiple() can transfer. */
+#define DISK_MAX_SECTORS 256
+
 /* Format specifier for printf(), e.g.:
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
@@ -19,9 +26,43 @@ void disk_init (void);
 void disk_print_stats (void);
 
 struct disk *disk_get (int chan_no, int dev_no);
+void disk_get_stats (struct disk *, long long *read_cnt, long long *write_cnt);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_read_multiple (struct disk *, disk_sector_t, void *, size_t);
+void disk_write_multiple (struct disk *, disk_sector_t, const void *, size_t);
+void disk_flush (struct disk *);
+
+/*** GrilledSalmon ***/
+/* 비동기 디스크 요청. disk_submit으로 채널의 큐에 넣으면 인터럽트
+ * 처리기가 차례로 디스크에 보내고, 끝나면 bottom half 스레드가 done을
+ * 부른다 (threads/workqueue.c). done은 다른 요청의 완료를 기다리며 잠들면
+ * 안 된다. */
+struct disk_request;
+typedef void disk_done_func (struct disk_request *);
+
+struct disk_request {
+	struct list_elem elem;      /* 채널 큐의 원소. */
+	struct disk *disk;          /* 대상 디스크. */
+	disk_sector_t sector;       /* 첫 sector. */
+	void *buffer;               /* cnt * DISK_SECTOR_SIZE 바이트, 커널 주소. */
+	size_t cnt;                 /* 1 이상 DISK_MAX_SECTORS 이하. */
+	bool write;                 /* true면 쓰기. */
+	disk_done_func *done;       /* 완료 callback. */
+	void *aux;                  /* done에 넘길 값. */
+	int64_t submitted;          /* disk_submit 한 tick. */
+	uint64_t submit_tsc;        /* disk_submit 한 TSC. 통계에 쓴다. */
+	int priority;               /* 보낸 스레드의 (donation을 받은) 우선순위. */
+	bool flush;                 /* 데이터 없이 write cache를 내린다. disk_flush가 쓴다. */
+};
+
+void disk_request_init (struct disk_request *, struct disk *, disk_sector_t,
+		void *buffer, size_t cnt, bool write, disk_done_func *, void *aux);
+void disk_submit (struct disk_request *);
+void disk_request_complete (struct disk_request *);
+bool disk_set_scheduler (const char *name);
+bool disk_set_ramdisk (const char *spec);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
@@ -2,11 +2,16 @@
 #define DEVICES_INPUT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
+size_t input_read (uint8_t *, size_t);
 bool input_full (void);
+struct wait_entry;
+struct semaphore;
+bool input_poll (struct wait_entry *, struct semaphore *);
 
 #endif /* devices/input.h */
@@ -1,36 +1,39 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
+#include <stddef.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
-/* 인터럽트 큐는 커널 스레드와 외부 인터럽트 핸들러 간에 공유되는 circular 버퍼이다.
-  인터럽트 큐 함수는 커널 스레드 또는 외부 인터럽트 핸들러에서 호출할 수 있다.
-   intq_init()를 제외하고, 인터럽트는 두 경우 모두 해제되어 있어야 합니다.
-   인터럽트 큐는 "monitor"의 구조이다.
-   threads/synch.h의 잠금 및 조건 변수는 이 경우에 사용할 수 없는데,
-   인터럽트 핸들러로부터가 아니라, 커널 스레드로부터만 보호할 수 있기 때문 */
+/*** GrilledSalmon ***/
+/* 인터럽트 큐는 외부 인터럽트 핸들러가 넣고 커널 스레드가 꺼내는 single-producer,
+   single-consumer circular 버퍼이다. head는 넣는 쪽만, tail은 꺼내는 쪽만 쓰고
+   서로의 값은 acquire로 읽고 release로 쓰므로, 바이트를 넣고 꺼낼 때 인터럽트를
+   끌 필요가 없다. 꺼내는 스레드가 여럿이면 lock으로 한 번에 하나만 꺼낸다.
+   큐가 비어 있을 때만 인터럽트를 끄고 잠든다.
+   넣는 쪽은 인터럽트를 끄고 부르며 큐가 가득 차 있으면 안 된다. */
 
-/* Queue buffer size, in bytes. */
+/* Queue buffer size, in bytes.  Must be a power of 2. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
 struct intq {
 	/* Waiting threads. */
-	struct lock lock;           /* Only one thread may wait at once. */
-	struct thread *not_full;    /* Thread waiting for not-full condition. */
+	struct lock lock;           /* Only one thread may consume at once. */
 	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
+	struct wait_queue pollers;  /* poll 중인 스레드. 바이트가 들어오면 깨운다. */
 
-	/* Queue. */
+	/* Queue.  head와 tail은 계속 늘고, head - tail 바이트가 들어 있다. */
 	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
-	int head;                   /* New data is written here. */
-	int tail;                   /* Old data is read here. */
+	unsigned head;              /* New data is written here.  Producer only. */
+	unsigned tail;              /* Old data is read here.  Consumer only. */
 };
 
 void intq_init (struct intq *);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
+size_t intq_read (struct intq *, uint8_t *, size_t, bool *was_full);
 void intq_putc (struct intq *, uint8_t);
 
 #endif /* devices/intq.h */
@@ -0,0 +1,11 @@
+#ifndef DEVICES_PCI_H
+#define DEVICES_PCI_H
+
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* PCI configuration space 접근 (configuration mechanism #1). */
+uint32_t pci_read_config (int bus, int dev, int func, int reg);
+void pci_write_config (int bus, int dev, int func, int reg, uint32_t value);
+
+#endif /* devices/pci.h */
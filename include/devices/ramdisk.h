@@ -0,0 +1,19 @@
+#ifndef DEVICES_RAMDISK_H
+#define DEVICES_RAMDISK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+
+/*** GrilledSalmon ***/
+/* 메모리에 담는 디스크. disk.c가 -ramdisk로 고른 자리에 붙인다. */
+struct ramdisk;
+
+/* 크기를 정하지 않으면 그 자리에 원래 디스크가 없을 때 이만큼 잡는다 (MB). */
+#define RAMDISK_DEFAULT_MB 4
+
+struct ramdisk *ramdisk_create (disk_sector_t capacity);
+void ramdisk_transfer (struct ramdisk *, disk_sector_t, void *buffer,
+		size_t cnt, bool write);
+
+#endif /* devices/ramdisk.h */
@@ -7,6 +7,9 @@
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Loops per second from the "-loops=N" option, or 0 to measure. */
+extern unsigned timer_loops_per_sec;
+
 void timer_init (void);
 void timer_calibrate (void);
 
@@ -18,6 +21,16 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+void timer_udelay (int64_t microseconds);
+void timer_ndelay (int64_t nanoseconds);
+
 void timer_print_stats (void);
 
+uint64_t timer_nanos (void);
+uint64_t timer_cycles_to_nanos (uint64_t cycles);
+void *timer_clock_page (void);
+
+void timer_idle (void);
+void timer_wake (void);
+
 #endif /* devices/timer.h */
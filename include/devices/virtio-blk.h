@@ -0,0 +1,21 @@
+#ifndef DEVICES_VIRTIO_BLK_H
+#define DEVICES_VIRTIO_BLK_H
+
+#include "devices/disk.h"
+
+/*** GrilledSalmon ***/
+/* Legacy virtio PCI 블록 장치. disk.c가 찾아서 struct disk 자리에 붙이고,
+ * 그 disk로 들어온 요청을 넘긴다. 끝난 요청은 인터럽트 처리기 안에서
+ * disk_request_complete로 돌려준다. */
+struct virtio_blk;
+
+/* utils/pintos --virtio는 fs, scratch, swap 디스크를 PCI slot
+ * VIRTIO_BLK_SLOT_BASE부터 차례로 꽂는다. */
+#define VIRTIO_BLK_SLOT_BASE 0x10
+
+struct virtio_blk *virtio_blk_probe (void);
+int virtio_blk_pci_slot (const struct virtio_blk *);
+disk_sector_t virtio_blk_capacity (const struct virtio_blk *);
+void virtio_blk_submit (struct virtio_blk *, struct disk_request *);
+
+#endif /* devices/virtio-blk.h */
@@ -0,0 +1,33 @@
+#ifndef FILESYS_BUFFER_CACHE_H
+#define FILESYS_BUFFER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* 기본 buffer cache 크기 (sector 수). -bc=N으로 바꾼다. */
+#define BC_DEFAULT_SECTORS 64
+
+/* 순차 읽기에서 미리 읽어 둘 sector 수. */
+#define BC_READAHEAD_SECTORS 8
+
+/* 이보다 큰 read는 buffer cache를 거치지 않고 유저 버퍼로 바로 읽는다. */
+#define BC_DIRECT_MIN (16 * DISK_SECTOR_SIZE)
+
+extern size_t bc_sectors;
+
+void bc_init (void);
+bool bc_set_policy (const char *name);
+void bc_read (disk_sector_t sector, void *buffer, size_t ofs, size_t size);
+void bc_write (disk_sector_t sector, const void *buffer, size_t ofs, size_t size);
+void bc_write_held (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size);
+void bc_checkpoint (disk_sector_t sector);
+void bc_read_direct (disk_sector_t sector, void *buffer, size_t cnt);
+void bc_write_direct (disk_sector_t sector, const void *buffer, size_t cnt);
+void bc_flush (void);
+void bc_readahead (disk_sector_t sector);
+void bc_get_stats (size_t *hits, size_t *misses, size_t *readahead);
+void bc_print_stats (void);
+
+#endif /* filesys/buffer_cache.h */
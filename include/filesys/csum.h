@@ -0,0 +1,22 @@
+#ifndef FILESYS_CSUM_H
+#define FILESYS_CSUM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "devices/disk.h"
+
+/* checksum sector 하나에 드는 sector별 checksum 수. */
+#define CSUM_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (uint32_t))
+
+/* true면 sector checksum 영역을 잡아 포맷한다. -csum으로 켠다. */
+extern bool csum_format_enabled;
+
+void csum_init (disk_sector_t start, size_t sectors);
+void csum_format (void);
+bool csum_verify (disk_sector_t, const void *data);
+void csum_update (disk_sector_t, const void *data);
+void csum_flush (void);
+void csum_print_stats (void);
+
+#endif /* filesys/csum.h */
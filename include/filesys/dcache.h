@@ -0,0 +1,27 @@
+#ifndef FILESYS_DCACHE_H
+#define FILESYS_DCACHE_H
+
+#include <stdbool.h>
+#include "devices/disk.h"
+
+struct inode;
+
+/* 이름 cache에 담아 둘 최대 항목 수. */
+#define DCACHE_MAX 256
+
+/* dcache_open의 결과. */
+enum dcache_result {
+	DCACHE_MISS,                /* 모른다. 디렉터리를 찾아봐야 한다. */
+	DCACHE_HIT,                 /* 있다. inode를 열었다. */
+	DCACHE_NEGATIVE,            /* 없다는 것을 안다. */
+};
+
+void dcache_init (void);
+enum dcache_result dcache_open (disk_sector_t parent, const char *name,
+		struct inode **inode);
+void dcache_insert (disk_sector_t parent, const char *name,
+		disk_sector_t child);
+void dcache_insert_negative (disk_sector_t parent, const char *name);
+void dcache_purge (disk_sector_t parent);
+
+#endif /* filesys/dcache.h */
@@ -14,25 +14,41 @@ typedef uint32_t cluster_t;  /* Index of a cluster within FAT. */
 #define EOChain 0x0FFFFFFF   /* End of cluster chain */
 
 /* Sectors of FAT information. */
-#define SECTORS_PER_CLUSTER 1 /* Number of sectors per cluster */
+#define SECTORS_PER_CLUSTER 1 /* Default number of sectors per cluster */
+#define SECTORS_PER_CLUSTER_MAX 16 /* Largest cluster -cluster=N accepts */
 #define FAT_BOOT_SECTOR 0     /* FAT boot sector. */
 #define ROOT_DIR_CLUSTER 1    /* Cluster for the root directory */
 
+/* 포맷할 때 쓸 cluster 크기 (sector 수). -cluster=N으로 바꾼다. */
+extern unsigned int fat_format_cluster_sectors;
+
+/* true면 inode가 cluster를 extent로 찾도록 포맷한다. -extents로 켠다. */
+extern bool fat_format_extents;
+
 void fat_init (void);
 void fat_open (void);
 void fat_close (void);
 void fat_create (void);
-void fat_close (void);
+void fat_flush (void);
 
 cluster_t fat_create_chain (
     cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
 );
+cluster_t fat_create_run (
+    cluster_t clst, /* Cluster # to stretch, 0: Create a new chain */
+    size_t cnt      /* Number of contiguous clusters to add */
+);
 void fat_remove_chain (
     cluster_t clst, /* Cluster # to be removed */
     cluster_t pclst /* Previous cluster of clst, 0: clst is the start of chain */
 );
 cluster_t fat_get (cluster_t clst);
 void fat_put (cluster_t clst, cluster_t val);
+void fat_mark_unwritten (cluster_t clst, size_t cnt);
+void fat_mark_written (cluster_t clst);
+bool fat_unwritten (cluster_t clst);
+unsigned int fat_cluster_sectors (void);
+bool fat_extents (void);
 disk_sector_t cluster_to_sector (cluster_t clst);
 cluster_t sector_to_cluster (disk_sector_t sector); /*** GrilledSalmon ***/
 
@@ -4,32 +4,52 @@
 #include "filesys/off_t.h"
 
 struct inode;
+struct pipe;
+struct shm_seg;
+struct ipc_chan;
 
 struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
-	int dupCount;               /* dupCount 가 0일때만 파일 종료 */
-#ifdef VM		/*** GrilledSalmon ***/
-	int copying_child;		/* 파일을 복사하고 있는 자식의 tid */
-	struct file *child_file;	/* 자식이 복사해 만든 파일의 포인터 */
-	int *child_remain_cnt; 		/* 자식이 복사해 만든 remain_cnt 포인터 */
-#endif
+	int ref_cnt;                /* fd, 실행 파일 참조 수. 0이 되면 파일 종료 */
+	int owner;                  /* pos를 그대로 옮겨도 되는 스레드의 tid. fork로
+	                               같이 쓰게 되면 0 */
+	off_t ra_next;              /* 직전 file_read가 끝난 위치. 여기서 읽으면 순차 읽기 */
+	bool direct;                /* O_DIRECT로 열었다. sector 단위 read, write는
+	                               buffer cache를 거치지 않는다 */
+	bool dir;                   /* 디렉터리를 열었다. getdents로만 읽고 쓸 수
+	                               없다 */
+	struct pipe *pipe;          /* pipe의 한쪽 끝이면 그 pipe. inode는 NULL */
+	bool pipe_write;            /* pipe의 쓰는 쪽이다 */
+	struct shm_seg *shm;        /* shm_create로 만든 segment. inode는 NULL */
+	struct ipc_chan *chan;      /* chan_create로 만든 channel. inode는 NULL */
 };
 
 
+void file_init (void);
+
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_share (struct file *);
+struct file *file_open_pipe (struct pipe *, bool write_end);
+struct file *file_open_shm (struct shm_seg *);
+struct file *file_open_chan (struct ipc_chan *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
 
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
+off_t file_read_direct (struct file *, void *, off_t);
 off_t file_write (struct file *, const void *, off_t);
+off_t file_write_direct (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+bool file_allocate (struct file *, off_t length);
+off_t file_copy_range (struct file *src, off_t src_ofs,
+		struct file *dst, off_t dst_ofs, off_t size);
 
 /* Preventing writes. */
 void file_deny_write (struct file *);
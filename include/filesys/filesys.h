@@ -8,13 +8,22 @@
 #define FREE_MAP_SECTOR 0       /* Free map file inode sector. */
 #define ROOT_DIR_SECTOR 1       /* Root directory file inode sector. */
 
+struct inode;
+struct stat;
+
 /* Disk used for file system. */
 extern struct disk *filesys_disk;
 
+/* Run the background defragmenter (-defrag). */
+extern bool filesys_defrag;
+
 void filesys_init (bool format);
 void filesys_done (void);
 bool filesys_create (const char *name, off_t initial_size);
 struct file *filesys_open (const char *name);
 bool filesys_remove (const char *name);
+bool filesys_stat (const char *name, struct stat *);
+void filesys_stat_inode (struct inode *, struct stat *);
+void filesys_sync (void);
 
 #endif /* filesys/filesys.h */
@@ -0,0 +1,24 @@
+#ifndef FILESYS_FSSTAT_H
+#define FILESYS_FSSTAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <syscall-nr.h>
+
+/* fsstat_add로 세는 값. struct fsstat의 같은 이름 항목이 된다. */
+enum fsstat_counter {
+	FSSTAT_BYTES_READ,
+	FSSTAT_BYTES_WRITTEN,
+	FSSTAT_CHAIN_LOOKUPS,
+	FSSTAT_CHAIN_STEPS,
+	FSSTAT_CLUSTERS_ALLOCATED,
+	FSSTAT_COUNTERS
+};
+
+uint64_t fsstat_begin (void);
+void fsstat_end (enum fsstat_op, uint64_t start);
+void fsstat_add (enum fsstat_counter, long n);
+void fsstat_get (struct fsstat *);
+void fsstat_print (void);
+
+#endif /* filesys/fsstat.h */
@@ -6,18 +6,35 @@
 #include "devices/disk.h"
 
 struct bitmap;
+struct dir_index;
+struct page_index;
 
 void inode_init (void);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
+struct inode *inode_open_checked (disk_sector_t);
+struct inode *inode_create_mem (disk_sector_t inumber);
 struct inode *inode_reopen (struct inode *);
 disk_sector_t inode_get_inumber (const struct inode *);
+void inode_set_journaled (struct inode *);
 void inode_close (struct inode *);
+void inode_flush (void);
 void inode_remove (struct inode *);
+bool inode_is_removed (const struct inode *);
+unsigned inode_write_gen (const struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
+off_t inode_read_direct (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_write_direct (struct inode *, const void *, off_t size, off_t offset);
+void inode_readahead (struct inode *, off_t offset, size_t sectors);
+bool inode_allocate (struct inode *, off_t length);
+bool inode_allocate_run (struct inode *, off_t length);
+disk_sector_t inode_map (struct inode *, off_t offset, size_t *cnt);
+bool inode_relocate (disk_sector_t);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+struct dir_index **inode_dir_index (struct inode *);
+struct page_index **inode_page_index (struct inode *);
 
 #endif /* filesys/inode.h */
@@ -0,0 +1,19 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* 포맷할 때 journal에 잡아 둘 sector 수. header 한 개와 log 칸들이다. */
+#define JOURNAL_SECTORS 33
+
+void journal_init (disk_sector_t start, size_t sectors);
+void journal_format (void);
+void journal_recover (void);
+void journal_begin (void);
+void journal_end (void);
+void journal_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size);
+void journal_commit (void);
+
+#endif /* filesys/journal.h */
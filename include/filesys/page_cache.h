@@ -1,12 +1,47 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <hash.h>
+#include <list.h>
+#include "devices/disk.h"
 
 struct page;
 enum vm_type;
 
-struct page_cache {};
+/*** GrilledSalmon ***/
+/* buffer cache에서 밀려난 sector들을 담는 VM_PAGE_CACHE page. frame 하나에
+ * BASE부터 PGSIZE / DISK_SECTOR_SIZE개의 sector가 들어간다. */
+struct page_cache {
+	disk_sector_t base;             /* 첫 sector. 그 수의 배수다. */
+	uint8_t valid;                  /* bit I: BASE + I의 내용이 있다. */
+	struct hash_elem elem;          /* valid가 0이 아니면 pc_groups에 있다. */
+	struct list_elem empty_elem;    /* valid가 0이면 pc_empty에 있다. */
+};
+
+/* struct page가 위의 struct page_cache를 담으므로 그 뒤에 넣는다. */
+#include "vm/vm.h"
 
-void page_cache_init (void);
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+
+/*** GrilledSalmon ***/
+/* buffer cache의 두 번째 단. 유저 풀의 빈 frame에 clean sector를 담아 두고,
+ * 메모리가 모자라면 clock이 다른 유저 frame과 함께 골라 버린다. */
+void page_cache_sector_init (void);
+bool page_cache_sector_take (disk_sector_t sector, void *buffer);
+void page_cache_sector_put (disk_sector_t sector, const void *buffer);
+void page_cache_print_stats (void);
+
+/*** GrilledSalmon ***/
+/* mmap 한 파일의 page를 담은 frame들. 같은 파일 위치를 mmap 한 프로세스들이
+ * 한 frame을 같이 쓴다. frame_lock을 잡고 불러야 한다. */
+struct frame;
+struct inode;
+void page_cache_share_init (void);
+struct frame *page_cache_lookup (struct inode *inode, off_t ofs);
+bool page_cache_insert (struct frame *frame);
+void page_cache_remove (struct frame *frame);
+void page_cache_mark_dirty (struct frame *frame);
+void page_cache_clear_dirty (struct frame *frame);
+void page_cache_set_writeback (struct frame *frame, bool writeback);
+struct frame *page_cache_next_dirty (void);
 #endif
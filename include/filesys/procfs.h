@@ -0,0 +1,14 @@
+#ifndef FILESYS_PROCFS_H
+#define FILESYS_PROCFS_H
+
+struct inode;
+
+/*** GrilledSalmon ***/
+/* 이 경로 아래의 이름은 커널 통계로 만드는 읽기 전용 procfs가 맡는다. */
+#define PROCFS_PREFIX "/proc/"
+
+void procfs_init (void);
+const char *procfs_name (const char *path);
+struct inode *procfs_open (const char *name);
+
+#endif /* filesys/procfs.h */
@@ -0,0 +1,19 @@
+#ifndef FILESYS_TMPFS_H
+#define FILESYS_TMPFS_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/*** GrilledSalmon ***/
+/* 이 경로 아래의 이름은 디스크가 아니라 메모리에 있는 tmpfs가 맡는다. */
+#define TMPFS_PREFIX "/tmp/"
+
+void tmpfs_init (void);
+const char *tmpfs_name (const char *path);
+bool tmpfs_create (const char *name, off_t initial_size);
+struct inode *tmpfs_open (const char *name);
+bool tmpfs_remove (const char *name);
+
+#endif /* filesys/tmpfs.h */
@@ -0,0 +1,12 @@
+#ifndef __LIB_CRC32C_H
+#define __LIB_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* CRC32C (Castagnoli). 처음에는 CRC를 0으로 넘기고, 나눠서 계산할 때는 앞
+ * 조각의 결과를 넘긴다. */
+uint32_t crc32c (uint32_t crc, const void *, size_t);
+
+#endif /* lib/crc32c.h */
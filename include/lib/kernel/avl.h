@@ -0,0 +1,71 @@
+#ifndef __LIB_KERNEL_AVL_H
+#define __LIB_KERNEL_AVL_H
+
+/* Intrusive AVL tree.
+ *
+ * Like the lists in list.h, this tree does not allocate memory.
+ * Each structure that may be placed in a tree embeds a struct
+ * avl_elem member, and avl_entry() converts a struct avl_elem
+ * back into the structure that contains it.
+ *
+ * The tree is ordered by a LESS function supplied at
+ * initialization time and holds at most one element of each key.
+ * Its height stays within 1.44 lg n, so avl_insert(),
+ * avl_remove(), avl_find() and avl_floor() take O(lg n) time.
+ * avl_first() and avl_next() walk the elements in ascending
+ * order. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct avl_elem {
+	struct avl_elem *parent;    /* Parent, or null for the root. */
+	struct avl_elem *left;      /* Smaller elements. */
+	struct avl_elem *right;     /* Larger elements. */
+	int height;                 /* Height of the subtree rooted here. */
+};
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool avl_less_func (const struct avl_elem *a,
+                            const struct avl_elem *b,
+                            void *aux);
+
+/* Tree. */
+struct avl {
+	struct avl_elem *root;      /* Root element, or null if empty. */
+	size_t size;                /* Number of elements. */
+	avl_less_func *less;        /* Ordering function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to tree element AVL_ELEM into a pointer to
+   the structure that AVL_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the tree element. */
+#define avl_entry(AVL_ELEM, STRUCT, MEMBER)             \
+	((STRUCT *) ((uint8_t *) &(AVL_ELEM)->parent    \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+void avl_init (struct avl *, avl_less_func *, void *aux);
+
+/* Insertion and removal. */
+struct avl_elem *avl_insert (struct avl *, struct avl_elem *);
+void avl_remove (struct avl *, struct avl_elem *);
+
+/* Search. */
+struct avl_elem *avl_find (const struct avl *, const struct avl_elem *);
+struct avl_elem *avl_floor (const struct avl *, const struct avl_elem *);
+
+/* Traversal. */
+struct avl_elem *avl_first (const struct avl *);
+struct avl_elem *avl_next (struct avl_elem *);
+
+/* Tree properties. */
+size_t avl_size (const struct avl *);
+bool avl_empty (const struct avl *);
+
+#endif /* lib/kernel/avl.h */
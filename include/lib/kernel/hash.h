@@ -96,5 +96,7 @@ bool hash_empty (struct hash *);
 uint64_t hash_bytes (const void *, size_t);
 uint64_t hash_string (const char *);
 uint64_t hash_int (int);
+uint64_t hash_u64 (uint64_t);
+uint64_t hash_ptr (const void *);
 
 #endif /* lib/kernel/hash.h */
@@ -0,0 +1,72 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Intrusive pairing heap.
+ *
+ * Like the lists in list.h, this heap does not allocate memory.
+ * Each structure that may be placed in a heap embeds a struct
+ * heap_elem member, and heap_entry() converts a struct heap_elem
+ * back into the structure that contains it.
+ *
+ * The heap is ordered by a LESS function supplied at
+ * initialization time: heap_top() returns an element E such that
+ * LESS (X, E) is false for every other element X.  In other words
+ * it is a min-heap with respect to LESS; pass a "greater than"
+ * function to get a max-heap.
+ *
+ * heap_push() takes O(1) time, heap_pop() and heap_remove() take
+ * O(lg n) amortized time.  When the key of an element changes,
+ * call heap_update() to restore the heap order, or heap_decrease()
+ * in O(1) time if the element only moved toward the top.  The heap is not
+ * stable: if FIFO order among equal keys matters, break ties in
+ * LESS (for example with a sequence number). */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *next;     /* Right sibling. */
+	struct heap_elem *prev;     /* Left sibling, or parent if leftmost. */
+};
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should come out of the
+   heap before B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Top element, or null if empty. */
+	size_t size;                /* Number of elements. */
+	heap_less_func *less;       /* Ordering function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+		- offsetof (STRUCT, MEMBER.child)))
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+void heap_decrease (struct heap *, struct heap_elem *);
+
+/* Heap properties. */
+struct heap_elem *heap_top (struct heap *);
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,113 @@
+#ifndef __LIB_KERNEL_OHASH_H
+#define __LIB_KERNEL_OHASH_H
+
+/* Open-addressing hash table.
+ *
+ * An alternative to hash.h for tables that are searched far more
+ * often than they change.  Instead of an array of chain lists,
+ * the table keeps two arrays of the same power-of-2 length: one
+ * byte of control data per slot and one element pointer per slot.
+ * A control byte is either EMPTY, DELETED, or the low 7 bits of
+ * the hash of the element in that slot.  A search walks the
+ * control bytes linearly from the slot chosen by the rest of the
+ * hash and only follows the pointers whose byte matches, so most
+ * misses never touch an element at all.
+ *
+ * Like hash.h, the table does not allocate its elements: each
+ * structure that may be placed in a table embeds a struct
+ * ohash_elem member, and ohash_entry() converts a struct
+ * ohash_elem back into the structure that contains it.  The
+ * element caches its hash so that growing the table never calls
+ * the hash function again.  Elements are compared with an
+ * equality function rather than a less-than function.
+ *
+ * Growing or shrinking does not stop to move every element at
+ * once.  The table allocates the new slot array and keeps the old
+ * one next to it; each insertion or deletion then moves a batch
+ * of old slots across, and searches look in both arrays until the
+ * old one is empty and freed.  ohash_reserve() sizes a table up
+ * front for callers that know how many elements are coming. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hash table element. */
+struct ohash_elem {
+	uint64_t hash;              /* Hash of this element, set on insertion. */
+};
+
+/* Converts pointer to hash element OHASH_ELEM into a pointer to
+   the structure that OHASH_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the hash element. */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)                 \
+	((STRUCT *) ((uint8_t *) &(OHASH_ELEM)->hash            \
+		- offsetof (STRUCT, MEMBER.hash)))
+
+/* Computes and returns the hash value for hash element E, given
+   auxiliary data AUX. */
+typedef uint64_t ohash_hash_func (const struct ohash_elem *e, void *aux);
+
+/* Returns true if hash elements A and B have the same key, given
+   auxiliary data AUX. */
+typedef bool ohash_eq_func (const struct ohash_elem *a,
+                            const struct ohash_elem *b,
+                            void *aux);
+
+/* Performs some operation on hash element E, given auxiliary
+   data AUX. */
+typedef void ohash_action_func (struct ohash_elem *e, void *aux);
+
+/* One array of slots. */
+struct ohash_table {
+	size_t slot_cnt;            /* Number of slots, a power of 2, or 0. */
+	uint8_t *ctrl;              /* Array of `slot_cnt' control bytes. */
+	struct ohash_elem **slots;  /* Array of `slot_cnt' elements. */
+};
+
+/* Hash table. */
+struct ohash {
+	size_t elem_cnt;            /* Number of elements in both tables. */
+	size_t used_cnt;            /* Elements plus DELETED slots in `cur'. */
+	struct ohash_table cur;     /* Where new elements go. */
+	struct ohash_table old;     /* Being moved into `cur', or empty. */
+	size_t migrate_slot;        /* Next slot of `old' to move. */
+	size_t migrate_batch;       /* Slots of `old' to move per change. */
+	ohash_hash_func *hash;      /* Hash function. */
+	ohash_eq_func *eq;          /* Equality function. */
+	void *aux;                  /* Auxiliary data for `hash' and `eq'. */
+};
+
+/* A hash table iterator. */
+struct ohash_iterator {
+	struct ohash *hash;         /* The hash table. */
+	struct ohash_table *table;  /* Current table: `cur', then `old'. */
+	size_t slot;                /* Current slot in `table'. */
+	struct ohash_elem *elem;    /* Current hash element. */
+};
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, ohash_hash_func *, ohash_eq_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+bool ohash_reserve (struct ohash *, size_t cnt);
+
+/* Search, insertion, deletion. */
+struct ohash_elem *ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_replace (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct ohash_elem *ohash_next (struct ohash_iterator *);
+struct ohash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
+#endif /* lib/kernel/ohash.h */
@@ -0,0 +1,65 @@
+#ifndef __LIB_KERNEL_RADIX_H
+#define __LIB_KERNEL_RADIX_H
+
+/* Radix tree.
+ *
+ * Maps 64-bit indexes to non-null pointers.  Each node has
+ * RADIX_SLOTS children and consumes RADIX_SHIFT bits of the
+ * index, so a tree whose largest index is below 64^H is H nodes
+ * deep.  The tree grows taller only when an index does not fit
+ * and shrinks again when the high part empties, so dense small
+ * indexes, like the page numbers of a file, stay shallow.
+ *
+ * Every entry may carry up to RADIX_TAGS independent tag bits.
+ * Each node keeps, per tag, a bitmap of the slots below which a
+ * tagged entry lives, so radix_gang_lookup() can find the tagged
+ * entries of a large sparse tree without visiting untagged
+ * subtrees.
+ *
+ * The tree allocates its own nodes with malloc() but not the
+ * items it points to. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RADIX_SHIFT 6                   /* Index bits per level. */
+#define RADIX_SLOTS (1 << RADIX_SHIFT)  /* Children per node. */
+#define RADIX_TAGS 2                    /* Tag bits per entry. */
+#define RADIX_ANY (-1)                  /* radix_gang_lookup(): untagged. */
+
+/* Tree node. */
+struct radix_node {
+	void *slots[RADIX_SLOTS];           /* Children, or items at the bottom. */
+	uint64_t present;                   /* Bit I set if slots[I] is non-null. */
+	uint64_t tags[RADIX_TAGS];          /* Bit I set if slot I has the tag below. */
+};
+
+/* Tree. */
+struct radix_tree {
+	struct radix_node *root;            /* Root node, or null if empty. */
+	unsigned height;                    /* Levels of nodes; 0 if empty. */
+	size_t cnt;                         /* Number of items. */
+};
+
+void radix_init (struct radix_tree *);
+void radix_destroy (struct radix_tree *);
+
+/* Insertion, removal, search. */
+bool radix_insert (struct radix_tree *, uint64_t index, void *item);
+void *radix_delete (struct radix_tree *, uint64_t index);
+void *radix_lookup (const struct radix_tree *, uint64_t index);
+size_t radix_gang_lookup (const struct radix_tree *, uint64_t start,
+                          void **items, uint64_t *indexes, size_t max,
+                          int tag);
+
+/* Tags. */
+void radix_tag_set (struct radix_tree *, uint64_t index, unsigned tag);
+void radix_tag_clear (struct radix_tree *, uint64_t index, unsigned tag);
+bool radix_tag_get (const struct radix_tree *, uint64_t index, unsigned tag);
+
+/* Information. */
+size_t radix_size (const struct radix_tree *);
+bool radix_empty (const struct radix_tree *);
+
+#endif /* lib/kernel/radix.h */
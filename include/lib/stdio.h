@@ -22,6 +22,7 @@ int vprintf (const char *, va_list) PRINTF_FORMAT (1, 0);
 int vsnprintf (char *, size_t, const char *, va_list) PRINTF_FORMAT (3, 0);
 int putchar (int);
 int puts (const char *);
+int fflush (int);
 
 /* Nonstandard functions. */
 void hex_dump (uintptr_t ofs, const void *, size_t size, bool ascii);
@@ -31,6 +32,7 @@ void __vprintf (const char *format, va_list args,
 		void (*output) (char, void *), void *aux);
 void __printf (const char *format,
 		void (*output) (char, void *), void *aux, ...);
+void __stdout_reset (void);     /* lib/user만. */
 
 /* Try to be helpful. */
 #define sprintf dont_use_sprintf_use_snprintf
@@ -10,6 +10,13 @@ void qsort (void *array, size_t cnt, size_t size,
 void *bsearch (const void *key, const void *array, size_t cnt,
 		size_t size, int (*compare) (const void *, const void *));
 
+/*** GrilledSalmon ***/
+/* 유저 프로그램의 malloc (lib/user/malloc.c). 커널은 threads/malloc.h를 쓴다. */
+void *malloc (size_t) __attribute__ ((malloc));
+void *calloc (size_t, size_t) __attribute__ ((malloc));
+void *realloc (void *, size_t);
+void free (void *);
+
 /* Nonstandard functions. */
 void sort (void *array, size_t cnt, size_t size,
 		int (*compare) (const void *, const void *, void *aux),
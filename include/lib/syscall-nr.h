@@ -1,6 +1,8 @@
 #ifndef __LIB_SYSCALL_NR_H
 #define __LIB_SYSCALL_NR_H
 
+#include <stdbool.h>
+
 /* System call numbers. */
 enum {
 	/* Projects 2 and later. */
@@ -36,6 +38,340 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Futex */
+	SYS_FUTEX_WAIT,             /* Sleep while a user word holds a value. */
+	SYS_FUTEX_WAKE,             /* Wake threads sleeping on a user word. */
+
+	/* Memory hints */
+	SYS_MADVISE,                /* Advise on the use of a memory range. */
+
+	/* Accounting */
+	SYS_GETRUSAGE,              /* Get page fault and memory statistics. */
+
+	/* Preallocation */
+	SYS_FALLOCATE,              /* Reserve disk space for a file. */
+
+	/* Positional and vectored I/O */
+	SYS_PREAD,                  /* Read from a file at an offset. */
+	SYS_PWRITE,                 /* Write to a file at an offset. */
+	SYS_READV,                  /* Read into several buffers. */
+	SYS_WRITEV,                 /* Write from several buffers. */
+	SYS_COPY_FILE_RANGE,        /* Copy between files inside the kernel. */
+
+	/* Durability */
+	SYS_FSYNC,                  /* Force a file's changes to disk. */
+
+	/* File system statistics */
+	SYS_FSSTAT,                 /* Get file system counters and latencies. */
+
+	/* Process creation without copying the address space */
+	SYS_SPAWN,                  /* Run a program in a new child process. */
+
+	/* Batched system calls */
+	SYS_RING_ENTER,             /* Run queued operations from a ring. */
+
+	/* Profiling */
+	SYS_SYSPROF,                /* Get system call counts and latencies. */
+
+	/* Environment */
+	SYS_EXECVE,                 /* Switch process with environment variables. */
+
+	/* Memory */
+	SYS_SBRK,                   /* Move the program break. */
+
+	/* Scheduling */
+	SYS_SCHEDSTAT,              /* Get context switch and latency counters. */
+
+	/* Resource limits */
+	SYS_SETRLIMIT,              /* Limit a resource the process may use. */
+
+	/* Memory-mapped files */
+	SYS_MSYNC,                  /* Write back a mapped file range. */
+
+	/* Open with flags */
+	SYS_OPEN2,                  /* Open a file with O_* flags. */
+
+	/* Directories */
+	SYS_GETDENTS,               /* Read several directory entries. */
+	SYS_STAT,                   /* Get a file's attributes by name. */
+	SYS_FSTAT,                  /* Get an open file's attributes. */
+
+	/* Pipes */
+	SYS_PIPE,                   /* Create a pipe. */
+
+	/* Shared memory */
+	SYS_SHM_CREATE,             /* Create a shared memory segment. */
+	SYS_SHM_ATTACH,             /* Map a shared memory segment. */
+	SYS_SHM_DETACH,             /* Unmap a shared memory segment. */
+
+	/* Processes */
+	SYS_WAITPID,                /* Wait for a given or any child process. */
+	SYS_UTHREAD_CREATE,         /* Start a thread in this address space. */
+	SYS_UTHREAD_EXIT,           /* Terminate the calling thread only. */
+	SYS_UTHREAD_JOIN,           /* Wait for a thread of this process. */
+	SYS_CHECKPOINT,             /* Save this process to an image file. */
+	SYS_RESTORE,                /* Replace this process with an image. */
+	SYS_AIO_READ,               /* Start reading a file in the background. */
+	SYS_AIO_WRITE,              /* Start writing a file in the background. */
+	SYS_AIO_WAIT,               /* Wait for background requests to finish. */
+	SYS_AIO_RETURN,             /* Collect a finished background request. */
+	SYS_POLL,                   /* Wait for any of several descriptors. */
+	SYS_CHAN_CREATE,            /* Create a message channel. */
+	SYS_CHAN_SEND,              /* Queue a message on a channel. */
+	SYS_CHAN_RECV,              /* Take the oldest message off a channel. */
+	SYS_SCHED_EDF,              /* Reserve CPU time each period by deadline. */
+
+	SYS_CNT                     /* Number of system call numbers. */
 };
 
+/* Flag that may be OR'ed into mmap()'s WRITABLE argument:
+   fault in the whole mapping before returning. */
+#define MAP_POPULATE 0x2
+/* Flag that may be OR'ed into mmap()'s WRITABLE argument:
+   map zero-filled anonymous memory instead of FD. */
+#define MAP_ANON 0x4
+
+/* Read-only page mapped at CLOCK_PAGE in every process.  The
+   nanoseconds since boot are ((rdtsc () - tsc_base) * mult) >> shift,
+   computed with a 128-bit product.  See clock_nanos(). */
+#define CLOCK_PAGE ((void *) 0x47480000)
+struct clock_page
+  {
+    unsigned long long tsc_base; /* TSC value at time 0. */
+    unsigned long long mult;     /* Nanoseconds per TSC cycle << SHIFT. */
+    unsigned shift;
+  };
+
+/* Flags for open2(). */
+#define O_DIRECT 0x1            /* Whole-sector I/O skips the buffer cache. */
+
+/* One directory entry filled in by getdents(). */
+struct dirent
+  {
+    int inumber;                /* Sector of the entry's inode. */
+    bool is_dir;                /* Is the entry a directory? */
+    char name[15];              /* Null-terminated, at most 14 characters. */
+  };
+
+/* File types in struct stat. */
+#define S_IFREG 1               /* Regular file. */
+#define S_IFDIR 2               /* Directory. */
+#define S_IFCHR 3               /* The console. */
+#define S_IFIFO 4               /* A pipe. */
+#define S_IFSHM 5               /* A shared memory segment. */
+#define S_IFCHAN 6              /* A message channel. */
+
+/* File attributes filled in by stat() and fstat(). */
+struct stat
+  {
+    long long size;             /* Length in bytes. */
+    int inumber;                /* Sector of the inode; 0 for the console. */
+    int type;                   /* One of the S_IF* types above. */
+    int nlink;                  /* Directory entries that name it. */
+  };
+
+/* Flags for msync(). */
+#define MS_ASYNC 0x1            /* Leave the writing to the write-back daemon. */
+#define MS_SYNC 0x4             /* Write before returning.  The default. */
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_SEQUENTIAL 2       /* Expect sequential access. */
+#define MADV_WILLNEED 3         /* Expect access soon: read ahead. */
+#define MADV_DONTNEED 4         /* Done with the pages: drop them. */
+
+/* Resources for setrlimit(). */
+#define RLIMIT_RSS 0            /* Resident memory, in bytes. */
+
+/* Per-process statistics filled in by getrusage().  The fault
+   and memory fields are 0 without virtual memory.  INBLOCK and
+   OUBLOCK count sectors the process sent to any disk, including
+   swap and file pages written back when its frames are evicted.
+   RCHAR and WCHAR count bytes moved by read(), write() and their
+   positional and vectored forms, whether or not a disk was
+   touched. */
+struct rusage
+  {
+    long minflt;                /* Page faults handled without I/O. */
+    long majflt;                /* Swap-ins and file reads. */
+    long nevict;                /* Frames evicted to make room for us. */
+    long nstack;                /* Stack growths. */
+    long rss;                   /* Resident pages right now. */
+    long inblock;               /* Sectors read from disk for us. */
+    long oublock;               /* Sectors written to disk for us. */
+    long long rchar;            /* Bytes returned by reads. */
+    long long wchar;            /* Bytes accepted by writes. */
+  };
+
+/* Operations whose latency fsstat() reports. */
+enum fsstat_op
+  {
+    FSSTAT_READ,                /* inode_read_at(). */
+    FSSTAT_WRITE,               /* inode_write_at(). */
+    FSSTAT_MAP,                 /* Byte offset to disk sector lookup. */
+    FSSTAT_ALLOC,               /* FAT cluster allocation. */
+    FSSTAT_OPS
+  };
+
+/* Latency histogram buckets.  Bucket N counts calls that took
+   [2^N, 2^(N+1)) TSC cycles; the last bucket also takes the rest. */
+#define FSSTAT_BUCKETS 32
+
+/* File system statistics filled in by fsstat(). */
+struct fsstat
+  {
+    long bc_hits;               /* Buffer cache lookups that hit. */
+    long bc_misses;             /* Buffer cache lookups that missed. */
+    long bc_readahead;          /* Sectors read ahead. */
+    long bytes_read;            /* Bytes returned by inode reads. */
+    long bytes_written;         /* Bytes accepted by inode writes. */
+    long sectors_read;          /* Sectors read from the file system disk. */
+    long sectors_written;       /* Sectors written to the file system disk. */
+    long chain_lookups;         /* Cluster lookups that walked the FAT. */
+    long chain_steps;           /* FAT entries followed by those walks. */
+    long clusters_allocated;    /* Clusters handed out by the FAT. */
+    long ops[FSSTAT_OPS];       /* Calls per operation. */
+    long latency[FSSTAT_OPS][FSSTAT_BUCKETS]; /* log2 cycle histograms. */
+  };
+
+/* Latency histogram buckets for sysprof(), as for fsstat(). */
+#define SYSPROF_BUCKETS 32
+
+/* System call statistics filled in by sysprof(), indexed by
+   system call number.  A call is counted when it is entered; its
+   cycles and histogram bucket are added only if it returns, so
+   exit() and a successful exec() show up in CALLS alone. */
+struct sysprof
+  {
+    long calls[SYS_CNT];        /* Calls entered. */
+    long long cycles[SYS_CNT];  /* TSC cycles spent in calls that returned. */
+    long latency[SYS_CNT][SYSPROF_BUCKETS]; /* log2 cycle histograms. */
+  };
+
+/* Wakeup latency buckets for schedstat(), as for fsstat(). */
+#define SCHEDSTAT_BUCKETS 32
+
+/* Scheduler statistics filled in by schedstat().  Times are TSC
+   cycles.  A thread is woken when thread_unblock() makes it ready
+   and runs when the scheduler switches to it; the wakeup latency
+   is the time in between.  Time spent ready after being preempted
+   or yielding counts in READY_CYCLES but is not a wakeup.  The
+   run queue fields and LATENCY are filled in for the whole system
+   only; for one thread they are 0. */
+struct schedstat
+  {
+    long nvcsw;                 /* Switches away because the thread blocked. */
+    long nivcsw;                /* Switches away while still runnable. */
+    long wakeups;               /* Wakeups that have since run. */
+    long long wakeup_cycles;    /* Sum of wakeup latencies. */
+    long long wakeup_max;       /* Longest wakeup latency. */
+    long long ready_cycles;     /* Time spent in a run queue. */
+    long rq_samples;            /* Timer ticks that sampled the run queue. */
+    long long rq_len_sum;       /* Sum of the sampled run queue lengths. */
+    long rq_len_max;            /* Longest sampled run queue. */
+    long latency[SCHEDSTAT_BUCKETS]; /* log2 wakeup latency histogram. */
+  };
+
+/* One buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of the buffer. */
+    size_t iov_len;             /* Size of the buffer in bytes. */
+  };
+
+/* Most buffers readv() and writev() accept in one call. */
+#define IOV_MAX 64
+
+/* One change spawn() makes to the child's copy of the caller's
+   file descriptors before the child's program starts. */
+struct spawn_action
+  {
+    int op;                     /* SPAWN_CLOSE or SPAWN_DUP2. */
+    int fd;                     /* Descriptor to close, or to duplicate. */
+    int newfd;                  /* SPAWN_DUP2 only: where to put FD. */
+  };
+
+#define SPAWN_CLOSE 1           /* close (fd) in the child. */
+#define SPAWN_DUP2 2            /* dup2 (fd, newfd) in the child. */
+
+/* Most actions spawn() accepts in one call. */
+#define SPAWN_ACTIONS_MAX 16
+
+/* One descriptor for poll().  The caller sets fd and events; poll()
+   sets revents. */
+struct pollfd
+  {
+    int fd;                     /* Descriptor, POLL_AIO, or negative to skip. */
+    short events;               /* POLLIN and/or POLLOUT to wait for. */
+    short revents;              /* What is ready.  May add POLLHUP, POLLNVAL. */
+  };
+
+#define POLLIN 0x1              /* Reading will not block. */
+#define POLLOUT 0x4             /* Writing will not block. */
+#define POLLHUP 0x10            /* The other end of a pipe is closed. */
+#define POLLNVAL 0x20           /* FD is not open. */
+
+/* fd for poll() that is readable when an aio request of this
+   process has finished but not been collected with aio_return(). */
+#define POLL_AIO (-2)
+
+/* Most descriptors poll() accepts in one call. */
+#define POLL_MAX 64
+
+/* Largest message chan_send() accepts.  Whole pages of a page-aligned
+   message are moved to the receiver instead of copied. */
+#define CHAN_MSG_MAX (4 * 1024 * 1024)
+
+/* Operations a ring_enter() submission may ask for.  Each one is
+   run like the system call of the same name. */
+enum ring_op
+  {
+    RING_NOP,                   /* Nothing; completes with 0. */
+    RING_OPEN,                  /* open (addr). */
+    RING_CLOSE,                 /* close (fd); completes with 0. */
+    RING_READ,                  /* read (fd, addr, len). */
+    RING_WRITE,                 /* write (fd, addr, len). */
+    RING_SEEK,                  /* seek (fd, offset); completes with 0. */
+    RING_PREAD,                 /* pread (fd, addr, len, offset). */
+    RING_PWRITE,                /* pwrite (fd, addr, len, offset). */
+  };
+
+/* One queued operation. */
+struct ring_sqe
+  {
+    int op;                     /* enum ring_op. */
+    int fd;                     /* File descriptor, if any. */
+    void *addr;                 /* Buffer or file name, if any. */
+    unsigned len;               /* Buffer size. */
+    int offset;                 /* File offset for seek, pread, pwrite. */
+    unsigned long long user_data; /* Copied to the completion as is. */
+  };
+
+/* One finished operation. */
+struct ring_cqe
+  {
+    unsigned long long user_data; /* From the submission. */
+    int res;                    /* What the system call returned. */
+  };
+
+/* Number of entries in each queue of a ring.  A power of 2. */
+#define RING_ENTRIES 64
+
+/* Submission and completion queues shared by a process and the
+   kernel.  The process fills sq[] and advances sq_tail, then calls
+   ring_enter(); the kernel runs entries from sq_head, posts one
+   completion per entry at cq_tail, and advances both.  The process
+   reads completions from cq_head.  Indexes only grow and are taken
+   modulo RING_ENTRIES. */
+struct sys_ring
+  {
+    unsigned sq_head;           /* Next submission to run.  Kernel. */
+    unsigned sq_tail;           /* End of queued submissions.  User. */
+    unsigned cq_head;           /* Next completion to read.  User. */
+    unsigned cq_tail;           /* End of posted completions.  Kernel. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
 #endif /* lib/syscall-nr.h */
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "../syscall-nr.h"
 
 /* Process identifier. */
 typedef int pid_t;
@@ -25,30 +27,87 @@ void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
 pid_t fork (const char *thread_name);
 int exec (const char *file);
+int execve (const char *cmd_line, char *const envp[]);
+pid_t spawn (const char *cmd_line, const struct spawn_action *actions,
+		int action_cnt);
 int wait (pid_t);
+pid_t waitpid (pid_t, int *status);
+pid_t uthread_create (int (*func) (void *), void *arg, void *stack_top);
+void uthread_exit (int status) NO_RETURN;
+int uthread_join (pid_t, int *status);
+int checkpoint (const char *file);
+int restore (const char *file);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
 int open (const char *file);
+int open2 (const char *file, int flags);
 int filesize (int fd);
 int read (int fd, void *buffer, unsigned length);
 int write (int fd, const void *buffer, unsigned length);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range (int fd_in, off_t off_in, int fd_out, off_t off_out,
+		unsigned length);
+int aio_read (int fd, void *buffer, unsigned length, off_t offset);
+int aio_write (int fd, const void *buffer, unsigned length, off_t offset);
+int aio_wait (const int *ids, int n, int timeout_ms);
+int aio_return (int id);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 
 int dup2(int oldfd, int newfd);
+int pipe (int fds[2]);
+int poll (struct pollfd *fds, int n, int timeout_ms);
+int chan_create (void);
+int chan_send (int fd, const void *buffer, unsigned length);
+int chan_recv (int fd, void *buffer, unsigned length);
+
+/* Batched system calls. */
+int ring_enter (struct sys_ring *ring, unsigned to_submit);
+
+/* Futex. */
+int futex_wait (int *addr, int expected);
+int futex_wait_timeout (int *addr, int expected, int timeout_ms);
+int futex_wake (int *addr, int n);
 
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length, int flags);
+int shm_create (size_t size);
+void *shm_attach (int fd, void *addr, bool writable);
+int shm_detach (void *addr);
+void *sbrk (intptr_t increment);
+int getrusage (struct rusage *usage);
+int setrlimit (int resource, long limit);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
 bool mkdir (const char *dir);
 bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
+int getdents (int fd, struct dirent *ents, unsigned cnt);
+int stat (const char *file, struct stat *st);
+int fstat (int fd, struct stat *st);
 bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
+bool fallocate (int fd, off_t length);
+int fsync (int fd);
+int fsstat (struct fsstat *st);
+int sysprof (struct sysprof *sp, bool self);
+int schedstat (struct schedstat *st, bool self);
+int sched_edf (unsigned runtime_ms, unsigned period_ms, unsigned deadline_ms);
+
+/* Nanoseconds since boot, read from CLOCK_PAGE. */
+unsigned long long clock_nanos (void);
+
+/* Environment variables passed by execve(). */
+extern char **environ;
+char *getenv (const char *name);
 
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
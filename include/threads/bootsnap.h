@@ -0,0 +1,19 @@
+#ifndef THREADS_BOOTSNAP_H
+#define THREADS_BOOTSNAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* 지난 부팅에서 잰 값을 os 디스크에 남겨 두고 다음 부팅에 다시 쓴다.
+   See bootsnap.c. */
+
+/* -nosnap: 남겨 둔 값을 쓰지 않고 다시 잰다. */
+extern bool bootsnap_disabled;
+
+void bootsnap_load (void);
+bool bootsnap_get (uint64_t *tsc_per_tick, unsigned *loops_per_tick);
+void bootsnap_set (uint64_t tsc_per_tick, unsigned loops_per_tick);
+void bootsnap_save (void);
+
+#endif /* threads/bootsnap.h */
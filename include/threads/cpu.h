@@ -0,0 +1,64 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+/*** GrilledSalmon ***/
+/* struct cpu 멤버의 offset. syscall-entry.S가 %gs로 읽는다. */
+#define CPU_KERNEL_RSP 0
+#define CPU_USER_RSP 8
+
+#ifndef __ASSEMBLER__
+#include <heap.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/thread.h"
+
+/* 다룰 수 있는 CPU의 수. AP를 깨우지 않으므로 지금은 BSP 하나다. */
+#define CPU_MAX 1
+
+/* CPU마다 하나 있는 데이터. 스케줄러의 상태는 모두 여기 두어, CPU가 늘면 각자
+ * 자기 것만 보게 한다. 앞의 두 칸은 syscall_entry가 swapgs 뒤에 읽고 쓴다. */
+struct cpu {
+	uint64_t kernel_rsp;        /* 지금 스레드의 ring 0 stack 끝. */
+	uint64_t user_rsp;          /* syscall_entry가 user rsp를 잠깐 둔다. */
+	struct thread *thread;      /* 지금 스레드. */
+	struct thread *idle_thread; /* 할 일이 없을 때 도는 스레드. */
+	unsigned id;                /* cpus[] 안의 index. */
+
+	/* Run queue.  우선순위마다 FIFO 큐를 하나씩 두고, ready_mask의 p번째
+	   비트로 ready_queues[p]가 비어있지 않음을 표시한다. (PRI_MAX + 1 == 64) */
+	struct list ready_queues[PRI_MAX + 1];
+	uint64_t ready_mask;
+	int ready_cnt;              /* ready 큐에 있는 스레드 수 (load_avg 계산용) */
+
+	/* -cfs일 때는 ready_queues 대신 vruntime 순의 힙을 쓴다. min_vruntime은
+	   이 CPU에서 가장 뒤처진 스레드의 vruntime을 따라가며 줄지 않는다. */
+	struct heap cfs_queue;
+	uint64_t min_vruntime;
+
+	/* EDF 스레드는 위의 큐보다 먼저 돈다. edf_queue는 abs_deadline 순이고,
+	   budget을 다 쓴 스레드는 next_release 순으로 edf_throttled에서 기다린다.
+	   edf_cnt는 edf_queue에 있는 스레드 수다. */
+	struct heap edf_queue;
+	struct heap edf_throttled;
+	int edf_cnt;
+
+	/* Scheduling. */
+	unsigned thread_ticks;      /* # of timer ticks since last yield. */
+
+	/* Statistics. */
+	long long idle_ticks;       /* # of timer ticks spent idle. */
+	long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+	long long user_ticks;       /* # of timer ticks in user programs. */
+} __attribute__ ((aligned (64)));
+
+extern struct cpu cpus[CPU_MAX];
+extern unsigned cpu_cnt;
+
+/* 지금 코드가 도는 CPU. CPU가 하나뿐이라 늘 cpus[0]이다. */
+static inline struct cpu *
+this_cpu (void) {
+	return &cpus[0];
+}
+#endif
+
+#endif /* threads/cpu.h */
@@ -1,16 +1,73 @@
-#define F (1<< 14)  //fixed point 1
-#define INT_MAX ((1<< 31) -1)
-#define INT_MIN (-(1<< 31))
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 고정소수점 연산. mlfqs 계산이 timer interrupt 안에서 매 tick 불리므로
+   모두 static inline으로 두어 호출 비용 없이 몇 개의 명령어로 풀리게 한다.
+   곱셈/나눗셈은 int64_t로 넓혀서 계산해 중간값 overflow를 막는다. */
+#define F (1 << 14)  //fixed point 1
+
+/* 자주 쓰는 상수는 미리 계산해 둔다. (load_avg 계산용) */
+#define FP_59_60 ((int) (((int64_t) 59 * F) / 60))
+#define FP_1_60 ((int) (((int64_t) 1 * F) / 60))
+
 // x and y denote fixed_pointnumbers in 17.14 format
 // n is an integer
-int int_to_fp(int n);
-int fp_to_int_round(int x);
-int fp_to_int(int x);
-int add_fp(int x,int y);
-int add_mixed(int x, int n);
-int sub_fp(int x, int y);
-int sub_mixed(int x, int n);
-int mult_fp(int x, int y);
-int mult_mixed(int x, int y);
-int div_fp(int x, int y);
-int div_mixed(int x, int n);
\ No newline at end of file
+static inline int
+int_to_fp (int n) {
+	return n * F;
+}
+
+static inline int
+fp_to_int (int x) {
+	return x / F;
+}
+
+static inline int
+fp_to_int_round (int x) {
+	if (x >= 0) return (x + F / 2) / F;
+	else return (x - F / 2) / F;
+}
+
+static inline int
+add_fp (int x, int y) {
+	return x + y;
+}
+
+static inline int
+sub_fp (int x, int y) {
+	return x - y;
+}
+
+static inline int
+add_mixed (int x, int n) {
+	return x + n * F;
+}
+
+static inline int
+sub_mixed (int x, int n) {
+	return x - n * F;
+}
+
+static inline int
+mult_fp (int x, int y) {
+	return ((int64_t) x) * y / F;
+}
+
+static inline int
+mult_mixed (int x, int n) {
+	return (int) ((int64_t) x * n);
+}
+
+static inline int
+div_fp (int x, int y) {
+	return ((int64_t) x) * F / y;
+}
+
+static inline int
+div_mixed (int x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed_point.h */
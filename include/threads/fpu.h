@@ -0,0 +1,14 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* Lazy FPU/SSE context switching.  See fpu.c. */
+void fpu_init (void);
+void fpu_switch (struct thread *next);
+bool fpu_copy (struct thread *dst, struct thread *src);
+void fpu_release (struct thread *t);
+
+#endif /* threads/fpu.h */
@@ -2,12 +2,33 @@
 #define THREADS_MALLOC_H
 
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+/* Blocks that one subsystem obtained with malloc_tagged(), for
+   mem_tag_print_stats().  Define each tag once, statically, with
+   MEM_TAG; it registers itself the first time it is used. */
+struct mem_tag
+  {
+    const char *name;
+    struct mem_tag *next;       /* Next registered tag. */
+    bool registered;
+    size_t live_cnt;            /* Blocks handed out and not freed. */
+    size_t live_bytes;          /* Their sizes, as rounded up by malloc(). */
+    size_t peak_bytes;          /* Largest LIVE_BYTES so far. */
+  };
+#define MEM_TAG(NAME) { .name = (NAME) }
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_print_stats (void);
+
+void *malloc_tagged (struct mem_tag *, size_t) __attribute__ ((malloc));
+void *calloc_tagged (struct mem_tag *, size_t, size_t) __attribute__ ((malloc));
+void free_tagged (struct mem_tag *, void *);
+void mem_tag_print_stats (void);
 
 #endif /* threads/malloc.h */
@@ -2,19 +2,32 @@
 #define THREAD_MMU_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "threads/pte.h"
 
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
+typedef bool pte_run_func (uint64_t *pte, void *va, size_t cnt, void *aux);
 
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
+bool pml4_map (uint64_t *pml4, uint64_t va, uint64_t pa, uint64_t flags);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
+bool pml4_for_each_range (uint64_t *pml4, void *start, void *end,
+		pte_for_each_func *, void *);
+bool pml4_for_each_run (uint64_t *pml4, void *start, void *end,
+		pte_run_func *, void *);
 void pml4_destroy (uint64_t *pml4);
+void pml4_pcid_init (void);
+bool pml4_zero_idle (void);
+void pml4_print_stats (void);
 void pml4_activate (uint64_t *pml4);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
 void pml4_clear_page (uint64_t *pml4, void *upage);
+void pml4_forget_page (uint64_t *pml4, void *upage);
+void *pml4_unmap_kernel (void *va);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed (uint64_t *pml4, const void *upage);
@@ -0,0 +1,20 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+
+/*** GrilledSalmon ***/
+/* Sampling profiler.  With -profile, every timer interrupt records
+   where the CPU was: the interrupted rip and a short backtrace
+   following the saved frame pointers.  At power off the samples
+   are printed as folded stacks and as a histogram of the hottest
+   addresses.  See profile_print() for the format. */
+
+extern bool profile_enabled;
+
+void profile_init (void);
+void profile_sample (const struct intr_frame *);
+void profile_print (void);
+
+#endif /* threads/profile.h */
@@ -26,7 +26,9 @@
 #define PDPE(la) ((((uint64_t) (la)) >> PDPESHIFT) & 0x1FF)
 #define PDX(la)  ((((uint64_t) (la)) >> PDXSHIFT) & 0x1FF)
 #define PTX(la)  ((((uint64_t) (la)) >> PTXSHIFT) & 0x1FF)
-#define PTE_ADDR(pte) ((uint64_t) (pte) & ~0xFFF)
+/* Bits 12..51.  Bits 52 and up of a PDPTE or PDE hold the number of
+   present entries in the table it points to (see mmu.c). */
+#define PTE_ADDR(pte) ((uint64_t) (pte) & 0x000ffffffffff000ULL)
 
 /* The important flags are listed below.
    When a PDE or PTE is not "present", the other flags are
@@ -41,5 +43,11 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=PDE maps a 2 MB page (PDEs only). */
+#define PTE_SHARED 0x200                 /* 1=page not owned; pml4_destroy() keeps it. */
+
+/* Size of the page a PDE with PTE_PS maps. */
+#define HUGE_PGSIZE (1UL << PDXSHIFT)
+#define HUGE_PGPAGES (HUGE_PGSIZE >> PTXSHIFT)
 
 #endif /* threads/pte.h */
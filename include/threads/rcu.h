@@ -0,0 +1,34 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <stddef.h>
+
+/*** GrilledSalmon ***/
+/* 읽기가 대부분인 자료구조를 위한 RCU.  See rcu.c. */
+
+struct rcu_head;
+typedef void rcu_func (struct rcu_head *);
+
+/* call_rcu에 넘기는 것. 지울 객체 안에 넣어 두고 FUNC에서 rcu_entry로 객체를
+   찾는다. */
+struct rcu_head {
+	struct rcu_head *next;
+	rcu_func *func;
+};
+
+#define rcu_entry(HEAD, STRUCT, MEMBER) \
+	((STRUCT *) ((char *) (HEAD) - offsetof (STRUCT, MEMBER)))
+
+/* reader가 공유 포인터 P를 읽는다. */
+#define rcu_dereference(P) __atomic_load_n (&(P), __ATOMIC_ACQUIRE)
+/* writer가 다 채운 V를 공유 포인터 P에 건다. */
+#define rcu_assign_pointer(P, V) __atomic_store_n (&(P), (V), __ATOMIC_RELEASE)
+
+void rcu_read_lock (void);
+void rcu_read_unlock (void);
+void call_rcu (struct rcu_head *, rcu_func *);
+void synchronize_rcu (void);
+void rcu_quiescent (void);
+void rcu_print_stats (void);
+
+#endif /* threads/rcu.h */
@@ -2,45 +2,147 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <heap.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+struct thread;
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* 공유자원의 갯수를 의미한다. */
-	struct list waiters;        /* 공유자원을 사용하기 위해 대기하는 waiters의 리스트 */
+	struct heap waiters;        /* 공유자원을 사용하기 위해 대기하는 스레드들의 우선순위 힙 */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t ticks);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
+void sema_up_handoff (struct semaphore *);
 void sema_self_test (void);
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
+void synch_update_waiter (struct thread *t);
+void synch_cancel_wait (struct thread *t);
+
+/*** GrilledSalmon ***/
+/* Lock contention statistics.  Built only with LOCKSTAT defined,
+   e.g. by adding -DLOCKSTAT to DEFINES in the directory's
+   Make.vars.  Every lock_init() call site gets one lock_class, so
+   all the locks one line of code initializes (say, every inode's
+   lock) are counted together under that line's name.  Times are
+   TSC cycles.  lockstat_print() ranks the classes by time spent
+   waiting. */
+#ifdef LOCKSTAT
+struct lock_class {
+	const char *name;           /* lock_init()의 인자와 호출 위치. */
+	struct lock_class *next;    /* lock_classes 목록의 다음 원소. */
+	bool registered;            /* lock_classes에 들어가 있으면 true. */
+	uint64_t acquire_cnt;       /* 획득 횟수. */
+	uint64_t contend_cnt;       /* 이미 잡혀 있어서 기다려야 했던 횟수. */
+	uint64_t wait_cycles;       /* 기다린 시간의 합. */
+	uint64_t hold_cycles;       /* 잡고 있던 시간의 합. */
+	uint64_t hold_max;          /* 가장 오래 잡고 있던 시간. */
+};
+#endif
 
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* 현재 lock을 가지고 있는 thread 정보 */
 	struct semaphore semaphore; /* 0과 1로 이루어진 세마포어 */
+	struct heap donors;         /* 이 lock을 기다리며 holder에게 우선순위를 기부하는 스레드들의 힙 */
+	struct heap_elem elem;      /* holder의 held_locks 힙의 원소 */
+	struct thread *handoff;     /* lock_release가 바로 넘겨줄 스레드. cond_signal_handoff가 정한다. */
+#ifdef LOCKSTAT
+	struct lock_class *class;   /* 통계를 모으는 곳. NULL이면 세지 않는다. */
+	uint64_t taken_tsc;         /* holder가 잡은 시각. */
+#endif
 };
 
 void lock_init (struct lock *);
+#ifdef LOCKSTAT
+#define LOCKSTAT_STR_(X) #X
+#define LOCKSTAT_STR(X) LOCKSTAT_STR_ (X)
+/* 호출 위치마다 lock_class를 하나씩 만들어 LOCK을 거기에 붙인다. */
+#define lock_init(LOCK) ({                                            \
+	static struct lock_class lock_class_ = {                          \
+		.name = #LOCK " (" __FILE__ ":" LOCKSTAT_STR (__LINE__) ")",  \
+	};                                                                \
+	lock_init_class ((LOCK), &lock_class_);                           \
+})
+void lock_init_class (struct lock *, struct lock_class *);
+void lockstat_print (void);
+#else
+static inline void lockstat_print (void) {}
+#endif
 void lock_acquire (struct lock *);
+bool lock_acquire_timeout (struct lock *, int64_t ticks);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* condition variabels가 만족하기를 기다리는 waiters의 리스트를 가진다. */
+	struct heap waiters;        /* condition variabels가 만족하기를 기다리는 waiters의 우선순위 힙 */
 };
 void donate_priority(void);
-void remove_with_lock(struct lock *lock);
 void refresh_priority(void);
+bool cmp_lock_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux);
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t ticks);
 void cond_signal (struct condition *, struct lock *);
+void cond_signal_handoff (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock {
+	struct lock lock;           /* writer가 잡고 있는 lock. 뒤에 기다리는 스레드는 writer에게 기부한다. */
+	struct semaphore drained;   /* 마지막 reader가 나갈 때 기다리던 writer를 깨운다. */
+	unsigned readers;           /* 현재 읽고 있는 reader 수 */
+	unsigned drain_waiters;     /* reader가 모두 나가기를 기다리는 writer 수 */
+	bool prefer_writer;         /* true면 기다리는 writer가 있을 때 새 reader를 막는다. */
+};
+
+void rwlock_init (struct rwlock *, bool prefer_writer);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
+/* Spinlock.  짧은 임계구역 전용. 잡고 있는 동안 인터럽트가 꺼져 있으므로 잠들면 안 된다. */
+struct spinlock {
+	bool locked;                /* 누군가 잡고 있으면 true */
+	enum intr_level old_level;  /* acquire 직전의 인터럽트 상태 */
+	uint64_t acquire_cnt;       /* 획득 횟수 */
+	uint64_t contend_cnt;       /* 이미 잡혀 있어서 기다려야 했던 횟수 */
+};
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+
+/*** GrilledSalmon ***/
+/* Wait queue.  한 스레드가 여러 객체를 한꺼번에 기다릴 때 (poll) 객체마다 entry를
+   하나씩 걸어 두고, 객체의 상태가 바뀌면 wait_queue_wake가 걸린 entry들의
+   세마포어를 올린다. 인터럽트를 끄고 고치므로 인터럽트 핸들러에서도 깨울 수
+   있다. */
+struct wait_queue {
+	struct list entries;        /* struct wait_entry의 리스트 */
+};
+
+struct wait_entry {
+	struct list_elem elem;
+	struct wait_queue *wq;      /* 걸려 있는 queue. 없으면 NULL. */
+	struct semaphore *sema;     /* 깨울 때 올린다. */
+};
+
+void wait_queue_init (struct wait_queue *);
+void wait_entry_add (struct wait_queue *, struct wait_entry *, struct semaphore *);
+void wait_entry_remove (struct wait_entry *);
+void wait_queue_wake (struct wait_queue *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -1,11 +1,13 @@
 #ifndef THREADS_THREAD_H
 #define THREADS_THREAD_H
-#define FDT_PAGES 3  // 파일 디스크립터 테이블을 위한 페이지 할당(thread_create, process_exit 에서 사용)
-#define FDCOUNT_LIMIT FDT_PAGES*(1<<9)   // 파일 디스크립터 인덱스 제한치
+#define FDT_INLINE 16  // struct thread 안에 바로 두는 fd 수(thread_create에서 초기화)
+#define FDCOUNT_LIMIT 1536   // 파일 디스크립터 인덱스 제한치
+#define FDT_MAP_WORDS(CAP) (((CAP) + 63) / 64)   // fd CAP개의 bitmap에 드는 uint64_t 수
 
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
@@ -32,9 +34,55 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63	   /* Highest priority. */
 #define NICE_DEFAULT 0
+#define NICE_MIN -20
+#define NICE_MAX 20
 #define RECENT_CPU_DEFAULT 0
 #define LOAD_AVG_DEFAULT 0
 
+/*** GrilledSalmon ***/
+/* EDF class에 든 스레드의 예약. 시간은 모두 tick이다. period가 시작할 때마다
+   budget이 runtime으로 채워지고, 그 period의 deadline이 이른 스레드부터 돈다. */
+struct thread_edf {
+	int64_t runtime;            /* period마다 받는 CPU 시간. 0이면 EDF가 아니다. */
+	int64_t period;
+	int64_t deadline;           /* period가 시작한 뒤 runtime을 다 받아야 하는 시간. */
+	uint64_t bw;                /* runtime / period. admission control에 쓴다. */
+	int64_t abs_deadline;       /* 이번 period의 deadline 시각. */
+	int64_t next_release;       /* 다음 period가 시작하는 시각. */
+	int64_t budget;             /* 이번 period에 남은 runtime. */
+	bool throttled;             /* budget을 다 써서 next_release까지 돌지 못한다. */
+	struct heap_elem elem;      /* cpu의 edf_queue나 edf_throttled의 원소. */
+};
+
+/* 스레드 하나의 스케줄링 통계. struct schedstat의 앞부분과 같은 뜻이다. */
+struct thread_schedstat {
+	long nvcsw;                 /* block되어 CPU를 내놓은 횟수. */
+	long nivcsw;                /* 뺏기거나 양보해서 CPU를 내놓은 횟수. */
+	long wakeups;               /* thread_unblock() 뒤에 다시 돈 횟수. */
+	uint64_t wakeup_cycles;     /* thread_unblock()부터 돌 때까지 걸린 시간의 합. */
+	uint64_t wakeup_max;        /* 그중 가장 긴 시간. */
+	uint64_t ready_cycles;      /* ready 큐에서 기다린 시간의 합. */
+};
+
+/*** GrilledSalmon ***/
+/* 부모와 자식이 함께 들고 있는 자식의 기록. 자식이 끝나도 부모가 wait 할
+   때까지 남으므로 자식의 struct thread는 끝나자마자 풀 수 있다. 둘 다 놓으면
+   (ref_cnt가 0이면) 풀린다. thread.c의 pid table에 tid로 들어 있고, 인터럽트를
+   끄고 고친다. */
+struct child {
+	tid_t tid;
+	struct thread *thread;      /* 자식 스레드. 끝났으면 NULL. */
+	struct thread *parent;      /* wait 할 부모. 부모가 먼저 끝났거나 거두었으면 NULL. */
+	int ref_cnt;
+	int exit_status;
+	bool load_failed;           /* fork, spawn한 자식이 읽어 들이지 못했다. */
+	bool uthread;               /* 부모의 주소 공간을 나누는 user thread. */
+	struct semaphore loaded;    /* 자식이 읽어 들이기를 마쳤다. */
+	struct semaphore exited;    /* 자식이 끝났다. */
+	struct list_elem elem;      /* 부모의 child_list, zombie_list나 uthread_list의 원소. */
+	struct list_elem pid_elem;  /* pid table의 원소. */
+};
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -100,46 +148,88 @@ struct thread
    char name[16];			   /* Name (for debugging purposes). */
    int priority;			   /* Priority. */
    int64_t wakeup_tick;	   // 일어날 시간
+   bool in_wheel;           /* 타이머 휠에 들어 있으면 true. elem을 휠이 쓰고 있다. */
 
    int init_priority;		   /* donation 이후 우선순위를 초기화하기 위해 초기값 저장 */
    struct lock *wait_on_lock; /* 해당 스레드가 대기하고있는 lock자료구조의 주소를 저장 */
-   struct list list_donation;	   /* 해당 스레드가 우선순위는 낮으나 lock을 보유하고 있을 때 사용됨 */
-   struct list_elem donation_elem;   /* 낮은 우선순위를 가진 스레드의 donations가 가리키는 list_elem  */
+   struct heap held_locks;	   /* 보유하고 있는 lock들의 힙. top lock의 donor가 가장 높은 기부 우선순위 */
+   struct heap_elem donor_elem;   /* wait_on_lock의 donors 힙의 원소 */
    /* Shared between thread.c and synch.c. */
    struct list_elem elem; /* List element. -> list_entry()로 thread에 접근 가능 */
 
+   /* Owned by synch.c. */
+   struct heap_elem wait_elem;      /* 세마포어 waiters 힙의 원소 */
+   struct semaphore *wait_on_sema;  /* 대기하고 있는 세마포어 (없으면 NULL) */
+   int64_t wait_seq;                /* 같은 우선순위끼리 FIFO로 깨우기 위한 대기 순번 */
+   struct condition *wait_on_cond;  /* cond_wait 중인 condition (없으면 NULL) */
+   struct heap_elem *wait_cond_elem; /* condition waiters 힙 안의 원소 */
+
+   /* Owned by rcu.c. */
+   int rcu_nesting;                 /* 겹친 rcu_read_lock의 수 */
+   int rcu_phase;                   /* 읽기 구간에 들어갈 때의 phase */
+
    int nice;		/* 우선순위에 영향을 주는 값 */
    int recent_cpu; /* 최근에 얼마나 많은 CPU time을 사용했는가를 표현 */
+   int64_t recent_cpu_epoch;	/* recent_cpu를 마지막으로 감쇠시킨 mlfqs epoch(초) */
+   uint64_t vruntime;	/* -cfs: nice의 weight로 나눠 센 CPU 시간 */
+   struct heap_elem cfs_elem;	/* -cfs: cpu->cfs_queue의 원소 */
+   struct thread_edf edf;	/* EDF class의 예약. 보통 스레드면 runtime이 0 */
+   struct list_elem all_elem;	/* all_list의 원소 */
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4; /* Page map level 4 */
+	struct sysprof *sysprof; /* -sysprof일 때 이 프로세스의 system call 통계 */
+	struct rusage rusage;	/* page fault와 I/O 통계. rss는 getrusage 때 센다. */
+	/* NULL이 아니면 이 스레드가 보내는 disk 요청을 이 프로세스의 rusage에 센다.
+	   다른 프로세스의 page를 evict 할 때 잠깐 쓴다. */
+	struct thread *io_owner;
+	struct aio_ctx *aio;	/* leader가 가진 aio 요청들. 처음 쓸 때 만든다 (aio.c). */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
 	uint64_t rsp;    /* 유저영역에서 발생한 인터럽트일 때 인터럽트 프레임(유저영역)의 rsp값을 저장해둠 */ /*** haein-side ***/
+	void *heap_start;	/* 실행 파일 segment가 끝나는 page. heap은 여기서 시작한다. */
+	void *brk;		/* 지금의 program break. [heap_start, brk)가 heap이다. */
+	size_t rss_cnt;		/* frame에 있는 page 수. frame_lock이 보호한다. */
+	size_t rss_limit;	/* rss_cnt가 이만큼이면 자기 page부터 evict 한다. 0이면 없다. */
 #endif
 	/* Owned by thread.c. */
 	struct intr_frame tf; /* Information for switching */
-   /* 자식 프로세스 순회용 리스트 */
+	void *fpu;            /* FXSAVE 영역. FPU를 처음 쓸 때 만든다 (fpu.c). */
+	unsigned cpu;         /* ready일 때 들어가는 run queue의 CPU (cpus[]의 index). */
+	uint64_t ready_tsc;   /* ready가 된 시각. ready가 아니면 0. */
+	bool woken;           /* thread_unblock()으로 ready가 되었으면 true. */
+	struct thread_schedstat sched; /* 이 스레드의 스케줄링 통계. */
+   /*** GrilledSalmon ***/
+   /* 살아 있는 자식과, 끝났지만 아직 wait 하지 않은 자식의 struct child.
+      자식이 끝날 때 자기 기록을 child_list에서 zombie_list로 옮기고 child_exit를
+      올린다. 인터럽트를 끄고 고친다. */
    struct list child_list;
-   struct list_elem child_elem;
-
-   /* wait_sema 를 이용하여 자식 프로세스가 종료할때까지 대기함. 종료 상태를 저장 */
-   struct semaphore wait_sema;
+   struct list zombie_list;
+   struct semaphore child_exit;
+   struct child *child;       /* 부모와 나누는 내 기록. initial thread는 NULL. */
    int exit_status;
 
-   /* 자식에게 넘겨줄 intr_frame
-   fork가 완료될때 까지 부모가 기다리게 하는 forksema
-   자식 프로세스 종료상태를 부모가 받을때까지 종료를 대기하게 하는 free_sema */
+   /* 주소 공간, fd table, 자식을 가진 스레드. 보통은 자기 자신이고
+      uthread_create로 만든 스레드는 만든 프로세스의 leader다. leader의
+      uthread_list에는 그런 스레드들의 struct child가 있다. exiting이면
+      uthread들은 다음 system call에서 끝난다. */
+   struct thread *leader;
+   struct list uthread_list;
+   bool exiting;
+
+   /* 자식에게 넘겨줄 intr_frame */
    struct intr_frame parent_if;
-   struct semaphore fork_sema;
-   struct semaphore free_sema;
 
-   /* fd table 파일 구조체와 fd index */
+   /* fd table 파일 구조체와 쓰고 있는 fd의 bitmap. 처음에는 fdInline을 쓰다가
+      모자라면 두 배씩 malloc으로 늘린다(syscall.c의 fdt_reserve). */
    struct file **fdTable;
-   int fdIdx;
+   uint64_t *fdMap;
+   int fdCap;
+   struct file *fdInline[FDT_INLINE];
+   uint64_t fdInlineMap;
 
    int stdin_count;
    int stdout_count;
@@ -155,15 +245,26 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler: CPU time is split in
+   proportion to a weight derived from each thread's nice value.
+   Controlled by kernel command-line option "-o cfs". */
+extern bool thread_cfs;
+
 void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+void thread_get_schedstat(struct schedstat *, bool self);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
+void thread_sleep(int64_t ticks);
+void thread_block_timeout(int64_t ticks);
+void thread_awake(int64_t ticks);
+int64_t thread_next_wakeup (int64_t limit);
+
 void thread_block(void);
 void thread_unblock(struct thread *);
 
@@ -171,8 +272,16 @@ struct thread *thread_current(void);
 tid_t thread_tid(void);
 const char *thread_name(void);
 
+/* Performs some operation on thread t, given auxiliary data AUX. */
+typedef void thread_action_func(struct thread *t, void *aux);
+void thread_foreach(thread_action_func *, void *);
+struct thread *thread_find(tid_t tid);
+struct child *child_find(tid_t tid);
+void child_put(struct child *);
+
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
+bool thread_yield_to(struct thread *t);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
@@ -182,7 +291,10 @@ void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
+bool thread_set_edf(int64_t runtime, int64_t period, int64_t deadline);
+
 void test_max_priority(void);
+void thread_update_priority(struct thread *t, int priority);
 bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
 void donate_priority(void);
@@ -0,0 +1,47 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* Kernel tracepoints.  TRACE (EVENT, A, B) records EVENT with two
+   arguments and the TSC in a ring buffer in memory, without
+   printing anything, so it hardly changes the timing it measures.
+   Tracepoints compile to nothing unless the kernel is built with
+   KTRACE defined, e.g. by adding -DKTRACE to DEFINES in the
+   directory's Make.vars.  The ring is written to the serial port
+   at power off; see trace_dump() for the format. */
+
+/* Events.  Arguments are noted as (A, B). */
+enum trace_event {
+	TRACE_sched_switch,     /* (tid of previous, tid of next). */
+	TRACE_thread_block,     /* (tid, 0). */
+	TRACE_thread_unblock,   /* (tid, priority). */
+	TRACE_page_fault,       /* (fault address, write << 1 | user). */
+	TRACE_evict,            /* (frames evicted, 0). */
+	TRACE_disk_read,        /* (first sector, sector count). */
+	TRACE_disk_write,       /* (first sector, sector count). */
+	TRACE_syscall,          /* (system call number, first argument). */
+	TRACE_EVENT_CNT
+};
+
+/* One record in the ring and in the dump, 32 bytes. */
+struct trace_rec {
+	uint64_t tsc;           /* rdtsc () when recorded. */
+	uint16_t event;         /* enum trace_event. */
+	uint16_t cpu;           /* CPU that recorded it. */
+	int32_t tid;            /* Running thread, or -1 early in boot. */
+	uint64_t a, b;          /* Event arguments. */
+};
+
+#ifdef KTRACE
+void trace_record (enum trace_event, uint64_t a, uint64_t b);
+void trace_dump (void);
+#define TRACE(EVENT, A, B) \
+	trace_record (TRACE_##EVENT, (uint64_t) (A), (uint64_t) (B))
+#else
+#define TRACE(EVENT, A, B) ((void) 0)
+static inline void trace_dump (void) { }
+#endif
+
+#endif /* threads/trace.h */
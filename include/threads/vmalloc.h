@@ -0,0 +1,30 @@
+#ifndef THREADS_VMALLOC_H
+#define THREADS_VMALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* 물리적으로 흩어진 page를 이어진 커널 가상 주소에 매핑해 주는 할당기.
+   vmalloc.c를 보라. */
+
+/* vmalloc이 쓰는 커널 가상 주소 영역. direct map과 같은 PML4 entry 안에
+   있으므로 모든 pml4가 base_pml4의 PDPT를 통해 같이 본다. */
+#define VMALLOC_START ((uint64_t) 0xc000000000)
+#define VMALLOC_SIZE ((uint64_t) 256 << 20)
+#define VMALLOC_END (VMALLOC_START + VMALLOC_SIZE)
+
+/* VA가 vmalloc 영역 안이다. */
+#define is_vmalloc_addr(va) \
+	((uint64_t) (va) >= VMALLOC_START && (uint64_t) (va) < VMALLOC_END)
+
+void vmalloc_init (void);
+void *vmalloc (size_t) __attribute__ ((malloc));
+void vfree (void *);
+void *kvmalloc (size_t) __attribute__ ((malloc));
+void *kvcalloc (size_t, size_t) __attribute__ ((malloc));
+void kvfree (void *);
+void vmalloc_print_stats (void);
+
+#endif /* threads/vmalloc.h */
@@ -0,0 +1,43 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* 커널 work queue와 bottom half.  See workqueue.c. */
+
+typedef void work_func (void *aux);
+
+/* 나중에 worker가 부를 일 하나. 부르는 쪽이 들고 있고 여러 번 다시 넣을 수
+   있다. 큐에 있는 동안 (pending) 다시 넣으면 무시된다. */
+struct work {
+	struct list_elem elem;      /* 큐나 delayed 목록의 원소. */
+	work_func *func;
+	void *aux;
+	int64_t expire;             /* work_queue_delayed: 큐로 옮길 tick. */
+	int prio;                   /* 넣을 큐. enum wq_prio. */
+	bool pending;               /* 큐나 delayed 목록에 있다. */
+};
+
+/* 큐의 우선순위. worker는 높은 큐부터 꺼내고 그 일을 하는 동안 큐에 맞는
+   스레드 우선순위로 돈다. */
+enum wq_prio {
+	WQ_HIGH,                    /* 지연에 민감한 일. */
+	WQ_NORMAL,                  /* reclaim, readahead, write-back. */
+	WQ_LOW,                     /* 남는 시간에 해도 되는 일. */
+	WQ_PRIO_CNT
+};
+
+void workqueue_init (void);
+void workqueue_start (void);
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct work *, enum wq_prio);
+bool work_queue_delayed (struct work *, enum wq_prio, int64_t ticks);
+void bh_schedule (struct work *);
+void workqueue_tick (int64_t now);
+int64_t workqueue_next_wakeup (int64_t limit);
+void workqueue_print_stats (void);
+
+#endif /* threads/workqueue.h */
@@ -0,0 +1,25 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct thread;
+struct semaphore;
+struct wait_entry;
+
+/*** GrilledSalmon ***/
+/* 프로세스 하나가 동시에 둘 수 있는 요청 수와 요청 하나의 최대 크기. */
+#define AIO_MAX 16
+#define AIO_SIZE_MAX (16 * 4096)
+
+void aio_init (void);
+int aio_submit (struct file *, void *ubuf, size_t size, off_t ofs, bool write);
+int aio_collect (const int *ids, int n, int timeout_ms);
+int aio_reap (int id);
+unsigned aio_poll (struct wait_entry *, struct semaphore *);
+void aio_destroy (struct thread *);
+
+#endif /* userprog/aio.h */
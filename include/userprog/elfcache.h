@@ -0,0 +1,38 @@
+#ifndef USERPROG_ELFCACHE_H
+#define USERPROG_ELFCACHE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct inode;
+
+/*** GrilledSalmon ***/
+/* 검증을 마친 PT_LOAD 세그먼트 하나. load_segment()에 그대로 넘긴다. */
+struct elf_seg {
+	uint64_t file_page;         /* 파일에서 읽기 시작할 페이지 offset. */
+	uint64_t mem_page;          /* 올릴 user 가상 주소. */
+	uint32_t read_bytes;        /* 파일에서 읽을 바이트 수. */
+	uint32_t zero_bytes;        /* 뒤를 0으로 채울 바이트 수. */
+	bool writable;
+};
+
+/* 실행 파일 하나를 파싱하고 검증한 결과. */
+struct elf_image {
+	struct list_elem elem;      /* Element in the cache list. */
+	struct inode *inode;        /* 파싱한 실행 파일. 참조를 하나 들고 있다. */
+	unsigned write_gen;         /* 파싱할 때의 inode_write_gen(). */
+	int ref_cnt;                /* 캐시와 load 중인 프로세스의 참조 수. */
+	uint64_t entry;             /* Entry point. */
+	int seg_cnt;
+	struct elf_seg segs[];
+};
+
+void elfcache_init (void);
+struct elf_image *elfcache_alloc (struct inode *, int seg_cap);
+struct elf_image *elfcache_get (struct inode *);
+void elfcache_put (struct elf_image *);
+void elfcache_release (struct elf_image *);
+void elfcache_flush (void);
+
+#endif /* userprog/elfcache.h */
@@ -0,0 +1,19 @@
+#ifndef USERPROG_IPC_H
+#define USERPROG_IPC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct ipc_chan;
+struct semaphore;
+struct wait_entry;
+
+/*** GrilledSalmon ***/
+struct ipc_chan *ipc_create (void);
+int ipc_send (struct ipc_chan *, const void *ubuf, size_t size);
+int ipc_recv (struct ipc_chan *, void *ubuf, size_t size);
+size_t ipc_pending (struct ipc_chan *);
+unsigned ipc_poll (struct ipc_chan *, struct wait_entry *, struct semaphore *);
+void ipc_close (struct ipc_chan *);
+
+#endif /* userprog/ipc.h */
@@ -0,0 +1,21 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct file;
+struct pipe;
+struct semaphore;
+struct wait_entry;
+
+/*** GrilledSalmon ***/
+bool pipe_create (struct file **rd, struct file **wr);
+int pipe_read (struct pipe *, void *ubuf, size_t size);
+int pipe_write (struct pipe *, const void *ubuf, size_t size);
+size_t pipe_available (struct pipe *);
+unsigned pipe_poll (struct pipe *, bool write_end, struct wait_entry *,
+		struct semaphore *);
+void pipe_close (struct pipe *, bool write_end);
+
+#endif /* userprog/pipe.h */
@@ -3,13 +3,26 @@
 
 #include "threads/thread.h"
 
+struct spawn_action;
+
+/* true이면 프로세스가 끝날 때 I/O 통계를 출력한다. -ioacct로 켠다. */
+extern bool process_print_io;
+
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_spawn (char *cmd_line, const struct spawn_action *actions,
+		int action_cnt);
 int process_exec (void *f_name);
+int process_execve (char *cmd_line, const char *env);
 int process_wait (tid_t);
+tid_t process_waitpid (tid_t pid, int *status);
+tid_t process_uthread_create (void *entry, void *arg1, void *arg2,
+		void *stack);
+bool process_uthread_join (tid_t tid, int *status);
+int process_checkpoint (const char *file_name, const struct intr_frame *if_);
+int process_restore (char *file_name);
 void process_exit (void);
 void process_activate (struct thread *next);
-static void argument_stack(struct intr_frame *if_, int argv_cnt, char **argv_list);
-/* pid를 입력하여 자식프로세스인지 확인하여 맞다면 thread 구조체 반환 */
-struct thread *get_child_with_pid(int pid);
+/* pid를 입력하여 자식프로세스인지 확인하여 맞다면 그 struct child 반환 */
+struct child *get_child_with_pid(int pid);
 #endif /* userprog/process.h */
@@ -3,10 +3,16 @@
 
 #include "threads/synch.h"
 
-void syscall_init (void);
+struct thread;
+struct file;
 
-/* 파일 사용시 lock하여 상호배제 구현 */
-struct lock file_rw_lock;
+void syscall_init (void);
+bool fdt_reserve (struct thread *, int cap);
+void fdt_set (struct thread *, int fd, struct file *);
+void fdt_destroy (struct thread *);
+int fdt_next (struct thread *, int fd);
 
+void close (int fd);
+int dup2 (int oldfd, int newfd);
 
 #endif /* userprog/syscall.h */
\ No newline at end of file
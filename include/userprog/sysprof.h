@@ -0,0 +1,20 @@
+#ifndef USERPROG_SYSPROF_H
+#define USERPROG_SYSPROF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <syscall-nr.h>
+
+struct thread;
+
+/* -sysprof: 프로세스마다 따로 세고 power off 때 출력한다. */
+extern bool sysprof_enabled;
+
+uint64_t sysprof_begin (int nr);
+void sysprof_end (int nr, uint64_t start);
+bool sysprof_get (struct sysprof *, bool self);
+void sysprof_exit (struct thread *);
+void sysprof_print (void);
+
+#endif /* userprog/sysprof.h */
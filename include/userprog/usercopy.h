@@ -0,0 +1,20 @@
+#ifndef USERPROG_USERCOPY_H
+#define USERPROG_USERCOPY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*** GrilledSalmon ***/
+/* 유저 메모리를 미리 검사하지 않고 바로 읽고 쓴다. 그러다 처리할 수 없는
+   page fault가 나면 page_fault()가 exception table에서 그 명령을 찾아 실패로
+   돌아가게 한다. 주소가 유저 영역이 아니어도 실패한다. */
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+bool user_fault_in (const void *uaddr, size_t size, bool write);
+bool user_range_ok (const void *uaddr, size_t size);
+
+uintptr_t usercopy_fixup (uintptr_t rip);
+
+#endif /* userprog/usercopy.h */
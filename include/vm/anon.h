@@ -9,7 +9,19 @@ struct anon_page {
     enum vm_type aux_type;      /*** GrilledSalmon ***/
 };
 
+extern char *swap_disk_spec;
+extern char *swap_file_spec;
+
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_share_slot (struct page *dst, struct page *src);
+void anon_drop_slot (struct page *page);
+void anon_drop_slots (struct ohash *h);
+void anon_print_stats (void);
+
+/* page 하나가 아닌 곳(shared memory segment)이 쥐는 swap slot. */
+int swap_slot_store (const void *kva);
+void swap_slot_load (int slot, void *kva);
+void swap_slot_put (int slot);
 
 #endif
@@ -4,6 +4,7 @@
 #include "vm/vm.h"
 
 struct page;
+struct vma;
 enum vm_type;
 
 /*** GrilledSalmon ***/
@@ -16,7 +17,15 @@ struct file_page {
 
 void vm_file_init (void);
 bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
+bool lazy_load_file (struct page *page, void *aux);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+int do_msync (void *addr, size_t length, int flags);
+void *do_mmap_anon (void *addr, size_t length, bool writable);
+struct vma *vma_create_anon (void *start, void *end, bool writable);
+void *vm_sbrk (intptr_t increment);
+bool vma_alloc_page (struct vma *vma, void *va);
+void vma_destroy (struct vma *vma);
+void mmap_file_release (struct file *file, int *remain_cnt);
 #endif
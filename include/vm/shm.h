@@ -0,0 +1,31 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct vma;
+struct shm_seg;
+
+/*** GrilledSalmon ***/
+/* shared memory segment의 page. 프로세스가 매핑한 page와, segment가 page마다
+ * 하나씩 들고 있는 anchor page가 있다. anchor는 spt에 없고 swap slot은
+ * anchor만 가진다. */
+struct shm_page {
+	struct shm_seg *seg;
+	size_t idx;                 /* segment 안에서 몇 번째 page인지. */
+	int slot_number;            /* anchor의 swap slot. 없으면 -1. */
+};
+
+/* segment 하나의 최대 page 수. */
+#define SHM_PAGES_MAX 4096
+
+struct shm_seg *shm_seg_create (size_t page_cnt);
+struct shm_seg *shm_seg_share (struct shm_seg *);
+void shm_seg_put (struct shm_seg *);
+size_t shm_seg_pages (struct shm_seg *);
+struct page *shm_anchor (struct page *page);
+void *do_shm_attach (void *addr, struct shm_seg *seg, bool writable);
+bool shm_alloc_page (struct vma *vma, void *va);
+
+#endif /* vm/shm.h */
@@ -3,6 +3,10 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/ohash.h"
+#include "lib/kernel/avl.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -13,6 +17,8 @@ enum vm_type {
 	VM_FILE = 2,
 	/* page that hold the page cache, for project 4 */
 	VM_PAGE_CACHE = 3,
+	/* page of a shared anonymous memory segment */
+	VM_SHM = 4,
 
 	VM_STACK = 9,			/*** GrilledSalmon ***/
 	VM_SEG = 17,
@@ -30,9 +36,8 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
-#ifdef EFILESYS
+#include "vm/shm.h"
 #include "filesys/page_cache.h"
-#endif
 
 struct page_operations;
 struct thread;
@@ -54,9 +59,14 @@ struct page {
 
 	/* Your implementation */
 	/*** Dongdongbro ***/
-	struct hash_elem hash_elem;
+	struct ohash_elem hash_elem;
 	bool writable;
 
+	/*** GrilledSalmon ***/
+	uint64_t *pml4;					/* 이 page를 매핑하는 프로세스의 pml4 */
+	struct thread *owner;			/* 그 프로세스. evict 할 때의 I/O를 센다. */
+	struct list_elem frame_elem;	/* frame->pages */
+
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union
 	 * 메모리 영역에 저장하는 다양한 유형의 데이터
@@ -66,19 +76,32 @@ struct page {
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
-#ifdef EFILESYS
 		struct page_cache page_cache;
-#endif
+		struct shm_page shm;
 	};
 };
 
 /* The representation of "frame" */
 /* 물리 메모리 나타냄 */
+/* COW fork 후에는 여러 프로세스의 anon page가 한 frame을 read-only로 같이 매핑한다.
+ * frame_lock이 pages, page_cnt, pin_cnt, evicting을 보호한다. */
 struct frame {
 	void *kva; 			// kernel virtual address
-	struct page *page;	// a page structure
-	struct list_elem frame_elem;	// for frame_table
-	uint64_t *pml4;
+	struct list pages;	// 이 frame을 매핑하는 page들
+	size_t page_cnt;	// pages의 길이
+	int pin_cnt;		// 0보다 크면 clock이 victim으로 고르지 않는다 (claim/evict/copy 중)
+	bool evicting;		// swap out 중이거나 page cache에 넣고 아직 읽는 중. 끝나면 frame_evicted로 알린다.
+
+	/* mmap 한 파일의 page cache에 있으면 그 위치. 아니면 inode가 NULL이다. */
+	struct inode *inode;
+	off_t file_ofs;
+	size_t file_bytes;
+
+	/* -evict=2q에서 쓰는 active/inactive list의 원소. frame table에 있는 동안
+	 * 둘 중 하나에 있다. */
+	struct list_elem lru_elem;
+	bool active;		// active list에 있다.
+	bool referenced;	// inactive list에서 한 번 접근된 것을 보았다.
 };
 
 /*** GrilledSalmon ***/
@@ -91,6 +114,35 @@ struct lazy_info {
 	int *remain_cnt;
 };
 
+/*** GrilledSalmon ***/
+/* mmap 한 영역 하나 (VMA). page는 미리 만들지 않고 fault가 나면
+ * vma_alloc_page가 FILE의 정보로 하나씩 만든다. spt의 vmas에 START 순으로 있다.
+ * FILE.FILE이 NULL이면 anon 영역 (MAP_ANON, heap)이고 page는 0으로 시작한다. */
+struct vma {
+	struct avl_elem elem;
+	void *start;            /* 첫 page. */
+	void *end;              /* 마지막 page의 다음 주소. */
+	bool writable;
+	bool sequential;        /* MADV_SEQUENTIAL: 많이 미리 읽고 지나간 page는 먼저 내보낸다. */
+	struct file_page file;  /* file, START의 파일 offset, START부터 읽을 byte 수, 참조 수 */
+	struct shm_seg *shm;    /* shm_attach 한 영역이면 그 segment. 참조를 하나 가진다. */
+};
+
+/* struct page, struct frame, struct lazy_info 전용 object cache (vm_init에서 생성) */
+extern struct kmem_cache *vm_page_cache;
+extern struct kmem_cache *vm_frame_cache;
+extern struct kmem_cache *lazy_info_cache;
+
+/* fault-around로 미리 읽어 오는 page 수 (-fault-around=N). */
+extern size_t vm_fault_around_pages;
+/* stack growth 한 번에 만드는 page 수 (-stack-chunk=N). */
+extern size_t vm_stack_chunk_pages;
+extern bool vm_print_rusage;
+/* 같은 내용의 anon frame을 합치는 ksmd를 켠다 (-ksm). */
+extern bool vm_ksm_enabled;
+/* kswapd를 깨우는 빈 page 수 (-kswapd=N). 음수이면 유저 풀 크기에서 정한다. */
+extern int vm_kswapd_low;
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -114,7 +166,15 @@ struct page_operations {
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-	struct hash h;
+	struct ohash h;
+	struct avl vmas;	/* mmap 영역들. 아직 만들지 않은 page는 여기서 찾는다. */
+	/* spt_find_page가 마지막으로 찾은 page. system call이 buffer를 확인하고 pin 하고
+	 * fault 나는 동안 같은 page를 여러 번 찾으므로 hash 앞에 둔다. page가 spt에서
+	 * 빠지면 지운다. */
+	struct page *last;
+	/* 주소 공간을 나누는 스레드들(uthread)이 page를 만들고 지우는 일을 묶는다.
+	 * fault 처리와 spt를 고치는 system call이 잡는다. */
+	struct lock lock;
 };
 
 #include "threads/thread.h"
@@ -126,6 +186,13 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
+bool spt_lock (struct supplemental_page_table *spt);
+void spt_unlock (struct supplemental_page_table *spt, bool locked);
+struct page *spt_get_page (struct supplemental_page_table *spt, void *va);
+bool spt_range_free (struct supplemental_page_table *spt, void *start, void *end);
+struct vma *vma_find (struct supplemental_page_table *spt, const void *va);
+void vma_insert (struct supplemental_page_table *spt, struct vma *vma);
+void vma_remove (struct supplemental_page_table *spt, struct vma *vma);
 
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
@@ -136,7 +203,31 @@ bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+struct frame *vm_frame_pin (struct page *page);
+bool vm_pin_user (void *uaddr, size_t size);
+void vm_unpin_user (void *uaddr, size_t size);
+void vm_free_frame (struct page *page);
+bool vm_frame_detach (struct page *page, struct frame *frame);
+void vm_frame_release (struct frame *frame);
+void vm_release_frame (struct page *page);
+size_t vm_flush_pick (struct frame **frames, size_t max);
+void vm_flush_done (struct frame **frames, size_t cnt);
+struct frame *vm_msync_pick (struct page *page, bool async);
+bool vm_cache_frame_get (struct page *page);
+bool vm_frame_is_dirty (struct frame *frame);
+void vm_frame_clear_dirty (struct frame *frame);
 bool vm_claim_page (void *va);
+struct page *vm_carrier_create (void *va);
+bool vm_carrier_map (struct page *carrier, void *va);
+void vm_carrier_read (struct page *carrier, void *kva);
+void vm_carrier_free (struct page *carrier);
+void vm_prefault (void *start, void *end, bool evict);
+void vm_stack_reserve (size_t pages);
+int vm_madvise (void *addr, size_t length, int advice);
+size_t vm_resident_pages (struct supplemental_page_table *spt);
+void ksm_print_stats (void);
+void kswapd_print_stats (void);
+bool vm_set_evict_policy (const char *name);
 enum vm_type page_get_type (struct page *page);
 
 #endif  /* VM_VM_H */
@@ -0,0 +1,23 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/*** GrilledSalmon ***/
+/* Swap disk 앞에 두는 압축 메모리 cache. swap slot 번호로 인덱싱한다.
+ * 꽉 차면 가장 오래된 page를 풀어서 자기 slot에 쓴다. */
+
+/* 압축된 page가 쓸 수 있는 메모리 상한 (KB). 0이면 zswap을 쓰지 않는다. */
+extern size_t zswap_limit_kb;
+
+/* cache에서 밀려난 PAGE를 디스크의 SLOT에 쓰는 함수. */
+typedef void zswap_writeback_func (size_t slot, const void *page);
+
+void zswap_init (size_t slot_cnt, zswap_writeback_func *writeback);
+bool zswap_store (size_t slot, const void *page);
+bool zswap_load (size_t slot, void *page);
+bool zswap_contains (size_t slot);
+void zswap_invalidate (size_t slot);
+void zswap_print_stats (void);
+
+#endif
@@ -0,0 +1,250 @@
+#include "avl.h"
+#include "../debug.h"
+
+/* An AVL tree is a binary search tree in which the heights of
+   the two subtrees of every element differ by at most one.
+   Every element caches the height of its subtree.  After an
+   insertion or removal, the heights are recomputed on the path
+   from the changed element up to the root, and any element that
+   has become unbalanced is fixed with one or two rotations. */
+
+/* Returns the height of the subtree rooted at E. */
+static int
+height (const struct avl_elem *e) {
+	return e != NULL ? e->height : 0;
+}
+
+/* Recomputes the height of E from its children. */
+static void
+update_height (struct avl_elem *e) {
+	int l = height (e->left), r = height (e->right);
+	e->height = (l > r ? l : r) + 1;
+}
+
+/* Returns the height of E's left subtree minus that of its right
+   subtree. */
+static int
+balance (const struct avl_elem *e) {
+	return height (e->left) - height (e->right);
+}
+
+/* Makes NEW take the place of OLD as the child of PARENT, or as
+   the root of TREE if PARENT is null.  NEW may be null. */
+static void
+replace_child (struct avl *tree, struct avl_elem *parent,
+               struct avl_elem *old, struct avl_elem *new) {
+	if (parent == NULL)
+		tree->root = new;
+	else if (parent->left == old)
+		parent->left = new;
+	else
+		parent->right = new;
+	if (new != NULL)
+		new->parent = parent;
+}
+
+/* Rotates the subtree rooted at X to the left and returns its new
+   root, X's former right child. */
+static struct avl_elem *
+rotate_left (struct avl *tree, struct avl_elem *x) {
+	struct avl_elem *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	replace_child (tree, x->parent, x, y);
+	y->left = x;
+	x->parent = y;
+	update_height (x);
+	update_height (y);
+	return y;
+}
+
+/* Rotates the subtree rooted at X to the right and returns its
+   new root, X's former left child. */
+static struct avl_elem *
+rotate_right (struct avl *tree, struct avl_elem *x) {
+	struct avl_elem *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	replace_child (tree, x->parent, x, y);
+	y->right = x;
+	x->parent = y;
+	update_height (x);
+	update_height (y);
+	return y;
+}
+
+/* Restores the AVL property on the path from E up to the root. */
+static void
+rebalance (struct avl *tree, struct avl_elem *e) {
+	while (e != NULL) {
+		update_height (e);
+		if (balance (e) > 1) {
+			if (balance (e->left) < 0)
+				rotate_left (tree, e->left);
+			e = rotate_right (tree, e);
+		} else if (balance (e) < -1) {
+			if (balance (e->right) > 0)
+				rotate_right (tree, e->right);
+			e = rotate_left (tree, e);
+		}
+		e = e->parent;
+	}
+}
+
+/* Returns the smallest element of the subtree rooted at E. */
+static struct avl_elem *
+leftmost (struct avl_elem *e) {
+	while (e->left != NULL)
+		e = e->left;
+	return e;
+}
+
+/* Initializes TREE as an empty tree ordered by LESS, which is
+   passed auxiliary data AUX. */
+void
+avl_init (struct avl *tree, avl_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = NULL;
+	tree->size = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts NEW into TREE.  If an element equal to NEW is already
+   in TREE, returns it without inserting NEW; otherwise returns
+   a null pointer. */
+struct avl_elem *
+avl_insert (struct avl *tree, struct avl_elem *new) {
+	struct avl_elem *parent = NULL;
+	struct avl_elem **link = &tree->root;
+
+	ASSERT (tree != NULL);
+	ASSERT (new != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (new, parent, tree->aux))
+			link = &parent->left;
+		else if (tree->less (parent, new, tree->aux))
+			link = &parent->right;
+		else
+			return parent;
+	}
+
+	new->parent = parent;
+	new->left = new->right = NULL;
+	new->height = 1;
+	*link = new;
+	tree->size++;
+	rebalance (tree, parent);
+	return NULL;
+}
+
+/* Removes E, which must be in TREE. */
+void
+avl_remove (struct avl *tree, struct avl_elem *e) {
+	struct avl_elem *fix;
+
+	ASSERT (tree != NULL);
+	ASSERT (e != NULL);
+	ASSERT (tree->size > 0);
+
+	if (e->left != NULL && e->right != NULL) {
+		/* Replace E by its in-order successor S, which has no
+		   left child. */
+		struct avl_elem *s = leftmost (e->right);
+
+		if (s->parent == e)
+			fix = s;
+		else {
+			fix = s->parent;
+			replace_child (tree, s->parent, s, s->right);
+			s->right = e->right;
+			s->right->parent = s;
+		}
+		replace_child (tree, e->parent, e, s);
+		s->left = e->left;
+		s->left->parent = s;
+		s->height = e->height;
+	} else {
+		fix = e->parent;
+		replace_child (tree, e->parent, e,
+		               e->left != NULL ? e->left : e->right);
+	}
+	tree->size--;
+	rebalance (tree, fix);
+}
+
+/* Returns the element of TREE equal to KEY, or a null pointer if
+   there is none. */
+struct avl_elem *
+avl_find (const struct avl *tree, const struct avl_elem *key) {
+	struct avl_elem *e = tree->root;
+
+	while (e != NULL) {
+		if (tree->less (key, e, tree->aux))
+			e = e->left;
+		else if (tree->less (e, key, tree->aux))
+			e = e->right;
+		else
+			return e;
+	}
+	return NULL;
+}
+
+/* Returns the greatest element of TREE that is less than or
+   equal to KEY, or a null pointer if every element is greater
+   than KEY. */
+struct avl_elem *
+avl_floor (const struct avl *tree, const struct avl_elem *key) {
+	struct avl_elem *e = tree->root;
+	struct avl_elem *best = NULL;
+
+	while (e != NULL) {
+		if (tree->less (key, e, tree->aux))
+			e = e->left;
+		else {
+			best = e;
+			e = e->right;
+		}
+	}
+	return best;
+}
+
+/* Returns the smallest element of TREE, or a null pointer if
+   TREE is empty. */
+struct avl_elem *
+avl_first (const struct avl *tree) {
+	return tree->root != NULL ? leftmost (tree->root) : NULL;
+}
+
+/* Returns the element that follows E in ascending order, or a
+   null pointer if E is the greatest element of its tree. */
+struct avl_elem *
+avl_next (struct avl_elem *e) {
+	ASSERT (e != NULL);
+
+	if (e->right != NULL)
+		return leftmost (e->right);
+	while (e->parent != NULL && e->parent->right == e)
+		e = e->parent;
+	return e->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+avl_size (const struct avl *tree) {
+	return tree->size;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+avl_empty (const struct avl *tree) {
+	return tree->root == NULL;
+}
@@ -4,6 +4,7 @@
 #include <round.h>
 #include <stdio.h>
 #include "threads/malloc.h"
+#include "threads/vmalloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
 #endif
@@ -27,6 +28,7 @@ typedef unsigned long elem_type;
    simulates an array of bits. */
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
+	size_t next_fit;    /* Where bitmap_scan_and_flip_next() resumes. */
 	elem_type *bits;    /* Elements that represent bits. */
 };
 
@@ -64,6 +66,34 @@ last_mask (const struct bitmap *b) {
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns an elem_type in which bits FIRST through LAST,
+   inclusive, are set, where FIRST and LAST are bit positions
+   within one element. */
+static inline elem_type
+range_mask (size_t first, size_t last) {
+	elem_type hi = last + 1 < ELEM_BITS
+		? ((elem_type) 1 << (last + 1)) - 1 : (elem_type) -1;
+	return hi & ~(((elem_type) 1 << first) - 1);
+}
+
+/* Returns the number of set bits in X.  The kernel does not link
+   libgcc, so __builtin_popcountl() is not available without
+   -mpopcnt. */
+static inline size_t
+elem_popcount (elem_type x) {
+	x = x - ((x >> 1) & 0x5555555555555555UL);
+	x = (x & 0x3333333333333333UL) + ((x >> 2) & 0x3333333333333333UL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (x * 0x0101010101010101UL) >> 56;
+}
+
+/* Returns element IDX of B with its bits inverted if VALUE is
+   false, so that the bits equal to VALUE read as 1. */
+static inline elem_type
+elem_match (const struct bitmap *b, size_t idx, bool value) {
+	return value ? b->bits[idx] : ~b->bits[idx];
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -75,7 +105,8 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
-		b->bits = malloc (byte_cnt (bit_cnt));
+		b->next_fit = 0;
+		b->bits = kvmalloc (byte_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all (b, false);
 			return b;
@@ -95,6 +126,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 	ASSERT (block_size >= bitmap_buf_size (bit_cnt));
 
 	b->bit_cnt = bit_cnt;
+	b->next_fit = 0;
 	b->bits = (elem_type *) (b + 1);
 	bitmap_set_all (b, false);
 	return b;
@@ -113,7 +145,7 @@ bitmap_buf_size (size_t bit_cnt) {
 void
 bitmap_destroy (struct bitmap *b) {
 	if (b != NULL) {
-		free (b->bits);
+		kvfree (b->bits);
 		free (b);
 	}
 }
@@ -195,33 +227,54 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.  Works a
+   whole element at a time; each element is updated atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t idx, last_idx;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	if (cnt == 0)
+		return;
+
+	last_idx = elem_idx (start + cnt - 1);
+	for (idx = elem_idx (start); idx <= last_idx; idx++) {
+		size_t first = idx == elem_idx (start) ? start % ELEM_BITS : 0;
+		size_t last = idx == last_idx ? (start + cnt - 1) % ELEM_BITS : ELEM_BITS - 1;
+		elem_type mask = range_mask (first, last);
+
+		/* Same as bitmap_mark()/bitmap_reset(), for MASK. */
+		if (value)
+			asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+		else
+			asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t idx, last_idx, value_cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
+	if (cnt == 0)
+		return 0;
+
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	last_idx = elem_idx (start + cnt - 1);
+	for (idx = elem_idx (start); idx <= last_idx; idx++) {
+		size_t first = idx == elem_idx (start) ? start % ELEM_BITS : 0;
+		size_t last = idx == last_idx ? (start + cnt - 1) % ELEM_BITS : ELEM_BITS - 1;
+		value_cnt += elem_popcount (elem_match (b, idx, value)
+				& range_mask (first, last));
+	}
 	return value_cnt;
 }
 
@@ -229,15 +282,22 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t idx, last_idx;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
+	if (cnt == 0)
+		return false;
+
+	last_idx = elem_idx (start + cnt - 1);
+	for (idx = elem_idx (start); idx <= last_idx; idx++) {
+		size_t first = idx == elem_idx (start) ? start % ELEM_BITS : 0;
+		size_t last = idx == last_idx ? (start + cnt - 1) % ELEM_BITS : ELEM_BITS - 1;
+		if (elem_match (b, idx, value) & range_mask (first, last))
 			return true;
+	}
 	return false;
 }
 
@@ -261,9 +321,31 @@ bool
 bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 	return !bitmap_contains (b, start, cnt, false);
 }
-
+
 /* Finding set or unset bits. */
 
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or B's size if there is none.  Elements with
+   no such bit are skipped with a single comparison. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) {
+	size_t idx, bit;
+	elem_type word;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	idx = elem_idx (start);
+	word = elem_match (b, idx, value) & ~(bit_mask (start) - 1);
+	while (word == 0) {
+		if (++idx >= elem_cnt (b->bit_cnt))
+			return b->bit_cnt;
+		word = elem_match (b, idx, value);
+	}
+	bit = idx * ELEM_BITS + __builtin_ctzl (word);
+	return bit < b->bit_cnt ? bit : b->bit_cnt;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
@@ -273,12 +355,21 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
+	if (cnt == 0)
+		return start;
+
+	/* Jump from the start of one run of VALUE bits to the next,
+	   stopping at the first run that is at least CNT long. */
+	while (cnt <= b->bit_cnt - start) {
+		size_t run_start = find_next (b, start, value);
+		size_t run_end;
+
+		if (cnt > b->bit_cnt - run_start)
+			break;
+		run_end = find_next (b, run_start, !value);
+		if (run_end - run_start >= cnt)
+			return run_start;
+		start = run_end;
 	}
 	return BITMAP_ERROR;
 }
@@ -297,7 +388,28 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
 		bitmap_set_multiple (b, idx, cnt, !value);
 	return idx;
 }
-
+
+/* Like bitmap_scan_and_flip(), but searches "next fit": starting
+   just past the group found by the previous call and wrapping
+   around to the beginning of B, so that repeated allocations of
+   single bits do not rescan the same full prefix every time. */
+size_t
+bitmap_scan_and_flip_next (struct bitmap *b, size_t cnt, bool value) {
+	size_t start, idx;
+
+	ASSERT (b != NULL);
+
+	start = b->next_fit <= b->bit_cnt ? b->next_fit : 0;
+	idx = bitmap_scan (b, start, cnt, value);
+	if (idx == BITMAP_ERROR && start > 0)
+		idx = bitmap_scan (b, 0, cnt, value);
+	if (idx != BITMAP_ERROR) {
+		bitmap_set_multiple (b, idx, cnt, !value);
+		b->next_fit = idx + cnt;
+	}
+	return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
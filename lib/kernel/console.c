@@ -1,14 +1,31 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void putbuf_have_lock (const char *, size_t);
+
+/*** GrilledSalmon ***/
+/* vprintf()는 lock 없이 스택의 buffer에 먼저 formatting 한 다음 lock을 잡고
+   한 번에 쓴다. buffer를 넘는 긴 출력은 처음 넘칠 때 lock을 잡고 끝날 때까지
+   들고 있으므로 다른 스레드의 출력과 섞이지 않는다. 커널 스택이 작으므로
+   buffer도 작게 둔다. */
+#define VPRINTF_BUF_SIZE 128
+
+struct vprintf_aux {
+	char buf[VPRINTF_BUF_SIZE];
+	size_t len;                 /* buf에 모인 문자 수. */
+	int char_cnt;               /* 지금까지 formatting 한 문자 수. */
+	bool locked;                /* 넘쳐서 console lock을 잡았다. */
+};
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -59,6 +76,15 @@ static int console_lock_depth;
 /* Number of characters written to console. */
 static int64_t write_cnt;
 
+/*** GrilledSalmon ***/
+/* console_capture()를 부른 스레드의 출력은 console 대신 capture_buf에 모인다.
+   procfs가 *_print_stats()의 출력을 그대로 파일 내용으로 쓸 때 쓴다. 한 번에
+   한 스레드만 모을 수 있고, 필드들은 console lock을 잡고 고친다. */
+static struct thread *capture_thread;
+static char *capture_buf;
+static size_t capture_size;
+static size_t capture_len;
+
 /* Enable console locking. */
 void
 console_init (void) {
@@ -72,6 +98,7 @@ console_init (void) {
 void
 console_panic (void) {
 	use_console_lock = false;
+	serial_panic ();
 }
 
 /* Prints console statistics. */
@@ -111,18 +138,66 @@ console_locked_by_current_thread (void) {
 			|| lock_held_by_current_thread (&console_lock));
 }
 
+/*** GrilledSalmon ***/
+/* 지금 스레드의 출력을 console에 쓰지 않고 BUF의 SIZE 바이트에 모으기
+   시작한다. 넘치는 출력은 버린다. console_capture_end()로 끝낸다. */
+void
+console_capture (char *buf, size_t size) {
+	acquire_console ();
+	ASSERT (capture_thread == NULL);
+	capture_thread = thread_current ();
+	capture_buf = buf;
+	capture_size = size;
+	capture_len = 0;
+	release_console ();
+}
+
+/* console_capture()로 시작한 것을 끝내고 BUF에 모인 바이트 수를 리턴한다. */
+size_t
+console_capture_end (void) {
+	size_t len;
+
+	acquire_console ();
+	ASSERT (capture_thread == thread_current ());
+	len = capture_len;
+	capture_thread = NULL;
+	release_console ();
+	return len;
+}
+
+/* 이 출력을 capture_buf에 모아야 하면 true. console lock을 잡고 부른다. */
+static bool
+capturing (void) {
+	return capture_thread != NULL && !intr_context ()
+		&& capture_thread == thread_current ();
+}
+
+/* BUFFER의 N 문자를 capture_buf에 들어가는 만큼 덧붙인다. */
+static void
+capture_putbuf (const char *buffer, size_t n) {
+	if (n > capture_size - capture_len)
+		n = capture_size - capture_len;
+	memcpy (capture_buf + capture_len, buffer, n);
+	capture_len += n;
+}
+
 /* The standard vprintf() function,
    which is like printf() but uses a va_list.
    Writes its output to both vga display and serial port. */
 int
 vprintf (const char *format, va_list args) {
-	int char_cnt = 0;
+	struct vprintf_aux aux;
 
-	acquire_console ();
-	__vprintf (format, args, vprintf_helper, &char_cnt);
+	aux.len = 0;
+	aux.char_cnt = 0;
+	aux.locked = false;
+	__vprintf (format, args, vprintf_helper, &aux);
+	if (!aux.locked)
+		acquire_console ();
+	putbuf_have_lock (aux.buf, aux.len);
 	release_console ();
 
-	return char_cnt;
+	return aux.char_cnt;
 }
 
 /* Writes string S to the console, followed by a new-line
@@ -130,8 +205,7 @@ vprintf (const char *format, va_list args) {
 int
 puts (const char *s) {
 	acquire_console ();
-	while (*s != '\0')
-		putchar_have_lock (*s++);
+	putbuf_have_lock (s, strlen (s));
 	putchar_have_lock ('\n');
 	release_console ();
 
@@ -142,8 +216,7 @@ puts (const char *s) {
 void
 putbuf (const char *buffer, size_t n) {
 	acquire_console ();
-	while (n-- > 0)
-		putchar_have_lock (*buffer++);
+	putbuf_have_lock (buffer, n);
 	release_console ();
 }
 
@@ -159,10 +232,36 @@ putchar (int c) {
 
 /* Helper function for vprintf(). */
 static void
-vprintf_helper (char c, void *char_cnt_) {
-	int *char_cnt = char_cnt_;
-	(*char_cnt)++;
-	putchar_have_lock (c);
+vprintf_helper (char c, void *aux_) {
+	struct vprintf_aux *aux = aux_;
+
+	aux->char_cnt++;
+	aux->buf[aux->len++] = c;
+	if (aux->len == sizeof aux->buf) {
+		if (!aux->locked) {
+			acquire_console ();
+			aux->locked = true;
+		}
+		putbuf_have_lock (aux->buf, aux->len);
+		aux->len = 0;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* BUFFER의 N 문자를 vga와 serial에 쓴다. 버퍼를 통째로 넘겨 serial은 한 번에
+   ring에 복사하고 vga는 한 번만 scroll 한다. console lock은 부른 쪽이 잡는다. */
+static void
+putbuf_have_lock (const char *buffer, size_t n) {
+	ASSERT (console_locked_by_current_thread ());
+	if (n == 0)
+		return;
+	if (capturing ()) {
+		capture_putbuf (buffer, n);
+		return;
+	}
+	write_cnt += n;
+	serial_putbuf (buffer, n);
+	vga_putbuf (buffer, n);
 }
 
 /* Writes C to the vga display and serial port.
@@ -171,6 +270,11 @@ vprintf_helper (char c, void *char_cnt_) {
 static void
 putchar_have_lock (uint8_t c) {
 	ASSERT (console_locked_by_current_thread ());
+	if (capturing ()) {
+		char ch = c;
+		capture_putbuf (&ch, 1);
+		return;
+	}
 	write_cnt++;
 	serial_putc (c);
 	vga_putc (c);
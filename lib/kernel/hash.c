@@ -6,8 +6,10 @@
    See hash.h for basic information. */
 
 #include "hash.h"
+#include <string.h>
 #include "../debug.h"
 #include "threads/malloc.h"
+#include "threads/vmalloc.h"
 
 #define list_elem_to_hash_elem(LIST_ELEM)                       \
 	list_entry(LIST_ELEM, struct hash_elem, list_elem)
@@ -26,7 +28,7 @@ hash_init (struct hash *h,
 		hash_hash_func *hash, hash_less_func *less, void *aux) {
 	h->elem_cnt = 0;
 	h->bucket_cnt = 4;
-	h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+	h->buckets = kvmalloc (sizeof *h->buckets * h->bucket_cnt);
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
@@ -81,7 +83,7 @@ void
 hash_destroy (struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear (h, destructor);
-	free (h->buckets);
+	kvfree (h->buckets);
 }
 
 /* Inserts NEW into hash table H and returns a null pointer, if
@@ -235,45 +237,77 @@ hash_empty (struct hash *h) {
 	return h->elem_cnt == 0;
 }
 
-/* Fowler-Noll-Vo hash constants, for 32-bit word sizes. */
-#define FNV_64_PRIME 0x00000100000001B3UL
-#define FNV_64_BASIS 0xcbf29ce484222325UL
+/* MurmurHash3 constants, for 64-bit words. */
+#define MURMUR_C1 0x87c37b91114253d5ULL
+#define MURMUR_C2 0x4cf5ad432745937fULL
+#define MURMUR_SEED 0xcbf29ce484222325ULL
+
+/* Returns X rotated left by N bits. */
+static inline uint64_t
+rotl64 (uint64_t x, int n) {
+	return (x << n) | (x >> (64 - n));
+}
 
 /* Returns a hash of the SIZE bytes in BUF. */
 uint64_t
 hash_bytes (const void *buf_, size_t size) {
-	/* Fowler-Noll-Vo 32-bit hash, for bytes. */
+	/* MurmurHash3-style, one 8-byte word per round.  The last
+	   partial word is padded with zeros and the length is mixed
+	   in at the end, so buffers that differ only in trailing zero
+	   bytes still hash differently. */
 	const unsigned char *buf = buf_;
-	uint64_t hash;
+	uint64_t hash, w;
+	size_t left;
 
 	ASSERT (buf != NULL);
 
-	hash = FNV_64_BASIS;
-	while (size-- > 0)
-		hash = (hash * FNV_64_PRIME) ^ *buf++;
+	hash = MURMUR_SEED;
+	for (left = size; left > 0; left -= left < sizeof w ? left : sizeof w) {
+		w = 0;
+		memcpy (&w, buf, left < sizeof w ? left : sizeof w);
+		buf += sizeof w;
+
+		w *= MURMUR_C1;
+		w = rotl64 (w, 31);
+		w *= MURMUR_C2;
+		hash ^= w;
+		hash = rotl64 (hash, 27) * 5 + 0x52dce729;
+	}
 
-	return hash;
+	return hash_u64 (hash ^ size);
 }
 
 /* Returns a hash of string S. */
 uint64_t
-hash_string (const char *s_) {
-	const unsigned char *s = (const unsigned char *) s_;
-	uint64_t hash;
-
+hash_string (const char *s) {
 	ASSERT (s != NULL);
 
-	hash = FNV_64_BASIS;
-	while (*s != '\0')
-		hash = (hash * FNV_64_PRIME) ^ *s++;
-
-	return hash;
+	return hash_bytes (s, strlen (s));
 }
 
 /* Returns a hash of integer I. */
 uint64_t
 hash_int (int i) {
-	return hash_bytes (&i, sizeof i);
+	return hash_u64 ((unsigned) i);
+}
+
+/* Returns a hash of X.  This is the MurmurHash3 finalizer: every
+   bit of X affects every bit of the result, so the low bits that
+   pick a bucket are as good as the high ones. */
+uint64_t
+hash_u64 (uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+/* Returns a hash of pointer P itself, not of what it points to. */
+uint64_t
+hash_ptr (const void *p) {
+	return hash_u64 ((uintptr_t) p);
 }
 
 /* Returns the bucket in H that E belongs in. */
@@ -345,7 +379,7 @@ rehash (struct hash *h) {
 		return;
 
 	/* Allocate new buckets and initialize them as empty. */
-	new_buckets = malloc (sizeof *new_buckets * new_bucket_cnt);
+	new_buckets = kvmalloc (sizeof *new_buckets * new_bucket_cnt);
 	if (new_buckets == NULL) {
 		/* Allocation failed.  This means that use of the hash table will
 		   be less efficient.  However, it is still usable, so
@@ -375,7 +409,7 @@ rehash (struct hash *h) {
 		}
 	}
 
-	free (old_buckets);
+	kvfree (old_buckets);
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -0,0 +1,200 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a heap-ordered multiway tree.  Each element
+   points to its leftmost child and to its right sibling; the
+   `prev' link points to the left sibling, or to the parent for a
+   leftmost child, so that an arbitrary element can be cut out of
+   the tree in O(1) time.  The root has null `prev' and `next'.
+
+   Melding two trees makes the one with the larger top a child of
+   the other.  Removing the top melds its children in two passes:
+   first pairwise from left to right, then the resulting trees from
+   right to left, which is what gives the O(lg n) amortized bound
+   on heap_pop(). */
+
+/* Melds the trees rooted at A and B and returns the new root. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (heap->less (b, a, heap->aux)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes the leftmost child of A. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+
+	a->prev = a->next = NULL;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree
+   with the standard two-pass pairing and returns its root. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first) {
+	struct heap_elem *stack = NULL;
+	struct heap_elem *root = NULL;
+
+	/* First pass: meld pairs from left to right, pushing each
+	   result onto STACK (linked through `next'). */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *m;
+
+		if (b == NULL) {
+			first = NULL;
+			a->prev = a->next = NULL;
+			m = a;
+		} else {
+			first = b->next;
+			a->prev = a->next = NULL;
+			b->prev = b->next = NULL;
+			m = meld (heap, a, b);
+		}
+		m->next = stack;
+		stack = m;
+	}
+
+	/* Second pass: meld the results from right to left. */
+	while (stack != NULL) {
+		struct heap_elem *next = stack->next;
+		stack->next = NULL;
+		root = meld (heap, root, stack);
+		stack = next;
+	}
+	return root;
+}
+
+/* Cuts ELEM, which is not the root, out of its sibling list.  Its
+   children stay with it. */
+static void
+cut (struct heap_elem *elem) {
+	ASSERT (elem->prev != NULL);
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->prev = elem->next = NULL;
+}
+
+/* Initializes HEAP as an empty heap ordered by LESS with
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->size = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_push (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->prev = elem->next = NULL;
+	heap->root = meld (heap, heap->root, elem);
+	heap->size++;
+}
+
+/* Returns the top element of HEAP, or a null pointer if HEAP is
+   empty. */
+struct heap_elem *
+heap_top (struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->root;
+}
+
+/* Removes and returns the top element of HEAP, or returns a null
+   pointer if HEAP is empty. */
+struct heap_elem *
+heap_pop (struct heap *heap) {
+	struct heap_elem *top;
+
+	ASSERT (heap != NULL);
+
+	top = heap->root;
+	if (top != NULL) {
+		heap->root = merge_pairs (heap, top->child);
+		heap->size--;
+		top->child = top->prev = top->next = NULL;
+	}
+	return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	struct heap_elem *sub;
+
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+	ASSERT (heap->size > 0);
+
+	if (elem == heap->root) {
+		heap_pop (heap);
+		return;
+	}
+
+	cut (elem);
+
+	/* Its children go back into the heap as one tree. */
+	sub = merge_pairs (heap, elem->child);
+	heap->root = meld (heap, heap->root, sub);
+	heap->size--;
+	elem->child = elem->prev = elem->next = NULL;
+}
+
+/* Restores the heap order after the key of ELEM, which must be
+   in HEAP, has changed in either direction. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem) {
+	heap_remove (heap, elem);
+	heap_push (heap, elem);
+}
+
+/* Restores the heap order after the key of ELEM, which must be
+   in HEAP, has moved toward the top, so that ELEM may now have to
+   come out before its parent.  Its subtree is still in order, so
+   it is cut out whole and melded with the root in O(1) time. */
+void
+heap_decrease (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+	ASSERT (heap->size > 0);
+
+	if (elem == heap->root)
+		return;
+	cut (elem);
+	heap->root = meld (heap, heap->root, elem);
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (const struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (const struct heap *heap) {
+	ASSERT (heap != NULL);
+	return heap->root == NULL;
+}
@@ -0,0 +1,459 @@
+/* Open-addressing hash table.
+
+   See ohash.h for basic information. */
+
+#include "ohash.h"
+#include <string.h>
+#include "../debug.h"
+#include "threads/malloc.h"
+#include "threads/vmalloc.h"
+
+/* Control byte values.  A slot that holds an element has the low
+   7 bits of the element's hash as its control byte, so its top
+   bit is clear; EMPTY and DELETED have it set.  A search stops at
+   the first EMPTY slot.  DELETED marks a slot whose element was
+   removed while the slot after it was in use, so that searches
+   for elements placed past it still go on. */
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xfe
+
+/* Fewest slots a table has. */
+#define MIN_SLOTS 8
+
+/* Fewest old slots moved into the new table per change while a
+   resize is in progress. */
+#define MIGRATE_SLOTS 16
+
+static size_t find_slot (struct ohash *, struct ohash_table *,
+		const struct ohash_elem *, uint64_t);
+static struct ohash_table *lookup (struct ohash *, const struct ohash_elem *,
+		uint64_t, size_t *);
+static bool table_put (struct ohash_table *, struct ohash_elem *, uint64_t);
+static void insert_elem (struct ohash *, struct ohash_elem *, uint64_t);
+static void remove_slot (struct ohash *, struct ohash_table *, size_t);
+static void reserve (struct ohash *);
+static bool start_resize (struct ohash *, size_t);
+static void migrate (struct ohash *, size_t);
+
+/* Returns true if control byte C belongs to a slot holding an
+   element. */
+static inline bool
+ctrl_full (uint8_t c) {
+	return (c & 0x80) == 0;
+}
+
+/* Returns the control byte for an element whose hash is HASH. */
+static inline uint8_t
+ctrl_tag (uint64_t hash) {
+	return hash & 0x7f;
+}
+
+/* Returns the slot in T where a search for HASH begins. */
+static inline size_t
+home_slot (struct ohash_table *t, uint64_t hash) {
+	return (hash >> 7) & (t->slot_cnt - 1);
+}
+
+/* Returns the slot after SLOT in T, wrapping around. */
+static inline size_t
+next_slot (struct ohash_table *t, size_t slot) {
+	return (slot + 1) & (t->slot_cnt - 1);
+}
+
+/* Returns the smallest table size that holds CNT elements at most
+   half full. */
+static size_t
+slots_for (size_t cnt) {
+	size_t slot_cnt = MIN_SLOTS;
+
+	while (slot_cnt < cnt * 2)
+		slot_cnt *= 2;
+	return slot_cnt;
+}
+
+/* Initializes hash table H to compute hash values using HASH and
+   compare hash elements using EQ, given auxiliary data AUX. */
+bool
+ohash_init (struct ohash *h,
+		ohash_hash_func *hash, ohash_eq_func *eq, void *aux) {
+	h->elem_cnt = 0;
+	h->used_cnt = 0;
+	h->cur.slot_cnt = 0;
+	h->cur.ctrl = NULL;
+	h->cur.slots = NULL;
+	h->old = h->cur;
+	h->migrate_slot = 0;
+	h->migrate_batch = 0;
+	h->hash = hash;
+	h->eq = eq;
+	h->aux = aux;
+
+	return start_resize (h, MIN_SLOTS);
+}
+
+/* Removes all the elements from H.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the hash.  DESTRUCTOR may, if appropriate, deallocate the
+   memory used by the hash element.  However, modifying hash
+   table H while ohash_clear() is running, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), yields undefined behavior,
+   whether done in DESTRUCTOR or elsewhere. */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor) {
+	if (destructor != NULL)
+		ohash_apply (h, destructor);
+
+	kvfree (h->old.slots);
+	h->old.slot_cnt = 0;
+	h->old.ctrl = NULL;
+	h->old.slots = NULL;
+	memset (h->cur.ctrl, CTRL_EMPTY, h->cur.slot_cnt);
+	h->elem_cnt = 0;
+	h->used_cnt = 0;
+}
+
+/* Destroys hash table H.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the hash, as in ohash_clear(). */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor) {
+	if (destructor != NULL)
+		ohash_apply (h, destructor);
+	kvfree (h->old.slots);
+	kvfree (h->cur.slots);
+}
+
+/* Sizes H so that it holds CNT elements in all without growing,
+   finishing any resize in progress.  Unlike the resizes done by
+   insertions, this one moves every element before it returns.
+   Returns false if memory runs out, in which case H still works
+   and grows as usual. */
+bool
+ohash_reserve (struct ohash *h, size_t cnt) {
+	size_t slot_cnt;
+
+	migrate (h, SIZE_MAX);
+	if (cnt < h->elem_cnt)
+		cnt = h->elem_cnt;
+	slot_cnt = slots_for (cnt);
+	if (slot_cnt <= h->cur.slot_cnt)
+		return true;
+	if (!start_resize (h, slot_cnt))
+		return false;
+	migrate (h, SIZE_MAX);
+	return true;
+}
+
+/* Inserts NEW into hash table H and returns a null pointer, if
+   no equal element is already in the table.
+   If an equal element is already in the table, returns it
+   without inserting NEW. */
+struct ohash_elem *
+ohash_insert (struct ohash *h, struct ohash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	size_t slot;
+	struct ohash_table *t = lookup (h, new, hash, &slot);
+
+	if (t != NULL)
+		return t->slots[slot];
+
+	reserve (h);
+	insert_elem (h, new, hash);
+	migrate (h, h->migrate_batch);
+	return NULL;
+}
+
+/* Inserts NEW into hash table H, replacing any equal element
+   already in the table, which is returned. */
+struct ohash_elem *
+ohash_replace (struct ohash *h, struct ohash_elem *new) {
+	uint64_t hash = h->hash (new, h->aux);
+	size_t slot;
+	struct ohash_table *t = lookup (h, new, hash, &slot);
+	struct ohash_elem *old;
+
+	if (t == NULL) {
+		reserve (h);
+		insert_elem (h, new, hash);
+		migrate (h, h->migrate_batch);
+		return NULL;
+	}
+
+	old = t->slots[slot];
+	new->hash = hash;
+	t->slots[slot] = new;
+	return old;
+}
+
+/* Finds and returns an element equal to E in hash table H, or a
+   null pointer if no equal element exists in the table.  Never
+   moves elements, so it changes nothing in H. */
+struct ohash_elem *
+ohash_find (struct ohash *h, struct ohash_elem *e) {
+	size_t slot;
+	struct ohash_table *t = lookup (h, e, h->hash (e, h->aux), &slot);
+
+	return t != NULL ? t->slots[slot] : NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in hash
+   table H.  Returns a null pointer if no equal element existed
+   in the table.
+
+   If the elements of the hash table are dynamically allocated,
+   or own resources that are, then it is the caller's
+   responsibility to deallocate them. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e) {
+	size_t slot;
+	struct ohash_table *t = lookup (h, e, h->hash (e, h->aux), &slot);
+	struct ohash_elem *found;
+
+	if (t == NULL)
+		return NULL;
+
+	found = t->slots[slot];
+	remove_slot (h, t, slot);
+	migrate (h, h->migrate_batch);
+
+	/* Shrink once the table is less than 1/8 full.  If that fails
+	   the table is merely larger than it needs to be. */
+	if (h->old.slot_cnt == 0 && h->cur.slot_cnt > MIN_SLOTS
+			&& h->elem_cnt * 8 < h->cur.slot_cnt)
+		start_resize (h, slots_for (h->elem_cnt * 2));
+	return found;
+}
+
+/* Calls ACTION for each element in hash table H in arbitrary
+   order.
+   Modifying hash table H while ohash_apply() is running, using
+   any of the functions ohash_clear(), ohash_destroy(),
+   ohash_insert(), ohash_replace(), or ohash_delete(), yields
+   undefined behavior, whether done from ACTION or elsewhere. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action) {
+	struct ohash_iterator i;
+
+	ASSERT (action != NULL);
+
+	ohash_first (&i, h);
+	while (ohash_next (&i))
+		action (ohash_cur (&i), h->aux);
+}
+
+/* Initializes I for iterating hash table H, with the same idiom
+   as hash_first().
+
+   Modifying hash table H during iteration, using any of the
+   functions ohash_clear(), ohash_destroy(), ohash_insert(),
+   ohash_replace(), or ohash_delete(), invalidates all
+   iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h) {
+	ASSERT (i != NULL);
+	ASSERT (h != NULL);
+
+	i->hash = h;
+	i->table = &h->cur;
+	i->slot = (size_t) -1;
+	i->elem = NULL;
+}
+
+/* Advances I to the next element in the hash table and returns
+   it.  Returns a null pointer if no elements are left.  Elements
+   are returned in arbitrary order. */
+struct ohash_elem *
+ohash_next (struct ohash_iterator *i) {
+	struct ohash *h;
+
+	ASSERT (i != NULL);
+
+	h = i->hash;
+	for (;;) {
+		while (++i->slot < i->table->slot_cnt)
+			if (ctrl_full (i->table->ctrl[i->slot]))
+				return i->elem = i->table->slots[i->slot];
+		if (i->table == &h->old)
+			break;
+		i->table = &h->old;
+		i->slot = (size_t) -1;
+	}
+
+	i->slot = i->table->slot_cnt;
+	return i->elem = NULL;
+}
+
+/* Returns the current element in the hash table iteration, or a
+   null pointer at the end of the table.  Undefined behavior
+   after calling ohash_first() but before ohash_next(). */
+struct ohash_elem *
+ohash_cur (struct ohash_iterator *i) {
+	return i->elem;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) {
+	return h->elem_cnt == 0;
+}
+
+/* Returns the slot of the element in T that is equal to E, whose
+   hash is HASH, or t->slot_cnt if there is none.  The equality
+   function is called only for elements with the same hash. */
+static size_t
+find_slot (struct ohash *h, struct ohash_table *t,
+		const struct ohash_elem *e, uint64_t hash) {
+	uint8_t tag = ctrl_tag (hash);
+	size_t i;
+
+	if (t->slot_cnt == 0)
+		return 0;
+	for (i = home_slot (t, hash); t->ctrl[i] != CTRL_EMPTY; i = next_slot (t, i))
+		if (t->ctrl[i] == tag && t->slots[i]->hash == hash
+				&& h->eq (t->slots[i], e, h->aux))
+			return i;
+	return t->slot_cnt;
+}
+
+/* Searches both tables of H for an element equal to E, whose hash
+   is HASH.  If there is one, stores its slot in *SLOT and returns
+   its table; otherwise returns a null pointer. */
+static struct ohash_table *
+lookup (struct ohash *h, const struct ohash_elem *e, uint64_t hash,
+		size_t *slot) {
+	*slot = find_slot (h, &h->cur, e, hash);
+	if (*slot != h->cur.slot_cnt)
+		return &h->cur;
+	*slot = find_slot (h, &h->old, e, hash);
+	if (*slot != h->old.slot_cnt)
+		return &h->old;
+	return NULL;
+}
+
+/* Puts E, whose hash is HASH, into the first free slot of its
+   probe sequence in T, which must have one.  Returns true if that
+   slot was EMPTY rather than DELETED. */
+static bool
+table_put (struct ohash_table *t, struct ohash_elem *e, uint64_t hash) {
+	bool was_empty;
+	size_t i;
+
+	for (i = home_slot (t, hash); ctrl_full (t->ctrl[i]); i = next_slot (t, i))
+		continue;
+
+	was_empty = t->ctrl[i] == CTRL_EMPTY;
+	e->hash = hash;
+	t->ctrl[i] = ctrl_tag (hash);
+	t->slots[i] = e;
+	return was_empty;
+}
+
+/* Inserts E, whose hash is HASH, into the current table of H.  H
+   must not contain an element equal to E. */
+static void
+insert_elem (struct ohash *h, struct ohash_elem *e, uint64_t hash) {
+	if (table_put (&h->cur, e, hash))
+		h->used_cnt++;
+	h->elem_cnt++;
+}
+
+/* Removes the element in SLOT of table T of H.  If the next slot
+   is empty no search can pass through SLOT, so it becomes empty as
+   well. */
+static void
+remove_slot (struct ohash *h, struct ohash_table *t, size_t slot) {
+	h->elem_cnt--;
+	if (t->ctrl[next_slot (t, slot)] == CTRL_EMPTY) {
+		t->ctrl[slot] = CTRL_EMPTY;
+		if (t == &h->cur)
+			h->used_cnt--;
+	} else
+		t->ctrl[slot] = CTRL_DELETED;
+}
+
+/* Makes sure H can take one more element while keeping at least
+   1/8 of its current slots empty, starting a resize if needed.
+   If memory runs out the table keeps filling up, and we panic
+   only when no slot at all is left, since every search needs an
+   empty slot to stop at. */
+static void
+reserve (struct ohash *h) {
+	if ((h->used_cnt + 1) * 8 <= h->cur.slot_cnt * 7)
+		return;
+
+	migrate (h, SIZE_MAX);
+	if (!start_resize (h, slots_for (h->elem_cnt + 1))
+			&& h->used_cnt + 1 >= h->cur.slot_cnt)
+		PANIC ("ohash: out of memory");
+}
+
+/* Allocates a new current table of SLOT_CNT slots for H, which
+   must be a power of 2 at least twice the number of elements, and
+   turns the current one into the old one to be moved across by
+   migrate().  No resize may already be in progress.  Returns
+   false, leaving H as it was, if memory runs out. */
+static bool
+start_resize (struct ohash *h, size_t slot_cnt) {
+	struct ohash_elem **slots;
+
+	ASSERT (h->old.slot_cnt == 0);
+	ASSERT (slot_cnt >= h->elem_cnt * 2 && (slot_cnt & (slot_cnt - 1)) == 0);
+
+	/* The control bytes follow the element pointers in one block. */
+	slots = kvmalloc (slot_cnt * (sizeof *slots + 1));
+	if (slots == NULL)
+		return false;
+
+	h->old = h->cur;
+	h->cur.slot_cnt = slot_cnt;
+	h->cur.slots = slots;
+	h->cur.ctrl = (uint8_t *) (slots + slot_cnt);
+	memset (h->cur.ctrl, CTRL_EMPTY, slot_cnt);
+	h->used_cnt = 0;
+
+	/* Move the old slots within slot_cnt / 8 changes.  The new
+	   table starts at most half full and each change adds at most
+	   one used slot, so it stays under 5/8 full until the old one
+	   is gone and reserve() never has to wait for migration. */
+	h->migrate_slot = 0;
+	h->migrate_batch = h->old.slot_cnt * 8 / slot_cnt;
+	if (h->migrate_batch < MIGRATE_SLOTS)
+		h->migrate_batch = MIGRATE_SLOTS;
+	migrate (h, h->migrate_batch);
+	return true;
+}
+
+/* Moves up to CNT slots of H's old table into the current one,
+   using the elements' cached hashes, and frees the old table once
+   it has been moved entirely.  The moved slots become DELETED so
+   that searches of the old table still reach the rest. */
+static void
+migrate (struct ohash *h, size_t cnt) {
+	struct ohash_table *old = &h->old;
+
+	while (old->slot_cnt != 0 && cnt-- > 0) {
+		size_t i = h->migrate_slot++;
+
+		if (ctrl_full (old->ctrl[i])) {
+			struct ohash_elem *e = old->slots[i];
+			if (table_put (&h->cur, e, e->hash))
+				h->used_cnt++;
+			old->ctrl[i] = CTRL_DELETED;
+		}
+		if (h->migrate_slot == old->slot_cnt) {
+			kvfree (old->slots);
+			old->slot_cnt = 0;
+			old->ctrl = NULL;
+			old->slots = NULL;
+		}
+	}
+}
@@ -0,0 +1,349 @@
+#include "radix.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* A tree of height H has H levels of nodes, numbered from 1 at
+   the bottom to H at the root.  Level L uses bits
+   [(L - 1) * RADIX_SHIFT, L * RADIX_SHIFT) of the index, and the
+   slots of level 1 hold the items.  Nodes are freed as soon as
+   they become empty, and the root is replaced by its only child
+   while that child is in slot 0, so a tree never has more levels
+   than its largest index needs. */
+
+/* Most levels a 64-bit index needs. */
+#define RADIX_MAX_HEIGHT ((64 + RADIX_SHIFT - 1) / RADIX_SHIFT)
+
+/* Returns the slot that INDEX takes in a node at LEVEL. */
+static inline unsigned
+slot_of (uint64_t index, unsigned level) {
+	return (index >> ((level - 1) * RADIX_SHIFT)) & (RADIX_SLOTS - 1);
+}
+
+/* Returns the bit for SLOT in a node's bitmaps. */
+static inline uint64_t
+slot_bit (unsigned slot) {
+	return (uint64_t) 1 << slot;
+}
+
+/* Returns the largest index a tree of HEIGHT levels can hold. */
+static uint64_t
+max_index (unsigned height) {
+	if (height * RADIX_SHIFT >= 64)
+		return UINT64_MAX;
+	return ((uint64_t) 1 << (height * RADIX_SHIFT)) - 1;
+}
+
+/* Initializes TREE as an empty tree. */
+void
+radix_init (struct radix_tree *tree) {
+	ASSERT (tree != NULL);
+
+	tree->root = NULL;
+	tree->height = 0;
+	tree->cnt = 0;
+}
+
+/* Frees N, a node at LEVEL, and the nodes below it. */
+static void
+free_nodes (struct radix_node *n, unsigned level) {
+	if (level > 1) {
+		uint64_t present = n->present;
+
+		while (present != 0) {
+			free_nodes (n->slots[__builtin_ctzll (present)], level - 1);
+			present &= present - 1;
+		}
+	}
+	free (n);
+}
+
+/* Frees the nodes of TREE, leaving it empty.  The items are the
+   caller's to free. */
+void
+radix_destroy (struct radix_tree *tree) {
+	if (tree->root != NULL)
+		free_nodes (tree->root, tree->height);
+	radix_init (tree);
+}
+
+/* Makes TREE tall enough to hold INDEX.  Returns false if memory
+   runs out. */
+static bool
+grow (struct radix_tree *tree, uint64_t index) {
+	if (tree->root == NULL) {
+		unsigned height = 1;
+
+		while (index > max_index (height))
+			height++;
+		tree->root = calloc (1, sizeof *tree->root);
+		if (tree->root == NULL)
+			return false;
+		tree->height = height;
+		return true;
+	}
+
+	while (index > max_index (tree->height)) {
+		struct radix_node *n = calloc (1, sizeof *n);
+		unsigned t;
+
+		if (n == NULL)
+			return false;
+		n->slots[0] = tree->root;
+		n->present = slot_bit (0);
+		for (t = 0; t < RADIX_TAGS; t++)
+			if (tree->root->tags[t] != 0)
+				n->tags[t] = slot_bit (0);
+		tree->root = n;
+		tree->height++;
+	}
+	return true;
+}
+
+/* Removes root nodes of TREE that have only slot 0 in use. */
+static void
+shrink (struct radix_tree *tree) {
+	while (tree->height > 1 && tree->root->present == slot_bit (0)) {
+		struct radix_node *child = tree->root->slots[0];
+
+		free (tree->root);
+		tree->root = child;
+		tree->height--;
+	}
+}
+
+/* Frees the empty nodes on PATH, the nodes that INDEX passes
+   through, from LEVEL upward, then shrinks TREE. */
+static void
+collapse (struct radix_tree *tree, struct radix_node **path,
+		uint64_t index, unsigned level) {
+	for (; level <= tree->height && path[level]->present == 0; level++) {
+		struct radix_node *parent;
+		uint64_t bit;
+		unsigned t;
+
+		free (path[level]);
+		if (level == tree->height) {
+			tree->root = NULL;
+			tree->height = 0;
+			return;
+		}
+		parent = path[level + 1];
+		bit = slot_bit (slot_of (index, level + 1));
+		parent->slots[slot_of (index, level + 1)] = NULL;
+		parent->present &= ~bit;
+		for (t = 0; t < RADIX_TAGS; t++)
+			parent->tags[t] &= ~bit;
+	}
+	if (tree->root != NULL)
+		shrink (tree);
+}
+
+/* Stores in PATH the nodes of TREE that INDEX passes through,
+   indexed by level, and returns the bottom one.  Returns a null
+   pointer if some node on the way is missing. */
+static struct radix_node *
+walk (const struct radix_tree *tree, uint64_t index,
+		struct radix_node **path) {
+	struct radix_node *n = tree->root;
+	unsigned level;
+
+	if (n == NULL || index > max_index (tree->height))
+		return NULL;
+	for (level = tree->height; level > 1; level--) {
+		path[level] = n;
+		n = n->slots[slot_of (index, level)];
+		if (n == NULL)
+			return NULL;
+	}
+	path[1] = n;
+	return n;
+}
+
+/* Stores ITEM, which must not be null, at INDEX in TREE and
+   returns true.  Returns false without storing it if INDEX is
+   already in use or if memory runs out. */
+bool
+radix_insert (struct radix_tree *tree, uint64_t index, void *item) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	struct radix_node *n;
+	unsigned level, slot;
+
+	ASSERT (item != NULL);
+
+	if (!grow (tree, index)) {
+		if (tree->root != NULL)
+			shrink (tree);
+		return false;
+	}
+
+	n = tree->root;
+	for (level = tree->height; level > 1; level--) {
+		slot = slot_of (index, level);
+		path[level] = n;
+		if (n->slots[slot] == NULL) {
+			struct radix_node *child = calloc (1, sizeof *child);
+
+			if (child == NULL) {
+				collapse (tree, path, index, level);
+				return false;
+			}
+			n->slots[slot] = child;
+			n->present |= slot_bit (slot);
+		}
+		n = n->slots[slot];
+	}
+
+	slot = slot_of (index, 1);
+	if (n->slots[slot] != NULL)
+		return false;
+	n->slots[slot] = item;
+	n->present |= slot_bit (slot);
+	tree->cnt++;
+	return true;
+}
+
+/* Removes and returns the item at INDEX in TREE, or returns a
+   null pointer if there is none.  The item's tags go with it. */
+void *
+radix_delete (struct radix_tree *tree, uint64_t index) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	struct radix_node *leaf = walk (tree, index, path);
+	unsigned slot = slot_of (index, 1);
+	unsigned t;
+	void *item;
+
+	if (leaf == NULL || leaf->slots[slot] == NULL)
+		return NULL;
+
+	for (t = 0; t < RADIX_TAGS; t++)
+		radix_tag_clear (tree, index, t);
+	item = leaf->slots[slot];
+	leaf->slots[slot] = NULL;
+	leaf->present &= ~slot_bit (slot);
+	tree->cnt--;
+	collapse (tree, path, index, 1);
+	return item;
+}
+
+/* Returns the item at INDEX in TREE, or a null pointer if there
+   is none. */
+void *
+radix_lookup (const struct radix_tree *tree, uint64_t index) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	struct radix_node *leaf = walk (tree, index, path);
+
+	return leaf != NULL ? leaf->slots[slot_of (index, 1)] : NULL;
+}
+
+/* Returns the first item at or after START below N, a node at
+   LEVEL whose first index is BASE, and stores its index in
+   *INDEX.  Only items with TAG count, or all items if TAG is
+   RADIX_ANY.  Returns a null pointer if there is none. */
+static void *
+next_item (const struct radix_node *n, unsigned level, uint64_t base,
+		uint64_t start, int tag, uint64_t *index) {
+	unsigned shift = (level - 1) * RADIX_SHIFT;
+	uint64_t mask = tag == RADIX_ANY ? n->present : n->tags[tag];
+
+	mask &= ~(uint64_t) 0 << ((start - base) >> shift);
+	for (; mask != 0; mask &= mask - 1) {
+		unsigned slot = __builtin_ctzll (mask);
+		uint64_t child_base = base + ((uint64_t) slot << shift);
+		void *item;
+
+		if (level == 1) {
+			*index = child_base;
+			return n->slots[slot];
+		}
+		item = next_item (n->slots[slot], level - 1, child_base,
+				start > child_base ? start : child_base, tag, index);
+		if (item != NULL)
+			return item;
+	}
+	return NULL;
+}
+
+/* Stores in ITEMS up to MAX items of TREE in index order, starting
+   from index START, and returns how many it stored.  Only items
+   with TAG are returned, or all items if TAG is RADIX_ANY.  If
+   INDEXES is non-null, the index of each item is stored there as
+   well, so that a caller can go on from the last one plus 1. */
+size_t
+radix_gang_lookup (const struct radix_tree *tree, uint64_t start,
+		void **items, uint64_t *indexes, size_t max, int tag) {
+	size_t cnt = 0;
+
+	ASSERT (tag == RADIX_ANY || (tag >= 0 && tag < RADIX_TAGS));
+
+	if (tree->root == NULL)
+		return 0;
+	while (cnt < max && start <= max_index (tree->height)) {
+		uint64_t index;
+		void *item = next_item (tree->root, tree->height, 0, start, tag, &index);
+
+		if (item == NULL)
+			break;
+		items[cnt] = item;
+		if (indexes != NULL)
+			indexes[cnt] = index;
+		cnt++;
+		if (index == UINT64_MAX)
+			break;
+		start = index + 1;
+	}
+	return cnt;
+}
+
+/* Sets TAG on the item at INDEX in TREE, which must exist. */
+void
+radix_tag_set (struct radix_tree *tree, uint64_t index, unsigned tag) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	unsigned level;
+
+	ASSERT (tag < RADIX_TAGS);
+	ASSERT (radix_lookup (tree, index) != NULL);
+
+	walk (tree, index, path);
+	for (level = 1; level <= tree->height; level++)
+		path[level]->tags[tag] |= slot_bit (slot_of (index, level));
+}
+
+/* Clears TAG on the item at INDEX in TREE, if there is one. */
+void
+radix_tag_clear (struct radix_tree *tree, uint64_t index, unsigned tag) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	unsigned level;
+
+	ASSERT (tag < RADIX_TAGS);
+
+	if (walk (tree, index, path) == NULL)
+		return;
+	for (level = 1; level <= tree->height; level++) {
+		path[level]->tags[tag] &= ~slot_bit (slot_of (index, level));
+		if (path[level]->tags[tag] != 0)
+			break;
+	}
+}
+
+/* Returns true if the item at INDEX in TREE has TAG. */
+bool
+radix_tag_get (const struct radix_tree *tree, uint64_t index, unsigned tag) {
+	struct radix_node *path[RADIX_MAX_HEIGHT + 1];
+	struct radix_node *leaf = walk (tree, index, path);
+
+	ASSERT (tag < RADIX_TAGS);
+
+	return leaf != NULL && (leaf->tags[tag] & slot_bit (slot_of (index, 1)));
+}
+
+/* Returns the number of items in TREE. */
+size_t
+radix_size (const struct radix_tree *tree) {
+	return tree->cnt;
+}
+
+/* Returns true if TREE has no items. */
+bool
+radix_empty (const struct radix_tree *tree) {
+	return tree->cnt == 0;
+}
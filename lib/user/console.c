@@ -3,6 +3,60 @@
 #include <syscall.h>
 #include <syscall-nr.h>
 
+/*** GrilledSalmon ***/
+/* stdout buffer. printf, puts, putchar의 출력을 모아 두었다가 write 한 번으로
+   보낸다. stdout이 console이면 줄이 끝날 때마다, 아니면 buffer가 찰 때 보내고
+   fflush와 exit도 보낸다. 다른 handle로 가는 출력은 buffer를 거치지 않는다. */
+#define STDOUT_BUF_SIZE 1024
+
+enum stdout_mode {
+	STDOUT_UNKNOWN,             /* 다음 출력 때 fstat으로 알아본다. */
+	STDOUT_LINE,                /* console. 줄마다 보낸다. */
+	STDOUT_FULL,                /* 파일이나 pipe. buffer가 차면 보낸다. */
+};
+
+static char stdout_buf[STDOUT_BUF_SIZE];
+static size_t stdout_len;
+static enum stdout_mode stdout_mode;
+
+static void stdout_putc (char c);
+
+/* HANDLE의 buffer에 모인 출력을 보낸다. 보낼 수 없었으면 -1 (EOF). stdout이
+   아닌 handle은 buffer가 없으므로 아무것도 하지 않는다. */
+int
+fflush (int handle) {
+	size_t len = stdout_len;
+
+	if (handle != STDOUT_FILENO || len == 0)
+		return 0;
+	/* write가 다시 fflush를 부르므로 먼저 비운다. */
+	stdout_len = 0;
+	return write (STDOUT_FILENO, stdout_buf, len) == (int) len ? 0 : -1;
+}
+
+/* 모인 출력을 보내고 stdout이 무엇인지 잊는다. dup2나 close로 stdout이 바뀔
+   때 부른다. */
+void
+__stdout_reset (void) {
+	fflush (STDOUT_FILENO);
+	stdout_mode = STDOUT_UNKNOWN;
+}
+
+/* C를 stdout buffer에 넣고 mode에 맞게 보낸다. */
+static void
+stdout_putc (char c) {
+	if (stdout_mode == STDOUT_UNKNOWN) {
+		struct stat st;
+
+		stdout_mode = fstat (STDOUT_FILENO, &st) == 0 && st.type == S_IFCHR
+			? STDOUT_LINE : STDOUT_FULL;
+	}
+	stdout_buf[stdout_len++] = c;
+	if (stdout_len == sizeof stdout_buf
+			|| (c == '\n' && stdout_mode == STDOUT_LINE))
+		fflush (STDOUT_FILENO);
+}
+
 /* The standard vprintf() function,
    which is like printf() but uses a va_list. */
 int
@@ -27,8 +81,9 @@ hprintf (int handle, const char *format, ...) {
    character. */
 int
 puts (const char *s) {
-	write (STDOUT_FILENO, s, strlen (s));
-	putchar ('\n');
+	while (*s != '\0')
+		stdout_putc (*s++);
+	stdout_putc ('\n');
 
 	return 0;
 }
@@ -36,8 +91,7 @@ puts (const char *s) {
 /* Writes C to the console. */
 int
 putchar (int c) {
-	char c2 = c;
-	write (STDOUT_FILENO, &c2, 1);
+	stdout_putc (c);
 	return c;
 }
 
@@ -50,6 +104,7 @@ struct vhprintf_aux {
 };
 
 static void add_char (char, void *);
+static void stdout_add_char (char, void *);
 static void flush (struct vhprintf_aux *);
 
 /* Formats the printf() format specification FORMAT with
@@ -58,6 +113,14 @@ static void flush (struct vhprintf_aux *);
 int
 vhprintf (int handle, const char *format, va_list args) {
 	struct vhprintf_aux aux;
+
+	/*** GrilledSalmon ***/
+	if (handle == STDOUT_FILENO) {
+		int char_cnt = 0;
+
+		__vprintf (format, args, stdout_add_char, &char_cnt);
+		return char_cnt;
+	}
 	aux.p = aux.buf;
 	aux.char_cnt = 0;
 	aux.handle = handle;
@@ -77,6 +140,15 @@ add_char (char c, void *aux_) {
 	aux->char_cnt++;
 }
 
+/* C를 stdout buffer에 넣고 CNT_로 센다. */
+static void
+stdout_add_char (char c, void *cnt_) {
+	int *cnt = cnt_;
+
+	stdout_putc (c);
+	(*cnt)++;
+}
+
 /* Flushes the buffer in AUX. */
 static void
 flush (struct vhprintf_aux *aux) {
@@ -1,9 +1,10 @@
 #include <syscall.h>
 
 int main (int, char *[]);
-void _start (int argc, char *argv[]);
+void _start (int argc, char *argv[], char *envp[]);
 
 void
-_start (int argc, char *argv[]) {
+_start (int argc, char *argv[], char *envp[]) {
+	environ = envp;
 	exit (main (argc, argv));
 }
@@ -0,0 +1,23 @@
+#include <syscall.h>
+#include <string.h>
+
+/* NULL로 끝나는 "NAME=value" 문자열 배열. _start()가 채운다. */
+char **environ;
+
+/* 환경 변수 NAME의 값을 리턴한다. 없으면 NULL. */
+char *
+getenv (const char *name) {
+	char **e;
+
+	for (e = environ; e != NULL && *e != NULL; e++) {
+		const char *n = name, *v = *e;
+
+		while (*n != '\0' && *n == *v) {
+			n++;
+			v++;
+		}
+		if (*n == '\0' && *v == '=')
+			return (char *) v + 1;
+	}
+	return NULL;
+}
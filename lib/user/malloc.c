@@ -0,0 +1,316 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <round.h>
+#include <syscall.h>
+
+/*** GrilledSalmon ***/
+/* 유저 프로그램의 malloc.
+
+   커널의 threads/malloc.c와 같은 모양이다. 요청 크기를 2의 거듭제곱으로 올려
+   그 크기의 descriptor에서 block을 꺼낸다. descriptor의 free list가 비면 page
+   하나(arena)를 얻어 block들로 나눈다. page는 sbrk로 heap을 늘려 얻는다.
+   arena의 block이 모두 돌아오면 그 block들을 free list에서 빼고
+   MADV_DONTNEED로 frame을 돌려준 다음 idle_arenas에 두었다가 다음 arena로
+   다시 쓴다.
+
+   arena 하나에 들어가지 않는 큰 block은 anonymous mmap으로 page를 따로 받고
+   free 할 때 munmap 한다. 주소는 stack 아래에서부터 아래로 골라 간다.
+
+   user thread가 같이 부를 수 있도록 futex로 만든 lock 하나로 막는다. */
+
+#define ARENA_SIZE 4096
+#define ARENA_MAGIC 0x9a548eed
+
+/* 큰 block을 매핑할 영역. stack이 자랄 수 있는 1 MB 아래에서 시작한다. */
+#define BIG_TOP ((uintptr_t) 0x47380000)
+#define BIG_BOTTOM ((uintptr_t) 0x20000000)
+
+/* 비워 둔 arena를 이만큼까지 들고 있는다. 넘치면 그냥 free list에 둔다. */
+#define IDLE_MAX 64
+
+/* Free block. arena가 비면 그 block들을 free list에서 빼야 하므로 양쪽으로
+   잇는다. */
+struct block {
+	struct block *prev;
+	struct block *next;
+};
+
+/* Descriptor. */
+struct desc {
+	size_t block_size;          /* Size of each element in bytes. */
+	size_t blocks_per_arena;    /* Number of blocks in an arena. */
+	struct block *free_list;    /* List of free blocks. */
+};
+
+/* Arena. 큰 block이면 desc가 NULL이고 free_cnt는 page 수다. */
+struct arena {
+	unsigned magic;             /* Always set to ARENA_MAGIC. */
+	struct desc *desc;          /* Owning descriptor, null for big block. */
+	size_t free_cnt;            /* Free blocks; pages in big block. */
+	size_t pad;                 /* block을 16바이트에 맞춘다. */
+};
+
+#define DESC(SIZE) \
+	{ SIZE, (ARENA_SIZE - sizeof (struct arena)) / (SIZE), NULL }
+static struct desc descs[] = {
+	DESC (16), DESC (32), DESC (64), DESC (128), DESC (256), DESC (512),
+	DESC (1024), DESC (2048),
+};
+#define DESC_CNT (sizeof descs / sizeof *descs)
+
+static struct arena *idle_arenas[IDLE_MAX];
+static size_t idle_cnt;
+static uintptr_t big_next = BIG_TOP;   /* 다음 큰 block이 끝날 주소. */
+
+/* 0이면 풀림, 1이면 잡힘, 2이면 잡혔고 기다리는 스레드가 있다. */
+static int heap_lock;
+
+static void
+heap_acquire (void) {
+	int c = 0;
+
+	if (__atomic_compare_exchange_n (&heap_lock, &c, 1, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+	if (c != 2)
+		c = __atomic_exchange_n (&heap_lock, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		futex_wait (&heap_lock, 2);
+		c = __atomic_exchange_n (&heap_lock, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+static void
+heap_release (void) {
+	if (__atomic_exchange_n (&heap_lock, 0, __ATOMIC_RELEASE) == 2)
+		futex_wake (&heap_lock, 1);
+}
+
+static void
+block_push (struct desc *d, struct block *b) {
+	b->prev = NULL;
+	b->next = d->free_list;
+	if (d->free_list != NULL)
+		d->free_list->prev = b;
+	d->free_list = b;
+}
+
+static void
+block_remove (struct desc *d, struct block *b) {
+	if (b->prev != NULL)
+		b->prev->next = b->next;
+	else
+		d->free_list = b->next;
+	if (b->next != NULL)
+		b->next->prev = b->prev;
+}
+
+static struct arena *
+block_to_arena (void *b) {
+	struct arena *a = (struct arena *) ((uintptr_t) b & ~(uintptr_t) (ARENA_SIZE - 1));
+
+	ASSERT (a->magic == ARENA_MAGIC);
+	return a;
+}
+
+static struct block *
+arena_to_block (struct arena *a, size_t idx) {
+	return (struct block *) ((uint8_t *) (a + 1) + idx * a->desc->block_size);
+}
+
+/* arena로 쓸 page 하나를 얻는다. 비워 둔 arena가 없으면 heap을 늘린다. heap의
+   끝이 page에 맞지 않으면 먼저 맞춘다. 없으면 NULL. */
+static struct arena *
+arena_get (void) {
+	uintptr_t brk;
+
+	if (idle_cnt > 0)
+		return idle_arenas[--idle_cnt];
+	brk = (uintptr_t) sbrk (0);
+	if (brk == (uintptr_t) -1)
+		return NULL;
+	if (brk % ARENA_SIZE != 0
+			&& sbrk (ARENA_SIZE - brk % ARENA_SIZE) == (void *) -1)
+		return NULL;
+	brk = (uintptr_t) sbrk (ARENA_SIZE);
+	return brk == (uintptr_t) -1 ? NULL : (struct arena *) brk;
+}
+
+/* PAGE_CNT page짜리 큰 block의 arena를 매핑한다. 다른 매핑과 겹치면 그 크기만큼
+   아래로 옮겨 가며 찾는다. 없으면 NULL. */
+static struct arena *
+big_get (size_t page_cnt) {
+	size_t size = page_cnt * ARENA_SIZE;
+	uintptr_t addr;
+
+	for (addr = big_next - size; addr >= BIG_BOTTOM && addr < big_next;
+			addr -= size)
+		if (mmap ((void *) addr, size, 1 | MAP_ANON, -1, 0) == (void *) addr) {
+			if (addr < big_next)
+				big_next = addr;
+			return (struct arena *) addr;
+		}
+	return NULL;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size) {
+	struct desc *d;
+	struct block *b;
+	struct arena *a;
+
+	/* A null pointer satisfies a request for 0 bytes. */
+	if (size == 0)
+		return NULL;
+
+	for (d = descs; d < descs + DESC_CNT; d++)
+		if (d->block_size >= size)
+			break;
+
+	heap_acquire ();
+	if (d == descs + DESC_CNT) {
+		/* SIZE is too big for any descriptor.
+		   Allocate enough pages to hold SIZE plus an arena. */
+		size_t page_cnt;
+
+		if (size > SIZE_MAX - sizeof *a - ARENA_SIZE) {
+			heap_release ();
+			return NULL;
+		}
+		page_cnt = DIV_ROUND_UP (size + sizeof *a, ARENA_SIZE);
+		a = big_get (page_cnt);
+		heap_release ();
+		if (a == NULL)
+			return NULL;
+		a->magic = ARENA_MAGIC;
+		a->desc = NULL;
+		a->free_cnt = page_cnt;
+		return a + 1;
+	}
+
+	/* If the free list is empty, create a new arena. */
+	if (d->free_list == NULL) {
+		size_t i;
+
+		a = arena_get ();
+		if (a == NULL) {
+			heap_release ();
+			return NULL;
+		}
+		a->magic = ARENA_MAGIC;
+		a->desc = d;
+		a->free_cnt = d->blocks_per_arena;
+		for (i = 0; i < d->blocks_per_arena; i++)
+			block_push (d, arena_to_block (a, i));
+	}
+
+	/* Get a block from free list and return it. */
+	b = d->free_list;
+	block_remove (d, b);
+	a = block_to_arena (b);
+	a->free_cnt--;
+	heap_release ();
+	return b;
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b) {
+	void *p;
+	size_t size;
+
+	/* Calculate block size and make sure it fits in size_t. */
+	size = a * b;
+	if (size < a || size < b || (a != 0 && size / a != b))
+		return NULL;
+
+	/* Allocate and zero memory. */
+	p = malloc (size);
+	if (p != NULL)
+		memset (p, 0, size);
+
+	return p;
+}
+
+/* Returns the number of bytes allocated for BLOCK. */
+static size_t
+block_size (void *block) {
+	struct arena *a = block_to_arena (block);
+
+	return a->desc != NULL ? a->desc->block_size
+		: a->free_cnt * ARENA_SIZE - sizeof *a;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size) {
+	if (new_size == 0) {
+		free (old_block);
+		return NULL;
+	} else if (old_block != NULL && new_size <= block_size (old_block)) {
+		/* 이미 들어간다. */
+		return old_block;
+	} else {
+		void *new_block = malloc (new_size);
+		if (old_block != NULL && new_block != NULL) {
+			memcpy (new_block, old_block, block_size (old_block));
+			free (old_block);
+		}
+		return new_block;
+	}
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p) {
+	struct arena *a;
+	struct desc *d;
+
+	if (p == NULL)
+		return;
+	a = block_to_arena (p);
+	d = a->desc;
+
+	heap_acquire ();
+	if (d == NULL) {
+		/* It's a big block.  Unmap it. */
+		size_t size = a->free_cnt * ARENA_SIZE;
+
+		if ((uintptr_t) a == big_next)
+			big_next += size;
+		a->magic = 0;
+		munmap (a);
+		heap_release ();
+		return;
+	}
+
+#ifndef NDEBUG
+	/* Clear the block to help detect use-after-free bugs. */
+	memset (p, 0xcc, d->block_size);
+#endif
+	block_push (d, p);
+
+	/* If the arena is now entirely unused, drop its frames and keep the
+	   page for the next arena. */
+	if (++a->free_cnt >= d->blocks_per_arena && idle_cnt < IDLE_MAX) {
+		size_t i;
+
+		ASSERT (a->free_cnt == d->blocks_per_arena);
+		for (i = 0; i < d->blocks_per_arena; i++)
+			block_remove (d, arena_to_block (a, i));
+		idle_arenas[idle_cnt++] = a;
+		madvise (a, ARENA_SIZE, MADV_DONTNEED);
+	}
+	heap_release ();
+}
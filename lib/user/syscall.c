@@ -1,5 +1,6 @@
 #include <syscall.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "../syscall-nr.h"
 typedef int pid_t;
 
@@ -77,25 +78,84 @@ halt (void) {
 
 void
 exit (int status) {
+	fflush (STDOUT_FILENO);
 	syscall1 (SYS_EXIT, status);
 	NOT_REACHED ();
 }
 
 pid_t
 fork (const char *thread_name){
+	/* 자식이 buffer를 물려받아 같은 출력을 두 번 쓰지 않게 한다. */
+	fflush (STDOUT_FILENO);
 	return (pid_t) syscall1 (SYS_FORK, thread_name);
 }
 
 int
 exec (const char *file) {
+	fflush (STDOUT_FILENO);
 	return (pid_t) syscall1 (SYS_EXEC, file);
 }
 
+int
+execve (const char *cmd_line, char *const envp[]) {
+	fflush (STDOUT_FILENO);
+	return syscall2 (SYS_EXECVE, cmd_line, envp);
+}
+
+pid_t
+spawn (const char *cmd_line, const struct spawn_action *actions,
+		int action_cnt) {
+	fflush (STDOUT_FILENO);
+	return (pid_t) syscall3 (SYS_SPAWN, cmd_line, actions, action_cnt);
+}
+
 int
 wait (pid_t pid) {
 	return syscall1 (SYS_WAIT, pid);
 }
 
+pid_t
+waitpid (pid_t pid, int *status) {
+	return (pid_t) syscall2 (SYS_WAITPID, pid, status);
+}
+
+/* 새 스레드가 처음 도는 곳. FUNC의 리턴값이 uthread_join이 받는 종료 상태다. */
+static void NO_RETURN
+uthread_start (int (*func) (void *), void *arg) {
+	uthread_exit (func (arg));
+}
+
+pid_t
+uthread_create (int (*func) (void *), void *arg, void *stack_top) {
+	return (pid_t) syscall4 (SYS_UTHREAD_CREATE, uthread_start, func, arg,
+			stack_top);
+}
+
+void
+uthread_exit (int status) {
+	syscall1 (SYS_UTHREAD_EXIT, status);
+	NOT_REACHED ();
+}
+
+int
+uthread_join (pid_t tid, int *status) {
+	return syscall2 (SYS_UTHREAD_JOIN, tid, status);
+}
+
+/* 떠 두기 전에 버퍼에 있는 출력을 내보내야 restore 한 프로세스가 다시 내보내지
+   않는다. */
+int
+checkpoint (const char *file) {
+	fflush (STDOUT_FILENO);
+	return syscall1 (SYS_CHECKPOINT, file);
+}
+
+int
+restore (const char *file) {
+	fflush (STDOUT_FILENO);
+	return syscall1 (SYS_RESTORE, file);
+}
+
 bool
 create (const char *file, unsigned initial_size) {
 	return syscall2 (SYS_CREATE, file, initial_size);
@@ -111,6 +171,11 @@ open (const char *file) {
 	return syscall1 (SYS_OPEN, file);
 }
 
+int
+open2 (const char *file, int flags) {
+	return syscall2 (SYS_OPEN2, file, flags);
+}
+
 int
 filesize (int fd) {
 	return syscall1 (SYS_FILESIZE, fd);
@@ -123,9 +188,81 @@ read (int fd, void *buffer, unsigned size) {
 
 int
 write (int fd, const void *buffer, unsigned size) {
+	/* printf로 모아 둔 출력이 먼저 나가게 한다. */
+	if (fd == STDOUT_FILENO)
+		fflush (STDOUT_FILENO);
 	return syscall3 (SYS_WRITE, fd, buffer, size);
 }
 
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+aio_read (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_AIO_READ, fd, buffer, size, offset);
+}
+
+int
+aio_write (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_AIO_WRITE, fd, buffer, size, offset);
+}
+
+int
+aio_wait (const int *ids, int n, int timeout_ms) {
+	return syscall3 (SYS_AIO_WAIT, ids, n, timeout_ms);
+}
+
+int
+aio_return (int id) {
+	return syscall1 (SYS_AIO_RETURN, id);
+}
+
+int
+poll (struct pollfd *fds, int n, int timeout_ms) {
+	return syscall3 (SYS_POLL, fds, n, timeout_ms);
+}
+
+int
+chan_create (void) {
+	return syscall0 (SYS_CHAN_CREATE);
+}
+
+int
+chan_send (int fd, const void *buffer, unsigned length) {
+	return syscall3 (SYS_CHAN_SEND, fd, buffer, length);
+}
+
+int
+chan_recv (int fd, void *buffer, unsigned length) {
+	return syscall3 (SYS_CHAN_RECV, fd, buffer, length);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	if (fd == STDOUT_FILENO)
+		fflush (STDOUT_FILENO);
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+copy_file_range (int fd_in, off_t off_in, int fd_out, off_t off_out,
+		unsigned length) {
+	return syscall5 (SYS_COPY_FILE_RANGE, fd_in, off_in, fd_out, off_out,
+			length);
+}
+
 void
 seek (int fd, unsigned position) {
 	syscall2 (SYS_SEEK, fd, position);
@@ -138,14 +275,38 @@ tell (int fd) {
 
 void
 close (int fd) {
+	if (fd == STDOUT_FILENO)
+		__stdout_reset ();
 	syscall1 (SYS_CLOSE, fd);
 }
 
 int
 dup2 (int oldfd, int newfd){
+	if (newfd == STDOUT_FILENO)
+		__stdout_reset ();
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+futex_wait (int *addr, int expected) {
+	return syscall3 (SYS_FUTEX_WAIT, addr, expected, -1);
+}
+
+int
+futex_wait_timeout (int *addr, int expected, int timeout_ms) {
+	return syscall3 (SYS_FUTEX_WAIT, addr, expected, timeout_ms);
+}
+
+int
+futex_wake (int *addr, int n) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+int
+ring_enter (struct sys_ring *ring, unsigned to_submit) {
+	return syscall2 (SYS_RING_ENTER, ring, to_submit);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -156,6 +317,21 @@ munmap (void *addr) {
 	syscall1 (SYS_MUNMAP, addr);
 }
 
+int
+madvise (void *addr, size_t length, int advice) {
+	return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+void *
+sbrk (intptr_t increment) {
+	return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+int
+getrusage (struct rusage *usage) {
+	return syscall1 (SYS_GETRUSAGE, usage);
+}
+
 bool
 chdir (const char *dir) {
 	return syscall1 (SYS_CHDIR, dir);
@@ -171,6 +347,26 @@ readdir (int fd, char name[READDIR_MAX_LEN + 1]) {
 	return syscall2 (SYS_READDIR, fd, name);
 }
 
+int
+getdents (int fd, struct dirent *ents, unsigned cnt) {
+	return syscall3 (SYS_GETDENTS, fd, ents, cnt);
+}
+
+int
+stat (const char *file, struct stat *st) {
+	return syscall2 (SYS_STAT, file, st);
+}
+
+int
+fstat (int fd, struct stat *st) {
+	return syscall2 (SYS_FSTAT, fd, st);
+}
+
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
 bool
 isdir (int fd) {
 	return syscall1 (SYS_ISDIR, fd);
@@ -186,6 +382,61 @@ symlink (const char* target, const char* linkpath) {
 	return syscall2 (SYS_SYMLINK, target, linkpath);
 }
 
+bool
+fallocate (int fd, off_t length) {
+	return syscall2 (SYS_FALLOCATE, fd, length);
+}
+
+int
+fsync (int fd) {
+	return syscall1 (SYS_FSYNC, fd);
+}
+
+int
+fsstat (struct fsstat *st) {
+	return syscall1 (SYS_FSSTAT, st);
+}
+
+int
+sysprof (struct sysprof *sp, bool self) {
+	return syscall2 (SYS_SYSPROF, sp, self);
+}
+
+int
+schedstat (struct schedstat *st, bool self) {
+	return syscall2 (SYS_SCHEDSTAT, st, self);
+}
+
+int
+sched_edf (unsigned runtime_ms, unsigned period_ms, unsigned deadline_ms) {
+	return syscall3 (SYS_SCHED_EDF, runtime_ms, period_ms, deadline_ms);
+}
+
+int
+setrlimit (int resource, long limit) {
+	return syscall2 (SYS_SETRLIMIT, resource, limit);
+}
+
+int
+msync (void *addr, size_t length, int flags) {
+	return syscall3 (SYS_MSYNC, addr, length, flags);
+}
+
+int
+shm_create (size_t size) {
+	return syscall1 (SYS_SHM_CREATE, size);
+}
+
+void *
+shm_attach (int fd, void *addr, bool writable) {
+	return (void *) syscall3 (SYS_SHM_ATTACH, fd, addr, writable);
+}
+
+int
+shm_detach (void *addr) {
+	return syscall1 (SYS_SHM_DETACH, addr);
+}
+
 int
 mount (const char *path, int chan_no, int dev_no) {
 	return syscall3 (SYS_MOUNT, path, chan_no, dev_no);
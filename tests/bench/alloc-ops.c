@@ -0,0 +1,59 @@
+/* Measures the kernel allocators in TSC cycles per allocation and
+   free pair: palloc_get_page() with and without PAL_ZERO, and
+   malloc() for a range of sizes up to a multi-page block.  Each
+   block is freed right away, so this is the fast path through the
+   free lists. */
+
+#include <stdio.h>
+#include "tests/bench/kbench.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+
+#define ROUNDS 2000
+
+static const size_t sizes[] = { 16, 64, 256, 1024, 2048, 8192 };
+
+/* Allocates and frees a page ROUNDS times with FLAGS. */
+static void
+bench_palloc (const char *metric, enum palloc_flags flags)
+{
+  uint64_t start;
+  int i;
+
+  start = kbench_cycles ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      void *page = palloc_get_page (flags);
+      if (page == NULL)
+        fail ("palloc_get_page failed");
+      palloc_free_page (page);
+    }
+  kbench_report ("alloc-ops", metric, kbench_cycles () - start, ROUNDS);
+}
+
+void
+test_alloc_ops (void)
+{
+  char metric[32];
+  uint64_t start;
+  size_t s;
+  int i;
+
+  bench_palloc ("palloc", 0);
+  bench_palloc ("palloc-zero", PAL_ZERO);
+
+  for (s = 0; s < sizeof sizes / sizeof *sizes; s++)
+    {
+      start = kbench_cycles ();
+      for (i = 0; i < ROUNDS; i++)
+        {
+          void *p = malloc (sizes[s]);
+          if (p == NULL)
+            fail ("malloc (%zu) failed", sizes[s]);
+          free (p);
+        }
+      snprintf (metric, sizeof metric, "malloc-%zu", sizes[s]);
+      kbench_report ("alloc-ops", metric, kbench_cycles () - start, ROUNDS);
+    }
+}
@@ -0,0 +1,7 @@
+/* Child process run by proc-exec.  Exits at once. */
+
+int
+main (void)
+{
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include "tests/bench/bench.h"
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+/* Returns nanoseconds since boot. */
+uint64_t
+bench_nanos (void)
+{
+  return clock_nanos ();
+}
+
+/* Prints one result line for the running benchmark. */
+void
+bench_report (const char *metric, long long value, const char *unit)
+{
+  printf ("bench %s %s %lld %s\n", test_name, metric, value, unit);
+}
+
+/* Returns how many of CNT things happened per second, given that
+   they took NS nanoseconds in all. */
+long long
+bench_per_sec (long long cnt, uint64_t ns)
+{
+  if (ns == 0)
+    ns = 1;
+  return (long long) ((unsigned long long) cnt * 1000000000ULL / ns);
+}
+
+/* Returns the nanoseconds each of CNT operations took, on average,
+   given that they took NS nanoseconds in all. */
+long long
+bench_per_op (uint64_t ns, long long cnt)
+{
+  return cnt > 0 ? (long long) (ns / cnt) : 0;
+}
@@ -0,0 +1,20 @@
+#ifndef TESTS_BENCH_BENCH_H
+#define TESTS_BENCH_BENCH_H
+
+#include <stdint.h>
+
+/* Helpers for the benchmarks in tests/bench.  A benchmark prints
+   each result as one line
+
+       bench NAME METRIC VALUE UNIT
+
+   where NAME is the benchmark, METRIC names what was measured and
+   VALUE is an integer.  "make bench" collects these lines from
+   every benchmark's output into bench.results. */
+
+uint64_t bench_nanos (void);
+void bench_report (const char *metric, long long value, const char *unit);
+long long bench_per_sec (long long cnt, uint64_t ns);
+long long bench_per_op (uint64_t ns, long long cnt);
+
+#endif /* tests/bench/bench.h */
@@ -0,0 +1,34 @@
+/* Measures disk_read() latency in TSC cycles per sector.  Reads
+   sectors spread over hd0:0 one at a time, so each read waits for
+   the device.  Kernels built without FILESYS have no disk driver
+   running and only report that the benchmark was skipped. */
+
+#include <stdio.h>
+#include "tests/bench/kbench.h"
+#include "tests/threads/tests.h"
+#ifdef FILESYS
+#include "devices/disk.h"
+#endif
+
+#define ROUNDS 256
+
+void
+test_disk_read (void)
+{
+#ifdef FILESYS
+  static uint8_t buf[DISK_SECTOR_SIZE];
+  struct disk *d = disk_get (0, 0);
+  disk_sector_t size;
+  uint64_t start;
+  int i;
+
+  if (d == NULL || (size = disk_size (d)) == 0)
+    fail ("hd0:0 not present");
+  start = kbench_cycles ();
+  for (i = 0; i < ROUNDS; i++)
+    disk_read (d, (disk_sector_t) i * 7919 % size, buf);
+  kbench_report ("disk-read", "sector", kbench_cycles () - start, ROUNDS);
+#else
+  msg ("skipped: no disk in this kernel");
+#endif
+}
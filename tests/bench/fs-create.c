@@ -0,0 +1,37 @@
+/* Measures how fast empty files can be created and removed. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 100
+
+void
+test_main (void)
+{
+  char name[16];
+  uint64_t start, ns;
+  int i;
+
+  start = bench_nanos ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+  ns = bench_nanos () - start;
+  bench_report ("create", bench_per_sec (FILE_CNT, ns), "files/s");
+
+  start = bench_nanos ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  ns = bench_nanos () - start;
+  bench_report ("remove", bench_per_sec (FILE_CNT, ns), "files/s");
+}
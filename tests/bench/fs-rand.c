@@ -0,0 +1,49 @@
+/* Measures random block I/O: reads and writes blocks at random
+   offsets in a file that is already filled in. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)
+#define BLOCK_SIZE 4096
+#define BLOCK_CNT (FILE_SIZE / BLOCK_SIZE)
+#define OPS 512
+
+static char buf[BLOCK_SIZE];
+
+void
+test_main (void)
+{
+  const char *name = "bench.dat";
+  uint64_t start, ns;
+  int fd, i;
+
+  CHECK (create (name, FILE_SIZE), "create \"%s\"", name);
+  CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+  for (i = 0; i < BLOCK_CNT; i++)
+    write (fd, buf, BLOCK_SIZE);
+  fsync (fd);
+
+  start = bench_nanos ();
+  for (i = 0; i < OPS; i++)
+    if (pread (fd, buf, BLOCK_SIZE,
+               random_ulong () % BLOCK_CNT * BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("random read %d failed", i);
+  ns = bench_nanos () - start;
+  bench_report ("read", bench_per_sec (OPS, ns), "ops/s");
+
+  start = bench_nanos ();
+  for (i = 0; i < OPS; i++)
+    if (pwrite (fd, buf, BLOCK_SIZE,
+                random_ulong () % BLOCK_CNT * BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("random write %d failed", i);
+  fsync (fd);
+  ns = bench_nanos () - start;
+  bench_report ("write", bench_per_sec (OPS, ns), "ops/s");
+
+  close (fd);
+  remove (name);
+}
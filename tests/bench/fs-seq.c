@@ -0,0 +1,42 @@
+/* Measures sequential file throughput: writes a file block by
+   block, forces it to disk, then reads it back. */
+
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)
+#define BLOCK_SIZE 4096
+
+static char buf[BLOCK_SIZE];
+
+void
+test_main (void)
+{
+  const char *name = "bench.dat";
+  uint64_t start, ns;
+  size_t ofs;
+  int fd;
+
+  CHECK (create (name, 0), "create \"%s\"", name);
+  CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+  start = bench_nanos ();
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE)
+    if (write (fd, buf, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("write at offset %zu failed", ofs);
+  fsync (fd);
+  ns = bench_nanos () - start;
+  bench_report ("write", bench_per_sec (FILE_SIZE / 1024, ns), "KB/s");
+
+  seek (fd, 0);
+  start = bench_nanos ();
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE)
+    if (read (fd, buf, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("read at offset %zu failed", ofs);
+  ns = bench_nanos () - start;
+  bench_report ("read", bench_per_sec (FILE_SIZE / 1024, ns), "KB/s");
+
+  close (fd);
+  remove (name);
+}
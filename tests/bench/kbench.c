@@ -0,0 +1,20 @@
+#include "tests/bench/kbench.h"
+#include <stdio.h>
+#include "intrinsic.h"
+
+/* Returns the TSC. */
+uint64_t
+kbench_cycles (void)
+{
+  return rdtsc ();
+}
+
+/* Prints CYCLES spent on OPS operations as cycles per operation of
+   METRIC in benchmark NAME. */
+void
+kbench_report (const char *name, const char *metric, uint64_t cycles,
+               long long ops)
+{
+  printf ("bench %s %s %llu cycles\n", name, metric,
+          (unsigned long long) (ops > 0 ? cycles / ops : 0));
+}
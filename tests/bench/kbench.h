@@ -0,0 +1,18 @@
+#ifndef TESTS_BENCH_KBENCH_H
+#define TESTS_BENCH_KBENCH_H
+
+#include <stdint.h>
+
+/* Helpers for the kernel benchmarks in tests/bench.  They time
+   with the TSC and print each result in the format of bench.h,
+
+       bench NAME METRIC VALUE cycles
+
+   where VALUE is TSC cycles per operation, so that runs before
+   and after a change to the code measured compare directly. */
+
+uint64_t kbench_cycles (void);
+void kbench_report (const char *name, const char *metric,
+                    uint64_t cycles, long long ops);
+
+#endif /* tests/bench/kbench.h */
@@ -0,0 +1,95 @@
+/* Measures the lib/kernel containers in TSC cycles per operation:
+   hash_insert() of N keys into an empty table, hash_find() of each
+   of them, list_insert_ordered() of N keys into a sorted list that
+   grows from empty, and bitmap_scan_and_flip() taking N bits one
+   at a time from an empty bitmap.  The keys come from a fixed
+   sequence, so every run does the same work. */
+
+#include <bitmap.h>
+#include <hash.h>
+#include <list.h>
+#include <stdio.h>
+#include "tests/bench/kbench.h"
+#include "tests/threads/tests.h"
+
+#define N 1024
+
+struct item
+  {
+    struct hash_elem hash_elem;
+    struct list_elem list_elem;
+    unsigned key;
+  };
+
+static struct item items[N];
+
+static uint64_t
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct item, hash_elem)->key);
+}
+
+static bool
+item_hash_less (const struct hash_elem *a, const struct hash_elem *b,
+                void *aux UNUSED)
+{
+  return (hash_entry (a, struct item, hash_elem)->key
+          < hash_entry (b, struct item, hash_elem)->key);
+}
+
+static bool
+item_list_less (const struct list_elem *a, const struct list_elem *b,
+                void *aux UNUSED)
+{
+  return (list_entry (a, struct item, list_elem)->key
+          < list_entry (b, struct item, list_elem)->key);
+}
+
+void
+test_lib_ops (void)
+{
+  struct bitmap *b;
+  struct hash h;
+  struct list l;
+  unsigned key = 1;
+  uint64_t start;
+  int i;
+
+  for (i = 0; i < N; i++)
+    {
+      key = key * 1103515245 + 12345;
+      items[i].key = key;
+    }
+
+  if (!hash_init (&h, item_hash, item_hash_less, NULL))
+    fail ("hash_init failed");
+  start = kbench_cycles ();
+  for (i = 0; i < N; i++)
+    hash_insert (&h, &items[i].hash_elem);
+  kbench_report ("lib-ops", "hash-insert", kbench_cycles () - start, N);
+
+  start = kbench_cycles ();
+  for (i = 0; i < N; i++)
+    if (hash_find (&h, &items[i].hash_elem) == NULL)
+      fail ("key %u not found", items[i].key);
+  kbench_report ("lib-ops", "hash-find", kbench_cycles () - start, N);
+  hash_destroy (&h, NULL);
+
+  list_init (&l);
+  start = kbench_cycles ();
+  for (i = 0; i < N; i++)
+    list_insert_ordered (&l, &items[i].list_elem, item_list_less, NULL);
+  kbench_report ("lib-ops", "list-insert-ordered",
+                 kbench_cycles () - start, N);
+
+  b = bitmap_create (N);
+  if (b == NULL)
+    fail ("bitmap_create failed");
+  start = kbench_cycles ();
+  for (i = 0; i < N; i++)
+    if (bitmap_scan_and_flip (b, 0, 1, false) == BITMAP_ERROR)
+      fail ("bitmap full after %d bits", i);
+  kbench_report ("lib-ops", "bitmap-scan-and-flip",
+                 kbench_cycles () - start, N);
+  bitmap_destroy (b);
+}
@@ -0,0 +1,68 @@
+/* Measures lock costs.  First one thread acquires and releases an
+   uncontended lock.  Then a higher-priority waiter is made to take
+   the lock over each time it is released.  Each round is a release
+   that hands the lock to the waiter (with the donation undone and
+   a switch), the waiter giving it back and sleeping, and the owner
+   waking the waiter, which blocks on the lock again and donates.
+   That is three switches per round. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUNDS 1000
+
+static struct lock lock;
+static struct semaphore resume, done;
+
+static void
+waiter_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ROUNDS; i++)
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+      sema_down (&resume);
+    }
+  sema_up (&done);
+}
+
+void
+test_lock_handoff (void)
+{
+  uint64_t start, ns;
+  int i;
+
+  lock_init (&lock);
+  sema_init (&resume, 0);
+  sema_init (&done, 0);
+
+  start = timer_nanos ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+    }
+  ns = timer_nanos () - start;
+  printf ("bench lock-handoff uncontended %llu ns\n",
+          (unsigned long long) (ns / ROUNDS));
+
+  lock_acquire (&lock);
+  thread_create ("waiter", PRI_DEFAULT + 1, waiter_thread, NULL);
+  start = timer_nanos ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      lock_release (&lock);
+      lock_acquire (&lock);
+      sema_up (&resume);
+    }
+  ns = timer_nanos () - start;
+  lock_release (&lock);
+  sema_down (&done);
+  printf ("bench lock-handoff handoff %llu ns\n",
+          (unsigned long long) (ns / ROUNDS));
+}
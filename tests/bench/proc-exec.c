@@ -0,0 +1,32 @@
+/* Measures the latency of starting a program: fork() + exec() of
+   a child that exits at once, then wait(). */
+
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUNDS 20
+
+void
+test_main (void)
+{
+  uint64_t start, ns;
+  int i;
+
+  start = bench_nanos ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      pid_t pid = fork ("child");
+
+      if (pid == 0)
+        {
+          exec ("bench-child");
+          exit (-1);
+        }
+      if (pid < 0 || wait (pid) != 0)
+        fail ("exec round %d failed", i);
+    }
+  ns = bench_nanos () - start;
+  bench_report ("fork_exec_wait", bench_per_op (ns, ROUNDS), "ns");
+}
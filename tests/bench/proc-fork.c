@@ -0,0 +1,28 @@
+/* Measures fork() + exit() + wait() latency. */
+
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ROUNDS 20
+
+void
+test_main (void)
+{
+  uint64_t start, ns;
+  int i;
+
+  start = bench_nanos ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      pid_t pid = fork ("child");
+
+      if (pid == 0)
+        exit (0);
+      if (pid < 0 || wait (pid) != 0)
+        fail ("fork round %d failed", i);
+    }
+  ns = bench_nanos () - start;
+  bench_report ("fork_exit_wait", bench_per_op (ns, ROUNDS), "ns");
+}
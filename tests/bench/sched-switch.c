@@ -0,0 +1,46 @@
+/* Measures the cost of a context switch: two kernel threads of the
+   same priority hand control back and forth through a pair of
+   semaphores, two switches per round. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUNDS 1000
+
+static struct semaphore ping, pong;
+
+static void
+pong_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ROUNDS; i++)
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
+
+void
+test_sched_switch (void)
+{
+  uint64_t start, ns;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("pong", PRI_DEFAULT, pong_thread, NULL);
+
+  start = timer_nanos ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  ns = timer_nanos () - start;
+  printf ("bench sched-switch switch %llu ns\n",
+          (unsigned long long) (ns / (2 * ROUNDS)));
+}
@@ -0,0 +1,96 @@
+/* Measures the synchronization primitives in TSC cycles.  First
+   one thread acquires and releases an uncontended lock and downs
+   and ups an uncontended semaphore.  Then two threads ping-pong
+   through a pair of semaphores, two switches per round.  Last,
+   several threads of the same priority take turns on one lock,
+   each yielding while it holds the lock, so that every acquire
+   finds the lock held and blocks. */
+
+#include <stdio.h>
+#include "tests/bench/kbench.h"
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUNDS 10000
+#define PINGPONG_ROUNDS 1000
+#define CONTEND_THREADS 4
+#define CONTEND_ROUNDS 250
+
+static struct lock lock;
+static struct semaphore ping, pong, done;
+
+static void
+pong_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+}
+
+static void
+contend_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < CONTEND_ROUNDS; i++)
+    {
+      lock_acquire (&lock);
+      thread_yield ();
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
+
+void
+test_synch_ops (void)
+{
+  struct semaphore sema;
+  uint64_t start;
+  int i;
+
+  lock_init (&lock);
+  start = kbench_cycles ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      lock_acquire (&lock);
+      lock_release (&lock);
+    }
+  kbench_report ("synch-ops", "lock-uncontended",
+                 kbench_cycles () - start, ROUNDS);
+
+  sema_init (&sema, 1);
+  start = kbench_cycles ();
+  for (i = 0; i < ROUNDS; i++)
+    {
+      sema_down (&sema);
+      sema_up (&sema);
+    }
+  kbench_report ("synch-ops", "sema-uncontended",
+                 kbench_cycles () - start, ROUNDS);
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("pong", PRI_DEFAULT, pong_thread, NULL);
+  start = kbench_cycles ();
+  for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  kbench_report ("synch-ops", "sema-pingpong",
+                 kbench_cycles () - start, PINGPONG_ROUNDS);
+
+  sema_init (&done, 0);
+  start = kbench_cycles ();
+  for (i = 0; i < CONTEND_THREADS; i++)
+    thread_create ("contend", PRI_DEFAULT, contend_thread, NULL);
+  for (i = 0; i < CONTEND_THREADS; i++)
+    sema_down (&done);
+  kbench_report ("synch-ops", "lock-contended",
+                 kbench_cycles () - start, CONTEND_THREADS * CONTEND_ROUNDS);
+}
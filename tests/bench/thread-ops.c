@@ -0,0 +1,34 @@
+/* Measures thread_create() and thread exit in TSC cycles.  Each
+   new thread has a higher priority than the creator, so it runs
+   at once and exits, and the creator resumes after its stack page
+   has been freed.  One round is a whole create, run and exit. */
+
+#include <stdio.h>
+#include "tests/bench/kbench.h"
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+
+#define ROUNDS 500
+
+static int ran;
+
+static void
+exit_thread (void *aux UNUSED)
+{
+  ran++;
+}
+
+void
+test_thread_ops (void)
+{
+  uint64_t start;
+  int i;
+
+  start = kbench_cycles ();
+  for (i = 0; i < ROUNDS; i++)
+    thread_create ("exit", PRI_DEFAULT + 1, exit_thread, NULL);
+  kbench_report ("thread-ops", "create-exit", kbench_cycles () - start,
+                 ROUNDS);
+  if (ran != ROUNDS)
+    fail ("only %d of %d threads ran", ran, ROUNDS);
+}
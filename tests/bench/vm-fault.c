@@ -0,0 +1,33 @@
+/* Measures the cost of a minor page fault: touches every page of
+   an anonymous mapping once. */
+
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 512
+
+void
+test_main (void)
+{
+  char *map = (char *) 0x10000000;
+  struct rusage before, after;
+  uint64_t start, ns;
+  size_t i;
+
+  CHECK (mmap (map, PAGE_CNT * PAGE_SIZE, 1 | MAP_ANON, -1, 0) == map,
+         "mmap anonymous memory");
+  getrusage (&before);
+  start = bench_nanos ();
+  for (i = 0; i < PAGE_CNT; i++)
+    map[i * PAGE_SIZE] = 1;
+  ns = bench_nanos () - start;
+  getrusage (&after);
+
+  bench_report ("faults", after.minflt - before.minflt, "faults");
+  bench_report ("fault", bench_per_op (ns, PAGE_CNT), "ns");
+  bench_report ("rate", bench_per_sec (PAGE_CNT, ns), "faults/s");
+  munmap (map);
+}
@@ -0,0 +1,41 @@
+/* Measures swap throughput: dirties more anonymous memory than the
+   machine has, so that the first pass swaps pages out, then reads
+   every page back, so that the second pass swaps them in. */
+
+#include <syscall.h>
+#include "tests/bench/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (16 * 1024 * 1024)
+#define PAGE_CNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char chunk[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  uint64_t start, ns;
+  size_t i;
+
+  getrusage (&before);
+  start = bench_nanos ();
+  for (i = 0; i < PAGE_CNT; i++)
+    chunk[i * PAGE_SIZE] = (char) i;
+  ns = bench_nanos () - start;
+  getrusage (&after);
+  bench_report ("out_evictions", after.nevict - before.nevict, "pages");
+  bench_report ("out", bench_per_sec (CHUNK_SIZE / 1024, ns), "KB/s");
+
+  before = after;
+  start = bench_nanos ();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (chunk[i * PAGE_SIZE] != (char) i)
+      fail ("page %zu is inconsistent", i);
+  ns = bench_nanos () - start;
+  getrusage (&after);
+  bench_report ("in_faults", after.majflt - before.majflt, "pages");
+  bench_report ("in", bench_per_sec (CHUNK_SIZE / 1024, ns), "KB/s");
+}
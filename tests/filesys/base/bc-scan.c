@@ -0,0 +1,69 @@
+/* Checks that a file read twice stays in the buffer cache while a
+   longer file streams through it once.  Runs with -bc=64
+   -bc-policy=2q, where only sectors that come back soon after
+   leaving the cache are kept apart from one-pass reads. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HOT_SECTORS 4
+#define FILLER_SECTORS 76
+#define STREAM_SECTORS 200
+
+static char buf[512];
+
+static void
+write_sectors (int fd, size_t cnt)
+{
+  for (size_t i = 0; i < cnt; i++)
+    if (write (fd, buf, sizeof buf) != sizeof buf)
+      fail ("write sector %zu failed", i);
+}
+
+static void
+read_sectors (int fd, size_t cnt)
+{
+  for (size_t i = 0; i < cnt; i++)
+    if (pread (fd, buf, sizeof buf, i * sizeof buf) != sizeof buf)
+      fail ("pread sector %zu failed", i);
+}
+
+void
+test_main (void) 
+{
+  static struct fsstat before, after;
+  int hot, filler, stream;
+
+  CHECK (create ("hot", 0), "create \"hot\"");
+  CHECK (create ("filler", 0), "create \"filler\"");
+  CHECK (create ("stream", 0), "create \"stream\"");
+  CHECK ((hot = open ("hot")) > 1, "open \"hot\"");
+  CHECK ((filler = open ("filler")) > 1, "open \"filler\"");
+  CHECK ((stream = open ("stream")) > 1, "open \"stream\"");
+  write_sectors (hot, HOT_SECTORS);
+  write_sectors (filler, FILLER_SECTORS);
+  write_sectors (stream, STREAM_SECTORS);
+
+  /* Read "hot" once, push it out with "filler", and read it again
+     while the cache still remembers it left. */
+  read_sectors (hot, HOT_SECTORS);
+  read_sectors (filler, FILLER_SECTORS);
+  read_sectors (hot, HOT_SECTORS);
+  msg ("read \"hot\" twice");
+
+  read_sectors (stream, STREAM_SECTORS);
+  msg ("read \"stream\" once");
+
+  CHECK (fsstat (&before) == 0, "fsstat before last read");
+  read_sectors (hot, HOT_SECTORS);
+  CHECK (fsstat (&after) == 0, "fsstat after last read");
+  if (after.bc_misses != before.bc_misses)
+    fail ("\"hot\" missed the buffer cache %ld times",
+          after.bc_misses - before.bc_misses);
+  msg ("\"hot\" stayed cached");
+
+  close (hot);
+  close (filler);
+  close (stream);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-scan) begin
+(bc-scan) create "hot"
+(bc-scan) create "filler"
+(bc-scan) create "stream"
+(bc-scan) open "hot"
+(bc-scan) open "filler"
+(bc-scan) open "stream"
+(bc-scan) read "hot" twice
+(bc-scan) read "stream" once
+(bc-scan) fsstat before last read
+(bc-scan) fsstat after last read
+(bc-scan) "hot" stayed cached
+(bc-scan) end
+EOF
+pass;
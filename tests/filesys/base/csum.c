@@ -0,0 +1,41 @@
+/* Checks the shared CRC32C routine against a known value, then
+   writes a file larger than the buffer cache on a disk formatted
+   with sector checksums and reads it back.  Evicted sectors get
+   their checksums on write-back and are verified when they are
+   read again, so a wrong checksum shows up as a kernel message. */
+
+#include <crc32c.h>
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (40 * 1024)
+
+static char buf[FILE_SIZE];
+static char back[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  int fd;
+
+  CHECK (crc32c (0, "123456789", 9) == 0xe3069283,
+         "crc32c of \"123456789\"");
+  random_init (0);
+  random_bytes (buf, sizeof buf);
+  CHECK (crc32c (crc32c (0, buf, 1001), buf + 1001, sizeof buf - 1001)
+         == crc32c (0, buf, sizeof buf), "crc32c in two pieces");
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf, "write \"data\"");
+  close (fd);
+
+  CHECK ((fd = open ("data")) > 1, "open \"data\" again");
+  CHECK (read (fd, back, sizeof back) == sizeof back, "read \"data\"");
+  close (fd);
+  if (memcmp (buf, back, sizeof buf))
+    fail ("\"data\" read back differs from what was written");
+}
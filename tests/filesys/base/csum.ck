@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(csum) begin
+(csum) crc32c of "123456789"
+(csum) crc32c in two pieces
+(csum) create "data"
+(csum) open "data"
+(csum) write "data"
+(csum) open "data" again
+(csum) read "data"
+(csum) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Creates a number of files, then lists the root directory in
+   batches with getdents() and checks that every file shows up
+   exactly once and that the directory cannot be written. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 40
+#define BATCH 7
+
+void
+test_main (void) 
+{
+  static struct dirent ents[BATCH];
+  bool seen[FILE_CNT];
+  int fd, total = 0, n;
+
+  memset (seen, 0, sizeof seen);
+  for (int i = 0; i < FILE_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "file%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+  msg ("created %d files", FILE_CNT);
+
+  CHECK ((fd = open ("/")) > 1, "open \"/\"");
+  CHECK (write (fd, "x", 1) == 0, "write to \"/\" writes nothing");
+
+  while ((n = getdents (fd, ents, BATCH)) > 0)
+    for (int i = 0; i < n; i++)
+      {
+        int idx;
+
+        if (ents[i].is_dir)
+          fail ("\"%s\" listed as a directory", ents[i].name);
+        if (memcmp (ents[i].name, "file", 4) != 0)
+          continue;
+        idx = atoi (ents[i].name + 4);
+        if (idx < 0 || idx >= FILE_CNT || seen[idx])
+          fail ("unexpected or repeated entry \"%s\"", ents[i].name);
+        seen[idx] = true;
+        total++;
+      }
+  if (n < 0)
+    fail ("getdents failed");
+  if (total != FILE_CNT)
+    fail ("listed %d files, expected %d", total, FILE_CNT);
+  msg ("listed every file once");
+
+  CHECK (getdents (fd, ents, BATCH) == 0, "getdents at end returns 0");
+  close (fd);
+}
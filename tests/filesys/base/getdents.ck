@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(getdents) begin
+(getdents) created 40 files
+(getdents) open "/"
+(getdents) write to "/" writes nothing
+(getdents) listed every file once
+(getdents) getdents at end returns 0
+(getdents) end
+EOF
+pass;
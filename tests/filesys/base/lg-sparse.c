@@ -0,0 +1,61 @@
+/* Creates a large file and checks that create() does not write
+   its zero-filled contents to disk, that reading them back does
+   not touch the disk either, and that a write in the middle of
+   the file leaves zeros on both sides of it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (2 * 1024 * 1024)
+#define MIDDLE (FILE_SIZE / 2)
+
+static char buf[4096];
+
+static void
+check_zeros (const char *what, size_t ofs, size_t size)
+{
+  for (size_t i = ofs; i < ofs + size; i++)
+    if (buf[i] != 0)
+      fail ("%s: byte %zu is %d instead of 0", what, i, buf[i]);
+}
+
+void
+test_main (void) 
+{
+  static struct fsstat before, after;
+  int fd;
+
+  CHECK (fsstat (&before) == 0, "fsstat before create");
+  CHECK (create ("sparse", FILE_SIZE), "create \"sparse\"");
+  CHECK (fsstat (&after) == 0, "fsstat after create");
+  if (after.sectors_written - before.sectors_written >= 64)
+    fail ("create wrote %ld sectors",
+          after.sectors_written - before.sectors_written);
+  msg ("create wrote few sectors");
+
+  CHECK ((fd = open ("sparse")) > 1, "open \"sparse\"");
+  CHECK (fsstat (&before) == 0, "fsstat before read");
+  seek (fd, MIDDLE);
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read from the middle");
+  CHECK (fsstat (&after) == 0, "fsstat after read");
+  check_zeros ("middle", 0, sizeof buf);
+  if (after.sectors_read != before.sectors_read)
+    fail ("read %ld sectors", after.sectors_read - before.sectors_read);
+  msg ("read zeros without reading the disk");
+
+  seek (fd, MIDDLE + 100);
+  CHECK (write (fd, "abc", 3) == 3, "write in the middle");
+  seek (fd, MIDDLE);
+  CHECK (read (fd, buf, 512) == 512, "read the written sector");
+  check_zeros ("before write", 0, 100);
+  if (memcmp (buf + 100, "abc", 3))
+    fail ("written bytes differ");
+  check_zeros ("after write", 103, 512 - 103);
+  seek (fd, 0);
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read the start");
+  check_zeros ("start", 0, sizeof buf);
+  msg ("close \"sparse\"");
+  close (fd);
+}
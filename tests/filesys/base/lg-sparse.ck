@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lg-sparse) begin
+(lg-sparse) fsstat before create
+(lg-sparse) create "sparse"
+(lg-sparse) fsstat after create
+(lg-sparse) create wrote few sectors
+(lg-sparse) open "sparse"
+(lg-sparse) fsstat before read
+(lg-sparse) read from the middle
+(lg-sparse) fsstat after read
+(lg-sparse) read zeros without reading the disk
+(lg-sparse) write in the middle
+(lg-sparse) read the written sector
+(lg-sparse) read the start
+(lg-sparse) close "sparse"
+(lg-sparse) end
+EOF
+pass;
@@ -0,0 +1,52 @@
+/* Sends data larger than the pipe's buffer from a child process
+   to its parent through a pipe, then checks that the parent sees
+   end of file once the child is gone. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE 40000
+
+static char wbuf[DATA_SIZE];
+static char rbuf[DATA_SIZE];
+
+void
+test_main (void) 
+{
+  struct stat st;
+  int fds[2];
+  size_t ofs;
+  int pid;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (fstat (fds[0], &st) == 0 && st.type == S_IFIFO, "fstat pipe");
+  CHECK (write (fds[0], "x", 1) == -1, "write to read end fails");
+
+  for (ofs = 0; ofs < DATA_SIZE; ofs++)
+    wbuf[ofs] = ofs % 251;
+
+  if ((pid = fork ("writer")) == 0)
+    {
+      close (fds[0]);
+      if (write (fds[1], wbuf, DATA_SIZE) != DATA_SIZE)
+        exit (1);
+      exit (0);
+    }
+  close (fds[1]);
+
+  /* Reads of a page or more let the writer fill RBUF directly. */
+  for (ofs = 0; ofs < DATA_SIZE; )
+    {
+      int n = read (fds[0], rbuf + ofs, DATA_SIZE - ofs);
+      if (n <= 0)
+        fail ("read returned %d at offset %zu", n, ofs);
+      ofs += n;
+    }
+  msg ("read %d bytes", DATA_SIZE);
+  compare_bytes (rbuf, wbuf, DATA_SIZE, 0, "pipe");
+
+  CHECK (wait (pid) == 0, "wait for writer");
+  CHECK (read (fds[0], rbuf, 1) == 0, "read at end of file");
+  close (fds[0]);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pipe) begin
+(pipe) pipe
+(pipe) fstat pipe
+(pipe) write to read end fails
+(pipe) read 40000 bytes
+(pipe) wait for writer
+(pipe) read at end of file
+(pipe) end
+EOF
+pass;
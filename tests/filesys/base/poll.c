@@ -0,0 +1,64 @@
+/* Waits on a pipe, a file and finished aio requests with poll:
+   an empty pipe times out, a child's write wakes the parent, the
+   child closing its end shows up as POLLHUP, and a bad descriptor
+   comes back as POLLNVAL. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct pollfd pfd[3];
+  char buf[4];
+  int fds[2];
+  int fd, id, pid;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  pfd[0].fd = fds[0];
+  pfd[0].events = POLLIN;
+  pfd[1].fd = fds[1];
+  pfd[1].events = POLLOUT;
+  CHECK (poll (pfd, 2, 0) == 1 && pfd[0].revents == 0
+         && pfd[1].revents == POLLOUT, "only the write end is ready");
+  CHECK (poll (pfd, 1, 30) == 0, "empty pipe times out");
+
+  if ((pid = fork ("writer")) == 0)
+    {
+      close (fds[0]);
+      if (write (fds[1], "abc", 3) != 3)
+        exit (1);
+      exit (0);
+    }
+  close (fds[1]);
+
+  CHECK (poll (pfd, 1, -1) == 1 && (pfd[0].revents & POLLIN),
+         "child's write wakes poll");
+  CHECK (wait (pid) == 0, "wait for writer");
+  CHECK (poll (pfd, 1, -1) == 1 && pfd[0].revents == (POLLIN | POLLHUP),
+         "closed write end gives POLLHUP");
+  CHECK (read (fds[0], buf, sizeof buf) == 3, "read 3 bytes");
+  close (fds[0]);
+
+  CHECK (create ("data", 512), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  pfd[0].fd = fd;
+  pfd[0].events = POLLIN | POLLOUT;
+  pfd[1].fd = 100;
+  pfd[1].events = POLLIN;
+  pfd[2].fd = -1;
+  pfd[2].events = POLLIN;
+  CHECK (poll (pfd, 3, -1) == 2 && pfd[0].revents == (POLLIN | POLLOUT)
+         && pfd[1].revents == POLLNVAL && pfd[2].revents == 0,
+         "file is ready, bad fd is POLLNVAL");
+
+  CHECK ((id = aio_read (fd, buf, sizeof buf, 0)) >= 0, "aio_read");
+  pfd[0].fd = POLL_AIO;
+  pfd[0].events = POLLIN;
+  CHECK (poll (pfd, 1, -1) == 1 && pfd[0].revents == POLLIN,
+         "finished aio wakes poll");
+  CHECK (aio_return (id) == sizeof buf, "aio_return");
+  CHECK (poll (pfd, 1, 0) == 0, "nothing left to collect");
+  close (fd);
+}
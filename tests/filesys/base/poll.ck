@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(poll) begin
+(poll) pipe
+(poll) only the write end is ready
+(poll) empty pipe times out
+(poll) child's write wakes poll
+(poll) wait for writer
+(poll) closed write end gives POLLHUP
+(poll) read 3 bytes
+(poll) create "data"
+(poll) open "data"
+(poll) file is ready, bad fd is POLLNVAL
+(poll) aio_read
+(poll) finished aio wakes poll
+(poll) aio_return
+(poll) nothing left to collect
+(poll) end
+EOF
+pass;
@@ -0,0 +1,71 @@
+/* Reads the statistics files under /proc while the process runs,
+   checks that /proc/self/stat follows a write made in between, and
+   that the files cannot be written, created or removed. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[4096];
+static char data[100];
+
+/* Reads all of NAME into BUF as a string.  Prints nothing on
+   success, since console output counts toward wchar. */
+static void
+read_proc (const char *name) 
+{
+  int fd, n;
+
+  if ((fd = open (name)) < 2)
+    fail ("open \"%s\" failed", name);
+  n = read (fd, buf, sizeof buf - 1);
+  if (n <= 0)
+    fail ("read \"%s\" returned %d", name, n);
+  buf[n] = '\0';
+  close (fd);
+}
+
+/* Returns the number after KEY in BUF. */
+static long
+field (const char *key) 
+{
+  char *p = strstr (buf, key);
+
+  if (p == NULL)
+    fail ("no \"%s\" in /proc/self/stat", key);
+  return atoi (p + strlen (key));
+}
+
+void
+test_main (void) 
+{
+  long before, after;
+  int fd;
+
+  read_proc ("/proc/stat");
+  CHECK (strstr (buf, "Thread:") != NULL, "/proc/stat has thread statistics");
+
+  read_proc ("/proc/self/stat");
+  CHECK (strstr (buf, "name procfs\n") != NULL, "/proc/self/stat has our name");
+
+  read_proc ("/proc/self/stat");
+  before = field ("wchar ");
+  if (!create ("data", 0) || (fd = open ("data")) < 2
+      || write (fd, data, sizeof data) != sizeof data)
+    fail ("writing \"data\" failed");
+  close (fd);
+  read_proc ("/proc/self/stat");
+  after = field ("wchar ");
+  if (after - before != (long) sizeof data)
+    fail ("wchar grew by %ld, not %zu", after - before, sizeof data);
+  msg ("wchar followed the write");
+
+  CHECK ((fd = open ("/proc/stat")) > 1, "open \"/proc/stat\"");
+  CHECK (write (fd, data, sizeof data) == 0, "write \"/proc/stat\" fails");
+  close (fd);
+  CHECK (!create ("/proc/new", 0), "create \"/proc/new\" fails");
+  CHECK (!remove ("/proc/stat"), "remove \"/proc/stat\" fails");
+  CHECK (open ("/proc/99999/stat") == -1, "open \"/proc/99999/stat\" fails");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(procfs) begin
+(procfs) /proc/stat has thread statistics
+(procfs) /proc/self/stat has our name
+(procfs) wchar followed the write
+(procfs) open "/proc/stat"
+(procfs) write "/proc/stat" fails
+(procfs) create "/proc/new" fails
+(procfs) remove "/proc/stat" fails
+(procfs) open "/proc/99999/stat" fails
+(procfs) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Checks stat() and fstat() against filesize() and against each
+   other, for a file, the root directory and the console. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct stat st, fst;
+  int fd;
+
+  CHECK (create ("quux", 1234), "create \"quux\"");
+  CHECK (stat ("quux", &st) == 0, "stat \"quux\"");
+  if (st.size != 1234 || st.type != S_IFREG || st.nlink != 1)
+    fail ("stat \"quux\": size %lld, type %d, nlink %d",
+          st.size, st.type, st.nlink);
+
+  CHECK ((fd = open ("quux")) > 1, "open \"quux\"");
+  CHECK (fstat (fd, &fst) == 0, "fstat \"quux\"");
+  if (fst.size != filesize (fd) || fst.inumber != st.inumber
+      || fst.type != S_IFREG)
+    fail ("fstat does not match stat");
+  close (fd);
+
+  CHECK (stat ("/", &st) == 0, "stat \"/\"");
+  if (st.type != S_IFDIR)
+    fail ("\"/\" is not a directory");
+  CHECK (fstat (1, &st) == 0 && st.type == S_IFCHR, "fstat stdout");
+  CHECK (stat ("no-such-file", &st) == -1, "stat missing file fails");
+}
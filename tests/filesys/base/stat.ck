@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(stat) begin
+(stat) create "quux"
+(stat) stat "quux"
+(stat) open "quux"
+(stat) fstat "quux"
+(stat) stat "/"
+(stat) fstat stdout
+(stat) stat missing file fails
+(stat) end
+EOF
+pass;
@@ -0,0 +1,42 @@
+/* Writes and reads back a file under /tmp, checks that doing so
+   allocates no clusters on disk, and that a removed file stays
+   readable through a descriptor opened before the removal. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 20000
+
+static char buf1[SIZE];
+static char buf2[SIZE];
+
+void
+test_main (void) 
+{
+  static struct fsstat before, after;
+  int fd;
+
+  random_init (0);
+  random_bytes (buf1, sizeof buf1);
+
+  CHECK (fsstat (&before) == 0, "fsstat before");
+  CHECK (create ("/tmp/scratch", 0), "create \"/tmp/scratch\"");
+  CHECK ((fd = open ("/tmp/scratch")) > 1, "open \"/tmp/scratch\"");
+  CHECK (write (fd, buf1, SIZE) == SIZE, "write \"/tmp/scratch\"");
+  CHECK (filesize (fd) == SIZE, "filesize is %d", SIZE);
+  CHECK (fsstat (&after) == 0, "fsstat after");
+  if (after.clusters_allocated != before.clusters_allocated)
+    fail ("tmpfs allocated %ld clusters",
+          after.clusters_allocated - before.clusters_allocated);
+
+  CHECK (remove ("/tmp/scratch"), "remove \"/tmp/scratch\"");
+  CHECK (open ("/tmp/scratch") == -1, "open removed file fails");
+  seek (fd, 0);
+  CHECK (read (fd, buf2, SIZE) == SIZE, "read \"/tmp/scratch\"");
+  if (memcmp (buf1, buf2, SIZE))
+    fail ("data read back differs");
+  close (fd);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(tmpfs) begin
+(tmpfs) fsstat before
+(tmpfs) create "/tmp/scratch"
+(tmpfs) open "/tmp/scratch"
+(tmpfs) write "/tmp/scratch"
+(tmpfs) filesize is 20000
+(tmpfs) fsstat after
+(tmpfs) remove "/tmp/scratch"
+(tmpfs) open removed file fails
+(tmpfs) read "/tmp/scratch"
+(tmpfs) end
+EOF
+pass;
@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+check_archive ({"direct" => ["y" x 512, substr (random_bytes (32768), 512)]});
+pass;
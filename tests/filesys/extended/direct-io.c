@@ -0,0 +1,61 @@
+/* Writes a file through a descriptor opened with O_DIRECT and
+   checks that the whole-sector write bypassed the buffer cache.
+   Then mixes cached and direct descriptors on the same file and
+   checks that each sees what the other wrote. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[32768];
+static char rbuf[32768];
+
+void
+test_main (void) 
+{
+  static struct fsstat before, after;
+  const char *file_name = "direct";
+  int dfd, fd;
+  long lookups;
+
+  random_bytes (buf, sizeof buf);
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((dfd = open2 (file_name, O_DIRECT)) > 1,
+         "open \"%s\" with O_DIRECT", file_name);
+  CHECK (open2 (file_name, 0x100) == -1, "open2 rejects unknown flags");
+  CHECK (fsstat (&before) == 0, "fsstat before write");
+  CHECK (write (dfd, buf, sizeof buf) == sizeof buf,
+         "write \"%s\"", file_name);
+  CHECK (fsstat (&after) == 0, "fsstat after write");
+  lookups = (after.bc_hits + after.bc_misses)
+            - (before.bc_hits + before.bc_misses);
+  if (lookups >= 16)
+    fail ("write made %ld buffer cache lookups", lookups);
+  msg ("write bypassed the buffer cache");
+
+  /* A cached write is seen by a direct read. */
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  memset (buf, 'x', 512);
+  CHECK (write (fd, buf, 512) == 512, "cached write of the first sector");
+  seek (dfd, 0);
+  CHECK (read (dfd, rbuf, sizeof rbuf) == sizeof rbuf, "direct read");
+  if (memcmp (buf, rbuf, sizeof buf))
+    fail ("direct read differs from what was written");
+
+  /* A direct write is seen by a cached read. */
+  memset (buf, 'y', 512);
+  seek (dfd, 0);
+  CHECK (write (dfd, buf, 512) == 512, "direct write of the first sector");
+  seek (fd, 0);
+  CHECK (read (fd, rbuf, 512) == 512, "cached read");
+  if (memcmp (buf, rbuf, 512))
+    fail ("cached read differs from what was written");
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  close (dfd);
+  check_file (file_name, buf, sizeof buf);
+}
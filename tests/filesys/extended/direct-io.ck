@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(direct-io) begin
+(direct-io) create "direct"
+(direct-io) open "direct" with O_DIRECT
+(direct-io) open2 rejects unknown flags
+(direct-io) fsstat before write
+(direct-io) write "direct"
+(direct-io) fsstat after write
+(direct-io) write bypassed the buffer cache
+(direct-io) open "direct"
+(direct-io) cached write of the first sector
+(direct-io) direct read
+(direct-io) direct write of the first sector
+(direct-io) cached read
+(direct-io) close "direct"
+(direct-io) open "direct" for verification
+(direct-io) verified contents of "direct"
+(direct-io) close "direct"
+(direct-io) end
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Preallocates space for an empty file with fallocate() and
+   checks that the file's size is updated and that the new
+   region reads back as zeros. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[20000];
+
+void
+test_main (void) 
+{
+  const char *file_name = "testfile";
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (fallocate (fd, sizeof buf), "fallocate \"%s\"", file_name);
+  if (filesize (fd) != sizeof buf)
+    fail ("filesize not updated properly: should be %zu, actually %d",
+          sizeof buf, filesize (fd));
+  CHECK (tell (fd) == 0, "tell \"%s\" unchanged", file_name);
+  CHECK (fallocate (fd, 100), "fallocate \"%s\" shorter", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  check_file (file_name, buf, sizeof buf);
+}
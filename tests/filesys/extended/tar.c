@@ -131,6 +131,30 @@ archive_ordinary_file (const char *file_name, int file_fd,
   if (!write_header (file_name, '0', file_size, 0644, archive_fd, write_error))
     return false;
 
+  /* Whole blocks go straight from FILE_FD to ARCHIVE_FD inside the
+     kernel; only the padded tail passes through BUF. */
+  if (file_size >= 512)
+    {
+      static const char zeros[512];
+      int whole = file_size / 512 * 512;
+      int copied = copy_file_range (file_fd, -1, archive_fd, -1, whole);
+
+      if (copied != whole)
+        {
+          printf ("%s: read error\n", file_name);
+          read_error = true;
+          success = false;
+          for (copied = copied > 0 ? copied : 0; copied < whole; )
+            {
+              int pad = whole - copied > 512 ? 512 : whole - copied;
+              if (!do_write (archive_fd, zeros, pad, write_error))
+                break;
+              copied += pad;
+            }
+        }
+      file_size -= whole;
+    }
+
   while (file_size > 0) 
     {
       static char buf[512];
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::mlfqs;
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# 3000 ticks split by weights 1024, 335 and 110.
+my (@weight) = (1024, 335, 110);
+my ($total) = 0;
+$total += $_ foreach @weight;
+my (@expected) = map (3000 * $_ / $total, @weight);
+
+my (@actual);
+foreach (@output) {
+    my ($id, $count) = /Thread (\d+) received (\d+) ticks\./ or next;
+    $actual[$id] = $count;
+}
+
+mlfqs_compare ("thread", "%d", \@actual, \@expected, 50, [0, $#weight, 1],
+	       "Some tick counts were missing or differed from those "
+	       . "expected by more than 50.");
+pass;
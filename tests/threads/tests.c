@@ -38,6 +38,14 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"cfs-nice", test_cfs_nice},
+    {"sched-switch", test_sched_switch},
+    {"lock-handoff", test_lock_handoff},
+    {"synch-ops", test_synch_ops},
+    {"thread-ops", test_thread_ops},
+    {"alloc-ops", test_alloc_ops},
+    {"lib-ops", test_lib_ops},
+    {"disk-read", test_disk_read},
   };
 
 static const char *test_name;
@@ -32,6 +32,14 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_cfs_nice;
+extern test_func test_sched_switch;
+extern test_func test_lock_handoff;
+extern test_func test_synch_ops;
+extern test_func test_thread_ops;
+extern test_func test_alloc_ops;
+extern test_func test_lib_ops;
+extern test_func test_disk_read;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,79 @@
+/* Writes a file in four chunks with aio_write, then keeps all four
+   chunks in flight at once with aio_read and collects them with
+   aio_wait and aio_return, checking the data and that finished ids
+   can be reused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNKS 4
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t chunk = size / CHUNKS;
+  char buf[sizeof sample];
+  int ids[CHUNKS];
+  int left, i, fd;
+
+  CHECK (create ("data", size), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  /* Submit the chunks back to front. */
+  for (i = CHUNKS - 1; i >= 0; i--)
+    {
+      size_t ofs = i * chunk;
+      size_t len = i == CHUNKS - 1 ? size - ofs : chunk;
+      ids[i] = aio_write (fd, sample + ofs, len, ofs);
+      if (ids[i] < 0)
+        fail ("aio_write chunk %d failed", i);
+    }
+  msg ("aio_write %d chunks", CHUNKS);
+  for (i = 0; i < CHUNKS; i++)
+    {
+      size_t len = i == CHUNKS - 1 ? size - i * chunk : chunk;
+      if (aio_wait (&ids[i], 1, -1) != 1)
+        fail ("aio_wait for write %d failed", i);
+      if (aio_return (ids[i]) != (int) len)
+        fail ("aio_return for write %d was short", i);
+    }
+  msg ("writes done");
+  CHECK (tell (fd) == 0, "file position unchanged");
+
+  /* All reads in flight, then collect them as they finish. */
+  memset (buf, 0, sizeof buf);
+  for (i = 0; i < CHUNKS; i++)
+    {
+      size_t ofs = i * chunk;
+      size_t len = i == CHUNKS - 1 ? size - ofs : chunk;
+      ids[i] = aio_read (fd, buf + ofs, len, ofs);
+      if (ids[i] < 0)
+        fail ("aio_read chunk %d failed", i);
+    }
+  msg ("aio_read %d chunks", CHUNKS);
+  for (left = CHUNKS; left > 0; )
+    {
+      if (aio_wait (ids, left, -1) < 1)
+        fail ("aio_wait returned nothing");
+      for (i = 0; i < left; )
+        if (aio_wait (&ids[i], 1, 0) == 1)
+          {
+            if (aio_return (ids[i]) < 0)
+              fail ("aio_return for a read failed");
+            ids[i] = ids[--left];
+          }
+        else
+          i++;
+    }
+  msg ("reads done");
+  compare_bytes (buf, sample, size, 0, "data");
+
+  CHECK (aio_return (ids[0]) == -1, "reaped id is gone");
+  CHECK (aio_read (0, buf, 1, 0) == -1, "aio_read on stdin fails");
+  msg ("close \"data\"");
+  close (fd);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-rw) begin
+(aio-rw) create "data"
+(aio-rw) open "data"
+(aio-rw) aio_write 4 chunks
+(aio-rw) writes done
+(aio-rw) file position unchanged
+(aio-rw) aio_read 4 chunks
+(aio-rw) reads done
+(aio-rw) reaped id is gone
+(aio-rw) aio_read on stdin fails
+(aio-rw) close "data"
+(aio-rw) end
+aio-rw: exit(0)
+EOF
+pass;
@@ -0,0 +1,22 @@
+/* Child process run by exec-env test.
+   Prints the value of each environment variable named on its
+   command line. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-env";
+
+int
+main (int argc, char *argv[]) 
+{
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      const char *value = getenv (argv[i]);
+      msg ("%s=%s", argv[i], value != NULL ? value : "(null)");
+    }
+  return 0;
+}
@@ -0,0 +1,27 @@
+/* Reads the clock page several times and checks that the time
+   only goes forward and that a busy loop takes some of it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  unsigned long long start, prev, now;
+  volatile int spin;
+  int i;
+
+  start = prev = clock_nanos ();
+  CHECK (start > 0, "clock is running");
+  for (i = 0; i < 1000; i++)
+    {
+      for (spin = 0; spin < 1000; spin++)
+        continue;
+      now = clock_nanos ();
+      if (now < prev)
+        fail ("clock went back from %llu to %llu", prev, now);
+      prev = now;
+    }
+  CHECK (prev > start, "clock advanced");
+}
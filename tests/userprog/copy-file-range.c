@@ -0,0 +1,32 @@
+/* Copies "sample.txt" into a second file with copy_file_range,
+   once at explicit offsets and once through the file positions. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int size = sizeof sample - 1;
+  int half = size / 2;
+  int in, out;
+
+  CHECK (create ("copy", size), "create \"copy\"");
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((out = open ("copy")) > 1, "open \"copy\"");
+  CHECK (copy_file_range (in, half, out, half, size) == size - half,
+         "copy second half at explicit offsets");
+  CHECK (tell (in) == 0 && tell (out) == 0, "file positions unchanged");
+  CHECK (copy_file_range (in, -1, out, -1, half) == half,
+         "copy first half at file positions");
+  CHECK (tell (in) == half && tell (out) == half, "file positions advanced");
+  CHECK (copy_file_range (out, 0, out, 1, 10) == -1,
+         "overlapping copy within a file rejected");
+  msg ("close \"sample.txt\"");
+  close (in);
+  msg ("close \"copy\"");
+  close (out);
+  check_file ("copy", sample, size);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-file-range) begin
+(copy-file-range) create "copy"
+(copy-file-range) open "sample.txt"
+(copy-file-range) open "copy"
+(copy-file-range) copy second half at explicit offsets
+(copy-file-range) file positions unchanged
+(copy-file-range) copy first half at file positions
+(copy-file-range) file positions advanced
+(copy-file-range) overlapping copy within a file rejected
+(copy-file-range) close "sample.txt"
+(copy-file-range) close "copy"
+(copy-file-range) open "copy" for verification
+(copy-file-range) verified contents of "copy"
+(copy-file-range) close "copy"
+(copy-file-range) end
+copy-file-range: exit(0)
+EOF
+pass;
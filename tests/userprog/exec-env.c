@@ -0,0 +1,16 @@
+/* Executes child-env with environment variables through execve()
+   and lets it look them up with getenv(). */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char *envp[] = { "FOO=bar", "EMPTY=", "FOOD=pizza", NULL };
+
+  msg ("I'm your father");
+  execve ("child-env FOO EMPTY FOOD NONE", envp);
+  fail ("execve() returned");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-env) begin
+(exec-env) I'm your father
+(child-env) FOO=bar
+(child-env) EMPTY=
+(child-env) FOOD=pizza
+(child-env) NONE=(null)
+exec-env: exit(0)
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Spawns child-simple twice, so that the second load can reuse
+   the parsed ELF headers, then overwrites the start of the
+   executable.  The next spawn must parse the modified file again
+   and fail instead of loading the old, cached headers. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  pid_t pid;
+  int handle;
+  int i;
+
+  for (i = 0; i < 2; i++)
+    {
+      CHECK ((pid = spawn ("child-simple", NULL, 0)) != PID_ERROR,
+             "spawn \"child-simple\"");
+      msg ("wait(spawn()) = %d", wait (pid));
+    }
+
+  CHECK ((handle = open ("child-simple")) > 1, "open \"child-simple\"");
+  CHECK (write (handle, "junk", 4) == 4, "overwrite ELF header");
+  close (handle);
+
+  msg ("spawn(\"child-simple\") = %d", spawn ("child-simple", NULL, 0));
+}
@@ -0,0 +1,40 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(exec-stale) begin
+(exec-stale) spawn "child-simple"
+(child-simple) run
+child-simple: exit(81)
+(exec-stale) wait(spawn()) = 81
+(exec-stale) spawn "child-simple"
+(child-simple) run
+child-simple: exit(81)
+(exec-stale) wait(spawn()) = 81
+(exec-stale) open "child-simple"
+(exec-stale) overwrite ELF header
+load: child-simple: error loading executable
+child-simple: exit(-1)
+(exec-stale) spawn("child-simple") = -1
+(exec-stale) end
+exec-stale: exit(0)
+EOF
+(exec-stale) begin
+(exec-stale) spawn "child-simple"
+(child-simple) run
+child-simple: exit(81)
+(exec-stale) wait(spawn()) = 81
+(exec-stale) spawn "child-simple"
+(child-simple) run
+child-simple: exit(81)
+(exec-stale) wait(spawn()) = 81
+(exec-stale) open "child-simple"
+(exec-stale) overwrite ELF header
+load: child-simple: error loading executable
+(exec-stale) spawn("child-simple") = -1
+(exec-stale) end
+exec-stale: exit(0)
+child-simple: exit(-1)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Forks with a file open under two descriptors that share a
+   position through dup2().  Checks that the child's reads move
+   both of its descriptors but not the parent's, and that the
+   parent's descriptors still move together afterwards. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[16];
+  pid_t pid;
+  int fd;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (dup2 (fd, 40) == 40, "dup2 to fd 40");
+  CHECK (read (fd, buf, 5) == 5, "read 5 bytes");
+
+  if ((pid = fork ("child")) == 0)
+    {
+      CHECK (read (40, buf, 10) == 10, "child reads 10 bytes");
+      CHECK (tell (fd) == 15, "child tell = %u", tell (fd));
+      seek (fd, 0);
+      CHECK (tell (40) == 0, "child seek moves both");
+      exit (0);
+    }
+  wait (pid);
+
+  CHECK (tell (fd) == 5, "parent tell = %u", tell (fd));
+  CHECK (read (fd, buf, 5) == 5, "parent reads 5 bytes");
+  CHECK (tell (40) == 10, "parent tell through fd 40 = %u", tell (40));
+}
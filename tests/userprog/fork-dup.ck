@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-dup) begin
+(fork-dup) open "sample.txt"
+(fork-dup) dup2 to fd 40
+(fork-dup) read 5 bytes
+(fork-dup) child reads 10 bytes
+(fork-dup) child tell = 15
+(fork-dup) child seek moves both
+child: exit(0)
+(fork-dup) parent tell = 5
+(fork-dup) parent reads 5 bytes
+(fork-dup) parent tell through fd 40 = 10
+(fork-dup) end
+fork-dup: exit(0)
+EOF
+pass;
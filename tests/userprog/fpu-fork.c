@@ -0,0 +1,45 @@
+/* Puts a value in an SSE register, forks, and checks that the
+   child inherits it and that the child's own use of the register
+   does not leak back into the parent. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static inline void
+set_xmm0 (uint64_t v)
+{
+  asm volatile ("movq %0, %%xmm0" : : "r" (v));
+}
+
+static inline uint64_t
+get_xmm0 (void)
+{
+  uint64_t v;
+  asm volatile ("movq %%xmm0, %0" : "=r" (v));
+  return v;
+}
+
+void
+test_main (void) 
+{
+  pid_t pid;
+
+  set_xmm0 (0x1122334455667788ULL);
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      if (get_xmm0 () != 0x1122334455667788ULL)
+        fail ("child did not inherit xmm0");
+      set_xmm0 (0xdeadbeefcafef00dULL);
+      msg ("child ok");
+      exit (81);
+    }
+  if (pid < 0)
+    fail ("fork() failed");
+  CHECK (wait (pid) == 81, "wait for child");
+  if (get_xmm0 () != 0x1122334455667788ULL)
+    fail ("parent lost xmm0");
+  msg ("parent ok");
+}
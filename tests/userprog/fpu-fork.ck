@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fpu-fork) begin
+(fpu-fork) child ok
+child: exit(81)
+(fpu-fork) wait for child
+(fpu-fork) parent ok
+(fpu-fork) end
+fpu-fork: exit(0)
+EOF
+pass;
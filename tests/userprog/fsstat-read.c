@@ -0,0 +1,27 @@
+/* Reads "sample.txt" and checks that fsstat() counts the bytes
+   and the read calls. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static struct fsstat before, after;
+  static char buf[sizeof sample];
+  int fd;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (fsstat (&before) == 0, "fsstat before reading");
+  CHECK (read (fd, buf, sizeof sample - 1) == sizeof sample - 1,
+         "read \"sample.txt\"");
+  CHECK (fsstat (&after) == 0, "fsstat after reading");
+  CHECK (after.bytes_read - before.bytes_read >= (long) sizeof sample - 1,
+         "bytes read counted");
+  CHECK (after.ops[FSSTAT_READ] > before.ops[FSSTAT_READ],
+         "read calls counted");
+  msg ("close \"sample.txt\"");
+  close (fd);
+}
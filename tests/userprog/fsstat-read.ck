@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fsstat-read) begin
+(fsstat-read) open "sample.txt"
+(fsstat-read) fsstat before reading
+(fsstat-read) read "sample.txt"
+(fsstat-read) fsstat after reading
+(fsstat-read) bytes read counted
+(fsstat-read) read calls counted
+(fsstat-read) close "sample.txt"
+(fsstat-read) end
+fsstat-read: exit(0)
+EOF
+pass;
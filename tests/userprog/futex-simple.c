@@ -0,0 +1,15 @@
+/* Calls futex_wait with a value that does not match, which must
+   return immediately, then futex_wake with nobody waiting. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static int word = 0;
+
+  CHECK (futex_wait (&word, 1) == -1, "futex_wait with a stale value");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+}
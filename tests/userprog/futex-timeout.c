@@ -0,0 +1,17 @@
+/* Waits on a futex nobody wakes with a timeout, which must
+   return the timeout code, then checks that a stale value still
+   wins over the timeout. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static int word = 0;
+
+  CHECK (futex_wait_timeout (&word, 0, 50) == -2, "futex_wait times out");
+  CHECK (futex_wait_timeout (&word, 1, 50) == -1, "futex_wait with a stale value");
+  CHECK (futex_wait_timeout (&word, 0, 0) == -2, "futex_wait with a zero timeout");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-timeout) begin
+(futex-timeout) futex_wait times out
+(futex-timeout) futex_wait with a stale value
+(futex-timeout) futex_wait with a zero timeout
+(futex-timeout) end
+futex-timeout: exit(0)
+EOF
+pass;
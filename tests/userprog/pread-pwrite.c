@@ -0,0 +1,30 @@
+/* Writes the two halves of a file out of order with pwrite and
+   reads them back with pread, checking that neither call moves
+   the file position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buf[sizeof sample];
+  int fd;
+
+  CHECK (create ("data", size), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (pwrite (fd, sample + half, size - half, half) == (int) (size - half),
+         "pwrite second half");
+  CHECK (pwrite (fd, sample, half, 0) == (int) half, "pwrite first half");
+  CHECK (tell (fd) == 0, "file position unchanged");
+  CHECK (pread (fd, buf, size, 0) == (int) size, "pread \"data\"");
+  compare_bytes (buf, sample, size, 0, "data");
+  CHECK (tell (fd) == 0, "file position unchanged");
+  msg ("close \"data\"");
+  close (fd);
+  check_file ("data", sample, size);
+}
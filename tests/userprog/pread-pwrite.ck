@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "data"
+(pread-pwrite) open "data"
+(pread-pwrite) pwrite second half
+(pread-pwrite) pwrite first half
+(pread-pwrite) file position unchanged
+(pread-pwrite) pread "data"
+(pread-pwrite) file position unchanged
+(pread-pwrite) close "data"
+(pread-pwrite) open "data" for verification
+(pread-pwrite) verified contents of "data"
+(pread-pwrite) close "data"
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,18 @@
+/* Reads from a file into the code segment, which is mapped
+   read-only.  The kernel must not write through the read-only
+   mapping on the process's behalf.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  read (handle, (void *) test_main, 123);
+  fail ("survived reading data into code segment");
+}
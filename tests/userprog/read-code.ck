@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-code) begin
+(read-code) open "sample.txt"
+read-code: exit(-1)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Reads "sample.txt" into three buffers with one readv, then
+   gathers the same buffers into a new file with one writev. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  static char a[100], b[200], c[sizeof sample];
+  struct iovec iov[3] = {
+    { a, sizeof a }, { b, sizeof b }, { c, size - sizeof a - sizeof b },
+  };
+  int fd;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (readv (fd, iov, 3) == (int) size, "readv \"sample.txt\"");
+  compare_bytes (a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes (b, sample + sizeof a, sizeof b, sizeof a, "sample.txt");
+  compare_bytes (c, sample + sizeof a + sizeof b, iov[2].iov_len,
+                 sizeof a + sizeof b, "sample.txt");
+  msg ("close \"sample.txt\"");
+  close (fd);
+
+  CHECK (create ("data", size), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (writev (fd, iov, 3) == (int) size, "writev \"data\"");
+  msg ("close \"data\"");
+  close (fd);
+  check_file ("data", sample, size);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) open "sample.txt"
+(readv-writev) readv "sample.txt"
+(readv-writev) close "sample.txt"
+(readv-writev) create "data"
+(readv-writev) open "data"
+(readv-writev) writev "data"
+(readv-writev) close "data"
+(readv-writev) open "data" for verification
+(readv-writev) verified contents of "data"
+(readv-writev) close "data"
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
@@ -0,0 +1,69 @@
+/* Writes a file out of order and reads it back with a single
+   ring_enter() call, then closes it with a second one, checking
+   every completion's result and user_data. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring;
+
+static void
+queue (int op, int fd, void *addr, unsigned len, int offset)
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->addr = addr;
+  sqe->len = len;
+  sqe->offset = offset;
+  sqe->user_data = 100 + ring.sq_tail;
+  ring.sq_tail++;
+}
+
+static void
+expect (int res)
+{
+  struct ring_cqe *cqe = &ring.cq[ring.cq_head % RING_ENTRIES];
+
+  if (cqe->user_data != 100 + ring.cq_head)
+    fail ("completion %u has user_data %llu", ring.cq_head, cqe->user_data);
+  if (cqe->res != res)
+    fail ("completion %u returned %d instead of %d",
+          ring.cq_head, cqe->res, res);
+  ring.cq_head++;
+}
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buf[sizeof sample];
+  int fd;
+
+  CHECK (create ("data", size), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  queue (RING_PWRITE, fd, sample + half, size - half, half);
+  queue (RING_PWRITE, fd, sample, half, 0);
+  queue (RING_SEEK, fd, NULL, 0, 0);
+  queue (RING_READ, fd, buf, size, 0);
+  queue (RING_NOP, 0, NULL, 0, 0);
+  CHECK (ring_enter (&ring, 5) == 5, "ring_enter 5 operations");
+  expect (size - half);
+  expect (half);
+  expect (0);
+  expect (size);
+  expect (0);
+  compare_bytes (buf, sample, size, 0, "data");
+
+  queue (RING_CLOSE, fd, NULL, 0, 0);
+  CHECK (ring_enter (&ring, 1) == 1, "ring_enter close");
+  expect (0);
+  CHECK (ring.sq_head == ring.sq_tail && ring.cq_tail == ring.cq_head,
+         "queues drained");
+  check_file ("data", sample, size);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-io) begin
+(ring-io) create "data"
+(ring-io) open "data"
+(ring-io) ring_enter 5 operations
+(ring-io) ring_enter close
+(ring-io) queues drained
+(ring-io) open "data" for verification
+(ring-io) verified contents of "data"
+(ring-io) close "data"
+(ring-io) end
+ring-io: exit(0)
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Writes and reads back a file bigger than the buffer cache,
+   checking that getrusage() counts the bytes moved by write(),
+   read() and pread(), and charges the disk sectors they caused to
+   this process. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK 4096
+#define CHUNK_CNT 32
+
+static char buf[CHUNK];
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  long long written = 0, read_back = 0;
+  int fd, i;
+
+  CHECK (create ("data", CHUNK * CHUNK_CNT), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  /* Nothing may print between the two getrusage() calls, because
+     writes to the console count too. */
+  if (getrusage (&before) != 0)
+    fail ("getrusage failed");
+  for (i = 0; i < CHUNK_CNT; i++)
+    written += write (fd, buf, CHUNK);
+  seek (fd, 0);
+  for (i = 0; i < CHUNK_CNT; i++)
+    read_back += read (fd, buf, CHUNK);
+  read_back += pread (fd, buf, CHUNK / 2, 0);
+  if (getrusage (&after) != 0)
+    fail ("getrusage failed");
+  msg ("moved the data");
+
+  if (written != CHUNK * CHUNK_CNT)
+    fail ("wrote %lld bytes", written);
+  if (after.wchar - before.wchar != written)
+    fail ("wchar grew by %lld, not %lld", after.wchar - before.wchar, written);
+  if (after.rchar - before.rchar != read_back)
+    fail ("rchar grew by %lld, not %lld", after.rchar - before.rchar, read_back);
+  if (after.inblock <= before.inblock)
+    fail ("no sectors read were charged to the process");
+  if (after.oublock <= before.oublock)
+    fail ("no sectors written were charged to the process");
+  close (fd);
+}
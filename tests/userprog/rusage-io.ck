@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rusage-io) begin
+(rusage-io) create "data"
+(rusage-io) open "data"
+(rusage-io) moved the data
+(rusage-io) end
+rusage-io: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Checks admission control of sched_edf(): a reservation must
+   satisfy runtime <= deadline <= period, and the reservations of
+   all threads may not add up to the whole CPU.  A thread's
+   reservation is given back when it exits. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Forks a child that tries to reserve RUNTIME_MS every 100 ms and
+   returns whether it got the reservation. */
+static bool
+child_reserves (unsigned runtime_ms)
+{
+  pid_t pid = fork ("child");
+
+  if (pid == 0)
+    exit (sched_edf (runtime_ms, 100, 100) == 0);
+  return wait (pid) == 1;
+}
+
+void
+test_main (void)
+{
+  CHECK (sched_edf (50, 40, 40) == -1, "runtime past deadline rejected");
+  CHECK (sched_edf (10, 40, 50) == -1, "deadline past period rejected");
+  CHECK (sched_edf (50, 100, 100) == 0, "reserve half the CPU");
+  CHECK (sched_edf (90, 100, 100) == 0, "grow own reservation");
+  CHECK (!child_reserves (10), "child rejected when CPU is full");
+  CHECK (sched_edf (0, 0, 0) == 0, "release reservation");
+  CHECK (child_reserves (90), "child admitted after release");
+  CHECK (child_reserves (90), "exited child gave its reservation back");
+}
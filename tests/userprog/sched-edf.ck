@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-edf) begin
+(sched-edf) runtime past deadline rejected
+(sched-edf) deadline past period rejected
+(sched-edf) reserve half the CPU
+(sched-edf) grow own reservation
+(sched-edf) child rejected when CPU is full
+(sched-edf) release reservation
+(sched-edf) child admitted after release
+(sched-edf) exited child gave its reservation back
+(sched-edf) end
+sched-edf: exit(0)
+EOF
+pass;
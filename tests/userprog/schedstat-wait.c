@@ -0,0 +1,35 @@
+/* Checks that schedstat() counts a parent blocking in wait() as a
+   voluntary switch followed by a wakeup, and that the system-wide
+   counters include it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct schedstat self_before, self_after, all_before, all_after;
+
+void
+test_main (void) 
+{
+  pid_t pid;
+
+  CHECK (schedstat (&self_before, true) == 0, "schedstat");
+  CHECK (schedstat (&all_before, false) == 0, "schedstat");
+  pid = fork ("child");
+  if (pid == 0)
+    exit (0);
+  CHECK (wait (pid) == 0, "wait");
+  CHECK (schedstat (&self_after, true) == 0, "schedstat");
+  CHECK (schedstat (&all_after, false) == 0, "schedstat");
+
+  CHECK (self_after.nvcsw > self_before.nvcsw, "parent blocked");
+  CHECK (self_after.wakeups > self_before.wakeups, "parent woken");
+  CHECK (self_after.wakeup_cycles > self_before.wakeup_cycles,
+         "wakeup latency recorded");
+  CHECK (self_after.ready_cycles >= self_after.wakeup_cycles,
+         "wakeups count as ready time");
+  CHECK (self_after.rq_samples == 0, "no run queue samples per thread");
+  CHECK (all_after.wakeups - all_before.wakeups
+         >= self_after.wakeups - self_before.wakeups,
+         "system counts the parent's wakeups");
+}
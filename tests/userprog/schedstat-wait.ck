@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(schedstat-wait) begin
+(schedstat-wait) schedstat
+(schedstat-wait) schedstat
+(schedstat-wait) wait
+(schedstat-wait) schedstat
+(schedstat-wait) schedstat
+(schedstat-wait) parent blocked
+(schedstat-wait) parent woken
+(schedstat-wait) wakeup latency recorded
+(schedstat-wait) wakeups count as ready time
+(schedstat-wait) no run queue samples per thread
+(schedstat-wait) system counts the parent's wakeups
+(schedstat-wait) end
+schedstat-wait: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Spawns child-read with the file it should read moved to
+   descriptor 5 by spawn()'s fd actions.  The child reads the rest
+   of the file through that descriptor, and the parent's own
+   position and descriptor must be unaffected. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/boundary.h"
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct spawn_action actions[2];
+  pid_t pid;
+  int handle;
+  int byte_cnt;
+  char *buffer;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  buffer = get_boundary_area () - sizeof sample / 2;
+  CHECK ((byte_cnt = read (handle, buffer, 20)) == 20,
+         "read \"sample.txt\" first 20 bytes");
+
+  actions[0].op = SPAWN_DUP2;
+  actions[0].fd = handle;
+  actions[0].newfd = 5;
+  actions[1].op = SPAWN_CLOSE;
+  actions[1].fd = handle;
+  CHECK ((pid = spawn ("child-read 5", actions, 2)) != PID_ERROR,
+         "spawn \"child-read 5\"");
+  wait (pid);
+
+  byte_cnt = read (handle, buffer + 20, sizeof sample - 21);
+  if (byte_cnt != sizeof sample - 21)
+    fail ("read() returned %d instead of %zu", byte_cnt, sizeof sample - 21);
+  else if (strcmp (sample, buffer)) {
+    msg ("expected text:\n%s", sample);
+    msg ("text actually read:\n%s", buffer);
+    fail ("expected text differs from actual");
+  } else {
+    msg ("Parent success");
+  }
+
+  close (handle);
+}
@@ -0,0 +1,41 @@
+/* Checks that sysprof() counts each system call once and records
+   a latency for every call that returns. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sysprof before, after;
+
+static long
+returned (const struct sysprof *sp, int nr)
+{
+  long cnt = 0;
+  int b;
+
+  for (b = 0; b < SYSPROF_BUCKETS; b++)
+    cnt += sp->latency[nr][b];
+  return cnt;
+}
+
+void
+test_main (void) 
+{
+  int i;
+
+  CHECK (sysprof (&before, false) == 0, "sysprof");
+  for (i = 0; i < 3; i++)
+    close (100);
+  CHECK (sysprof (&after, false) == 0, "sysprof");
+
+  CHECK (after.calls[SYS_CLOSE] - before.calls[SYS_CLOSE] == 3,
+         "3 close calls counted");
+  CHECK (returned (&after, SYS_CLOSE) - returned (&before, SYS_CLOSE) == 3,
+         "3 close latencies recorded");
+  CHECK (after.cycles[SYS_CLOSE] > before.cycles[SYS_CLOSE],
+         "close cycles grew");
+  CHECK (after.calls[SYS_SYSPROF] - before.calls[SYS_SYSPROF] == 1,
+         "1 sysprof call counted");
+  CHECK (sysprof (&after, true) == -1,
+         "no per-process profile without -sysprof");
+}
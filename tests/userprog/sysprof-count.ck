@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sysprof-count) begin
+(sysprof-count) sysprof
+(sysprof-count) sysprof
+(sysprof-count) 3 close calls counted
+(sysprof-count) 3 close latencies recorded
+(sysprof-count) close cycles grew
+(sysprof-count) 1 sysprof call counted
+(sysprof-count) no per-process profile without -sysprof
+(sysprof-count) end
+sysprof-count: exit(0)
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Starts two threads in the same address space.  Each one writes
+   to a global the main thread can see and returns a status that
+   uthread_join must pass back.  Joining the same thread twice or
+   joining a bad tid fails. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char stacks[2][4096] __attribute__ ((aligned (16)));
+static int slots[2];
+
+static int
+worker (void *aux)
+{
+  int *slot = aux;
+
+  *slot = 42;
+  return slot == &slots[0] ? 10 : 11;
+}
+
+void
+test_main (void) 
+{
+  pid_t tids[2];
+  int status;
+  int i;
+
+  for (i = 0; i < 2; i++)
+    {
+      tids[i] = uthread_create (worker, &slots[i], stacks[i] + sizeof stacks[i]);
+      CHECK (tids[i] > 0, "uthread_create %d", i);
+    }
+  for (i = 0; i < 2; i++)
+    {
+      CHECK (uthread_join (tids[i], &status) == 0, "uthread_join %d", i);
+      if (status != 10 + i)
+        fail ("thread %d returned %d", i, status);
+      if (slots[i] != 42)
+        fail ("thread %d did not write shared memory", i);
+    }
+  CHECK (uthread_join (tids[0], &status) == -1, "join a joined thread");
+  CHECK (uthread_join (-1, NULL) == -1, "join a bad tid");
+}
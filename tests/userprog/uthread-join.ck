@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread-join) begin
+(uthread-join) uthread_create 0
+(uthread-join) uthread_create 1
+(uthread-join) uthread_join 0
+(uthread-join) uthread_join 1
+(uthread-join) join a joined thread
+(uthread-join) join a bad tid
+(uthread-join) end
+uthread-join: exit(0)
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Forks several children and reaps them with waitpid(-1), which
+   must return each child exactly once with its exit status, then
+   -1 once no children are left. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+
+void
+test_main (void) 
+{
+  pid_t pids[CHILD_CNT];
+  bool reaped[CHILD_CNT] = { false };
+  int i, j;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        exit (80 + i);
+      CHECK (pids[i] > 0, "fork child %d", i);
+    }
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      int status;
+      pid_t pid = waitpid (-1, &status);
+
+      for (j = 0; j < CHILD_CNT; j++)
+        if (pids[j] == pid)
+          break;
+      if (j == CHILD_CNT || reaped[j])
+        fail ("waitpid returned unexpected pid %d", pid);
+      if (status != 80 + j)
+        fail ("child %d exited with %d, expected %d", j, status, 80 + j);
+      reaped[j] = true;
+    }
+  msg ("reaped all children");
+
+  CHECK (waitpid (-1, NULL) == -1, "waitpid with no children");
+  CHECK (wait (pids[0]) == -1, "wait for a reaped child");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(waitpid-any) begin
+(waitpid-any) fork child 0
+(waitpid-any) fork child 1
+(waitpid-any) fork child 2
+(waitpid-any) fork child 3
+(waitpid-any) reaped all children
+(waitpid-any) waitpid with no children
+(waitpid-any) wait for a reaped child
+(waitpid-any) end
+EOF
+pass;
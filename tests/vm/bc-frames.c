@@ -0,0 +1,71 @@
+/* Runs with an 8-sector buffer cache, so most sectors of a 64 kB
+   file live in page cache frames after being pushed out of the
+   buffer cache.  Writes the file, reads it back, rewrites every
+   other sector and reads it back again, checking the data each
+   time. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SECTOR 512
+#define FILE_SECTORS 128
+
+static char buf[SECTOR];
+
+static void
+fill (int sector, int round)
+{
+  memset (buf, sector * 7 + round, SECTOR);
+}
+
+static void
+check (int fd, const char *what)
+{
+  char expected[SECTOR];
+  int i;
+
+  seek (fd, 0);
+  for (i = 0; i < FILE_SECTORS; i++)
+    {
+      fill (i, i % 2 ? 0 : 1);
+      memcpy (expected, buf, SECTOR);
+      if (read (fd, buf, SECTOR) != SECTOR)
+        fail ("read of sector %d failed", i);
+      if (memcmp (buf, expected, SECTOR))
+        fail ("sector %d holds bad data %s", i, what);
+    }
+}
+
+void
+test_main (void)
+{
+  int fd, i;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  msg ("write file");
+  for (i = 0; i < FILE_SECTORS; i++)
+    {
+      fill (i, 0);
+      if (write (fd, buf, SECTOR) != SECTOR)
+        fail ("write of sector %d failed", i);
+    }
+
+  msg ("rewrite even sectors");
+  for (i = 0; i < FILE_SECTORS; i += 2)
+    {
+      fill (i, 1);
+      seek (fd, i * SECTOR);
+      if (write (fd, buf, SECTOR) != SECTOR)
+        fail ("rewrite of sector %d failed", i);
+    }
+
+  msg ("read file");
+  check (fd, "after rewriting");
+  msg ("read file again");
+  check (fd, "on the second read");
+  close (fd);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-frames) begin
+(bc-frames) create "data"
+(bc-frames) open "data"
+(bc-frames) write file
+(bc-frames) rewrite even sectors
+(bc-frames) read file
+(bc-frames) read file again
+(bc-frames) end
+EOF
+pass;
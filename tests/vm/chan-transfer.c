@@ -0,0 +1,94 @@
+/* Sends page-aligned messages over a channel and checks that whole
+   pages reach the receiver without being copied, that the sender's
+   later writes do not leak into the received copy, and that
+   unaligned buffers and a forked sender still get the right bytes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 16
+#define MSG_SIZE (PAGES * 4096 + 100)
+
+static void
+fill (char *p, size_t size, char seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    p[i] = seed + i % 251;
+}
+
+static void
+verify (const char *p, size_t size, char seed, const char *what)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != (char) (seed + i % 251))
+      fail ("byte %zu of %s is wrong", i, what);
+}
+
+void
+test_main (void)
+{
+  char *src = (char *) 0x10000000;
+  char *dst = (char *) 0x20000000;
+  char small[64];
+  struct stat st;
+  size_t i;
+  pid_t child;
+  int ch;
+
+  CHECK (mmap (src, (PAGES + 1) * 4096, 1 | MAP_ANON, -1, 0) == src,
+         "mmap source");
+  CHECK (mmap (dst, (PAGES + 1) * 4096, 1 | MAP_ANON, -1, 0) == dst,
+         "mmap destination");
+  CHECK ((ch = chan_create ()) > 1, "chan_create");
+  fill (src, MSG_SIZE, 'a');
+
+  CHECK (chan_send (ch, src, MSG_SIZE) == MSG_SIZE, "send aligned message");
+  CHECK (fstat (ch, &st) == 0 && st.type == S_IFCHAN && st.size == MSG_SIZE,
+         "fstat channel");
+  CHECK (chan_recv (ch, dst, MSG_SIZE) == MSG_SIZE, "receive aligned message");
+  verify (dst, MSG_SIZE, 'a', "received message");
+  for (i = 0; i < PAGES; i++)
+    if (get_phys_addr (dst + i * 4096) != get_phys_addr (src + i * 4096))
+      fail ("page %zu was copied", i);
+
+  /* The sender keeps its pages; writing them must not change the
+     received message, and writing the received pages must not
+     change the sender's. */
+  src[0] = 'X';
+  dst[4096] = 'Y';
+  if (dst[0] != 'a' || src[4096] != (char) ('a' + 4096 % 251))
+    fail ("pages still shared after a write");
+
+  /* A receive buffer that is too small takes the front of the
+     message, and an unaligned one is filled by copying. */
+  CHECK (chan_send (ch, src + 4096, 4096) == 4096, "send one page");
+  CHECK (chan_recv (ch, small, sizeof small) == sizeof small,
+         "receive into small buffer");
+  verify (small, sizeof small, 'a' + 4096 % 251, "small buffer");
+  CHECK (chan_send (ch, src + 4096, 2 * 4096) == 2 * 4096, "send two pages");
+  CHECK (chan_recv (ch, dst + 1, 2 * 4096) == 2 * 4096,
+         "receive into unaligned buffer");
+  verify (dst + 1, 2 * 4096, 'a' + 4096 % 251, "unaligned buffer");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      fill (src, MSG_SIZE, 'k');
+      chan_send (ch, src, MSG_SIZE);
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for sender");
+  CHECK (chan_recv (ch, dst, MSG_SIZE) == MSG_SIZE, "receive from child");
+  verify (dst, MSG_SIZE, 'k', "message from child");
+  if (src[0] != 'X')
+    fail ("child's pages leaked into parent");
+
+  CHECK (chan_send (ch, src, CHAN_MSG_MAX + 1) == -1, "oversized send fails");
+  close (ch);
+}
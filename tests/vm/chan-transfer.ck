@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(chan-transfer) begin
+(chan-transfer) mmap source
+(chan-transfer) mmap destination
+(chan-transfer) chan_create
+(chan-transfer) send aligned message
+(chan-transfer) fstat channel
+(chan-transfer) receive aligned message
+(chan-transfer) send one page
+(chan-transfer) receive into small buffer
+(chan-transfer) send two pages
+(chan-transfer) receive into unaligned buffer
+(chan-transfer) wait for sender
+(chan-transfer) receive from child
+(chan-transfer) oversized send fails
+(chan-transfer) end
+EOF
+pass;
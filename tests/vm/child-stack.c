@@ -0,0 +1,30 @@
+/* Child process run by pt-grow-chunk.  Its stack was reserved
+   at exec, so touching 128 kB of it must not grow the stack. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 32
+
+const char *test_name = "child-stack";
+
+int
+main (void)
+{
+  volatile char stk_obj[PAGE_CNT * PAGE_SIZE];
+  struct rusage before, after;
+  size_t i;
+
+  CHECK (getrusage (&before) == 0, "getrusage");
+  for (i = 0; i < PAGE_CNT; i++)
+    stk_obj[i * PAGE_SIZE] = i;
+  CHECK (getrusage (&after) == 0, "getrusage after touching the stack");
+  if (after.nstack != before.nstack)
+    fail ("%ld stack growths in the reserved stack",
+          after.nstack - before.nstack);
+  for (i = 0; i < PAGE_CNT; i++)
+    if (stk_obj[i * PAGE_SIZE] != (char) i)
+      fail ("stack page %zu is inconsistent", i);
+  return 0;
+}
@@ -0,0 +1,62 @@
+/* Warms up a process (heap, a big mapped block, a data file read
+   part of the way), saves it with checkpoint(), then replaces the
+   process with restore().  The restored image must come back from
+   checkpoint() with 1 and find memory and the file position as
+   they were. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BIG_SIZE (64 * 1024)
+
+static int table[1024];
+
+void
+test_main (void)
+{
+  char *small, *big;
+  char buf[4];
+  int fd, ret;
+  size_t i;
+
+  for (i = 0; i < sizeof table / sizeof *table; i++)
+    table[i] = i * i;
+  small = malloc (100);
+  big = malloc (BIG_SIZE);
+  CHECK (small != NULL && big != NULL, "malloc");
+  strlcpy (small, "grilled salmon", 100);
+  for (i = 0; i < BIG_SIZE; i++)
+    big[i] = i % 251;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (write (fd, "abcdef", 6) == 6, "write \"data\"");
+  seek (fd, 3);
+
+  ret = checkpoint ("image");
+  if (ret == 0)
+    {
+      msg ("checkpoint saved");
+      /* Spoil everything the image should bring back. */
+      memset (table, 0, sizeof table);
+      small[0] = '\0';
+      seek (fd, 0);
+      restore ("image");
+      fail ("restore returned");
+    }
+  CHECK (ret == 1, "checkpoint returned %d after restore", ret);
+
+  for (i = 0; i < sizeof table / sizeof *table; i++)
+    if (table[i] != (int) (i * i))
+      fail ("table[%zu] is %d", i, table[i]);
+  CHECK (!strcmp (small, "grilled salmon"), "heap block came back");
+  for (i = 0; i < BIG_SIZE; i++)
+    if (big[i] != (char) (i % 251))
+      fail ("big block byte %zu is %d", i, big[i]);
+  msg ("big block came back");
+  CHECK (tell (fd) == 3, "file position came back");
+  CHECK (read (fd, buf, 3) == 3 && !memcmp (buf, "def", 3), "read the rest");
+}
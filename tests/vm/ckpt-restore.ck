@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ckpt-restore) begin
+(ckpt-restore) malloc
+(ckpt-restore) create "data"
+(ckpt-restore) open "data"
+(ckpt-restore) write "data"
+(ckpt-restore) checkpoint saved
+(ckpt-restore) checkpoint returned 1 after restore
+(ckpt-restore) heap block came back
+(ckpt-restore) big block came back
+(ckpt-restore) file position came back
+(ckpt-restore) read the rest
+(ckpt-restore) end
+ckpt-restore: exit(0)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Touches fresh anonymous pages and a mapped file, checking that
+   getrusage() counts minor faults, major faults and resident pages. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  char *map = (char *) 0x10000000;
+  struct rusage before, after;
+  int handle;
+  size_t i;
+
+  CHECK (getrusage (&before) == 0, "getrusage");
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = 1;
+  CHECK (getrusage (&after) == 0, "getrusage after touching memory");
+  if (after.minflt < before.minflt + PAGE_CNT)
+    fail ("minor faults went from %ld to %ld", before.minflt, after.minflt);
+  if (after.rss < before.rss + PAGE_CNT)
+    fail ("resident pages went from %ld to %ld", before.rss, after.rss);
+
+  before = after;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (map, PAGE_SIZE, 0, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  if (memcmp (map, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+  CHECK (getrusage (&after) == 0, "getrusage after reading the file");
+  if (after.majflt <= before.majflt)
+    fail ("major faults did not grow from %ld", before.majflt);
+}
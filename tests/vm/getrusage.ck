@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(getrusage) begin
+(getrusage) getrusage
+(getrusage) getrusage after touching memory
+(getrusage) open "sample.txt"
+(getrusage) mmap "sample.txt"
+(getrusage) getrusage after reading the file
+(getrusage) end
+EOF
+pass;
@@ -0,0 +1,65 @@
+/* Exercises the user malloc: many small blocks of every size
+   class, a block big enough to be mapped on its own, realloc that
+   keeps the contents, and reuse of freed memory. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SMALL_CNT 256
+#define BIG_SIZE (64 * 1024)
+
+void
+test_main (void)
+{
+  static char *small[SMALL_CNT];
+  char *big, *p, *q;
+  size_t i;
+
+  for (i = 0; i < SMALL_CNT; i++)
+    {
+      size_t size = 1 + (i * 37) % 2000;
+
+      small[i] = malloc (size);
+      if (small[i] == NULL)
+        fail ("malloc %zu bytes failed", size);
+      memset (small[i], i, size);
+    }
+  for (i = 0; i < SMALL_CNT; i++)
+    {
+      size_t size = 1 + (i * 37) % 2000;
+      size_t j;
+
+      for (j = 0; j < size; j++)
+        if (small[i][j] != (char) i)
+          fail ("block %zu byte %zu is %d", i, j, small[i][j]);
+    }
+  msg ("small blocks hold their contents");
+
+  big = malloc (BIG_SIZE);
+  CHECK (big != NULL, "malloc %d bytes", BIG_SIZE);
+  for (i = 0; i < BIG_SIZE; i++)
+    big[i] = i % 251;
+  for (i = 0; i < BIG_SIZE; i++)
+    if (big[i] != (char) (i % 251))
+      fail ("big block byte %zu is %d", i, big[i]);
+  free (big);
+  msg ("big block holds its contents");
+
+  p = malloc (10);
+  strlcpy (p, "salmon", 10);
+  q = realloc (p, 5000);
+  CHECK (q != NULL && !strcmp (q, "salmon"), "realloc keeps the contents");
+  free (q);
+
+  for (i = 0; i < SMALL_CNT; i++)
+    free (small[i]);
+  p = calloc (64, 8);
+  CHECK (p != NULL, "calloc after freeing everything");
+  for (i = 0; i < 64 * 8; i++)
+    if (p[i] != 0)
+      fail ("calloc byte %zu is %d", i, p[i]);
+  free (p);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-user) begin
+(malloc-user) small blocks hold their contents
+(malloc-user) malloc 65536 bytes
+(malloc-user) big block holds its contents
+(malloc-user) realloc keeps the contents
+(malloc-user) calloc after freeing everything
+(malloc-user) end
+malloc-user: exit(0)
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Maps anonymous memory with MAP_ANON, which needs no file, checks
+   that it reads as zeros and holds writes, then unmaps it and
+   verifies that it is gone. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MAP_SIZE (64 * 4096)
+
+void
+test_main (void)
+{
+  char *map = (char *) 0x10000000;
+  size_t i;
+
+  CHECK (mmap (map, MAP_SIZE, 1 | MAP_ANON, -1, 0) == map,
+         "mmap anonymous memory");
+  for (i = 0; i < MAP_SIZE; i++)
+    if (map[i] != 0)
+      fail ("byte %zu of anonymous map is %d, not 0", i, map[i]);
+  msg ("anonymous map reads as zero");
+  for (i = 0; i < MAP_SIZE; i++)
+    map[i] = i;
+  for (i = 0; i < MAP_SIZE; i++)
+    if (map[i] != (char) i)
+      fail ("byte %zu reads %d after write", i, map[i]);
+  msg ("anonymous map holds writes");
+
+  CHECK (mmap (map, 4096, 1 | MAP_ANON, -1, 0) == MAP_FAILED,
+         "try to map over it again");
+  munmap (map);
+  msg ("munmap");
+
+  fail ("unmapped memory is readable (%d)", *map);
+}
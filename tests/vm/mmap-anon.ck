@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mmap-anon) begin
+(mmap-anon) mmap anonymous memory
+(mmap-anon) anonymous map reads as zero
+(mmap-anon) anonymous map holds writes
+(mmap-anon) try to map over it again
+(mmap-anon) munmap
+mmap-anon: exit(-1)
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Maps a file with MAP_POPULATE, then drops and prefetches its
+   pages with madvise(), checking which pages are loaded. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/small.inc"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT ((sizeof small + PAGE_SIZE - 1) / PAGE_SIZE)
+
+static void
+check_loaded (char *map, bool loaded)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if ((get_phys_addr (map + i * PAGE_SIZE) != 0) != loaded)
+      fail ("page %zu should%s be loaded", i, loaded ? "" : " not");
+}
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  size_t length = PAGE_CNT * PAGE_SIZE;
+  int handle;
+  void *map;
+
+  CHECK ((handle = open ("small.txt")) > 1, "open \"small.txt\"");
+  CHECK ((map = mmap (actual, length, MAP_POPULATE, handle, 0)) != MAP_FAILED,
+         "mmap \"small.txt\" with MAP_POPULATE");
+  msg ("check that all pages are loaded");
+  check_loaded (actual, true);
+
+  CHECK (madvise (actual, length, MADV_DONTNEED) == 0, "madvise MADV_DONTNEED");
+  check_loaded (actual, false);
+
+  CHECK (madvise (actual, length, MADV_WILLNEED) == 0, "madvise MADV_WILLNEED");
+  check_loaded (actual, true);
+  if (memcmp (actual, small, sizeof small - 1))
+    fail ("read of mmap'd file reported bad data");
+
+  CHECK (madvise (actual + length, PAGE_SIZE, MADV_WILLNEED) == -1,
+         "madvise on an unmapped page");
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) open "small.txt"
+(mmap-madvise) mmap "small.txt" with MAP_POPULATE
+(mmap-madvise) check that all pages are loaded
+(mmap-madvise) madvise MADV_DONTNEED
+(mmap-madvise) madvise MADV_WILLNEED
+(mmap-madvise) madvise on an unmapped page
+(mmap-madvise) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Writes to a file through a mapping and flushes the write with
+   msync() while the file stays mapped, then reads the data back
+   with read() to verify.  Also checks that msync() rejects bad
+   arguments. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", 2 * 4096), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (ACTUAL, 2 * 4096, 1, handle, 0) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK (msync (ACTUAL + 1, 4096, MS_SYNC) == -1, "msync misaligned address");
+  CHECK (msync (ACTUAL, 3 * 4096, MS_SYNC) == -1, "msync past the mapping");
+  CHECK (msync (ACTUAL, 4096, MS_SYNC | MS_ASYNC) == -1, "msync bad flags");
+
+  memcpy (ACTUAL, sample, strlen (sample));
+  memcpy (ACTUAL + 4096, sample, strlen (sample));
+  CHECK (msync (ACTUAL, 4096, MS_SYNC) == 0, "msync first page");
+  CHECK (msync (ACTUAL + 4096, 4096, MS_ASYNC) == 0, "msync second page async");
+  CHECK (msync (ACTUAL, 2 * 4096, 0) == 0, "msync whole mapping");
+
+  /* Read back via read() without unmapping. */
+  read (handle, buf, strlen (sample));
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare first page against written data");
+  seek (handle, 4096);
+  read (handle, buf, strlen (sample));
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare second page against written data");
+  close (handle);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-msync) begin
+(mmap-msync) create "sample.txt"
+(mmap-msync) open "sample.txt"
+(mmap-msync) mmap "sample.txt"
+(mmap-msync) msync misaligned address
+(mmap-msync) msync past the mapping
+(mmap-msync) msync bad flags
+(mmap-msync) msync first page
+(mmap-msync) msync second page async
+(mmap-msync) msync whole mapping
+(mmap-msync) compare first page against written data
+(mmap-msync) compare second page against written data
+(mmap-msync) end
+EOF
+pass;
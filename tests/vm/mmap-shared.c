@@ -0,0 +1,45 @@
+/* Maps the same file twice and once more from a forked child,
+   checking that all mappings share one physical page and see
+   each other's writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *map1 = (char *) 0x10000000;
+  char *map2 = (char *) 0x20000000;
+  void *phys;
+  int handle;
+  pid_t child;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (map1, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  CHECK (mmap (map2, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\" again");
+  if (memcmp (map1, sample, strlen (sample))
+      || memcmp (map2, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+  phys = get_phys_addr (map1);
+  if (get_phys_addr (map2) != phys)
+    fail ("mappings of the same offset use different pages");
+
+  map1[0] = 'S';
+  if (map2[0] != 'S')
+    fail ("write through one mapping not seen by the other");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      if (map1[0] != 'S' || get_phys_addr (map1) != phys)
+        fail ("child does not share the parent's page");
+      map2[1] = 'H';
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+  if (map1[1] != 'H')
+    fail ("write from child not seen by parent");
+}
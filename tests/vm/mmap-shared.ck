@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-shared) begin
+(mmap-shared) open "sample.txt"
+(mmap-shared) mmap "sample.txt"
+(mmap-shared) mmap "sample.txt" again
+(mmap-shared) wait for child
+(mmap-shared) end
+EOF
+pass;
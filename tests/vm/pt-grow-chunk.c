@@ -0,0 +1,34 @@
+/* Touches a 128 kB stack object one page at a time from its low
+   end, checking that the stack grows several pages per fault.
+   Then runs child-stack with STACK_RESERVE set, which touches as
+   much stack without growing it at all. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 32
+
+void
+test_main (void)
+{
+  volatile char stk_obj[PAGE_CNT * PAGE_SIZE];
+  char *envp[] = { "STACK_RESERVE=256", NULL };
+  struct rusage before, after;
+  size_t i;
+
+  CHECK (getrusage (&before) == 0, "getrusage");
+  for (i = 0; i < PAGE_CNT; i++)
+    stk_obj[i * PAGE_SIZE] = i;
+  CHECK (getrusage (&after) == 0, "getrusage after touching the stack");
+  if (after.nstack - before.nstack > PAGE_CNT / 8 + 1)
+    fail ("%ld stack growths for %d pages", after.nstack - before.nstack,
+          PAGE_CNT);
+  for (i = 0; i < PAGE_CNT; i++)
+    if (stk_obj[i * PAGE_SIZE] != (char) i)
+      fail ("stack page %zu is inconsistent", i);
+
+  execve ("child-stack", envp);
+  fail ("execve() returned");
+}
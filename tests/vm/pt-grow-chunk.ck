@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pt-grow-chunk) begin
+(pt-grow-chunk) getrusage
+(pt-grow-chunk) getrusage after touching the stack
+(child-stack) getrusage
+(child-stack) getrusage after touching the stack
+pt-grow-chunk: exit(0)
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Limits the process to 64 resident pages with setrlimit(), then
+   writes 1 MB of memory, checking that the process never holds
+   more than its limit and that the pages it had to give up come
+   back from swap intact. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define LIMIT_PAGES 64
+#define BUF_PAGES 256
+
+static char buf[BUF_PAGES * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct rusage usage;
+  size_t i;
+
+  CHECK (setrlimit (-1, 0) == -1, "setrlimit with a bad resource");
+  CHECK (setrlimit (RLIMIT_RSS, LIMIT_PAGES * PAGE_SIZE) == 0,
+         "limit RSS to %d pages", LIMIT_PAGES);
+
+  msg ("write buffer");
+  for (i = 0; i < BUF_PAGES; i++)
+    {
+      buf[i * PAGE_SIZE] = i;
+      if (i % 32 == 31)
+        {
+          getrusage (&usage);
+          if (usage.rss > LIMIT_PAGES)
+            fail ("%ld resident pages after %zu, limit %d",
+                  usage.rss, i + 1, LIMIT_PAGES);
+        }
+    }
+
+  msg ("check buffer");
+  for (i = 0; i < BUF_PAGES; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("page %zu is inconsistent", i);
+
+  CHECK (getrusage (&usage) == 0, "getrusage");
+  if (usage.nevict == 0)
+    fail ("no pages evicted");
+  if (usage.rss > LIMIT_PAGES)
+    fail ("%ld resident pages, limit %d", usage.rss, LIMIT_PAGES);
+}
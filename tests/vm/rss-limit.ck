@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rss-limit) begin
+(rss-limit) setrlimit with a bad resource
+(rss-limit) limit RSS to 64 pages
+(rss-limit) write buffer
+(rss-limit) check buffer
+(rss-limit) getrusage
+(rss-limit) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Grows the heap with sbrk(), checks that the new memory starts
+   zeroed and keeps what is written to it, forks a child that sees
+   a copy of the heap, then shrinks the heap back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HEAP_SIZE (256 * 1024)
+
+void
+test_main (void)
+{
+  char *base, *top;
+  size_t i;
+  pid_t child;
+
+  base = sbrk (0);
+  CHECK (base != (void *) -1, "sbrk (0)");
+  CHECK (sbrk (HEAP_SIZE) == base, "sbrk (%d)", HEAP_SIZE);
+  top = sbrk (0);
+  CHECK (top == base + HEAP_SIZE, "break moved by %d bytes", HEAP_SIZE);
+
+  for (i = 0; i < HEAP_SIZE; i++)
+    if (base[i] != 0)
+      fail ("byte %zu of new heap is %d, not 0", i, base[i]);
+  for (i = 0; i < HEAP_SIZE; i += 4096)
+    base[i] = i / 4096;
+  msg ("heap written");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      for (i = 0; i < HEAP_SIZE; i += 4096)
+        if (base[i] != (char) (i / 4096))
+          fail ("child sees byte %zu as %d", i, base[i]);
+      exit (81);
+    }
+  CHECK (wait (child) == 81, "child sees the heap");
+
+  CHECK (sbrk (-HEAP_SIZE) == top, "sbrk (%d)", -HEAP_SIZE);
+  CHECK (sbrk (0) == base, "break back at the start");
+  CHECK (sbrk (-1) == (void *) -1, "sbrk below the heap fails");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sbrk-heap) begin
+(sbrk-heap) sbrk (0)
+(sbrk-heap) sbrk (262144)
+(sbrk-heap) break moved by 262144 bytes
+(sbrk-heap) heap written
+child: exit(81)
+(sbrk-heap) child sees the heap
+(sbrk-heap) sbrk (-262144)
+(sbrk-heap) break back at the start
+(sbrk-heap) sbrk below the heap fails
+(sbrk-heap) end
+sbrk-heap: exit(0)
+EOF
+pass;
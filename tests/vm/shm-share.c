@@ -0,0 +1,53 @@
+/* Creates a shared memory segment, attaches it twice and from a
+   forked child, and checks that every attachment uses the same
+   physical pages and sees the others' writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SEG_SIZE (3 * 4096 + 100)
+
+void
+test_main (void)
+{
+  char *map1 = (char *) 0x10000000;
+  char *map2 = (char *) 0x20000000;
+  char *ro = (char *) 0x30000000;
+  struct stat st;
+  size_t i;
+  pid_t child;
+  int fd;
+
+  CHECK ((fd = shm_create (SEG_SIZE)) > 1, "shm_create");
+  CHECK (fstat (fd, &st) == 0 && st.type == S_IFSHM && st.size == 4 * 4096,
+         "fstat segment");
+  CHECK (shm_attach (fd, map1, true) == map1, "attach");
+  CHECK (shm_attach (fd, map2, true) == map2, "attach again");
+  for (i = 0; i < 4 * 4096; i++)
+    if (map1[i] != 0)
+      fail ("byte %zu of new segment is %d", i, map1[i]);
+
+  strlcpy (map1, "parent", 4096);
+  if (strcmp (map2, "parent") || get_phys_addr (map1) != get_phys_addr (map2))
+    fail ("attachments do not share a page");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      strlcpy (map2 + 3 * 4096, "child", 4096);
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+  if (strcmp (map1 + 3 * 4096, "child"))
+    fail ("write from child not seen by parent");
+
+  CHECK (shm_detach (map2) == 0, "detach");
+  CHECK (shm_detach (map2) == -1, "detach again fails");
+  CHECK (shm_attach (fd, ro, false) == ro, "attach read-only");
+  close (fd);
+  if (strcmp (ro, "parent") || strcmp (map1, "parent"))
+    fail ("segment lost its contents after close");
+  CHECK (shm_detach (map1) == 0 && shm_detach (ro) == 0, "detach the rest");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-share) begin
+(shm-share) shm_create
+(shm-share) fstat segment
+(shm-share) attach
+(shm-share) attach again
+(shm-share) wait for child
+(shm-share) detach
+(shm-share) detach again fails
+(shm-share) attach read-only
+(shm-share) detach the rest
+(shm-share) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Streams once through 6 MB of memory while touching a small
+   hot set between every few pages, with the 2q eviction policy
+   and 8 MB of memory.  Then checks that both the hot set and
+   the streamed pages still hold what was written to them. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 32
+#define SCAN_PAGES (6 * 1024 * 1024 / PAGE_SIZE)
+#define HOT_EVERY 16
+
+static char hot[HOT_PAGES * PAGE_SIZE];
+static char scan[SCAN_PAGES * PAGE_SIZE];
+
+static void
+touch_hot (int round)
+{
+  size_t i;
+
+  for (i = 0; i < HOT_PAGES; i++)
+    {
+      char *p = hot + i * PAGE_SIZE;
+      if (*p != (char) (i + round))
+        fail ("hot page %zu holds %d, expected %d",
+              i, *p, (char) (i + round));
+      *p = (char) (i + round + 1);
+    }
+}
+
+void
+test_main (void)
+{
+  size_t i;
+  int round = 0;
+
+  msg ("fill hot set");
+  for (i = 0; i < HOT_PAGES; i++)
+    hot[i * PAGE_SIZE] = (char) i;
+
+  msg ("stream through memory");
+  for (i = 0; i < SCAN_PAGES; i++)
+    {
+      scan[i * PAGE_SIZE] = (char) (i * 7);
+      if (i % HOT_EVERY == 0)
+        touch_hot (round++);
+    }
+
+  msg ("check hot set");
+  touch_hot (round++);
+
+  msg ("check streamed pages");
+  for (i = 0; i < SCAN_PAGES; i++)
+    if (scan[i * PAGE_SIZE] != (char) (i * 7))
+      fail ("streamed page %zu is inconsistent", i);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-scan) begin
+(swap-scan) fill hot set
+(swap-scan) stream through memory
+(swap-scan) check hot set
+(swap-scan) check streamed pages
+(swap-scan) end
+EOF
+pass;
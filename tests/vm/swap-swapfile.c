@@ -0,0 +1,39 @@
+/* Swaps anonymous pages to a swap file on the file system
+   (-swapfile) instead of a swap disk, then checks that the pages
+   come back intact and that the swap file cannot be written by
+   user programs. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (8 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  char c = 'x';
+  int fd;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunk[i * PAGE_SIZE] = (char) (i * 7);
+  msg ("wrote %d pages", PAGE_COUNT);
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunk[i * PAGE_SIZE] != (char) (i * 7))
+      fail ("page %zu is inconsistent", i);
+  msg ("pages came back");
+
+  CHECK ((fd = open ("swapfile")) > 1, "open \"swapfile\"");
+  CHECK (filesize (fd) >= 8 * ONE_MB, "swap file is at least 8 MB");
+  CHECK (write (fd, &c, 1) == 0, "writing the swap file is refused");
+  close (fd);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-swapfile) begin
+(swap-swapfile) wrote 2048 pages
+(swap-swapfile) pages came back
+(swap-swapfile) open "swapfile"
+(swap-swapfile) swap file is at least 8 MB
+(swap-swapfile) writing the swap file is refused
+(swap-swapfile) end
+EOF
+pass;
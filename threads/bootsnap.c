@@ -0,0 +1,135 @@
+#include "threads/bootsnap.h"
+#include <debug.h>
+#include <hash.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/loader.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/disk.h"
+#endif
+
+/*** GrilledSalmon ***/
+/* 부팅 snapshot.
+
+   부팅할 때마다 timer_calibrate()가 TSC와 busy_wait()의 속도를 tick에 맞춰
+   잰다. 같은 기계에서 다시 부팅하면 결과도 같으므로, 잰 값을 os 디스크의
+   마지막 sector에 남겨 두고 다음 부팅에서는 재지 않고 쓴다.
+
+   loader는 커널 image 뒤의 이 sector를 LOADER_SNAP에 읽어 둔다. 그 자리는
+   palloc_init()이 쓸 수 있으므로 main()이 그 전에 bootsnap_load()로 복사해
+   둔다. CPU가 바뀌었거나 (CPUID) checksum이 맞지 않으면 무시한다.
+   부팅이 끝나면 bootsnap_save()가 바뀐 값을 hd0:0에 다시 쓴다. utils/pintos는
+   실행이 끝난 뒤 그 sector를 os.dsk에 옮겨 다음 실행이 보게 한다.
+
+   메모리 전체를 디스크에 떠 두었다 되살리는 hibernate는 장치 상태와 스레드를
+   되살릴 수 없어 하지 않는다. 부팅에서 다시 할 필요가 없는 일은 잰 값뿐이다. */
+
+#define BOOTSNAP_MAGIC 0x50414e53       /* "SNAP". */
+#define BOOTSNAP_VERSION 1
+
+struct bootsnap {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t cpu_sig[4];        /* CPUID 0의 vendor와 1의 EAX. */
+	uint32_t timer_freq;        /* 값을 잰 TIMER_FREQ. */
+	uint32_t loops_per_tick;
+	uint64_t tsc_per_tick;
+	uint32_t pad;
+	uint32_t csum;              /* 앞의 필드들의 hash. */
+};
+
+bool bootsnap_disabled;
+
+static struct bootsnap snap;         /* 이번 부팅이 쓸 값. */
+static bool snap_valid;              /* snap을 읽어 와서 믿을 수 있다. */
+static bool snap_dirty;              /* 읽어 온 것과 다르다. */
+
+static void
+cpu_signature (uint32_t sig[4]) {
+	uint32_t eax = 0, ebx, ecx = 0, edx;
+
+	asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	sig[0] = ebx;
+	sig[1] = edx;
+	sig[2] = ecx;
+	eax = 1;
+	ecx = 0;
+	asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	sig[3] = eax;
+}
+
+static uint32_t
+snap_csum (const struct bootsnap *s) {
+	return hash_bytes (s, offsetof (struct bootsnap, csum));
+}
+
+/* loader가 읽어 둔 snapshot을 복사해 둔다. palloc_init() 전에 불러야 한다. */
+void
+bootsnap_load (void) {
+	uint32_t sig[4];
+
+	memcpy (&snap, ptov (LOADER_SNAP), sizeof snap);
+	cpu_signature (sig);
+	snap_valid = snap.magic == BOOTSNAP_MAGIC
+		&& snap.version == BOOTSNAP_VERSION
+		&& snap.timer_freq == TIMER_FREQ
+		&& !memcmp (snap.cpu_sig, sig, sizeof sig)
+		&& snap.csum == snap_csum (&snap)
+		&& snap.tsc_per_tick != 0 && snap.loops_per_tick != 0;
+}
+
+/* 남겨 둔 값이 있으면 *TSC_PER_TICK과 *LOOPS_PER_TICK에 담고 true. */
+bool
+bootsnap_get (uint64_t *tsc_per_tick, unsigned *loops_per_tick) {
+	if (!snap_valid || bootsnap_disabled)
+		return false;
+	*tsc_per_tick = snap.tsc_per_tick;
+	*loops_per_tick = snap.loops_per_tick;
+	return true;
+}
+
+/* 이번 부팅에서 쓴 값을 기록한다. 남겨 둔 것과 다르면 bootsnap_save()가 쓴다. */
+void
+bootsnap_set (uint64_t tsc_per_tick, unsigned loops_per_tick) {
+	if (snap_valid && snap.tsc_per_tick == tsc_per_tick
+			&& snap.loops_per_tick == loops_per_tick)
+		return;
+	memset (&snap, 0, sizeof snap);
+	snap.magic = BOOTSNAP_MAGIC;
+	snap.version = BOOTSNAP_VERSION;
+	cpu_signature (snap.cpu_sig);
+	snap.timer_freq = TIMER_FREQ;
+	snap.loops_per_tick = loops_per_tick;
+	snap.tsc_per_tick = tsc_per_tick;
+	snap.csum = snap_csum (&snap);
+	snap_valid = true;
+	snap_dirty = true;
+}
+
+/* 바뀐 snapshot을 hd0:0의 마지막 sector에 쓴다. 그 sector가 비어 있거나
+   snapshot일 때만 쓴다. 디스크가 없는 build에서는 아무것도 하지 않는다. */
+void
+bootsnap_save (void) {
+#ifdef FILESYS
+	static uint8_t buf[DISK_SECTOR_SIZE];
+	struct disk *d;
+	disk_sector_t sector;
+	size_t i;
+
+	if (!snap_dirty || (d = disk_get (0, 0)) == NULL || disk_size (d) < 2)
+		return;
+	sector = disk_size (d) - 1;
+	disk_read (d, sector, buf);
+	if (*(uint32_t *) buf != BOOTSNAP_MAGIC)
+		for (i = 0; i < sizeof buf; i++)
+			if (buf[i] != 0)
+				return;
+	memset (buf, 0, sizeof buf);
+	memcpy (buf, &snap, sizeof snap);
+	disk_write (d, sector, buf);
+	snap_dirty = false;
+#endif
+}
@@ -0,0 +1,158 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/*** GrilledSalmon ***/
+/* FPU/SSE 상태를 게으르게 바꾼다.
+ *
+ * 스레드를 바꿀 때마다 x87과 SSE register를 저장하고 되살리는 대신, 새 스레드가
+ * 그 register의 주인 (fpu_owner)이 아니면 CR0.TS만 세워 둔다. 그 스레드가 FPU
+ * 명령을 처음 쓰면 #NM이 나고, 그때 주인의 상태를 주인의 저장 영역에 FXSAVE하고
+ * 자기 상태를 FXRSTOR한 뒤 주인이 된다. FPU를 쓰지 않는 스레드는 저장 영역도
+ * 없고 (thread->fpu가 NULL) 바꿀 때 드는 비용도 없다. 커널은 -mno-sse로 빌드하므로
+ * #NM은 user 프로그램에서만 난다.
+ *
+ * 저장 영역은 FXSAVE의 512바이트다. XSAVE는 AVX 같은 확장 상태까지 담지만 CPU마다
+ * 크기와 XCR0 설정이 달라 x87과 SSE만 다룬다. */
+#define FPU_AREA_SIZE 512
+#define FPU_AREA_ALIGN 16
+
+#define CR0_MP (1 << 1)             /* WAIT/FWAIT도 TS를 본다. */
+#define CR0_EM (1 << 2)             /* FPU를 흉내 낸다. 끈다. */
+#define CR0_TS (1 << 3)             /* 다음 FPU 명령에서 #NM. */
+#define CR0_NE (1 << 5)             /* FPU 오류를 #MF로 알린다. */
+#define CR4_OSFXSR (1 << 9)         /* FXSAVE/FXRSTOR와 SSE를 켠다. */
+#define CR4_OSXMMEXCPT (1 << 10)    /* SSE 오류를 #XM으로 알린다. */
+
+static struct kmem_cache *fpu_cache;
+static uint8_t fpu_initial[FPU_AREA_SIZE] __attribute__ ((aligned (FPU_AREA_ALIGN)));
+
+/* 지금 FPU register에 상태가 올라와 있는 스레드. 없으면 NULL. */
+static struct thread *fpu_owner;
+
+static void fpu_trap (struct intr_frame *);
+
+static inline void
+fxsave (void *area) {
+	asm volatile ("fxsave64 (%0)" : : "r" (area) : "memory");
+}
+
+static inline void
+fxrstor (const void *area) {
+	asm volatile ("fxrstor64 (%0)" : : "r" (area) : "memory");
+}
+
+static inline void
+clts (void) {
+	asm volatile ("clts");
+}
+
+static inline void
+stts (void) {
+	lcr0 (rcr0 () | CR0_TS);
+}
+
+/* FPU와 SSE를 켜고 #NM handler를 등록한다. intr_init() 뒤에 부른다. */
+void
+fpu_init (void) {
+	lcr0 ((rcr0 () & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+	lcr4 (rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT);
+
+	/* 처음 FPU를 쓰는 스레드가 받을 상태. */
+	asm volatile ("fninit");
+	fxsave (fpu_initial);
+	stts ();
+
+	fpu_cache = kmem_cache_create ("fpu", FPU_AREA_SIZE, FPU_AREA_ALIGN, NULL);
+	if (fpu_cache == NULL)
+		PANIC ("fpu_init: out of memory");
+	intr_register_int (7, 0, INTR_ON, fpu_trap,
+			"#NM Device Not Available Exception");
+}
+
+/* 스레드를 NEXT로 바꾸기 전에 schedule()이 부른다. NEXT가 주인이면 TS를 내려
+ * 그대로 쓰게 하고, 아니면 TS를 세워 처음 쓸 때 #NM이 나게 한다. */
+void
+fpu_switch (struct thread *next) {
+	uint64_t cr0 = rcr0 ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (next == fpu_owner) {
+		if (cr0 & CR0_TS)
+			clts ();
+	} else if (!(cr0 & CR0_TS))
+		lcr0 (cr0 | CR0_TS);
+}
+
+/* fork()한 자식 DST가 부모 SRC의 FPU 상태를 물려받게 한다. SRC가 FPU를 쓴 적이
+ * 없으면 할 일이 없다. 메모리가 모자라면 false. */
+bool
+fpu_copy (struct thread *dst, struct thread *src) {
+	enum intr_level old_level;
+
+	if (src->fpu == NULL)
+		return true;
+	if (dst->fpu == NULL && (dst->fpu = kmem_cache_alloc (fpu_cache)) == NULL)
+		return false;
+
+	old_level = intr_disable ();
+	if (fpu_owner == src) {
+		/* SRC의 최신 상태는 아직 register에 있다. */
+		clts ();
+		fxsave (src->fpu);
+		if (thread_current () != fpu_owner)
+			stts ();
+	}
+	memcpy (dst->fpu, src->fpu, FPU_AREA_SIZE);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* T의 FPU 상태를 버린다. T가 주인이면 register의 상태도 버리고, T가 다시 FPU를
+ * 쓰면 처음처럼 초기 상태를 받는다. exec할 때와 죽은 스레드를 치울 때 부른다. */
+void
+fpu_release (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+
+	if (fpu_owner == t) {
+		fpu_owner = NULL;
+		stts ();
+	}
+	if (t->fpu != NULL) {
+		kmem_cache_free (fpu_cache, t->fpu);
+		t->fpu = NULL;
+	}
+	intr_set_level (old_level);
+}
+
+/* #NM. 지금 스레드를 FPU의 주인으로 만든다. */
+static void
+fpu_trap (struct intr_frame *f UNUSED) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (cur->fpu == NULL) {
+		cur->fpu = kmem_cache_alloc (fpu_cache);
+		if (cur->fpu == NULL) {
+			cur->exit_status = -1;
+			thread_exit ();
+		}
+		memcpy (cur->fpu, fpu_initial, FPU_AREA_SIZE);
+	}
+
+	old_level = intr_disable ();
+	clts ();
+	if (fpu_owner != cur) {
+		if (fpu_owner != NULL)
+			fxsave (fpu_owner->fpu);
+		fxrstor (cur->fpu);
+		fpu_owner = cur;
+	}
+	intr_set_level (old_level);
+}
@@ -13,29 +13,45 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/fpu.h"
+#include "threads/bootsnap.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vmalloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/rcu.h"
+#include "threads/workqueue.h"
+#include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
+#include "userprog/sysprof.h"
+#include "userprog/elfcache.h"
 #include "userprog/tss.h"
 #endif
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/fat.h"
+#include "filesys/fsstat.h"
+#include "filesys/csum.h"
 #endif
 
 /* Page-map-level-4 with kernel mappings only. */
@@ -51,6 +67,27 @@ bool power_off_when_done;
 
 bool thread_tests;
 
+/* -alloc-stats: Include per-descriptor malloc statistics in print_stats()? */
+static bool alloc_stats;
+
+/* -memstat: Print kernel memory by object cache and malloc tag? */
+static bool memstat;
+
+/*** GrilledSalmon ***/
+/* -bootprof: Print how long each phase of main() took?  The
+   phases are always timed; only the printing is optional. */
+static bool bootprof;
+
+/* End of each boot phase, in TSC cycles, in order. */
+#define BOOT_PHASE_MAX 24
+struct boot_phase {
+	const char *name;
+	uint64_t tsc;
+};
+static struct boot_phase boot_phases[BOOT_PHASE_MAX];
+static int boot_phase_cnt;
+static uint64_t boot_start;         /* TSC when main() began. */
+
 static void bss_init (void);
 static void paging_init (uint64_t mem_end);
 
@@ -60,6 +97,8 @@ static void run_actions (char **argv);
 static void usage (void);
 
 static void print_stats (void);
+static void boot_phase_done (const char *name);
+static void print_boot_profile (void);
 
 
 int main (void) NO_RETURN;
@@ -67,25 +106,37 @@ int main (void) NO_RETURN;
 /* Pintos main program. */
 int
 main (void) {
+	uint64_t start = rdtsc ();
 	uint64_t mem_end;
 	char **argv;
 
 	/* Clear BSS and get machine's RAM size. */
 	bss_init ();
+	boot_start = start;
+	bootsnap_load ();
+	boot_phase_done ("bss_init");
 
 	/* Break command line into arguments and parse options. */
 	argv = read_command_line ();
 	argv = parse_options (argv);
+	boot_phase_done ("parse_options");
 
 	/* Initialize ourselves as a thread so we can use locks,
 	   then enable console locking. */
 	thread_init ();
+	workqueue_init ();
 	console_init ();
+	boot_phase_done ("thread_init");
 
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
+	boot_phase_done ("palloc_init");
 	malloc_init ();
+	boot_phase_done ("malloc_init");
 	paging_init (mem_end);
+	vmalloc_init ();
+	boot_phase_done ("paging_init");
+	profile_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -94,29 +145,41 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	elfcache_init ();
 #endif
+	boot_phase_done ("intr_init");
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	workqueue_start ();
 	serial_init_queue ();
+	boot_phase_done ("thread_start");
 	timer_calibrate ();
+	boot_phase_done ("timer_calibrate");
 
 #ifdef FILESYS
 	/* Initialize file system. */
 	disk_init ();
+	boot_phase_done ("disk_init");
 	filesys_init (format_filesys);
+	boot_phase_done ("filesys_init");
 #endif
 
 #ifdef VM
 	vm_init ();
+	boot_phase_done ("vm_init");
 #endif
 
 	printf ("Boot complete.\n");
+	bootsnap_save ();
+	if (bootprof)
+		print_boot_profile ();
 
 	/* Run actions specified on kernel command line. */
 	run_actions (argv);
@@ -145,26 +208,46 @@ bss_init (void) {
  * Points base_pml4 to the pml4 it creates. */
 static void
 paging_init (uint64_t mem_end) {
-	uint64_t *pml4, *pte;
+	uint64_t *pml4;
 	int perm;
 	pml4 = base_pml4 = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 
 	extern char start, _end_kernel_text;
+	uint8_t *user_pool;
+	size_t user_pages;
+
+	/*** GrilledSalmon ***/
+	/* 2 MB 단위로 매핑할 수 있는 곳은 PDE 하나로 매핑한다. page table이 줄고 TLB가
+	 * 덮는 범위가 넓어진다. 읽기 전용인 커널 text와 user pool은 4 KB로 둔다.
+	 * vm은 frame을 kva로 쓴 흔적을 user pool의 4 KB PTE에서 page마다 본다. */
+	palloc_user_pool ((void **) &user_pool, &user_pages);
+
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	for (uint64_t pa = 0; pa < mem_end; ) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		if (pa % HUGE_PGSIZE == 0 && pa + HUGE_PGSIZE <= mem_end
+				&& (va + HUGE_PGSIZE <= (uint64_t) &start
+					|| va >= (uint64_t) &_end_kernel_text)
+				&& (va + HUGE_PGSIZE <= (uint64_t) user_pool
+					|| va >= (uint64_t) (user_pool + user_pages * PGSIZE))) {
+			pml4_map (pml4, va, pa, PTE_P | PTE_W | PTE_PS);
+			pa += HUGE_PGSIZE;
+			continue;
+		}
+
 		perm = PTE_P | PTE_W;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
 
-		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
-			*pte = pa | perm;
+		pml4_map (pml4, va, pa, perm);
+		pa += PGSIZE;
 	}
 
 	// reload cr3
 	pml4_activate(0);
+	pml4_pcid_init ();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -216,16 +299,85 @@ parse_options (char **argv) {
 #ifdef FILESYS
 		else if (!strcmp (name, "-f"))
 			format_filesys = true;
+		else if (!strcmp (name, "-bc"))
+			bc_sectors = atoi (value);
+		else if (!strcmp (name, "-bc-policy")) {
+			if (value == NULL || !bc_set_policy (value))
+				PANIC ("unknown buffer cache policy `%s' (use -h for help)",
+						value != NULL ? value : "");
+		}
+		else if (!strcmp (name, "-ramdisk")) {
+			if (value == NULL || !disk_set_ramdisk (value))
+				PANIC ("bad RAM disk list `%s' (use -h for help)",
+						value != NULL ? value : "");
+		}
+		else if (!strcmp (name, "-iosched")) {
+			if (value == NULL || !disk_set_scheduler (value))
+				PANIC ("unknown I/O scheduler `%s' (use -h for help)",
+						value != NULL ? value : "");
+		}
+		else if (!strcmp (name, "-cluster"))
+			fat_format_cluster_sectors = atoi (value);
+		else if (!strcmp (name, "-extents"))
+			fat_format_extents = true;
+		else if (!strcmp (name, "-csum"))
+			csum_format_enabled = true;
+		else if (!strcmp (name, "-defrag"))
+			filesys_defrag = true;
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
-		else if (!strcmp (name, "-mlfqs"))
+		else if (!strcmp (name, "-loops"))
+			timer_loops_per_sec = atoi (value);
+		else if (!strcmp (name, "-mlfqs")) {
 			thread_mlfqs = true;
+			thread_cfs = false;
+		} else if (!strcmp (name, "-cfs")) {
+			thread_cfs = true;
+			thread_mlfqs = false;
+		}
+		else if (!strcmp (name, "-alloc-stats"))
+			alloc_stats = true;
+		else if (!strcmp (name, "-memstat"))
+			memstat = true;
+		else if (!strcmp (name, "-profile"))
+			profile_enabled = true;
+		else if (!strcmp (name, "-bootprof"))
+			bootprof = true;
+		else if (!strcmp (name, "-nosnap"))
+			bootsnap_disabled = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+		else if (!strcmp (name, "-sysprof"))
+			sysprof_enabled = true;
+		else if (!strcmp (name, "-ioacct"))
+			process_print_io = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-zswap"))
+			zswap_limit_kb = atoi (value);
+		else if (!strcmp (name, "-swap"))
+			swap_disk_spec = value;
+		else if (!strcmp (name, "-swapfile"))
+			swap_file_spec = value;
+		else if (!strcmp (name, "-fault-around"))
+			vm_fault_around_pages = atoi (value);
+		else if (!strcmp (name, "-stack-chunk"))
+			vm_stack_chunk_pages = atoi (value) > 0 ? atoi (value) : 1;
+		else if (!strcmp (name, "-rusage"))
+			vm_print_rusage = true;
+		else if (!strcmp (name, "-ksm"))
+			vm_ksm_enabled = true;
+		else if (!strcmp (name, "-kswapd"))
+			vm_kswapd_low = atoi (value);
+		else if (!strcmp (name, "-evict")) {
+			if (value == NULL || !vm_set_evict_policy (value))
+				PANIC ("unknown eviction policy `%s' (use -h for help)",
+						value != NULL ? value : "");
+		}
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -324,25 +476,100 @@ usage (void) {
 			"  -h                 Print this help message and power off.\n"
 			"  -q                 Power off VM after actions or on panic.\n"
 			"  -f                 Format file system disk during startup.\n"
+			"  -bc=N              Cache up to N disk sectors in memory.\n"
+			"  -bc-policy=NAME    Replace cached sectors with clock (default) or\n"
+			"                     2q, which lets one-pass reads go by.\n"
+			"  -iosched=NAME      Schedule disk requests with fifo, clook,\n"
+			"                     deadline or prio (default).\n"
+			"  -ramdisk=C:D[:MB],... Replace disk hdC:D by a RAM disk of MB\n"
+			"                     megabytes (default: the replaced disk's size).\n"
+			"  -cluster=N         Format with N sectors per FAT cluster.\n"
+			"  -extents           Format with extent-mapped inodes.\n"
+			"  -csum              Format with CRC32C checksums of every sector.\n"
+			"  -defrag            Make fragmented files contiguous while the\n"
+			"                     disk is idle.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
+			"  -loops=N           Skip timer calibration: busy-wait N loops/s.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Share the CPU in proportion to nice weights.\n"
+			"  -alloc-stats       Print malloc statistics on power off.\n"
+			"  -memstat           Print kernel memory per subsystem on power off.\n"
+			"  -profile           Sample the kernel on each timer tick and print\n"
+			"                     folded stacks and hot addresses on power off.\n"
+			"  -bootprof          Print how long each boot phase took.\n"
+			"  -nosnap            Recalibrate instead of using the boot snapshot.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+			"  -sysprof           Profile system calls per process and print\n"
+			"                     the totals on power off.\n"
+			"  -ioacct            Print bytes and sectors moved when a process exits.\n"
+#endif
+#ifdef VM
+			"  -zswap=KB          Keep up to KB of compressed swap in memory.\n"
+			"  -swap=C:D,...      Stripe swap across the listed disks.\n"
+			"  -swapfile=NAME[:MB]  Swap to file NAME, created with MB (default 4)\n"
+			"                     and grown in contiguous chunks as needed.\n"
+			"  -fault-around=N    Also map N following pages on file-backed faults.\n"
+			"  -stack-chunk=N     Grow the stack by up to N pages per fault.\n"
+			"  -rusage            Print page fault statistics when a process exits.\n"
+			"  -ksm               Merge identical anonymous pages in the background.\n"
+			"  -kswapd=N          Reclaim frames in the background below N free\n"
+			"                     pages, up to 2N.  0 turns it off.\n"
+			"  -evict=NAME        Pick eviction victims with clock (default)\n"
+			"                     or 2q, which keeps pages used twice active.\n"
 #endif
 			);
 	power_off ();
 }
 
 
+/* Records that boot phase NAME, which began where the previous
+   phase ended, is done. */
+static void
+boot_phase_done (const char *name) {
+	if (boot_phase_cnt < BOOT_PHASE_MAX) {
+		boot_phases[boot_phase_cnt].name = name;
+		boot_phases[boot_phase_cnt].tsc = rdtsc ();
+		boot_phase_cnt++;
+	}
+}
+
+/* Prints the boot phases with their length in cycles and
+   microseconds and their share of the whole boot. */
+static void
+print_boot_profile (void) {
+	uint64_t prev = boot_start;
+	uint64_t total = boot_phases[boot_phase_cnt - 1].tsc - boot_start;
+	int i;
+
+	printf ("Boot profile: %llu cycles, %llu us\n", (unsigned long long) total,
+			(unsigned long long) (timer_cycles_to_nanos (total) / 1000));
+	for (i = 0; i < boot_phase_cnt; i++) {
+		uint64_t cycles = boot_phases[i].tsc - prev;
+
+		printf ("  %-16s %12llu cycles %10llu us %3llu%%\n", boot_phases[i].name,
+				(unsigned long long) cycles,
+				(unsigned long long) (timer_cycles_to_nanos (cycles) / 1000),
+				(unsigned long long) (total > 0 ? cycles * 100 / total : 0));
+		prev = boot_phases[i].tsc;
+	}
+}
+
 /* Powers down the machine we're running on,
    as long as we're running on Bochs or QEMU. */
 void
 power_off (void) {
+#ifdef USERPROG
+	/* 캐시가 들고 있는 실행 파일 inode를 filesys_done() 전에 닫는다. */
+	elfcache_flush ();
+#endif
 #ifdef FILESYS
 	filesys_done ();
 #endif
 
 	print_stats ();
+	lockstat_print ();
+	trace_dump ();
 
 	printf ("Powering off...\n");
 	outw (0x604, 0x2000);               /* Poweroff command for qemu */
@@ -354,12 +581,38 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	workqueue_print_stats ();
+	rcu_print_stats ();
+	intr_print_stats ();
+	palloc_print_stats ();
+	pml4_print_stats ();
+	if (alloc_stats) {
+		malloc_print_stats ();
+		vmalloc_print_stats ();
+	}
+	if (memstat) {
+		kmem_print_stats ();
+		mem_tag_print_stats ();
+	}
+	if (profile_enabled)
+		profile_print ();
 #ifdef FILESYS
 	disk_print_stats ();
+	bc_print_stats ();
+	fsstat_print ();
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
+	if (sysprof_enabled)
+		sysprof_print ();
+#endif
+#ifdef VM
+	anon_print_stats ();
+	zswap_print_stats ();
+	ksm_print_stats ();
+	kswapd_print_stats ();
+	page_cache_print_stats ();
 #endif
 }
\ No newline at end of file
@@ -103,6 +103,24 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/*** GrilledSalmon ***/
+/* Per-vector statistics, printed by intr_print_stats().  Times are
+   TSC cycles from entry to intr_handler() until the handler
+   returns, so they include any interrupt that nests inside and,
+   for internal interrupts such as page faults, any time the
+   handler sleeps.  A reschedule is an external interrupt whose
+   handler called intr_yield_on_return(); its latency runs from
+   entry until thread_yield() is called. */
+struct intr_stat {
+   uint64_t cnt;                /* Times the vector was handled. */
+   uint64_t cycles;             /* Total time in the handler. */
+   uint64_t max;                /* Longest time in the handler. */
+   uint64_t resched_cnt;        /* Reschedules it triggered. */
+   uint64_t resched_cycles;     /* Total entry-to-yield latency. */
+   uint64_t resched_max;        /* Longest entry-to-yield latency. */
+};
+static struct intr_stat intr_stats[INTR_CNT];
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -332,6 +350,8 @@ void
 intr_handler (struct intr_frame *frame) {
    bool external;
    intr_handler_func *handler;
+   struct intr_stat *st = &intr_stats[frame->vec_no];
+   uint64_t start = rdtsc (), cycles;
 
    /* External interrupts are special.
       We only handle one at a time (so interrupts must be off)
@@ -344,6 +364,12 @@ intr_handler (struct intr_frame *frame) {
 
       in_external_intr = true;
       yield_on_return = false;
+
+      /*** GrilledSalmon ***/
+      /* idle이 timer를 one-shot으로 맞춰 두고 자던 중이면, 다른 장치의
+         handler가 보기 전에 지난 tick을 센다. */
+      if (frame->vec_no != 0x20)
+         timer_wake ();
    }
 
    /* Invoke the interrupt's handler. */
@@ -361,6 +387,12 @@ intr_handler (struct intr_frame *frame) {
       PANIC ("Unexpected interrupt");
    }
 
+   cycles = rdtsc () - start;
+   st->cnt++;
+   st->cycles += cycles;
+   if (cycles > st->max)
+      st->max = cycles;
+
    /* Complete the processing of an external interrupt. */
    if (external) {
       ASSERT (intr_get_level () == INTR_OFF);
@@ -369,8 +401,37 @@ intr_handler (struct intr_frame *frame) {
       in_external_intr = false;
       pic_end_of_interrupt (frame->vec_no);
 
-      if (yield_on_return)
+      if (yield_on_return) {
+         cycles = rdtsc () - start;
+         st->resched_cnt++;
+         st->resched_cycles += cycles;
+         if (cycles > st->resched_max)
+            st->resched_max = cycles;
          thread_yield ();
+      }
+   }
+}
+
+/* Prints, for each vector that has been handled, how often, the
+   average and longest time its handler took, and the reschedules
+   it triggered with their average and longest latency. */
+void
+intr_print_stats (void) {
+   int i;
+
+   printf ("Interrupts:  vec  count   avg ns   max ns  resched  avg ns   max ns  name\n");
+   for (i = 0; i < INTR_CNT; i++) {
+      const struct intr_stat *st = &intr_stats[i];
+
+      if (st->cnt == 0)
+         continue;
+      printf ("Interrupts: 0x%02x %6"PRIu64" %8"PRIu64" %8"PRIu64" %8"PRIu64
+              " %7"PRIu64" %8"PRIu64"  %s\n", i, st->cnt,
+              timer_cycles_to_nanos (st->cycles / st->cnt),
+              timer_cycles_to_nanos (st->max), st->resched_cnt,
+              st->resched_cnt > 0
+              ? timer_cycles_to_nanos (st->resched_cycles / st->resched_cnt) : 0,
+              timer_cycles_to_nanos (st->resched_max), intr_names[i]);
    }
 }
 
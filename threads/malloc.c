@@ -39,7 +39,22 @@ struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
-	struct lock lock;           /* Lock. */
+	struct spinlock lock;       /* Lock. */
+
+	/* Statistics, protected by LOCK. */
+	size_t alloc_cnt;           /* Blocks handed out. */
+	size_t free_cnt;            /* Blocks given back. */
+	size_t arena_cnt;           /* Arenas currently held. */
+	size_t peak_arena_cnt;      /* Most arenas held at once. */
+};
+
+/* Statistics for blocks too big for any descriptor. */
+struct big_stats {
+	struct spinlock lock;       /* Protects the members below. */
+	size_t alloc_cnt;           /* Big blocks handed out. */
+	size_t free_cnt;            /* Big blocks given back. */
+	size_t page_cnt;            /* Pages currently held. */
+	size_t peak_page_cnt;       /* Most pages held at once. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -60,6 +75,12 @@ struct block {
 /* Our set of descriptors. */
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
+static struct big_stats big;    /* Big block statistics. */
+
+/* Registered tags, newest first.  TAG_LOCK protects the list and
+   every tag's counters. */
+static struct mem_tag *all_tags;
+static struct spinlock tag_lock;
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
@@ -75,8 +96,10 @@ malloc_init (void) {
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		spinlock_init (&d->lock);
 	}
+	spinlock_init (&big.lock);
+	spinlock_init (&tag_lock);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -109,10 +132,17 @@ malloc (size_t size) {
 		a->magic = ARENA_MAGIC;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+
+		spinlock_acquire (&big.lock);
+		big.alloc_cnt++;
+		big.page_cnt += page_cnt;
+		if (big.page_cnt > big.peak_page_cnt)
+			big.peak_page_cnt = big.page_cnt;
+		spinlock_release (&big.lock);
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
+	spinlock_acquire (&d->lock);
 
 	/* If the free list is empty, create a new arena. */
 	if (list_empty (&d->free_list)) {
@@ -121,7 +151,7 @@ malloc (size_t size) {
 		/* Allocate a page. */
 		a = palloc_get_page (0);
 		if (a == NULL) {
-			lock_release (&d->lock);
+			spinlock_release (&d->lock);
 			return NULL;
 		}
 
@@ -133,13 +163,16 @@ malloc (size_t size) {
 			struct block *b = arena_to_block (a, i);
 			list_push_back (&d->free_list, &b->free_elem);
 		}
+		if (++d->arena_cnt > d->peak_arena_cnt)
+			d->peak_arena_cnt = d->arena_cnt;
 	}
 
 	/* Get a block from free list and return it. */
 	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
 	a = block_to_arena (b);
 	a->free_cnt--;
-	lock_release (&d->lock);
+	d->alloc_cnt++;
+	spinlock_release (&d->lock);
 	return b;
 }
 
@@ -213,10 +246,11 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
+			spinlock_acquire (&d->lock);
 
 			/* Add block to free list. */
 			list_push_front (&d->free_list, &b->free_elem);
+			d->free_cnt++;
 
 			/* If the arena is now entirely unused, free it. */
 			if (++a->free_cnt >= d->blocks_per_arena) {
@@ -228,17 +262,134 @@ free (void *p) {
 					list_remove (&b->free_elem);
 				}
 				palloc_free_page (a);
+				d->arena_cnt--;
 			}
 
-			lock_release (&d->lock);
+			spinlock_release (&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
-			palloc_free_multiple (a, a->free_cnt);
+			size_t page_cnt = a->free_cnt;
+
+			palloc_free_multiple (a, page_cnt);
+			spinlock_acquire (&big.lock);
+			big.free_cnt++;
+			big.page_cnt -= page_cnt;
+			spinlock_release (&big.lock);
 			return;
 		}
 	}
 }
 
+/* Prints malloc() statistics: for each descriptor, the blocks
+   handed out and given back and the arenas it holds now and at
+   its peak; then the same for big blocks, in pages.  A live
+   count that keeps growing under a steady load is a leak. */
+void
+malloc_print_stats (void) {
+	struct desc *d;
+	struct big_stats b;
+
+	for (d = descs; d < descs + desc_cnt; d++) {
+		size_t alloc_cnt, free_cnt, arena_cnt, peak_arena_cnt;
+
+		/* Take a snapshot so we don't print with the lock held. */
+		spinlock_acquire (&d->lock);
+		alloc_cnt = d->alloc_cnt;
+		free_cnt = d->free_cnt;
+		arena_cnt = d->arena_cnt;
+		peak_arena_cnt = d->peak_arena_cnt;
+		spinlock_release (&d->lock);
+
+		printf ("malloc: %4zu-byte blocks: %zu allocs, %zu frees, %zu live, "
+				"%zu arenas (peak %zu)\n", d->block_size, alloc_cnt, free_cnt,
+				alloc_cnt - free_cnt, arena_cnt, peak_arena_cnt);
+	}
+
+	spinlock_acquire (&big.lock);
+	b = big;
+	spinlock_release (&big.lock);
+	printf ("malloc: big blocks: %zu allocs, %zu frees, %zu live, "
+			"%zu pages (peak %zu)\n", b.alloc_cnt, b.free_cnt,
+			b.alloc_cnt - b.free_cnt, b.page_cnt, b.peak_page_cnt);
+}
+
+/* Adds BLOCK, just obtained from malloc(), to TAG. */
+static void
+tag_add (struct mem_tag *tag, void *block) {
+	size_t size = block_size (block);
+
+	spinlock_acquire (&tag_lock);
+	if (!tag->registered) {
+		tag->registered = true;
+		tag->next = all_tags;
+		all_tags = tag;
+	}
+	tag->live_cnt++;
+	tag->live_bytes += size;
+	if (tag->live_bytes > tag->peak_bytes)
+		tag->peak_bytes = tag->live_bytes;
+	spinlock_release (&tag_lock);
+}
+
+/* Like malloc(), but counts the block against TAG until it is
+   given to free_tagged() with the same TAG. */
+void *
+malloc_tagged (struct mem_tag *tag, size_t size) {
+	void *p = malloc (size);
+
+	if (p != NULL)
+		tag_add (tag, p);
+	return p;
+}
+
+/* Like calloc(), but counts the block against TAG. */
+void *
+calloc_tagged (struct mem_tag *tag, size_t a, size_t b) {
+	void *p = calloc (a, b);
+
+	if (p != NULL)
+		tag_add (tag, p);
+	return p;
+}
+
+/* Frees BLOCK, which malloc_tagged() or calloc_tagged() obtained
+   for TAG.  A null pointer is ignored. */
+void
+free_tagged (struct mem_tag *tag, void *block) {
+	size_t size;
+
+	if (block == NULL)
+		return;
+
+	size = block_size (block);
+	spinlock_acquire (&tag_lock);
+	ASSERT (tag->registered && tag->live_cnt > 0 && tag->live_bytes >= size);
+	tag->live_cnt--;
+	tag->live_bytes -= size;
+	spinlock_release (&tag_lock);
+	free (block);
+}
+
+/* Prints the blocks and bytes each tag holds now and its peak
+   bytes. */
+void
+mem_tag_print_stats (void) {
+	struct mem_tag *tag;
+
+	for (tag = all_tags; tag != NULL; tag = tag->next) {
+		size_t live_cnt, live_bytes, peak_bytes;
+
+		spinlock_acquire (&tag_lock);
+		live_cnt = tag->live_cnt;
+		live_bytes = tag->live_bytes;
+		peak_bytes = tag->peak_bytes;
+		spinlock_release (&tag_lock);
+
+		printf ("malloc: %-12s %zu live blocks, %zu bytes (peak %zu)\n",
+				tag->name, live_cnt, live_bytes, peak_bytes);
+	}
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
@@ -1,58 +1,195 @@
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
-static uint64_t *
-pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
-	int idx = PDX (va);
-	if (pdp) {
-		uint64_t *pte = (uint64_t *) pdp[idx];
-		if (!((uint64_t) pte & PTE_P)) {
-			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
-				if (new_page)
-					pdp[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
-				else
-					return NULL;
-			} else
-				return NULL;
-		}
-		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
+/*** GrilledSalmon ***/
+/* PCID. CPU가 지원하면 CR4.PCIDE를 켜고 pml4마다 PCID를 붙인다. CR3를 바꿀 때
+ * bit 63을 세우면 TLB를 비우지 않아서, 돌아온 프로세스가 자기 TLB 항목을 그대로
+ * 쓴다. PCID 0은 base_pml4가 쓰고 나머지를 pml4들이 돌려 쓴다.
+ *
+ * 올라와 있지 않은 pml4의 PTE를 내리면 (eviction 등) 그 PCID로 잡힌 TLB 항목이
+ * 남는다. invlpg는 지금 PCID만 비우므로 그 slot을 stale로 표시해 두고, 다음에
+ * 올릴 때 bit 63 없이 CR3를 써서 그 PCID의 항목을 모두 비운다. */
+#define PCID_CNT 64
+#define CR3_PCID_MASK 0xfffULL
+#define CR3_NOFLUSH (1ULL << 63)
+#define CR4_PCIDE (1 << 17)
+#define CPUID_1_ECX_PCID (1 << 17)
+
+struct pcid_slot {
+	uint64_t *pml4;             /* 이 PCID를 쓰는 pml4. 비어 있으면 NULL. */
+	bool stale;                 /* TLB에 지난 항목이 남아 있을 수 있다. */
+};
+
+static struct pcid_slot pcid_slots[PCID_CNT];
+static unsigned pcid_victim = 1;    /* 빈 slot이 없을 때 다음에 빼앗을 slot. */
+static bool pcid_enabled;
+
+static bool pml4_is_active (uint64_t *pml4);
+static void tlb_flush_page (uint64_t *pml4, const void *va);
+
+/*** GrilledSalmon ***/
+/* page table 하나에 present인 entry가 몇 개인지를 그 table을 가리키는 위 단계
+ * entry의 52..61 bit에 둔다. CPU는 2 MB page가 아닌 PDPTE와 PDE의 이 bit를 보지
+ * 않는다. 순회와 해제는 그만큼 찾으면 나머지 entry를 보지 않고, 0이면 그 table을
+ * 통째로 건너뛴다. PML4E에는 두지 않는다. 커널의 PDPT는 모든 pml4가 같이 쓰는데
+ * PML4E는 pml4마다 복사본이라 개수가 어긋나기 때문이다. 그래서 PDPT는 전부 본다.
+ *
+ * 개수는 entry_set()이 present bit가 바뀔 때 고친다. leaf를 present로 만드는 일은
+ * pml4_map()과 그것을 쓰는 함수들로만 한다. */
+#define PTE_CNT_SHIFT 52
+#define PTE_CNT_ONE (1ULL << PTE_CNT_SHIFT)
+#define PTE_CNT_MASK (0x3ffULL << PTE_CNT_SHIFT)
+#define pte_cnt(e) ((unsigned) (((e) & PTE_CNT_MASK) >> PTE_CNT_SHIFT))
+
+/* 개수를 두지 않는 table에 넘기는 개수. 끝까지 본다. */
+#define PT_CNT_ALL (PGSIZE / sizeof (uint64_t))
+
+/* 단계별 index의 shift. 0은 PML4, 3은 page table. */
+static const unsigned level_shift[4] = {
+	PML4SHIFT, PDPESHIFT, PDXSHIFT, PTXSHIFT
+};
+
+/*** GrilledSalmon ***/
+/* page table page cache. 프로세스가 끝날 때 놓은 page table page를 palloc에
+ * 돌려주지 않고 여기 두었다가 다음 pml4_create()와 walk()가 다시 쓴다. page
+ * table은 모두 kernel pool에서 오므로 cache는 하나다.
+ *
+ * pml4와 PDPT는 present entry만 있으므로 놓으면서 그 entry를 0으로 지우면 다시
+ * 0인 page가 되어 clean에 둔다. page directory와 page table에는 pml4_clear_page()
+ * 가 present bit만 내린 entry가 남을 수 있어 dirty에 두고, 꺼낼 때나 idle
+ * 스레드가 pml4_zero_idle()로 0으로 채운다. 어느 쪽이든 palloc의 lock, buddy
+ * 병합, 놓을 때의 0xcc 채우기를 거치지 않는다. */
+#define PT_CACHE_PAGES 64
+
+static struct spinlock pt_cache_lock;   /* 0으로 채운 것이 spinlock_init()과 같다. */
+static void *pt_clean[PT_CACHE_PAGES];  /* 0으로 채워진 page. */
+static void *pt_dirty[PT_CACHE_PAGES];  /* 0으로 채워야 하는 page. */
+static size_t pt_clean_cnt, pt_dirty_cnt;
+static long long pt_alloc_cnt, pt_cache_hits;
+
+/* 0으로 채운 page table page를 하나 준다. 메모리가 없으면 NULL. */
+static void *
+pt_page_get (void) {
+	void *page = NULL;
+	bool dirty = false;
+
+	spinlock_acquire (&pt_cache_lock);
+	pt_alloc_cnt++;
+	if (pt_clean_cnt > 0)
+		page = pt_clean[--pt_clean_cnt];
+	else if (pt_dirty_cnt > 0) {
+		page = pt_dirty[--pt_dirty_cnt];
+		dirty = true;
 	}
-	return NULL;
+	if (page != NULL)
+		pt_cache_hits++;
+	spinlock_release (&pt_cache_lock);
+
+	if (page == NULL)
+		return palloc_get_page (PAL_ZERO);
+	if (dirty)
+		clear_page (page);
+	return page;
 }
 
-static uint64_t *
-pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
-	uint64_t *pte = NULL;
-	int idx = PDPE (va);
-	int allocated = 0;
-	if (pdpe) {
-		uint64_t *pde = (uint64_t *) pdpe[idx];
-		if (!((uint64_t) pde & PTE_P)) {
-			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
-				if (new_page) {
-					pdpe[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
-					allocated = 1;
-				} else
-					return NULL;
-			} else
-				return NULL;
-		}
-		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create);
+/* 다 쓴 page table page PAGE를 cache에 둔다. CLEAN이면 이미 0이다. cache가 차
+ * 있으면 palloc에 돌려준다. */
+static void
+pt_page_put (void *page, bool clean) {
+	spinlock_acquire (&pt_cache_lock);
+	if (clean && pt_clean_cnt < PT_CACHE_PAGES) {
+		pt_clean[pt_clean_cnt++] = page;
+		page = NULL;
+	} else if (pt_dirty_cnt < PT_CACHE_PAGES) {
+		pt_dirty[pt_dirty_cnt++] = page;
+		page = NULL;
 	}
-	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pdpe[idx])));
-		pdpe[idx] = 0;
+	spinlock_release (&pt_cache_lock);
+	palloc_free_page (page);
+}
+
+/* cache의 dirty page 하나를 0으로 채워 clean으로 옮긴다. 할 일이 없으면 false.
+ * idle 스레드가 인터럽트를 켜고 부른다. */
+bool
+pml4_zero_idle (void) {
+	void *page = NULL;
+
+	spinlock_acquire (&pt_cache_lock);
+	if (pt_dirty_cnt > 0 && pt_clean_cnt < PT_CACHE_PAGES)
+		page = pt_dirty[--pt_dirty_cnt];
+	spinlock_release (&pt_cache_lock);
+	if (page == NULL)
+		return false;
+
+	clear_page (page);
+	pt_page_put (page, true);
+	return true;
+}
+
+/* page table page cache의 통계를 출력한다. */
+void
+pml4_print_stats (void) {
+	printf ("Page tables: %lld allocated, %lld from cache, %zu clean, "
+			"%zu dirty cached\n", pt_alloc_cnt, pt_cache_hits,
+			pt_clean_cnt, pt_dirty_cnt);
+}
+
+/* PATH[L]의 entry를 VAL로 바꾼다. present 여부가 바뀌면 그 entry가 있는 table의
+ * 개수 (PATH[L - 1]에 있다)도 고친다. */
+static void
+entry_set (uint64_t **path, int l, uint64_t val) {
+	uint64_t old = *path[l];
+
+	*path[l] = val;
+	if (l >= 2 && ((old ^ val) & PTE_P))
+		*path[l - 1] += (val & PTE_P) ? PTE_CNT_ONE : -PTE_CNT_ONE;
+}
+
+/* PML4에서 VA를 덮는 entry를 LEVEL 단계까지 찾아 단계마다 PATH에 둔다. 중간
+ * 단계의 table이 없으면 CREATE일 때 만들고 아니면 실패한다. 도중에 2 MB page의
+ * PDE를 만나면 거기서 멈춘다. 마지막으로 채운 단계를 리턴하고, 실패하면 이번에
+ * 만든 table을 모두 되돌리고 -1. */
+static int
+walk (uint64_t *pml4, const uint64_t va, int level, bool create,
+		uint64_t **path) {
+	uint64_t *table = pml4;
+	int l, alloc = -1;
+
+	for (l = 0; ; l++) {
+		uint64_t *e = &table[(va >> level_shift[l]) & 0x1ff];
+
+		path[l] = e;
+		if (l == level || (l == 2 && (*e & PTE_P) && (*e & PTE_PS)))
+			return l;
+		if (!(*e & PTE_P)) {
+			uint64_t *new_page;
+			if (!create || (new_page = pt_page_get ()) == NULL)
+				break;
+			entry_set (path, l, vtop (new_page) | PTE_U | PTE_W | PTE_P);
+			if (alloc < 0)
+				alloc = l;
+		}
+		table = ptov (PTE_ADDR (*e));
 	}
-	return pte;
+
+	/* 되돌리는 table에는 그 아래 table을 가리키던 entry 하나뿐이고, 그것도
+	 * 먼저 지웠으니 모두 0이다. */
+	if (alloc >= 0)
+		for (l--; l >= alloc; l--) {
+			pt_page_put (ptov (PTE_ADDR (*path[l])), true);
+			entry_set (path, l, 0);
+		}
+	return -1;
 }
 
 /* Returns the address of the page table entry for virtual
@@ -61,128 +198,207 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
  * on CREATE.  If CREATE is true, then a new page table is
  * created and a pointer into it is returned.  Otherwise, a null
  * pointer is returned. */
+/*** GrilledSalmon ***/
+/* 2 MB page 안이면 그 PDE를 리턴한다. 리턴한 entry를 직접 present로 만들지 말고
+ * pml4_map()을 쓴다. */
 uint64_t *
 pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
-	uint64_t *pte = NULL;
-	int idx = PML4 (va);
-	int allocated = 0;
-	if (pml4e) {
-		uint64_t *pdpe = (uint64_t *) pml4e[idx];
-		if (!((uint64_t) pdpe & PTE_P)) {
-			if (create) {
-				uint64_t *new_page = palloc_get_page (PAL_ZERO);
-				if (new_page) {
-					pml4e[idx] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
-					allocated = 1;
-				} else
-					return NULL;
-			} else
-				return NULL;
-		}
-		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create);
-	}
-	if (pte == NULL && allocated) {
-		palloc_free_page ((void *) ptov (PTE_ADDR (pml4e[idx])));
-		pml4e[idx] = 0;
-	}
-	return pte;
+	uint64_t *path[4];
+	int level;
+
+	if (pml4e == NULL || (level = walk (pml4e, va, 3, create, path)) < 0)
+		return NULL;
+	return path[level];
+}
+
+/*** GrilledSalmon ***/
+/* PML4에서 VA를 물리 주소 PA로 FLAGS 권한으로 매핑한다. FLAGS에 PTE_PS가 있으면
+ * VA와 PA가 HUGE_PGSIZE로 정렬되어 있어야 하고 PDE 하나로 2 MB를 매핑한다. 그
+ * 자리에 이미 2 MB page가 있거나, 2 MB를 매핑할 자리에 page table이 있으면 false.
+ * 메모리가 모자라도 false. */
+bool
+pml4_map (uint64_t *pml4, uint64_t va, uint64_t pa, uint64_t flags) {
+	uint64_t *path[4];
+	int level = flags & PTE_PS ? 2 : 3;
+
+	if (walk (pml4, va, level, true, path) != level)
+		return false;
+	if ((flags & PTE_PS) && (*path[2] & PTE_P))
+		return false;
+	entry_set (path, level, pa | flags);
+	return true;
 }
 
+static unsigned kern_first, kern_end;   /* present인 커널 PML4E의 범위. */
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
  * allocation fails. */
+/*** GrilledSalmon ***/
+/* 커널 매핑은 base_pml4의 PML4E가 가리키는 PDPT들을 모든 pml4가 같이 쓴다.
+ * paging_init() 뒤의 커널 매핑 (vmalloc)도 이미 있는 PDPT 아래에 들어가므로
+ * present인 커널 PML4E는 바뀌지 않는다. 그래서 처음 한 번 그 범위를 찾아 두고
+ * page 전체 대신 그 entry들만 복사한다. */
 uint64_t *
 pml4_create (void) {
-	uint64_t *pml4 = palloc_get_page (0);
+	uint64_t *pml4;
+
+	if (kern_end == 0) {
+		unsigned first = 0, end = 0, i;
+
+		for (i = PML4 (KERN_BASE); i < PT_CNT_ALL; i++)
+			if (base_pml4[i] & PTE_P) {
+				if (end == 0)
+					first = i;
+				end = i + 1;
+			}
+		ASSERT (end != 0);
+		kern_first = first;
+		kern_end = end;
+	}
+
+	pml4 = pt_page_get ();
 	if (pml4)
-		memcpy (pml4, base_pml4, PGSIZE);
+		memcpy (pml4 + kern_first, base_pml4 + kern_first,
+				(kern_end - kern_first) * sizeof *pml4);
 	return pml4;
 }
 
-static bool
-pt_for_each (uint64_t *pt, pte_for_each_func *func, void *aux,
-		unsigned pml4_index, unsigned pdp_index, unsigned pdx_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pte = &pt[i];
-		if (((uint64_t) *pte) & PTE_P) {
-			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
-								 ((uint64_t) pdp_index << PDPESHIFT) |
-								 ((uint64_t) pdx_index << PDXSHIFT) |
-								 ((uint64_t) i << PTXSHIFT));
-			if (!func (pte, va, aux))
-				return false;
-		}
-	}
-	return true;
-}
+/*** GrilledSalmon ***/
+/* table 순회 하나의 상태. FUNC와 RUN_FUNC 중 하나만 쓴다. */
+struct range_walk {
+	uint64_t start, end;        /* [START, END)에 걸친 entry만 본다. */
+	pte_for_each_func *func;    /* PTE마다 부른다. */
+	pte_run_func *run_func;     /* 이어진 PTE 묶음마다 부른다. */
+	void *aux;
+	uint64_t *run;              /* 모으고 있는 묶음의 첫 PTE. */
+	uint64_t run_va;            /* 그 PTE의 가상 주소. */
+	size_t run_cnt;             /* 모은 PTE의 수. 0이면 모으는 중이 아니다. */
+};
 
+/* 모아 둔 묶음을 RUN_FUNC에 넘긴다. */
 static bool
-pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
-		unsigned pml4_index, unsigned pdp_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
-				return false;
-	}
-	return true;
+range_flush_run (struct range_walk *r) {
+	size_t cnt = r->run_cnt;
+
+	r->run_cnt = 0;
+	return cnt == 0 || r->run_func (r->run, (void *) r->run_va, cnt, r->aux);
 }
 
+/* LEVEL 단계의 TABLE에서 [R->start, R->end)에 걸친 present entry를 훑는다. BASE는
+ * TABLE의 첫 entry가 덮는 가상 주소, CNT는 TABLE의 present entry 수. */
 static bool
-pdp_for_each (uint64_t *pdp,
-		pte_for_each_func *func, void *aux, unsigned pml4_index) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pde = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pde) & PTE_P)
-			if (!pgdir_for_each ((uint64_t *) PTE_ADDR (pde), func,
-					 aux, pml4_index, i))
+range_for_each (uint64_t *table, int level, uint64_t base, unsigned cnt,
+		struct range_walk *r) {
+	uint64_t size = 1ULL << level_shift[level];
+	unsigned i = r->start > base ? (r->start - base) >> level_shift[level] : 0;
+	unsigned seen = 0;
+
+	for (; i < PT_CNT_ALL && seen < cnt && base + i * size < r->end; i++) {
+		uint64_t *e = &table[i];
+		uint64_t va = base + i * size;
+
+		if (!(*e & PTE_P)) {
+			if (level == 3 && !range_flush_run (r))
 				return false;
+			continue;
+		}
+		seen++;
+		if (level == 3 && r->run_func != NULL) {
+			if (r->run_cnt++ == 0) {
+				r->run = e;
+				r->run_va = va;
+			}
+		} else if (level == 3 || (level == 2 && (*e & PTE_PS))) {
+			/* 2 MB page는 PDE 하나를 그 page의 첫 주소로 넘긴다. */
+			if (r->run_func != NULL ? !r->run_func (e, (void *) va, 1, r->aux)
+					: !r->func (e, (void *) va, r->aux))
+				return false;
+		} else if (!range_for_each (ptov (PTE_ADDR (*e)), level + 1, va,
+					level >= 1 ? pte_cnt (*e) : PT_CNT_ALL, r))
+			return false;
 	}
-	return true;
+	return level != 3 || range_flush_run (r);
 }
 
 /* Apply FUNC to each available pte entries including kernel's. */
 bool
 pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-		uint64_t *pdpe = ptov((uint64_t *) pml4[i]);
-		if (((uint64_t) pdpe) & PTE_P)
-			if (!pdp_for_each ((uint64_t *) PTE_ADDR (pdpe), func, aux, i))
-				return false;
-	}
-	return true;
+	return pml4_for_each_range (pml4, NULL, (void *) (1ULL << 48), func, aux);
 }
 
+/*** GrilledSalmon ***/
+/* PML4에서 [START, END)에 걸친 present PTE마다 FUNC를 부른다. FUNC가 false를
+ * 리턴하면 멈추고 false. 2 MB page는 그 PDE로 한 번 부른다. 매핑이 없는 table은
+ * 건너뛰므로 sparse한 주소 공간에서 빠르다. */
+bool
+pml4_for_each_range (uint64_t *pml4, void *start, void *end,
+		pte_for_each_func *func, void *aux) {
+	struct range_walk r = {
+		.start = (uint64_t) start, .end = (uint64_t) end,
+		.func = func, .aux = aux,
+	};
+
+	return range_for_each (pml4, 0, 0, PT_CNT_ALL, &r);
+}
+
+/* pml4_for_each_range()와 같지만, 한 page table 안에서 이어진 present PTE를
+ * 묶어 RUN_FUNC (첫 PTE, 그 가상 주소, PTE 수, AUX)로 한 번에 넘긴다. 묶음의
+ * PTE는 배열로 이어져 있고 가상 주소도 PGSIZE씩 이어진다. 2 MB page는 그 PDE
+ * 하나짜리 묶음이다 (PTE_PS로 구분한다). */
+bool
+pml4_for_each_run (uint64_t *pml4, void *start, void *end,
+		pte_run_func *run_func, void *aux) {
+	struct range_walk r = {
+		.start = (uint64_t) start, .end = (uint64_t) end,
+		.run_func = run_func, .aux = aux,
+	};
+
+	return range_for_each (pml4, 0, 0, PT_CNT_ALL, &r);
+}
+
+/* 다 쓴 page table PT를 놓는다. CNT는 PT의 present entry 수. 내려 둔 entry가
+ * 남아 있을 수 있으므로 dirty로 놓는다. */
 static void
-pt_destroy (uint64_t *pt) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+pt_destroy (uint64_t *pt, unsigned cnt) {
+	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *) && cnt > 0; i++) {
 		uint64_t *pte = ptov((uint64_t *) pt[i]);
-		if (((uint64_t) pte) & PTE_P)
-			palloc_free_page ((void *) PTE_ADDR (pte));
+		if (((uint64_t) pte) & PTE_P) {
+			if (!(pt[i] & PTE_SHARED))
+				palloc_free_page ((void *) PTE_ADDR (pte));
+			cnt--;
+		}
 	}
-	palloc_free_page ((void *) pt);
+	pt_page_put ((void *) pt, false);
 }
 
 static void
-pgdir_destroy (uint64_t *pdp) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+pgdir_destroy (uint64_t *pdp, unsigned cnt) {
+	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *) && cnt > 0; i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			pt_destroy (PTE_ADDR (pte));
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS)
+			palloc_free_multiple ((void *) PTE_ADDR (pte), HUGE_PGPAGES);
+		else
+			pt_destroy ((void *) PTE_ADDR (pte), pte_cnt (pdp[i]));
+		cnt--;
 	}
-	palloc_free_page ((void *) pdp);
+	pt_page_put ((void *) pdp, false);
 }
 
+/* PDPT의 entry는 present인 page directory뿐이므로 지우면서 돌면 0이 된다. */
 static void
 pdpe_destroy (uint64_t *pdpe) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pde = ptov((uint64_t *) pdpe[i]);
-		if (((uint64_t) pde) & PTE_P)
-			pgdir_destroy ((void *) PTE_ADDR (pde));
+		if (((uint64_t) pde) & PTE_P) {
+			pgdir_destroy ((void *) PTE_ADDR (pde), pte_cnt (pdpe[i]));
+			pdpe[i] = 0;
+		}
 	}
-	palloc_free_page ((void *) pdpe);
+	pt_page_put ((void *) pdpe, true);
 }
 
 /* Destroys pml4e, freeing all the pages it references. */
@@ -191,19 +407,126 @@ pml4_destroy (uint64_t *pml4) {
 	if (pml4 == NULL)
 		return;
 	ASSERT (pml4 != base_pml4);
+	ASSERT (!pml4_is_active (pml4));
+
+	/* 이 PCID를 다시 쓰는 pml4는 남은 항목을 비우며 올린다. */
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		for (unsigned i = 1; i < PCID_CNT; i++)
+			if (pcid_slots[i].pml4 == pml4)
+				pcid_slots[i].pml4 = NULL;
+		intr_set_level (old_level);
+	}
 
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
 		pdpe_destroy ((void *) PTE_ADDR (pdpe));
-	palloc_free_page ((void *) pml4);
+	/* 나머지는 pml4_create()가 복사한 커널 PML4E뿐이다. */
+	pml4[0] = 0;
+	memset (pml4 + kern_first, 0, (kern_end - kern_first) * sizeof *pml4);
+	pt_page_put ((void *) pml4, true);
+}
+
+/*** GrilledSalmon ***/
+/* CPU가 PCID를 지원하면 켠다. base_pml4를 올린 뒤, CR3의 PCID가 0일 때 부른다. */
+void
+pml4_pcid_init (void) {
+	uint32_t eax = 1, ebx, ecx, edx;
+
+	asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+	if (!(ecx & CPUID_1_ECX_PCID))
+		return;
+	ASSERT ((rcr3 () & CR3_PCID_MASK) == 0);
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_slots[0].pml4 = base_pml4;
+	pcid_enabled = true;
+}
+
+/* PML4가 쓸 PCID를 돌려준다. 처음 올리는 pml4면 빈 slot을, 없으면 돌아가며
+ * 하나를 빼앗아 준다. 그 PCID로 남은 TLB 항목을 비워야 하면 *FLUSH가 true. */
+static unsigned
+pcid_get (uint64_t *pml4, bool *flush) {
+	unsigned i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	for (i = 0; i < PCID_CNT; i++)
+		if (pcid_slots[i].pml4 == pml4) {
+			*flush = pcid_slots[i].stale;
+			pcid_slots[i].stale = false;
+			return i;
+		}
+
+	for (i = 1; i < PCID_CNT; i++)
+		if (pcid_slots[i].pml4 == NULL)
+			break;
+	if (i == PCID_CNT) {
+		i = pcid_victim;
+		pcid_victim = pcid_victim % (PCID_CNT - 1) + 1;
+	}
+	pcid_slots[i].pml4 = pml4;
+	pcid_slots[i].stale = false;
+	*flush = true;      /* 이전 주인의 항목이 남아 있다. */
+	return i;
+}
+
+/* PML4의 PCID를 stale로 표시한다. PML4가 NULL이면 모든 PCID. */
+static void
+pcid_mark_stale (uint64_t *pml4) {
+	enum intr_level old_level = intr_disable ();
+	unsigned i;
+
+	for (i = 0; i < PCID_CNT; i++)
+		if (pml4 == NULL || pcid_slots[i].pml4 == pml4)
+			pcid_slots[i].stale = true;
+	intr_set_level (old_level);
 }
 
 /* Loads page directory PD into the CPU's page directory base
  * register. */
+/*** GrilledSalmon ***/
+/* 이미 올라와 있는 pml4면 CR3를 다시 쓰지 않고, PCID를 쓰면 TLB를 비우지 않고
+ * 올린다. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	uint64_t cr3;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+	if (pml4_is_active (pml4))
+		return;
+	cr3 = vtop (pml4);
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		bool flush;
+
+		cr3 |= pcid_get (pml4, &flush);
+		if (!flush)
+			cr3 |= CR3_NOFLUSH;
+		intr_set_level (old_level);
+	}
+	lcr3 (cr3);
+}
+
+/* PML4가 지금 CR3에 올라와 있으면 true. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return (rcr3 () & ~CR3_PCID_MASK) == vtop (pml4);
+}
+
+/* PML4의 VA에 대한 TLB 항목을 비운다. 올라와 있는 pml4면 invlpg로 바로 비우고,
+ * 아니면 그 PCID를 stale로 표시한다. base_pml4의 커널 매핑은 모든 pml4가 같이
+ * 쓰므로 지금 PCID에서 비우고 나머지 PCID는 모두 stale로 표시한다. */
+static void
+tlb_flush_page (uint64_t *pml4, const void *va) {
+	if (pml4 == base_pml4) {
+		invlpg ((uint64_t) va);
+		if (pcid_enabled)
+			pcid_mark_stale (NULL);
+	} else if (pml4_is_active (pml4))
+		invlpg ((uint64_t) va);
+	else if (pcid_enabled)
+		pcid_mark_stale (pml4);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -216,6 +539,8 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
+	if (pte && (*pte & PTE_P) && (*pte & PTE_PS))
+		return ptov (PTE_ADDR (*pte)) + ((uint64_t) uaddr & (HUGE_PGSIZE - 1));
 	if (pte && (*pte & PTE_P))
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
 	return NULL;
@@ -236,11 +561,26 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	ASSERT (is_user_vaddr (upage));
 	ASSERT (pml4 != base_pml4);
 
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
+	return pml4_map (pml4, (uint64_t) upage, vtop (kpage),
+			PTE_P | (rw ? PTE_W : 0) | PTE_U);
+}
+
+/*** GrilledSalmon ***/
+/* pml4_set_page()의 2 MB판. UPAGE에서 HUGE_PGSIZE 바이트를 KPAGE부터의 연속된
+ * 물리 메모리로 PDE 하나에 매핑한다. UPAGE와 KPAGE는 HUGE_PGSIZE로 정렬되어
+ * 있어야 하고, 그 2 MB에 아직 page table이나 매핑이 없어야 한다. KPAGE는
+ * palloc_get_multiple()로 HUGE_PGPAGES개를 받은 것으로, pml4_destroy()가 한꺼번에
+ * 돌려준다. 메모리가 모자라거나 이미 매핑이 있으면 false. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT ((vtop (kpage) & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (is_user_vaddr (upage + HUGE_PGSIZE - 1));
+	ASSERT (pml4 != base_pml4);
 
-	if (pte)
-		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
-	return pte != NULL;
+	return pml4_map (pml4, (uint64_t) upage, vtop (kpage),
+			PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U);
 }
 
 /* Marks user virtual page UPAGE "not present" in page
@@ -249,19 +589,56 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
  * UPAGE need not be mapped. */
 void
 pml4_clear_page (uint64_t *pml4, void *upage) {
-	uint64_t *pte;
+	uint64_t *path[4];
+	int level;
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
-	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	level = walk (pml4, (uint64_t) upage, 3, false, path);
 
-	if (pte != NULL && (*pte & PTE_P) != 0) {
-		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+	if (level >= 0 && (*path[level] & PTE_P) != 0) {
+		entry_set (path, level, *path[level] & ~PTE_P);
+		tlb_flush_page (pml4, upage);
 	}
 }
 
+/* Like pml4_clear_page(), but leaves the TLB alone.  Only for a
+ * PML4 that is about to be destroyed: switching away from it
+ * drops whatever the TLB still holds. */
+void
+pml4_forget_page (uint64_t *pml4, void *upage) {
+	uint64_t *path[4];
+	int level;
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	level = walk (pml4, (uint64_t) upage, 3, false, path);
+
+	if (level >= 0 && (*path[level] & PTE_P) != 0)
+		entry_set (path, level, *path[level] & ~PTE_P);
+}
+
+/*** GrilledSalmon ***/
+/* base_pml4에서 커널 가상 주소 VA의 4 KB 매핑을 지우고 모든 PCID의 TLB에서
+ * 비운다. 매핑되어 있던 page를 direct map 주소로 리턴하고, 없었으면 NULL.
+ * 지운 자리의 page table은 남겨 둔다. vmalloc이 쓴다. */
+void *
+pml4_unmap_kernel (void *va) {
+	uint64_t *path[4];
+	uint64_t pte;
+
+	ASSERT (pg_ofs (va) == 0);
+	ASSERT (is_kernel_vaddr (va));
+
+	if (walk (base_pml4, (uint64_t) va, 3, false, path) != 3
+			|| !(*path[3] & PTE_P))
+		return NULL;
+	pte = *path[3];
+	entry_set (path, 3, 0);
+	tlb_flush_page (base_pml4, va);
+	return ptov (PTE_ADDR (pte));
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
  * that is, if the page has been modified since the PTE was
  * installed.
@@ -283,8 +660,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, vpage);
 	}
 }
 
@@ -309,7 +685,6 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, vpage);
 	}
 }
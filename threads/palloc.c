@@ -1,5 +1,6 @@
 #include "threads/palloc.h"
 #include <bitmap.h>
+#include <list.h>
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
@@ -24,13 +25,49 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are kept by a binary buddy allocator:
+   free_lists[K] holds the free blocks of 2**K pages, aligned to
+   2**K pages from the pool base, linked through a list_elem
+   stored in the first page of each block.  A request for N pages
+   takes a block of the smallest order that fits, splitting
+   larger blocks as needed, and gives the pages beyond N back.
+   Freeing merges a block with its buddy for as long as the buddy
+   is free too.  used_map still records which pages are handed
+   out, for page_from_pool() and sanity checks.
+
+   Each pool also keeps a small reserve of free pages that are
+   already zeroed.  The idle thread fills it through
+   palloc_zero_idle(), so a single-page PAL_ZERO request is
+   usually just a pop.  The reserve is given back to the buddy
+   lists whenever they run dry. */
+
+/* Largest block order the buddy allocator manages. */
+#define BUDDY_MAX_ORDER 10
+#define BUDDY_ORDERS (BUDDY_MAX_ORDER + 1)
+
+/* free_order[] value for a page that does not start a free block. */
+#define BUDDY_NONE 0xff
+
+/* Pre-zeroed pages each pool keeps in reserve. */
+#define ZERO_RESERVE_PAGES 64
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
+	const char *name;               /* For statistics. */
+	struct spinlock lock;           /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *free_order;            /* Per page: order of the free block it starts, or BUDDY_NONE. */
+	struct list free_lists[BUDDY_ORDERS]; /* Free blocks of each order. */
+	size_t zero_cnt;                /* Pages in ZERO_IDX. */
+	size_t zero_idx[ZERO_RESERVE_PAGES]; /* Free pages known to be zeroed. */
+
+	/* Statistics, protected by LOCK. */
+	size_t free_cnt;                /* Pages on the free lists. */
+	size_t used_cnt;                /* Pages handed out. */
+	size_t peak_used_cnt;           /* Most pages handed out at once. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -38,10 +75,14 @@ static struct pool kernel_pool, user_pool;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
-static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+static void init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free_block (struct pool *, size_t page_idx, int order);
+static void buddy_free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void zero_reserve_drain (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -158,7 +199,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 						break;
 					}
 					// generate kernel pool
-					init_pool (&kernel_pool,
+					init_pool (&kernel_pool, "Kernel",
 							&free_start, region_start, start + rem * PGSIZE);
 					// Transition to the next state
 					if (rem == size_in_pg) {
@@ -188,7 +229,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 	}
 
 	// generate the user pool
-	init_pool(&user_pool, &free_start, region_start, end);
+	init_pool(&user_pool, "User", &free_start, region_start, end);
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -224,11 +265,15 @@ split:
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free_range (pool, page_idx, page_cnt);
+				pool->free_cnt += page_cnt;
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				buddy_free_range (pool, page_idx, page_cnt);
+				pool->free_cnt += page_cnt;
 			}
 		}
 	}
@@ -258,14 +303,36 @@ palloc_init (void) {
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   FLAGS, in which case the kernel panics.  At most
+   1 << BUDDY_MAX_ORDER pages can be obtained at once. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	size_t page_idx = BITMAP_ERROR;
+	bool zeroed = false;
+
+	if (page_cnt > 0) {
+		spinlock_acquire (&pool->lock);
+		if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zero_cnt > 0) {
+			page_idx = pool->zero_idx[--pool->zero_cnt];
+			zeroed = true;
+		} else {
+			page_idx = buddy_alloc (pool, page_cnt);
+			if (page_idx == BITMAP_ERROR && pool->zero_cnt > 0) {
+				zero_reserve_drain (pool);
+				page_idx = buddy_alloc (pool, page_cnt);
+			}
+		}
+		if (page_idx != BITMAP_ERROR) {
+			ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+			bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+			pool->free_cnt -= page_cnt;
+			pool->used_cnt += page_cnt;
+			if (pool->used_cnt > pool->peak_used_cnt)
+				pool->peak_used_cnt = pool->used_cnt;
+		}
+		spinlock_release (&pool->lock);
+	}
 	void *pages;
 	
 	if (page_idx != BITMAP_ERROR)
@@ -274,7 +341,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 		pages = NULL;
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 	if (flags & PAL_ASSERT)
@@ -318,8 +385,13 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	spinlock_acquire (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range (pool, page_idx, page_cnt);
+	pool->free_cnt += page_cnt;
+	pool->used_cnt -= page_cnt;
+	spinlock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -328,19 +400,124 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Gives every page in POOL's zeroed reserve back to the buddy
+   lists.  POOL's lock must be held. */
+static void
+zero_reserve_drain (struct pool *pool) {
+	while (pool->zero_cnt > 0)
+		buddy_free_block (pool, pool->zero_idx[--pool->zero_cnt], 0);
+}
+
+/* Zeroes one free page into the reserve of a pool that is not
+   full yet, trying the user pool first since page faults are the
+   main PAL_ZERO users.  Returns false if there was nothing to do.
+   Called by the idle thread with interrupts on: the page is
+   zeroed outside the pool lock, so a thread that becomes ready
+   preempts the work right away. */
+bool
+palloc_zero_idle (void) {
+	struct pool *pools[] = { &user_pool, &kernel_pool };
+	size_t i;
+
+	for (i = 0; i < sizeof pools / sizeof *pools; i++) {
+		struct pool *pool = pools[i];
+		size_t page_idx = BITMAP_ERROR;
+
+		spinlock_acquire (&pool->lock);
+		if (pool->zero_cnt < ZERO_RESERVE_PAGES)
+			page_idx = buddy_alloc (pool, 1);
+		spinlock_release (&pool->lock);
+		if (page_idx == BITMAP_ERROR)
+			continue;
+
+		clear_page (pool->base + PGSIZE * page_idx);
+
+		spinlock_acquire (&pool->lock);
+		if (pool->zero_cnt < ZERO_RESERVE_PAGES)
+			pool->zero_idx[pool->zero_cnt++] = page_idx;
+		else
+			buddy_free_block (pool, page_idx, 0);
+		spinlock_release (&pool->lock);
+		return true;
+	}
+	return false;
+}
+
+/* Prints POOL's statistics.  The fragmentation figure is the
+   share of free pages outside the largest free block, so it
+   grows as free memory breaks up into pieces too small for
+   multi-page requests. */
+static void
+pool_print_stats (struct pool *pool) {
+	size_t free_cnt, used_cnt, peak_used_cnt, zero_cnt, largest = 0;
+	int order;
+
+	/* Take a snapshot so we don't print with the lock held. */
+	spinlock_acquire (&pool->lock);
+	free_cnt = pool->free_cnt;
+	used_cnt = pool->used_cnt;
+	peak_used_cnt = pool->peak_used_cnt;
+	zero_cnt = pool->zero_cnt;
+	for (order = BUDDY_MAX_ORDER; order >= 0; order--)
+		if (!list_empty (&pool->free_lists[order])) {
+			largest = (size_t) 1 << order;
+			break;
+		}
+	spinlock_release (&pool->lock);
+
+	printf ("%s pool: %zu pages used (peak %zu), %zu free (%zu zeroed), "
+			"largest free block %zu pages, %zu%% fragmented\n",
+			pool->name, used_cnt, peak_used_cnt, free_cnt, zero_cnt, largest,
+			free_cnt > 0 ? 100 - largest * 100 / free_cnt : 0);
+}
+
+/* Stores the kernel virtual address of the user pool's first
+   page in *BASE and the number of pages in the pool in
+   *PAGE_CNT. */
+void
+palloc_user_pool (void **base, size_t *page_cnt) {
+	*base = user_pool.base;
+	*page_cnt = bitmap_size (user_pool.used_map);
+}
+
+/* Returns the number of free pages in the user pool.  The count
+   is read without the pool lock, so it is only a hint. */
+size_t
+palloc_user_free_cnt (void) {
+	return user_pool.free_cnt;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) {
+	pool_print_stats (&kernel_pool);
+	pool_print_stats (&user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
+init_pool (struct pool *p, const char *name, void **bm_base,
+		uint64_t start, uint64_t end) {
   /* We'll put the pool's used_map at its base.
      Calculate the space needed for the bitmap
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = bitmap_buf_size (pgcnt);
+	size_t bm_pages = DIV_ROUND_UP (bm_size + pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->name = name;
+	spinlock_init (&p->lock);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_size);
 	p->base = (void *) start;
 
+	// The buddy order map follows the bitmap.
+	p->free_order = (uint8_t *) *bm_base + bm_size;
+	memset (p->free_order, BUDDY_NONE, pgcnt);
+	for (order = 0; order < BUDDY_ORDERS; order++)
+		list_init (&p->free_lists[order]);
+	p->zero_cnt = 0;
+
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
@@ -356,3 +533,86 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the list element kept in the first page of the block
+   that starts at page PAGE_IDX of POOL. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx) {
+	return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the free block of 1 << ORDER pages at PAGE_IDX to POOL,
+   merging it with its buddy for as long as the buddy is free. */
+static void
+buddy_free_block (struct pool *pool, size_t page_idx, int order) {
+	size_t pool_pages = bitmap_size (pool->used_map);
+
+	while (order < BUDDY_MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+		if (buddy >= pool_pages || pool->free_order[buddy] != order)
+			break;
+		list_remove (block_elem (pool, buddy));
+		pool->free_order[buddy] = BUDDY_NONE;
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	pool->free_order[page_idx] = order;
+	list_push_front (&pool->free_lists[order], block_elem (pool, page_idx));
+}
+
+/* Gives the PAGE_CNT pages starting at PAGE_IDX back to POOL, as
+   the largest aligned blocks that cover them. */
+static void
+buddy_free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+		while (order < BUDDY_MAX_ORDER
+				&& (page_idx & ((size_t) 1 << order)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free_block (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Takes PAGE_CNT contiguous pages out of POOL's free lists and
+   returns the index of the first one, or BITMAP_ERROR if no free
+   block is big enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	struct list_elem *e;
+	size_t page_idx;
+	int want = 0, order;
+
+	while (((size_t) 1 << want) < page_cnt)
+		if (++want > BUDDY_MAX_ORDER)
+			return BITMAP_ERROR;
+
+	for (order = want; order <= BUDDY_MAX_ORDER; order++)
+		if (!list_empty (&pool->free_lists[order]))
+			break;
+	if (order > BUDDY_MAX_ORDER)
+		return BITMAP_ERROR;
+
+	e = list_pop_front (&pool->free_lists[order]);
+	page_idx = pg_no (e) - pg_no (pool->base);
+	ASSERT (pool->free_order[page_idx] == order);
+	pool->free_order[page_idx] = BUDDY_NONE;
+
+	/* Split down to the order we want; the upper halves stay free. */
+	while (order > want) {
+		size_t half;
+
+		order--;
+		half = page_idx + ((size_t) 1 << order);
+		pool->free_order[half] = order;
+		list_push_front (&pool->free_lists[order], block_elem (pool, half));
+	}
+
+	/* Give back the pages beyond PAGE_CNT. */
+	if (page_cnt < ((size_t) 1 << want))
+		buddy_free_range (pool, page_idx + page_cnt,
+				((size_t) 1 << want) - page_cnt);
+	return page_idx;
+}
@@ -0,0 +1,195 @@
+#include "threads/profile.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/*** GrilledSalmon ***/
+/* Sampling profiler.  See profile.h.
+
+   Samples go into a fixed buffer allocated at boot.  Only the
+   8254 timer interrupt records, on one CPU with interrupts off, so
+   the buffer needs no lock.  When it is full, further samples are
+   only counted. */
+
+/* -profile: Sample the interrupted code on every timer tick? */
+bool profile_enabled;
+
+/* Frames recorded per sample, the interrupted rip included. */
+#define PROFILE_DEPTH 8
+
+/* Pages of samples: 4096 samples, about 40 seconds at 100 Hz. */
+#define PROFILE_PAGES 64
+
+/* Addresses in the histogram. */
+#define PROFILE_TOP 20
+
+/* One sample.  PC[0] is the interrupted rip, PC[1] its caller's
+   return address, and so on; unused entries are 0. */
+struct profile_sample {
+	uint64_t pc[PROFILE_DEPTH];
+};
+
+/* One address in the histogram. */
+struct profile_count {
+	uint64_t pc;
+	uint64_t cnt;
+};
+
+static struct profile_sample *samples;
+static size_t sample_max;           /* Capacity of SAMPLES. */
+static size_t sample_cnt;           /* Samples recorded. */
+static size_t user_cnt;             /* Ticks that interrupted user code. */
+static size_t dropped_cnt;          /* Kernel ticks after SAMPLES filled. */
+
+/* Allocates the sample buffer if -profile was given. */
+void
+profile_init (void) {
+	if (!profile_enabled)
+		return;
+	samples = palloc_get_multiple (PAL_ZERO, PROFILE_PAGES);
+	if (samples == NULL) {
+		printf ("profile: out of memory, profiling disabled\n");
+		profile_enabled = false;
+		return;
+	}
+	sample_max = PROFILE_PAGES * PGSIZE / sizeof *samples;
+}
+
+/* Records where the timer interrupt F struck.  Follows the saved
+   rbp chain only while it stays inside the interrupted thread's
+   stack page and keeps going up, so a function caught in its
+   prologue or a corrupted frame ends the backtrace early instead of
+   faulting. */
+void
+profile_sample (const struct intr_frame *f) {
+	uintptr_t stack_top = pg_round_down (f) + PGSIZE;
+	uintptr_t fp = f->R.rbp;
+	struct profile_sample *s;
+	int d;
+
+	if ((f->cs & 3) != 0) {
+		user_cnt++;
+		return;
+	}
+	if (sample_cnt >= sample_max) {
+		dropped_cnt++;
+		return;
+	}
+
+	s = &samples[sample_cnt++];
+	s->pc[0] = f->rip;
+	for (d = 1; d < PROFILE_DEPTH; d++) {
+		uint64_t *frame = (uint64_t *) fp;
+
+		if (fp <= (uintptr_t) f || fp + 16 > stack_top || (fp & 7) != 0)
+			break;
+		if (!is_kernel_vaddr (frame[1]))
+			break;
+		s->pc[d] = frame[1];
+		if (frame[0] <= fp)
+			break;
+		fp = frame[0];
+	}
+}
+
+/* Orders samples by whole stack. */
+static int
+compare_stack (const void *a_, const void *b_) {
+	const struct profile_sample *a = a_, *b = b_;
+	int d;
+
+	for (d = 0; d < PROFILE_DEPTH; d++)
+		if (a->pc[d] != b->pc[d])
+			return a->pc[d] < b->pc[d] ? -1 : 1;
+	return 0;
+}
+
+/* Orders samples by interrupted rip. */
+static int
+compare_pc (const void *a_, const void *b_) {
+	const struct profile_sample *a = a_, *b = b_;
+
+	return a->pc[0] < b->pc[0] ? -1 : a->pc[0] > b->pc[0];
+}
+
+/* Orders histogram entries by count, largest first. */
+static int
+compare_count (const void *a_, const void *b_) {
+	const struct profile_count *a = a_, *b = b_;
+
+	return a->cnt > b->cnt ? -1 : a->cnt < b->cnt;
+}
+
+/* Prints one folded stack, outermost caller first, with its
+   sample count. */
+static void
+print_folded (const struct profile_sample *s, size_t cnt) {
+	int d;
+
+	for (d = PROFILE_DEPTH - 1; d >= 0 && s->pc[d] == 0; d--)
+		continue;
+	printf ("folded: ");
+	for (; d >= 0; d--)
+		printf ("0x%llx%s", (unsigned long long) s->pc[d], d > 0 ? ";" : "");
+	printf (" %zu\n", cnt);
+}
+
+/* Stops sampling and prints the profile.  The output is
+
+       Profile: N kernel samples, U user, D dropped
+       folded: 0xOUTER;...;0xRIP COUNT
+       ...
+       Hottest addresses:
+         0xRIP COUNT PERCENT%
+       ...
+
+   Lines starting with "folded: " are, without that prefix, stacks
+   in the format flame graph tools read; user ticks appear as the
+   single frame "[user]".  The addresses can be symbolized with
+   utils/backtrace or with addr2line on kernel.o.  Consumes the
+   sample buffer. */
+void
+profile_print (void) {
+	struct profile_count *counts;
+	size_t i, j, n;
+
+	if (samples == NULL)
+		return;
+	profile_enabled = false;
+
+	printf ("Profile: %zu kernel samples, %zu user, %zu dropped\n",
+			sample_cnt, user_cnt, dropped_cnt);
+	qsort (samples, sample_cnt, sizeof *samples, compare_stack);
+	for (i = 0; i < sample_cnt; i = j) {
+		for (j = i + 1; j < sample_cnt; j++)
+			if (compare_stack (&samples[i], &samples[j]) != 0)
+				break;
+		print_folded (&samples[i], j - i);
+	}
+	if (user_cnt > 0)
+		printf ("folded: [user] %zu\n", user_cnt);
+
+	/* Counts go over the front of the buffer: entry N is written
+	   no later than sample N is read, and is smaller. */
+	qsort (samples, sample_cnt, sizeof *samples, compare_pc);
+	counts = (struct profile_count *) samples;
+	for (i = n = 0; i < sample_cnt; i = j) {
+		uint64_t pc = samples[i].pc[0];
+
+		for (j = i + 1; j < sample_cnt; j++)
+			if (samples[j].pc[0] != pc)
+				break;
+		counts[n].pc = pc;
+		counts[n].cnt = j - i;
+		n++;
+	}
+	qsort (counts, n, sizeof *counts, compare_count);
+	printf ("Hottest addresses:\n");
+	for (i = 0; i < n && i < PROFILE_TOP; i++)
+		printf ("  0x%016llx %6llu %3llu%%\n", (unsigned long long) counts[i].pc,
+				(unsigned long long) counts[i].cnt,
+				(unsigned long long) (counts[i].cnt * 100 / sample_cnt));
+}
@@ -0,0 +1,179 @@
+#include "threads/rcu.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/*** GrilledSalmon ***/
+/* Read-copy-update.
+
+   Readers of a table that rarely changes take no lock.  They
+   bracket their lookup with rcu_read_lock() and
+   rcu_read_unlock().  A writer, under the table's own lock,
+   unlinks an object with rcu_assign_pointer() and hands it to
+   call_rcu().  The object is freed only after every reader that
+   might still see it has left.
+
+   A grace period is the time until the readers that were inside
+   when it started have all left.  Readers may be preempted and
+   may sleep, so a context switch alone does not prove that a
+   thread has left.  Instead each reader counts itself in one of
+   two phases.  A grace period flips the phase that new readers
+   enter, then waits for the old phase's count to reach zero.
+   schedule() checks that on every context switch.  The last
+   reader out of the old phase, and call_rcu(), also check it.
+   When a grace period ends, its callbacks run in a bottom half.
+   Callbacks queued during a grace period wait for the next one.
+
+   All of this state is protected by turning interrupts off. */
+
+static int rcu_phase;                   /* 새 reader가 들어가는 phase. */
+static int rcu_readers[2];              /* phase마다 안에 있는 reader 수. */
+static bool gp_active;                  /* rcu_readers[!rcu_phase]가 0이 되기를 기다린다. */
+
+/* 다음 grace period를, 지금 grace period를 기다리는 callback과 끝나서 부를
+   callback. */
+static struct rcu_head *next_list, **next_tail = &next_list;
+static struct rcu_head *wait_list, **wait_tail = &wait_list;
+static struct rcu_head *done_list, **done_tail = &done_list;
+
+static void run_callbacks (void *aux);
+static struct work done_work = { .func = run_callbacks };
+
+/* 통계. */
+static long long gp_cnt;
+static long long cb_cnt;
+
+/* grace period가 끝났는지 보고, 끝났으면 callback을 bottom half로 넘긴 뒤
+   기다리는 callback이 있으면 다음 grace period를 시작한다. 인터럽트는 꺼져
+   있어야 한다. */
+static void
+rcu_advance (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (;;) {
+		if (gp_active) {
+			if (rcu_readers[!rcu_phase] != 0)
+				return;
+			*done_tail = wait_list;
+			done_tail = wait_tail;
+			wait_list = NULL;
+			wait_tail = &wait_list;
+			gp_active = false;
+			gp_cnt++;
+			bh_schedule (&done_work);
+		}
+		if (next_list == NULL)
+			return;
+		wait_list = next_list;
+		wait_tail = next_tail;
+		next_list = NULL;
+		next_tail = &next_list;
+		rcu_phase = !rcu_phase;
+		gp_active = true;
+	}
+}
+
+/* 읽기 구간에 들어간다. 겹쳐 부를 수 있다. 구간 안에서 잠들어도 되지만 그동안
+   call_rcu의 callback이 밀린다. */
+void
+rcu_read_lock (void) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (!intr_context ());
+	if (cur->rcu_nesting++ == 0) {
+		enum intr_level old_level = intr_disable ();
+
+		cur->rcu_phase = rcu_phase;
+		rcu_readers[rcu_phase]++;
+		intr_set_level (old_level);
+	}
+}
+
+/* 읽기 구간에서 나온다. */
+void
+rcu_read_unlock (void) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (cur->rcu_nesting > 0);
+	if (--cur->rcu_nesting == 0) {
+		enum intr_level old_level = intr_disable ();
+
+		rcu_readers[cur->rcu_phase]--;
+		rcu_advance ();
+		intr_set_level (old_level);
+	}
+}
+
+/* 지금 읽기 구간 안에 있는 reader가 모두 나온 뒤 FUNC (HEAD)를 부른다.
+   FUNC는 bottom half 스레드에서 돌고, 디스크 I/O를 기다리면 안 된다. 인터럽트
+   처리기에서 불러도 된다. */
+void
+call_rcu (struct rcu_head *head, rcu_func *func) {
+	enum intr_level old_level;
+
+	head->func = func;
+	head->next = NULL;
+	old_level = intr_disable ();
+	*next_tail = head;
+	next_tail = &head->next;
+	rcu_advance ();
+	intr_set_level (old_level);
+}
+
+struct rcu_sync {
+	struct rcu_head head;
+	struct semaphore done;
+};
+
+static void
+sync_done (struct rcu_head *head) {
+	sema_up (&rcu_entry (head, struct rcu_sync, head)->done);
+}
+
+/* 지금 읽기 구간 안에 있는 reader가 모두 나올 때까지 기다린다. 읽기 구간
+   안에서 부르면 자기 자신을 기다리게 된다. */
+void
+synchronize_rcu (void) {
+	struct rcu_sync sync;
+
+	ASSERT (thread_current ()->rcu_nesting == 0);
+	sema_init (&sync.done, 0);
+	call_rcu (&sync.head, sync_done);
+	sema_down (&sync.done);
+}
+
+/* schedule()이 context switch마다 부른다. */
+void
+rcu_quiescent (void) {
+	if (gp_active)
+		rcu_advance ();
+}
+
+static void
+run_callbacks (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct rcu_head *head = done_list;
+
+		done_list = NULL;
+		done_tail = &done_list;
+		intr_set_level (old_level);
+		if (head == NULL)
+			break;
+		while (head != NULL) {
+			struct rcu_head *next = head->next;
+
+			cb_cnt++;
+			head->func (head);
+			head = next;
+		}
+	}
+}
+
+void
+rcu_print_stats (void) {
+	printf ("RCU: %lld grace periods, %lld callbacks\n", gp_cnt, cb_cnt);
+}
@@ -0,0 +1,269 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   malloc() rounds every request up to a power of two, so a
+   structure slightly over a power of two wastes almost half of
+   its block.  An object cache hands out objects of exactly one
+   size instead.  It carves whole pages ("slabs") into as many
+   objects as fit, and keeps a stack of free object indexes in
+   each slab's header.  Because the free list lives outside the
+   objects, a free object keeps the state its constructor gave
+   it.
+
+   Recently freed objects first go into the cache's magazine, a
+   small LIFO array.  The next allocation pops from it without
+   touching any slab.  Only when the magazine is empty or full
+   does the cache fall back to its slabs.
+
+   Slabs with free objects are on the cache's `partial' list and
+   full slabs are on its `full' list.  A slab whose objects are
+   all free again goes back to the page allocator, unless it is
+   the cache's only slab with free space. */
+
+/* Number of objects a cache's magazine holds. */
+#define KMEM_MAGAZINE_SIZE 16
+
+/* Identifies a slab. */
+#define SLAB_MAGIC 0x534c4142
+
+/* Object cache. */
+struct kmem_cache {
+	const char *name;           /* For debugging. */
+	size_t size;                /* Object size in bytes. */
+	size_t stride;              /* Distance between objects. */
+	size_t obj_ofs;             /* Offset of object 0 in a slab. */
+	size_t objs_per_slab;       /* Objects in each slab. */
+	kmem_ctor_func *ctor;       /* Constructor, or null. */
+	struct spinlock lock;       /* Protects everything below. */
+	struct list partial;        /* Slabs with at least one free object. */
+	struct list full;           /* Slabs with no free objects. */
+	size_t mag_cnt;             /* Objects in MAGAZINE. */
+	void *magazine[KMEM_MAGAZINE_SIZE]; /* Recently freed objects. */
+	size_t live_cnt;            /* Objects handed out and not freed. */
+	size_t peak_live_cnt;       /* Largest LIVE_CNT so far. */
+	size_t slab_cnt;            /* Slab pages held now. */
+	struct kmem_cache *next;    /* Next in ALL_CACHES. */
+};
+
+/* Every cache, newest first, for kmem_print_stats(). */
+static struct kmem_cache *all_caches;
+
+/* Header at the start of each slab page. */
+struct slab {
+	unsigned magic;             /* SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* In cache's `partial' or `full'. */
+	size_t free_cnt;            /* Number of entries in FREE_IDX. */
+	uint16_t free_idx[];        /* Stack of free object indexes. */
+};
+
+/* Returns the offset of object 0 in a slab holding N objects
+   aligned to ALIGN. */
+static size_t
+slab_obj_ofs (size_t n, size_t align) {
+	return ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+}
+
+/* Creates and returns a cache of objects of SIZE bytes, each
+   aligned to ALIGN bytes (a power of two, or 0 for the natural
+   alignment of a pointer).  If CTOR is nonnull, it is called on
+   every object once, when the slab holding it is created; freed
+   objects must be returned in their constructed state.  NAME is
+   kept for debugging.  Returns a null pointer if memory is not
+   available. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *cache;
+	enum intr_level old_level;
+	size_t n;
+
+	if (align < sizeof (void *))
+		align = sizeof (void *);
+	ASSERT ((align & (align - 1)) == 0);
+	ASSERT (size > 0 && size <= PGSIZE / 4);
+
+	cache = malloc (sizeof *cache);
+	if (cache == NULL)
+		return NULL;
+
+	cache->name = name;
+	cache->size = size;
+	cache->stride = ROUND_UP (size, align);
+	n = (PGSIZE - sizeof (struct slab)) / (cache->stride + sizeof (uint16_t));
+	while (slab_obj_ofs (n, align) + n * cache->stride > PGSIZE)
+		n--;
+	ASSERT (n > 0);
+	cache->objs_per_slab = n;
+	cache->obj_ofs = slab_obj_ofs (n, align);
+	cache->ctor = ctor;
+	spinlock_init (&cache->lock);
+	list_init (&cache->partial);
+	list_init (&cache->full);
+	cache->mag_cnt = 0;
+	cache->live_cnt = cache->peak_live_cnt = cache->slab_cnt = 0;
+
+	old_level = intr_disable ();
+	cache->next = all_caches;
+	all_caches = cache;
+	intr_set_level (old_level);
+	return cache;
+}
+
+/* Returns object IDX of slab S in CACHE. */
+static void *
+slab_obj (struct kmem_cache *cache, struct slab *s, size_t idx) {
+	return (uint8_t *) s + cache->obj_ofs + idx * cache->stride;
+}
+
+/* Allocates a new slab for CACHE, constructs its objects and puts
+   it on the partial list.  Returns false if no page is
+   available. */
+static bool
+slab_grow (struct kmem_cache *cache) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return false;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = cache;
+	s->free_cnt = cache->objs_per_slab;
+	for (i = 0; i < cache->objs_per_slab; i++) {
+		/* Hand out low indexes first. */
+		s->free_idx[i] = cache->objs_per_slab - 1 - i;
+		if (cache->ctor != NULL)
+			cache->ctor (slab_obj (cache, s, i));
+	}
+	list_push_front (&cache->partial, &s->elem);
+	cache->slab_cnt++;
+	return true;
+}
+
+/* Obtains and returns an object from CACHE, or a null pointer if
+   memory is not available.  The object is in the state its
+   constructor, or whoever freed it last, left it in; it is not
+   zeroed. */
+void *
+kmem_cache_alloc (struct kmem_cache *cache) {
+	struct slab *s;
+	void *obj;
+
+	ASSERT (cache != NULL);
+
+	spinlock_acquire (&cache->lock);
+	if (cache->mag_cnt > 0) {
+		obj = cache->magazine[--cache->mag_cnt];
+		goto done;
+	}
+
+	if (list_empty (&cache->partial) && !slab_grow (cache)) {
+		spinlock_release (&cache->lock);
+		return NULL;
+	}
+
+	s = list_entry (list_front (&cache->partial), struct slab, elem);
+	ASSERT (s->free_cnt > 0);
+	obj = slab_obj (cache, s, s->free_idx[--s->free_cnt]);
+	if (s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&cache->full, &s->elem);
+	}
+
+done:
+	if (++cache->live_cnt > cache->peak_live_cnt)
+		cache->peak_live_cnt = cache->live_cnt;
+	spinlock_release (&cache->lock);
+	return obj;
+}
+
+/* Returns OBJ to the slab it came from.  CACHE's lock must be
+   held. */
+static void
+slab_put (struct kmem_cache *cache, void *obj) {
+	struct slab *s = pg_round_down (obj);
+	size_t idx = ((uint8_t *) obj - (uint8_t *) s - cache->obj_ofs) / cache->stride;
+
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == cache);
+	ASSERT (idx < cache->objs_per_slab);
+	ASSERT (slab_obj (cache, s, idx) == obj);
+	ASSERT (s->free_cnt < cache->objs_per_slab);
+
+	if (s->free_cnt++ == 0) {
+		/* It was full. */
+		list_remove (&s->elem);
+		list_push_front (&cache->partial, &s->elem);
+	}
+	s->free_idx[s->free_cnt - 1] = idx;
+
+	/* Keep it if it is the only slab with free objects. */
+	if (s->free_cnt == cache->objs_per_slab
+			&& list_begin (&cache->partial) != list_rbegin (&cache->partial)) {
+		list_remove (&s->elem);
+		s->magic = 0;
+		palloc_free_page (s);
+		cache->slab_cnt--;
+	}
+}
+
+/* Frees OBJ, which must have been obtained from CACHE.  A null
+   pointer is ignored. */
+void
+kmem_cache_free (struct kmem_cache *cache, void *obj) {
+	ASSERT (cache != NULL);
+
+	if (obj == NULL)
+		return;
+	ASSERT (((struct slab *) pg_round_down (obj))->cache == cache);
+
+	spinlock_acquire (&cache->lock);
+	if (cache->mag_cnt == KMEM_MAGAZINE_SIZE) {
+		/* Flush the older half of the magazine back to the slabs. */
+		size_t i, half = KMEM_MAGAZINE_SIZE / 2;
+
+		for (i = 0; i < half; i++)
+			slab_put (cache, cache->magazine[i]);
+		for (i = half; i < KMEM_MAGAZINE_SIZE; i++)
+			cache->magazine[i - half] = cache->magazine[i];
+		cache->mag_cnt -= half;
+	}
+	cache->magazine[cache->mag_cnt++] = obj;
+	cache->live_cnt--;
+	spinlock_release (&cache->lock);
+}
+
+/* Prints, for each cache, the objects in use now and at the
+   peak, the bytes they take, and the slab pages the cache holds.
+   The difference between the last two is what the cache wastes
+   in partly used slabs and in its magazine. */
+void
+kmem_print_stats (void) {
+	struct kmem_cache *cache;
+
+	for (cache = all_caches; cache != NULL; cache = cache->next) {
+		size_t live_cnt, peak_live_cnt, slab_cnt;
+
+		spinlock_acquire (&cache->lock);
+		live_cnt = cache->live_cnt;
+		peak_live_cnt = cache->peak_live_cnt;
+		slab_cnt = cache->slab_cnt;
+		spinlock_release (&cache->lock);
+
+		printf ("slab: %-12s %4zu-byte objects: %zu live (peak %zu), "
+				"%zu bytes in %zu pages\n", cache->name, cache->size, live_cnt,
+				peak_live_cnt, live_cnt * cache->size, slab_cnt);
+	}
+}
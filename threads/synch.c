@@ -31,12 +31,42 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
 
-void donate_priority(void);
-void remove_with_lock(struct lock *lock);
-void refresh_priority(void);
+/* donation을 전파하는 최대 깊이 (nested donation) */
+#define DONATION_DEPTH_MAX 8
+
+/* 대기 순번. 우선순위가 같은 waiter들은 먼저 온 순서대로 깨어난다. */
+static int64_t next_wait_seq;
+
+static struct thread *sema_wake (struct semaphore *);
+static void handoff (struct thread *);
+
+/* 우선순위가 높은 스레드가 먼저, 같다면 먼저 기다리기 시작한 스레드가 먼저 나온다. */
+static bool
+waiter_first (const struct thread *a, const struct thread *b) {
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->wait_seq < b->wait_seq;
+}
+
+/* 세마포어 waiters 힙의 비교 함수 */
+static bool
+sema_waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return waiter_first (heap_entry (a, struct thread, wait_elem),
+			heap_entry (b, struct thread, wait_elem));
+}
+
+/* lock donors 힙의 비교 함수 */
+static bool
+donor_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return waiter_first (heap_entry (a, struct thread, donor_elem),
+			heap_entry (b, struct thread, donor_elem));
+}
 
-// list_entry (list_pop_front (&sema->waiters), struct thread, elem));
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -51,7 +81,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, sema_waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -74,14 +104,48 @@ sema_down (struct semaphore *sema) {
 
 	old_level = intr_disable ();
 	while (sema->value == 0) {
-		// 현재 running 쓰레드의 elem과 sema.waiters와 연결
-		list_insert_ordered (&sema->waiters, &thread_current()->elem, cmp_priority, NULL);
+		// 현재 running 쓰레드를 sema.waiters 힙에 넣는다. (우선순위가 바뀌면 synch_update_waiter가 재배치)
+		struct thread *cur = thread_current ();
+		cur->wait_on_sema = sema;
+		cur->wait_seq = next_wait_seq++;
+		heap_push (&sema->waiters, &cur->wait_elem);
 		thread_block ();
 	}
 	sema->value--;
 	intr_set_level (old_level);
 }
 
+/*** GrilledSalmon ***/
+/* sema_down()과 같지만 TICKS tick 안에 내리지 못하면 포기하고 false를 리턴한다.
+   내렸으면 true. TICKS가 0 이하면 sema_try_down()과 같다. 기다리는 동안에는
+   타이머 휠에도 들어가 있어서, 시간이 다 되면 thread_awake()가 waiters에서
+   빼고 깨운다. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) {
+	int64_t deadline = timer_ticks () + ticks;
+	enum intr_level old_level;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	while (sema->value == 0) {
+		struct thread *cur = thread_current ();
+
+		if (timer_ticks () >= deadline) {
+			intr_set_level (old_level);
+			return false;
+		}
+		cur->wait_on_sema = sema;
+		cur->wait_seq = next_wait_seq++;
+		heap_push (&sema->waiters, &cur->wait_elem);
+		thread_block_timeout (deadline);
+	}
+	sema->value--;
+	intr_set_level (old_level);
+	return true;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -118,20 +182,60 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	// 리스트 pop을 하기 전에 항상 list가 empty 상태가 아닌지 확인해주는 습관을 들이자!
-	if (!list_empty (&sema->waiters)){
-		// waiters에 있는 쓰레드의 우선순위가 변경되었을 경우를 고려하여 정렬해준다.
-		list_sort(&sema->waiters, cmp_priority, NULL);
-		// 정렬 후의 리스트에서 가장 우선순위가 높은 것을 가져와서 thread를 Status가 THREADRUNNING으로 바꾸어준다.
-		thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
-	}
-	sema->value++;
+	sema_wake (sema);
 	// 현재 thread_current의 우선순위와 ready que 안에 있는 priority의 최댓값을 비교하여 높은 우선순위 thread를 yield해준다.
 	// 더 높은 우선순위를 선점시키기 위한 장치로서 선언해주었다.
 	test_max_priority();
 	intr_set_level (old_level);
 }
 
+/*** GrilledSalmon ***/
+/* sema_up()과 같지만 깨운 스레드의 우선순위가 현재 스레드 이상이면 그 스레드로
+   바로 전환한다 (thread_yield_to()). 같은 우선순위의 두 스레드가 주고받는 경우
+   sema_up()은 time slice가 끝날 때까지 깨운 쪽이 돌지만, 여기서는 바로 넘어간다.
+   인터럽트 핸들러에서 부르면 sema_up()과 같다. */
+void
+sema_up_handoff (struct semaphore *sema) {
+	enum intr_level old_level;
+
+	ASSERT (sema != NULL);
+
+	old_level = intr_disable ();
+	handoff (sema_wake (sema));
+	intr_set_level (old_level);
+}
+
+/* SEMA의 waiters 중 가장 우선순위가 높은 스레드를 깨우고 value를 올린다.
+   깨운 스레드를 리턴하고 waiters가 비어 있었으면 NULL. 인터럽트는 꺼져 있어야
+   한다. */
+static struct thread *
+sema_wake (struct semaphore *sema) {
+	struct thread *t = NULL;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	// 리스트 pop을 하기 전에 항상 list가 empty 상태가 아닌지 확인해주는 습관을 들이자!
+	if (!heap_empty (&sema->waiters)){
+		// waiters 힙의 top이 가장 우선순위가 높은 스레드이다. (우선순위 변경은 힙에 이미 반영되어 있다.)
+		t = heap_entry (heap_pop (&sema->waiters), struct thread, wait_elem);
+		t->wait_on_sema = NULL;
+		thread_unblock (t);
+	}
+	sema->value++;
+	return t;
+}
+
+/* ready 상태인 T로 전환한다. 그럴 수 없으면 (T가 NULL이거나 우선순위가 낮거나
+   인터럽트 핸들러 안이면) 평소처럼 더 높은 우선순위에게만 양보한다. 인터럽트는
+   꺼져 있어야 하고, T는 그 동안 없어지지 않아야 한다. */
+static void
+handoff (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t == NULL || intr_context () || !thread_yield_to (t))
+		test_max_priority ();
+}
+
 static void sema_test_helper (void *sema_);
 
 /* Self-test for semaphores that makes control "ping-pong"
@@ -182,45 +286,133 @@ sema_test_helper (void *sema_) {
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
+#ifndef LOCKSTAT
 void
 lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	heap_init (&lock->donors, donor_less, NULL);
+	lock->handoff = NULL;
 }
+#else
+/* 통계를 모으는 lock_class들. lock_init()이 처음 부른 순서의 역순이다. */
+static struct lock_class *lock_classes;
 
-/* Acquires LOCK, sleeping until it becomes available if
-   necessary.  The lock must not already be held by the current
-   thread.
+/* lock_init()과 같지만 LOCK의 통계를 CLASS에 모은다. CLASS가 NULL이면 세지 않는다. */
+void
+lock_init_class (struct lock *lock, struct lock_class *class) {
+	ASSERT (lock != NULL);
 
-   This function may sleep, so it must not be called within an
-   interrupt handler.  This function may be called with
-   interrupts disabled, but interrupts will be turned back on if
-   we need to sleep. */
-/* 현재 스레드의 우선순위를 기부, lock과 연결된 모든 스레드를 순회하며 priority를 기부한다. */
+	lock->holder = NULL;
+	sema_init (&lock->semaphore, 1);
+	heap_init (&lock->donors, donor_less, NULL);
+	lock->handoff = NULL;
+	lock->class = class;
+	lock->taken_tsc = 0;
+	if (class != NULL && !class->registered) {
+		enum intr_level old_level = intr_disable ();
+		if (!class->registered) {
+			class->registered = true;
+			class->next = lock_classes;
+			lock_classes = class;
+		}
+		intr_set_level (old_level);
+	}
+}
+
+/* 이름을 괄호로 감싸 lock_init() 매크로를 피한다. 위치를 모르는 lock은 세지 않는다. */
 void
-donate_priority(void){
-   struct thread *t = thread_current();
-   int depth = 0;
-   while(t->wait_on_lock != NULL && depth <= 7){      // 해당 lock을 대기하고 있는 스레드 && 최대 깊이 8 설정
-      depth++;
-      struct thread *tmp = t->wait_on_lock->holder;
-      tmp->priority = t->priority;               // holder의 우선순위를 현재 스레드의 우선순위로 바꿈
-      t = tmp;
-   }
+(lock_init) (struct lock *lock) {
+	lock_init_class (lock, NULL);
 }
-/* lock을 해지했을 때, donation_list에서 해당 스레드(donation_elem)를 제거 */
+
+/* 기다린 시간이 긴 순서로 lock_class들의 통계를 출력한다. */
 void
-remove_with_lock(struct lock *lock){
-   struct thread *p1 = thread_current();
-   // p1->list_donation
-   struct list_elem *liem;
-   // list_donation을 탐색해서 wait_on_lock(기다리고 있는 lock)과 lock(인자로 들어옴)이 같으면, 리스트에서 elem 제거
-   for(liem = list_begin(&p1->list_donation); liem != list_end(&p1->list_donation); liem = list_next(liem)){
-      if(list_entry(liem, struct thread, donation_elem)->wait_on_lock == lock){
-         list_remove(liem);
-      }
+lockstat_print (void) {
+	enum intr_level old_level = intr_disable ();
+	struct lock_class *sorted = NULL, *c, *next, **p;
+
+	/* 몇십 개뿐이므로 삽입 정렬로 충분하다. */
+	for (c = lock_classes; c != NULL; c = next) {
+		next = c->next;
+		for (p = &sorted; *p != NULL && (*p)->wait_cycles >= c->wait_cycles;
+				p = &(*p)->next)
+			continue;
+		c->next = *p;
+		*p = c;
+	}
+	lock_classes = sorted;
+
+	printf ("Lock contention:\n");
+	for (c = lock_classes; c != NULL; c = c->next) {
+		if (c->acquire_cnt == 0)
+			continue;
+		printf ("  %s: %llu acquires, %llu contended, %llu wait cycles, "
+				"%llu avg hold, %llu max hold\n", c->name,
+				(unsigned long long) c->acquire_cnt,
+				(unsigned long long) c->contend_cnt,
+				(unsigned long long) c->wait_cycles,
+				(unsigned long long) (c->hold_cycles / c->acquire_cnt),
+				(unsigned long long) c->hold_max);
+	}
+	intr_set_level (old_level);
+}
+#endif
+
+/* LOCK을 기다리는 donor들 중 가장 높은 우선순위. donor가 없으면 PRI_MIN - 1. */
+static int
+lock_donor_priority (const struct lock *lock) {
+	struct lock *l = (struct lock *) lock;
+	if (heap_empty (&l->donors))
+		return PRI_MIN - 1;
+	return heap_entry (heap_top (&l->donors), struct thread, donor_elem)->priority;
+}
+
+/* held_locks 힙의 비교 함수. donor의 우선순위가 가장 높은 lock이 top에 온다. */
+bool
+cmp_lock_priority (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return lock_donor_priority (heap_entry (a, struct lock, elem))
+		> lock_donor_priority (heap_entry (b, struct lock, elem));
+}
+
+/* T가 가진 lock들의 donor까지 고려한 T의 우선순위. held_locks 힙의 top만 보면 된다. */
+static int
+effective_priority (struct thread *t) {
+	int priority = t->init_priority;
+	if (!heap_empty (&t->held_locks)) {
+		int donated = lock_donor_priority (
+				heap_entry (heap_top (&t->held_locks), struct lock, elem));
+		if (donated > priority)
+			priority = donated;
+	}
+	return priority;
+}
+
+/* 현재 스레드의 우선순위를 기부, wait_on_lock을 따라가며 holder들의 우선순위를 갱신한다.
+   holder의 우선순위가 더 이상 바뀌지 않으면 그 뒤로는 바뀔 것이 없으므로 멈춘다.
+   인터럽트는 꺼져 있어야 한다. */
+void
+donate_priority(void){
+   struct thread *t = thread_current();
+   int depth;
+
+   ASSERT (intr_get_level () == INTR_OFF);
+
+   for (depth = 0; depth < DONATION_DEPTH_MAX && t->wait_on_lock != NULL; depth++) {
+      struct lock *lock = t->wait_on_lock;
+      struct thread *holder = lock->holder;
+      int priority;
+
+      if (holder == NULL)
+         break;
+      priority = effective_priority(holder);
+      if (priority == holder->priority)
+         break;
+      thread_update_priority(holder, priority);  // holder의 우선순위를 바꿈 (ready 상태면 큐도, 대기 중이면 waiters/donors 힙도 옮김)
+      t = holder;
    }
 }
 
@@ -228,34 +420,87 @@ remove_with_lock(struct lock *lock){
 void
 refresh_priority(void){
    struct thread *p1 = thread_current();
-   p1->priority = p1->init_priority;      // 현재 스레드의 우선순위를 원래 우선순위로 변경
+   thread_update_priority(p1, effective_priority(p1));  // cond waiters 힙에 들어있을 수 있으므로 재배치까지 맡긴다.
+}
 
-   if(!list_empty(&p1->list_donation)){   // 현재 스레드의 donation list에서 가장 높은 우선순위와 비교
-      int new_priority = list_entry(list_begin(&p1->list_donation), struct thread, donation_elem)->priority;
-      if (p1->priority < new_priority) {
-         p1->priority = new_priority;
-      }
-   }
+/* 현재 스레드가 LOCK을 얻었다. LOCK을 held_locks에 넣어, 남은 donor들이 이제 현재 스레드에게 기부하도록 한다. */
+static void
+lock_take (struct lock *lock) {
+   struct thread *p1 = thread_current();
+   enum intr_level old_level = intr_disable();
+
+   lock->holder = p1;
+   heap_push(&p1->held_locks, &lock->elem);
+#ifdef LOCKSTAT
+   lock->taken_tsc = rdtsc ();
+   if (lock->class != NULL)
+      lock->class->acquire_cnt++;
+#endif
+   if (!thread_mlfqs && !heap_empty(&lock->donors))
+      thread_update_priority(p1, effective_priority(p1));
+   intr_set_level(old_level);
 }
 
 void
 lock_acquire (struct lock *lock) {
+   lock_acquire_timeout (lock, -1);
+}
+
+/*** GrilledSalmon ***/
+/* lock_acquire()와 같지만 TICKS tick 안에 얻지 못하면 포기하고 false를
+   리턴한다. TICKS가 음수면 얻을 때까지 기다린다. 포기할 때는 holder에게 한
+   기부를 거두고 holder의 우선순위를 다시 계산한다. */
+bool
+lock_acquire_timeout (struct lock *lock, int64_t ticks) {
    ASSERT (lock != NULL);
    ASSERT (!intr_context ());
    ASSERT (!lock_held_by_current_thread (lock));
 
    struct thread *p1 = thread_current();
+   bool success = true;
+#ifdef LOCKSTAT
+   /* 인터럽트를 끄지 않고 보므로 경계에서 한두 번 틀릴 수 있지만 통계에는 상관없다. */
+   bool contended = lock->semaphore.value == 0;
+   uint64_t wait_start = rdtsc ();
+#endif
 
    if (!thread_mlfqs) {
+      enum intr_level old_level = intr_disable();
       if(lock->holder != NULL) {      /* lock->holder가 존재할 경우 */
          p1->wait_on_lock = lock;   // 현재 lock을 요청하는 current thread의 wait on lock 에 lock 주소필드를 저장해준다.
+         p1->wait_seq = next_wait_seq++;
+         heap_push(&lock->donors, &p1->donor_elem); // lock의 donors 힙에 현재 스레드를 넣는다.
+         heap_decrease(&lock->holder->held_locks, &lock->elem);  // lock의 donor 최댓값이 커졌을 수 있으므로 위로 올린다
          donate_priority();         // 현재 스레드의 우선순위 기부 -> 우선순위 역전 방지
-         list_insert_ordered(&lock->holder->list_donation, &p1->donation_elem,cmp_priority, NULL); // holder의 list_donation에 현재 스레드 정보(elem)를 우선순위 높은순으로 저장
       }
+      intr_set_level(old_level);
+   }
+   if (ticks < 0)
+      sema_down (&lock->semaphore);
+   else
+      success = sema_down_timeout (&lock->semaphore, ticks);
+   if (p1->wait_on_lock != NULL) {
+      enum intr_level old_level = intr_disable();
+      heap_remove(&lock->donors, &p1->donor_elem);  // lock을 얻었으므로 더 이상 donor가 아니다.
+      p1->wait_on_lock = NULL;      // sema_down에서 요청했던 lock을 얻었으므로, 초기화
+      if (!success && lock->holder != NULL) {
+         /* 기부를 거둔다. holder가 더 위로 전한 기부는 그 lock들이 풀릴 때 정리된다. */
+         heap_update(&lock->holder->held_locks, &lock->elem);
+         thread_update_priority(lock->holder, effective_priority(lock->holder));
+      }
+      intr_set_level(old_level);
+   }
+#ifdef LOCKSTAT
+   if (contended && lock->class != NULL) {
+      enum intr_level old_level = intr_disable();
+      lock->class->contend_cnt++;
+      lock->class->wait_cycles += rdtsc () - wait_start;
+      intr_set_level(old_level);
    }
-   sema_down (&lock->semaphore);
-   lock->holder = thread_current ();
-   p1->wait_on_lock = NULL;      // sema_down에서 요청했던 lock을 얻었으므로, 초기화
+#endif
+   if (success)
+      lock_take (lock);
+   return success;
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -273,7 +518,7 @@ lock_try_acquire (struct lock *lock) {
 
 	success = sema_try_down (&lock->semaphore);
 	if (success)
-		lock->holder = thread_current ();
+		lock_take (lock);
 	return success;
 }
 
@@ -288,14 +533,32 @@ lock_release (struct lock *lock) {
    ASSERT (lock != NULL);
    ASSERT (lock_held_by_current_thread (lock));
 
-   if (!thread_mlfqs) {
-      /* priority-donation 관련 */
-      remove_with_lock(lock); // list_donation에서 스레드(elem) 제거
-      refresh_priority();    //-> 빌렸던 내 원래의 우선순의를 원복한다.
-   }
-   
+   enum intr_level old_level = intr_disable();
+   /* priority-donation 관련: 이 lock의 donor들은 lock과 함께 held_locks에서 한 번에 빠진다. */
+   heap_remove(&thread_current()->held_locks, &lock->elem);
    lock->holder = NULL;
-   sema_up (&lock->semaphore);
+#ifdef LOCKSTAT
+   if (lock->class != NULL) {
+      uint64_t held = rdtsc () - lock->taken_tsc;
+      lock->class->hold_cycles += held;
+      if (held > lock->class->hold_max)
+         lock->class->hold_max = held;
+   }
+#endif
+   if (!thread_mlfqs)
+      refresh_priority();    //-> 빌렸던 내 원래의 우선순의를 원복한다.
+
+   /* cond_signal_handoff()가 정해 둔 스레드가 있으면 그쪽으로 넘어간다. 그
+      스레드는 이 lock을 다시 잡아야 cond_wait()에서 돌아가므로 지금까지
+      살아 있고, 인터럽트를 켜기 전에 넘어가므로 그 사이에 끝날 수도 없다. */
+   struct thread *next = lock->handoff;
+   lock->handoff = NULL;
+   sema_wake (&lock->semaphore);
+   if (next != NULL)
+      handoff (next);
+   else
+      test_max_priority ();
+   intr_set_level(old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -310,10 +573,52 @@ lock_held_by_current_thread (const struct lock *lock) {
 
 /* One semaphore in a list. */
 struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
+	struct heap_elem elem;              /* Heap element. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* 이 세마포어에서 기다리는 스레드 */
 };
 
+/* condition waiters 힙의 비교 함수. 각 semaphore_elem을 기다리는 스레드의 우선순위로 비교한다. */
+static bool
+cond_waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return waiter_first (heap_entry (a, struct semaphore_elem, elem)->thread,
+			heap_entry (b, struct semaphore_elem, elem)->thread);
+}
+
+/* T의 우선순위가 바뀌었을 때, T가 기다리고 있는 세마포어와 condition의
+   waiters 힙, 그리고 lock의 donors 힙에서 T의 위치를 다시 잡는다.
+   인터럽트는 꺼져 있어야 한다. */
+void
+synch_update_waiter (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->wait_on_sema != NULL)
+		heap_update (&t->wait_on_sema->waiters, &t->wait_elem);
+	if (t->wait_on_cond != NULL)
+		heap_update (&t->wait_on_cond->waiters, t->wait_cond_elem);
+	if (t->wait_on_lock != NULL) {
+		/* lock의 donor 최댓값이 바뀌었을 수 있으므로 holder의 held_locks도 재배치한다. */
+		struct lock *lock = t->wait_on_lock;
+		heap_update (&lock->donors, &t->donor_elem);
+		if (lock->holder != NULL)
+			heap_update (&lock->holder->held_locks, &lock->elem);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* thread_block_timeout()의 시간이 다 된 T를 기다리던 세마포어의 waiters에서
+   뺀다. 인터럽트는 꺼져 있어야 한다. */
+void
+synch_cancel_wait (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->wait_on_sema != NULL) {
+		heap_remove (&t->wait_on_sema->waiters, &t->wait_elem);
+		t->wait_on_sema = NULL;
+	}
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -321,7 +626,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -353,14 +658,66 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
 	sema_init (&waiter.semaphore, 0);				// semaphore_elem의 semaphore value를 0으로 초기화 시켜준다.
-	// condition의 waiter에서 semaphore_elem의 elem을 thread의 우선순위 기준으로 정렬하기 위함이다.
-	list_insert_ordered (&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+	waiter.thread = cur;
+	// condition의 waiters 힙에 현재 스레드의 우선순위 기준으로 넣는다.
+	// lock_release에서 우선순위가 바뀌어도 synch_update_waiter가 힙을 재배치한다.
+	old_level = intr_disable ();
+	cur->wait_seq = next_wait_seq++;
+	cur->wait_on_cond = cond;
+	cur->wait_cond_elem = &waiter.elem;
+	heap_push (&cond->waiters, &waiter.elem);
+	intr_set_level (old_level);
+
 	lock_release (lock);
-	sema_down (&waiter.semaphore);					// sema_down에서 sema가 0인 경우 thread elem과 sema의 waiters와 연결시켜주고 block 시켜준다.
+	sema_down (&waiter.semaphore);					// sema_down에서 sema가 0인 경우 thread를 sema의 waiters 힙에 넣고 block 시켜준다.
 	lock_acquire (lock);
 }
 
+/*** GrilledSalmon ***/
+/* cond_wait()과 같지만 TICKS tick 안에 signal을 받지 못하면 그만 기다린다.
+   어느 쪽이든 LOCK을 다시 잡은 뒤 리턴하고, signal을 받았으면 true. 시간이
+   다 된 뒤 다시 돌기 전에 온 signal도 받은 것으로 친다. */
+bool
+cond_wait_timeout (struct condition *cond, struct lock *lock, int64_t ticks) {
+	struct semaphore_elem waiter;
+	bool signaled;
+
+	ASSERT (cond != NULL);
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	sema_init (&waiter.semaphore, 0);
+	waiter.thread = cur;
+	old_level = intr_disable ();
+	cur->wait_seq = next_wait_seq++;
+	cur->wait_on_cond = cond;
+	cur->wait_cond_elem = &waiter.elem;
+	heap_push (&cond->waiters, &waiter.elem);
+	intr_set_level (old_level);
+
+	lock_release (lock);
+	sema_down_timeout (&waiter.semaphore, ticks);
+	/* cond_signal은 waiter를 힙에서 꺼내며 wait_on_cond를 지운다. 아직 힙에
+	   있으면 signal이 오지 않은 것이다. */
+	old_level = intr_disable ();
+	signaled = cur->wait_on_cond == NULL;
+	if (!signaled) {
+		heap_remove (&cond->waiters, &waiter.elem);
+		cur->wait_on_cond = NULL;
+	}
+	intr_set_level (old_level);
+	lock_acquire (lock);
+	return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -376,10 +733,37 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)){
-		list_sort(&cond->waiters, cmp_sem_priority, NULL);
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	if (!heap_empty (&cond->waiters)){
+		enum intr_level old_level = intr_disable ();
+		struct semaphore_elem *waiter =
+			heap_entry (heap_pop (&cond->waiters), struct semaphore_elem, elem);
+		waiter->thread->wait_on_cond = NULL;
+		intr_set_level (old_level);
+		sema_up (&waiter->semaphore);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* cond_signal()과 같지만 깨운 스레드를 LOCK의 handoff 대상으로 정해 둔다.
+   깨운 스레드는 LOCK을 다시 잡아야 하므로 지금 바로 넘어가면 곧 다시 잠들
+   뿐이다. 대신 lock_release(LOCK)가 LOCK을 놓으면서 그 스레드로 바로
+   전환한다 (우선순위가 현재 스레드 이상일 때). IPC처럼 한쪽이 signal 하고
+   다른 쪽이 곧바로 받아 가는 경우 왕복 지연이 time slice만큼 줄어든다. */
+void
+cond_signal_handoff (struct condition *cond, struct lock *lock) {
+	ASSERT (cond != NULL);
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	if (!heap_empty (&cond->waiters)){
+		enum intr_level old_level = intr_disable ();
+		struct semaphore_elem *waiter =
+			heap_entry (heap_pop (&cond->waiters), struct semaphore_elem, elem);
+		waiter->thread->wait_on_cond = NULL;
+		lock->handoff = waiter->thread;
+		sema_wake (&waiter->semaphore);
+		intr_set_level (old_level);
 	}
 }
 
@@ -394,15 +778,211 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
 
-// condition waiter의 thread 우선순위 값을 비교하기 위해 함수 선언하였다.
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux){
-	struct semaphore *wait1 = &(list_entry(a, struct semaphore_elem, elem)->semaphore);
-	struct semaphore *wait2 = &(list_entry(b, struct semaphore_elem, elem)->semaphore);
-	struct thread *t1 = list_entry(list_begin(&wait1->waiters),struct thread, elem);
-	struct thread *t2 = list_entry(list_begin(&wait2->waiters),struct thread, elem);
-	return t1->priority > t2->priority ? 1 : 0 ;
-}
\ No newline at end of file
+/* Initializes RW as an unheld reader-writer lock.  Any number of
+   readers may hold RW at the same time, but a writer holds it
+   exclusively.
+
+   If PREFER_WRITER is true, a writer waiting for the current
+   readers to leave keeps new readers out, so writers cannot be
+   starved.  Otherwise new readers are let in while a writer
+   waits.
+
+   Writers hold RW's internal lock for their whole critical
+   section, so threads blocked behind a writer donate their
+   priority to it.  Readers are not tracked individually and do
+   not receive donations. */
+void
+rwlock_init (struct rwlock *rw, bool prefer_writer) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	sema_init (&rw->drained, 0);
+	rw->readers = 0;
+	rw->drain_waiters = 0;
+	rw->prefer_writer = prefer_writer;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->lock);		// writer가 있다면 여기서 기다리며 writer에게 우선순위를 기부한다.
+	old_level = intr_disable ();
+	rw->readers++;
+	intr_set_level (old_level);
+	lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader to leave wakes up any writer waiting for the
+   readers to drain. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0)
+		for (; rw->drain_waiters > 0; rw->drain_waiters--)
+			sema_up (&rw->drained);
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it in either mode.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->lock);
+	old_level = intr_disable ();
+	while (rw->readers > 0) {
+		rw->drain_waiters++;
+		if (rw->prefer_writer)
+			sema_down (&rw->drained);	// lock을 쥔 채 기다리므로 새 reader는 들어오지 못한다.
+		else {
+			/* reader 우선: 기다리는 동안 새 reader가 들어올 수 있도록 lock을 놓는다. */
+			intr_set_level (old_level);
+			lock_release (&rw->lock);
+			sema_down (&rw->drained);
+			lock_acquire (&rw->lock);
+			old_level = intr_disable ();
+		}
+	}
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->lock);
+}
+
+/* Initializes SPIN as an unheld spinlock.
+
+   A spinlock is meant for critical sections that are only a few
+   dozen instructions long, such as allocator free lists.  It
+   never sleeps: acquiring it disables interrupts (restored on
+   release) and busy-waits if another CPU holds it, so it costs
+   no semaphore or scheduler work.  On the single CPU Pintos runs
+   on, disabling interrupts already excludes everyone else, so it
+   never actually spins in practice.  The holder must not sleep,
+   and a spinlock is not recursive.
+
+   contend_cnt counts acquisitions that found the lock busy. */
+void
+spinlock_init (struct spinlock *spin) {
+	ASSERT (spin != NULL);
+
+	spin->locked = false;
+	spin->old_level = INTR_OFF;
+	spin->acquire_cnt = 0;
+	spin->contend_cnt = 0;
+}
+
+/* Acquires SPIN, busy-waiting with interrupts disabled while it
+   is held.  May be called within an interrupt handler. */
+void
+spinlock_acquire (struct spinlock *spin) {
+	enum intr_level old_level;
+
+	ASSERT (spin != NULL);
+
+	old_level = intr_disable ();
+	if (__atomic_exchange_n (&spin->locked, true, __ATOMIC_ACQUIRE)) {
+		spin->contend_cnt++;
+		while (__atomic_exchange_n (&spin->locked, true, __ATOMIC_ACQUIRE))
+			asm volatile ("pause");
+	}
+	spin->old_level = old_level;
+	spin->acquire_cnt++;
+}
+
+/* Releases SPIN and restores the interrupt level from before
+   spinlock_acquire(). */
+void
+spinlock_release (struct spinlock *spin) {
+	enum intr_level old_level;
+
+	ASSERT (spin != NULL);
+	ASSERT (spin->locked);
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	old_level = spin->old_level;
+	__atomic_store_n (&spin->locked, false, __ATOMIC_RELEASE);
+	intr_set_level (old_level);
+}
+
+/*** GrilledSalmon ***/
+void
+wait_queue_init (struct wait_queue *wq) {
+	list_init (&wq->entries);
+}
+
+/* E를 WQ에 건다. WQ가 깨어나면 SEMA가 올라간다. */
+void
+wait_entry_add (struct wait_queue *wq, struct wait_entry *e,
+		struct semaphore *sema) {
+	enum intr_level old_level = intr_disable ();
+
+	e->wq = wq;
+	e->sema = sema;
+	list_push_back (&wq->entries, &e->elem);
+	intr_set_level (old_level);
+}
+
+/* wait_entry_add로 건 E를 뗀다. 걸려 있지 않으면 아무것도 하지 않는다. */
+void
+wait_entry_remove (struct wait_entry *e) {
+	enum intr_level old_level = intr_disable ();
+
+	if (e->wq != NULL) {
+		list_remove (&e->elem);
+		e->wq = NULL;
+	}
+	intr_set_level (old_level);
+}
+
+/* WQ에 걸린 entry마다 그 세마포어를 올린다. entry는 걸린 채로 둔다. 목록을 도는
+   동안 다른 스레드로 넘어가지 않도록 다 올린 다음에 양보한다. */
+void
+wait_queue_wake (struct wait_queue *wq) {
+	enum intr_level old_level = intr_disable ();
+	struct list_elem *e;
+
+	for (e = list_begin (&wq->entries); e != list_end (&wq->entries);
+			e = list_next (e))
+		sema_wake (list_entry (e, struct wait_entry, elem)->sema);
+	test_max_priority ();
+	intr_set_level (old_level);
+}
@@ -3,8 +3,15 @@ threads_SRC += threads/thread.c		# Thread management core.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
+threads_SRC += threads/workqueue.c	# Work queues and bottom halves.
+threads_SRC += threads/rcu.c		# Read-copy-update.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/slab.c		# Object caches.
+threads_SRC += threads/vmalloc.c	# Virtually contiguous allocations.
 threads_SRC += threads/start.S		# Startup code.
+threads_SRC += threads/fpu.c		# Lazy FPU/SSE switching.
+threads_SRC += threads/trace.c		# Trace ring buffer.
+threads_SRC += threads/profile.c	# Sampling profiler.
+threads_SRC += threads/bootsnap.c	# Boot snapshot.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
-threads_SRC += threads/fixed_point.c
\ No newline at end of file
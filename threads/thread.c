@@ -4,14 +4,21 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
+#include "threads/cpu.h"
 #include "threads/fixed_point.h" // project1_advanced_scheduler
+#include "threads/fpu.h"
+#include "threads/trace.h"
+#include "threads/rcu.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -25,46 +32,124 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* sleep 상태의 스레드들을 저장하기 위한 리스트 */
-static struct list sleep_list;
-
-/* Idle thread. */
-static struct thread *idle_thread;
+/*** GrilledSalmon ***/
+/* CPU별 데이터. List of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running, the idle
+   thread, and the statistics live here.  See threads/cpu.h. */
+struct cpu cpus[CPU_MAX];
+unsigned cpu_cnt = 1;           /* cpus[]에서 돌고 있는 CPU의 수. */
+
+/* sleep 상태의 스레드들을 저장하기 위한 계층형 타이머 휠.
+   [0, NEAR)           : near 휠. 슬롯 하나가 1 tick (wakeup_tick & NEAR_MASK).
+   [NEAR, NEAR + FAR)  : far 휠. 슬롯 하나가 NEAR tick.
+   [NEAR + FAR]        : NEAR * FAR tick 이상 남은 스레드들의 overflow 리스트.
+   wheel_now는 thread_awake()가 마지막으로 처리한 tick이다. */
+#define WHEEL_NEAR_BITS 8
+#define WHEEL_NEAR_SIZE (1 << WHEEL_NEAR_BITS)
+#define WHEEL_NEAR_MASK (WHEEL_NEAR_SIZE - 1)
+#define WHEEL_FAR_BITS 6
+#define WHEEL_FAR_SIZE (1 << WHEEL_FAR_BITS)
+#define WHEEL_FAR_MASK (WHEEL_FAR_SIZE - 1)
+#define WHEEL_OVERFLOW (WHEEL_NEAR_SIZE + WHEEL_FAR_SIZE)
+static struct list sleep_wheel[WHEEL_OVERFLOW + 1];
+static int64_t wheel_now;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
+/*** GrilledSalmon ***/
+/* 모든 스레드(idle 제외)의 스케줄링 통계와 run queue 길이 표본.
+   schedule()과 thread_tick()이 인터럽트가 꺼진 채로 더한다. */
+static struct schedstat sched_global;
+
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
 /* Thread destruction requests */
 static struct list destruction_req;
 
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/*** GrilledSalmon ***/
+/* 최근에 죽은 스레드의 page. fork와 exit가 몰릴 때 palloc을 거치지 않고
+   바로 다시 쓴다. 다시 쓸 때 struct thread 부분만 init_thread가 지운다.
+   do_schedule이 인터럽트가 꺼진 채로 넣으므로 인터럽트를 끄고 고친다. */
+#define THREAD_CACHE_MAX 16
+static struct thread *thread_cache[THREAD_CACHE_MAX];
+static int thread_cache_cnt;
+static long long thread_cache_hits, thread_cache_misses;
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;	/* 1: mlfqs, 0: rr*/
 
+/*** GrilledSalmon ***/
+/* -cfs: 우선순위 대신 vruntime으로 고른다. 돌고 있는 스레드는 tick마다
+   CFS_TICK * NICE_0_WEIGHT / weight 만큼 vruntime이 늘고, run queue는 vruntime이
+   가장 작은 스레드를 먼저 내놓는 힙이라 넣고 빼는 데 O(log n)이다. weight가
+   크면 vruntime이 천천히 늘어 그만큼 자주 뽑히므로, CPU 시간은 weight에
+   비례해 나뉜다. weight는 nice가 1 오를 때마다 약 1.25배씩 준다.
+
+   priority와 donation은 그대로 두어 세마포어와 lock의 waiters 순서에만 쓰인다. */
+bool thread_cfs;
+
+#define NICE_0_WEIGHT 1024
+#define CFS_TICK ((uint64_t) 1 << 20)   /* nice 0 스레드가 한 tick에 쌓는 vruntime. */
+/* 돌고 있는 스레드는 가장 작은 vruntime보다 이만큼 앞서야 뺏긴다. 깨어난
+   스레드는 min_vruntime보다 이만큼까지 뒤에서 시작한다. */
+#define CFS_GRAN (CFS_TICK * TIME_SLICE / 2)
+
+/* nice -20..20의 weight. */
+static const unsigned cfs_weights[NICE_MAX - NICE_MIN + 1] = {
+	88761, 71755, 56483, 46273, 36291,
+	29154, 23254, 18705, 14949, 11916,
+	9548, 7620, 6100, 4904, 3906,
+	3121, 2501, 1991, 1586, 1277,
+	1024, 820, 655, 526, 423,
+	335, 272, 215, 172, 137,
+	110, 87, 70, 56, 45,
+	36, 29, 23, 18, 15,
+	12,
+};
+
+/*** GrilledSalmon ***/
+/* EDF class. thread_set_edf()로 (runtime, period, deadline)을 예약한 스레드는
+   우선순위와 상관없이 다른 스레드보다 먼저 돌고, 그중에서는 이번 period의
+   deadline이 가장 이른 스레드가 돈다. donation으로 우선순위가 흔들려도 예약한
+   만큼은 deadline 안에 돈다.
+
+   예약을 받을 때 모든 EDF 스레드의 runtime/period 합이 CPU의 EDF_BW_MAX를
+   넘지 않게 한다. 그러면 deadline == period일 때 모든 deadline이 지켜지고,
+   나머지 CPU 시간은 보통 스레드에게 남는다. thread_tick()이 돌고 있는 EDF
+   스레드의 budget을 깎고, 다 쓰면 다음 period까지 edf_throttled에 둔다. */
+#define EDF_BW_SHIFT 20
+#define EDF_BW_MAX (((uint64_t) 1 << EDF_BW_SHIFT) * 95 / 100)
+
+static uint64_t edf_bw_total;   /* EDF 스레드들의 bw 합. 인터럽트를 끄고 고친다. */
+
 /* project1_advanced_scheduler */
 #define NICE_DEFAULT 0
 #define RECENT_CPU_DEFAULT 0
 #define LOAD_AVG_DEFAULT 0
 int load_avg;
 
-static int64_t	next_tick_to_awake;
+/* mlfqs_recalc()가 호출된(1초가 지난) 횟수.
+   blocked 스레드는 recent_cpu_epoch와 비교해 밀린 만큼만 나중에 한 번에 감쇠시킨다. */
+static int64_t mlfqs_epoch;
+
+/* recent_cpu 감쇠 계수 2*load_avg / (2*load_avg + 1). load_avg가 바뀔 때만 다시 계산한다. */
+static int recent_cpu_coef;
+
+/* 모든 스레드를 연결하는 리스트. 스레드가 처음 만들어질 때 추가되고 종료될 때 제거된다. */
+static struct list all_list;
+
+/*** GrilledSalmon ***/
+/* tid로 struct child를 찾는 table. tid는 차례로 늘어나므로 나머지로 bucket을
+   고른다. all_list처럼 인터럽트를 끄고 고친다. */
+#define PID_BUCKETS 64
+static struct list pid_table[PID_BUCKETS];
 
 
 static void kernel_thread (thread_func *, void *aux);
@@ -73,8 +158,28 @@ static void idle (void *aux UNUSED);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
+static struct thread *thread_page_get (void);
+static void thread_page_put (struct thread *);
 static void schedule (void);
+static void thread_print_schedstat (void);
+static void schedstat_switch (struct thread *curr, struct thread *next);
 static tid_t allocate_tid (void);
+static void ready_push (struct thread *t);
+static struct thread *ready_pop (struct cpu *c);
+static struct thread *ready_steal (struct cpu *c);
+static void ready_remove (struct thread *t);
+static int ready_max_priority (struct cpu *c);
+static struct cpu *cpu_least_loaded (void);
+static int mlfqs_calc_priority (struct thread *t);
+static bool cfs_less (const struct heap_elem *, const struct heap_elem *, void *);
+static bool cfs_tick (struct cpu *c, struct thread *t);
+static bool cfs_should_preempt (struct cpu *c);
+static bool edf_deadline_less (const struct heap_elem *, const struct heap_elem *, void *);
+static bool edf_release_less (const struct heap_elem *, const struct heap_elem *, void *);
+static struct thread *edf_pop (struct cpu *c);
+static bool edf_tick (struct cpu *c, struct thread *t);
+static bool edf_should_preempt (struct cpu *c);
+static void mlfqs_catch_up (struct thread *t);
 void test_max_priority(void);
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
@@ -122,25 +227,62 @@ thread_init (void) {
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&this_cpu ()->ready_queues[pri]);
+	this_cpu ()->ready_mask = 0;
+	heap_init (&this_cpu ()->cfs_queue, cfs_less, NULL);
+	heap_init (&this_cpu ()->edf_queue, edf_deadline_less, NULL);
+	heap_init (&this_cpu ()->edf_throttled, edf_release_less, NULL);
+	this_cpu ()->edf_cnt = 0;
+	this_cpu ()->min_vruntime = 0;
+	this_cpu ()->ready_cnt = 0;
+	this_cpu ()->id = 0;
 	list_init (&destruction_req);
-	list_init (&sleep_list);	// sleep 스레드들을 연결해놓은 리스트를 초기화 한다.
+	list_init (&all_list);
+	for (int i = 0; i < PID_BUCKETS; i++)
+		list_init (&pid_table[i]);
+	for (int i = 0; i <= WHEEL_OVERFLOW; i++)	// sleep 스레드들을 연결해놓은 타이머 휠을 초기화 한다.
+		list_init (&sleep_wheel[i]);
+	wheel_now = 0;
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid ();
+	this_cpu ()->thread = initial_thread;
 }
 
-// readylist에서 가장 먼저 나올 스레드의 틱 값을 업데이트 시켜주기 위한 함수이다.
-void update_next_tick_to_awake(int64_t ticks){
-	// thread_sleep에서 호출된 함수로, tick으로 받아온 변수의 값이 이전 next_tick보다 작으면 그 tick값을 next_tick값으로 바꿔주고 원래의 값이 더 작다면 기존 값을 유지한다.
-	next_tick_to_awake = (next_tick_to_awake>ticks) ? ticks : next_tick_to_awake;
+/* T를 wakeup_tick에 맞는 타이머 휠 슬롯에 넣는다. 인터럽트는 꺼져 있어야 한다.
+   이미 지난 tick이면 다음 tick에 깨어나도록 wheel_now + 1로 올려준다. */
+static void
+sleep_insert (struct thread *t) {
+	int64_t expire = t->wakeup_tick > wheel_now ? t->wakeup_tick : wheel_now + 1;
+	int64_t delta = expire - wheel_now;
+	struct list *slot;
+
+	ASSERT (intr_get_level () == INTR_OFF);
 
+	if (delta < WHEEL_NEAR_SIZE)
+		slot = &sleep_wheel[expire & WHEEL_NEAR_MASK];
+	else if (delta < WHEEL_NEAR_SIZE * WHEEL_FAR_SIZE)
+		slot = &sleep_wheel[WHEEL_NEAR_SIZE
+			+ ((expire >> WHEEL_NEAR_BITS) & WHEEL_FAR_MASK)];
+	else
+		slot = &sleep_wheel[WHEEL_OVERFLOW];
+	list_push_back (slot, &t->elem);
+	t->in_wheel = true;
 }
 
-int64_t get_next_tick_to_awake(void){
-	return next_tick_to_awake;
+/* SLOT에 있는 스레드들을 다시 sleep_insert 한다. (상위 단계 -> 하위 단계로 내려보냄) */
+static void
+sleep_cascade (struct list *slot) {
+	struct list pending;
+
+	list_init (&pending);
+	while (!list_empty (slot))
+		list_push_back (&pending, list_pop_front (slot));
+	while (!list_empty (&pending))
+		sleep_insert (list_entry (list_pop_front (&pending), struct thread, elem));
 }
 
 // timer sleep에서 인자로 받은 (start + ticks) 으로 sleep을 실행한다.
@@ -152,12 +294,10 @@ void thread_sleep(int64_t ticks){
 	ASSERT(!intr_context());
 	old_level = intr_disable();
 
-	ASSERT(cur != idle_thread);
-
+	ASSERT(cur != this_cpu ()->idle_thread);
 
 	cur->wakeup_tick = ticks;	// 현재 running중인 쓰레드의 wakeup 틱을 timer sleep값으로 업데이트 시켜놓고,
-	update_next_tick_to_awake(cur->wakeup_tick);	// next_tick_to_awake을 업데이트 시켜준다.
-	list_push_back(&sleep_list, &cur->elem);	// sleep_list에 추가
+	sleep_insert(cur);		// 타이머 휠에 추가 (O(1))
 
 	// 스레드를 sleep 시킨다.
 	thread_block();
@@ -166,30 +306,73 @@ void thread_sleep(int64_t ticks){
 	intr_set_level(old_level);
 }
 
-// awake는 timet interrupt가 발생할 때마다 tick과 next tick to awake와 비교하여 실행한다.
+/*** GrilledSalmon ***/
+/* thread_block()과 같지만 TICKS tick이 되면 타이머 휠이 깨운다. 그 전에
+   누가 thread_unblock() 하면 휠에서 빠진다. 세마포어에서 기다리던 중에 시간이
+   다 되면 thread_awake()가 그 세마포어의 waiters에서도 뺀다. 어느 쪽으로
+   깨어났는지는 부른 쪽이 자기 조건을 다시 보고 판단한다. 인터럽트는 꺼져 있어야
+   한다. */
+void
+thread_block_timeout (int64_t ticks) {
+	struct thread *cur = thread_current ();
+
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (cur != this_cpu ()->idle_thread);
+
+	cur->wakeup_tick = ticks;
+	sleep_insert (cur);
+	thread_block ();
+}
+
+// awake는 timer interrupt가 발생할 때마다 호출되어 wheel_now를 TICKS까지 한 칸씩 전진시킨다.
+// 각 tick마다 해당 near 슬롯에 있는 스레드만 깨우므로, 비용은 깨어나는 스레드 수에 비례한다.
 void thread_awake(int64_t ticks){
-	// sleeplist의 head를 가져온다
-	struct list_elem* cur = list_begin(&sleep_list);
-	struct thread* t;
-	next_tick_to_awake = INT64_MAX;
-
-	// sleep list의 끝까지 순회한다.
-	while(cur != list_end(&sleep_list)){
-		// list_entry 해당 구조체의 시작 주소
-		t = list_entry(cur, struct thread, elem);
-		// 리스트 안에 구조체의 깨울 시간이 지났다면,
-		if(ticks >= t->wakeup_tick){
-			cur = list_remove(&t->elem);
-			thread_unblock(t);
+	while (wheel_now < ticks) {
+		wheel_now++;
+
+		/* near 휠이 한 바퀴 돌 때마다 far 슬롯 하나를, far 휠이 한 바퀴 돌 때마다
+		   overflow 리스트를 아래 단계로 내려보낸다. */
+		if ((wheel_now & WHEEL_NEAR_MASK) == 0) {
+			if (((wheel_now >> WHEEL_NEAR_BITS) & WHEEL_FAR_MASK) == 0)
+				sleep_cascade (&sleep_wheel[WHEEL_OVERFLOW]);
+			sleep_cascade (&sleep_wheel[WHEEL_NEAR_SIZE
+					+ ((wheel_now >> WHEEL_NEAR_BITS) & WHEEL_FAR_MASK)]);
 		}
-		else{
-			cur = list_next(cur);
-			update_next_tick_to_awake(t->wakeup_tick);
+
+		/* near 슬롯에는 wakeup_tick == wheel_now인 스레드만 들어있다. */
+		struct list *slot = &sleep_wheel[wheel_now & WHEEL_NEAR_MASK];
+		while (!list_empty (slot)) {
+			struct thread *t = list_entry (list_pop_front (slot), struct thread, elem);
+			ASSERT (t->wakeup_tick <= wheel_now);
+			t->in_wheel = false;
+			/* thread_block_timeout()으로 세마포어를 기다리던 스레드는 waiters에서 뺀다. */
+			synch_cancel_wait (t);
+			thread_unblock (t);
 		}
-		// next_tick이 바뀌었을 수 있으므로 업데이트
 	}
 }
 
+/*** GrilledSalmon ***/
+/* 다음 tick부터 세어 타이머 휠에 할 일이 있는 첫 tick까지의 tick 수를 LIMIT
+   이하로 리턴한다. 깨울 스레드가 있는 near 슬롯과, far 휠을 내려보내야 하는 near
+   휠의 한 바퀴 끝이 할 일이다. idle이 그때까지 timer 인터럽트 없이 잔다.
+   인터럽트는 꺼져 있어야 한다. */
+int64_t
+thread_next_wakeup (int64_t limit) {
+	int64_t n;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	for (n = 1; n < limit; n++) {
+		int64_t tick = wheel_now + n;
+
+		if ((tick & WHEEL_NEAR_MASK) == 0
+				|| !list_empty (&sleep_wheel[tick & WHEEL_NEAR_MASK]))
+			break;
+	}
+	return n;
+}
+
 /* Starts preemptive thread scheduling by enabling interrupts.
    Also creates the idle thread. */
 // Idle 스레드를 만들고, 선점 스레드 스케쥴링을 시작한다.
@@ -217,27 +400,138 @@ thread_start (void) {
 void
 thread_tick (void) {
 	struct thread *t = thread_current ();
+	struct cpu *c = this_cpu ();
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
-
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)	// thread_ticks는 맨처음 schedule()에서 0으로 만들어준다.
+		c->kernel_ticks++;
+	sched_global.rq_samples++;
+	sched_global.rq_len_sum += c->ready_cnt;
+	if (c->ready_cnt > sched_global.rq_len_max)
+		sched_global.rq_len_max = c->ready_cnt;
+
+	/* Enforce preemption.  EDF 스레드는 budget을 다 썼거나 deadline이 더 이른
+	   스레드가 왔을 때만 뺏긴다. */
+	if (edf_tick (c, t))
+		intr_yield_on_return ();
+	else if (t->edf.runtime != 0)
+		c->thread_ticks++;
+	else if (thread_cfs) {
+		c->thread_ticks++;
+		if (cfs_tick (c, t))
+			intr_yield_on_return ();
+	} else if (++c->thread_ticks >= TIME_SLICE)	// thread_ticks는 맨처음 schedule()에서 0으로 만들어준다.
 		intr_yield_on_return ();
 }
 
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+
+	for (unsigned i = 0; i < CPU_MAX; i++) {
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+	printf ("Thread: %lld page cache hits, %lld misses\n",
+			thread_cache_hits, thread_cache_misses);
+	thread_print_schedstat ();
+}
+
+/* 스케줄러 통계를 출력한다. 평균은 소수점 아래 두 자리까지. */
+static void
+thread_print_schedstat (void) {
+	struct schedstat st;
+	long long avg_rq;
+	int b;
+
+	thread_get_schedstat (&st, false);
+	avg_rq = st.rq_samples > 0 ? st.rq_len_sum * 100 / st.rq_samples : 0;
+	printf ("Scheduler: %ld voluntary, %ld involuntary switches, "
+			"%lld.%02lld avg run queue (max %ld)\n", st.nvcsw, st.nivcsw,
+			avg_rq / 100, avg_rq % 100, st.rq_len_max);
+	printf ("Scheduler: %ld wakeups, %lld avg, %lld max wakeup cycles, "
+			"%lld ready cycles, log2 wakeup cycles", st.wakeups,
+			st.wakeups > 0 ? st.wakeup_cycles / st.wakeups : 0, st.wakeup_max,
+			st.ready_cycles);
+	for (b = 0; b < SCHEDSTAT_BUCKETS; b++)
+		if (st.latency[b] != 0)
+			printf (" %d:%ld", b, st.latency[b]);
+	printf ("\n");
+}
+
+/* SELF이면 지금 스레드의, 아니면 전체 스케줄링 통계를 ST에 담는다. */
+void
+thread_get_schedstat (struct schedstat *st, bool self) {
+	enum intr_level old_level = intr_disable ();
+
+	if (self) {
+		const struct thread_schedstat *s = &thread_current ()->sched;
+
+		memset (st, 0, sizeof *st);
+		st->nvcsw = s->nvcsw;
+		st->nivcsw = s->nivcsw;
+		st->wakeups = s->wakeups;
+		st->wakeup_cycles = s->wakeup_cycles;
+		st->wakeup_max = s->wakeup_max;
+		st->ready_cycles = s->ready_cycles;
+	} else
+		*st = sched_global;
+	intr_set_level (old_level);
+}
+
+/* CURR에서 NEXT로 넘어간다. CURR가 CPU를 내놓은 이유와 NEXT가 ready 큐에서
+   기다린 시간을 센다. 인터럽트는 꺼져 있어야 한다. */
+static void
+schedstat_switch (struct thread *curr, struct thread *next) {
+	struct thread *idle = this_cpu ()->idle_thread;
+	uint64_t now, waited;
+
+	if (curr != next && curr != idle) {
+		if (curr->status == THREAD_BLOCKED) {
+			curr->sched.nvcsw++;
+			sched_global.nvcsw++;
+		} else if (curr->status == THREAD_READY) {
+			curr->sched.nivcsw++;
+			sched_global.nivcsw++;
+		}
+	}
+	if (next == idle || next->ready_tsc == 0)
+		return;
+
+	now = rdtsc ();
+	waited = now - next->ready_tsc;
+	next->ready_tsc = 0;
+	next->sched.ready_cycles += waited;
+	sched_global.ready_cycles += waited;
+	if (next->woken) {
+		uint64_t c = waited;
+		int bucket = 0;
+
+		next->woken = false;
+		next->sched.wakeups++;
+		next->sched.wakeup_cycles += waited;
+		if (waited > next->sched.wakeup_max)
+			next->sched.wakeup_max = waited;
+		sched_global.wakeups++;
+		sched_global.wakeup_cycles += waited;
+		if ((long long) waited > sched_global.wakeup_max)
+			sched_global.wakeup_max = waited;
+		while (c > 1 && bucket < SCHEDSTAT_BUCKETS - 1) {
+			c >>= 1;
+			bucket++;
+		}
+		sched_global.latency[bucket]++;
+	}
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -260,30 +554,50 @@ tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
 	struct thread *t;
+	struct child *c;
 	tid_t tid;
 
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_page_get ();
 	if (t == NULL)
 		return TID_ERROR;
+	c = malloc (sizeof *c);
+	if (c == NULL) {
+		thread_page_put (t);
+		return TID_ERROR;
+	}
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
-	/* 현재 스레드의 자식 리스트에 새로 생성한 스레드 추가 */
-    struct thread *curr = thread_current();
-    list_push_back(&curr->child_list,&t->child_elem);
+	/* 부모와 나눌 기록을 현재 프로세스 leader의 자식 리스트와 pid table에 추가.
+	   끝나는 자식이 부모의 리스트를 고치므로 인터럽트를 끈다. */
+    struct thread *curr = thread_current()->leader;
+    c->tid = tid;
+    c->thread = t;
+    c->parent = curr;
+    c->ref_cnt = 2;
+    c->exit_status = 0;
+    c->load_failed = false;
+    c->uthread = false;
+    sema_init (&c->loaded, 0);
+    sema_init (&c->exited, 0);
+    t->child = c;
+    enum intr_level old_level = intr_disable ();
+    list_push_back (&curr->child_list, &c->elem);
+    list_push_back (&pid_table[tid % PID_BUCKETS], &c->pid_elem);
+    intr_set_level (old_level);
 
     /* 파일 디스크립터 초기화 */
-    t->fdTable = palloc_get_multiple(PAL_ZERO,FDT_PAGES);
-    if(t->fdTable == NULL)
-        return TID_ERROR;
-    t->fdIdx = 2;
+    t->fdTable = t->fdInline;
+    t->fdMap = &t->fdInlineMap;
+    t->fdCap = FDT_INLINE;
     t->fdTable[0] = 1;
     t->fdTable[1] = 2;
+    t->fdInlineMap = 0x3;
 
     t->stdin_count = 1;
     t->stdout_count = 1;
@@ -301,6 +615,8 @@ thread_create (const char *name, int priority,
 
 
 	/* Add to run queue. */
+	t->cpu = cpu_least_loaded ()->id;
+	t->vruntime = cpus[t->cpu].min_vruntime;
 	thread_unblock (t);
 	// 추가한 부분
 	test_max_priority();
@@ -309,13 +625,373 @@ thread_create (const char *name, int priority,
 }
 
 void test_max_priority(void) {
-	int pri = thread_get_priority();
-	struct list_elem *cur = list_begin(&ready_list);
-	struct thread *t1;
-	t1 = list_entry(cur, struct thread, elem);
+	if (intr_context ())
+		return;
+	if (edf_should_preempt (this_cpu ())) {
+		thread_yield ();
+		return;
+	}
+	if (thread_current ()->edf.runtime != 0)
+		return;
+	if (thread_cfs) {
+		if (cfs_should_preempt (this_cpu ()))
+			thread_yield ();
+		return;
+	}
+	// ready 큐가 비어있으면 ready_max_priority()는 -1을 반환하므로 양보하지 않는다.
+	if (thread_get_priority() < ready_max_priority (this_cpu ()) && !intr_context())
+		thread_yield();
+}
+
+/*** GrilledSalmon ***/
+/* vruntime이 작은 스레드가 먼저. 같으면 tid가 작은 쪽. */
+static bool
+cfs_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, cfs_elem);
+	const struct thread *b = heap_entry (b_, struct thread, cfs_elem);
+
+	if (a->vruntime != b->vruntime)
+		return a->vruntime < b->vruntime;
+	return a->tid < b->tid;
+}
+
+/* C의 run queue에서 vruntime이 가장 작은 스레드. 비어있으면 NULL. */
+static struct thread *
+cfs_first (struct cpu *c) {
+	struct heap_elem *e = heap_top (&c->cfs_queue);
+
+	return e != NULL ? heap_entry (e, struct thread, cfs_elem) : NULL;
+}
+
+static unsigned
+cfs_weight (const struct thread *t) {
+	int nice = t->nice < NICE_MIN ? NICE_MIN : t->nice > NICE_MAX ? NICE_MAX : t->nice;
+
+	return cfs_weights[nice - NICE_MIN];
+}
+
+/* C의 min_vruntime을 지금 스레드와 run queue의 맨 앞 중 작은 vruntime까지
+   올린다. 내리지는 않는다. */
+static void
+cfs_update_min (struct cpu *c) {
+	struct thread *first = cfs_first (c);
+	struct thread *curr = c->thread;
+	uint64_t v;
+
+	if (curr != NULL && curr != c->idle_thread && curr->status == THREAD_RUNNING)
+		v = first != NULL && first->vruntime < curr->vruntime
+			? first->vruntime : curr->vruntime;
+	else if (first != NULL)
+		v = first->vruntime;
+	else
+		return;
+	if (v > c->min_vruntime)
+		c->min_vruntime = v;
+}
+
+/* 돌고 있는 스레드가 run queue의 맨 앞보다 CFS_GRAN 넘게 앞서 있다. */
+static bool
+cfs_should_preempt (struct cpu *c) {
+	struct thread *first = cfs_first (c);
+	struct thread *curr = c->thread;
+
+	if (first == NULL)
+		return false;
+	return curr == c->idle_thread || curr->vruntime > first->vruntime + CFS_GRAN;
+}
+
+/* 한 tick 돈 T에 vruntime을 매기고, 뺏어야 하면 true. */
+static bool
+cfs_tick (struct cpu *c, struct thread *t) {
+	if (t != c->idle_thread) {
+		t->vruntime += CFS_TICK * NICE_0_WEIGHT / cfs_weight (t);
+		cfs_update_min (c);
+	}
+	return cfs_should_preempt (c);
+}
+
+/* 깨어나는 T의 vruntime을 C의 min_vruntime - CFS_GRAN보다 뒤처지지 않게
+   올린다. 오래 잔 스레드가 밀린 몫을 한꺼번에 가져가 다른 스레드들을 굶기지
+   않게 하면서, 조금은 먼저 돌게 해 준다. */
+static void
+cfs_place (struct cpu *c, struct thread *t) {
+	uint64_t floor = c->min_vruntime > CFS_GRAN ? c->min_vruntime - CFS_GRAN : 0;
+
+	if (t->vruntime < floor)
+		t->vruntime = floor;
+}
+
+/*** GrilledSalmon ***/
+static bool
+edf_deadline_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, edf.elem);
+	const struct thread *b = heap_entry (b_, struct thread, edf.elem);
+
+	if (a->edf.abs_deadline != b->edf.abs_deadline)
+		return a->edf.abs_deadline < b->edf.abs_deadline;
+	return a->tid < b->tid;
+}
+
+static bool
+edf_release_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, edf.elem);
+	const struct thread *b = heap_entry (b_, struct thread, edf.elem);
 
-	if (pri < t1->priority && !intr_context())
-			thread_yield();
+	return a->edf.next_release < b->edf.next_release;
+}
+
+/* C의 edf_queue에서 deadline이 가장 이른 스레드. 비어있으면 NULL. */
+static struct thread *
+edf_first (struct cpu *c) {
+	struct heap_elem *e = heap_top (&c->edf_queue);
+
+	return e != NULL ? heap_entry (e, struct thread, edf.elem) : NULL;
+}
+
+/* NOW에 T의 새 period를 시작한다. budget을 채우고 deadline을 정한다. */
+static void
+edf_new_period (struct thread *t, int64_t now) {
+	t->edf.budget = t->edf.runtime;
+	t->edf.abs_deadline = now + t->edf.deadline;
+	t->edf.next_release = now + t->edf.period;
+	t->edf.throttled = false;
+}
+
+/* ready가 된 EDF 스레드 T를 C의 큐에 넣는다. budget을 다 썼으면
+   edf_throttled에 넣는다. */
+static void
+edf_push (struct cpu *c, struct thread *t) {
+	if (t->edf.throttled)
+		heap_push (&c->edf_throttled, &t->edf.elem);
+	else {
+		heap_push (&c->edf_queue, &t->edf.elem);
+		c->edf_cnt++;
+	}
+}
+
+static void
+edf_remove (struct cpu *c, struct thread *t) {
+	if (t->edf.throttled)
+		heap_remove (&c->edf_throttled, &t->edf.elem);
+	else {
+		heap_remove (&c->edf_queue, &t->edf.elem);
+		c->edf_cnt--;
+	}
+}
+
+/* C에서 다음에 돌 EDF 스레드를 꺼낸다. 없으면 NULL. */
+static struct thread *
+edf_pop (struct cpu *c) {
+	struct thread *t = edf_first (c);
+
+	if (t != NULL) {
+		heap_pop (&c->edf_queue);
+		c->edf_cnt--;
+	}
+	return t;
+}
+
+/* C에서 돌고 있는 스레드보다 먼저 돌아야 할 EDF 스레드가 ready 큐에 있다. */
+static bool
+edf_should_preempt (struct cpu *c) {
+	struct thread *first = edf_first (c);
+	struct thread *curr = c->thread;
+
+	if (first == NULL)
+		return false;
+	return curr->edf.runtime == 0 || curr->edf.throttled
+		|| first->edf.abs_deadline < curr->edf.abs_deadline;
+}
+
+/* 한 tick마다 부른다. period가 다시 시작한 스레드를 edf_throttled에서
+   edf_queue로 옮기고, 돌고 있는 EDF 스레드 T의 budget을 깎는다. T를 뺏어야
+   하면 true. */
+static bool
+edf_tick (struct cpu *c, struct thread *t) {
+	int64_t now = timer_ticks ();
+	struct heap_elem *e;
+
+	while ((e = heap_top (&c->edf_throttled)) != NULL) {
+		struct thread *r = heap_entry (e, struct thread, edf.elem);
+
+		if (r->edf.next_release > now)
+			break;
+		heap_pop (&c->edf_throttled);
+		edf_new_period (r, now);
+		edf_push (c, r);
+	}
+
+	if (t->edf.runtime != 0) {
+		if (now >= t->edf.next_release)
+			edf_new_period (t, now);
+		else if (--t->edf.budget <= 0)
+			t->edf.throttled = true;
+	}
+	return t->edf.throttled || edf_should_preempt (c);
+}
+
+/* T를 T->cpu의 run queue에서 우선순위에 해당하는 큐의 맨 뒤에 넣는다.
+   인터럽트는 꺼져 있어야 한다. */
+static void
+ready_push (struct thread *t) {
+	struct cpu *c = &cpus[t->cpu];
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	if (t->edf.runtime != 0) {
+		edf_push (c, t);
+		return;
+	}
+	if (thread_cfs) {
+		heap_push (&c->cfs_queue, &t->cfs_elem);
+		c->ready_cnt++;
+		return;
+	}
+	list_push_back (&c->ready_queues[t->priority], &t->elem);
+	c->ready_mask |= 1ULL << t->priority;
+	c->ready_cnt++;
+}
+
+/* C의 run queue에서 가장 높은 우선순위 큐의 맨 앞 스레드를 꺼낸다.
+   비어있으면 NULL. */
+static struct thread *
+ready_pop (struct cpu *c) {
+	int pri = ready_max_priority (c);
+	struct thread *t;
+
+	if (thread_cfs) {
+		if (heap_empty (&c->cfs_queue))
+			return NULL;
+		t = heap_entry (heap_pop (&c->cfs_queue), struct thread, cfs_elem);
+		c->ready_cnt--;
+		cfs_update_min (c);
+		return t;
+	}
+	if (pri < 0)
+		return NULL;
+	t = list_entry (list_pop_front (&c->ready_queues[pri]), struct thread, elem);
+	if (list_empty (&c->ready_queues[pri]))
+		c->ready_mask &= ~(1ULL << pri);
+	c->ready_cnt--;
+	return t;
+}
+
+/* ready 큐에 있는 T를 큐에서 뺀다. T->priority는 아직 바뀌기 전이어야 한다. */
+static void
+ready_remove (struct thread *t) {
+	struct cpu *c = &cpus[t->cpu];
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_READY);
+
+	if (t->edf.runtime != 0) {
+		edf_remove (c, t);
+		return;
+	}
+	if (thread_cfs) {
+		heap_remove (&c->cfs_queue, &t->cfs_elem);
+		c->ready_cnt--;
+		return;
+	}
+	list_remove (&t->elem);
+	if (list_empty (&c->ready_queues[t->priority]))
+		c->ready_mask &= ~(1ULL << t->priority);
+	c->ready_cnt--;
+}
+
+/* C의 ready 큐에 있는 스레드 중 가장 높은 우선순위. 비어있으면 -1. */
+static int
+ready_max_priority (struct cpu *c) {
+	uint64_t mask = c->ready_mask;
+
+	if (mask == 0)
+		return -1;
+	return 63 - __builtin_clzll (mask);
+}
+
+/*** GrilledSalmon ***/
+/* C의 run queue가 비었을 때 다른 CPU에서 스레드를 하나 훔쳐 온다. ready 스레드가
+   가장 많은 CPU에서 가장 낮은 우선순위 큐의 맨 뒤 스레드 (가장 늦게 돌 스레드)를
+   가져와 C의 것으로 만든다. 훔칠 것이 없으면 NULL.
+
+   run queue는 아직 인터럽트를 꺼서 지킨다. CPU가 여럿 돌게 되면 CPU마다 run
+   queue의 spinlock을 두고 여기서 두 개를 잡아야 한다. */
+static struct thread *
+ready_steal (struct cpu *c) {
+	struct cpu *victim = NULL;
+	struct thread *t;
+	int pri;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	for (unsigned i = 0; i < cpu_cnt; i++)
+		if (&cpus[i] != c && cpus[i].ready_cnt > 0
+				&& (victim == NULL || cpus[i].ready_cnt > victim->ready_cnt))
+			victim = &cpus[i];
+	if (victim == NULL)
+		return NULL;
+
+	if (thread_cfs) {
+		/* vruntime은 CPU마다 따로 흐르므로 min_vruntime과의 차이를 옮긴다. */
+		int64_t lag;
+
+		t = cfs_first (victim);
+		ready_remove (t);
+		lag = (int64_t) (t->vruntime - victim->min_vruntime);
+		t->vruntime = lag < 0 && (uint64_t) -lag > c->min_vruntime
+			? 0 : c->min_vruntime + lag;
+		t->cpu = c->id;
+		return t;
+	}
+	pri = __builtin_ctzll (victim->ready_mask);
+	t = list_entry (list_back (&victim->ready_queues[pri]), struct thread, elem);
+	ready_remove (t);
+	t->cpu = c->id;
+	return t;
+}
+
+/* ready 스레드와 돌고 있는 스레드가 가장 적은 CPU. 새 스레드를 여기 둔다. */
+static struct cpu *
+cpu_least_loaded (void) {
+	struct cpu *best = NULL;
+	int best_load = 0;
+
+	for (unsigned i = 0; i < cpu_cnt; i++) {
+		struct cpu *c = &cpus[i];
+		int load = c->ready_cnt + c->edf_cnt + (c->thread != c->idle_thread);
+
+		if (best == NULL || load < best_load) {
+			best = c;
+			best_load = load;
+		}
+	}
+	return best;
+}
+
+/* T의 (donation이 반영된) 우선순위를 PRIORITY로 바꾼다.
+   T가 ready 큐에 있다면 새 우선순위의 큐 맨 뒤로 옮기고,
+   세마포어/condition waiters 힙에 있다면 그 안에서의 위치를 다시 잡는다. */
+void
+thread_update_priority (struct thread *t, int priority) {
+	enum intr_level old_level;
+
+	if (t->priority == priority)
+		return;
+
+	old_level = intr_disable ();
+	if (t->status == THREAD_READY && t != this_cpu ()->idle_thread) {
+		ready_remove (t);
+		t->priority = priority;
+		ready_push (t);
+	} else {
+		t->priority = priority;
+		/* 세마포어나 condition에서 기다리고 있다면 그 대기열도 재배치한다. */
+		synch_update_waiter (t);
+	}
+	intr_set_level (old_level);
 }
 
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
@@ -343,6 +1019,7 @@ void
 thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
+	TRACE (thread_block, thread_current ()->tid, 0);
 	thread_current ()->status = THREAD_BLOCKED;
 	schedule ();
 }
@@ -363,11 +1040,129 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
+	if (t->in_wheel) {
+		/* thread_block_timeout()의 시간이 되기 전에 깨어났다. */
+		list_remove (&t->elem);
+		t->in_wheel = false;
+	}
+	if (thread_mlfqs && t != this_cpu ()->idle_thread) {
+		/* block 되어 있던 동안 밀린 recent_cpu 감쇠를 반영한 뒤 큐에 넣는다. */
+		mlfqs_catch_up (t);
+		t->priority = mlfqs_calc_priority (t);
+	}
+	if (thread_cfs)
+		cfs_place (&cpus[t->cpu], t);
+	if (t->edf.runtime != 0 && timer_ticks () >= t->edf.next_release)
+		edf_new_period (t, timer_ticks ());
+	ready_push (t);
 	t->status = THREAD_READY;
+	t->ready_tsc = rdtsc ();
+	t->woken = true;
+	TRACE (thread_unblock, t->tid, t->priority);
+	/* 인터럽트가 깨운 EDF 스레드는 다음 tick을 기다리지 않고 바로 돌린다. */
+	if (t->edf.runtime != 0 && intr_context ()
+			&& t->cpu == this_cpu ()->id && edf_should_preempt (this_cpu ()))
+		intr_yield_on_return ();
 	intr_set_level (old_level);
 }
 
+/* Invoke function 'func' on all threads, passing along 'aux'.
+   This function must be called with interrupts off. */
+void
+thread_foreach (thread_action_func *func, void *aux) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&all_list); e != list_end (&all_list);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, all_elem);
+		func (t, aux);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* TID인 스레드의 struct child를 찾는다. 없으면 NULL. 돌려준 기록은 인터럽트가
+   켜지면 풀릴 수 있으므로 인터럽트를 끄고 불러야 한다. */
+struct child *
+child_find (tid_t tid) {
+	struct list *bucket = &pid_table[tid % PID_BUCKETS];
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (tid < 0)
+		return NULL;
+	for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e)) {
+		struct child *c = list_entry (e, struct child, pid_elem);
+		if (c->tid == tid)
+			return c;
+	}
+	return NULL;
+}
+
+/* TID인 스레드를 찾는다. 없거나 이미 끝났으면 NULL. 인터럽트를 끄고 불러야
+   한다. */
+struct thread *
+thread_find (tid_t tid) {
+	struct child *c = child_find (tid);
+
+	return c != NULL ? c->thread : NULL;
+}
+
+/* C의 참조 하나를 놓는다. 부모와 자식이 모두 놓으면 pid table에서 빼고 푼다. */
+void
+child_put (struct child *c) {
+	enum intr_level old_level = intr_disable ();
+	bool last = --c->ref_cnt == 0;
+
+	if (last)
+		list_remove (&c->pid_elem);
+	intr_set_level (old_level);
+	if (last)
+		free (c);
+}
+
+/* 끝나는 스레드 T의 기록을 정리한다. 자기 기록에 종료 상태를 남기고 부모의
+   zombie_list로 옮긴다. 부모가 wait 할 때까지 기다리지 않으므로 T의 page는
+   바로 풀린다. 아직 거두지 않은 자식들은 부모를 잃으므로 그 기록을 놓는다.
+   user thread의 기록은 uthread_list에 남겨 두고 exited만 올린다. */
+static void
+thread_child_exit (struct thread *t) {
+	struct child *c = t->child;
+	struct list orphans;
+	enum intr_level old_level;
+
+	list_init (&orphans);
+	old_level = intr_disable ();
+	while (!list_empty (&t->child_list))
+		list_push_back (&orphans, list_pop_front (&t->child_list));
+	while (!list_empty (&t->zombie_list))
+		list_push_back (&orphans, list_pop_front (&t->zombie_list));
+	while (!list_empty (&t->uthread_list))
+		list_push_back (&orphans, list_pop_front (&t->uthread_list));
+	for (struct list_elem *e = list_begin (&orphans); e != list_end (&orphans);
+			e = list_next (e))
+		list_entry (e, struct child, elem)->parent = NULL;
+
+	if (c != NULL) {
+		c->thread = NULL;
+		c->exit_status = t->exit_status;
+		if (c->parent != NULL && !c->uthread) {
+			list_remove (&c->elem);
+			list_push_back (&c->parent->zombie_list, &c->elem);
+			sema_up (&c->parent->child_exit);
+		}
+		sema_up (&c->exited);
+	}
+	intr_set_level (old_level);
+
+	while (!list_empty (&orphans))
+		child_put (list_entry (list_pop_front (&orphans), struct child, elem));
+	if (c != NULL)
+		child_put (c);
+}
+
 /* Returns the name of the running thread. */
 const char *
 thread_name (void) {
@@ -404,14 +1199,18 @@ thread_tid (void) {
 void
 thread_exit (void) {
 	ASSERT (!intr_context ());
+	ASSERT (thread_current ()->rcu_nesting == 0);
 
 #ifdef USERPROG
 	process_exit ();
 #endif
+	thread_child_exit (thread_current ());
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	list_remove (&thread_current ()->all_elem);
+	edf_bw_total -= thread_current ()->edf.bw;
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -427,13 +1226,73 @@ thread_yield (void) {
 	ASSERT (!intr_context ());
 	old_level = intr_disable ();	// timer인터럽트나 i/o 인터럽트같은 것들를 disable한다.
 	// 만약 현재 스레드가 Idle 스레드가 아니라면 ready queue에 다시 담는다.
-	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
+	if (curr != this_cpu ()->idle_thread) {
+		/* -cfs에서는 vruntime이 가장 작으면 바로 다시 뽑히므로, 양보할 때는
+		   맨 앞 스레드 바로 뒤로 vruntime을 옮긴다. */
+		struct thread *first = thread_cfs ? cfs_first (this_cpu ()) : NULL;
+
+		if (first != NULL && curr->vruntime <= first->vruntime)
+			curr->vruntime = first->vruntime + 1;
+		ready_push (curr);
+		curr->ready_tsc = rdtsc ();
+		curr->woken = false;
+	}
 	// 현재 스레드가 idle이라면 ready queue에 담을필요가 없다. 어차피 static으로 선언되어 있어, 필요할 때 불러올 수 있다.
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
 
+/*** GrilledSalmon ***/
+/* 돌고 있는 스레드를 ready 큐에 넣고 ready 상태인 T로 바로 전환한다. 방금 깨운
+   스레드에게 CPU를 넘겨주는 용도다. 우선순위가 같은 스레드끼리 주고받을 때
+   thread_yield()는 같은 우선순위 큐의 맨 뒤로 가므로 T 앞의 스레드들이 먼저
+   돌지만, 여기서는 T를 큐의 맨 앞에 놓아 다음으로 돌게 한다.
+
+   T가 다른 CPU의 큐에 있으면 이 CPU로 데려온다. 우선순위 규칙은 지킨다: T가
+   현재 스레드나 이 CPU의 다른 ready 스레드보다 우선순위가 낮으면, 또 T가 ready가
+   아니면 아무것도 하지 않고 false를 리턴한다. 전환했다가 다시 돌아왔으면 true.
+   T가 그 사이에 없어지지 않는 것은 부르는 쪽이 보장해야 한다. */
+bool
+thread_yield_to (struct thread *t) {
+	struct thread *curr = thread_current ();
+	struct cpu *c = this_cpu ();
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+	ASSERT (is_thread (t));
+
+	old_level = intr_disable ();
+	if (t == curr || t->status != THREAD_READY || t == cpus[t->cpu].idle_thread
+			|| t->edf.runtime != 0 || curr->edf.runtime != 0
+			|| (!thread_cfs && (t->priority < curr->priority
+					|| t->priority < ready_max_priority (c)))) {
+		intr_set_level (old_level);
+		return false;
+	}
+	ready_remove (t);
+	t->cpu = c->id;
+	if (thread_cfs) {
+		/* -cfs에서는 T의 vruntime을 맨 앞 스레드보다 작게 당겨 맨 앞에 둔다.
+		   당긴 만큼은 T가 돌면서 다시 쌓는다. */
+		struct thread *first = cfs_first (c);
+
+		if (first != NULL && t->vruntime >= first->vruntime)
+			t->vruntime = first->vruntime > 0 ? first->vruntime - 1 : 0;
+		ready_push (t);
+	} else {
+		list_push_front (&c->ready_queues[t->priority], &t->elem);
+		c->ready_mask |= 1ULL << t->priority;
+		c->ready_cnt++;
+	}
+
+	ready_push (curr);
+	curr->ready_tsc = rdtsc ();
+	curr->woken = false;
+	do_schedule (THREAD_READY);
+	intr_set_level (old_level);
+	return true;
+}
+
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
@@ -455,11 +1314,51 @@ void
 thread_set_nice (int nice UNUSED) {
 	enum intr_level old_level = intr_disable ();
 	thread_current()->nice = nice;
-	mlfqs_priority(thread_current());
+	/* -cfs에서는 nice가 바로 weight가 되므로 우선순위는 건드리지 않는다. */
+	if (!thread_cfs)
+		mlfqs_priority(thread_current());
 	test_max_priority();
 	intr_set_level (old_level);
 }
 
+/*** GrilledSalmon ***/
+/* 지금 스레드를 PERIOD tick마다 시작해 DEADLINE tick 안에 RUNTIME tick을 받는
+   EDF 스레드로 만든다. 이미 EDF 스레드면 예약을 바꾸고, RUNTIME이 0이면 보통
+   스레드로 돌아간다. RUNTIME <= DEADLINE <= PERIOD여야 하고, 모든 EDF 스레드의
+   runtime/period 합이 EDF_BW_MAX를 넘게 되면 받아들이지 않고 false. */
+bool
+thread_set_edf (int64_t runtime, int64_t period, int64_t deadline) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	uint64_t bw = 0;
+	bool ok;
+
+	if (runtime < 0 || (runtime > 0 && (deadline < runtime || period < deadline)))
+		return false;
+	if (runtime > 0)
+		bw = ((uint64_t) runtime << EDF_BW_SHIFT) / period;
+
+	old_level = intr_disable ();
+	ok = edf_bw_total - curr->edf.bw + bw <= EDF_BW_MAX * cpu_cnt;
+	if (ok) {
+		edf_bw_total = edf_bw_total - curr->edf.bw + bw;
+		curr->edf.runtime = runtime;
+		curr->edf.period = period;
+		curr->edf.deadline = deadline;
+		curr->edf.bw = bw;
+		if (runtime > 0)
+			edf_new_period (curr, timer_ticks ());
+		else {
+			curr->edf.throttled = false;
+			curr->vruntime = this_cpu ()->min_vruntime;
+		}
+	}
+	intr_set_level (old_level);
+	if (ok)
+		test_max_priority ();
+	return ok;
+}
+
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
@@ -502,7 +1401,7 @@ static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();	// 현재 들고 있는 스레드가 idle밖에 없다
+	this_cpu ()->idle_thread = thread_current ();	// 현재 들고 있는 스레드가 idle밖에 없다
 	sema_up (idle_started);		// semaphore의 값을 1로 만들어 줘서 공유 자원의 공유(인터럽트) 가능
 
 	for (;;) {
@@ -510,6 +1409,15 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();	// 자기 자신(idle)을 block해주기 전까지 인터럽트 당하면 안되므로 먼저 disable 한다.
 		thread_block ();	// 자기 자신을 block 한다.
 
+		/* 할 일이 없으니 PAL_ZERO용 페이지와 cache의 page table page를
+		   미리 0으로 채워 둔다. 인터럽트를 켜 두므로 누군가 ready가 되면
+		   바로 선점된다. */
+		intr_enable ();
+		while (this_cpu ()->ready_cnt == 0
+				&& (pml4_zero_idle () || palloc_zero_idle ()))
+			continue;
+		intr_disable ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -522,7 +1430,9 @@ idle (void *idle_started_ UNUSED) {
 
 		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
 		   7.11.1 "HLT Instruction". */
-		asm volatile ("sti; hlt" : : : "memory");
+		/*** GrilledSalmon ***/
+		/* timer_idle()이 다음 할 일까지 timer 인터럽트를 멈추고 sti; hlt 한다. */
+		timer_idle ();
 	}
 }
 
@@ -539,6 +1449,35 @@ kernel_thread (thread_func *function, void *aux) {
 
 /* Does basic initialization of T as a blocked thread named
    NAME. */
+/*** GrilledSalmon ***/
+/* 새 스레드의 page. 캐시에 있으면 그것을, 없으면 palloc에서 받는다. */
+static struct thread *
+thread_page_get (void) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *t = NULL;
+
+	if (thread_cache_cnt > 0) {
+		t = thread_cache[--thread_cache_cnt];
+		thread_cache_hits++;
+	} else
+		thread_cache_misses++;
+	intr_set_level (old_level);
+	return t != NULL ? t : palloc_get_page (PAL_ZERO);
+}
+
+/* 스레드 page T를 캐시에 넣는다. 가득 차면 palloc에 돌려준다. */
+static void
+thread_page_put (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+	bool cached = thread_cache_cnt < THREAD_CACHE_MAX;
+
+	if (cached)
+		thread_cache[thread_cache_cnt++] = t;
+	intr_set_level (old_level);
+	if (!cached)
+		palloc_free_page (t);
+}
+
 // 만든 스레드를 초기화 한다. 맨처음 스레드의 상태는 blocked이다.
 // 커널 스택 포인터 rsp의 위치도 같이 정해준다. rsp의 값은 커널이 함수나 변수를 쌓을수록 점점 작아질 것.
 static void
@@ -555,15 +1494,20 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->magic = THREAD_MAGIC;	// 스레드 공간의 끝주소 값은 동일하기 때문에 기본 값으로 넣어준다.
 	t->init_priority = priority;
 	t->wait_on_lock = NULL;
-	list_init(&t->list_donation);
+	heap_init(&t->held_locks, cmp_lock_priority, NULL);
 	list_init(&t->child_list);
-
-	sema_init(&t->wait_sema,0);
-    sema_init(&t->fork_sema,0);
-    sema_init(&t->free_sema,0);
+	list_init (&t->zombie_list);
+	sema_init (&t->child_exit, 0);
+	list_init (&t->uthread_list);
+	t->leader = t;
 
 	t->nice = NICE_DEFAULT;
 	t->recent_cpu = RECENT_CPU_DEFAULT;
+	t->recent_cpu_epoch = mlfqs_epoch;
+
+	enum intr_level old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -573,10 +1517,14 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct cpu *c = this_cpu ();
+	struct thread *next = edf_pop (c);
+
+	if (next == NULL)
+		next = ready_pop (c);
+	if (next == NULL)
+		next = ready_steal (c);
+	return next != NULL ? next : c->idle_thread;
 }
 
 /* Use iretq to launch the thread */
@@ -687,7 +1635,8 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim =
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		fpu_release (victim);
+		thread_page_put (victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -701,11 +1650,15 @@ schedule (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
+	schedstat_switch (curr, next);
+	/* context switch마다 RCU grace period가 끝났는지 본다. */
+	rcu_quiescent ();
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	this_cpu ()->thread_ticks = 0;
+	this_cpu ()->thread = next;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -727,6 +1680,8 @@ schedule (void) {
 
 		/* Before switching the thread, we first save the information
 		 * of current running. */
+		TRACE (sched_switch, curr->tid, next->tid);
+		fpu_switch (next);
 		thread_launch (next);
 	}
 }
@@ -745,53 +1700,103 @@ allocate_tid (void) {
 }
 
 
-void mlfqs_priority(struct thread *t)
+/* T의 mlfqs 우선순위를 계산한다. ready 큐의 인덱스로 쓰이므로 PRI_MIN..PRI_MAX 범위로 잘라준다. */
+static int mlfqs_calc_priority(struct thread *t)
 {
-	if (t == idle_thread) return;
-	t->priority = fp_to_int (add_mixed (div_mixed (t->recent_cpu, -4), PRI_MAX - t->nice * 2));
+	int priority = fp_to_int (add_mixed (div_mixed (t->recent_cpu, -4), PRI_MAX - t->nice * 2));
 	// PRI_MAX –(recent_cpu/ 4) – (nice * 2)
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
+}
+
+void mlfqs_priority(struct thread *t)
+{
+	if (t == this_cpu ()->idle_thread) return;
+	thread_update_priority (t, mlfqs_calc_priority (t));
 }
 
 void mlfqs_recent_cpu(struct thread *t)
 {
-	if (t == idle_thread) return;
-	t->recent_cpu = add_mixed (mult_fp (div_fp (mult_mixed (load_avg, 2), add_mixed (mult_mixed (load_avg, 2), 1)), t->recent_cpu), t->nice);
+	if (t == this_cpu ()->idle_thread) return;
+	t->recent_cpu = add_mixed (mult_fp (recent_cpu_coef, t->recent_cpu), t->nice);
 	// (2 * load_avg) / (2 * load_avg +1) * t->recent_cpu + t->nice;
+	t->recent_cpu_epoch = mlfqs_epoch;
+}
+
+/* T가 recent_cpu를 마지막으로 갱신한 뒤 지나간 k초 만큼의 감쇠를 한 번에 적용한다.
+   c = 2L/(2L+1)일 때 k번 반복한 결과는
+     recent_cpu = c^k * recent_cpu + nice * (1 - c^k) * (2L+1)
+   이고, 그동안 load_avg가 현재 값으로 일정했다고 근사한다. */
+static void
+mlfqs_catch_up (struct thread *t) {
+	int64_t k = mlfqs_epoch - t->recent_cpu_epoch;
+	int twice_load = mult_mixed (load_avg, 2);
+	int coef = recent_cpu_coef;
+	int coef_k = int_to_fp (1);
+
+	if (k <= 0)
+		return;
+
+	/* 제곱을 반복해 c^k를 O(log k)에 구한다. */
+	for (int64_t e = k; e > 0; e >>= 1) {
+		if (e & 1)
+			coef_k = mult_fp (coef_k, coef);
+		coef = mult_fp (coef, coef);
+	}
+
+	t->recent_cpu = add_fp (mult_fp (coef_k, t->recent_cpu),
+			mult_mixed (mult_fp (sub_fp (int_to_fp (1), coef_k),
+					add_mixed (twice_load, 1)), t->nice));
+	t->recent_cpu_epoch = mlfqs_epoch;
 }
 
 void mlfqs_load_avg(void)
 {
 	int cnt = 0;
-	if (thread_current() != idle_thread) {
-		cnt++;
+	/* 모든 CPU의 ready 스레드와, idle이 아닌 돌고 있는 스레드를 센다. */
+	for (unsigned i = 0; i < cpu_cnt; i++) {
+		cnt += cpus[i].ready_cnt + cpus[i].edf_cnt;
+		if (cpus[i].thread != cpus[i].idle_thread)
+			cnt++;
 	}
-	load_avg =  add_fp (mult_fp (div_fp (int_to_fp (59), int_to_fp (60)), load_avg),
-                     mult_mixed (div_fp (int_to_fp (1), int_to_fp (60)), list_size(&ready_list) + cnt));
-	// (59/60) * load_avg + (1/60) * (list_size(&ready_list) + cnt);
+	load_avg = add_fp (mult_fp (FP_59_60, load_avg), mult_mixed (FP_1_60, cnt));
+	// (59/60) * load_avg + (1/60) * (ready_cnt + cnt);
 	if (load_avg < 0) {
 		load_avg = LOAD_AVG_DEFAULT;
 	}
+	recent_cpu_coef = div_fp (mult_mixed (load_avg, 2), add_mixed (mult_mixed (load_avg, 2), 1));
 // add_fp (mult_fp (div_fp (int_to_fp (59), int_to_fp (60)), load_avg),
 // mult_mixed (div_fp (int_to_fp (1), int_to_fp (60)), ready_threads))
 }
 
 void mlfqs_increment(void)
 {
-	if (thread_current() != idle_thread)
+	if (thread_current() != this_cpu ()->idle_thread)
 		thread_current()->recent_cpu = add_mixed(thread_current()->recent_cpu, 1);
 }
 
 void mlfqs_recalc(void)
 {
-	struct list_elem *e;
-	struct list_elem *f;
-	for(e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e)){
-		mlfqs_recent_cpu(list_entry(e, struct thread, elem));
-		mlfqs_priority(list_entry(e, struct thread, elem));
-	}
-	for(f = list_begin(&sleep_list); f != list_end(&sleep_list); f = list_next(f)){
-		mlfqs_recent_cpu(list_entry(f, struct thread, elem));
-		mlfqs_priority(list_entry(f, struct thread, elem));
+	struct list ready;
+
+	mlfqs_epoch++;
+
+	// blocked 스레드는 여기서 갱신하지 않고, thread_unblock()에서 mlfqs_catch_up()으로 한 번에 따라잡는다.
+	// 우선순위가 바뀌면 큐를 옮겨다니므로, 높은 우선순위 큐부터 순서대로 꺼내 놓고 다시 넣는다.
+	// 다시 넣을 때는 t->cpu의 큐로 돌아가므로 모든 CPU의 큐를 한 번에 모은다.
+	list_init(&ready);
+	for (unsigned i = 0; i < cpu_cnt; i++)
+		while (cpus[i].ready_cnt > 0)
+			list_push_back(&ready, &ready_pop(&cpus[i])->elem);
+	while (!list_empty(&ready)){
+		struct thread *t = list_entry(list_pop_front(&ready), struct thread, elem);
+		mlfqs_recent_cpu(t);
+		if (t != this_cpu ()->idle_thread)
+			t->priority = mlfqs_calc_priority(t);	// 큐 밖에 있으므로 직접 갱신
+		ready_push(t);
 	}
 	mlfqs_recent_cpu(thread_current());
 	mlfqs_priority(thread_current());
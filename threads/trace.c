@@ -0,0 +1,75 @@
+#include "threads/trace.h"
+#include <stdio.h>
+#include "devices/serial.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/*** GrilledSalmon ***/
+/* Kernel trace ring buffer.  See trace.h.
+
+   A writer claims a slot by atomically incrementing trace_head and
+   fills it in place, so interrupt handlers may record while a
+   thread is in the middle of a record without any lock.  Once the
+   ring wraps, the oldest records are overwritten. */
+
+#ifdef KTRACE
+
+/* Number of records in the ring.  A power of 2. */
+#define TRACE_RECS 2048
+
+static struct trace_rec trace_ring[TRACE_RECS];
+static uint64_t trace_head;             /* Records ever claimed. */
+
+/* Event names, indexed by enum trace_event, for the dump header. */
+static const char *const trace_names[TRACE_EVENT_CNT] = {
+	"sched_switch", "thread_block", "thread_unblock", "page_fault",
+	"evict", "disk_read", "disk_write", "syscall",
+};
+
+/* Records EVENT with arguments A and B. */
+void
+trace_record (enum trace_event event, uint64_t a, uint64_t b) {
+	uint64_t n = __atomic_fetch_add (&trace_head, 1, __ATOMIC_RELAXED);
+	struct trace_rec *r = &trace_ring[n & (TRACE_RECS - 1)];
+	struct cpu *c = this_cpu ();
+
+	r->tsc = rdtsc ();
+	r->event = event;
+	r->cpu = c->id;
+	r->tid = c->thread != NULL ? c->thread->tid : -1;
+	r->a = a;
+	r->b = b;
+}
+
+/* Writes the ring to the serial port, oldest record first.  The
+   dump is one text line
+
+       ktrace: N records of 32 bytes, events NAME0 NAME1 ...\n
+
+   giving the event names in enum order, followed by N raw
+   struct trace_rec in little-endian byte order, followed by the
+   line "ktrace: end\n".  Recording stops while dumping. */
+void
+trace_dump (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t head = trace_head;
+	uint64_t first = head > TRACE_RECS ? head - TRACE_RECS : 0;
+	uint64_t i;
+	int e;
+
+	printf ("ktrace: %llu records of %zu bytes, events",
+			(unsigned long long) (head - first), sizeof (struct trace_rec));
+	for (e = 0; e < TRACE_EVENT_CNT; e++)
+		printf (" %s", trace_names[e]);
+	printf ("\n");
+	serial_flush ();
+	for (i = first; i < head; i++)
+		serial_putbuf (&trace_ring[i & (TRACE_RECS - 1)], sizeof (struct trace_rec));
+	serial_flush ();
+	printf ("ktrace: end\n");
+	intr_set_level (old_level);
+}
+
+#endif /* KTRACE */
@@ -0,0 +1,180 @@
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/*** GrilledSalmon ***/
+/* vmalloc.
+
+   malloc()은 한 page에 들어가지 않는 block을 palloc_get_multiple()로 받으므로
+   물리적으로 이어진 page가 필요하다. 메모리가 조각나면 빈 page가 많아도
+   실패한다. vmalloc()은 page를 하나씩 따로 받아 VMALLOC_START부터의 커널 가상
+   주소에 이어 붙여 매핑한다. 오래 살고 큰 표 (hash bucket 배열, frame table,
+   FAT sector 표 같은 것)에 쓴다.
+
+   매핑은 base_pml4의 PDPT 아래에 만든다. 커널 영역의 PML4 entry는 모든
+   pml4가 복사해 가지므로, 나중에 만든 매핑도 모든 주소 공간에서 보인다.
+   영역마다 뒤에 매핑하지 않은 guard page를 하나 두어, 넘쳐 쓰면 page fault가
+   나고 vfree()는 guard page까지 세어 크기를 안다.
+
+   direct map 밖이므로 vtop()을 쓸 수 없고, DMA buffer로 쓰면 안 된다.
+   spinlock으로만 막으므로 malloc()을 부를 수 있는 곳이면 어디서나 부를 수
+   있다. */
+
+#define VMALLOC_PAGES (VMALLOC_SIZE / PGSIZE)
+
+static struct spinlock vmalloc_lock;
+static struct bitmap *va_map;           /* 쓰고 있는 가상 page. guard 포함. */
+static uint8_t va_map_buf[VMALLOC_PAGES / 8 + 64];
+
+/* 통계. vmalloc_lock이 보호한다. */
+static size_t alloc_cnt, free_cnt;
+static size_t page_cnt, peak_page_cnt;
+
+/* paging_init() 뒤에 부른다. 그 전의 kvmalloc()은 malloc()으로 간다. */
+void
+vmalloc_init (void) {
+	ASSERT (bitmap_buf_size (VMALLOC_PAGES) <= sizeof va_map_buf);
+	spinlock_init (&vmalloc_lock);
+	va_map = bitmap_create_in_buf (VMALLOC_PAGES, va_map_buf, sizeof va_map_buf);
+}
+
+/* VA부터 매핑된 page를 guard page까지 모두 풀고 돌려준다. 푼 page 수. */
+static size_t
+unmap_pages (uint8_t *va) {
+	size_t cnt = 0;
+	void *kpage;
+
+	for (;;) {
+		spinlock_acquire (&vmalloc_lock);
+		kpage = pml4_unmap_kernel (va + cnt * PGSIZE);
+		spinlock_release (&vmalloc_lock);
+		if (kpage == NULL)
+			return cnt;
+		palloc_free_page (kpage);
+		cnt++;
+	}
+}
+
+/* SIZE 바이트 이상의 가상으로 이어진 block을 page 단위로 할당한다. 내용은
+   정해져 있지 않다. 가상 주소나 page가 모자라면 NULL. */
+void *
+vmalloc (size_t size) {
+	size_t cnt = DIV_ROUND_UP (size, PGSIZE);
+	size_t idx, i;
+	uint8_t *va;
+
+	if (size == 0 || va_map == NULL || cnt >= VMALLOC_PAGES)
+		return NULL;
+
+	spinlock_acquire (&vmalloc_lock);
+	idx = bitmap_scan_and_flip (va_map, 0, cnt + 1, false);
+	spinlock_release (&vmalloc_lock);
+	if (idx == BITMAP_ERROR)
+		return NULL;
+	va = (uint8_t *) (VMALLOC_START + idx * PGSIZE);
+
+	for (i = 0; i < cnt; i++) {
+		void *kpage = palloc_get_page (0);
+		bool ok;
+
+		if (kpage == NULL)
+			goto fail;
+		spinlock_acquire (&vmalloc_lock);
+		ok = pml4_map (base_pml4, (uint64_t) (va + i * PGSIZE), vtop (kpage),
+				PTE_P | PTE_W);
+		spinlock_release (&vmalloc_lock);
+		if (!ok) {
+			palloc_free_page (kpage);
+			goto fail;
+		}
+	}
+
+	spinlock_acquire (&vmalloc_lock);
+	alloc_cnt++;
+	page_cnt += cnt;
+	if (page_cnt > peak_page_cnt)
+		peak_page_cnt = page_cnt;
+	spinlock_release (&vmalloc_lock);
+	return va;
+
+fail:
+	unmap_pages (va);
+	spinlock_acquire (&vmalloc_lock);
+	bitmap_set_multiple (va_map, idx, cnt + 1, false);
+	spinlock_release (&vmalloc_lock);
+	return NULL;
+}
+
+/* vmalloc()으로 받은 P를 돌려준다. P가 NULL이면 아무것도 하지 않는다. */
+void
+vfree (void *p) {
+	size_t idx, cnt;
+
+	if (p == NULL)
+		return;
+	ASSERT (is_vmalloc_addr (p));
+	ASSERT (pg_ofs (p) == 0);
+
+	idx = ((uint64_t) p - VMALLOC_START) / PGSIZE;
+	cnt = unmap_pages (p);
+	ASSERT (cnt > 0);
+
+	spinlock_acquire (&vmalloc_lock);
+	ASSERT (bitmap_all (va_map, idx, cnt + 1));
+	bitmap_set_multiple (va_map, idx, cnt + 1, false);
+	free_cnt++;
+	page_cnt -= cnt;
+	spinlock_release (&vmalloc_lock);
+}
+
+/* SIZE가 page 하나를 넘을 수 있는 표를 받는다. 작으면 malloc()으로, 크면
+   vmalloc()으로 받는다. kvfree()로 돌려준다. */
+void *
+kvmalloc (size_t size) {
+	void *p;
+
+	if (size <= PGSIZE / 2 || va_map == NULL)
+		return malloc (size);
+	p = vmalloc (size);
+	return p != NULL ? p : malloc (size);
+}
+
+/* 0으로 채운 A * B 바이트의 kvmalloc(). */
+void *
+kvcalloc (size_t a, size_t b) {
+	size_t size = a * b;
+	void *p;
+
+	if (a != 0 && size / a != b)
+		return NULL;
+	p = kvmalloc (size);
+	if (p != NULL)
+		memset (p, 0, size);
+	return p;
+}
+
+/* kvmalloc()이나 kvcalloc()으로 받은 P를 돌려준다. */
+void
+kvfree (void *p) {
+	if (is_vmalloc_addr (p))
+		vfree (p);
+	else
+		free (p);
+}
+
+void
+vmalloc_print_stats (void) {
+	spinlock_acquire (&vmalloc_lock);
+	printf ("vmalloc: %zu allocs, %zu frees, %zu pages (peak %zu)\n",
+			alloc_cnt, free_cnt, page_cnt, peak_page_cnt);
+	spinlock_release (&vmalloc_lock);
+}
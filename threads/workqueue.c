@@ -0,0 +1,242 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/*** GrilledSalmon ***/
+/* Kernel work queue.
+
+   Write-back, readahead and reclaim used to each run in a thread
+   of their own that slept until there was something to do.  Now
+   they hand struct works to a small pool of worker threads
+   instead.  Each priority has its own FIFO queue, and a worker
+   always takes from the highest non-empty one.  While it runs a
+   work, the worker runs at the thread priority that matches the
+   queue.  A work that must run again later re-queues itself,
+   often with work_queue_delayed().  Delayed works wait on a list
+   sorted by expiry, and the timer interrupt moves them to their
+   queue.
+
+   Bottom halves are the second half of an interrupt handler.
+   The handler acknowledges the device and calls bh_schedule().
+   One thread at PRI_MAX runs the bottom halves right after the
+   interrupt returns.  Bottom halves do not share the worker pool,
+   because a work may wait for a disk request that only a bottom
+   half can complete.
+
+   All the queues are protected by turning interrupts off, so
+   interrupt handlers can queue works. */
+
+#define WQ_WORKERS 3
+
+static struct list queues[WQ_PRIO_CNT];
+static struct list delayed;         /* expire 순. */
+static struct semaphore queued;     /* 큐에 있는 work 수. */
+static struct list bh_list;
+static struct semaphore bh_queued;  /* bh_list에 있는 work 수. */
+
+/* 큐마다 worker가 그 일을 하는 동안의 스레드 우선순위. */
+static const int wq_priority[WQ_PRIO_CNT] = {
+	[WQ_HIGH] = PRI_DEFAULT + 1,
+	[WQ_NORMAL] = PRI_DEFAULT,
+	[WQ_LOW] = PRI_MIN,
+};
+
+/* 통계. 인터럽트를 끄고 센다. */
+static long long run_cnt[WQ_PRIO_CNT];
+static long long bh_run_cnt;
+
+static void worker (void *aux);
+static void bh_thread (void *aux);
+
+/* 큐를 초기화한다. timer 인터럽트가 켜지기 전에 부른다. */
+void
+workqueue_init (void) {
+	int i;
+
+	for (i = 0; i < WQ_PRIO_CNT; i++)
+		list_init (&queues[i]);
+	list_init (&delayed);
+	list_init (&bh_list);
+	sema_init (&queued, 0);
+	sema_init (&bh_queued, 0);
+}
+
+/* worker들과 bottom half 스레드를 띄운다. thread_start() 다음에 부른다. 그
+   전에 넣은 work는 이때부터 돈다. */
+void
+workqueue_start (void) {
+	int i;
+
+	if (thread_create ("kbhd", PRI_MAX, bh_thread, NULL) == TID_ERROR)
+		PANIC ("cannot start bottom half thread");
+	for (i = 0; i < WQ_WORKERS; i++) {
+		char name[16];
+
+		snprintf (name, sizeof name, "kworker/%d", i);
+		if (thread_create (name, PRI_DEFAULT, worker, NULL) == TID_ERROR)
+			PANIC ("cannot start work queue worker");
+	}
+}
+
+/* W가 AUX를 넘겨 FUNC를 부르도록 초기화한다. */
+void
+work_init (struct work *w, work_func *func, void *aux) {
+	w->func = func;
+	w->aux = aux;
+	w->expire = 0;
+	w->prio = WQ_NORMAL;
+	w->pending = false;
+}
+
+/* W를 PRIO 큐의 맨 뒤에 넣는다. 이미 pending이면 false. 인터럽트 처리기에서
+   불러도 된다. */
+bool
+work_queue (struct work *w, enum wq_prio prio) {
+	enum intr_level old_level;
+	bool queue;
+
+	ASSERT (prio < WQ_PRIO_CNT);
+
+	old_level = intr_disable ();
+	queue = !w->pending;
+	if (queue) {
+		w->pending = true;
+		w->prio = prio;
+		list_push_back (&queues[prio], &w->elem);
+		sema_up (&queued);
+	}
+	intr_set_level (old_level);
+	return queue;
+}
+
+static bool
+expire_less (const struct list_elem *a, const struct list_elem *b,
+		void *aux UNUSED) {
+	return list_entry (a, struct work, elem)->expire
+		< list_entry (b, struct work, elem)->expire;
+}
+
+/* TICKS tick 뒤에 W를 PRIO 큐에 넣는다. 이미 pending이면 false. */
+bool
+work_queue_delayed (struct work *w, enum wq_prio prio, int64_t ticks) {
+	enum intr_level old_level;
+	bool queue;
+
+	ASSERT (prio < WQ_PRIO_CNT);
+
+	if (ticks <= 0)
+		return work_queue (w, prio);
+	old_level = intr_disable ();
+	queue = !w->pending;
+	if (queue) {
+		w->pending = true;
+		w->prio = prio;
+		w->expire = timer_ticks () + ticks;
+		list_insert_ordered (&delayed, &w->elem, expire_less, NULL);
+	}
+	intr_set_level (old_level);
+	return queue;
+}
+
+/* W를 bottom half로 돌린다. 인터럽트 처리기에서 부르면 처리기가 끝나자마자
+   돈다. 이미 pending이면 아무것도 하지 않는다. */
+void
+bh_schedule (struct work *w) {
+	enum intr_level old_level = intr_disable ();
+
+	if (!w->pending) {
+		w->pending = true;
+		list_push_back (&bh_list, &w->elem);
+		sema_up (&bh_queued);
+		if (intr_context ())
+			intr_yield_on_return ();
+	}
+	intr_set_level (old_level);
+}
+
+/* timer 인터럽트가 tick마다 부른다. 시간이 된 delayed work를 큐로 옮긴다. */
+void
+workqueue_tick (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (!list_empty (&delayed)) {
+		struct work *w = list_entry (list_front (&delayed), struct work, elem);
+
+		if (w->expire > now)
+			break;
+		list_pop_front (&delayed);
+		list_push_back (&queues[w->prio], &w->elem);
+		sema_up (&queued);
+	}
+}
+
+/* 다음 tick부터 세어 delayed work가 처음 큐로 가는 tick까지의 tick 수를 LIMIT
+   이하로 리턴한다. timer_idle()이 그때까지만 잔다. 인터럽트는 꺼져 있어야
+   한다. */
+int64_t
+workqueue_next_wakeup (int64_t limit) {
+	int64_t n;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (list_empty (&delayed))
+		return limit;
+	n = list_entry (list_front (&delayed), struct work, elem)->expire
+		- timer_ticks ();
+	if (n < 1)
+		n = 1;
+	return n < limit ? n : limit;
+}
+
+/* 큐가 빌 때까지 높은 큐부터 work를 꺼내 부른다. pending은 부르기 전에
+   지우므로 work가 자기 자신을 다시 넣을 수 있다. */
+static void
+worker (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level;
+		struct work *w = NULL;
+		int prio;
+
+		sema_down (&queued);
+		old_level = intr_disable ();
+		for (prio = 0; prio < WQ_PRIO_CNT; prio++)
+			if (!list_empty (&queues[prio])) {
+				w = list_entry (list_pop_front (&queues[prio]), struct work, elem);
+				break;
+			}
+		ASSERT (w != NULL);
+		w->pending = false;
+		run_cnt[prio]++;
+		intr_set_level (old_level);
+
+		thread_set_priority (wq_priority[prio]);
+		w->func (w->aux);
+	}
+}
+
+static void
+bh_thread (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level;
+		struct work *w;
+
+		sema_down (&bh_queued);
+		old_level = intr_disable ();
+		w = list_entry (list_pop_front (&bh_list), struct work, elem);
+		w->pending = false;
+		bh_run_cnt++;
+		intr_set_level (old_level);
+
+		w->func (w->aux);
+	}
+}
+
+void
+workqueue_print_stats (void) {
+	printf ("Workqueue: %lld high, %lld normal, %lld low works, "
+			"%lld bottom halves\n", run_cnt[WQ_HIGH], run_cnt[WQ_NORMAL],
+			run_cnt[WQ_LOW], bh_run_cnt);
+}
@@ -0,0 +1,285 @@
+/* aio.c: Asynchronous file reads and writes. */
+
+#include "userprog/aio.h"
+#include <debug.h>
+#include <round.h>
+#include <syscall-nr.h>
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "userprog/usercopy.h"
+
+/*** GrilledSalmon ***/
+/* aio_read, aio_write는 요청을 work queue에 넣고 바로 돌아온다. kworker가
+ * file_read_at, file_write_at으로 buffer cache를 거쳐 읽고 쓰므로 worker 수만큼
+ * 디스크 요청이 한꺼번에 큐에 들어가고, 그동안 프로세스는 계속 돈다.
+ *
+ * worker는 다른 주소 공간에서 돌므로 유저 버퍼를 직접 쓰지 않는다. write는
+ * 보낼 때 커널 버퍼로 복사해 두고, read는 커널 버퍼에 읽어 두었다가 프로세스가
+ * aio_wait나 aio_return으로 끝난 것을 볼 때 유저 버퍼로 옮긴다.
+ *
+ * 요청은 leader의 aio_ctx에 slot 번호를 id로 해서 둔다. aio_return으로 거둘
+ * 때까지 slot을 쓴다. 프로세스가 끝나거나 exec 하면 남은 요청이 끝나기를
+ * 기다렸다가 모두 버린다. */
+
+struct aio_req {
+	struct work work;
+	struct aio_ctx *ctx;
+	struct file *file;          /* file_share로 잡은 참조. */
+	uint8_t *kbuf;
+	void *ubuf;
+	size_t size;
+	off_t ofs;
+	bool write;
+	bool done;                  /* worker가 끝냈다. ctx->lock이 보호한다. */
+	bool delivered;             /* 결과를 유저 버퍼와 rusage에 옮겼다. */
+	int result;
+};
+
+struct aio_ctx {
+	struct lock lock;
+	struct condition done;      /* 요청 하나가 끝났다. */
+	struct thread *owner;       /* leader. 디스크 I/O를 여기에 센다. */
+	int pending;                /* worker가 아직 끝내지 않은 요청 수. */
+	struct wait_queue pollers;  /* POLL_AIO를 poll 중인 스레드. */
+	struct aio_req *reqs[AIO_MAX];
+};
+
+/* 같은 프로세스의 user thread들이 ctx를 동시에 만들지 않게 한다. */
+static struct lock ctx_create_lock;
+
+static void aio_work (void *aux);
+
+void
+aio_init (void) {
+	lock_init (&ctx_create_lock);
+}
+
+/* 현재 프로세스의 ctx. 없으면 만들고, 메모리가 모자라면 NULL. */
+static struct aio_ctx *
+ctx_get (void) {
+	struct thread *leader = thread_current ()->leader;
+	struct aio_ctx *ctx;
+
+	lock_acquire (&ctx_create_lock);
+	ctx = leader->aio;
+	if (ctx == NULL && (ctx = calloc (1, sizeof *ctx)) != NULL) {
+		lock_init (&ctx->lock);
+		cond_init (&ctx->done);
+		wait_queue_init (&ctx->pollers);
+		ctx->owner = leader;
+		leader->aio = ctx;
+	}
+	lock_release (&ctx_create_lock);
+	return ctx;
+}
+
+static void
+req_free (struct aio_req *r) {
+	file_close (r->file);
+	free (r->kbuf);
+	free (r);
+}
+
+/* FILE의 OFS부터 SIZE 바이트를 UBUF로 읽거나 (WRITE면 UBUF를 쓰는) 요청을
+ * 넣고 id를 리턴한다. FILE은 inode가 있는 일반 파일이어야 한다. slot이 다
+ * 찼거나, SIZE가 AIO_SIZE_MAX보다 크거나, 메모리가 모자라면 -1. */
+int
+aio_submit (struct file *file, void *ubuf, size_t size, off_t ofs, bool write) {
+	struct aio_ctx *ctx = ctx_get ();
+	struct aio_req *r;
+	int id;
+
+	if (ctx == NULL || size > AIO_SIZE_MAX || ofs < 0)
+		return -1;
+	r = calloc (1, sizeof *r);
+	if (r == NULL)
+		return -1;
+	r->kbuf = malloc (size > 0 ? size : 1);
+	if (r->kbuf == NULL || (write && !copy_from_user (r->kbuf, ubuf, size))) {
+		free (r->kbuf);
+		free (r);
+		return -1;
+	}
+	r->ctx = ctx;
+	r->file = file_share (file);
+	r->ubuf = ubuf;
+	r->size = size;
+	r->ofs = ofs;
+	r->write = write;
+	work_init (&r->work, aio_work, r);
+
+	lock_acquire (&ctx->lock);
+	for (id = 0; id < AIO_MAX; id++)
+		if (ctx->reqs[id] == NULL)
+			break;
+	if (id == AIO_MAX) {
+		lock_release (&ctx->lock);
+		req_free (r);
+		return -1;
+	}
+	ctx->reqs[id] = r;
+	ctx->pending++;
+	lock_release (&ctx->lock);
+
+	work_queue (&r->work, WQ_NORMAL);
+	return id;
+}
+
+/* kworker에서 요청 하나를 실행한다. 디스크 요청은 보낸 프로세스에 센다. */
+static void
+aio_work (void *aux) {
+	struct aio_req *r = aux;
+	struct aio_ctx *ctx = r->ctx;
+	struct thread *t = thread_current ();
+	off_t ret;
+
+	t->io_owner = ctx->owner;
+	if (r->write)
+		ret = file_write_at (r->file, r->kbuf, r->size, r->ofs);
+	else
+		ret = file_read_at (r->file, r->kbuf, r->size, r->ofs);
+	t->io_owner = NULL;
+
+	lock_acquire (&ctx->lock);
+	r->result = ret;
+	r->done = true;
+	ctx->pending--;
+	cond_broadcast (&ctx->done, &ctx->lock);
+	wait_queue_wake (&ctx->pollers);
+	lock_release (&ctx->lock);
+}
+
+/* 끝난 요청 R의 결과를 한 번만 유저 버퍼와 rusage에 옮긴다. 유저 버퍼가
+ * 매핑되어 있지 않으면 결과를 -1로 한다. ctx->lock을 잡고 부른다. */
+static void
+deliver (struct aio_req *r) {
+	struct thread *t = thread_current ();
+
+	if (r->delivered)
+		return;
+	r->delivered = true;
+	if (r->result <= 0)
+		return;
+	if (!r->write && !copy_to_user (r->ubuf, r->kbuf, r->result)) {
+		r->result = -1;
+		return;
+	}
+	if (r->write)
+		t->rusage.wchar += r->result;
+	else
+		t->rusage.rchar += r->result;
+}
+
+/* 현재 프로세스의 ID번 요청. 없으면 NULL. */
+static struct aio_req *
+req_lookup (struct aio_ctx *ctx, int id) {
+	return ctx != NULL && id >= 0 && id < AIO_MAX ? ctx->reqs[id] : NULL;
+}
+
+/* IDS[0..N)의 요청 중 하나라도 끝날 때까지 TIMEOUT_MS ms 기다린다. 음수면
+ * 끝없이 기다리고 0이면 기다리지 않는다. 끝난 요청의 결과를 유저 버퍼에 옮기고
+ * 그 수를 리턴한다. 시간이 다 되면 0, 없는 id가 있으면 -1. */
+int
+aio_collect (const int *ids, int n, int timeout_ms) {
+	struct aio_ctx *ctx = thread_current ()->leader->aio;
+	int64_t deadline = timer_ticks ()
+		+ DIV_ROUND_UP ((int64_t) timeout_ms * TIMER_FREQ, 1000);
+	int done_cnt, i;
+
+	if (ctx == NULL)
+		return -1;
+	lock_acquire (&ctx->lock);
+	for (;;) {
+		done_cnt = 0;
+		for (i = 0; i < n; i++) {
+			struct aio_req *r = req_lookup (ctx, ids[i]);
+
+			if (r == NULL) {
+				lock_release (&ctx->lock);
+				return -1;
+			}
+			if (r->done) {
+				deliver (r);
+				done_cnt++;
+			}
+		}
+		if (done_cnt > 0 || timeout_ms == 0)
+			break;
+		if (timeout_ms < 0)
+			cond_wait (&ctx->done, &ctx->lock);
+		else if (timer_ticks () >= deadline)
+			break;
+		else
+			cond_wait_timeout (&ctx->done, &ctx->lock, deadline - timer_ticks ());
+	}
+	lock_release (&ctx->lock);
+	return done_cnt;
+}
+
+/* 끝난 ID번 요청을 거두고 읽거나 쓴 바이트 수를 리턴한다. id는 다시 쓰인다.
+ * 없는 id이거나 아직 끝나지 않았으면 -1. */
+int
+aio_reap (int id) {
+	struct aio_ctx *ctx = thread_current ()->leader->aio;
+	struct aio_req *r;
+	int result;
+
+	if (ctx == NULL)
+		return -1;
+	lock_acquire (&ctx->lock);
+	r = req_lookup (ctx, id);
+	if (r == NULL || !r->done) {
+		lock_release (&ctx->lock);
+		return -1;
+	}
+	deliver (r);
+	result = r->result;
+	ctx->reqs[id] = NULL;
+	lock_release (&ctx->lock);
+	req_free (r);
+	return result;
+}
+
+/* 끝났지만 aio_return으로 거두지 않은 요청이 있으면 POLLIN. E가 NULL이 아니면
+ * 먼저 E를 걸어 두어 요청이 끝날 때 SEMA가 올라가게 한다. */
+unsigned
+aio_poll (struct wait_entry *e, struct semaphore *sema) {
+	struct aio_ctx *ctx = ctx_get ();
+	unsigned ready = 0;
+	int i;
+
+	if (ctx == NULL)
+		return 0;
+	lock_acquire (&ctx->lock);
+	if (e != NULL)
+		wait_entry_add (&ctx->pollers, e, sema);
+	for (i = 0; i < AIO_MAX; i++)
+		if (ctx->reqs[i] != NULL && ctx->reqs[i]->done)
+			ready = POLLIN;
+	lock_release (&ctx->lock);
+	return ready;
+}
+
+/* LEADER의 요청이 모두 끝나기를 기다렸다가 ctx와 함께 버린다. 프로세스가
+ * 끝나거나 exec 할 때 leader가 부른다. */
+void
+aio_destroy (struct thread *leader) {
+	struct aio_ctx *ctx = leader->aio;
+	int i;
+
+	if (ctx == NULL)
+		return;
+	lock_acquire (&ctx->lock);
+	while (ctx->pending > 0)
+		cond_wait (&ctx->done, &ctx->lock);
+	lock_release (&ctx->lock);
+	for (i = 0; i < AIO_MAX; i++)
+		if (ctx->reqs[i] != NULL)
+			req_free (ctx->reqs[i]);
+	leader->aio = NULL;
+	free (ctx);
+}
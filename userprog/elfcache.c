@@ -0,0 +1,150 @@
+/* elfcache.c: Parsed ELF headers of recently executed programs. */
+
+#include "userprog/elfcache.h"
+#include <debug.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/*** GrilledSalmon ***/
+/* 같은 프로그램을 여러 번 exec하면 ELF header와 program header를 매번 다시
+ * 읽고 검증하게 된다. 한 번 검증한 결과를 inode마다 두고 다음 exec에서 그대로
+ * 쓴다. 파싱한 뒤 파일에 쓰기가 있었거나 파일이 지워졌으면 버린다.
+ *
+ * 캐시는 inode의 참조를 하나 들고 있어서 inode가 메모리에 남는다. 그래서 크기를
+ * ELF_CACHE_MAX로 묶고 power off 전에 elfcache_flush()로 모두 닫는다. */
+#define ELF_CACHE_MAX 8
+
+static struct list elf_cache;           /* 최근에 쓴 것이 앞. */
+static size_t elf_cache_cnt;
+static struct lock elf_cache_lock;
+
+void
+elfcache_init (void) {
+	list_init (&elf_cache);
+	lock_init (&elf_cache_lock);
+}
+
+/* INODE를 파싱한 결과를 담을, 세그먼트 SEG_CAP개짜리 elf_image를 만든다.
+ * 호출한 쪽이 하나의 참조를 가진다. 메모리가 모자라면 NULL. */
+struct elf_image *
+elfcache_alloc (struct inode *inode, int seg_cap) {
+	struct elf_image *img;
+
+	img = malloc (sizeof *img + seg_cap * sizeof img->segs[0]);
+	if (img == NULL)
+		return NULL;
+	img->inode = inode_reopen (inode);
+	img->write_gen = inode_write_gen (inode);
+	img->ref_cnt = 1;
+	img->entry = 0;
+	img->seg_cnt = 0;
+	return img;
+}
+
+/* IMG의 참조 하나를 놓는다. 마지막 참조였으면 inode를 닫고 해제한다. */
+void
+elfcache_release (struct elf_image *img) {
+	bool last;
+
+	if (img == NULL)
+		return;
+	lock_acquire (&elf_cache_lock);
+	last = --img->ref_cnt == 0;
+	lock_release (&elf_cache_lock);
+	if (last) {
+		inode_close (img->inode);
+		free (img);
+	}
+}
+
+/* 캐시에서 IMG를 뺀다. 캐시가 들고 있던 참조는 호출한 쪽이 놓는다. */
+static void
+evict (struct elf_image *img) {
+	ASSERT (lock_held_by_current_thread (&elf_cache_lock));
+	list_remove (&img->elem);
+	elf_cache_cnt--;
+}
+
+/* INODE의 캐시된 파싱 결과를 참조를 하나 늘려 돌려준다. 없거나 오래됐으면
+ * NULL. 지나가며 지워진 파일의 항목도 버린다. */
+struct elf_image *
+elfcache_get (struct inode *inode) {
+	struct elf_image *found = NULL;
+	struct elf_image *stale[ELF_CACHE_MAX];
+	size_t stale_cnt = 0, i;
+	struct list_elem *e, *next;
+
+	lock_acquire (&elf_cache_lock);
+	for (e = list_begin (&elf_cache); e != list_end (&elf_cache); e = next) {
+		struct elf_image *img = list_entry (e, struct elf_image, elem);
+
+		next = list_next (e);
+		if (inode_is_removed (img->inode)
+				|| inode_write_gen (img->inode) != img->write_gen) {
+			evict (img);
+			stale[stale_cnt++] = img;
+		} else if (img->inode == inode) {
+			/* LRU: 맨 앞으로 옮긴다. */
+			list_remove (e);
+			list_push_front (&elf_cache, e);
+			img->ref_cnt++;
+			found = img;
+		}
+	}
+	lock_release (&elf_cache_lock);
+
+	for (i = 0; i < stale_cnt; i++)
+		elfcache_release (stale[i]);
+	return found;
+}
+
+/* 새로 파싱한 IMG를 캐시에 넣는다. 호출한 쪽의 참조는 그대로 남는다.
+ * 같은 inode가 이미 있거나 (동시에 파싱한 경우) 가득 차면 오래된 것을 뺀다. */
+void
+elfcache_put (struct elf_image *img) {
+	struct elf_image *old = NULL, *dup = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&elf_cache_lock);
+	for (e = list_begin (&elf_cache); e != list_end (&elf_cache);
+			e = list_next (e)) {
+		struct elf_image *cur = list_entry (e, struct elf_image, elem);
+		if (cur->inode == img->inode) {
+			dup = cur;
+			break;
+		}
+	}
+	if (dup != NULL)
+		evict (dup);
+	else if (elf_cache_cnt >= ELF_CACHE_MAX)
+		old = list_entry (list_back (&elf_cache), struct elf_image, elem);
+	if (old != NULL)
+		evict (old);
+	img->ref_cnt++;
+	list_push_front (&elf_cache, &img->elem);
+	elf_cache_cnt++;
+	lock_release (&elf_cache_lock);
+
+	elfcache_release (dup);
+	elfcache_release (old);
+}
+
+/* 캐시를 비우고 들고 있던 inode를 모두 닫는다. filesys_done() 전에 불러야
+ * 실행 파일의 inode도 디스크에 쓰인다. */
+void
+elfcache_flush (void) {
+	while (true) {
+		struct elf_image *img;
+
+		lock_acquire (&elf_cache_lock);
+		if (list_empty (&elf_cache)) {
+			lock_release (&elf_cache_lock);
+			break;
+		}
+		img = list_entry (list_front (&elf_cache), struct elf_image, elem);
+		evict (img);
+		lock_release (&elf_cache_lock);
+		elfcache_release (img);
+	}
+}
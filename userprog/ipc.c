@@ -0,0 +1,214 @@
+/* ipc.c: Message channels between processes. */
+
+#include "userprog/ipc.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <string.h>
+#include <syscall-nr.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/usercopy.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/*** GrilledSalmon ***/
+/* channel은 메시지를 순서대로 쌓아 두는 queue다. pipe와 달리 send 한 번이
+ * 메시지 하나이고 recv 한 번이 메시지 하나를 통째로 꺼낸다.
+ *
+ * 메시지는 page 단위로 담는다. 보내는 버퍼가 page 경계에서 시작하면 한 page를
+ * 다 채우는 부분은 복사하지 않고 보내는 쪽 page의 frame을 carrier에 걸어 둔다
+ * (vm_carrier_create). 받는 버퍼도 page 경계에서 시작하면 받는 쪽 page를 그
+ * frame에 연결하므로 (vm_carrier_map) 몇 MB짜리 메시지도 PTE만 고쳐서 넘어간다.
+ * 보낸 쪽이 계속 그 page를 쓰면 COW로 나뉜다. 나머지 부분이나 anon이 아닌 page는
+ * 커널 page에 복사해 둔다.
+ *
+ * fork와 spawn으로 fd를 물려주면 같은 struct file을 같이 쓴다. 그 file이
+ * 닫히면 남은 메시지와 함께 channel을 푼다. */
+
+/* 한 channel에 쌓아 둘 수 있는 메시지 수. 더 보내면 자리가 날 때까지 기다린다. */
+#define IPC_QUEUE_MAX 16
+
+struct ipc_page {
+	uint8_t *kva;               /* 복사해 둔 커널 page. */
+	struct page *carrier;       /* 복사하지 않고 나르는 page. */
+};
+
+struct ipc_msg {
+	struct list_elem elem;
+	size_t size;
+	size_t page_cnt;
+	struct ipc_page pages[];
+};
+
+struct ipc_chan {
+	struct lock lock;
+	struct condition readable;  /* 메시지가 들어왔다. */
+	struct condition writable;  /* 자리가 났다. */
+	struct list msgs;
+	size_t msg_cnt;
+	size_t bytes;               /* 쌓인 메시지의 바이트 수. */
+	struct wait_queue pollers;  /* poll 중인 스레드. */
+};
+
+/* 빈 channel을 만든다. 메모리가 모자라면 NULL. */
+struct ipc_chan *
+ipc_create (void) {
+	struct ipc_chan *ch = calloc (1, sizeof *ch);
+
+	if (ch == NULL)
+		return NULL;
+	lock_init (&ch->lock);
+	cond_init (&ch->readable);
+	cond_init (&ch->writable);
+	list_init (&ch->msgs);
+	wait_queue_init (&ch->pollers);
+	return ch;
+}
+
+static void
+msg_free (struct ipc_msg *m) {
+	size_t i;
+
+	for (i = 0; i < m->page_cnt; i++) {
+		palloc_free_page (m->pages[i].kva);
+#ifdef VM
+		if (m->pages[i].carrier != NULL)
+			vm_carrier_free (m->pages[i].carrier);
+#endif
+	}
+	free (m);
+}
+
+/* UBUF의 SIZE 바이트를 메시지 하나로 보낸다. queue가 차 있으면 자리가 날 때까지
+ * 기다린다. SIZE를 리턴하고, SIZE가 CHAN_MSG_MAX보다 크거나 버퍼가 잘못되었거나
+ * 메모리가 모자라면 -1. */
+int
+ipc_send (struct ipc_chan *ch, const void *ubuf, size_t size) {
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	struct ipc_msg *m;
+	size_t i;
+
+	if (size > CHAN_MSG_MAX)
+		return -1;
+	m = calloc (1, sizeof *m + page_cnt * sizeof *m->pages);
+	if (m == NULL)
+		return -1;
+	m->size = size;
+	for (i = 0; i < page_cnt; i++) {
+		const uint8_t *src = (const uint8_t *) ubuf + i * PGSIZE;
+		size_t chunk = size - i * PGSIZE < PGSIZE ? size - i * PGSIZE : PGSIZE;
+
+		m->page_cnt = i + 1;
+#ifdef VM
+		if (pg_ofs (src) == 0 && chunk == PGSIZE
+				&& (m->pages[i].carrier = vm_carrier_create ((void *) src)) != NULL)
+			continue;
+#endif
+		m->pages[i].kva = palloc_get_page (0);
+		if (m->pages[i].kva == NULL || !copy_from_user (m->pages[i].kva, src, chunk)) {
+			msg_free (m);
+			return -1;
+		}
+	}
+
+	lock_acquire (&ch->lock);
+	while (ch->msg_cnt >= IPC_QUEUE_MAX)
+		cond_wait (&ch->writable, &ch->lock);
+	list_push_back (&ch->msgs, &m->elem);
+	ch->msg_cnt++;
+	ch->bytes += size;
+	cond_signal (&ch->readable, &ch->lock);
+	wait_queue_wake (&ch->pollers);
+	lock_release (&ch->lock);
+	return size;
+}
+
+/* 메시지 M의 IDX번 page에서 CHUNK 바이트를 유저 버퍼 DST로 옮긴다. 옮길 수
+ * 있으면 carrier의 frame을 그대로 매핑한다. */
+static bool
+page_deliver (struct ipc_msg *m, size_t idx, uint8_t *dst, size_t chunk) {
+	struct ipc_page *p = &m->pages[idx];
+
+	if (p->kva != NULL)
+		return copy_to_user (dst, p->kva, chunk);
+#ifdef VM
+	if (pg_ofs (dst) == 0 && chunk == PGSIZE && user_range_ok (dst, PGSIZE)
+			&& vm_carrier_map (p->carrier, dst)) {
+		p->carrier = NULL;
+		return true;
+	}
+	p->kva = palloc_get_page (0);
+	if (p->kva == NULL)
+		return false;
+	vm_carrier_read (p->carrier, p->kva);
+	return copy_to_user (dst, p->kva, chunk);
+#else
+	NOT_REACHED ();
+#endif
+}
+
+/* 가장 먼저 들어온 메시지를 꺼내 UBUF에 담는다. 비어 있으면 들어올 때까지
+ * 기다린다. 메시지가 SIZE보다 길면 나머지는 버린다. 담은 바이트 수를 리턴하고,
+ * 버퍼가 잘못되었으면 -1이다. 어느 쪽이든 메시지는 없어진다. */
+int
+ipc_recv (struct ipc_chan *ch, void *ubuf, size_t size) {
+	struct ipc_msg *m;
+	size_t done, n, i;
+
+	lock_acquire (&ch->lock);
+	while (list_empty (&ch->msgs))
+		cond_wait (&ch->readable, &ch->lock);
+	m = list_entry (list_pop_front (&ch->msgs), struct ipc_msg, elem);
+	ch->msg_cnt--;
+	ch->bytes -= m->size;
+	cond_signal (&ch->writable, &ch->lock);
+	wait_queue_wake (&ch->pollers);
+	lock_release (&ch->lock);
+
+	n = size < m->size ? size : m->size;
+	for (i = 0, done = 0; done < n; i++, done += PGSIZE) {
+		size_t chunk = n - done < PGSIZE ? n - done : PGSIZE;
+
+		if (!page_deliver (m, i, (uint8_t *) ubuf + done, chunk)) {
+			msg_free (m);
+			return -1;
+		}
+	}
+	msg_free (m);
+	return n;
+}
+
+/* 쌓여 있는 메시지의 바이트 수. */
+size_t
+ipc_pending (struct ipc_chan *ch) {
+	return ch->bytes;
+}
+
+/* 꺼낼 메시지가 있으면 POLLIN, 자리가 있으면 POLLOUT. E가 NULL이 아니면 먼저
+ * E를 걸어 두어 바뀔 때 SEMA가 올라가게 한다. */
+unsigned
+ipc_poll (struct ipc_chan *ch, struct wait_entry *e, struct semaphore *sema) {
+	unsigned ready = 0;
+
+	lock_acquire (&ch->lock);
+	if (e != NULL)
+		wait_entry_add (&ch->pollers, e, sema);
+	if (ch->msg_cnt > 0)
+		ready |= POLLIN;
+	if (ch->msg_cnt < IPC_QUEUE_MAX)
+		ready |= POLLOUT;
+	lock_release (&ch->lock);
+	return ready;
+}
+
+/* channel의 마지막 struct file이 닫혔다. 남은 메시지와 함께 푼다. */
+void
+ipc_close (struct ipc_chan *ch) {
+	while (!list_empty (&ch->msgs))
+		msg_free (list_entry (list_pop_front (&ch->msgs), struct ipc_msg, elem));
+	free (ch);
+}
@@ -0,0 +1,287 @@
+/* pipe.c: Pipes between processes. */
+
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <syscall-nr.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/usercopy.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/*** GrilledSalmon ***/
+/* pipe 하나는 커널 page PIPE_PAGES개를 이은 ring buffer다. write는 ring에
+ * 넣고 read는 ring에서 꺼내므로 보통은 두 번 복사한다.
+ *
+ * 큰 read가 빈 pipe를 기다릴 때는 자기 유저 버퍼를 pin 하고 pipe에 걸어 둔다.
+ * 그러면 다음 write는 ring을 거치지 않고 writer의 유저 버퍼에서 reader의 유저
+ * page로 바로 복사한다. 다른 주소 공간의 page는 pml4_get_page()로 찾은 커널
+ * 주소로 쓴다. */
+#define PIPE_PAGES 4
+#define PIPE_SIZE (PIPE_PAGES * PGSIZE)
+#define PIPE_DIRECT_MIN PGSIZE  /* 이만큼 읽는 read부터 버퍼를 걸어 둔다. */
+
+struct pipe {
+	struct lock lock;
+	struct condition readable;  /* 읽을 것이 생겼거나 writer가 모두 닫았다. */
+	struct condition writable;  /* ring에 빈 곳이 생겼거나 reader가 모두 닫았다. */
+	struct condition handed;    /* dr_thread의 버퍼가 채워졌거나 writer가 모두 닫았다. */
+	uint8_t *pages[PIPE_PAGES];
+	size_t head;                /* 다음에 읽을 ring offset. */
+	size_t cnt;                 /* ring에 있는 바이트 수. */
+	bool reader_open;
+	bool writer_open;
+
+	/* 바로 받으려고 기다리는 reader. 없으면 dr_thread가 NULL. */
+	struct thread *dr_thread;
+	uint8_t *dr_buf;            /* reader의 유저 버퍼. pin 되어 있다. */
+	size_t dr_size;
+	size_t dr_done;             /* writer가 dr_buf에 채운 바이트 수. */
+
+	struct wait_queue pollers;  /* poll 중인 스레드. 읽거나 쓸 수 있게 되면 깨운다. */
+};
+
+static void pipe_free (struct pipe *);
+
+/* pipe를 만들고 읽는 쪽과 쓰는 쪽 struct file을 *RD, *WR에 담는다. 메모리가
+ * 모자라면 false. */
+bool
+pipe_create (struct file **rd, struct file **wr) {
+	struct pipe *p = calloc (1, sizeof *p);
+
+	if (p == NULL)
+		return false;
+	lock_init (&p->lock);
+	cond_init (&p->readable);
+	cond_init (&p->writable);
+	cond_init (&p->handed);
+	wait_queue_init (&p->pollers);
+	p->reader_open = p->writer_open = true;
+	for (int i = 0; i < PIPE_PAGES; i++)
+		if ((p->pages[i] = palloc_get_page (0)) == NULL)
+			goto fail;
+
+	*rd = file_open_pipe (p, false);
+	if (*rd == NULL)
+		goto fail;
+	*wr = file_open_pipe (p, true);
+	if (*wr == NULL) {
+		/* 읽는 쪽을 닫으면 writer는 아직 열린 것으로 남으므로 직접 푼다. */
+		p->writer_open = false;
+		file_close (*rd);
+		return false;
+	}
+	return true;
+
+fail:
+	pipe_free (p);
+	return false;
+}
+
+static void
+pipe_free (struct pipe *p) {
+	for (int i = 0; i < PIPE_PAGES; i++)
+		palloc_free_page (p->pages[i]);
+	free (p);
+}
+
+/* ring의 offset OFS에서 시작해 page 경계나 LIMIT 바이트 중 먼저 오는 곳까지의
+ * 길이. */
+static size_t
+ring_chunk (size_t ofs, size_t limit) {
+	size_t left = PGSIZE - ofs % PGSIZE;
+	return left < limit ? left : limit;
+}
+
+static uint8_t *
+ring_addr (struct pipe *p, size_t ofs) {
+	ofs %= PIPE_SIZE;
+	return p->pages[ofs / PGSIZE] + ofs % PGSIZE;
+}
+
+/* writer의 유저 버퍼 UBUF에서 기다리는 reader의 버퍼로 최대 SIZE 바이트를
+ * 복사하고 복사한 수를 리턴한다. reader의 버퍼는 pin 되어 있으므로 page가
+ * 그 사이에 없어지지 않는다. */
+static size_t
+direct_copy (struct pipe *p, const uint8_t *ubuf, size_t size) {
+	size_t done = 0;
+
+	if (size > p->dr_size)
+		size = p->dr_size;
+	while (done < size) {
+		uint8_t *dst = p->dr_buf + done;
+		size_t chunk = PGSIZE - pg_ofs (dst);
+		uint8_t *kpage;
+
+		if (chunk > size - done)
+			chunk = size - done;
+		kpage = pml4_get_page (p->dr_thread->pml4, dst);
+		if (kpage == NULL || !copy_from_user (kpage, ubuf + done, chunk))
+			break;
+		done += chunk;
+	}
+	return done;
+}
+
+/* UBUF로 최대 SIZE 바이트를 읽는다. pipe가 비어 있으면 무언가 쓰일 때까지
+ * 기다린다. writer가 모두 닫혔으면 0, 유저 버퍼가 잘못되었으면 -1. */
+int
+pipe_read (struct pipe *p, void *ubuf, size_t size) {
+	bool pinned = false, fault = false;
+	size_t done = 0;
+
+	if (size == 0)
+		return 0;
+#ifdef VM
+	/* page fault가 pipe lock을 잡은 채로 나지 않게 lock 밖에서 pin 한다. */
+	if (size >= PIPE_DIRECT_MIN)
+		pinned = vm_pin_user (ubuf, size);
+#else
+	pinned = size >= PIPE_DIRECT_MIN;
+#endif
+
+	lock_acquire (&p->lock);
+	while (p->cnt == 0 && p->writer_open) {
+		if (pinned && p->dr_thread == NULL) {
+			p->dr_thread = thread_current ();
+			p->dr_buf = ubuf;
+			p->dr_size = size;
+			p->dr_done = 0;
+			while (p->dr_done == 0 && p->writer_open)
+				cond_wait (&p->handed, &p->lock);
+			done = p->dr_done;
+			p->dr_thread = NULL;
+			/* 자리가 비기를 기다리던 다른 reader를 깨운다. */
+			cond_broadcast (&p->readable, &p->lock);
+			goto out;
+		}
+		cond_wait (&p->readable, &p->lock);
+	}
+
+	while (done < size && p->cnt > 0) {
+		size_t chunk = ring_chunk (p->head, size - done < p->cnt ? size - done : p->cnt);
+
+		if (!copy_to_user ((uint8_t *) ubuf + done, ring_addr (p, p->head), chunk)) {
+			fault = true;
+			break;
+		}
+		p->head = (p->head + chunk) % PIPE_SIZE;
+		p->cnt -= chunk;
+		done += chunk;
+	}
+	if (done > 0) {
+		cond_broadcast (&p->writable, &p->lock);
+		wait_queue_wake (&p->pollers);
+	}
+
+out:
+	lock_release (&p->lock);
+#ifdef VM
+	if (pinned)
+		vm_unpin_user (ubuf, size);
+#endif
+	return fault && done == 0 ? -1 : (int) done;
+}
+
+/* UBUF의 SIZE 바이트를 모두 쓸 때까지 기다리며 쓴다. 기다리는 reader가
+ * 있고 ring이 비었으면 그 reader의 버퍼로 바로 복사한다. 쓴 바이트 수를
+ * 리턴하고, 하나도 쓰지 못했는데 reader가 모두 닫혔거나 버퍼가 잘못되었으면
+ * -1. */
+int
+pipe_write (struct pipe *p, const void *ubuf, size_t size) {
+	const uint8_t *src = ubuf;
+	size_t done = 0;
+
+	lock_acquire (&p->lock);
+	while (done < size && p->reader_open) {
+		size_t n;
+
+		if (p->dr_thread != NULL && p->dr_done == 0 && p->cnt == 0) {
+			n = direct_copy (p, src + done, size - done);
+			if (n == 0)
+				break;
+			p->dr_done = n;
+			done += n;
+			/* handed에서는 dr_thread만 기다린다. lock을 놓을 때 그 reader로 바로
+			   넘어가 IPC 왕복을 줄인다. */
+			cond_signal_handoff (&p->handed, &p->lock);
+			continue;
+		}
+		if (p->cnt == PIPE_SIZE) {
+			cond_wait (&p->writable, &p->lock);
+			continue;
+		}
+
+		n = ring_chunk (p->head + p->cnt, PIPE_SIZE - p->cnt);
+		if (n > size - done)
+			n = size - done;
+		if (!copy_from_user (ring_addr (p, p->head + p->cnt), src + done, n))
+			break;
+		p->cnt += n;
+		done += n;
+		cond_broadcast (&p->readable, &p->lock);
+		wait_queue_wake (&p->pollers);
+	}
+	lock_release (&p->lock);
+	return done > 0 || size == 0 ? (int) done : -1;
+}
+
+/* 지금 읽을 수 있는 바이트 수. */
+size_t
+pipe_available (struct pipe *p) {
+	return p->cnt;
+}
+
+/* pipe의 쓰는 쪽(WRITE_END) 또는 읽는 쪽에서 지금 할 수 있는 일을 POLLIN,
+ * POLLOUT, POLLHUP으로 리턴한다. E가 NULL이 아니면 먼저 E를 걸어 두어 바뀔 때
+ * SEMA가 올라가게 한다. 반대쪽이 모두 닫혔으면 읽기는 0을, 쓰기는 -1을 바로
+ * 돌려주므로 그것도 할 수 있는 일로 친다. */
+unsigned
+pipe_poll (struct pipe *p, bool write_end, struct wait_entry *e,
+		struct semaphore *sema) {
+	unsigned ready = 0;
+
+	lock_acquire (&p->lock);
+	if (e != NULL)
+		wait_entry_add (&p->pollers, e, sema);
+	if (write_end) {
+		if (!p->reader_open)
+			ready |= POLLOUT | POLLHUP;
+		else if (p->cnt < PIPE_SIZE)
+			ready |= POLLOUT;
+	} else {
+		if (!p->writer_open)
+			ready |= POLLIN | POLLHUP;
+		else if (p->cnt > 0)
+			ready |= POLLIN;
+	}
+	lock_release (&p->lock);
+	return ready;
+}
+
+/* pipe의 쓰는 쪽(WRITE_END) 또는 읽는 쪽의 마지막 struct file이 닫혔다.
+ * 기다리는 쪽을 깨우고, 양쪽이 모두 닫혔으면 pipe를 푼다. */
+void
+pipe_close (struct pipe *p, bool write_end) {
+	bool dead;
+
+	lock_acquire (&p->lock);
+	if (write_end)
+		p->writer_open = false;
+	else
+		p->reader_open = false;
+	cond_broadcast (&p->readable, &p->lock);
+	cond_broadcast (&p->writable, &p->lock);
+	cond_broadcast (&p->handed, &p->lock);
+	wait_queue_wake (&p->pollers);
+	dead = !p->reader_open && !p->writer_open;
+	lock_release (&p->lock);
+	if (dead)
+		pipe_free (p);
+}
@@ -5,30 +5,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <syscall-nr.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "userprog/sysprof.h"
+#include "userprog/aio.h"
+#include "userprog/usercopy.h"
+#include "userprog/elfcache.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
 
 static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
+static bool process_load (char *file_name, const char *env,
+		struct intr_frame *_if);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void __do_spawn (void *);
+static void __do_uthread (void *);
+static void uthread_reap_all (struct thread *leader);
+static bool duplicate_fdt (struct thread *parent);
+
+bool process_print_io;
+
+/* 새 프로세스의 시작 스택을 만들 커널 page. build_args()가 채운다. */
+struct arg_block {
+	uint8_t *page;
+	size_t str_len;             /* page 끝에서부터 쓴 문자열의 바이트 수. */
+	size_t ptr_cnt;             /* page 앞에서부터 쓴 포인터 수. */
+	size_t size;                /* 완성된 블록의 바이트 수. */
+	int argc;
+};
 
-static void argument_stack(struct intr_frame *if_, int argv_cnt, char **argv_list);
+static bool build_args (struct arg_block *, char *cmd_line, const char *env);
 
 /* General process initializer for initd and other process. */
 static void
@@ -91,14 +118,106 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	if (tid == TID_ERROR)
 		return TID_ERROR;
 
-	struct thread *child = get_child_with_pid(tid);
-	sema_down(&child->fork_sema); // wait until child loads
-	if (child->exit_status == -1)
+	struct child *child = get_child_with_pid(tid);
+	sema_down(&child->loaded); // wait until child loads
+	if (child->load_failed) {
+		int status;
+
+		process_waitpid (tid, &status);	/* 실패한 자식은 바로 거둔다. */
 		return TID_ERROR;
+	}
 
 	return tid;
 }
 
+/*** GrilledSalmon ***/
+/* spawn이 자식에게 넘기는 것. 부모의 스택에 있으므로 자식은 loaded를
+   올린 뒤에는 건드리지 않는다. */
+struct spawn_aux {
+	struct thread *parent;
+	char *cmd_line;                         /* palloc 받은 page */
+	const struct spawn_action *actions;
+	int action_cnt;
+};
+
+/* CMD_LINE을 실행하는 자식 프로세스를 만들고 그 tid를 리턴한다. fork처럼
+ * 주소 공간을 복사하지 않고 fd table만 물려준 다음 ACTIONS를 자식의 fd table에
+ * 차례로 적용하고 바로 프로그램을 읽어 들인다. 자식이 프로그램을 읽어 들일
+ * 때까지 기다리며, 실패하면 TID_ERROR. CMD_LINE page는 자식이 돌려준다. */
+tid_t
+process_spawn (char *cmd_line, const struct spawn_action *actions,
+		int action_cnt) {
+	struct spawn_aux aux = { thread_current ()->leader, cmd_line, actions,
+		action_cnt };
+	char name[16], *save_ptr;
+
+	strlcpy (name, cmd_line, sizeof name);
+	strtok_r (name, " ", &save_ptr);
+
+	tid_t tid = thread_create (name, PRI_DEFAULT, __do_spawn, &aux);
+	if (tid == TID_ERROR) {
+		palloc_free_page (cmd_line);
+		return TID_ERROR;
+	}
+
+	struct child *child = get_child_with_pid (tid);
+	sema_down (&child->loaded);
+	if (child->load_failed) {
+		int status;
+
+		process_waitpid (tid, &status);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* spawn의 ACTION 하나를 지금 스레드의 fd table에 적용한다. */
+static bool
+apply_spawn_action (const struct spawn_action *action) {
+	switch (action->op) {
+		case SPAWN_CLOSE:
+			if (fdt_next (thread_current (), action->fd) != action->fd)
+				return false;
+			close (action->fd);
+			return true;
+		case SPAWN_DUP2:
+			return dup2 (action->fd, action->newfd) == action->newfd;
+		default:
+			return false;
+	}
+}
+
+/* process_spawn이 만든 스레드. 부모의 fd table만 복제하고 프로그램을 읽는다. */
+static void
+__do_spawn (void *aux_) {
+	struct spawn_aux *aux = aux_;
+	struct thread *current = thread_current ();
+	struct intr_frame if_;
+	bool success;
+
+#ifdef VM
+	supplemental_page_table_init (&current->spt);
+#endif
+	process_init ();
+
+	success = duplicate_fdt (aux->parent);
+	for (int i = 0; success && i < aux->action_cnt; i++)
+		success = apply_spawn_action (&aux->actions[i]);
+	if (success)
+		success = process_load (aux->cmd_line, NULL, &if_);
+	else
+		palloc_free_page (aux->cmd_line);
+
+	if (!success) {
+		current->child->load_failed = true;
+		sema_up (&current->child->loaded);
+		exit (TID_ERROR);
+	}
+	sema_up (&current->child->loaded);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
 #ifndef VM
 /* Duplicate the parent's address space by passing this function to the
  * pml4_for_each. This is only for the project 2. */
@@ -115,6 +234,9 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	{
 		return true;
 	}
+	/* 시계 page 같은 같이 쓰는 page는 자식이 따로 매핑한다. */
+	if (*pte & PTE_SHARED)
+		return true;
 	/* 2. Resolve VA from the parent's page map level 4. */
 	parent_page = pml4_get_page (parent->pml4, va);
 
@@ -139,7 +261,7 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	/* 4. TODO: Duplicate parent's page to the new page and
 	 *    TODO: check whether parent's page is writable or not (set WRITABLE
 	 *    TODO: according to the result). */
-	memcpy(newpage,parent_page, PGSIZE);
+	copy_page(newpage, parent_page);
 	writable = is_writable(pte);
 	/* 5. Add new page to child's page table at address VA with WRITABLE
 	 *    permission. */
@@ -149,15 +271,64 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	}
 	return true;
 }
+
+/*** GrilledSalmon ***/
+/* pml4_for_each_run()이 넘기는 이어진 PTE 묶음을 duplicate_pte()로 복사한다. */
+static bool
+duplicate_pte_run (uint64_t *pte, void *va, size_t cnt, void *aux) {
+	for (size_t i = 0; i < cnt; i++)
+		if (!duplicate_pte (pte + i, va + i * PGSIZE, aux))
+			return false;
+	return true;
+}
 #endif
 
-struct MapElem
-{
-	/* key - parent's struct file */
-	uintptr_t key;
-	/* value - child's newly created struct file */
-	uintptr_t value;
-};
+/*** GrilledSalmon ***/
+/* timer의 시계 page를 T의 주소 공간 CLOCK_PAGE에 읽기 전용으로 매핑한다. 모든
+ * 프로세스가 page 하나를 같이 쓰므로 PTE_SHARED로 두어 pml4_destroy()가 돌려주지
+ * 않게 한다. */
+static bool
+map_clock_page (struct thread *t) {
+	void *kpage = timer_clock_page ();
+
+	ASSERT (pg_ofs (CLOCK_PAGE) == 0 && is_user_vaddr (CLOCK_PAGE));
+	return kpage == NULL
+		|| pml4_map (t->pml4, (uint64_t) CLOCK_PAGE, vtop (kpage),
+				PTE_P | PTE_U | PTE_SHARED);
+}
+
+/*** GrilledSalmon ***/
+/* PARENT의 fd table을 지금 스레드로 복제한다. fork와 spawn이 같이 쓴다.
+ * struct file은 복사하지 않고 참조만 늘려 같이 쓰므로 dup2로 같은 파일을
+ * 가리키던 fd들은 자식에서도 그대로 같은 파일을 가리킨다. file position은
+ * 따로 움직여야 하니 owner를 지워서 먼저 옮기는 쪽이 복사하게 한다(own_file). */
+static bool
+duplicate_fdt (struct thread *parent) {
+	struct thread *current = thread_current ();
+
+	if (!fdt_reserve(current, parent->fdCap))
+		return false;
+
+	/* 부모가 닫은 0, 1번은 비워 둔다. */
+	fdt_set(current, 0, NULL);
+	fdt_set(current, 1, NULL);
+	current->stdin_count = parent->stdin_count;
+	current->stdout_count = parent->stdout_count;
+
+	/* 부모의 fdTable에서 열린 fd만 순회 */
+	for (int i = fdt_next(parent, 0); i >= 0; i = fdt_next(parent, i + 1))
+	{
+		struct file *file = parent->fdTable[i];
+
+		// 1 STDIN, 2 STDOUT
+		if (file > 2) {
+			file->owner = 0;
+			file_share(file);
+		}
+		fdt_set(current, i, file);
+	}
+	return true;
+}
 
 /* A thread function that copies parent's execution context.
  * Hint) parent->tf does not hold the userland context of the process.
@@ -167,8 +338,10 @@ static void
 __do_fork (void *aux) {
 	struct intr_frame if_;
 
-	/* process_fork에서 전달받은 스레드 */
-	struct thread *parent = (struct thread *) aux;
+	/* process_fork를 부른 스레드와 그 프로세스의 leader. intr_frame과 FPU는
+	 * 부른 스레드의 것을, 주소 공간과 fd table은 leader의 것을 복제한다. */
+	struct thread *caller = (struct thread *) aux;
+	struct thread *parent = caller->leader;
 	/* process_fork에서 생성한 스레드 */
 	struct thread *current = thread_current ();
 
@@ -177,7 +350,7 @@ __do_fork (void *aux) {
 	bool succ = true;
 
 	/* process_fork에서 복사 해두었던 intr_frame */
-	parent_if = &parent->parent_if;
+	parent_if = &caller->parent_if;
 
 	/* 1. Read the cpu context to local stack. */
 
@@ -192,12 +365,16 @@ __do_fork (void *aux) {
 		goto error;
 
 	process_activate (current);
+	if (!map_clock_page (current))
+		goto error;
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
 		goto error;
 #else
-	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
+	/* user 영역의 page table만 훑는다. */
+	if (!pml4_for_each_run (parent->pml4, NULL, (void *) KERN_BASE,
+				duplicate_pte_run, parent))
 		goto error;
 #endif
 
@@ -206,157 +383,320 @@ __do_fork (void *aux) {
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
-	if (parent->fdIdx == FDCOUNT_LIMIT)
+	current->running = file_share(parent->running);		/*** GrilledSalmon & half Dong***/
+#ifdef VM
+	current->heap_start = parent->heap_start;
+	current->brk = parent->brk;
+	current->rss_limit = parent->rss_limit;
+#endif
+	if (!duplicate_fdt(parent))
+		goto error;
+	if (!fpu_copy (current, caller))
 		goto error;
 
-	/* Project2-extra) multiple fds sharing same file - use associative map
-	(e.g. dict, hashmap) to duplicate these relationships
-	other test-cases like multi-oom don't need this feature */
-	const int MAPLEN = 10;
-	struct MapElem map[10];
+	sema_up(&current->child->loaded);
+	/* Finally, switch to the newly created process. */
+	if (succ)
+		do_iret (&if_);
+error:
+	current->child->load_failed = true;
+	sema_up(&current->child->loaded);
+	exit(TID_ERROR);
+	// thread_exit ();
+}
 
-	current->running = file_duplicate(parent->running);		/*** GrilledSalmon & half Dong***/
+/*** GrilledSalmon ***/
+/* uthread_create가 새 스레드에게 넘기는 것. 부르는 쪽의 스택에 있으므로 새
+ * 스레드는 started를 올린 뒤에는 건드리지 않는다. */
+struct uthread_aux {
+	struct thread *leader;
+	struct intr_frame if_;
+	struct semaphore started;
+	bool success;
+};
 
-	/* index for filling map */
-	int dupCount = 0;
+/* 지금 프로세스의 주소 공간과 fd table을 나누어 쓰는 user thread를 만들고 그
+ * tid를 리턴한다. 새 스레드는 유저 모드의 ENTRY에서 ARG1, ARG2를 인자로, STACK
+ * 아래를 스택으로 삼아 시작한다. 프로세스가 끝나는 중이면 TID_ERROR. */
+tid_t
+process_uthread_create (void *entry, void *arg1, void *arg2, void *stack) {
+	struct thread *leader = thread_current ()->leader;
+	struct uthread_aux aux;
+	tid_t tid;
 
-	/* fdTable을 순회 */
-	for (int i = 0; i < FDCOUNT_LIMIT; i++)
-	{
-		struct file *file = parent->fdTable[i];
-		if (file == NULL)
-			continue;
+	aux.leader = leader;
+	memset (&aux.if_, 0, sizeof aux.if_);
+	aux.if_.rip = (uintptr_t) entry;
+	aux.if_.R.rdi = (uint64_t) arg1;
+	aux.if_.R.rsi = (uint64_t) arg2;
+	/* 함수 입구에서처럼 return address 자리를 뺀 16바이트 정렬 */
+	aux.if_.rsp = ((uintptr_t) stack & ~(uintptr_t) 0xf) - sizeof (void *);
+	aux.if_.ds = aux.if_.es = aux.if_.ss = SEL_UDSEG;
+	aux.if_.cs = SEL_UCSEG;
+	aux.if_.eflags = FLAG_IF | FLAG_MBS;
+	sema_init (&aux.started, 0);
+
+	tid = thread_create (leader->name, PRI_DEFAULT, __do_uthread, &aux);
+	if (tid == TID_ERROR)
+		return TID_ERROR;
+	sema_down (&aux.started);
+	if (!aux.success) {
+		int status;
 
-		/* Project2-extra) linear search on key-pair array
-		If 'file' is already duplicated in child, don't duplicate again but share it */
-		bool found = false;
-		for (int j = 0; j < MAPLEN; j++)
-		{
-			if (map[j].key == file)
-			{
-				found = true;
-				current->fdTable[i] = map[j].value;
-				break;
-			}
-		}
-		if (!found)
-		{
-			struct file *new_file;
-			if (file > 2)
-				new_file = file_duplicate(file);
-			else
-				 // 1 STDIN, 2 STDOUT
-				new_file = file;
-
-			current->fdTable[i] = new_file;
-			if (dupCount < MAPLEN)
-			{
-				map[dupCount].key = file;
-				map[dupCount++].value = new_file;
-			}
-		}
+		process_uthread_join (tid, &status);
+		return TID_ERROR;
 	}
+	return tid;
+}
 
+/* user thread로 시작한다. 자기 기록을 leader의 child_list에서 uthread_list로
+ * 옮기고 leader의 page table로 들어간다. */
+static void
+__do_uthread (void *aux_) {
+	struct uthread_aux *aux = aux_;
+	struct thread *current = thread_current ();
+	struct thread *leader = aux->leader;
+	struct intr_frame if_ = aux->if_;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	aux->success = !leader->exiting;
+	current->child->uthread = true;
+	list_remove (&current->child->elem);
+	list_push_back (&leader->uthread_list, &current->child->elem);
+	current->leader = leader;
+	current->pml4 = leader->pml4;
+	process_activate (current);
+	intr_set_level (old_level);
 
-	current->fdIdx = parent->fdIdx;
-	sema_up(&current->fork_sema);
-	/* Finally, switch to the newly created process. */
-	if (succ)
-		do_iret (&if_);
-error:
-	current -> exit_status = TID_ERROR;
-	sema_up(&current->fork_sema);
-	exit(TID_ERROR);
-	// thread_exit ();
+	if (!aux->success) {
+		sema_up (&aux->started);
+		thread_exit ();
+	}
+	sema_up (&aux->started);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* 같은 프로세스의 user thread TID가 끝나기를 기다려 종료 상태를 *STATUS에
+ * 넣는다. TID가 이 프로세스의 user thread가 아니거나 나 자신이거나 이미 거두었으면
+ * false. 여러 스레드가 같은 TID를 기다리면 모두 깨어나고 하나만 기록을 놓는다. */
+bool
+process_uthread_join (tid_t tid, int *status) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	struct child *c;
+	bool reap;
+
+	old_level = intr_disable ();
+	c = child_find (tid);
+	if (c == NULL || !c->uthread || c->parent != cur->leader
+			|| c->thread == cur) {
+		intr_set_level (old_level);
+		return false;
+	}
+	c->ref_cnt++;		/* 기다리는 동안 기록이 풀리지 않게 */
+	intr_set_level (old_level);
+
+	/* exited를 다시 올려 두어 같이 기다리는 스레드도 깨어나게 한다. */
+	sema_down (&c->exited);
+	sema_up (&c->exited);
+	*status = c->exit_status;
+
+	old_level = intr_disable ();
+	reap = c->parent != NULL;
+	if (reap) {
+		list_remove (&c->elem);
+		c->parent = NULL;
+	}
+	intr_set_level (old_level);
+	if (reap)
+		child_put (c);
+	child_put (c);
+	return reap;
+}
+
+/* 끝나는 LEADER가 자기 user thread들이 모두 끝나기를 기다려 거둔다. exiting을
+ * 켜므로 user thread들은 다음 system call에서 끝난다. */
+static void
+uthread_reap_all (struct thread *leader) {
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	leader->exiting = true;
+	while (!list_empty (&leader->uthread_list)) {
+		struct child *c = list_entry (list_pop_front (&leader->uthread_list),
+				struct child, elem);
+
+		c->parent = NULL;
+		intr_set_level (old_level);
+		sema_down (&c->exited);
+		sema_up (&c->exited);
+		child_put (c);
+		old_level = intr_disable ();
+	}
+	intr_set_level (old_level);
 }
 
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int
 process_exec (void *f_name) {
-	char *file_name = f_name;
-	bool success;
+	return process_execve (f_name, NULL);
+}
 
+/*** GrilledSalmon ***/
+/* process_exec()와 같지만 새 프로그램에 환경 변수 ENV를 넘긴다. ENV는 CMD_LINE과
+ * 같은 page 안에 있는 "NAME=value" 문자열들로, 빈 문자열로 끝난다. NULL이면
+ * 환경 변수가 없다. */
+int
+process_execve (char *cmd_line, const char *env) {
 	/* We cannot use the intr_frame in the thread structure.
 	 * This is because when current thread rescheduled,
 	 * it stores the execution information to the member. */
 	struct intr_frame _if;
-	_if.ds = _if.es = _if.ss = SEL_UDSEG;
-	_if.cs = SEL_UCSEG;
-	_if.eflags = FLAG_IF | FLAG_MBS;
+
+	if (!process_load (cmd_line, env, &_if))
+		return -1;
+
+	/* Start switched process. */
+	do_iret (&_if);
+	NOT_REACHED ();
+}
+
+#ifdef VM
+/*** GrilledSalmon ***/
+/* 환경 변수 STACK_RESERVE=KB로 프로세스가 처음부터 쓸 stack 크기를, RSS_LIMIT=KB로
+ * 메모리에 둘 page 수의 한도를 알려 줄 수 있다. ENV에서 KEY("NAME=")의 값을 page
+ * 수로 바꿔 리턴한다. 없으면 0이다. */
+static size_t
+env_kb_pages (const char *env, const char *key) {
+	size_t len = strlen (key);
+	int kb;
+
+	for (; env != NULL && *env != '\0'; env += strlen (env) + 1)
+		if (strlen (env) >= len && !memcmp (env, key, len)) {
+			kb = atoi (env + len);
+			return kb > 0 ? DIV_ROUND_UP ((size_t) kb * 1024, PGSIZE) : 0;
+		}
+	return 0;
+}
+#endif
+
+/*** GrilledSalmon ***/
+/* 지금 스레드의 주소 공간을 버리고 FILE_NAME(명령어와 인자)의 프로그램을 읽어
+ * 들여 _IF를 그 프로그램의 시작 상태로 채운다. FILE_NAME은 palloc 받은 page로,
+ * 성공하든 실패하든 여기서 돌려준다. */
+static bool
+process_load (char *file_name, const char *env, struct intr_frame *_if) {
+	struct arg_block ab;
+	bool success = false;
+
+	_if->ds = _if->es = _if->ss = SEL_UDSEG;
+	_if->cs = SEL_UCSEG;
+	_if->eflags = FLAG_IF | FLAG_MBS;
+
+	/* 시작 스택을 먼저 커널 page에 만든다. strtok_r가 FILE_NAME을 첫 토큰으로
+	 * 잘라 두므로 load()에는 FILE_NAME을 그대로 넘긴다. */
+	ab.page = palloc_get_page (0);
+	if (ab.page == NULL || !build_args (&ab, file_name, env))
+		goto done;
 
 	/* We first kill the current context */
+	aio_destroy (thread_current ());
 	process_cleanup ();
+	fpu_release (thread_current ());
 
 	#ifdef VM
 	supplemental_page_table_init (&thread_current()->spt);
 	#endif
 
-	/* argument parsing */
-	char *argv[30];
-	int argc = 0;
-
-	char *token, *save_ptr;
-	token = strtok_r(file_name, " ", &save_ptr);
-	while (token != NULL)
-	{
-		/* 공백 기준으로 명령어 나누어 리스트로 조합 */
-		argv[argc] = token;
-		token = strtok_r(NULL, " ", &save_ptr);
-		argc++;
-	}
-
 	/* And then load the binary */
-	success = load (file_name, &_if);
-
-	/* If load failed, quit. */
-	if (!success)
-	{
-		palloc_free_page(file_name);
-		return -1;
-	}
+	if (!load (file_name, _if))
+		goto done;
+#ifdef VM
+	/* RSS limit는 fork와 exec를 지나도 남는다. RSS_LIMIT가 있으면 새로 정한다. */
+	size_t rss_limit = env_kb_pages (env, "RSS_LIMIT=");
+	if (rss_limit > 0)
+		thread_current ()->rss_limit = rss_limit;
+	vm_stack_reserve (env_kb_pages (env, "STACK_RESERVE="));
+#endif
 
-	argument_stack(&_if, argc, argv);
+	/* 만든 블록을 유저 스택 꼭대기로 한 번에 복사한다. */
+	ASSERT (_if->rsp == USER_STACK);
+	_if->rsp = USER_STACK - ab.size;
+	memcpy ((void *) _if->rsp, ab.page + PGSIZE - ab.size, ab.size);
+	_if->R.rdi = ab.argc;
+	_if->R.rsi = _if->rsp + sizeof (uint64_t);
+	_if->R.rdx = _if->rsp + (ab.argc + 2) * sizeof (uint64_t);
+	success = true;
 
-	// hex_dump(_if.rsp, _if.rsp, USER_STACK - (uint64_t)*rspp, true);
+done:
+	palloc_free_page (ab.page);
+	/* 인자는 유저 스택으로 복사했다. */
+	palloc_free_page (file_name);
+	return success;
+}
 
-	/* Start switched process. */
-	do_iret (&_if);
-	NOT_REACHED ();
+/*** GrilledSalmon ***/
+/* AB->PAGE에 포인터를 하나 더 쓴다. 문자열과 겹치면 false. */
+static bool
+push_arg_ptr (struct arg_block *ab, uint64_t ptr) {
+	if ((ab->ptr_cnt + 1) * sizeof ptr + ab->str_len > PGSIZE)
+		return false;
+	((uint64_t *) ab->page)[ab->ptr_cnt++] = ptr;
+	return true;
 }
 
-static void argument_stack(struct intr_frame *if_, int argv_cnt, char **argv_list) {
-	int i;
-	char *argu_addr[128];
-	int argc_len;
+/* 문자열 S를 AB->PAGE의 문자열 영역 아래에 붙이고 그 유저 주소를 포인터로 쓴다. */
+static bool
+push_arg_str (struct arg_block *ab, const char *s) {
+	size_t len = strlen (s) + 1;
 
-	for (i = argv_cnt-1; i >= 0; i--){
-		argc_len = strlen(argv_list[i]);
-		if_->rsp = if_->rsp - (argc_len+1);
-		memcpy(if_->rsp, argv_list[i], (argc_len+1));
-		argu_addr[i] = if_->rsp;
-	}
+	if (ab->ptr_cnt * sizeof (uint64_t) + ab->str_len + len > PGSIZE)
+		return false;
+	ab->str_len += len;
+	memcpy (ab->page + PGSIZE - ab->str_len, s, len);
+	return push_arg_ptr (ab, USER_STACK - ab->str_len);
+}
 
-	while (if_->rsp%8 != 0){
-		if_->rsp--;
-		memset(if_->rsp, 0, sizeof(uint8_t));
-	}
+/* CMD_LINE을 공백으로 나눈 인자와 ENV의 환경 변수로 새 프로세스의 시작 스택을
+ * AB->PAGE에 만든다. page의 끝이 USER_STACK에 온다고 보고 위에서부터 문자열을,
+ * 아래에서부터 가짜 리턴 주소, argv[], NULL, envp[], NULL을 한 번에 채운 뒤
+ * 포인터들을 8바이트로 맞춘 문자열 바로 밑으로 옮긴다. 완성된 블록은
+ * AB->PAGE의 끝 AB->SIZE 바이트다. 한 page에 다 들어가지 않으면 false. */
+static bool
+build_args (struct arg_block *ab, char *cmd_line, const char *env) {
+	char *token, *save_ptr;
+	size_t str_area, ptr_bytes;
 
-	for (i = argv_cnt; i>=0; i--){
-		if_->rsp = if_->rsp - 8;
-		if (i == argv_cnt){
-			memset(if_->rsp, 0, sizeof(char **)); // 왜 넣어줘야하지? 이유 알아보기
-		}else{
-			memcpy(if_->rsp, &argu_addr[i] , sizeof(char **));
-		}
+	ab->str_len = 0;
+	ab->ptr_cnt = 0;
+	ab->argc = 0;
+	if (!push_arg_ptr (ab, 0))
+		return false;
+	for (token = strtok_r (cmd_line, " ", &save_ptr); token != NULL;
+			token = strtok_r (NULL, " ", &save_ptr)) {
+		if (!push_arg_str (ab, token))
+			return false;
+		ab->argc++;
 	}
+	if (!push_arg_ptr (ab, 0))
+		return false;
+	for (; env != NULL && *env != '\0'; env += strlen (env) + 1)
+		if (!push_arg_str (ab, env))
+			return false;
+	if (!push_arg_ptr (ab, 0))
+		return false;
 
-	if_->rsp = if_->rsp - 8;
-	memset(if_->rsp, 0, sizeof(void *));
-
-	if_->R.rdi = argv_cnt;		//
-	if_->R.rsi = if_->rsp + 8;	// 다시 위로 올라옴 리턴 주소 바로 위로 argv
-
+	str_area = ROUND_UP (ab->str_len, sizeof (uint64_t));
+	ptr_bytes = ab->ptr_cnt * sizeof (uint64_t);
+	ab->size = str_area + ptr_bytes;
+	if (ab->size > PGSIZE)
+		return false;
+	memmove (ab->page + PGSIZE - ab->size, ab->page, ptr_bytes);
+	memset (ab->page + PGSIZE - str_area, 0, str_area - ab->str_len);
+	return true;
 }
 
 
@@ -374,26 +714,58 @@ process_wait (tid_t child_tid UNUSED) {
 	/* XXX: Hint) The pintos exit if process_wait (initd), we recommend you
 	 * XXX:       to add infinite loop here before
 	 * XXX:       implementing the process_wait. */
-	// for(int i = 0 ; i<10000000; i++);
-
-	// return -1;
-
-	struct thread *child = get_child_with_pid(child_tid);
+	int status;
 
-	if(child == NULL)
+	if (process_waitpid (child_tid, &status) == TID_ERROR)
 		return -1;
+	return status;
+}
 
-	/* 자식 프로세스가 종료할때 까지 대기 */
-	sema_down(&child->wait_sema);
-
-	/* 자식으로 부터 종료인자를 전달 받고 리스트에서 삭제 */
-	int exit_status = child->exit_status;
-	list_remove(&child->child_elem);
-
-	/* 자식 프로세스 종료 상태인자 받은 후 자식 프로세스 종료하게 함 */
-	sema_up(&child->free_sema);
-
-	return exit_status;
+/*** GrilledSalmon ***/
+/* 자식 PID가 끝나기를 기다려 종료 상태를 *STATUS에 넣고 PID를 리턴한다.
+ * PID가 -1이면 아무 자식이나 먼저 끝난 것을 거둔다. 기다릴 자식이 없으면
+ * TID_ERROR. */
+tid_t
+process_waitpid (tid_t pid, int *status) {
+	struct thread *cur = thread_current ()->leader;
+	struct child *child;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (pid == -1) {
+		/* child_exit는 wait(pid)로 거둔 자식의 몫까지 세므로 zombie_list를
+		 * 다시 본다. */
+		while (list_empty (&cur->zombie_list)) {
+			if (list_empty (&cur->child_list)) {
+				intr_set_level (old_level);
+				return TID_ERROR;
+			}
+			sema_down (&cur->child_exit);
+		}
+		child = list_entry (list_front (&cur->zombie_list), struct child, elem);
+	} else {
+		child = get_child_with_pid (pid);
+		if (child == NULL) {
+			intr_set_level (old_level);
+			return TID_ERROR;
+		}
+	}
+	intr_set_level (old_level);
+
+	/* 자식 프로세스가 종료할때 까지 대기. 자식의 스레드는 이미 없을 수 있고
+	 * 종료 상태는 기록에 남아 있다. */
+	sema_down (&child->exited);
+
+	/* 종료인자를 받고 리스트에서 삭제한 다음 기록을 놓는다. parent를 지우므로
+	 * 다시 wait 해도 찾지 못한다. */
+	pid = child->tid;
+	*status = child->exit_status;
+	old_level = intr_disable ();
+	list_remove (&child->elem);
+	child->parent = NULL;
+	intr_set_level (old_level);
+	child_put (child);
+	return pid;
 }
 
 /* Exit the process. This function is called by thread_exit (). */
@@ -405,26 +777,46 @@ process_exit (void) {
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
+	/*** GrilledSalmon ***/
+	/* user thread는 자기 것만 놓는다. 주소 공간과 fd table은 leader가 모든
+	 * user thread가 끝난 다음에 놓는다. */
+	if (curr->leader != curr) {
+		sysprof_exit (curr);
+		curr->pml4 = NULL;
+		pml4_activate (NULL);
+		return;
+	}
+	uthread_reap_all (curr);
+	aio_destroy (curr);
+
 	// P2-4 CLose all opened files
-	for (int i = 0; i < FDCOUNT_LIMIT; i++)
-	{
+	for (int i = fdt_next(curr, 0); i >= 0; i = fdt_next(curr, i + 1))
 		close(i);
-	}
 
-	/* thread_create에서 할당한 페이지 할당 해제 */
-	palloc_free_multiple(curr->fdTable, FDT_PAGES);
+	/* fdt_reserve로 늘린 fd table 해제 */
+	fdt_destroy(curr);
+	sysprof_exit(curr);
 
-	/* 현재 프로세스가 실행중인 파일 종료 */
-	file_close(curr->running);
+	if (process_print_io && curr->pml4 != NULL)
+		printf ("%s: rchar %lld wchar %lld inblock %ld oublock %ld\n",
+				thread_name (), curr->rusage.rchar, curr->rusage.wchar,
+				curr->rusage.inblock, curr->rusage.oublock);
+
+#ifdef VM
+	if (vm_print_rusage && curr->pml4 != NULL)
+		printf ("%s: minflt %ld majflt %ld evict %ld stack %ld rss %zu\n",
+				thread_name (), curr->rusage.minflt, curr->rusage.majflt,
+				curr->rusage.nevict, curr->rusage.nstack,
+				vm_resident_pages (&curr->spt));
+#endif
 
 	/* 현재 프로세스의 자원 반납 */
 	process_cleanup ();
 
-	/* 부모 프로세스가 자식 프로세스의 종료상태 확인하게 함 */
-	sema_up(&curr->wait_sema);
-
-	/* 부모 프로세스가 자식 프로세스 종료인자 받을때 까지 대기 */
-	sema_down(&curr->free_sema);
+	/* 현재 프로세스가 실행중인 파일 종료. page cache가 inode로 segment frame을
+	 * 찾으므로 page를 다 놓은 다음에 닫는다. */
+	file_close(curr->running);
+	curr->running = NULL;
 
 }
 
@@ -460,7 +852,12 @@ process_cleanup (void) {
 void
 process_activate (struct thread *next) {
 	/* Activate thread's page tables. */
-	pml4_activate (next->pml4);
+	/*** GrilledSalmon ***/
+	/* 주소 공간이 없는 스레드는 커널 매핑만 쓰고, 커널 매핑은 모든 pml4에 같다.
+	 * 그러므로 CR3를 바꾸지 않고 지금 올라와 있는 주소 공간을 빌려 쓴다. 빌려 간
+	 * pml4는 그 주인이 다시 돌아와 process_cleanup()에서 내린 뒤에만 없어진다. */
+	if (next->pml4 != NULL)
+		pml4_activate (next->pml4);
 
 	/* Set thread's kernel stack for use in processing interrupts. */
 	tss_update (next);
@@ -520,6 +917,7 @@ struct ELF64_PHDR {
 #define Phdr ELF64_PHDR
 
 static bool setup_stack (struct intr_frame *if_);
+static struct elf_image *parse_elf (struct file *, const char *file_name);
 static bool validate_segment (const struct Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		uint32_t read_bytes, uint32_t zero_bytes,
@@ -532,9 +930,8 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 load (const char *file_name, struct intr_frame *if_) {
 	struct thread *t = thread_current ();
-	struct ELF ehdr;
+	struct elf_image *img = NULL;
 	struct file *file = NULL;
-	off_t file_ofs;
 	bool success = false;
 	int i;
 
@@ -561,6 +958,66 @@ load (const char *file_name, struct intr_frame *if_) {
 	/* 현재 오픈한 파일에 다른내용 쓰지 못하게 함 */
 	file_deny_write(file);
 
+	/*** GrilledSalmon ***/
+	/* 같은 실행 파일을 전에 검증했으면 header를 다시 읽지 않는다. */
+	img = elfcache_get (file_get_inode (file));
+	if (img == NULL) {
+		img = parse_elf (file, file_name);
+		if (img == NULL)
+			goto done;
+		elfcache_put (img);
+	}
+
+#ifdef VM
+	t->heap_start = NULL;
+#endif
+	for (i = 0; i < img->seg_cnt; i++) {
+		const struct elf_seg *seg = &img->segs[i];
+		if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+					seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
+#ifdef VM
+		/* heap은 가장 높은 segment가 끝나는 page에서 시작한다. */
+		void *seg_end = (void *) (seg->mem_page + seg->read_bytes + seg->zero_bytes);
+		if (seg_end > t->heap_start)
+			t->heap_start = seg_end;
+#endif
+	}
+#ifdef VM
+	t->brk = t->heap_start;
+#endif
+
+	/* Set up stack. */
+	if (!setup_stack (if_))
+		goto done;
+	if (!map_clock_page (t))
+		goto done;
+
+	/* Start address. */
+	if_->rip = img->entry;
+
+	/* TODO: Your code goes here.
+	 * TODO: Implement argument passing (see project2/argument_passing.html). */
+
+	success = true;
+
+done:
+	/* We arrive here whether the load is successful or not. */
+	// file_close (file);
+	elfcache_release (img);
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* FILE의 ELF header와 program header를 읽고 검증해서 올릴 세그먼트 목록을
+ * 만든다. 잘못된 실행 파일이거나 메모리가 모자라면 NULL. */
+static struct elf_image *
+parse_elf (struct file *file, const char *file_name) {
+	struct ELF ehdr;
+	struct elf_image *img = NULL;
+	off_t file_ofs;
+	int i;
+
 	/* Read and verify executable header. */
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
 			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
@@ -570,20 +1027,25 @@ load (const char *file_name, struct intr_frame *if_) {
 			|| ehdr.e_phentsize != sizeof (struct Phdr)
 			|| ehdr.e_phnum > 1024) {
 		printf ("load: %s: error loading executable\n", file_name);
-		goto done;
+		goto fail;
 	}
 
+	img = elfcache_alloc (file_get_inode (file), ehdr.e_phnum);
+	if (img == NULL)
+		goto fail;
+	img->entry = ehdr.e_entry;
+
 	/* Read program headers. */
 	file_ofs = ehdr.e_phoff;
 	for (i = 0; i < ehdr.e_phnum; i++) {
 		struct Phdr phdr;
 
 		if (file_ofs < 0 || file_ofs > file_length (file))
-			goto done;
+			goto fail;
 		file_seek (file, file_ofs);
 
 		if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
+			goto fail;
 		file_ofs += sizeof phdr;
 		switch (phdr.p_type) {
 			case PT_NULL:
@@ -596,9 +1058,10 @@ load (const char *file_name, struct intr_frame *if_) {
 			case PT_DYNAMIC:
 			case PT_INTERP:
 			case PT_SHLIB:
-				goto done;
+				goto fail;
 			case PT_LOAD:
 				if (validate_segment (&phdr, file)) {
+					struct elf_seg *seg = &img->segs[img->seg_cnt++];
 					bool writable = (phdr.p_flags & PF_W) != 0;
 					uint64_t file_page = phdr.p_offset & ~PGMASK;
 					uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
@@ -616,32 +1079,22 @@ load (const char *file_name, struct intr_frame *if_) {
 						read_bytes = 0;
 						zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
 					}
-					if (!load_segment (file, file_page, (void *) mem_page,
-								read_bytes, zero_bytes, writable))
-						goto done;
+					seg->file_page = file_page;
+					seg->mem_page = mem_page;
+					seg->read_bytes = read_bytes;
+					seg->zero_bytes = zero_bytes;
+					seg->writable = writable;
 				}
 				else
-					goto done;
+					goto fail;
 				break;
 		}
 	}
+	return img;
 
-	/* Set up stack. */
-	if (!setup_stack (if_))
-		goto done;
-
-	/* Start address. */
-	if_->rip = ehdr.e_entry;
-
-	/* TODO: Your code goes here.
-	 * TODO: Implement argument passing (see project2/argument_passing.html). */
-
-	success = true;
-
-done:
-	/* We arrive here whether the load is successful or not. */
-	// file_close (file);
-	return success;
+fail:
+	elfcache_release (img);
+	return NULL;
 }
 
 
@@ -804,17 +1257,18 @@ lazy_load_segment (struct page *page, void *aux) {
 	/* TODO: Load the segment from the file */
 	/* TODO: This called when the first page fault occurs on address VA. */
 	/* TODO: VA is available when calling this function. */
-	struct file *file = thread_current()->running;
+	struct file *file = thread_current()->leader->running;
 	struct lazy_info *seg_load = aux;
 
-	file_seek(file, seg_load->ofs);
+	thread_current()->rusage.majflt++;
 
-	if(file_read(file, page->frame->kva, seg_load->read_bytes) != (int) seg_load->read_bytes){
+	/* running은 fork한 프로세스들이 같이 쓰므로 file position을 건드리지 않는다. */
+	if(file_read_at(file, page->frame->kva, seg_load->read_bytes, seg_load->ofs) != (int) seg_load->read_bytes){
 		return false;
 	}
 
 	memset(page->frame->kva + seg_load->read_bytes, 0, PGSIZE - seg_load->read_bytes);
-	free(seg_load);
+	kmem_cache_free(lazy_info_cache, seg_load);
 
 	return true;
 }
@@ -851,14 +1305,23 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
 
-		struct lazy_info *seg_info = malloc(sizeof(struct lazy_info));
-		seg_info->ofs = now;
-		seg_info->read_bytes = page_read_bytes;
-
-		if (!vm_alloc_page_with_initializer (VM_SEG, upage,
-					writable, lazy_load_segment, seg_info)) {
-			free(seg_info);
-			return false;
+		/* 파일에서 읽을 것이 없는 BSS page는 zero-fill anon page로 둔다.
+		 * 읽기만 하면 zero_frame을 같이 쓰고, 처음 쓸 때 frame을 받는다. */
+		if (page_read_bytes == 0) {
+			if (!vm_alloc_page (VM_SEG, upage, writable))
+				return false;
+		} else {
+			struct lazy_info *seg_info = kmem_cache_alloc(lazy_info_cache);
+			if (seg_info == NULL)
+				return false;
+			seg_info->ofs = now;
+			seg_info->read_bytes = page_read_bytes;
+
+			if (!vm_alloc_page_with_initializer (VM_SEG, upage,
+						writable, lazy_load_segment, seg_info)) {
+				kmem_cache_free(lazy_info_cache, seg_info);
+				return false;
+			}
 		}
 
 		/* Advance. */
@@ -883,29 +1346,408 @@ setup_stack (struct intr_frame *if_) {
 	/* TODO: Your code goes here */
 	vm_alloc_page(VM_STACK, stack_bottom, true);
 
-	success = vm_claim_page(stack_bottom);
-	memset(stack_bottom, 0, PGSIZE);
+	success = vm_claim_page(stack_bottom);	// stack page는 0으로 채워진 frame을 받는다.
 
 	if_->rsp = USER_STACK;
 
 	return success;
 }
-#endif /* VM */
+/*** GrilledSalmon ***/
+/* Checkpoint 이미지. 준비하는 데 오래 걸리는 프로세스를 준비가 끝난 때 파일로
+ * 떠 두었다가 나중에 그 상태에서 바로 다시 시작한다. 파일 앞에 ckpt_header,
+ * page 목록, VMA 목록, fd 목록이 차례로 있고, page 내용은 data_ofs부터 내용이
+ * 있는 page만 목록 순서로 한 page씩 있다. restore는 page를 미리 읽지 않는다.
+ * 이미지를 running으로 삼아 실행 파일의 segment처럼 fault가 날 때
+ * lazy_load_segment로 읽으므로 read-only page는 page cache로 같이 쓴다. */
+#define CKPT_MAGIC 0x54504b43           /* "CKPT" */
+#define CKPT_CNT_MAX (1 << 20)          /* 목록 하나의 길이 한도. */
+/* 유저가 바꿀 수 있는 eflags. CF, PF, AF, ZF, SF, DF, OF. */
+#define CKPT_EFLAGS_USER 0xcd5
+
+struct ckpt_header {
+	uint32_t magic;
+	uint32_t page_cnt;
+	uint32_t vma_cnt;
+	uint32_t fd_cnt;
+	uint64_t data_ofs;                  /* 첫 page 내용의 파일 위치. page 경계. */
+	struct intr_frame if_;              /* checkpoint를 부른 system call의 것. */
+	uint64_t heap_start;
+	uint64_t brk;
+	char name[16];
+};
 
-struct thread *get_child_with_pid(int pid)
-{
-	struct thread *cur = thread_current();
-	struct list *child_list = &cur->child_list;
+/* spt에 있던 page 하나. */
+struct ckpt_page {
+	uint64_t va;
+	uint32_t writable;
+	uint32_t zero;                      /* 아직 건드리지 않은 zero-fill page. 내용이 없다. */
+};
 
-#ifdef DEBUG_WAIT
-	printf("\nparent children # : %d\n", list_size(child_list));
-#endif
+/* anon VMA (heap, MAP_ANON) 하나. 만들지 않은 page는 fault가 나면 만든다. */
+struct ckpt_vma {
+	uint64_t start;
+	uint64_t end;
+	uint64_t writable;
+};
 
-	for (struct list_elem *e = list_begin(child_list); e != list_end(child_list); e = list_next(e))
-	{
-		struct thread *t = list_entry(e, struct thread, child_elem);
-		if (t->tid == pid)
-			return t;
+enum ckpt_fd_kind { CKPT_STDIN, CKPT_STDOUT, CKPT_FILE };
+
+/* 열린 fd 하나. 보통 파일은 inode 번호로 다시 열고 위치를 옮긴다. */
+struct ckpt_fd {
+	int32_t fd;
+	int32_t kind;                       /* enum ckpt_fd_kind */
+	uint32_t inumber;
+	int32_t pos;
+};
+
+/* HDR의 header와 목록들의 바이트 수. */
+static size_t
+ckpt_meta_size (const struct ckpt_header *hdr) {
+	return sizeof *hdr + hdr->page_cnt * sizeof (struct ckpt_page)
+		+ hdr->vma_cnt * sizeof (struct ckpt_vma)
+		+ hdr->fd_cnt * sizeof (struct ckpt_fd);
+}
+
+/* fd table의 FILE을 이미지에 어떻게 남길지. pipe, shm, 디렉터리는 남기지 않아서
+ * restore 하면 닫혀 있다. 그러면 -1. */
+static int
+ckpt_fd_kind (struct file *file) {
+	/* thread.c가 표준 입출력 fd에 넣어 두는 표시. */
+	if (file == (struct file *) 1)
+		return CKPT_STDIN;
+	if (file == (struct file *) 2)
+		return CKPT_STDOUT;
+	if (file->inode != NULL && !file->dir)
+		return CKPT_FILE;
+	return -1;
+}
+
+/* 지금 프로세스를 FILE_NAME에 checkpoint 이미지로 떠 둔다. IF_는 checkpoint를
+ * 부른 system call의 intr_frame으로, restore 한 프로세스는 같은 곳으로 돌아가
+ * 1을 받는다. FILE_NAME이 이미 있거나, 파일을 mmap 했거나 shm을 붙였으면
+ * 실패한다. user thread가 없어야 하고 spt lock을 잡고 부른다. 성공하면 0,
+ * 실패하면 -1이고 만든 파일은 지운다. */
+int
+process_checkpoint (const char *file_name, const struct intr_frame *if_) {
+	struct thread *t = thread_current ();
+	struct supplemental_page_table *spt = &t->spt;
+	struct ckpt_header hdr;
+	struct ckpt_page *pages;
+	struct ckpt_vma *vmas;
+	struct ckpt_fd *fds;
+	struct ohash_iterator it;
+	struct avl_elem *e;
+	struct file *file = NULL;
+	uint8_t *meta = NULL;
+	void *kpage = NULL;
+	bool created = false;
+	size_t meta_size, i;
+	off_t ofs;
+	int fd, result = -1;
+
+	ASSERT (t == t->leader);
+
+	memset (&hdr, 0, sizeof hdr);
+	hdr.magic = CKPT_MAGIC;
+	/* mmap 한 파일과 shm은 다른 곳과 같이 쓰는 내용이라 뜨지 않는다. */
+	for (e = avl_first (&spt->vmas); e != NULL; e = avl_next (e)) {
+		struct vma *vma = avl_entry (e, struct vma, elem);
+
+		if (vma->file.file != NULL || vma->shm != NULL)
+			return -1;
+		hdr.vma_cnt++;
 	}
-	return NULL;
+	hdr.page_cnt = ohash_size (&spt->h);
+	for (fd = fdt_next (t, 0); fd >= 0; fd = fdt_next (t, fd + 1))
+		if (ckpt_fd_kind (t->fdTable[fd]) >= 0)
+			hdr.fd_cnt++;
+	if (hdr.page_cnt > CKPT_CNT_MAX || hdr.vma_cnt > CKPT_CNT_MAX)
+		return -1;
+	meta_size = ckpt_meta_size (&hdr);
+	hdr.data_ofs = ROUND_UP (meta_size, PGSIZE);
+	hdr.if_ = *if_;
+	hdr.if_.R.rax = 1;
+	hdr.heap_start = (uint64_t) t->heap_start;
+	hdr.brk = (uint64_t) t->brk;
+	strlcpy (hdr.name, t->name, sizeof hdr.name);
+
+	meta = malloc (meta_size);
+	kpage = palloc_get_page (0);
+	if (meta == NULL || kpage == NULL)
+		goto done;
+	memcpy (meta, &hdr, sizeof hdr);
+	pages = (struct ckpt_page *) (meta + sizeof hdr);
+	vmas = (struct ckpt_vma *) (pages + hdr.page_cnt);
+	fds = (struct ckpt_fd *) (vmas + hdr.vma_cnt);
+
+	i = 0;
+	ohash_first (&it, &spt->h);
+	while (ohash_next (&it)) {
+		struct page *page = ohash_entry (ohash_cur (&it), struct page, hash_elem);
+
+		pages[i].va = (uint64_t) page->va;
+		pages[i].writable = page->writable;
+		pages[i].zero = VM_TYPE (page->operations->type) == VM_UNINIT
+			&& VM_TYPE (page->uninit.type) == VM_ANON && page->uninit.init == NULL;
+		i++;
+	}
+	i = 0;
+	for (e = avl_first (&spt->vmas); e != NULL; e = avl_next (e), i++) {
+		struct vma *vma = avl_entry (e, struct vma, elem);
+
+		vmas[i].start = (uint64_t) vma->start;
+		vmas[i].end = (uint64_t) vma->end;
+		vmas[i].writable = vma->writable;
+	}
+	i = 0;
+	for (fd = fdt_next (t, 0); fd >= 0; fd = fdt_next (t, fd + 1)) {
+		struct file *f = t->fdTable[fd];
+		int kind = ckpt_fd_kind (f);
+
+		if (kind < 0)
+			continue;
+		fds[i].fd = fd;
+		fds[i].kind = kind;
+		fds[i].inumber = kind == CKPT_FILE ? inode_get_inumber (f->inode) : 0;
+		fds[i].pos = kind == CKPT_FILE ? file_tell (f) : 0;
+		i++;
+	}
+
+	if (!filesys_create (file_name, 0))
+		goto done;
+	created = true;
+	file = filesys_open (file_name);
+	if (file == NULL || file_write_at (file, meta, meta_size, 0) != (off_t) meta_size)
+		goto done;
+
+	/* 아직 읽지 않은 page는 여기서 fault로 읽어 온다. */
+	ofs = hdr.data_ofs;
+	for (i = 0; i < hdr.page_cnt; i++) {
+		if (pages[i].zero)
+			continue;
+		if (!copy_from_user (kpage, (void *) pages[i].va, PGSIZE)
+				|| file_write_at (file, kpage, PGSIZE, ofs) != PGSIZE)
+			goto done;
+		ofs += PGSIZE;
+	}
+	result = 0;
+
+done:
+	file_close (file);
+	if (result != 0 && created)
+		filesys_remove (file_name);
+	palloc_free_page (kpage);
+	free (meta);
+	return result;
+}
+
+/* 읽어 들인 이미지의 목록들이 restore 해도 되는 것인지 본다. LENGTH는 이미지
+ * 파일의 길이. */
+static bool
+ckpt_check (const struct ckpt_header *hdr, const struct ckpt_page *pages,
+		const struct ckpt_vma *vmas, const struct ckpt_fd *fds, off_t length) {
+	size_t data_cnt = 0, i;
+
+	if (hdr->data_ofs % PGSIZE != 0 || hdr->data_ofs < ckpt_meta_size (hdr)
+			|| hdr->heap_start > hdr->brk || !is_user_vaddr (hdr->brk))
+		return false;
+	for (i = 0; i < hdr->page_cnt; i++) {
+		void *va = (void *) pages[i].va;
+
+		if (pg_ofs (va) != 0 || va == NULL || !is_user_vaddr (va)
+				|| va == CLOCK_PAGE)
+			return false;
+		if (!pages[i].zero)
+			data_cnt++;
+	}
+	if (hdr->data_ofs + data_cnt * PGSIZE > (uint64_t) length)
+		return false;
+	for (i = 0; i < hdr->vma_cnt; i++) {
+		void *start = (void *) vmas[i].start, *end = (void *) vmas[i].end;
+
+		if (pg_ofs (start) != 0 || pg_ofs (end) != 0 || start == NULL
+				|| start >= end || !is_user_vaddr (end - 1)
+				|| (start <= CLOCK_PAGE && CLOCK_PAGE < end))
+			return false;
+	}
+	/* checkpoint는 fd 순으로 쓴다. */
+	for (i = 0; i < hdr->fd_cnt; i++)
+		if (fds[i].fd < 0 || fds[i].fd >= FDCOUNT_LIMIT
+				|| (i > 0 && fds[i].fd <= fds[i - 1].fd)
+				|| fds[i].kind < CKPT_STDIN || fds[i].kind > CKPT_FILE
+				|| fds[i].pos < 0)
+			return false;
+	return true;
+}
+
+/* FILE_NAME의 checkpoint 이미지로 지금 프로세스를 바꾼다. exec처럼 지금 주소
+ * 공간을 버리고, fd table도 이미지의 것으로 바꾼다. FILE_NAME은 palloc 받은
+ * page로 여기서 돌려준다. 이미지가 잘못되었거나 떠 둔 파일을 열 수 없으면
+ * 지금 프로세스를 건드리지 않고 -1을 리턴한다. 그 뒤에 실패하면 -1로 종료한다.
+ * 성공하면 돌아오지 않는다. */
+int
+process_restore (char *file_name) {
+	struct thread *t = thread_current ();
+	struct ckpt_header hdr;
+	struct ckpt_page *pages;
+	struct ckpt_vma *vmas;
+	struct ckpt_fd *fds;
+	struct intr_frame if_;
+	struct file *file, **files = NULL;
+	uint8_t *meta = NULL;
+	size_t meta_size, i;
+	off_t ofs;
+	int fd;
+
+	file = filesys_open (file_name);
+	palloc_free_page (file_name);
+	if (file == NULL)
+		return -1;
+	if (file_read_at (file, &hdr, sizeof hdr, 0) != sizeof hdr
+			|| hdr.magic != CKPT_MAGIC || hdr.page_cnt > CKPT_CNT_MAX
+			|| hdr.vma_cnt > CKPT_CNT_MAX || hdr.fd_cnt > FDCOUNT_LIMIT)
+		goto fail;
+	meta_size = ckpt_meta_size (&hdr);
+	meta = malloc (meta_size);
+	if (meta == NULL
+			|| file_read_at (file, meta, meta_size, 0) != (off_t) meta_size)
+		goto fail;
+	pages = (struct ckpt_page *) (meta + sizeof hdr);
+	vmas = (struct ckpt_vma *) (pages + hdr.page_cnt);
+	fds = (struct ckpt_fd *) (vmas + hdr.vma_cnt);
+	if (!ckpt_check (&hdr, pages, vmas, fds, file_length (file)))
+		goto fail;
+
+	/* 떠 둔 파일들은 주소 공간을 버리기 전에 열어 본다. */
+	files = calloc (hdr.fd_cnt + 1, sizeof *files);
+	if (files == NULL)
+		goto fail;
+	for (i = 0; i < hdr.fd_cnt; i++)
+		if (fds[i].kind == CKPT_FILE) {
+			files[i] = file_open (inode_open_checked (fds[i].inumber));
+			if (files[i] == NULL)
+				goto fail;
+			file_seek (files[i], fds[i].pos);
+			files[i]->owner = t->tid;
+		}
+
+	/* 여기부터는 되돌릴 수 없다. */
+	aio_destroy (t);
+	process_cleanup ();
+	fpu_release (t);
+	supplemental_page_table_init (&t->spt);
+	t->pml4 = pml4_create ();
+	if (t->pml4 == NULL)
+		goto dead;
+	process_activate (t);
+	file_close (t->running);
+	t->running = file;
+	file_deny_write (file);
+	file = NULL;
+
+	/* VMA를 먼저 넣고 그 안에 있던 page를 만든다. */
+	for (i = 0; i < hdr.vma_cnt; i++) {
+		void *start = (void *) vmas[i].start, *end = (void *) vmas[i].end;
+		struct vma *vma;
+
+		if (!spt_range_free (&t->spt, start, end))
+			goto dead;
+		vma = vma_create_anon (start, end, vmas[i].writable);
+		if (vma == NULL)
+			goto dead;
+		vma_insert (&t->spt, vma);
+	}
+	ofs = hdr.data_ofs;
+	for (i = 0; i < hdr.page_cnt; i++) {
+		void *va = (void *) pages[i].va;
+		struct lazy_info *info;
+
+		if (pages[i].zero) {
+			if (!vm_alloc_page (VM_SEG, va, pages[i].writable))
+				goto dead;
+			continue;
+		}
+		info = kmem_cache_alloc (lazy_info_cache);
+		if (info == NULL)
+			goto dead;
+		info->file = NULL;
+		info->ofs = ofs;
+		info->read_bytes = PGSIZE;
+		info->remain_cnt = NULL;
+		if (!vm_alloc_page_with_initializer (VM_SEG, va, pages[i].writable,
+					lazy_load_segment, info)) {
+			kmem_cache_free (lazy_info_cache, info);
+			goto dead;
+		}
+		ofs += PGSIZE;
+	}
+	t->heap_start = (void *) hdr.heap_start;
+	t->brk = (void *) hdr.brk;
+	if (!map_clock_page (t))
+		goto dead;
+
+	/* fd table. */
+	for (fd = fdt_next (t, 0); fd >= 0; fd = fdt_next (t, fd + 1))
+		close (fd);
+	t->stdin_count = t->stdout_count = 0;
+	for (i = 0; i < hdr.fd_cnt; i++) {
+		if (!fdt_reserve (t, fds[i].fd + 1))
+			goto dead;
+		if (fds[i].kind == CKPT_STDIN) {
+			fdt_set (t, fds[i].fd, (struct file *) 1);
+			t->stdin_count++;
+		} else if (fds[i].kind == CKPT_STDOUT) {
+			fdt_set (t, fds[i].fd, (struct file *) 2);
+			t->stdout_count++;
+		} else {
+			fdt_set (t, fds[i].fd, files[i]);
+			files[i] = NULL;
+		}
+	}
+
+	/* 유저 모드로만 돌아가게 segment와 eflags는 새로 정한다. FPU 상태는 이미지에
+	 * 없어서 exec처럼 처음 상태로 시작한다. */
+	if_ = hdr.if_;
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = (if_.eflags & CKPT_EFLAGS_USER) | FLAG_IF | FLAG_MBS;
+	hdr.name[sizeof hdr.name - 1] = '\0';
+	strlcpy (t->name, hdr.name, sizeof t->name);
+	free (files);
+	free (meta);
+	do_iret (&if_);
+	NOT_REACHED ();
+
+fail:
+	for (i = 0; files != NULL && i < hdr.fd_cnt; i++)
+		file_close (files[i]);
+	free (files);
+	free (meta);
+	file_close (file);
+	return -1;
+
+dead:
+	for (i = 0; i < hdr.fd_cnt; i++)
+		file_close (files[i]);
+	free (files);
+	free (meta);
+	file_close (file);
+	exit (-1);
+	NOT_REACHED ();
+}
+#endif /* VM */
+
+struct child *get_child_with_pid(int pid)
+{
+	/*** GrilledSalmon ***/
+	/* pid table에서 찾고 부모가 나인지 본다. 찾은 기록이 풀리지 않게 인터럽트를
+	 * 끈 채로 본다. 내 자식의 기록은 내가 거둘 때까지 남는다. */
+	struct thread *cur = thread_current()->leader;
+	enum intr_level old_level = intr_disable ();
+	struct child *c = child_find (pid);
+
+	if (c != NULL && (c->parent != cur || c->uthread))
+		c = NULL;
+	intr_set_level (old_level);
+	return c;
 }
@@ -5,17 +5,33 @@
 #include "threads/thread.h"
 #include "threads/loader.h"
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
+#include "threads/trace.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 
 #include "filesys/filesys.h"
 #include "filesys/file.h"
+#include "filesys/directory.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/fsstat.h"
 #include <list.h>
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
+#include "userprog/usercopy.h"
+#include "userprog/sysprof.h"
+#include "userprog/pipe.h"
+#include "userprog/aio.h"
+#include "userprog/ipc.h"
+#include "devices/input.h"
+#include "devices/timer.h"
 #include "threads/synch.h"
 #include "vm/vm.h"
+#include <hash.h>
+#include <string.h>
+#include <round.h>
+#include "threads/malloc.h"
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
@@ -26,22 +42,73 @@ void exit (int status);
 bool create(const char *file, unsigned initial_size);
 bool remove(const char *file);
 int open(const char *file);
+int open2(const char *file, int flags);
 int filesize(int fd);
 int read(int fd, void *buffer, unsigned size);
 int write(int fd, const void *buffer, unsigned size);
 int _write (int fd UNUSED, const void *buffer, unsigned size);
+int pread(int fd, void *buffer, unsigned size, off_t offset);
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset);
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range(int fd_in, off_t off_in, int fd_out, off_t off_out, unsigned len);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
 tid_t fork (const char *thread_name, struct intr_frame *f);
 int exec (char *file_name);
+int execve (const char *cmd_line, char *const envp[]);
+tid_t spawn (const char *cmd_line, const struct spawn_action *actions, int action_cnt);
+tid_t waitpid (tid_t pid, int *status);
 int dup2(int oldfd, int newfd);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length, int flags);
+void *sbrk (intptr_t increment);
+int getrusage (struct rusage *usage);
+bool fallocate (int fd, off_t length);
+int fsync (int fd);
+int fsstat (struct fsstat *st);
+int sysprof (struct sysprof *sp, bool self);
+int schedstat (struct schedstat *st, bool self);
+int sched_edf (unsigned runtime_ms, unsigned period_ms, unsigned deadline_ms);
+int setrlimit (int resource, long limit);
+int mount (const char *path, int chan_no, int dev_no);
+int umount (const char *path);
+int futex_wait (int *uaddr, int expected, int timeout_ms);
+int futex_wake (int *uaddr, int n);
+int ring_enter (struct sys_ring *ring, unsigned to_submit);
+int getdents (int fd, struct dirent *ents, unsigned cnt);
+int stat (const char *file, struct stat *st);
+int fstat (int fd, struct stat *st);
+int pipe (int *fds);
+int shm_create (size_t size);
+void *shm_attach (int fd, void *addr, bool writable);
+int shm_detach (void *addr);
+tid_t uthread_create (void *entry, void *func, void *arg, void *stack);
+void uthread_exit (int status);
+int uthread_join (tid_t tid, int *status);
+int checkpoint (const char *file, struct intr_frame *f);
+int restore (const char *file);
+int aio_read (int fd, void *buffer, unsigned size, off_t offset);
+int aio_write (int fd, const void *buffer, unsigned size, off_t offset);
+int aio_wait (const int *ids, int n, int timeout_ms);
+int aio_return (int id);
+int poll (struct pollfd *fds, int n, int timeout_ms);
+int chan_create (void);
+int chan_send (int fd, const void *buffer, unsigned length);
+int chan_recv (int fd, void *buffer, unsigned length);
 
 /* syscall helper functions */
-void check_address(const uint64_t *uaddr);
+static char *copy_in_string(const char *ustr);
+static void check_buffer(const void *buffer, unsigned size, bool write);
 static struct file *find_file_by_fd(int fd);
+static struct file *own_file(int fd);
+static int fdt_lowest_free(struct thread *t);
+static int ring_run(const struct ring_sqe *sqe);
+static int count_io(int ret, bool write);
+static bool multithreaded(void);
 int add_file_to_fdt(struct file *file);
 void remove_file_from_fdt(int fd);
 
@@ -49,6 +116,24 @@ void remove_file_from_fdt(int fd);
 const int STDIN = 1;
 const int STDOUT = 2;
 
+/* Futex. (pml4, uaddr)로 해싱한 버킷마다 그 주소에서 잠든 스레드들의 리스트를 둔다. */
+#define FUTEX_BUCKETS 64
+
+struct futex_bucket {
+	struct lock lock;           /* 값 비교와 대기열 조작을 원자적으로 묶는다. */
+	struct list waiters;        /* struct futex_waiter의 리스트 */
+};
+
+struct futex_waiter {
+	struct list_elem elem;
+	uint64_t *pml4;             /* 주소 공간 */
+	int *uaddr;                 /* 기다리는 유저 주소 */
+	struct semaphore sema;      /* futex_wake가 올려준다. */
+};
+
+static struct futex_bucket futex_table[FUTEX_BUCKETS];
+static struct futex_bucket *futex_bucket (uint64_t *pml4, int *uaddr);
+
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -61,26 +146,210 @@ const int STDOUT = 2;
 #define MSR_STAR 0xc0000081         /* Segment selector msr */
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* GS base that swapgs swaps in */
 
 void
 syscall_init (void) {
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
 			((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
+	/*** GrilledSalmon ***/
+	/* syscall_entry는 swapgs로 이 CPU의 struct cpu를 %gs로 보고 다시 되돌린다.
+	 * 커널은 그 밖에서 GS를 쓰지 않는다 (intr_entry가 %gs를 다시 읽어 GS base가
+	 * 0이 된다). */
+	write_msr(MSR_KERNEL_GS_BASE, (uint64_t) this_cpu ());
 
 	/* The interrupt service rountine should not serve any interrupts
 	 * until the syscall_entry swaps the userland stack to the kernel
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
-	lock_init(&file_rw_lock);
+	for (int i = 0; i < FUTEX_BUCKETS; i++) {
+		lock_init(&futex_table[i].lock);
+		list_init(&futex_table[i].waiters);
+	}
+	aio_init();
+}
+
+/*** GrilledSalmon ***/
+/* System call dispatch table.  레지스터로 들어온 인자 A[0..5](rdi, rsi, rdx,
+ * r10, r8, r9)를 각 system call의 타입으로 바꿔 부르는 함수와, 공통으로 검사할
+ * 인자를 적은 metadata를 번호로 찾는다. 표에 없는 번호는 -1로 종료한다. */
+typedef uint64_t syscall_func (const uint64_t *a, struct intr_frame *f);
+
+struct syscall_desc {
+	syscall_func *func;
+	int argc;                   /* 인자 수 */
+	unsigned args;              /* ARG_PTR, ARG_BUF 비트 */
+};
+
+/* N번째 인자는 유저 포인터. 커널 주소면 handler를 부르기 전에 종료한다. */
+#define ARG_PTR(N) (1u << (N))
+/* N번째 인자는 N+1번째 인자 바이트의 유저 버퍼. 버퍼 끝까지 유저 영역이어야 한다. */
+#define ARG_BUF(N) (ARG_PTR (N) | 1u << (8 + (N)))
+/* spt를 고치거나 복사한다. 같은 주소 공간의 user thread끼리 spt lock으로 막는다. */
+#define ARG_SPT (1u << 16)
+
+static uint64_t sys_halt (const uint64_t *a UNUSED, struct intr_frame *f UNUSED) { halt(); NOT_REACHED(); }
+static uint64_t sys_exit (const uint64_t *a, struct intr_frame *f UNUSED) { exit(a[0]); NOT_REACHED(); }
+static uint64_t sys_fork (const uint64_t *a, struct intr_frame *f) { return fork((const char *) a[0], f); }
+static uint64_t sys_exec (const uint64_t *a, struct intr_frame *f UNUSED)
+{
+	if (exec((char *) a[0]) == -1)
+		exit(-1);
+	NOT_REACHED();
+}
+static uint64_t sys_execve (const uint64_t *a, struct intr_frame *f UNUSED)
+{
+	if (execve((const char *) a[0], (char *const *) a[1]) == -1)
+		exit(-1);
+	NOT_REACHED();
+}
+static uint64_t sys_wait (const uint64_t *a, struct intr_frame *f UNUSED) { return process_wait(a[0]); }
+static uint64_t sys_waitpid (const uint64_t *a, struct intr_frame *f UNUSED) { return waitpid(a[0], (int *) a[1]); }
+static uint64_t sys_spawn (const uint64_t *a, struct intr_frame *f UNUSED) { return spawn((const char *) a[0], (const struct spawn_action *) a[1], a[2]); }
+static uint64_t sys_create (const uint64_t *a, struct intr_frame *f UNUSED) { return create((const char *) a[0], a[1]); }
+static uint64_t sys_remove (const uint64_t *a, struct intr_frame *f UNUSED) { return remove((const char *) a[0]); }
+static uint64_t sys_open (const uint64_t *a, struct intr_frame *f UNUSED) { return open((const char *) a[0]); }
+static uint64_t sys_open2 (const uint64_t *a, struct intr_frame *f UNUSED) { return open2((const char *) a[0], a[1]); }
+static uint64_t sys_filesize (const uint64_t *a, struct intr_frame *f UNUSED) { return filesize(a[0]); }
+static uint64_t sys_read (const uint64_t *a, struct intr_frame *f UNUSED) { return read(a[0], (void *) a[1], a[2]); }
+static uint64_t sys_write (const uint64_t *a, struct intr_frame *f UNUSED) { return write(a[0], (const void *) a[1], a[2]); }
+static uint64_t sys_seek (const uint64_t *a, struct intr_frame *f) { seek(a[0], a[1]); return f->R.rax; }
+static uint64_t sys_tell (const uint64_t *a, struct intr_frame *f UNUSED) { return tell(a[0]); }
+static uint64_t sys_close (const uint64_t *a, struct intr_frame *f) { close(a[0]); return f->R.rax; }
+static uint64_t sys_mmap (const uint64_t *a, struct intr_frame *f UNUSED) { return (uint64_t) mmap((void *) a[0], a[1], a[2], a[3], a[4]); }
+static uint64_t sys_munmap (const uint64_t *a, struct intr_frame *f) { munmap((void *) a[0]); return f->R.rax; }
+static uint64_t sys_madvise (const uint64_t *a, struct intr_frame *f UNUSED) { return madvise((void *) a[0], a[1], a[2]); }
+static uint64_t sys_msync (const uint64_t *a, struct intr_frame *f UNUSED) { return msync((void *) a[0], a[1], a[2]); }
+static uint64_t sys_sbrk (const uint64_t *a, struct intr_frame *f UNUSED) { return (uint64_t) sbrk(a[0]); }
+static uint64_t sys_getrusage (const uint64_t *a, struct intr_frame *f UNUSED) { return getrusage((struct rusage *) a[0]); }
+static uint64_t sys_fallocate (const uint64_t *a, struct intr_frame *f UNUSED) { return fallocate(a[0], a[1]); }
+static uint64_t sys_fsync (const uint64_t *a, struct intr_frame *f UNUSED) { return fsync(a[0]); }
+static uint64_t sys_fsstat (const uint64_t *a, struct intr_frame *f UNUSED) { return fsstat((struct fsstat *) a[0]); }
+static uint64_t sys_mount (const uint64_t *a, struct intr_frame *f UNUSED) { return mount((const char *) a[0], a[1], a[2]); }
+static uint64_t sys_umount (const uint64_t *a, struct intr_frame *f UNUSED) { return umount((const char *) a[0]); }
+static uint64_t sys_pread (const uint64_t *a, struct intr_frame *f UNUSED) { return pread(a[0], (void *) a[1], a[2], a[3]); }
+static uint64_t sys_pwrite (const uint64_t *a, struct intr_frame *f UNUSED) { return pwrite(a[0], (const void *) a[1], a[2], a[3]); }
+static uint64_t sys_readv (const uint64_t *a, struct intr_frame *f UNUSED) { return readv(a[0], (const struct iovec *) a[1], a[2]); }
+static uint64_t sys_writev (const uint64_t *a, struct intr_frame *f UNUSED) { return writev(a[0], (const struct iovec *) a[1], a[2]); }
+static uint64_t sys_copy_file_range (const uint64_t *a, struct intr_frame *f UNUSED) { return copy_file_range(a[0], a[1], a[2], a[3], a[4]); }
+static uint64_t sys_dup2 (const uint64_t *a, struct intr_frame *f UNUSED) { return dup2(a[0], a[1]); }
+static uint64_t sys_futex_wait (const uint64_t *a, struct intr_frame *f UNUSED) { return futex_wait((int *) a[0], a[1], a[2]); }
+static uint64_t sys_futex_wake (const uint64_t *a, struct intr_frame *f UNUSED) { return futex_wake((int *) a[0], a[1]); }
+static uint64_t sys_ring_enter (const uint64_t *a, struct intr_frame *f UNUSED) { return ring_enter((struct sys_ring *) a[0], a[1]); }
+static uint64_t sys_sysprof (const uint64_t *a, struct intr_frame *f UNUSED) { return sysprof((struct sysprof *) a[0], a[1]); }
+static uint64_t sys_schedstat (const uint64_t *a, struct intr_frame *f UNUSED) { return schedstat((struct schedstat *) a[0], a[1]); }
+static uint64_t sys_sched_edf (const uint64_t *a, struct intr_frame *f UNUSED) { return sched_edf(a[0], a[1], a[2]); }
+static uint64_t sys_getdents (const uint64_t *a, struct intr_frame *f UNUSED) { return getdents(a[0], (struct dirent *) a[1], a[2]); }
+static uint64_t sys_stat (const uint64_t *a, struct intr_frame *f UNUSED) { return stat((const char *) a[0], (struct stat *) a[1]); }
+static uint64_t sys_fstat (const uint64_t *a, struct intr_frame *f UNUSED) { return fstat(a[0], (struct stat *) a[1]); }
+static uint64_t sys_pipe (const uint64_t *a, struct intr_frame *f UNUSED) { return pipe((int *) a[0]); }
+static uint64_t sys_shm_create (const uint64_t *a, struct intr_frame *f UNUSED) { return shm_create(a[0]); }
+static uint64_t sys_shm_attach (const uint64_t *a, struct intr_frame *f UNUSED) { return (uint64_t) shm_attach(a[0], (void *) a[1], a[2]); }
+static uint64_t sys_shm_detach (const uint64_t *a, struct intr_frame *f UNUSED) { return shm_detach((void *) a[0]); }
+static uint64_t sys_setrlimit (const uint64_t *a, struct intr_frame *f UNUSED) { return setrlimit(a[0], a[1]); }
+static uint64_t sys_uthread_create (const uint64_t *a, struct intr_frame *f UNUSED) { return uthread_create((void *) a[0], (void *) a[1], (void *) a[2], (void *) a[3]); }
+static uint64_t sys_uthread_exit (const uint64_t *a, struct intr_frame *f UNUSED) { uthread_exit(a[0]); NOT_REACHED(); }
+static uint64_t sys_uthread_join (const uint64_t *a, struct intr_frame *f UNUSED) { return uthread_join(a[0], (int *) a[1]); }
+static uint64_t sys_checkpoint (const uint64_t *a, struct intr_frame *f) { return checkpoint((const char *) a[0], f); }
+static uint64_t sys_restore (const uint64_t *a, struct intr_frame *f UNUSED) { return restore((const char *) a[0]); }
+static uint64_t sys_aio_read (const uint64_t *a, struct intr_frame *f UNUSED) { return aio_read(a[0], (void *) a[1], a[2], a[3]); }
+static uint64_t sys_aio_write (const uint64_t *a, struct intr_frame *f UNUSED) { return aio_write(a[0], (const void *) a[1], a[2], a[3]); }
+static uint64_t sys_aio_wait (const uint64_t *a, struct intr_frame *f UNUSED) { return aio_wait((const int *) a[0], a[1], a[2]); }
+static uint64_t sys_aio_return (const uint64_t *a, struct intr_frame *f UNUSED) { return aio_return(a[0]); }
+static uint64_t sys_poll (const uint64_t *a, struct intr_frame *f UNUSED) { return poll((struct pollfd *) a[0], a[1], a[2]); }
+static uint64_t sys_chan_create (const uint64_t *a UNUSED, struct intr_frame *f UNUSED) { return chan_create(); }
+static uint64_t sys_chan_send (const uint64_t *a, struct intr_frame *f UNUSED) { return chan_send(a[0], (const void *) a[1], a[2]); }
+static uint64_t sys_chan_recv (const uint64_t *a, struct intr_frame *f UNUSED) { return chan_recv(a[0], (void *) a[1], a[2]); }
+
+/* mmap, munmap, madvise, msync, shm_attach, shm_detach는 잘못된 주소에 실패를 돌려주므로 ARG_PTR을 달지 않는다.
+   waitpid와 uthread_join의 status는 NULL이어도 되므로 직접 검사한다. */
+static const struct syscall_desc syscall_table[] = {
+	[SYS_HALT]            = { sys_halt,            0, 0 },
+	[SYS_EXIT]            = { sys_exit,            1, 0 },
+	[SYS_FORK]            = { sys_fork,            1, ARG_PTR (0) | ARG_SPT },
+	[SYS_EXEC]            = { sys_exec,            1, ARG_PTR (0) },
+	[SYS_WAIT]            = { sys_wait,            1, 0 },
+	[SYS_CREATE]          = { sys_create,          2, ARG_PTR (0) },
+	[SYS_REMOVE]          = { sys_remove,          1, ARG_PTR (0) },
+	[SYS_OPEN]            = { sys_open,            1, ARG_PTR (0) },
+	[SYS_FILESIZE]        = { sys_filesize,        1, 0 },
+	[SYS_READ]            = { sys_read,            3, ARG_BUF (1) },
+	[SYS_WRITE]           = { sys_write,           3, ARG_BUF (1) },
+	[SYS_SEEK]            = { sys_seek,            2, 0 },
+	[SYS_TELL]            = { sys_tell,            1, 0 },
+	[SYS_CLOSE]           = { sys_close,           1, 0 },
+	[SYS_MMAP]            = { sys_mmap,            5, ARG_SPT },
+	[SYS_MUNMAP]          = { sys_munmap,          1, ARG_SPT },
+	[SYS_DUP2]            = { sys_dup2,            2, 0 },
+	[SYS_MOUNT]           = { sys_mount,           3, ARG_PTR (0) },
+	[SYS_UMOUNT]          = { sys_umount,          1, ARG_PTR (0) },
+	[SYS_FUTEX_WAIT]      = { sys_futex_wait,      3, ARG_PTR (0) },
+	[SYS_FUTEX_WAKE]      = { sys_futex_wake,      2, ARG_PTR (0) },
+	[SYS_MADVISE]         = { sys_madvise,         3, ARG_SPT },
+	[SYS_GETRUSAGE]       = { sys_getrusage,       1, ARG_PTR (0) },
+	[SYS_FALLOCATE]       = { sys_fallocate,       2, 0 },
+	[SYS_PREAD]           = { sys_pread,           4, ARG_BUF (1) },
+	[SYS_PWRITE]          = { sys_pwrite,          4, ARG_BUF (1) },
+	[SYS_READV]           = { sys_readv,           3, ARG_PTR (1) },
+	[SYS_WRITEV]          = { sys_writev,          3, ARG_PTR (1) },
+	[SYS_COPY_FILE_RANGE] = { sys_copy_file_range, 5, 0 },
+	[SYS_FSYNC]           = { sys_fsync,           1, 0 },
+	[SYS_FSSTAT]          = { sys_fsstat,          1, ARG_PTR (0) },
+	[SYS_SPAWN]           = { sys_spawn,           3, ARG_PTR (0) | ARG_PTR (1) },
+	[SYS_RING_ENTER]      = { sys_ring_enter,      2, ARG_PTR (0) },
+	[SYS_SYSPROF]         = { sys_sysprof,         2, ARG_PTR (0) },
+	[SYS_EXECVE]          = { sys_execve,          2, ARG_PTR (0) },
+	[SYS_SBRK]            = { sys_sbrk,            1, ARG_SPT },
+	[SYS_SCHEDSTAT]       = { sys_schedstat,       2, ARG_PTR (0) },
+	[SYS_SETRLIMIT]       = { sys_setrlimit,       2, 0 },
+	[SYS_MSYNC]           = { sys_msync,           3, ARG_SPT },
+	[SYS_OPEN2]           = { sys_open2,           2, ARG_PTR (0) },
+	[SYS_GETDENTS]        = { sys_getdents,        3, ARG_PTR (1) },
+	[SYS_STAT]            = { sys_stat,            2, ARG_PTR (0) | ARG_PTR (1) },
+	[SYS_FSTAT]           = { sys_fstat,           2, ARG_PTR (1) },
+	[SYS_PIPE]            = { sys_pipe,            1, ARG_PTR (0) },
+	[SYS_SHM_CREATE]      = { sys_shm_create,      1, 0 },
+	[SYS_SHM_ATTACH]      = { sys_shm_attach,      3, ARG_SPT },
+	[SYS_SHM_DETACH]      = { sys_shm_detach,      1, ARG_SPT },
+	[SYS_WAITPID]         = { sys_waitpid,         2, 0 },
+	[SYS_UTHREAD_CREATE]  = { sys_uthread_create,  4, 0 },
+	[SYS_UTHREAD_EXIT]    = { sys_uthread_exit,    1, 0 },
+	[SYS_UTHREAD_JOIN]    = { sys_uthread_join,    2, 0 },
+	[SYS_CHECKPOINT]      = { sys_checkpoint,      1, ARG_PTR (0) | ARG_SPT },
+	[SYS_RESTORE]         = { sys_restore,         1, ARG_PTR (0) },
+	[SYS_AIO_READ]        = { sys_aio_read,        4, ARG_BUF (1) },
+	[SYS_AIO_WRITE]       = { sys_aio_write,       4, ARG_BUF (1) },
+	[SYS_AIO_WAIT]        = { sys_aio_wait,        3, ARG_PTR (0) },
+	[SYS_AIO_RETURN]      = { sys_aio_return,      1, 0 },
+	[SYS_POLL]            = { sys_poll,            3, 0 },
+	[SYS_CHAN_CREATE]     = { sys_chan_create,     0, 0 },
+	[SYS_CHAN_SEND]       = { sys_chan_send,       3, ARG_BUF (1) },
+	[SYS_CHAN_RECV]       = { sys_chan_recv,       3, ARG_BUF (1) },
+	[SYS_SCHED_EDF]       = { sys_sched_edf,       3, 0 },
+};
+
+/* D가 유저 포인터라고 한 인자 A를 검사한다. 유저 영역을 벗어나면 -1로 종료.
+   주소가 실제로 매핑되어 있는지는 handler가 복사하면서 본다. */
+static void
+syscall_check_args (const struct syscall_desc *d, const uint64_t *a) {
+	for (int i = 0; i < d->argc; i++) {
+		size_t size = d->args & (1u << (8 + i)) ? a[i + 1] : 0;
+
+		if ((d->args & ARG_PTR (i)) && !user_range_ok((void *) a[i], size))
+			exit(-1);
+	}
 }
 
 /* The main system call interface */
 void
 syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	// printf("syscall! , %d\n",f->R.rax);
+	const struct syscall_desc *d;
+	uint64_t a[6] = { f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8, f->R.r9 };
+	int nr = f->R.rax;
+	uint64_t start;
+	struct thread *leader = thread_current()->leader;
 
 #ifdef VM
 	/*** haein-side ***/
@@ -88,121 +357,232 @@ syscall_handler (struct intr_frame *f UNUSED) {
     thread_current()->rsp = f->rsp;
 #endif
 
-	switch (f->R.rax)
-	{
-	case SYS_HALT:
-		halt();
-		break;
-	case SYS_EXIT:
-		exit(f->R.rdi);
-		break;
-	case SYS_FORK:
-		f->R.rax = fork(f->R.rdi, f);
-		break;
-	case SYS_EXEC:
-		if (exec(f->R.rdi) == -1)
-			exit(-1);
-		break;
-	case SYS_WAIT:
-		f->R.rax = process_wait(f->R.rdi);
-		break;
-	case SYS_CREATE:
-		f->R.rax = create(f->R.rdi, f->R.rsi);
-		break;
-	case SYS_REMOVE:
-		f->R.rax = remove(f->R.rdi);
-		break;
-	case SYS_OPEN:
-		f->R.rax = open(f->R.rdi);
-		break;
-	case SYS_FILESIZE:
-		f->R.rax = filesize(f->R.rdi);
-		break;
-	case SYS_READ:
-		f->R.rax = read(f->R.rdi, f->R.rsi, f->R.rdx);
-		break;
-	case SYS_WRITE:
-		f->R.rax = write(f->R.rdi, f->R.rsi, f->R.rdx);
-		break;
-	case SYS_SEEK:
-		seek(f->R.rdi, f->R.rsi);
-		break;
-	case SYS_TELL:
-		f->R.rax = tell(f->R.rdi);
-		break;
-	case SYS_CLOSE:
-		close(f->R.rdi);
-		break;
-	case SYS_MMAP: /*** haein ***/
-		f->R.rax = mmap(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8);
-		break;
-	case SYS_MUNMAP: /*** haein ***/
-		munmap(f->R.rdi);
-		break;
-	case SYS_DUP2:
-		f->R.rax = dup2(f->R.rdi, f->R.rsi);
-		break;
-	default:
+	/* 같은 프로세스의 다른 스레드가 exit 했으면 이 스레드도 끝난다. */
+	if (leader->exiting)
+		exit(leader->exit_status);
+	if (f->R.rax >= sizeof syscall_table / sizeof *syscall_table
+			|| syscall_table[f->R.rax].func == NULL)
 		exit(-1);
-		break;
-	}
+	d = &syscall_table[nr];
+	TRACE(syscall, nr, a[0]);
+	syscall_check_args(d, a);
+	start = sysprof_begin(nr);
+#ifdef VM
+	if (d->args & ARG_SPT) {
+		bool locked = spt_lock(&leader->spt);
+
+		f->R.rax = d->func(a, f);
+		spt_unlock(&leader->spt, locked);
+	} else
+#endif
+		f->R.rax = d->func(a, f);
+	sysprof_end(nr, start);
 }
 /* ------------------- helper function -------------------- */
 
-/* 사용할 수 있는 주소인지 확인하는 함수. 사용 불가 시 -1 종료 */
-void check_address(const uint64_t *uaddr){
-	struct thread *cur = thread_current();
-#ifndef VM
-	if (uaddr == NULL || !(is_user_vaddr(uaddr)) || pml4_get_page(cur->pml4, uaddr) == NULL)
-	{
+/*** GrilledSalmon ***/
+/* 유저 문자열 USTR을 커널 페이지로 복사해 리턴한다. 읽을 수 없는 주소면 -1로
+   종료하고, 한 페이지 안에 끝나지 않거나 페이지가 없으면 NULL. 다 쓰면
+   palloc_free_page로 돌려준다. */
+static char *copy_in_string(const char *ustr)
+{
+	char *kstr = palloc_get_page(0);
+	int len;
+
+	if (kstr == NULL)
+		return NULL;
+	len = strncpy_from_user(kstr, ustr, PGSIZE);
+	if (len < 0) {
+		palloc_free_page(kstr);
 		exit(-1);
 	}
-#else
-	if (uaddr == NULL || !(is_user_vaddr(uaddr)) || (spt_find_page(&cur->spt, uaddr) == NULL && !(cur->rsp<=uaddr && uaddr<USER_STACK)))
-	{
-		exit(-1);
+	if (len == PGSIZE) {
+		palloc_free_page(kstr);
+		return NULL;
 	}
-#endif
+	return kstr;
+}
+
+/* 커널이 바로 읽고(WRITE이면 쓰고) 쓸 유저 버퍼 [BUFFER, BUFFER + SIZE)의 모든
+   page를 건드려 본다. 잘못된 버퍼면 -1로 종료. */
+static void check_buffer(const void *buffer, unsigned size, bool write)
+{
+	if (buffer == NULL || !user_fault_in(buffer, size, write))
+		exit(-1);
 }
 
 /* 파일 디스크립터로 파일 검색 하여 파일 구조체 반환 */
 static struct file *find_file_by_fd(int fd)
 {
-	struct thread *cur = thread_current();
+	struct thread *cur = thread_current()->leader;
 
 	// Error - invalid id
-	if (fd < 0 || fd >= FDCOUNT_LIMIT)
+	if (fd < 0 || fd >= cur->fdCap)
 		return NULL;
 
 	return cur->fdTable[fd];
 }
+
+/*** GrilledSalmon ***/
+/* fd의 file position을 옮기기 전에 부른다. fork 뒤에는 부모와 자식이 같은 struct
+   file을 같이 쓰는데 file position은 따로 움직여야 하므로, 다른 프로세스가 아직
+   같이 쓰고 있으면 그때 struct file을 복사해서 이 프로세스의 fd 중 그 파일을 가리키던
+   것들을 모두 복사본으로 옮긴다. 복사본(또는 원래 파일)을 돌려주고 fd가 없거나
+   메모리가 없으면 NULL. STDIN, STDOUT과 file position이 없는 pipe, shared
+   memory는 그대로 돌려준다. */
+static struct file *own_file(int fd)
+{
+	struct thread *cur = thread_current()->leader;
+	struct file *file = find_file_by_fd(fd);
+	struct file *copy;
+	int slots = 0;
+
+	if (file <= 2 || file_get_inode(file) == NULL || file->owner == cur->tid)
+		return file;
+	/* 이 fd만 가리키고 있으면 복사할 필요 없이 가져온다. */
+	if (__atomic_load_n(&file->ref_cnt, __ATOMIC_ACQUIRE) == 1) {
+		file->owner = cur->tid;
+		return file;
+	}
+
+	copy = file_duplicate(file);
+	if (copy == NULL)
+		return NULL;
+	copy->owner = cur->tid;
+	for (int i = fdt_next(cur, 0); i >= 0; i = fdt_next(cur, i + 1))
+		if (cur->fdTable[i] == file) {
+			fdt_set(cur, i, slots++ == 0 ? copy : file_share(copy));
+			file_close(file);
+		}
+	return copy;
+}
+
+/* fdt_reserve로 늘린 fd table들. -memstat에 나온다. */
+static struct mem_tag fdt_tag = MEM_TAG ("fd table");
+
+/*** GrilledSalmon ***/
+/* T의 fd table이 적어도 CAP개의 fd를 담도록 두 배씩 늘린다. table 뒤에 bitmap을
+   붙여 한 번에 malloc 한다. FDCOUNT_LIMIT을 넘거나 메모리가 없으면 false. */
+bool fdt_reserve(struct thread *t, int cap)
+{
+	int new_cap = t->fdCap;
+	int words = FDT_MAP_WORDS(t->fdCap);
+	int new_words;
+	struct file **table;
+	uint64_t *map;
+
+	if (cap <= t->fdCap)
+		return true;
+	if (cap > FDCOUNT_LIMIT)
+		return false;
+	while (new_cap < cap)
+		new_cap *= 2;
+	if (new_cap > FDCOUNT_LIMIT)
+		new_cap = FDCOUNT_LIMIT;
+	new_words = FDT_MAP_WORDS(new_cap);
+
+	table = malloc_tagged(&fdt_tag, new_cap * sizeof *table + new_words * sizeof *map);
+	if (table == NULL)
+		return false;
+	map = (uint64_t *) (table + new_cap);
+	memcpy(table, t->fdTable, t->fdCap * sizeof *table);
+	memset(table + t->fdCap, 0, (new_cap - t->fdCap) * sizeof *table);
+	memcpy(map, t->fdMap, words * sizeof *map);
+	memset(map + words, 0, (new_words - words) * sizeof *map);
+
+	if (t->fdTable != t->fdInline)
+		free_tagged(&fdt_tag, t->fdTable);
+	t->fdTable = table;
+	t->fdMap = map;
+	t->fdCap = new_cap;
+	return true;
+}
+
+/* T의 FD 자리에 FILE을 넣고 bitmap을 맞춘다. FILE이 NULL이면 비운다. */
+void fdt_set(struct thread *t, int fd, struct file *file)
+{
+	uint64_t bit = 1ULL << (fd % 64);
+
+	ASSERT(0 <= fd && fd < t->fdCap);
+	t->fdTable[fd] = file;
+	if (file != NULL)
+		t->fdMap[fd / 64] |= bit;
+	else
+		t->fdMap[fd / 64] &= ~bit;
+}
+
+/* fdt_reserve로 늘린 T의 fd table을 돌려주고 처음의 빈 fdInline으로 되돌린다.
+   열린 파일은 닫지 않는다. */
+void fdt_destroy(struct thread *t)
+{
+	if (t->fdTable != t->fdInline)
+		free_tagged(&fdt_tag, t->fdTable);
+	memset(t->fdInline, 0, sizeof t->fdInline);
+	t->fdInlineMap = 0;
+	t->fdTable = t->fdInline;
+	t->fdMap = &t->fdInlineMap;
+	t->fdCap = FDT_INLINE;
+}
+
+/* T에서 FD 이상인 열린 fd 중 가장 작은 것. 없으면 -1. bitmap의 word 단위로
+   건너뛰므로 열린 fd 수에 비례해 순회할 수 있다. */
+int fdt_next(struct thread *t, int fd)
+{
+	int words = FDT_MAP_WORDS(t->fdCap);
+	int w = fd / 64;
+	uint64_t bits;
+
+	if (fd < 0 || fd >= t->fdCap)
+		return -1;
+	bits = t->fdMap[w] & (~0ULL << (fd % 64));
+	while (bits == 0) {
+		if (++w >= words)
+			return -1;
+		bits = t->fdMap[w];
+	}
+	return w * 64 + __builtin_ctzll(bits);
+}
+
+/* T에서 비어 있는 가장 작은 fd. 꽉 찼으면 T->fdCap. */
+static int fdt_lowest_free(struct thread *t)
+{
+	for (int w = 0; w < FDT_MAP_WORDS(t->fdCap); w++)
+		if (~t->fdMap[w] != 0) {
+			int fd = w * 64 + __builtin_ctzll(~t->fdMap[w]);
+			return fd < t->fdCap ? fd : t->fdCap;
+		}
+	return t->fdCap;
+}
+
 /* 새로 만든 파일을 파일 디스크립터 테이블에 추가 */
 int add_file_to_fdt(struct file *file)
 {
-	struct thread *cur = thread_current();
-	struct file **fdt = cur->fdTable;	// file descriptor table
-
-	// Project2-extra - (multi-oom) Find open spot from the front
-	while (cur->fdIdx < FDCOUNT_LIMIT && fdt[cur->fdIdx])
-		cur->fdIdx++;
+	struct thread *cur = thread_current()->leader;
+	int fd = fdt_lowest_free(cur);
 
 	// Error - fdt full
-	if (cur->fdIdx >= FDCOUNT_LIMIT)
+	if (fd == cur->fdCap && !fdt_reserve(cur, fd + 1))
 		return -1;
 
-	fdt[cur->fdIdx] = file;
-	return cur->fdIdx;
+	fdt_set(cur, fd, file);
+	return fd;
+}
+/* (PML4, UADDR)에 해당하는 futex 버킷 */
+static struct futex_bucket *futex_bucket (uint64_t *pml4, int *uaddr)
+{
+	uint64_t key[2] = { (uint64_t) pml4, (uint64_t) uaddr };
+	return &futex_table[hash_bytes(key, sizeof key) % FUTEX_BUCKETS];
 }
 /* 파일 테이블에서 fd 제거 */
 void remove_file_from_fdt(int fd)
 {
-	struct thread *cur = thread_current();
+	struct thread *cur = thread_current()->leader;
 
 	// Error - invalid fd
-	if (fd < 0 || fd >= FDCOUNT_LIMIT)
+	if (fd < 0 || fd >= cur->fdCap)
 		return;
 
-	cur->fdTable[fd] = NULL;
+	fdt_set(cur, fd, NULL);
 }
 
 /* ------------------------ syscall --------------------------*/
@@ -216,6 +596,18 @@ void halt(void){
 void exit (int status)
 {
 	struct thread *curr = thread_current();
+	struct thread *leader = curr->leader;
+
+	/*** GrilledSalmon ***/
+	/* user thread가 exit 하면 프로세스 전체가 끝난다. 종료 상태는 leader에 남기고
+	   메시지는 leader가 끝날 때 출력한다. */
+	if (curr != leader) {
+		if (!leader->exiting) {
+			leader->exit_status = status;
+			leader->exiting = true;
+		}
+		thread_exit();
+	}
 	curr->exit_status = status;
 
 	printf("%s: exit(%d)\n", thread_name(), status);
@@ -225,23 +617,48 @@ void exit (int status)
 /* 요청받은 파일을 생성한다. 만약 파일 주소가 유요하지 않다면 종료 */
 bool create(const char *file, unsigned initial_size)
 {
-	check_address(file);
-	return filesys_create(file, initial_size);
+	char *name = copy_in_string(file);
+	bool success;
+
+	if (name == NULL)
+		return false;
+	success = filesys_create(name, initial_size);
+	palloc_free_page(name);
+	return success;
 }
 
 /* 요청받은 파일이름의 파일을 제거 */
 bool remove(const char *file)
 {
-	check_address(file);
-	return filesys_remove(file);
+	char *name = copy_in_string(file);
+	bool success;
+
+	if (name == NULL)
+		return false;
+	success = filesys_remove(name);
+	palloc_free_page(name);
+	return success;
 }
 
 /* 요청받은 파일을 open. 파일 디스크립터가 가득차있다면 다시 닫아준다. */
 int open(const char *file)
 {
-	check_address(file);
-	lock_acquire(&file_rw_lock);
-	struct file *fileobj = filesys_open(file);
+	return open2(file, 0);
+}
+
+/*** GrilledSalmon ***/
+/* open처럼 열되 FLAGS의 O_*를 파일에 단다. 모르는 flag가 있으면 -1. */
+int open2(const char *file, int flags)
+{
+	if (flags & ~O_DIRECT)
+		return -1;
+
+	char *name = copy_in_string(file);
+
+	if (name == NULL)
+		return -1;
+	struct file *fileobj = filesys_open(name);
+	palloc_free_page(name);
 
 	if (fileobj == NULL)
 		return -1;
@@ -251,21 +668,23 @@ int open(const char *file)
 	/* 파일 디스크립터가 가득찬 경우 */
 	if (fd == -1)
 		file_close(fileobj);
+	else {
+		fileobj->owner = thread_current()->leader->tid;
+		fileobj->direct = (flags & O_DIRECT) != 0;
+	}
 
-	lock_release(&file_rw_lock);
 	return fd;
 }
 
 /* 주어진 파일을 실행한다. */
 int exec (char *file_name){
-	check_address(file_name);
+	if (multithreaded())
+		return -1;
 
-	int siz = strlen(file_name) + 1;
-	char *fn_copy = palloc_get_page(PAL_ZERO);
+	char *fn_copy = copy_in_string(file_name);
 
 	if (fn_copy == NULL)
-		exit(-1);
-	strlcpy(fn_copy, file_name, siz);
+		return -1;
 
 	if (process_exec(fn_copy) == -1)
 		return -1;
@@ -276,17 +695,329 @@ int exec (char *file_name){
 	return 0;
 }
 
+/*** GrilledSalmon ***/
+/* exec과 같지만 NULL로 끝나는 "NAME=value" 문자열 배열 ENVP를 새 프로그램의
+   환경 변수로 넘긴다. 명령어와 환경 변수를 한 page에 이어 복사하고, 빈 문자열로
+   환경 변수의 끝을 표시한다. 한 page에 다 들어가지 않으면 -1. */
+int execve (const char *cmd_line, char *const envp[])
+{
+	char *page;
+	size_t ofs;
+	int i;
+
+	if (multithreaded())
+		return -1;
+	page = copy_in_string(cmd_line);
+	if (page == NULL)
+		return -1;
+	ofs = strlen(page) + 1;
+	if (ofs >= PGSIZE) {
+		palloc_free_page(page);
+		return -1;
+	}
+	for (i = 0; envp != NULL; i++) {
+		char *uenv;
+		int len;
+
+		if (!copy_from_user(&uenv, &envp[i], sizeof uenv)) {
+			palloc_free_page(page);
+			exit(-1);
+		}
+		if (uenv == NULL)
+			break;
+		len = strncpy_from_user(page + ofs, uenv, PGSIZE - ofs);
+		if (len < 0) {
+			palloc_free_page(page);
+			exit(-1);
+		}
+		if ((size_t) len >= PGSIZE - ofs - 1) {
+			palloc_free_page(page);
+			return -1;
+		}
+		ofs += len + 1;
+	}
+	page[ofs] = '\0';
+
+	if (process_execve(page, page + strlen(page) + 1) == -1)
+		return -1;
+	NOT_REACHED();
+}
+
+/*** GrilledSalmon ***/
+/* CMD_LINE을 실행하는 자식 프로세스를 만든다. fork와 달리 주소 공간을 복사하지
+   않고, 지금의 fd table을 물려준 뒤 ACTIONS를 자식 쪽에 차례로 적용한다.
+   자식의 tid, 실패하면 -1을 반환한다. */
+tid_t spawn (const char *cmd_line, const struct spawn_action *actions, int action_cnt)
+{
+	struct spawn_action kactions[SPAWN_ACTIONS_MAX];
+	char *cmd;
+
+	if (action_cnt < 0 || action_cnt > SPAWN_ACTIONS_MAX)
+		return TID_ERROR;
+	if (action_cnt > 0
+			&& !copy_from_user(kactions, actions, action_cnt * sizeof *kactions))
+		exit(-1);
+	cmd = copy_in_string(cmd_line);
+	if (cmd == NULL)
+		return TID_ERROR;
+	return process_spawn(cmd, kactions, action_cnt);
+}
+
+/*** GrilledSalmon ***/
+/* 자식 PID가 끝나기를 기다려 그 pid를 반환하고 STATUS가 NULL이 아니면 종료
+   상태를 넣는다. PID가 -1이면 먼저 끝난 아무 자식이나 거둔다. 기다릴 자식이
+   없으면 -1. */
+tid_t waitpid (tid_t pid, int *status)
+{
+	int kstatus;
+
+	if (status != NULL && !user_range_ok(status, sizeof *status))
+		exit(-1);
+	pid = process_waitpid(pid, &kstatus);
+	if (pid != TID_ERROR && status != NULL
+			&& !copy_to_user(status, &kstatus, sizeof kstatus))
+		exit(-1);
+	return pid;
+}
+
+/*** GrilledSalmon ***/
+/* 이 프로세스의 주소 공간과 fd table을 같이 쓰는 스레드를 만든다. 새 스레드는
+   유저 모드에서 ENTRY(FUNC, ARG)를 STACK 아래의 스택으로 부르며 시작한다.
+   스레드의 tid를 리턴하고 실패하면 -1. */
+tid_t uthread_create (void *entry, void *func, void *arg, void *stack)
+{
+	if (!is_user_vaddr(entry) || !is_user_vaddr(stack))
+		return -1;
+	return process_uthread_create(entry, func, arg, stack);
+}
+
+/* 지금 스레드만 STATUS로 끝낸다. leader가 부르면 exit과 같다. */
+void uthread_exit (int status)
+{
+	struct thread *curr = thread_current();
+
+	if (curr == curr->leader)
+		exit(status);
+	curr->exit_status = status;
+	thread_exit();
+}
+
+/* 같은 프로세스의 스레드 TID가 끝나기를 기다려 종료 상태를 *STATUS에 넣는다.
+   STATUS는 NULL이어도 된다. 성공하면 0, 기다릴 수 없는 TID면 -1. */
+int uthread_join (tid_t tid, int *status)
+{
+	int kstatus;
+
+	if (status != NULL && !user_range_ok(status, sizeof *status))
+		exit(-1);
+	if (!process_uthread_join(tid, &kstatus))
+		return -1;
+	if (status != NULL && !copy_to_user(status, &kstatus, sizeof kstatus))
+		exit(-1);
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* 지금 프로세스를 FILE에 checkpoint 이미지로 떠 둔다. 성공하면 0이고, 나중에 그
+   이미지를 restore 한 프로세스에는 여기서 1이 돌아온다. user thread가 있으면
+   -1. */
+int checkpoint (const char *file, struct intr_frame *f)
+{
+#ifdef VM
+	char *name;
+	int ret;
+
+	if (multithreaded())
+		return -1;
+	name = copy_in_string(file);
+	if (name == NULL)
+		return -1;
+	ret = process_checkpoint(name, f);
+	palloc_free_page(name);
+	return ret;
+#else
+	return -1;
+#endif
+}
+
+/* 지금 프로세스를 FILE의 checkpoint 이미지로 바꾼다. exec처럼 성공하면 돌아오지
+   않고, 이미지를 쓸 수 없으면 -1. */
+int restore (const char *file)
+{
+#ifdef VM
+	char *name;
+
+	if (multithreaded())
+		return -1;
+	name = copy_in_string(file);
+	if (name == NULL)
+		return -1;
+	return process_restore(name);
+#else
+	return -1;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* 파일의 OFFSET부터 BUFFER로 읽는 요청을 넣고 바로 id를 리턴한다. BUFFER는
+   aio_wait나 aio_return이 요청이 끝난 것을 알려 줄 때 채워진다. 넣을 수 없으면
+   -1. */
+int aio_read (int fd, void *buffer, unsigned size, off_t offset)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL || fileobj->dir)
+		return -1;
+	return aio_submit(fileobj, buffer, size, offset, false);
+}
+
+/* BUFFER를 파일의 OFFSET부터 쓰는 요청을 넣고 바로 id를 리턴한다. BUFFER는
+   돌아오자마자 다시 써도 된다. 넣을 수 없으면 -1. */
+int aio_write (int fd, const void *buffer, unsigned size, off_t offset)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL || fileobj->dir)
+		return -1;
+	return aio_submit(fileobj, (void *) buffer, size, offset, true);
+}
+
+/* IDS[0..N)의 요청 중 하나라도 끝날 때까지 TIMEOUT_MS ms 기다리고 끝난 요청 수를
+   리턴한다. 음수면 끝없이 기다리고 0이면 보기만 한다. */
+int aio_wait (const int *ids, int n, int timeout_ms)
+{
+	int kids[AIO_MAX];
+
+	if (n <= 0 || n > AIO_MAX)
+		return -1;
+	if (!user_range_ok(ids, n * sizeof *ids) || !copy_from_user(kids, ids, n * sizeof *ids))
+		exit(-1);
+	return aio_collect(kids, n, timeout_ms);
+}
+
+/* 끝난 요청 ID를 거두고 읽거나 쓴 바이트 수를 리턴한다. */
+int aio_return (int id)
+{
+	return aio_reap(id);
+}
+
+/* poll에서 FILEOBJ가 지금 할 수 있는 일을 POLLIN, POLLOUT, POLLHUP으로, 열린
+   fd가 아니면 POLLNVAL로 돌려준다. E가 NULL이 아니면 상태가 바뀔 때 SEMA가
+   올라가도록 E를 건다. 일반 파일과 console 출력은 기다리지 않으므로 늘 준비되어
+   있다. */
+static unsigned poll_file(struct file *fileobj, struct wait_entry *e, struct semaphore *sema)
+{
+	if (fileobj == NULL)
+		return POLLNVAL;
+	if (fileobj == STDIN)
+		return input_poll(e, sema) ? POLLIN : 0;
+	if (fileobj == STDOUT)
+		return POLLOUT;
+	if (fileobj->pipe != NULL)
+		return pipe_poll(fileobj->pipe, fileobj->pipe_write, e, sema);
+	if (fileobj->chan != NULL)
+		return ipc_poll(fileobj->chan, e, sema);
+	return POLLIN | POLLOUT;
+}
+
+/* FDS[0..N) 중 하나라도 events의 일을 할 수 있을 때까지 TIMEOUT_MS ms 기다린다.
+   음수면 끝없이 기다리고 0이면 보기만 한다. 각 revents를 채우고 revents가 0이
+   아닌 수를 리턴한다. 시간이 다 되면 0.
+   처음 한 번 볼 때 fd마다 그 객체의 wait queue에 entry를 걸어 두고, 바뀌었다는
+   신호가 오면 다시 본다. 기다리는 동안 다른 user thread가 fd를 닫아도 pipe가
+   없어지지 않도록 파일의 참조를 잡아 둔다. */
+int poll (struct pollfd *ufds, int n, int timeout_ms)
+{
+	int64_t deadline = timer_ticks() + DIV_ROUND_UP((int64_t) timeout_ms * TIMER_FREQ, 1000);
+	struct pollfd *fds;
+	struct file **files;
+	struct wait_entry *entries;
+	struct semaphore sema;
+	bool first = true;
+	int ready, i;
+
+	if (n < 0 || n > POLL_MAX)
+		return -1;
+	if (n > 0 && !user_range_ok(ufds, n * sizeof *fds))
+		exit(-1);
+	fds = malloc((n + 1) * sizeof *fds);
+	files = malloc((n + 1) * sizeof *files);
+	entries = malloc((n + 1) * sizeof *entries);
+	if (fds == NULL || files == NULL || entries == NULL) {
+		ready = -1;
+		goto done;
+	}
+	if (!copy_from_user(fds, ufds, n * sizeof *fds)) {
+		free(fds);
+		free(files);
+		free(entries);
+		exit(-1);
+	}
+	for (i = 0; i < n; i++) {
+		entries[i].wq = NULL;
+		files[i] = fds[i].fd >= 0 ? find_file_by_fd(fds[i].fd) : NULL;
+		if (files[i] > 2)
+			file_share(files[i]);
+	}
+
+	sema_init(&sema, 0);
+	for (;;) {
+		ready = 0;
+		for (i = 0; i < n; i++) {
+			struct wait_entry *e = first ? &entries[i] : NULL;
+			unsigned rev = 0;
+
+			if (fds[i].fd == POLL_AIO)
+				rev = aio_poll(e, &sema);
+			else if (fds[i].fd >= 0)
+				rev = poll_file(files[i], e, &sema);
+			fds[i].revents = rev & (fds[i].events | POLLHUP | POLLNVAL);
+			if (fds[i].revents != 0)
+				ready++;
+		}
+		first = false;
+		if (ready > 0 || timeout_ms == 0)
+			break;
+		if (timeout_ms < 0)
+			sema_down(&sema);
+		else if (timer_ticks() >= deadline
+				|| !sema_down_timeout(&sema, deadline - timer_ticks()))
+			break;
+	}
+
+	for (i = 0; i < n; i++) {
+		wait_entry_remove(&entries[i]);
+		if (files[i] > 2)
+			file_close(files[i]);
+	}
+	if (!copy_to_user(ufds, fds, n * sizeof *fds))
+		ready = -1;
+done:
+	free(fds);
+	free(files);
+	free(entries);
+	return ready;
+}
+
+/* 지금 프로세스에 user thread가 있다. 아직 거두지 않은 스레드도 센다. */
+static bool multithreaded(void)
+{
+	struct thread *cur = thread_current();
+
+	return cur != cur->leader || !list_empty(&cur->uthread_list);
+}
+
 /* 버퍼에 있는 내용을 fd 파일에 작성. 파일에 작성한 바이트 반환 */
 int write(int fd, const void *buffer, unsigned size)
 {
-	check_address(buffer);
+	check_buffer(buffer, size, false);
 	int ret;
 
-	struct file *fileobj = find_file_by_fd(fd);
+	struct file *fileobj = own_file(fd);
 	if (fileobj == NULL)
 		return -1;
 
-	struct thread *curr = thread_current();
+	struct thread *curr = thread_current()->leader;
 
 	if (fileobj == STDOUT)
 	{
@@ -308,31 +1039,41 @@ int write(int fd, const void *buffer, unsigned size)
 	{
 		ret = -1;
 	}
+	else if (fileobj->pipe != NULL)
+	{
+		ret = fileobj->pipe_write ? pipe_write(fileobj->pipe, buffer, size) : -1;
+	}
+	else if (file_get_inode(fileobj) == NULL)
+	{
+		ret = -1;
+	}
 	else
 	{
-		lock_acquire(&file_rw_lock);
-		ret = file_write(fileobj, buffer, size);
-		lock_release(&file_rw_lock);
+#ifdef VM
+		/*** GrilledSalmon ***/
+		/* O_DIRECT로 연 파일에 sector 경계에서 시작하는 write는 유저 버퍼를 pin 하고
+		 * sector 전체를 덮는 부분을 buffer cache를 거치지 않고 디스크에 바로 쓴다. */
+		if (fileobj->direct && size >= DISK_SECTOR_SIZE
+				&& file_tell(fileobj) % DISK_SECTOR_SIZE == 0
+				&& vm_pin_user((void *) buffer, size)) {
+			ret = file_write_direct(fileobj, buffer, size);
+			vm_unpin_user((void *) buffer, size);
+		} else
+#endif
+		ret = file_write(fileobj, buffer, size);	// inode 단위로 lock을 잡는다.
 	}
 
-	return ret;
+	return count_io(ret, true);
 }
 
 /* 요청한 파일을 버퍼에 읽어온다. 읽어들인 바이트를 반환 */
 int read(int fd, void *buffer, unsigned size)
 {
-	check_address(buffer);
-	/*** Dongdongbro ***/
-#ifdef VM 
-	struct page *page = spt_find_page(&thread_current()->spt, buffer);
-	if (!(thread_current()->rsp<=buffer && buffer<USER_STACK) && !page->writable){
-		exit(-1);
-	}
-#endif
+	check_buffer(buffer, size, true);
 	int ret;
-	struct thread *cur = thread_current();
+	struct thread *cur = thread_current()->leader;
 
-	struct file *fileobj = find_file_by_fd(fd);
+	struct file *fileobj = own_file(fd);
 	if (fileobj == NULL)
 		return -1;
 
@@ -347,28 +1088,232 @@ int read(int fd, void *buffer, unsigned size)
 		}
 		else
 		{
-			int i;
-			unsigned char *buf = buffer;
-
-			/* 키보드로 적은(버퍼) 내용 받아옴 */
-			for (i = 0; i < size; i++)
-			{
-				char c = input_getc();
-				*buf++ = c;
-				if (c == '\0')
-					break;
-			}
-			ret = i;
+			/*** GrilledSalmon ***/
+			/* 키보드로 적은(버퍼) 내용 받아옴. 입력이 올 때까지 기다린 뒤 그때
+			 * 쌓여 있는 만큼을 한 번에 가져온다. input 큐는 인터럽트를 끄고
+			 * 읽으므로 유저 버퍼에 바로 쓰지 않고 커널 버퍼를 거친다. */
+			uint8_t keys[128];
+			size_t n = size < sizeof keys ? size : sizeof keys;
+
+			ret = input_read(keys, n);
+			if (!copy_to_user(buffer, keys, ret))
+				exit(-1);
 		}
 	}
 	else if (fileobj == STDOUT)
 	{
 		ret = -1;
 	}
+	else if (fileobj->pipe != NULL)
+	{
+		ret = fileobj->pipe_write ? -1 : pipe_read(fileobj->pipe, buffer, size);
+	}
+	else if (file_get_inode(fileobj) == NULL)
+	{
+		ret = -1;
+	}
 	else{
-		lock_acquire(&file_rw_lock);
-		ret = file_read(fileobj, buffer, size);
-		lock_release(&file_rw_lock);
+#ifdef VM
+		/*** GrilledSalmon ***/
+		/* sector 경계에서 시작하는 큰 read는 유저 버퍼를 pin 하고 buffer cache를
+		 * 거치지 않고 디스크에서 바로 읽는다. O_DIRECT로 연 파일은 sector 하나
+		 * 크기부터 그렇게 한다. */
+		if (size >= (fileobj->direct ? DISK_SECTOR_SIZE : BC_DIRECT_MIN)
+				&& file_tell(fileobj) % DISK_SECTOR_SIZE == 0
+				&& vm_pin_user(buffer, size)) {
+			ret = file_read_direct(fileobj, buffer, size);
+			vm_unpin_user(buffer, size);
+		} else
+#endif
+		ret = file_read(fileobj, buffer, size);	// inode 단위로 lock을 잡는다.
+	}
+	return count_io(ret, false);
+}
+
+/*** GrilledSalmon ***/
+/* 파일의 OFFSET부터 BUFFER로 읽는다. file position은 쓰지도 바꾸지도 않는다. */
+int pread(int fd, void *buffer, unsigned size, off_t offset)
+{
+	check_buffer(buffer, size, true);
+	struct file *fileobj = find_file_by_fd(fd);
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL || offset < 0)
+		return -1;
+	return count_io(file_read_at(fileobj, buffer, size, offset), false);
+}
+
+/* BUFFER를 파일의 OFFSET부터 쓴다. file position은 쓰지도 바꾸지도 않는다. */
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset)
+{
+	check_buffer(buffer, size, false);
+	struct file *fileobj = find_file_by_fd(fd);
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL || offset < 0)
+		return -1;
+	return count_io(file_write_at(fileobj, buffer, size, offset), true);
+}
+
+/*** GrilledSalmon ***/
+/* submission 하나를 같은 이름의 system call로 실행하고 그 결과를 리턴한다. */
+static int ring_run(const struct ring_sqe *sqe)
+{
+	switch (sqe->op) {
+	case RING_NOP:
+		return 0;
+	case RING_OPEN:
+		return open(sqe->addr);
+	case RING_CLOSE:
+		close(sqe->fd);
+		return 0;
+	case RING_READ:
+		return read(sqe->fd, sqe->addr, sqe->len);
+	case RING_WRITE:
+		return write(sqe->fd, sqe->addr, sqe->len);
+	case RING_SEEK:
+		seek(sqe->fd, sqe->offset);
+		return 0;
+	case RING_PREAD:
+		return pread(sqe->fd, sqe->addr, sqe->len, sqe->offset);
+	case RING_PWRITE:
+		return pwrite(sqe->fd, sqe->addr, sqe->len, sqe->offset);
+	default:
+		return -1;
+	}
+}
+
+/* RING의 submission queue에서 최대 TO_SUBMIT개를 차례로 실행하고 하나마다
+   completion을 올린다. completion queue가 차면 거기서 멈춘다. 실행한 수를,
+   ring의 index가 잘못되었으면 -1을 반환한다. trap 한 번에 여러 I/O를 하므로
+   작은 I/O를 많이 하는 프로그램의 system call 비용을 줄인다. */
+int ring_enter(struct sys_ring *ring, unsigned to_submit)
+{
+	unsigned sq_head, sq_tail, cq_head, cq_tail;
+	unsigned done;
+
+	if (!copy_from_user(&sq_head, &ring->sq_head, sizeof sq_head)
+			|| !copy_from_user(&sq_tail, &ring->sq_tail, sizeof sq_tail)
+			|| !copy_from_user(&cq_head, &ring->cq_head, sizeof cq_head)
+			|| !copy_from_user(&cq_tail, &ring->cq_tail, sizeof cq_tail))
+		exit(-1);
+	if (sq_tail - sq_head > RING_ENTRIES || cq_tail - cq_head > RING_ENTRIES)
+		return -1;
+
+	for (done = 0; done < to_submit && sq_head != sq_tail
+			&& cq_tail - cq_head < RING_ENTRIES; done++) {
+		struct ring_sqe sqe;
+		struct ring_cqe cqe;
+
+		if (!copy_from_user(&sqe, &ring->sq[sq_head % RING_ENTRIES], sizeof sqe))
+			exit(-1);
+		cqe.user_data = sqe.user_data;
+		cqe.res = ring_run(&sqe);
+		if (!copy_to_user(&ring->cq[cq_tail % RING_ENTRIES], &cqe, sizeof cqe))
+			exit(-1);
+		sq_head++;
+		cq_tail++;
+	}
+
+	if (!copy_to_user(&ring->sq_head, &sq_head, sizeof sq_head)
+			|| !copy_to_user(&ring->cq_tail, &cq_tail, sizeof cq_tail))
+		exit(-1);
+	return done;
+}
+
+/* IOV의 버퍼 IOVCNT개를 차례로 채우며 읽는다. 중간에 짧게 읽히면 거기서 멈추고
+   지금까지 읽은 바이트 수를 반환한다. */
+int readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	int total = 0;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX)
+		return -1;
+	for (int i = 0; i < iovcnt; i++) {
+		struct iovec v;
+		int ret;
+
+		if (!copy_from_user(&v, iov + i, sizeof v))
+			exit(-1);
+		if (v.iov_len == 0)
+			continue;
+		ret = read(fd, v.iov_base, v.iov_len);
+		if (ret < 0)
+			return total > 0 ? total : -1;
+		total += ret;
+		if ((size_t) ret < v.iov_len)
+			break;
+	}
+	return total;
+}
+
+/* IOV의 버퍼 IOVCNT개를 차례로 쓴다. 중간에 짧게 쓰이면 거기서 멈춘다. */
+int writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	int total = 0;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX)
+		return -1;
+	for (int i = 0; i < iovcnt; i++) {
+		struct iovec v;
+		int ret;
+
+		if (!copy_from_user(&v, iov + i, sizeof v))
+			exit(-1);
+		if (v.iov_len == 0)
+			continue;
+		ret = write(fd, v.iov_base, v.iov_len);
+		if (ret < 0)
+			return total > 0 ? total : -1;
+		total += ret;
+		if ((size_t) ret < v.iov_len)
+			break;
+	}
+	return total;
+}
+
+/* FD_IN의 OFF_IN부터 LEN 바이트를 FD_OUT의 OFF_OUT으로 커널 안에서 복사한다.
+   오프셋이 -1이면 그 파일의 file position을 쓰고 복사한 만큼 옮긴다.
+   같은 파일 안에서 겹치는 구간은 거부한다. 복사한 바이트 수를 반환한다. */
+int copy_file_range(int fd_in, off_t off_in, int fd_out, off_t off_out, unsigned len)
+{
+	struct file *in, *out;
+	off_t src, dst, ret;
+
+	/* position을 옮길 쪽을 먼저 이 프로세스 것으로 만든다. fd_in과 fd_out이 같은
+	   파일이면 하나를 복사할 때 다른 fd도 옮겨지므로 다시 찾는다. */
+	if ((off_in == -1 && own_file(fd_in) == NULL)
+			|| (off_out == -1 && own_file(fd_out) == NULL))
+		return -1;
+	in = find_file_by_fd(fd_in);
+	out = find_file_by_fd(fd_out);
+	if (in <= 2 || out <= 2 || file_get_inode(in) == NULL || file_get_inode(out) == NULL || off_in < -1 || off_out < -1 || (off_t) len < 0)
+		return -1;
+
+	src = off_in == -1 ? file_tell(in) : off_in;
+	dst = off_out == -1 ? file_tell(out) : off_out;
+	if (file_get_inode(in) == file_get_inode(out)
+			&& src < dst + (off_t) len && dst < src + (off_t) len)
+		return -1;
+
+	ret = file_copy_range(in, src, out, dst, len);
+	if (off_in == -1)
+		file_seek(in, src + ret);
+	if (off_out == -1)
+		file_seek(out, dst + ret);
+	count_io(ret, false);
+	return count_io(ret, true);
+}
+
+/*** GrilledSalmon ***/
+/* read/write 계열이 옮긴 RET 바이트를 지금 프로세스의 rchar 또는 wchar에
+   더하고 RET을 그대로 돌려준다. 실패(음수)는 세지 않는다. readv와 writev는
+   read와 write를 부르므로 따로 세지 않는다. */
+static int count_io(int ret, bool write)
+{
+	struct thread *t = thread_current();
+
+	if (ret > 0) {
+		if (write)
+			t->rusage.wchar += ret;
+		else
+			t->rusage.rchar += ret;
 	}
 	return ret;
 }
@@ -377,7 +1322,7 @@ void close(int fd){
 	struct file *fileobj = find_file_by_fd(fd);
 	if (fileobj == NULL)
 		return;
-	struct thread *cur = thread_current();
+	struct thread *cur = thread_current()->leader;
 
 
 	if (fd == 0 || fileobj == STDIN)
@@ -395,24 +1340,21 @@ void close(int fd){
 	if (fd <= 1 || fileobj <= 2)
 		return;
 
-	if (fileobj -> dupCount == 0)
-		file_close(fileobj);
-	else
-		fileobj->dupCount--;
+	file_close(fileobj);
 }
 
 /* 파일이 열려있다면 바이트 반환, 없다면 -1 반환 */
 int filesize(int fd)
 {
 	struct file *fileobj = find_file_by_fd(fd);
-	if (fileobj == NULL)
+	if (fileobj == NULL || (fileobj > 2 && file_get_inode(fileobj) == NULL))
 		return -1;
 	return file_length(fileobj);
 }
 
 void seek(int fd, unsigned position)
 {
-	struct file *fileobj = find_file_by_fd(fd);
+	struct file *fileobj = own_file(fd);
 	if (fileobj <= 2)
 		return;
 	fileobj->pos = position;
@@ -440,8 +1382,11 @@ int dup2(int oldfd, int newfd){
 	if (fileobj == NULL)
 		return -1;
 
-	struct thread *cur = thread_current();
-	struct file **fdt = cur->fdTable;
+	struct thread *cur = thread_current()->leader;
+
+	// newfd 자리까지 fd table을 늘린다.
+	if (newfd < 0 || !fdt_reserve(cur, newfd + 1))
+		return -1;
 
 	// Don't literally copy, but just increase its count and share the same struct file
 	// [syscall close] Only close it when count == 0
@@ -452,23 +1397,40 @@ int dup2(int oldfd, int newfd){
 	else if (fileobj == STDOUT)
 		cur->stdout_count++;
 	else
-		fileobj->dupCount++;
+		file_share(fileobj);
 
 	close(newfd);
-	fdt[newfd] = fileobj;
+	fdt_set(cur, newfd, fileobj);
 	return newfd;
 }
 
 /*** haein ***/
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
-	struct file *fileobj = find_file_by_fd(fd);
+	void *map;
 
-	if (fileobj == NULL || file_length(fileobj) == 0 || addr != pg_round_down(addr) || addr == NULL 
-		|| (int) length <= 0 || fd == 0 || fd == 1 || is_kernel_vaddr(addr) || offset != pg_round_down(offset)) {
+	if (writable & MAP_ANON) {
+		if (addr != pg_round_down(addr) || addr == NULL || (int) length <= 0 || is_kernel_vaddr(addr))
+			return NULL;
+#ifdef VM
+		map = do_mmap_anon (addr, length, writable & 1);
+#else
 		return NULL;
-	}
+#endif
+	} else {
+		struct file *fileobj = find_file_by_fd(fd);
 
-	return do_mmap (addr, length, writable, fileobj, offset);
+		if (fileobj == NULL || file_get_inode(fileobj) == NULL || file_length(fileobj) == 0 || addr != pg_round_down(addr) || addr == NULL 
+			|| (int) length <= 0 || fd == 0 || fd == 1 || is_kernel_vaddr(addr) || offset != pg_round_down(offset)) {
+			return NULL;
+		}
+
+		map = do_mmap (addr, length, writable & ~MAP_POPULATE, fileobj, offset);
+	}
+#ifdef VM
+	if (map != NULL && (writable & MAP_POPULATE))
+		vm_prefault (map, map + length, true);
+#endif
+	return map;
 }
 
 /*** haein ***/
@@ -477,3 +1439,477 @@ void munmap (void *addr) {
 		do_munmap(addr);
 	}
 }
+
+/*** GrilledSalmon ***/
+/* SIZE 바이트(page 단위로 올림)의 shared memory segment를 만들고 그 fd를
+   리턴한다. 내용은 0으로 시작한다. fd와 shm_attach 한 영역이 모두 없어지면
+   segment도 없어진다. 실패하면 -1. */
+int shm_create (size_t size)
+{
+#ifdef VM
+	size_t page_cnt = DIV_ROUND_UP(size, PGSIZE);
+	struct shm_seg *seg;
+	struct file *file;
+	int fd;
+
+	if (page_cnt == 0 || page_cnt > SHM_PAGES_MAX)
+		return -1;
+	seg = shm_seg_create(page_cnt);
+	if (seg == NULL)
+		return -1;
+	file = file_open_shm(seg);
+	if (file == NULL) {
+		shm_seg_put(seg);
+		return -1;
+	}
+	fd = add_file_to_fdt(file);
+	if (fd < 0)
+		file_close(file);
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+/* shared memory fd FD의 segment 전체를 ADDR에 매핑하고 ADDR을 리턴한다.
+   fork한 자식은 같은 segment를 매핑한 채로 시작한다. ADDR이 page 경계가
+   아니거나 다른 영역과 겹치면 NULL. */
+void *shm_attach (int fd, void *addr, bool writable)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+
+	if (fileobj <= 2 || fileobj->shm == NULL || addr == NULL
+			|| addr != pg_round_down(addr) || is_kernel_vaddr(addr))
+		return NULL;
+#ifdef VM
+	return do_shm_attach(addr, fileobj->shm, writable);
+#else
+	return NULL;
+#endif
+}
+
+/* ADDR에 shm_attach 한 영역을 뗀다. 성공하면 0, 그런 영역이 없으면 -1. */
+int shm_detach (void *addr)
+{
+#ifdef VM
+	struct vma *vma = vma_find(&thread_current()->leader->spt, addr);
+
+	if (vma == NULL || vma->start != addr || vma->shm == NULL)
+		return -1;
+	do_munmap(addr);
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* [ADDR, ADDR + LENGTH)를 어떻게 쓸지 알려준다. 성공하면 0, 잘못된 영역이거나
+ * 모르는 ADVICE면 -1. */
+int madvise (void *addr, size_t length, int advice) {
+#ifdef VM
+	return vm_madvise (addr, length, advice);
+#else
+	return -1;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* [ADDR, ADDR + LENGTH)의 mmap 한 파일에서 고쳐진 page를 파일에 쓴다. 성공하면 0,
+ * 잘못된 영역이거나 FLAGS면 -1. */
+int msync (void *addr, size_t length, int flags) {
+#ifdef VM
+	return do_msync (addr, length, flags);
+#else
+	return -1;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* program break를 INCREMENT만큼 옮기고 이전 break를 리턴한다. 실패하면 (void *) -1. */
+void *sbrk (intptr_t increment) {
+#ifdef VM
+	return vm_sbrk (increment);
+#else
+	return (void *) -1;
+#endif
+}
+
+/*** GrilledSalmon ***/
+/* 지금 프로세스의 page fault와 I/O 통계를 USAGE에 채운다. 성공하면 0. */
+int getrusage (struct rusage *usage) {
+	struct thread *t = thread_current();
+
+#ifdef VM
+	t->rusage.rss = vm_resident_pages(&t->leader->spt);
+#endif
+	if (!copy_to_user(usage, &t->rusage, sizeof *usage))
+		exit(-1);
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* FD의 파일이 적어도 LENGTH 바이트가 되도록 디스크 공간을 미리 잡는다. */
+bool fallocate (int fd, off_t length)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL || length < 0)
+		return false;
+	return file_allocate(fileobj, length);
+}
+
+/*** GrilledSalmon ***/
+/* 디렉터리 FD의 다음 항목들을 ENTS에 최대 CNT개 담고 담은 수를 리턴한다. 끝이면
+   0, 디렉터리가 아니면 -1. readdir을 항목마다 부르는 대신 한 번에 한 page
+   분량까지 채운다. */
+int getdents (int fd, struct dirent *ents, unsigned cnt)
+{
+	struct file *fileobj = own_file(fd);
+	struct dirent *buf;
+	size_t n;
+
+	if (fileobj <= 2 || !fileobj->dir)
+		return -1;
+	if (cnt > PGSIZE / sizeof *buf)
+		cnt = PGSIZE / sizeof *buf;
+	if (cnt == 0)
+		return 0;
+
+	buf = palloc_get_page(0);
+	if (buf == NULL)
+		return -1;
+	n = dir_read_entries(file_get_inode(fileobj), &fileobj->pos, buf, cnt);
+	if (!copy_to_user(ents, buf, n * sizeof *buf)) {
+		palloc_free_page(buf);
+		exit(-1);
+	}
+	palloc_free_page(buf);
+	return n;
+}
+
+/*** GrilledSalmon ***/
+/* FILE의 크기, inode 번호, 종류를 ST에 담는다. open, filesize, close를 따로
+   부르지 않아도 된다. 성공하면 0, 없는 파일이면 -1. */
+int stat (const char *file, struct stat *st)
+{
+	char *name = copy_in_string(file);
+	struct stat kst;
+	bool found;
+
+	if (name == NULL)
+		return -1;
+	found = filesys_stat(name, &kst);
+	palloc_free_page(name);
+	if (!found)
+		return -1;
+	if (!copy_to_user(st, &kst, sizeof kst))
+		exit(-1);
+	return 0;
+}
+
+/* stat과 같지만 열린 FD의 속성을 담는다. 콘솔은 S_IFCHR, pipe는 S_IFIFO이고
+   pipe의 크기는 지금 읽을 수 있는 바이트 수다. shared memory는 S_IFSHM이다.
+   channel은 S_IFCHAN이고 크기는 쌓여 있는 메시지의 바이트 수다. */
+int fstat (int fd, struct stat *st)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+	struct stat kst;
+
+	if (fileobj == NULL)
+		return -1;
+	if (fileobj <= 2) {
+		memset(&kst, 0, sizeof kst);
+		kst.type = S_IFCHR;
+		kst.nlink = 1;
+	} else if (fileobj->pipe != NULL) {
+		memset(&kst, 0, sizeof kst);
+		kst.type = S_IFIFO;
+		kst.size = pipe_available(fileobj->pipe);
+		kst.nlink = 1;
+	} else if (fileobj->chan != NULL) {
+		memset(&kst, 0, sizeof kst);
+		kst.type = S_IFCHAN;
+		kst.size = ipc_pending(fileobj->chan);
+		kst.nlink = 1;
+	} else if (fileobj->shm != NULL) {
+		memset(&kst, 0, sizeof kst);
+		kst.type = S_IFSHM;
+#ifdef VM
+		kst.size = (long long) shm_seg_pages(fileobj->shm) * PGSIZE;
+#endif
+		kst.nlink = 1;
+	} else
+		filesys_stat_inode(file_get_inode(fileobj), &kst);
+	if (!copy_to_user(st, &kst, sizeof kst))
+		exit(-1);
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* pipe를 만들어 읽는 쪽 fd를 FDS[0]에, 쓰는 쪽 fd를 FDS[1]에 담는다. 성공하면 0,
+   pipe나 fd를 만들 수 없으면 -1. fork와 spawn으로 물려준 fd로 프로세스끼리
+   주고받는다. */
+int pipe (int *fds)
+{
+	struct file *rd, *wr;
+	int kfds[2];
+
+	if (!pipe_create(&rd, &wr))
+		return -1;
+	kfds[0] = add_file_to_fdt(rd);
+	kfds[1] = kfds[0] < 0 ? -1 : add_file_to_fdt(wr);
+	if (kfds[1] < 0) {
+		if (kfds[0] >= 0)
+			remove_file_from_fdt(kfds[0]);
+		file_close(rd);
+		file_close(wr);
+		return -1;
+	}
+	if (!copy_to_user(fds, kfds, sizeof kfds)) {
+		close(kfds[0]);
+		close(kfds[1]);
+		exit(-1);
+	}
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* 메시지 channel을 만들고 그 fd를 리턴한다. fork와 spawn으로 fd를 물려주면
+   프로세스끼리 chan_send, chan_recv로 메시지를 주고받는다. 실패하면 -1. */
+int chan_create (void)
+{
+	struct ipc_chan *ch = ipc_create();
+	struct file *file;
+	int fd;
+
+	if (ch == NULL)
+		return -1;
+	file = file_open_chan(ch);
+	if (file == NULL) {
+		ipc_close(ch);
+		return -1;
+	}
+	fd = add_file_to_fdt(file);
+	if (fd < 0)
+		file_close(file);
+	return fd;
+}
+
+/* channel FD에 BUFFER의 LENGTH 바이트를 메시지 하나로 보낸다. BUFFER가 page
+   경계에서 시작하면 page 전체를 채운 부분은 복사하지 않고 받는 쪽으로 옮긴다.
+   LENGTH를 리턴하고, channel이 아니거나 너무 크면 -1. 기다리는 동안 다른 user
+   thread가 fd를 닫아도 channel이 남도록 참조를 하나 잡는다. */
+int chan_send (int fd, const void *buffer, unsigned length)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+	int ret;
+
+	if (fileobj <= 2 || fileobj->chan == NULL)
+		return -1;
+	file_share(fileobj);
+	ret = ipc_send(fileobj->chan, buffer, length);
+	file_close(fileobj);
+	return ret;
+}
+
+/* channel FD에서 가장 먼저 온 메시지를 BUFFER에 받는다. 없으면 올 때까지
+   기다린다. 메시지가 LENGTH보다 길면 나머지는 버린다. 받은 바이트 수를
+   리턴하고, channel이 아니거나 BUFFER에 쓸 수 없으면 -1. */
+int chan_recv (int fd, void *buffer, unsigned length)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+	int ret;
+
+	if (fileobj <= 2 || fileobj->chan == NULL)
+		return -1;
+	file_share(fileobj);
+	ret = ipc_recv(fileobj->chan, buffer, length);
+	file_close(fileobj);
+	return ret;
+}
+
+/*** GrilledSalmon ***/
+/* FD까지의 변경이 디스크에 남도록 journal을 commit 한다. data만 따로 쓰지
+   않고 그때까지 쌓인 것을 한 번에 commit 하므로 다른 파일의 변경도 함께 남는다. */
+int fsync (int fd)
+{
+	struct file *fileobj = find_file_by_fd(fd);
+	if (fileobj <= 2 || file_get_inode(fileobj) == NULL)
+		return -1;
+	filesys_sync();
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* 파일 시스템 통계를 ST에 담는다. 통계를 모으는 동안 page fault가 나지 않게
+   커널 버퍼에 먼저 모은다. */
+int fsstat (struct fsstat *st)
+{
+	struct fsstat *buf;
+	bool success;
+
+	buf = malloc(sizeof *buf);
+	if (buf == NULL)
+		return -1;
+	fsstat_get(buf);
+	success = copy_to_user(st, buf, sizeof *buf);
+	free(buf);
+	if (!success)
+		exit(-1);
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* SELF이면 이 프로세스의(-sysprof일 때만), 아니면 전체 system call 통계를 SP에
+   담는다. 성공하면 0. */
+int sysprof (struct sysprof *sp, bool self)
+{
+	struct sysprof *buf;
+	bool success;
+
+	buf = malloc(sizeof *buf);
+	if (buf == NULL)
+		return -1;
+	if (!sysprof_get(buf, self)) {
+		free(buf);
+		return -1;
+	}
+	success = copy_to_user(sp, buf, sizeof *buf);
+	free(buf);
+	if (!success)
+		exit(-1);
+	return 0;
+}
+
+/* SELF이면 이 스레드의, 아니면 전체 스케줄링 통계를 ST에 담는다. 언제나 0. */
+int schedstat (struct schedstat *st, bool self)
+{
+	struct schedstat buf;
+
+	thread_get_schedstat(&buf, self);
+	if (!copy_to_user(st, &buf, sizeof buf))
+		exit(-1);
+	return 0;
+}
+
+/*** GrilledSalmon ***/
+/* 이 스레드가 PERIOD_MS ms마다 DEADLINE_MS ms 안에 RUNTIME_MS ms의 CPU 시간을
+   받도록 EDF class에 예약한다. 시간은 tick으로 올려 센다. RUNTIME_MS가 0이면
+   예약을 푼다. 성공하면 0, 예약을 받아들일 수 없으면 -1. */
+int sched_edf (unsigned runtime_ms, unsigned period_ms, unsigned deadline_ms)
+{
+	int64_t runtime = DIV_ROUND_UP((int64_t) runtime_ms * TIMER_FREQ, 1000);
+	int64_t period = DIV_ROUND_UP((int64_t) period_ms * TIMER_FREQ, 1000);
+	int64_t deadline = DIV_ROUND_UP((int64_t) deadline_ms * TIMER_FREQ, 1000);
+
+	return thread_set_edf(runtime, period, deadline) ? 0 : -1;
+}
+
+/*** GrilledSalmon ***/
+/* RESOURCE를 LIMIT 바이트로 제한한다. 0이면 제한이 없다. RLIMIT_RSS를 넘은
+   프로세스는 새 frame이 필요할 때 자기 page부터 내보낸다. 성공하면 0, 모르는
+   resource이거나 VM이 없으면 -1. */
+int setrlimit (int resource, long limit)
+{
+#ifdef VM
+	if (resource == RLIMIT_RSS && limit >= 0) {
+		thread_current()->leader->rss_limit = DIV_ROUND_UP((size_t) limit, PGSIZE);
+		return 0;
+	}
+#endif
+	return -1;
+}
+
+/* 디스크를 붙일 하위 디렉터리와 경로 해석이 아직 없어서 mount는 언제나
+   실패한다. 모르는 system call이라고 프로세스를 죽이지 않고 -1을 돌려준다. */
+int mount (const char *path, int chan_no UNUSED, int dev_no UNUSED)
+{
+	char *name = copy_in_string(path);
+
+	if (name != NULL)
+		palloc_free_page(name);
+	return -1;
+}
+
+int umount (const char *path)
+{
+	char *name = copy_in_string(path);
+
+	if (name != NULL)
+		palloc_free_page(name);
+	return -1;
+}
+
+/* *UADDR이 아직 EXPECTED라면 futex_wake가 깨워줄 때까지 잠든다. TIMEOUT_MS가
+   0 이상이면 최대 그만큼만 잔다.
+   깨어났으면 0, 값이 이미 바뀌어 있었다면 잠들지 않고 -1, 시간이 다 되었으면
+   -2를 반환한다. */
+int futex_wait (int *uaddr, int expected, int timeout_ms)
+{
+	if ((uint64_t) uaddr % sizeof (int) != 0)
+		return -1;
+
+	struct thread *cur = thread_current();
+	struct futex_bucket *b = futex_bucket(cur->pml4, uaddr);
+	struct futex_waiter waiter;
+	int val;
+
+	/* 값 비교와 대기열 등록을 버킷 lock 아래에서 하므로 그 사이의 wake를 놓치지 않는다. */
+	lock_acquire(&b->lock);
+	if (!copy_from_user(&val, uaddr, sizeof val)) {
+		lock_release(&b->lock);
+		exit(-1);
+	}
+	if (val != expected) {
+		lock_release(&b->lock);
+		return -1;
+	}
+	waiter.pml4 = cur->pml4;
+	waiter.uaddr = uaddr;
+	sema_init(&waiter.sema, 0);
+	list_push_back(&b->waiters, &waiter.elem);
+	lock_release(&b->lock);
+
+	if (timeout_ms < 0) {
+		sema_down(&waiter.sema);
+		return 0;
+	}
+	/*** GrilledSalmon ***/
+	if (sema_down_timeout(&waiter.sema, DIV_ROUND_UP ((int64_t) timeout_ms * TIMER_FREQ, 1000)))
+		return 0;
+	/* futex_wake는 버킷 lock 아래에서 waiter를 빼고 sema를 올린다. 그 사이에
+	   왔다면 깨어난 것으로 친다. */
+	lock_acquire(&b->lock);
+	if (sema_try_down(&waiter.sema)) {
+		lock_release(&b->lock);
+		return 0;
+	}
+	list_remove(&waiter.elem);
+	lock_release(&b->lock);
+	return -2;
+}
+
+/* UADDR에서 잠든 스레드를 최대 N개 깨우고, 깨운 수를 반환한다. */
+int futex_wake (int *uaddr, int n)
+{
+	if (!user_fault_in(uaddr, sizeof (int), false))
+		exit(-1);
+
+	struct thread *cur = thread_current();
+	struct futex_bucket *b = futex_bucket(cur->pml4, uaddr);
+	struct list_elem *e;
+	int woken = 0;
+
+	lock_acquire(&b->lock);
+	for (e = list_begin(&b->waiters); e != list_end(&b->waiters) && woken < n; ) {
+		struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+		if (w->pml4 == cur->pml4 && w->uaddr == uaddr) {
+			e = list_remove(e);
+			sema_up(&w->sema);
+			woken++;
+		} else
+			e = list_next(e);
+	}
+	lock_release(&b->lock);
+	return woken;
+}
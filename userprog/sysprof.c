@@ -0,0 +1,167 @@
+/* sysprof.c: System call counts and latency histograms. */
+
+#include "userprog/sysprof.h"
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/*** GrilledSalmon ***/
+/* system call 번호마다 호출 수, 걸린 TSC cycle의 합과 log2 histogram을 모은다.
+ * 전체 통계는 언제나 세고 lock 대신 잠깐 interrupt를 끄고 더한다.
+ * -sysprof이면 프로세스마다 첫 system call 때 struct sysprof를 만들어 따로
+ * 세며, 그 프로세스만 건드리므로 interrupt를 끌 필요가 없다. */
+bool sysprof_enabled;
+
+static struct sysprof global;
+
+static const char *call_names[SYS_CNT] = {
+	[SYS_HALT] = "halt",
+	[SYS_EXIT] = "exit",
+	[SYS_FORK] = "fork",
+	[SYS_EXEC] = "exec",
+	[SYS_WAIT] = "wait",
+	[SYS_CREATE] = "create",
+	[SYS_REMOVE] = "remove",
+	[SYS_OPEN] = "open",
+	[SYS_FILESIZE] = "filesize",
+	[SYS_READ] = "read",
+	[SYS_WRITE] = "write",
+	[SYS_SEEK] = "seek",
+	[SYS_TELL] = "tell",
+	[SYS_CLOSE] = "close",
+	[SYS_MMAP] = "mmap",
+	[SYS_MUNMAP] = "munmap",
+	[SYS_CHDIR] = "chdir",
+	[SYS_MKDIR] = "mkdir",
+	[SYS_READDIR] = "readdir",
+	[SYS_ISDIR] = "isdir",
+	[SYS_INUMBER] = "inumber",
+	[SYS_SYMLINK] = "symlink",
+	[SYS_DUP2] = "dup2",
+	[SYS_MOUNT] = "mount",
+	[SYS_UMOUNT] = "umount",
+	[SYS_FUTEX_WAIT] = "futex_wait",
+	[SYS_FUTEX_WAKE] = "futex_wake",
+	[SYS_MADVISE] = "madvise",
+	[SYS_GETRUSAGE] = "getrusage",
+	[SYS_FALLOCATE] = "fallocate",
+	[SYS_PREAD] = "pread",
+	[SYS_PWRITE] = "pwrite",
+	[SYS_READV] = "readv",
+	[SYS_WRITEV] = "writev",
+	[SYS_COPY_FILE_RANGE] = "copy_file_range",
+	[SYS_FSYNC] = "fsync",
+	[SYS_FSSTAT] = "fsstat",
+	[SYS_SPAWN] = "spawn",
+	[SYS_RING_ENTER] = "ring_enter",
+	[SYS_SYSPROF] = "sysprof",
+	[SYS_EXECVE] = "execve",
+	[SYS_SBRK] = "sbrk",
+	[SYS_SCHEDSTAT] = "schedstat",
+	[SYS_SETRLIMIT] = "setrlimit",
+	[SYS_MSYNC] = "msync",
+	[SYS_OPEN2] = "open2",
+};
+
+/* 지금 프로세스의 통계. -sysprof가 아니거나 메모리가 없으면 NULL. */
+static struct sysprof *
+current_sysprof (void) {
+	struct thread *t = thread_current ();
+
+	if (sysprof_enabled && t->sysprof == NULL)
+		t->sysprof = calloc (1, sizeof *t->sysprof);
+	return t->sysprof;
+}
+
+/* NR번 system call에 들어왔다. 리턴값을 sysprof_end에 넘긴다. */
+uint64_t
+sysprof_begin (int nr) {
+	struct sysprof *self = current_sysprof ();
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	global.calls[nr]++;
+	intr_set_level (old_level);
+	if (self != NULL)
+		self->calls[nr]++;
+	return rdtsc ();
+}
+
+/* sysprof_begin이 START를 리턴한 뒤로 NR번 system call에 걸린 시간을 더한다. */
+void
+sysprof_end (int nr, uint64_t start) {
+	uint64_t cycles = rdtsc () - start;
+	struct sysprof *self = thread_current ()->sysprof;
+	enum intr_level old_level;
+	uint64_t c = cycles;
+	int bucket = 0;
+
+	while (c > 1 && bucket < SYSPROF_BUCKETS - 1) {
+		c >>= 1;
+		bucket++;
+	}
+
+	old_level = intr_disable ();
+	global.cycles[nr] += cycles;
+	global.latency[nr][bucket]++;
+	intr_set_level (old_level);
+	if (self != NULL) {
+		self->cycles[nr] += cycles;
+		self->latency[nr][bucket]++;
+	}
+}
+
+/* SELF이면 지금 프로세스의, 아니면 전체 통계를 SP에 담는다. 프로세스마다 세지
+   않는 중이면 false. */
+bool
+sysprof_get (struct sysprof *sp, bool self) {
+	enum intr_level old_level;
+
+	if (self) {
+		if (thread_current ()->sysprof == NULL)
+			return false;
+		memcpy (sp, thread_current ()->sysprof, sizeof *sp);
+		return true;
+	}
+	old_level = intr_disable ();
+	memcpy (sp, &global, sizeof *sp);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* 끝나는 프로세스 T의 통계를 돌려준다. */
+void
+sysprof_exit (struct thread *t) {
+	free (t->sysprof);
+	t->sysprof = NULL;
+}
+
+/* Prints system call statistics. */
+void
+sysprof_print (void) {
+	static struct sysprof sp;
+	int nr, b;
+
+	sysprof_get (&sp, false);
+	printf ("System calls:\n");
+	for (nr = 0; nr < SYS_CNT; nr++) {
+		long returned = 0;
+
+		if (sp.calls[nr] == 0)
+			continue;
+		for (b = 0; b < SYSPROF_BUCKETS; b++)
+			returned += sp.latency[nr][b];
+		printf ("  %s: %ld calls, %lld cycles", call_names[nr], sp.calls[nr],
+				sp.cycles[nr]);
+		if (returned != 0)
+			printf (" (%lld avg)", sp.cycles[nr] / returned);
+		printf (", log2 cycles");
+		for (b = 0; b < SYSPROF_BUCKETS; b++)
+			if (sp.latency[nr][b] != 0)
+				printf (" %d:%ld", b, sp.latency[nr][b]);
+		printf ("\n");
+	}
+}
@@ -0,0 +1,136 @@
+#include "userprog/usercopy.h"
+#include "threads/vaddr.h"
+
+/*** GrilledSalmon ***/
+/* Exception table.  유저 메모리에 접근하다 fault가 날 수 있는 명령(INSN)마다
+   fault가 났을 때 대신 이어서 실행할 주소(FIXUP)를 __ex_table section에 적어
+   둔다.  커널에서 유저 주소에 난 page fault를 VM이 처리하지 못하면
+   page_fault()가 usercopy_fixup()으로 fault가 난 rip를 찾아 FIXUP으로 돌아간다.
+   덕분에 system call마다 SPT를 찾아보며 주소를 검사하지 않아도 된다. */
+struct ex_entry {
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+/* threads/kernel.lds.S에서 정의한다. */
+extern const struct ex_entry __start_ex_table[], __stop_ex_table[];
+
+#define EX_TABLE(INSN, FIXUP)                          \
+	".pushsection __ex_table, \"a\"\n"                 \
+	".balign 8\n"                                      \
+	".quad " #INSN ", " #FIXUP "\n"                    \
+	".popsection\n"
+
+/* [UADDR, UADDR + SIZE)가 모두 유저 영역인지. 끝이 넘치는 경우도 거른다. */
+bool
+user_range_ok (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+
+	return start + size >= start && start + size <= KERN_BASE;
+}
+
+/* SRC에서 DST로 SIZE 바이트를 복사하고 복사하지 못한 바이트 수를 리턴한다.
+   rep movsb는 fault가 나면 그때까지 옮긴 만큼 rdi, rsi, rcx가 맞춰져 있으므로
+   fixup은 복사 바로 뒤로 건너뛰기만 하면 된다. */
+static size_t
+copy_user (void *dst, const void *src, size_t size) {
+	asm volatile ("1: rep movsb\n"
+	              "2:\n"
+	              EX_TABLE (1b, 2b)
+	              : "+D" (dst), "+S" (src), "+c" (size)
+	              : : "memory");
+	return size;
+}
+
+/* 유저 주소 UADDR의 바이트를 읽는다. fault가 나면 -1. */
+static int
+get_user (const uint8_t *uaddr) {
+	int byte;
+
+	asm volatile ("1: movzbl %1, %0\n"
+	              "   jmp 3f\n"
+	              "2: movl $-1, %0\n"
+	              "3:\n"
+	              EX_TABLE (1b, 2b)
+	              : "=r" (byte) : "m" (*uaddr));
+	return byte;
+}
+
+/* 유저 주소 UADDR의 바이트를 바꾸지 않고 써 본다. COW나 zero page이면 이때
+   자기 frame을 받는다. fault가 나면 false. */
+static bool
+touch_user (uint8_t *uaddr) {
+	int ok = 1;
+
+	asm volatile ("1: lock orb $0, %1\n"
+	              "   jmp 3f\n"
+	              "2: xorl %0, %0\n"
+	              "3:\n"
+	              EX_TABLE (1b, 2b)
+	              : "+r" (ok), "+m" (*uaddr));
+	return ok;
+}
+
+/* 유저 주소 USRC에서 DST로 SIZE 바이트를 복사한다. 성공하면 true. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	return user_range_ok (usrc, size) && copy_user (dst, usrc, size) == 0;
+}
+
+/* SRC의 SIZE 바이트를 유저 주소 UDST로 복사한다. 성공하면 true. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	return user_range_ok (udst, size) && copy_user (udst, src, size) == 0;
+}
+
+/* 유저 문자열 USRC를 널 문자까지 DST로 복사하고 그 길이를 리턴한다. SIZE
+   바이트 안에 널 문자가 없으면 SIZE를 리턴하고 DST는 널 문자로 끝나지 않는다.
+   읽을 수 없는 주소를 만나면 -1. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	const uint8_t *src = (const uint8_t *) usrc;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		int c;
+
+		if (!is_user_vaddr (src + i) || (c = get_user (src + i)) == -1)
+			return -1;
+		dst[i] = c;
+		if (c == '\0')
+			return i;
+	}
+	return size;
+}
+
+/* [UADDR, UADDR + SIZE)의 page를 하나씩 건드려 메모리에 올린다. WRITE이면
+   쓸 수 있는지도 본다. 커널이 이 버퍼를 바로 읽고 쓰기 전에 잘못된 버퍼를
+   걸러 내는 데 쓴다. 주소가 잘못되었으면 false. */
+bool
+user_fault_in (const void *uaddr, size_t size, bool write) {
+	uint8_t *p = (uint8_t *) uaddr;
+	uint8_t *end = p + size;
+
+	if (!user_range_ok (uaddr, size))
+		return false;
+	if (size == 0)
+		return true;
+	while (true) {
+		if (write ? !touch_user (p) : get_user (p) == -1)
+			return false;
+		p = (uint8_t *) pg_round_down (p) + PGSIZE;
+		if (p >= end)
+			return true;
+	}
+}
+
+/* 커널의 RIP에서 난 fault를 이어서 처리할 주소. exception table에 없으면 0. */
+uintptr_t
+usercopy_fixup (uintptr_t rip) {
+	const struct ex_entry *e;
+
+	for (e = __start_ex_table; e < __stop_ex_table; e++)
+		if (e->insn == rip)
+			return e->fixup;
+	return 0;
+}
@@ -1,11 +1,37 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #include "devices/disk.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <round.h>
 #include "bitmap.h"
 #include "threads/vaddr.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vmalloc.h"
 
 #define PG_PER_SEC (PGSIZE/DISK_SECTOR_SIZE)
+/* 한 번에 잡아 두는 연속된 slot 수. 이어서 swap out 되는 page들이 디스크에서도 붙어 있게 된다. */
+#define SWAP_CLUSTER 16
+/* swap을 나눠 담을 수 있는 디스크 수. 두 채널에 두 개씩이다. */
+#define SWAP_DISK_MAX 4
+/* swap in 할 때 같은 디스크에서 함께 읽어 오는 최대 slot 수. */
+#define SWAP_READAHEAD 8
+/* swap file이 가질 수 있는 최대 slot 수. slot 표는 처음부터 이만큼 잡는다. */
+#define SWAP_FILE_MAX_MB 64
+#define SWAP_FILE_SLOTS_MAX ((size_t) SWAP_FILE_MAX_MB * 1024 * 1024 / PGSIZE)
+/* swap file을 한 번에 늘리는 slot 수. 이어진 cluster가 없으면 SWAP_CLUSTER까지
+ * 반씩 줄여 본다. */
+#define SWAP_FILE_GROW 1024
+/* 기억해 둘 수 있는 swap file extent 수. */
+#define SWAP_EXTENT_MAX 256
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -13,6 +39,63 @@ static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
 static struct bitmap *swap_table;
+/* slot마다 그 slot을 쓰는 page 수. COW fork 후에는 여러 page가 한 slot을 같이 쓴다. */
+static uint16_t *slot_refs;
+/* 잡아 둔 cluster에서 다음에 내줄 slot과 남은 slot 수. */
+static size_t cluster_next;
+static size_t cluster_left;
+/* swap_table, slot_refs, cluster_next, cluster_left를 보호한다. */
+static struct lock swap_lock;
+
+/*** GrilledSalmon ***/
+/* -swap=C:D,... 로 받은 swap 디스크 목록. NULL이면 hd1:1 하나만 쓴다. */
+char *swap_disk_spec;
+/* slot을 나눠 담는 디스크들. slot S는 swap_disks[S % swap_disk_cnt]의
+ * S / swap_disk_cnt 번째 칸에 있으므로, 이어서 잡은 slot은 디스크를 번갈아
+ * 가며 놓이고 각 디스크 안에서는 차례로 붙는다. */
+static struct disk *swap_disks[SWAP_DISK_MAX];
+static size_t swap_disk_cnt;
+
+/*** GrilledSalmon ***/
+/* -swapfile=NAME[:MB]. 주면 swap 디스크 대신 파일 시스템의 NAME 파일에 swap
+ * 한다. 파일은 없으면 MB (기본 4) 크기로 만들고, slot이 모자라면 디스크에서
+ * 이어진 cluster로 SWAP_FILE_GROW slot씩 늘린다.
+ *
+ * 파일 안에서 slot S는 S * PGSIZE 바이트에 있다. 파일이 디스크에서 이어진
+ * 구간마다 extent 하나를 두어 slot을 sector로 바로 바꾸므로, swap I/O는 buffer
+ * cache를 거치지 않고 swap 디스크처럼 page 하나를 한 번의 요청으로 옮긴다.
+ * 디스크에서 두 구간에 걸친 slot은 쓰지 않는다. 파일은 열어 둔 채 쓰기를 막아
+ * 두므로 다른 프로세스가 쓰거나 defrag가 옮기지 못한다. */
+char *swap_file_spec;
+static struct file *swap_file;
+
+/* 파일의 SLOT부터 CNT개 slot이 filesys_disk의 SECTOR부터 이어져 있다. 한 번
+ * 더한 extent는 바뀌지 않고 (CNT는 늘 수만 있다) slot을 내주기 전에 더하므로
+ * slot_locate는 lock 없이 본다. */
+struct swap_extent {
+	size_t slot;
+	size_t cnt;
+	disk_sector_t sector;
+};
+static struct swap_extent swap_extents[SWAP_EXTENT_MAX];
+static size_t swap_extent_cnt;
+static off_t swap_file_mapped;          /* extent로 옮긴 파일 길이. */
+static size_t swap_file_slots;          /* 쓸 수 있는 slot 수. */
+static struct lock swap_grow_lock;      /* 늘리기를 한 번에 하나씩 한다. */
+static unsigned swap_grow_gen;          /* 늘릴 때마다 는다. swap_lock이 보호한다. */
+
+/* Swap-in readahead window.  같은 디스크에서 ra_base부터 이어지는 ra_cnt개의
+ * slot(slot 번호로는 swap_disk_cnt씩 떨어져 있다)을 ra_buf에 한 번에 읽어 둔다.
+ * 같이 evict 된 page는 slot도 붙어 있으므로 다음 fault들은 디스크에 가지 않고
+ * 여기서 복사해 간다. ra_valid[i]는 slot이 해제되면 지운다. ra_loading인 동안은
+ * 읽는 스레드가 ra_buf를 쓰므로 아무도 보지 않는다. swap_lock이 보호한다. */
+static uint8_t *ra_buf;
+static size_t ra_base;
+static size_t ra_cnt;
+static bool ra_valid[SWAP_READAHEAD];
+static bool ra_loading;
+static size_t ra_read_cnt;              /* 미리 읽은 slot 수. */
+static size_t ra_hit_cnt;               /* 그중 fault가 가져간 수. */
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -22,14 +105,400 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
-/*** haein and Dongdongbro ***/
-/* Initialize the data for anonymous pages */
+/*** GrilledSalmon ***/
+/* swap file의 SLOT이 든 extent. */
+static const struct swap_extent *
+extent_find (size_t slot) {
+	size_t lo = 0, hi = swap_extent_cnt;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		const struct swap_extent *e = &swap_extents[mid];
+
+		if (slot < e->slot)
+			hi = mid;
+		else if (slot >= e->slot + e->cnt)
+			lo = mid + 1;
+		else
+			return e;
+	}
+	NOT_REACHED ();
+}
+
+/*** GrilledSalmon ***/
+/* SLOT이 놓인 디스크를 리턴하고, 그 디스크에서의 첫 sector를 *SEC_NO에 담는다. */
+static struct disk *
+slot_locate (size_t slot, disk_sector_t *sec_no) {
+	if (swap_file != NULL) {
+		const struct swap_extent *e = extent_find (slot);
+
+		*sec_no = e->sector + (slot - e->slot) * PG_PER_SEC;
+		return filesys_disk;
+	}
+	*sec_no = slot / swap_disk_cnt * PG_PER_SEC;
+	return swap_disks[slot % swap_disk_cnt];
+}
+
+/* 같은 디스크에서 SLOT 바로 뒤의 slot이 디스크에서도 바로 뒤에 있으면 true. */
+static bool
+slot_next_adjacent (size_t slot) {
+	const struct swap_extent *e;
+
+	if (swap_file == NULL)
+		return true;
+	e = extent_find (slot);
+	return slot + 1 < e->slot + e->cnt;
+}
+
+/*** GrilledSalmon ***/
+/* zswap에서 밀려난 PAGE를 SLOT에 쓴다. */
+static void
+anon_write_slot (size_t slot, const void *page) {
+	disk_sector_t sec_no;
+	struct disk *d = slot_locate(slot, &sec_no);
+
+	disk_write_multiple(d, sec_no, page, PG_PER_SEC);
+}
+
+/*** GrilledSalmon ***/
+/* "C:D" 꼴의 NAME이 가리키는 디스크를 swap 디스크 목록에 더한다. 없는 디스크나
+ * 부트 디스크, 파일 시스템 디스크, 이미 넣은 디스크는 알리고 건너뛴다. */
+static void
+add_swap_disk (const char *name) {
+	int chan_no, dev_no;
+	struct disk *d;
+	size_t i;
+
+	if (strlen(name) != 3 || name[1] != ':'
+			|| name[0] < '0' || name[0] > '1' || name[2] < '0' || name[2] > '1') {
+		printf("swap: bad disk `%s', expected C:D\n", name);
+		return;
+	}
+	chan_no = name[0] - '0';
+	dev_no = name[2] - '0';
+	if (chan_no == 0) {
+		printf("swap: hd%s holds the kernel or the file system, skipped\n", name);
+		return;
+	}
+	d = disk_get(chan_no, dev_no);
+	if (d == NULL) {
+		printf("swap: hd%s not present, skipped\n", name);
+		return;
+	}
+	for (i = 0; i < swap_disk_cnt; i++)
+		if (swap_disks[i] == d)
+			return;
+	if (swap_disk_cnt < SWAP_DISK_MAX)
+		swap_disks[swap_disk_cnt++] = d;
+}
+
+/*** GrilledSalmon ***/
+/* swap file에서 아직 extent로 옮기지 않은 부분을 extent로 옮기고 그 slot들을
+ * 쓸 수 있게 한다. extent가 SWAP_EXTENT_MAX개가 되면 나머지는 쓰지 않는다. */
+static void
+swap_file_map (void) {
+	struct inode *inode = file_get_inode (swap_file);
+	off_t length = ROUND_DOWN (inode_length (inode), PGSIZE);
+	off_t pos = ROUND_UP (swap_file_mapped, PGSIZE);
+
+	while (pos < length) {
+		size_t sectors, slots, slot = pos / PGSIZE;
+		disk_sector_t sector = inode_map (inode, pos, &sectors);
+		struct swap_extent *last = swap_extent_cnt > 0
+			? &swap_extents[swap_extent_cnt - 1] : NULL;
+
+		if (sector == (disk_sector_t) -1)
+			break;
+		slots = sectors / PG_PER_SEC;
+		if (slot + slots > SWAP_FILE_SLOTS_MAX)
+			slots = SWAP_FILE_SLOTS_MAX - slot;
+		if (slots == 0) {
+			/* 다음 구간에 걸친다. */
+			pos += PGSIZE;
+			continue;
+		}
+		if (last != NULL && last->slot + last->cnt == slot
+				&& last->sector + last->cnt * PG_PER_SEC == sector)
+			last->cnt += slots;
+		else if (swap_extent_cnt < SWAP_EXTENT_MAX)
+			swap_extents[swap_extent_cnt++] = (struct swap_extent) {
+				.slot = slot, .cnt = slots, .sector = sector,
+			};
+		else
+			break;
+
+		lock_acquire(&swap_lock);
+		bitmap_set_multiple(swap_table, slot, slots, false);
+		swap_file_slots += slots;
+		lock_release(&swap_lock);
+		pos += (off_t) slots * PGSIZE;
+	}
+	swap_file_mapped = pos;
+}
+
+/*** GrilledSalmon ***/
+/* swap file 끝에 디스크에서 이어진 cluster를 잡아 slot을 늘린다. GEN은 부른
+ * 쪽이 slot이 모자란 것을 보았을 때의 swap_grow_gen이다. 그 사이 다른 스레드가
+ * 늘렸으면 다시 늘리지 않는다. 새 slot이 생겼으면 true. */
+static bool
+swap_file_grow (unsigned gen) {
+	struct inode *inode = file_get_inode (swap_file);
+	size_t before = swap_file_slots;
+	size_t slots;
+	off_t base;
+
+	lock_acquire(&swap_grow_lock);
+	if (gen != swap_grow_gen) {
+		lock_release(&swap_grow_lock);
+		return true;
+	}
+	base = ROUND_UP (inode_length (inode), PGSIZE);
+	for (slots = SWAP_FILE_GROW; slots >= SWAP_CLUSTER; slots /= 2) {
+		if ((size_t) base / PGSIZE + slots > SWAP_FILE_SLOTS_MAX)
+			continue;
+		if (inode_allocate_run (inode, base + (off_t) slots * PGSIZE)) {
+			swap_file_map ();
+			break;
+		}
+	}
+	lock_acquire(&swap_lock);
+	swap_grow_gen++;
+	lock_release(&swap_lock);
+	lock_release(&swap_grow_lock);
+	return swap_file_slots > before;
+}
+
+/*** GrilledSalmon ***/
+/* -swapfile로 받은 파일을 열어 swap file로 쓴다. 없으면 만든다. */
+static void
+swap_file_open (void) {
+	char *spec = malloc(strlen(swap_file_spec) + 1);
+	char *colon;
+	int mb = SWAP_FILE_GROW * PGSIZE / (1024 * 1024);
+
+	if (spec == NULL)
+		PANIC("swap file name allocation failed");
+	strlcpy(spec, swap_file_spec, strlen(swap_file_spec) + 1);
+	colon = strrchr(spec, ':');
+	if (colon != NULL) {
+		*colon = '\0';
+		mb = atoi(colon + 1);
+		if (mb < 1 || mb > SWAP_FILE_MAX_MB)
+			PANIC("swap file size must be 1 to %d MB", SWAP_FILE_MAX_MB);
+	}
+	swap_file = filesys_open(spec);
+	if (swap_file == NULL && filesys_create(spec, (off_t) mb * 1024 * 1024))
+		swap_file = filesys_open(spec);
+	if (swap_file == NULL)
+		PANIC("swap file `%s' cannot be opened", spec);
+	file_deny_write(swap_file);
+	free(spec);
+}
+
 void
 vm_anon_init (void) {
 	/* TODO: Set up the swap_disk. */
 	swap_disk = disk_get(1,1);
-	size_t bit_cnt = disk_size(swap_disk) / PG_PER_SEC;
+
+	/*** GrilledSalmon ***/
+	if (swap_file_spec != NULL) {
+		swap_file_open();
+		swap_disks[swap_disk_cnt++] = filesys_disk;
+		swap_disk_spec = NULL;
+	}
+
+	/*** GrilledSalmon ***/
+	/* -swap으로 여러 디스크를 받으면 slot을 번갈아 놓아 swap I/O가 디스크와
+	 * 채널에 고루 퍼지게 한다. 가장 작은 디스크에 맞춰 slot 수를 정한다. */
+	if (swap_disk_spec != NULL) {
+		char *spec = malloc(strlen(swap_disk_spec) + 1);
+		char *name, *save_ptr;
+
+		if (spec == NULL)
+			PANIC("swap disk list allocation failed");
+		strlcpy(spec, swap_disk_spec, strlen(swap_disk_spec) + 1);
+		for (name = strtok_r(spec, ",", &save_ptr); name != NULL;
+				name = strtok_r(NULL, ",", &save_ptr))
+			add_swap_disk(name);
+		free(spec);
+	}
+	if (swap_disk_cnt == 0) {
+		if (swap_disk == NULL)
+			PANIC("hd1:1 (swap) not present");
+		swap_disks[swap_disk_cnt++] = swap_disk;
+	}
+	swap_disk = swap_disks[0];
+
+	size_t per_disk = SIZE_MAX;
+	for (size_t i = 0; i < swap_disk_cnt; i++)
+		if (disk_size(swap_disks[i]) / PG_PER_SEC < per_disk)
+			per_disk = disk_size(swap_disks[i]) / PG_PER_SEC;
+	size_t bit_cnt = per_disk * swap_disk_cnt;
+	if (swap_file != NULL)
+		bit_cnt = SWAP_FILE_SLOTS_MAX;
+	else if (swap_disk_cnt > 1)
+		printf("swap: %zu slots striped over %zu disks\n", bit_cnt, swap_disk_cnt);
 	swap_table = bitmap_create(bit_cnt);
+	slot_refs = kvcalloc(bit_cnt, sizeof *slot_refs);
+	if (swap_table == NULL || slot_refs == NULL)
+		PANIC("swap table allocation failed");
+	lock_init(&swap_lock);
+	/*** GrilledSalmon ***/
+	/* swap file에서는 파일이 덮는 slot만 비워 둔다. */
+	if (swap_file != NULL) {
+		lock_init(&swap_grow_lock);
+		bitmap_set_all(swap_table, true);
+		swap_file_map();
+		printf("swap: file %s, %zu slots in %zu extents\n", swap_file_spec,
+				swap_file_slots, swap_extent_cnt);
+	}
+	zswap_init(bit_cnt, anon_write_slot);
+	ra_buf = palloc_get_multiple(0, SWAP_READAHEAD);	// 없으면 미리 읽지 않는다.
+}
+
+/*** GrilledSalmon ***/
+/* SLOT이 readahead window의 몇 번째 칸인지 리턴한다. 칸이 없으면 -1이다.
+ * swap_lock을 잡고 불러야 한다. */
+static int
+ra_index (size_t slot) {
+	size_t i;
+
+	if (slot < ra_base || (slot - ra_base) % swap_disk_cnt != 0)
+		return -1;
+	i = (slot - ra_base) / swap_disk_cnt;
+	return i < ra_cnt ? (int) i : -1;
+}
+
+/*** GrilledSalmon ***/
+/* SLOT을 디스크에서 KVA로 읽는다. 같은 디스크에서 바로 뒤에 이어지는, 쓰이고 있고
+ * zswap에 없는 slot들도 한 번의 요청으로 window에 읽어 둔다. 다른 스레드가 window를
+ * 채우는 중이면 SLOT만 읽는다. */
+static void
+anon_read_slot (size_t slot, void *kva) {
+	disk_sector_t sec_no;
+	struct disk *d = slot_locate(slot, &sec_no);
+	size_t cnt = 1, i;
+
+	lock_acquire(&swap_lock);
+	if (ra_buf != NULL && !ra_loading) {
+		while (cnt < SWAP_READAHEAD) {
+			size_t next = slot + cnt * swap_disk_cnt;
+			if (next >= bitmap_size(swap_table) || slot_refs[next] == 0 || zswap_contains(next)
+					|| !slot_next_adjacent(next - swap_disk_cnt))
+				break;
+			cnt++;
+		}
+	}
+	if (cnt > 1) {
+		ra_loading = true;
+		ra_base = slot;
+		ra_cnt = cnt;
+		for (i = 0; i < cnt; i++)
+			ra_valid[i] = true;
+	}
+	lock_release(&swap_lock);
+
+	if (cnt == 1) {
+		disk_read_multiple(d, sec_no, kva, PG_PER_SEC);
+		return;
+	}
+	disk_read_multiple(d, sec_no, ra_buf, cnt * PG_PER_SEC);
+	memcpy(kva, ra_buf, PGSIZE);
+
+	lock_acquire(&swap_lock);
+	ra_loading = false;
+	ra_read_cnt += cnt - 1;
+	lock_release(&swap_lock);
+}
+
+/*** GrilledSalmon ***/
+/* 새 slot 하나를 할당해 리턴한다. 잡아 둔 cluster에서 차례로 내주고, 다 쓰면
+ * 비어 있는 SWAP_CLUSTER개짜리 구간을 통째로 잡는다. 그런 구간이 없을 만큼
+ * 조각났으면 아무 빈 slot이나 준다. swap_lock을 잡고 불러야 한다. */
+static size_t
+slot_alloc (void) {
+	size_t slot;
+
+	ASSERT (lock_held_by_current_thread (&swap_lock));
+
+	if (cluster_left == 0) {
+		slot = bitmap_scan_and_flip_next(swap_table, SWAP_CLUSTER, false);
+		if (slot != BITMAP_ERROR) {
+			cluster_next = slot;
+			cluster_left = SWAP_CLUSTER;
+		}
+	}
+	if (cluster_left > 0) {
+		cluster_left--;
+		return cluster_next++;
+	}
+	return bitmap_scan_and_flip_next(swap_table, 1, false);
+}
+
+/*** GrilledSalmon ***/
+/* SLOT의 참조 하나를 놓고 마지막이었으면 slot을 비운다. swap_lock을 잡고 불러야 한다. */
+static void
+slot_put (int slot) {
+	ASSERT (slot_refs[slot] > 0);
+	if (--slot_refs[slot] == 0) {
+		/* window를 채우는 중이어도 지워서, 그 사이 다시 할당되어 쓰인 slot을
+		 * 낡은 내용으로 읽지 않게 한다. */
+		int ra = ra_index(slot);
+		if (ra != -1)
+			ra_valid[ra] = false;
+		zswap_invalidate(slot);
+		bitmap_set(swap_table, slot, false);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 slot을 가지고 있으면 놓는다. 마지막으로 쓰던 page였으면 slot을 비운다. */
+void
+anon_drop_slot (struct page *page) {
+	int slot = page->anon.slot_number;
+
+	swap_slot_put(slot);
+	page->anon.slot_number = -1;
+}
+
+/* anon_drop_slots의 ohash_apply action. */
+static void
+drop_slot_locked (struct ohash_elem *e, void *aux UNUSED) {
+	struct page *page = ohash_entry(e, struct page, hash_elem);
+
+	if (VM_TYPE(page->operations->type) != VM_ANON || page->frame != NULL
+			|| page->anon.slot_number == -1)
+		return;
+	slot_put(page->anon.slot_number);
+	page->anon.slot_number = -1;
+}
+
+/*** GrilledSalmon ***/
+/* 끝나는 프로세스의 spt H에서 메모리에 없는 anon page들의 slot을 swap_lock을 한
+ * 번만 잡고 모두 놓는다. frame이 남은 page는 anon_destroy가 놓는다. */
+void
+anon_drop_slots (struct ohash *h) {
+	lock_acquire(&swap_lock);
+	ohash_apply(h, drop_slot_locked);
+	lock_release(&swap_lock);
+}
+
+/*** GrilledSalmon ***/
+/* DST가 SRC의 slot을 같이 쓰게 한다. 둘의 내용이 같을 때만 부른다. */
+void
+anon_share_slot (struct page *dst, struct page *src) {
+	int slot = src->anon.slot_number;
+
+	if (dst->anon.slot_number == slot)
+		return;
+	anon_drop_slot(dst);
+	if (slot != -1) {
+		lock_acquire(&swap_lock);
+		ASSERT (slot_refs[slot] < UINT16_MAX);
+		slot_refs[slot]++;
+		lock_release(&swap_lock);
+	}
+	dst->anon.slot_number = slot;
 }
 
 /*** haein ***/
@@ -56,22 +525,39 @@ anon_initializer (struct page *page, enum vm_type type, void *kva UNUSED) {
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
-	
-	int slot_number = anon_page->slot_number;
-	int sec_no = anon_page->slot_number * PG_PER_SEC;
-	void *_kva = page->frame->kva;
 
-	for (int i=0; i<PG_PER_SEC; i++) {
-		disk_read(swap_disk, sec_no, _kva);
-		_kva += DISK_SECTOR_SIZE;
-		sec_no++;
-	}
-	
-	bitmap_set(swap_table, slot_number, false);
-	anon_page->slot_number = -1;
+	ASSERT (anon_page->slot_number != -1);
+	swap_slot_load(anon_page->slot_number, kva);
 
+	/* slot은 그대로 둔다. page가 clean한 동안에는 디스크의 사본이 유효하므로
+	 * 다시 evict 될 때 쓰지 않고 frame만 버리면 된다. slot은 destroy에서 해제한다. */
 	return true;
+}
+
+/*** GrilledSalmon ***/
+/* SLOT의 내용을 KVA로 읽는다. 미리 읽어 둔 window나 zswap에 있으면 거기서
+ * 가져오고, 아니면 디스크에서 읽고 major fault로 센다. */
+void
+swap_slot_load (int slot_number, void *kva) {
+	int ra;
 
+	/* 앞선 fault가 미리 읽어 두었으면 디스크에 가지 않으므로 minor fault다. */
+	lock_acquire(&swap_lock);
+	ra = ra_loading ? -1 : ra_index(slot_number);
+	if (ra != -1 && !ra_valid[ra])
+		ra = -1;
+	if (ra != -1) {
+		memcpy(kva, ra_buf + ra * PGSIZE, PGSIZE);
+		ra_hit_cnt++;
+	}
+	lock_release(&swap_lock);
+	if (ra != -1)
+		return;
+
+	thread_current()->rusage.majflt++;
+	/* zswap에 있으면 압축을 풀고, 없거나 이미 디스크로 밀려났으면 slot에서 읽는다. */
+	if (!zswap_load(slot_number, kva))
+		anon_read_slot(slot_number, kva);
 }
 
 /*** GrilledSalmon ***/
@@ -80,30 +566,79 @@ static bool
 anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
 
-	anon_page->slot_number = bitmap_scan_and_flip(swap_table, 0, 1, false);
-	if (anon_page->slot_number == BITMAP_ERROR) {
-		PANIC("Ran Out of Swap Partition!!!");
+	if (anon_page->slot_number != -1) {
+		/* swap in 한 뒤로 수정되지 않았으면 slot의 내용이 그대로 맞다. */
+		if (!vm_frame_is_dirty(page->frame))
+			return true;
+		/* 낡은 slot은 다른 page가 같이 쓰고 있을 수 있으니 덮어쓰지 않고 놓는다. */
+		anon_drop_slot(page);
 	}
-	
-	int sec_no = anon_page->slot_number * PG_PER_SEC;
-	void *kva = page->frame->kva;
+	anon_page->slot_number = swap_slot_store(page->frame->kva);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* 새 slot을 잡아 KVA의 내용을 쓰고 그 slot을 리턴한다. 참조 수는 1이고
+ * swap_slot_put으로 놓는다. */
+int
+swap_slot_store (const void *kva) {
+	lock_acquire(&swap_lock);
+	size_t slot = slot_alloc();
+	/*** GrilledSalmon ***/
+	/* swap file이면 늘려 보고 다시 잡는다. 늘리는 동안 파일 시스템 lock을
+	 * 잡으므로 swap_lock은 놓는다. */
+	while (slot == BITMAP_ERROR && swap_file != NULL) {
+		unsigned gen = swap_grow_gen;
 
-	for (int i=0; i<PG_PER_SEC; i++) {
-		disk_write(swap_disk, sec_no, kva);
-		kva += DISK_SECTOR_SIZE;
-		sec_no++;
+		lock_release(&swap_lock);
+		if (!swap_file_grow(gen)) {
+			lock_acquire(&swap_lock);
+			slot = slot_alloc();
+			break;
+		}
+		lock_acquire(&swap_lock);
+		slot = slot_alloc();
+	}
+	if (slot == BITMAP_ERROR) {
+		PANIC("Ran Out of Swap Partition!!!");
 	}
+	slot_refs[slot] = 1;
+	lock_release(&swap_lock);
 
-	return true;
+	/* slot은 항상 잡아 두고, 압축이 되면 내용만 zswap에 둔다. 그래야 COW로 공유된
+	 * slot의 참조 수와 clean page의 재사용이 zswap과 상관없이 그대로 동작한다. */
+	if (!zswap_store(slot, kva))
+		anon_write_slot(slot, kva);
+	return slot;
+}
+
+/*** GrilledSalmon ***/
+/* SLOT의 참조 하나를 놓는다. -1이면 아무것도 하지 않는다. */
+void
+swap_slot_put (int slot) {
+	if (slot == -1)
+		return;
+	lock_acquire(&swap_lock);
+	slot_put(slot);
+	lock_release(&swap_lock);
+}
+
+/*** GrilledSalmon ***/
+/* Prints swap-in readahead statistics. */
+void
+anon_print_stats (void) {
+	if (ra_read_cnt > 0)
+		printf("Swap: %zu slots read ahead, %zu hit\n", ra_read_cnt, ra_hit_cnt);
+	if (swap_file != NULL)
+		printf("Swap: file has %zu slots in %zu extents\n", swap_file_slots,
+				swap_extent_cnt);
 }
 
 /*** Dongdongbro ***/
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
-	if(anon_page->slot_number != -1){
-		bitmap_set(swap_table, anon_page->slot_number, 0);
-	}
-	free(page->frame);
+	/* evict 중이면 vm_free_frame이 끝날 때까지 기다려 주므로 slot은 그 다음에 놓는다. */
+	vm_free_frame(page);
+	anon_drop_slot(page);
 }
@@ -1,14 +1,16 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include <round.h>
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/slab.h"
+#include <syscall-nr.h>
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
-static bool lazy_load_file (struct page *page, void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
@@ -46,13 +48,14 @@ static bool
 file_backed_swap_in (struct page *page, void *kva) {
 	struct file_page *file_page = &page->file;
 	struct file *file = file_page->file;
-	file_seek(file, file_page->ofs);
+	thread_current()->rusage.majflt++;
 
-	if(file_read(file, page->frame->kva, file_page->read_bytes) != (int) file_page->read_bytes){
+	/* fork한 프로세스들이 같은 file을 같이 쓰므로 position을 쓰지 않고 읽는다. */
+	if(file_read_at(file, kva, file_page->read_bytes, file_page->ofs) != (int) file_page->read_bytes){
 		return false;
 	}
 
-	memset(page->frame->kva + file_page->read_bytes, 0, PGSIZE - file_page->read_bytes);
+	memset(kva + file_page->read_bytes, 0, PGSIZE - file_page->read_bytes);
 	return true;
 }
 
@@ -61,11 +64,12 @@ file_backed_swap_in (struct page *page, void *kva) {
 static bool
 file_backed_swap_out (struct page *page) {
 	struct file_page *file_page = &page->file;
-	uint64_t current_pml4 = page->frame->pml4;
 
-	if(pml4_is_dirty(current_pml4, page->va)){
-		file_write_at(file_page->file, page->va, file_page->read_bytes, file_page->ofs);
-		pml4_set_dirty(current_pml4, page->va, false);
+	/* clean page는 파일의 내용과 같으므로 frame만 버린다. */
+	if(vm_frame_is_dirty(page->frame)){
+		/* victim은 다른 프로세스의 page일 수 있으니 va가 아니라 kva로 쓴다. */
+		file_write_at(file_page->file, page->frame->kva, file_page->read_bytes, file_page->ofs);
+		vm_frame_clear_dirty(page->frame);
 	}
 	return true;
 }
@@ -74,119 +78,279 @@ file_backed_swap_out (struct page *page) {
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
-	uint64_t current_pml4 = thread_current()->pml4;
-
-	if(pml4_get_page(current_pml4, page->va)){
-		if(pml4_is_dirty(current_pml4, page->va)){
-			file_write_at(page->file.file, page->va, page->file.read_bytes, page->file.ofs);
-			pml4_set_dirty(current_pml4, page->va, false);
+	struct file_page *file_page = &page->file;
+	struct frame *frame = vm_frame_pin(page);	// evict 중이면 끝날 때까지 기다린다.
+
+	/* 다른 프로세스가 page cache로 같이 쓰고 있으면 매핑만 지운다. 수정한 내용은
+	 * 마지막으로 떠나는 page나 eviction이 파일에 쓴다. */
+	if(frame != NULL && vm_frame_detach(page, frame)){
+		if(vm_frame_is_dirty(frame)){
+			file_write_at(file_page->file, frame->kva, file_page->read_bytes, file_page->ofs);
+			vm_frame_clear_dirty(frame);
 		}
-		palloc_free_page(page->frame->kva);
-		pml4_clear_page(current_pml4, page->va);
+		vm_frame_release(frame);
 	}
 
-	if (*page->file.remain_cnt == 1){
-		file_close(page->file.file);
-		free(page->file.remain_cnt);
-	} else {
-		(*page->file.remain_cnt)--;
-	}
+	mmap_file_release(file_page->file, file_page->remain_cnt);
+}
 
-	free(page->frame);
+/*** GrilledSalmon ***/
+/* mmap 한 FILE의 참조 하나를 놓는다. REMAIN_CNT는 그 file을 쓰는 VMA와 page의 수이고
+ * 마지막 참조였으면 file을 닫는다. fork한 자식도 같은 FILE과 REMAIN_CNT를 같이
+ * 쓰므로 여러 프로세스가 동시에 놓을 수 있다. */
+void
+mmap_file_release (struct file *file, int *remain_cnt) {
+	if (__atomic_sub_fetch (remain_cnt, 1, __ATOMIC_ACQ_REL) == 0){
+		file_close(file);
+		free(remain_cnt);
+	}
 }
 
-/*** Dongdongbro ***/
+/*** Dongdongbro & GrilledSalmon ***/
 /* Do the mmap */
+/* 영역을 VMA 하나로만 기록하고 page는 fault가 날 때 vma_alloc_page로 만든다. */
 void *
 do_mmap (void *addr, size_t length, int writable,
 		struct file *file, off_t offset) {
-			struct file *reopen_file = file_reopen(file);
-			if (reopen_file == NULL){
-				return NULL;
-			}
-			off_t now = offset;
-			int *remain_cnt = malloc(sizeof(int));
-			uint64_t temp_addr = addr;
-			uint64_t initial_addr = addr;
-			int temp_length = length;
-
-			*remain_cnt = 0;
-
-			while (temp_length > 0){
-				(*remain_cnt)++;
-				if (spt_find_page(&thread_current()->spt, temp_addr) != NULL){
-					return NULL;
-				}
-				temp_addr += PGSIZE;
-				temp_length -= PGSIZE;
-			}
-
-			int f_length = file_length(reopen_file);
-			temp_length = length;
-
-			while (temp_length > 0){
-				size_t page_read_bytes = f_length < PGSIZE ? f_length : PGSIZE;
-				size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-				struct lazy_info *lazy_info = malloc(sizeof(struct lazy_info));
-				lazy_info->file = reopen_file;
-				lazy_info->ofs = now;
-				lazy_info->read_bytes = page_read_bytes;
-				lazy_info->remain_cnt = remain_cnt;
-
-				if(!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_file, lazy_info)){
-					free(lazy_info);
-					return NULL;
-				}
-
-				f_length = f_length > PGSIZE ? f_length - PGSIZE:0;
-				temp_length -= PGSIZE;
-				addr += PGSIZE;
-				now += PGSIZE;
-			}
-
-		return initial_addr;
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	void *end = addr + ROUND_UP(length, PGSIZE);
+	struct file *reopen_file;
+	struct vma *vma;
+
+	if (end <= addr || !is_user_vaddr(end - 1) || !spt_range_free(spt, addr, end))
+		return NULL;
+
+	reopen_file = file_reopen(file);
+	if (reopen_file == NULL)
+		return NULL;
+	vma = malloc(sizeof *vma);
+	if (vma != NULL)
+		vma->file.remain_cnt = malloc(sizeof(int));
+	if (vma == NULL || vma->file.remain_cnt == NULL) {
+		free(vma);
+		file_close(reopen_file);
+		return NULL;
+	}
+
+	vma->start = addr;
+	vma->end = end;
+	vma->writable = writable;
+	vma->sequential = false;
+	vma->shm = NULL;
+	vma->file.file = reopen_file;
+	vma->file.ofs = offset;
+	vma->file.read_bytes = file_length(reopen_file);
+	*vma->file.remain_cnt = 1;	// VMA 자신의 참조
+	vma_insert(spt, vma);
+
+	return addr;
+}
+
+/*** GrilledSalmon ***/
+/* VMA 안의 VA에 page를 만들어 spt에 넣는다. mmap이 page마다 하던 일을
+ * 처음 fault가 날 때 한다. */
+bool
+vma_alloc_page (struct vma *vma, void *va) {
+	size_t skip;
+	struct lazy_info *lazy_info;
+
+	va = pg_round_down(va);
+	if (vma->shm != NULL)
+		return shm_alloc_page(vma, va);
+	/* anon VMA의 page는 0으로 시작한다. */
+	if (vma->file.file == NULL)
+		return vm_alloc_page(VM_ANON, va, vma->writable);
+	skip = va - vma->start;
+	lazy_info = kmem_cache_alloc(lazy_info_cache);
+	if (lazy_info == NULL)
+		return false;
+	lazy_info->file = vma->file.file;
+	lazy_info->ofs = vma->file.ofs + skip;
+	lazy_info->read_bytes = vma->file.read_bytes > skip ? vma->file.read_bytes - skip : 0;
+	if (lazy_info->read_bytes > PGSIZE)
+		lazy_info->read_bytes = PGSIZE;
+	lazy_info->remain_cnt = vma->file.remain_cnt;
+
+	if(!vm_alloc_page_with_initializer(VM_FILE, va, vma->writable, lazy_load_file, lazy_info)){
+		kmem_cache_free(lazy_info_cache, lazy_info);
+		return false;
+	}
+	__atomic_add_fetch (vma->file.remain_cnt, 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* spt에서 뺀 VMA의 file 참조를 놓고 해제한다. */
+void
+vma_destroy (struct vma *vma) {
+	if (vma->file.file != NULL)
+		mmap_file_release(vma->file.file, vma->file.remain_cnt);
+	if (vma->shm != NULL)
+		shm_seg_put(vma->shm);
+	free(vma);
+}
+
+/*** GrilledSalmon ***/
+/* [ADDR, ADDR + LENGTH)에 0으로 시작하는 anon 영역을 VMA 하나로 만든다. file이
+ * 없는 VMA이고 page는 fault가 날 때 VM_ANON으로 만든다. 실패하면 NULL. */
+void *
+do_mmap_anon (void *addr, size_t length, bool writable) {
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	void *end = addr + ROUND_UP(length, PGSIZE);
+	struct vma *vma;
+
+	if (end <= addr || !is_user_vaddr(end - 1) || !spt_range_free(spt, addr, end))
+		return NULL;
+	vma = vma_create_anon(addr, end, writable);
+	if (vma == NULL)
+		return NULL;
+	vma_insert(spt, vma);
+	return addr;
+}
+
+/*** GrilledSalmon ***/
+/* [START, END)의 anon VMA를 만든다. spt에는 부른 쪽이 넣는다. */
+struct vma *
+vma_create_anon (void *start, void *end, bool writable) {
+	struct vma *vma = malloc(sizeof *vma);
+
+	if (vma == NULL)
+		return NULL;
+	vma->start = start;
+	vma->end = end;
+	vma->writable = writable;
+	vma->sequential = false;
+	vma->shm = NULL;
+	vma->file.file = NULL;
+	vma->file.ofs = 0;
+	vma->file.read_bytes = 0;
+	vma->file.remain_cnt = NULL;
+	return vma;
+}
+
+/*** GrilledSalmon ***/
+/* program break를 INCREMENT 바이트만큼 옮기고 이전 break를 리턴한다. heap은
+ * heap_start에서 시작하는 anon VMA 하나로, 늘릴 때는 VMA의 끝만 옮기고 줄일
+ * 때는 잘려 나간 page를 지운다. 다른 영역과 겹치거나 stack 영역까지 올라가면
+ * 옮기지 않고 (void *) -1을 리턴한다. */
+void *
+vm_sbrk (intptr_t increment) {
+	struct thread *t = thread_current()->leader;
+	struct supplemental_page_table *spt = &t->spt;
+	void *old_brk = t->brk;
+	void *new_brk = old_brk + increment;
+	void *old_end = pg_round_up(old_brk);
+	void *new_end = pg_round_up(new_brk);
+	struct vma *vma = NULL;
+	void *va;
+
+	if ((increment > 0 && new_brk < old_brk) || (increment < 0 && new_brk > old_brk)
+			|| new_brk < t->heap_start || new_end > (void *) (USER_STACK_LIMIT))
+		return (void *) -1;
+	if (old_end > t->heap_start) {
+		vma = vma_find(spt, t->heap_start);
+		if (vma == NULL || vma->start != t->heap_start || vma->shm != NULL)
+			return (void *) -1;	// heap을 munmap 했다.
+	}
+
+	if (new_end > old_end) {
+		if (!spt_range_free(spt, old_end, new_end))
+			return (void *) -1;
+		if (vma != NULL)
+			vma->end = new_end;
+		else {
+			vma = vma_create_anon(t->heap_start, new_end, true);
+			if (vma == NULL)
+				return (void *) -1;
+			vma_insert(spt, vma);
+		}
+	} else if (new_end < old_end) {
+		for (va = new_end; va < old_end; va += PGSIZE) {
+			struct page *page = spt_find_page(spt, va);
+			if (page != NULL)
+				spt_remove_page(spt, page);
+		}
+		if (new_end == t->heap_start) {
+			vma_remove(spt, vma);
+			vma_destroy(vma);
+		} else
+			vma->end = new_end;
+	}
+	t->brk = new_brk;
+	return old_brk;
 }
 
 /*** haein ***/
 /* Do the munmap */
 void
 do_munmap (void *addr) {
-	struct supplemental_page_table *spt = &thread_current() -> spt;
-	int remain_cnt = *spt_find_page(spt, addr)->file.remain_cnt;
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	struct vma *vma = vma_find(spt, addr);
 
-	while (remain_cnt) {
-		struct page *munmap_page = spt_find_page(spt, addr);
+	if (vma == NULL || vma->start != addr)
+		return;
 
-		if (munmap_page == NULL) {
-			goto err;
-		}
+	/* 만들어진 page만 spt에 있다. 나머지는 한 번도 건드리지 않은 page다. */
+	for (; addr < vma->end; addr += PGSIZE) {
+		struct page *munmap_page = spt_find_page(spt, addr);
 
-		spt_remove_page(spt, munmap_page); // vm_dealloc_page (page) -> destroy(page) free(page)
-		addr += PGSIZE;
-		remain_cnt--;
+		if (munmap_page != NULL)
+			spt_remove_page(spt, munmap_page); // vm_dealloc_page (page) -> destroy(page) free(page)
 	}
-
-	err:
-		return;
+	vma_remove(spt, vma);
+	vma_destroy(vma);
 }
 
 
+/*** GrilledSalmon ***/
+/* [ADDR, ADDR + LENGTH)에서 mmap 한 파일의 고쳐진 page만 파일에 쓰고 dirty bit를
+ * 지운다. munmap 하지 않아도 거기까지의 내용이 디스크에 남는다. MS_ASYNC이면 page
+ * cache에 있는 page는 write-back daemon에 맡기고 바로 돌아간다. 성공하면 0,
+ * ADDR이 page 경계가 아니거나 매핑되지 않은 page가 있거나 FLAGS가 잘못되었으면 -1. */
+int
+do_msync (void *addr, size_t length, int flags) {
+	struct supplemental_page_table *spt = &thread_current()->leader->spt;
+	void *end = addr + ROUND_UP(length, PGSIZE);
+	void *va;
+
+	if (pg_ofs(addr) != 0 || end < addr || (length > 0 && !is_user_vaddr(end - 1))
+			|| (flags & ~(MS_ASYNC | MS_SYNC)) != 0
+			|| flags == (MS_ASYNC | MS_SYNC))
+		return -1;
+	for (va = addr; va < end; va += PGSIZE)
+		if (spt_find_page(spt, va) == NULL && vma_find(spt, va) == NULL)
+			return -1;
+
+	/* 한 번도 건드리지 않았거나 아직 uninit인 page는 파일과 같다. */
+	for (va = addr; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page(spt, va);
+		struct frame *frame;
+
+		if (page == NULL || VM_TYPE(page->operations->type) != VM_FILE)
+			continue;
+		frame = vm_msync_pick(page, flags & MS_ASYNC);
+		if (frame == NULL)
+			continue;
+		file_write_at(page->file.file, frame->kva, page->file.read_bytes, page->file.ofs);
+		vm_flush_done(&frame, 1);
+	}
+	return 0;
+}
+
 /*** Dongdongbro ***/
-static bool
+bool
 lazy_load_file (struct page *page, void *aux){
 	struct lazy_info *lazy_info = aux;
 	struct file *file = lazy_info->file;
 
-	file_seek(file, lazy_info->ofs);
+	thread_current()->rusage.majflt++;
 
-	if(file_read(file, page->frame->kva, lazy_info->read_bytes) != (int) lazy_info->read_bytes){
+	if(file_read_at(file, page->frame->kva, lazy_info->read_bytes, lazy_info->ofs) != (int) lazy_info->read_bytes){
 		return false;
 	}
 
 	memset(page->frame->kva + lazy_info->read_bytes, 0, PGSIZE - lazy_info->read_bytes);
-	free(lazy_info);
+	kmem_cache_free(lazy_info_cache, lazy_info);
 
 	return true;
 }
@@ -0,0 +1,179 @@
+/* shm.c: Shared anonymous memory segments. */
+
+#include "vm/vm.h"
+#include "vm/shm.h"
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+
+/*** GrilledSalmon ***/
+/* 여러 프로세스가 같은 frame을 매핑하는 anon 메모리. shm_create가 돌려준 fd로
+ * attach 하고, fork로 물려받은 attach도 같은 segment를 본다.
+ *
+ * segment는 page마다 spt에 없는 anchor page를 하나씩 들고 있다. anchor는
+ * frame이 메모리에 있는 동안 frame->pages의 맨 앞에 있으므로 evict 할 때
+ * swap_out은 anchor에 불리고, slot은 매핑한 프로세스가 아니라 anchor에 남는다.
+ * 어느 프로세스가 다시 fault를 내든 anchor의 slot에서 읽어 온다. */
+struct shm_seg {
+	int ref_cnt;                /* fd와 VMA의 참조 수. */
+	size_t page_cnt;
+	struct page *anchors[];
+};
+
+static bool shm_swap_in (struct page *page, void *kva);
+static bool shm_swap_out (struct page *page);
+static void shm_destroy (struct page *page);
+
+static const struct page_operations shm_ops = {
+	.swap_in = shm_swap_in,
+	.swap_out = shm_swap_out,
+	.destroy = shm_destroy,
+	.type = VM_SHM,
+};
+
+/* PAGE_CNT page짜리 segment를 만든다. 부른 쪽이 참조 하나를 가진다. 메모리가
+ * 모자라면 NULL. */
+struct shm_seg *
+shm_seg_create (size_t page_cnt) {
+	struct shm_seg *seg;
+	size_t i;
+
+	ASSERT (page_cnt > 0 && page_cnt <= SHM_PAGES_MAX);
+	seg = malloc (sizeof *seg + page_cnt * sizeof *seg->anchors);
+	if (seg == NULL)
+		return NULL;
+	seg->ref_cnt = 1;
+	seg->page_cnt = page_cnt;
+	for (i = 0; i < page_cnt; i++) {
+		struct page *anchor = kmem_cache_alloc (vm_page_cache);
+
+		if (anchor == NULL) {
+			seg->page_cnt = i;
+			shm_seg_put (seg);
+			return NULL;
+		}
+		memset (anchor, 0, sizeof *anchor);
+		anchor->operations = &shm_ops;
+		anchor->writable = true;
+		anchor->shm.seg = seg;
+		anchor->shm.idx = i;
+		anchor->shm.slot_number = -1;
+		seg->anchors[i] = anchor;
+	}
+	return seg;
+}
+
+/* SEG의 참조를 하나 늘려 돌려준다. */
+struct shm_seg *
+shm_seg_share (struct shm_seg *seg) {
+	__atomic_add_fetch (&seg->ref_cnt, 1, __ATOMIC_RELAXED);
+	return seg;
+}
+
+/* SEG의 참조 하나를 놓는다. 마지막이었으면 frame과 swap slot을 모두 놓는다.
+ * 그때는 매핑한 page가 남아 있지 않다. */
+void
+shm_seg_put (struct shm_seg *seg) {
+	size_t i;
+
+	if (__atomic_sub_fetch (&seg->ref_cnt, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+	for (i = 0; i < seg->page_cnt; i++) {
+		struct page *anchor = seg->anchors[i];
+
+		vm_release_frame (anchor);
+		swap_slot_put (anchor->shm.slot_number);
+		kmem_cache_free (vm_page_cache, anchor);
+	}
+	free (seg);
+}
+
+size_t
+shm_seg_pages (struct shm_seg *seg) {
+	return seg->page_cnt;
+}
+
+/* 매핑한 PAGE가 가리키는 segment page의 anchor. */
+struct page *
+shm_anchor (struct page *page) {
+	return page->shm.seg->anchors[page->shm.idx];
+}
+
+/* ADDR부터 SEG 전체를 매핑하는 VMA를 만든다. page는 fault가 날 때
+ * shm_alloc_page가 만든다. 다른 영역과 겹치면 NULL. */
+void *
+do_shm_attach (void *addr, struct shm_seg *seg, bool writable) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *end = addr + seg->page_cnt * PGSIZE;
+	struct vma *vma;
+
+	if (end <= addr || !is_user_vaddr (end - 1) || !spt_range_free (spt, addr, end))
+		return NULL;
+	vma = vma_create_anon (addr, end, writable);
+	if (vma == NULL)
+		return NULL;
+	vma->shm = shm_seg_share (seg);
+	vma_insert (spt, vma);
+	return addr;
+}
+
+/* shm VMA 안의 VA에 매핑할 page를 만들어 spt에 넣는다. frame은
+ * vm_do_claim_page가 anchor에서 찾거나 새로 읽어 온다. */
+bool
+shm_alloc_page (struct vma *vma, void *va) {
+	struct page *page = kmem_cache_alloc (vm_page_cache);
+
+	if (page == NULL)
+		return false;
+	va = pg_round_down (va);
+	memset (page, 0, sizeof *page);
+	page->operations = &shm_ops;
+	page->va = va;
+	page->writable = vma->writable;
+	page->shm.seg = vma->shm;
+	page->shm.idx = (va - vma->start) / PGSIZE;
+	page->shm.slot_number = -1;
+	if (!spt_insert_page (&thread_current ()->leader->spt, page)) {
+		kmem_cache_free (vm_page_cache, page);
+		return false;
+	}
+	return true;
+}
+
+/* anchor PAGE의 내용을 KVA에 채운다. 한 번도 evict 되지 않았으면 0이다. */
+static bool
+shm_swap_in (struct page *page, void *kva) {
+	ASSERT (page == shm_anchor (page));
+
+	if (page->shm.slot_number == -1)
+		memset (kva, 0, PGSIZE);
+	else
+		swap_slot_load (page->shm.slot_number, kva);
+	return true;
+}
+
+/* frame의 맨 앞에 있는 anchor PAGE의 내용을 anchor의 slot에 쓴다. slot에 쓴
+ * 뒤로 어느 매핑도 고치지 않았으면 그대로 둔다. */
+static bool
+shm_swap_out (struct page *page) {
+	ASSERT (page == shm_anchor (page));
+
+	if (page->shm.slot_number != -1) {
+		if (!vm_frame_is_dirty (page->frame))
+			return true;
+		swap_slot_put (page->shm.slot_number);
+	}
+	page->shm.slot_number = swap_slot_store (page->frame->kva);
+	return true;
+}
+
+/* 매핑한 PAGE를 frame에서 떼어낸다. anchor가 frame에 남으므로 frame과 내용은
+ * segment에 그대로 있다. PAGE가 남긴 dirty bit는 커널 매핑으로 옮겨진다. */
+static void
+shm_destroy (struct page *page) {
+	struct frame *frame = vm_frame_pin (page);
+
+	if (frame != NULL && vm_frame_detach (page, frame))
+		NOT_REACHED ();
+}
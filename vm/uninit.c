@@ -65,5 +65,10 @@ uninit_destroy (struct page *page) {
 	struct uninit_page *uninit UNUSED = &page->uninit;
 	/* TODO: Fill this function.
 	 * TODO: If you don't have anything to do, just return.  */
-	free(uninit->aux);
+	struct lazy_info *lazy_info = uninit->aux;	// aux는 lazy_info이거나 NULL이다.
+
+	/* 한 번도 읽지 않은 mmap page도 file의 참조를 하나 가지고 있다. */
+	if (lazy_info != NULL && VM_TYPE(uninit->type) == VM_FILE)
+		mmap_file_release(lazy_info->file, lazy_info->remain_cnt);
+	kmem_cache_free(lazy_info_cache, lazy_info);
 }
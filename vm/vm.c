@@ -9,19 +9,87 @@
 #include "threads/malloc.h"
 #include "userprog/process.h"
 #include "lib/kernel/list.h" /*** haein ***/
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/init.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
+#include "threads/vmalloc.h"
+#include "filesys/page_cache.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+#include <round.h>
+#include <syscall-nr.h>
 #include <string.h>
 
-static struct list frame_table;			/*** GrilledSalmon ***/
-
-struct page *page_lookup (struct hash *h, const void *va); /*** haein ***/
+/*** GrilledSalmon ***/
+/* Frame table: 유저 풀의 frame 번호(kva - frame_base) / PGSIZE 로 인덱싱하는 배열.
+ * 비어 있는 칸은 NULL이다. clock_hand는 eviction 사이에도 유지되어 다음 eviction은
+ * 지난번에 멈춘 곳부터 이어서 돈다. frame_lock이 table, clock_hand와 각 frame의
+ * 공유 상태를 보호한다. evict 중인 frame의 page를 건드리려는 스레드는
+ * frame_evicted에서 기다린다. */
+static struct lock frame_lock;
+static struct condition frame_evicted;
+static struct frame **frame_table;
+static uint8_t *frame_base;
+static size_t frame_cnt;
+static size_t clock_hand;
+/* RSS limit를 넘은 프로세스가 자기 frame을 고를 때 쓰는 hand. clock_hand와 따로
+ * 돌아서 그 프로세스의 eviction이 다른 프로세스의 순서를 흩트리지 않는다. */
+static size_t owned_hand;
+/* 2Q: frame table의 frame은 처음에 inactive list 끝에 들어간다. inactive list에서
+ * 두 번째로 접근된 것이 보이면 active list로 올라가고, victim은 inactive list에서만
+ * 고른다. 한 번 훑고 지나가는 page는 inactive에서 빠져나가므로 자주 쓰는 page를
+ * 밀어내지 않는다. frame_lock이 보호한다. */
+static struct list active_frames, inactive_frames;
+static size_t active_cnt, inactive_cnt;
+/* 아직 읽기만 한 zero-fill anon page들이 read-only로 같이 매핑하는 frame.
+ * 커널 풀의 page라 frame table에 없고 항상 pinned이므로 evict 되지 않는다.
+ * 쓰기 fault가 나면 vm_handle_wp가 새 frame을 준다. */
+static struct frame zero_frame;
+
+/* 파일 내용으로 채우는 page에서 fault가 나면 바로 뒤따르는 page를 이만큼 더
+ * 미리 읽어 온다. 0이면 하지 않는다. -fault-around=N으로 정한다. */
+size_t vm_fault_around_pages;
+
+/* stack growth 한 번에 만드는 최대 page 수. -stack-chunk=N으로 정한다. */
+size_t vm_stack_chunk_pages = 8;
+
+/* true이면 프로세스가 끝날 때 page fault 통계를 출력한다. -rusage로 켠다. */
+bool vm_print_rusage;
+
+/* MADV_SEQUENTIAL 영역에서 fault가 나면 적어도 이만큼 미리 읽고, 이만큼 뒤에
+ * 남은 page는 clock이 먼저 고르게 한다. */
+#define SEQ_WINDOW_PAGES 16
+/* vm_evict_frame이 한 번에 evict 하는 최대 frame 수. */
+#define EVICT_BATCH 4
+
+/* 유저 풀의 빈 page가 kswapd_low 밑으로 내려가면 work queue에서 kswapd work가 돌아
+ * kswapd_high가 될 때까지 EVICT_BATCH개씩 evict 해서, fault는 보통 palloc에서 바로
+ * frame을 얻는다. -kswapd=N이면 low를 N으로(high는 2N) 정하고, 0이면 백그라운드로
+ * evict 하지 않는다. 음수이면 유저 풀 크기에서 정한다. */
+int vm_kswapd_low = -1;
+static size_t kswapd_low, kswapd_high;
+static struct work kswapd_work;
+static bool kswapd_awake;               /* kswapd_work를 이미 넣었다. */
+static size_t kswapd_wakeups;
+static size_t kswapd_reclaimed;
+
+struct kmem_cache *vm_page_cache;
+struct kmem_cache *vm_frame_cache;
+struct kmem_cache *lazy_info_cache;
+
+struct page *page_lookup (struct ohash *h, const void *va); /*** haein ***/
 
 /*** Dongdongbro ***/
-unsigned page_hash (const struct hash_elem *h_elem, void *aux UNUSED);
-bool page_less (const struct hash_elem *h_elem1, const struct hash_elem *h_elem2, void *aux UNUSED);
+uint64_t page_hash (const struct ohash_elem *h_elem, void *aux UNUSED);
+bool page_eq (const struct ohash_elem *h_elem1, const struct ohash_elem *h_elem2, void *aux UNUSED);
 
 /*** GrilledSalmon ***/
-void spt_hash_destructor (struct hash_elem *e, void *aux); 	
-static void copy_parent_file (struct file *parent_file, int parent_remain_cnt, tid_t child_tid, bool is_uninit, void *aux);
+void spt_hash_destructor (struct ohash_elem *e, void *aux); 	
+static void share_parent_file (int *remain_cnt);
+static void ksm_init (void);
+static void kswapd_init (void);
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -35,7 +103,38 @@ vm_init (void) {
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	list_init(&frame_table);
+	palloc_user_pool ((void **) &frame_base, &frame_cnt);
+	frame_table = kvcalloc (frame_cnt, sizeof *frame_table);
+	if (frame_table == NULL)
+		PANIC ("frame table allocation failed");
+	lock_init (&frame_lock);
+	cond_init (&frame_evicted);
+	clock_hand = 0;
+	list_init (&active_frames);
+	list_init (&inactive_frames);
+	zero_frame.kva = palloc_get_page (PAL_ZERO);
+	if (zero_frame.kva == NULL)
+		PANIC ("zero page allocation failed");
+	list_init (&zero_frame.pages);
+	zero_frame.page_cnt = 0;
+	zero_frame.pin_cnt = 1;
+	zero_frame.evicting = false;
+	zero_frame.inode = NULL;
+	page_cache_share_init ();
+#ifndef EFILESYS
+	pagecache_init ();	// mmap write-back daemon은 project 4가 아니어도 돈다.
+#endif
+
+	/* fork/exec/page fault마다 수없이 만들고 지우는 구조체들은 정확한 크기의 cache에서 받는다. */
+	vm_page_cache = kmem_cache_create ("page", sizeof (struct page), 0, NULL);
+	vm_frame_cache = kmem_cache_create ("frame", sizeof (struct frame), 0, NULL);
+	lazy_info_cache = kmem_cache_create ("lazy_info", sizeof (struct lazy_info), 0, NULL);
+	if (vm_page_cache == NULL || vm_frame_cache == NULL || lazy_info_cache == NULL)
+		PANIC ("vm object cache creation failed");
+	if (vm_ksm_enabled)
+		ksm_init ();
+	kswapd_init ();
+	page_cache_sector_init ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -54,8 +153,18 @@ page_get_type (struct page *page) {
 
 /* Helpers */
 static struct frame *vm_get_victim (void);
+static struct frame *victim_clock (void);
+static struct frame *victim_2q (void);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_map_frame (struct page *page, struct frame *frame);
+static void frame_prepare (struct frame *frame);
+static bool vm_map_shared (struct page *page, struct frame *frame);
+static bool vm_map_shm (struct page *page);
+static struct frame *cache_find (struct page *page);
+static void vm_drop_behind (struct supplemental_page_table *spt, struct vma *vma, void *va);
 static struct frame *vm_evict_frame (void);
+static size_t vm_evict_batch (struct frame **keep, struct thread *owner);
+static void kswapd_poke (void);
 
 /*** GrilledSalmon ***/
 /* Create the pending page object with initializer. If you want to create a
@@ -67,7 +176,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 	ASSERT (VM_TYPE(type) != VM_UNINIT)
 
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
 	upage = pg_round_down(upage);
 
 	/* Check wheter the upage is already occupied or not. */
@@ -75,7 +184,9 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		/* TODO: Create the page, fetch the initialier according to the VM type,
 		 * TODO: and then create "uninit" page struct by calling uninit_new. You
 		 * TODO: should modify the field after calling the uninit_new. */
-		struct page *page = malloc(sizeof(struct page));
+		struct page *page = kmem_cache_alloc(vm_page_cache);
+		if (page == NULL)
+			goto err;
 		bool (*initializer)(struct page *, enum vm_type, void *);
 
 		switch (VM_TYPE(type))
@@ -98,7 +209,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 		/* TODO: Insert the page into the spt. */
 		if (!spt_insert_page(spt, page)) {
-			free(page);
+			kmem_cache_free(vm_page_cache, page);
 			goto err;
 		}
 
@@ -113,7 +224,14 @@ err:
 /* VA와 상응하는 struct page를 supplemental page table에서 찾아준다. 실패 시, NULL을 리턴한다. */
 struct page *
 spt_find_page (struct supplemental_page_table *spt, void *va) {
-	return page_lookup(&spt->h, va);
+	struct page *page = spt->last;
+
+	if (page != NULL && page->va == pg_round_down (va))
+		return page;
+	page = page_lookup(&spt->h, va);
+	if (page != NULL)
+		spt->last = page;
+	return page;
 }
 
 /*** GrilledSalmon ***/
@@ -123,7 +241,7 @@ spt_insert_page (struct supplemental_page_table *spt, struct page *page) {
 	int succ = false;
 	/* TODO: Fill this function. */
 
-	if (hash_insert(&spt->h, &page->hash_elem) == NULL) {
+	if (ohash_insert(&spt->h, &page->hash_elem) == NULL) {
 		succ = true;
 	}
 
@@ -132,350 +250,2162 @@ spt_insert_page (struct supplemental_page_table *spt, struct page *page) {
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
-	hash_delete(&spt->h, &page->hash_elem);
+	if (spt->last == page)
+		spt->last = NULL;
+	ohash_delete(&spt->h, &page->hash_elem);
 	vm_dealloc_page (page);
 	return true;
 }
 
 /*** GrilledSalmon ***/
-/* Get the struct frame, that will be evicted. */
-static struct frame *
-vm_get_victim (void) {
-	struct frame *victim = NULL;
-	 /* TODO: The policy for eviction is up to you. */
-	struct list_elem *elem;
-	ASSERT(!list_empty(&frame_table));
-	int count = 0;
-	for (elem=list_begin(&frame_table); elem!=list_end(&frame_table); elem=list_next(elem))
-	{	
-		victim = list_entry(elem, struct frame, frame_elem);
-		if (pml4_is_accessed(victim->pml4, victim->page->va)) {
-			pml4_set_accessed(victim->pml4, victim->page->va, false);
-		} else {
-			break;
-		}
-	}
-	/* 만약 리스트를 다 돌았는데 모두 accessed 상태면 자동으로 마지막 frame 리턴*/
-	return victim;
+/* SPT의 lock을 잡는다. 이미 잡고 있으면 (fault 처리 중에 다시 fault가 나면)
+ * 잡지 않고 false를 리턴한다. 리턴값을 spt_unlock에 넘긴다. */
+bool
+spt_lock (struct supplemental_page_table *spt) {
+	if (lock_held_by_current_thread (&spt->lock))
+		return false;
+	lock_acquire (&spt->lock);
+	return true;
 }
 
-/*** haein ***/
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.
- * 하나의 페이지를 evict 하고 상응하는 frame을 리턴
- * 에러가 났을 때는 NULL을 리턴
- * 프레임 테이블에서 없애고 swap table에서도 없앰 (swap out)
- */
-static struct frame *
-vm_evict_frame (void) {
-	struct frame *victim = vm_get_victim (); // 여기서 걸림!
-	/* TODO: swap out the victim and return the evicted frame. */
-	if (!victim) {
-		return NULL;
-	}
+void
+spt_unlock (struct supplemental_page_table *spt, bool locked) {
+	if (locked)
+		lock_release (&spt->lock);
+}
 
-	if (!list_remove(&victim->frame_elem)) { // frame table에서 삭제
-		return NULL;
+/* VMA를 시작 주소 순으로 정렬한다. */
+static bool
+vma_less (const struct avl_elem *a_, const struct avl_elem *b_, void *aux UNUSED) {
+	const struct vma *a = avl_entry (a_, struct vma, elem);
+	const struct vma *b = avl_entry (b_, struct vma, elem);
+
+	return a->start < b->start;
+}
+
+/*** GrilledSalmon ***/
+/* VA를 포함하는 VMA를 리턴한다. 없으면 NULL. */
+struct vma *
+vma_find (struct supplemental_page_table *spt, const void *va) {
+	struct vma key;
+	struct avl_elem *e;
+
+	key.start = pg_round_down (va);
+	e = avl_floor (&spt->vmas, &key.elem);
+	if (e != NULL) {
+		struct vma *vma = avl_entry (e, struct vma, elem);
+		if (va < vma->end)
+			return vma;
 	}
+	return NULL;
+}
 
-	if (!swap_out(victim->page)) { // swap_out 호출
-		return NULL;
-	} 
-	
-	pml4_clear_page(victim->pml4, victim->page->va); // pml4에서 삭제
+/*** GrilledSalmon ***/
+/* VMA를 SPT에 넣는다. spt_range_free로 겹치지 않는 것을 확인한 뒤에 부른다. */
+void
+vma_insert (struct supplemental_page_table *spt, struct vma *vma) {
+	struct avl_elem *dup = avl_insert (&spt->vmas, &vma->elem);
+	ASSERT (dup == NULL);
+}
 
-	return victim;
+/*** GrilledSalmon ***/
+/* VMA를 SPT에서 뺀다. 그 영역의 page는 부른 쪽이 먼저 지운다. */
+void
+vma_remove (struct supplemental_page_table *spt, struct vma *vma) {
+	avl_remove (&spt->vmas, &vma->elem);
 }
 
+/*** GrilledSalmon ***/
+/* [START, END)에 page도 VMA도 없으면 true. 영역이 page 수보다 크면 page를 하나씩
+ * 찾는 대신 spt의 page를 훑는다. */
+bool
+spt_range_free (struct supplemental_page_table *spt, void *start, void *end) {
+	struct vma key;
+	struct avl_elem *e;
+	size_t page_cnt = (end - start) / PGSIZE;
 
-/*** GrilledSalmon & haein ***/
-/* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
-/* palloc()과 프레임을 얻어옵니다. 만약 이용가능한 페이지가 없으면, 페이지를 지우고 이를 리턴합니다.
-항상 유효한 주소값을 반환해야합니다. 만약 유저풀 메모리가 가득 찼다면 이 함수는 사용가능한 메모리 공간을 얻기 위해
-기존에 있던 프레임을 지워야합니다. */
-static struct frame *
-vm_get_frame (void) {
-	struct frame *frame = calloc(1, sizeof (struct frame));
-	ASSERT (frame != NULL);
+	ASSERT (pg_ofs (start) == 0 && pg_ofs (end) == 0 && start < end);
 
-	/* TODO: Fill this function. */
-	uint64_t *kva = palloc_get_page(PAL_USER);
+	/* END 앞에서 시작하는 마지막 VMA가 START 뒤까지 뻗어 있으면 겹친다. */
+	key.start = end - PGSIZE;
+	e = avl_floor (&spt->vmas, &key.elem);
+	if (e != NULL && avl_entry (e, struct vma, elem)->end > start)
+		return false;
 
-	if (kva == NULL) {		
-		struct frame *evicted_frame = vm_evict_frame(); //  evict 시킨 페이지에 상응하는 frame 리턴
-		ASSERT (evicted_frame != NULL);
-		kva = evicted_frame->kva; // evict 시킨 페이지의 kva에 공간 할당 받을 수 있음
+	if (page_cnt <= ohash_size (&spt->h)) {
+		void *va;
+		for (va = start; va < end; va += PGSIZE)
+			if (spt_find_page (spt, va) != NULL)
+				return false;
+	} else {
+		struct ohash_iterator i;
+		ohash_first (&i, &spt->h);
+		while (ohash_next (&i)) {
+			struct page *page = ohash_entry (ohash_cur (&i), struct page, hash_elem);
+			if (start <= page->va && page->va < end)
+				return false;
+		}
 	}
-	frame->kva = kva;
-	ASSERT (frame->page == NULL);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* VA의 page를 리턴한다. 아직 안 만든 mmap page면 VMA에서 만들어서 리턴한다.
+ * 둘 다 없으면 NULL. */
+struct page *
+spt_get_page (struct supplemental_page_table *spt, void *va) {
+	struct page *page = spt_find_page (spt, va);
+	struct vma *vma;
+
+	if (page != NULL)
+		return page;
+	vma = vma_find (spt, va);
+	if (vma == NULL || !vma_alloc_page (vma, va))
+		return NULL;
+	return spt_find_page (spt, va);
+}
 
-	list_push_back(&frame_table, &frame->frame_elem); // frame_table에 추가
-	
-	frame->pml4 = thread_current()->pml4; // frame의 pml4에 현재 스레드의 pml4 초기화
+/*** GrilledSalmon ***/
+/* Returns the frame table slot of KVA. */
+static size_t
+frame_index (const void *kva) {
+	size_t idx = ((const uint8_t *) kva - frame_base) / PGSIZE;
+	ASSERT (idx < frame_cnt);
+	return idx;
+}
 
-	return frame;
+/*** GrilledSalmon ***/
+/* PAGE를 FRAME에 연결하고 page 주인의 RSS에 센다. page->owner를 먼저 정해 두고
+ * frame_lock을 잡고 불러야 한다. */
+static void
+frame_link (struct frame *frame, struct page *page) {
+	list_push_back (&frame->pages, &page->frame_elem);
+	frame->page_cnt++;
+	page->frame = frame;
+	if (frame != &zero_frame && page->owner != NULL)
+		page->owner->rss_cnt++;
 }
 
-/*** Dongdongbro ***/
-/* Growing the stack. */
+/*** GrilledSalmon ***/
+/* PAGE를 자기 frame에서 떼어낸다. frame_lock을 잡고 불러야 한다. */
 static void
-vm_stack_growth (void *addr) {
-	addr = pg_round_down(addr);
+frame_unlink (struct page *page) {
+	if (page->frame != &zero_frame && page->owner != NULL)
+		page->owner->rss_cnt--;
+	list_remove (&page->frame_elem);
+	page->frame->page_cnt--;
+	page->frame = NULL;
+}
 
-	if (addr < USER_STACK_LIMIT){
-		goto err;
+/*** GrilledSalmon ***/
+/* T의 RSS limit가 있고 이미 그만큼 frame을 쓰고 있으면 true. */
+static bool
+rss_over_limit (const struct thread *t) {
+	return t->rss_limit > 0 && t->rss_cnt >= t->rss_limit;
+}
+
+/*** GrilledSalmon ***/
+/* FRAME을 frame table의 자기 칸과 inactive list 끝에 넣는다. evict 한 frame을 그대로
+ * 다시 쓰는 경우처럼 이미 table에 있으면 list에서만 옮긴다. frame_lock을 잡고
+ * 불러야 한다. */
+static void
+frame_table_insert (struct frame *frame) {
+	size_t idx = frame_index (frame->kva);
+
+	if (frame_table[idx] == frame) {
+		list_remove (&frame->lru_elem);
+		if (frame->active)
+			active_cnt--;
+		else
+			inactive_cnt--;
 	}
-	if (vm_alloc_page(VM_STACK, addr, true) && vm_claim_page(addr)) {
-		memset(addr, 0, PGSIZE);
+	frame_table[idx] = frame;
+	frame->active = false;
+	frame->referenced = false;
+	list_push_back (&inactive_frames, &frame->lru_elem);
+	inactive_cnt++;
+}
+
+/*** GrilledSalmon ***/
+/* FRAME이 frame table에 있으면 table과 list에서 뺀다. frame_lock을 잡고 불러야 한다. */
+static void
+frame_table_remove (struct frame *frame) {
+	size_t idx = frame_index (frame->kva);
+
+	if (frame_table[idx] != frame)
 		return;
-	}
+	frame_table[idx] = NULL;
+	list_remove (&frame->lru_elem);
+	if (frame->active)
+		active_cnt--;
+	else
+		inactive_cnt--;
+}
 
-err :
-	PANIC("Stack growth failed!");
+/*** GrilledSalmon ***/
+/* 아무도 매핑하지 않게 된 FRAME을 kva와 함께 해제한다. frame_lock을 잡고 불러야 한다. */
+static void
+frame_release (struct frame *frame) {
+	ASSERT (frame->page_cnt == 0 && frame->pin_cnt == 0);
+	frame_table_remove (frame);
+	if (frame->inode != NULL)
+		page_cache_remove (frame);
+	palloc_free_page (frame->kva);
+	kmem_cache_free (vm_frame_cache, frame);
 }
 
-/* Handle the fault on write_protected page */
-static bool
-vm_handle_wp (struct page *page UNUSED) {
+/*** GrilledSalmon ***/
+/* 매핑에 실패한 PAGE를 막 받은 frame에서 떼고 frame을 해제한다. */
+static void
+frame_discard (struct page *page) {
+	struct frame *frame = page->frame;
+
+	lock_acquire (&frame_lock);
+	frame_unlink (page);
+	frame->pin_cnt--;
+	frame_release (frame);
+	lock_release (&frame_lock);
 }
 
+/*** GrilledSalmon ***/
+/* PAGE의 frame이 evict 중이면 끝날 때까지 기다린 다음 frame을 리턴한다.
+ * evict 되었으면 NULL이다. frame_lock을 잡고 불러야 한다. */
+static struct frame *
+frame_wait (struct page *page) {
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait (&frame_evicted, &frame_lock);
+	return page->frame;
+}
 
 /*** GrilledSalmon ***/
-/* Return true on success */
-bool
-vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr,
-		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
-	struct thread *t = thread_current();
-	struct page *page = spt_find_page(&t->spt, addr);
-	void *rsp;
-	/* TODO: Validate the fault */
-	/* TODO: Your code goes here */
+/* PAGE의 frame을 clock이 고르지 못하게 pin 해서 리턴한다. evict 중이면 끝날 때까지
+ * 기다리고, page가 메모리에 없으면 NULL을 리턴한다. 다 쓰면 frame_lock을 잡고
+ * pin_cnt를 줄이거나 vm_free_frame으로 page를 떼어낸다. */
+struct frame *
+vm_frame_pin (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = frame_wait (page);
+	if (frame != NULL)
+		frame->pin_cnt++;
+	lock_release (&frame_lock);
+	return frame;
+}
 
-	if (is_user_vaddr(f->rsp)) {
-		rsp = f->rsp;
-		t->rsp = rsp;
-	} else {
-		rsp = t->rsp;
+/*** GrilledSalmon ***/
+/* FRAME이 최근에 접근되었으면 true를 리턴하고 accessed bit를 지운다.
+ * frame을 매핑하는 모든 pml4를 본다: frame을 공유하는 모든 page의 pml4와,
+ * 커널이 kva로 읽고 쓸 때 쓰는 base_pml4의 커널 매핑. buffer cache의 page는
+ * 유저 매핑이 없어 커널 매핑만 본다. */
+static bool
+frame_harvest_accessed (struct frame *frame) {
+	bool accessed = false;
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, frame_elem);
+		if (page->pml4 != NULL && pml4_is_accessed (page->pml4, page->va)) {
+			pml4_set_accessed (page->pml4, page->va, false);
+			accessed = true;
+		}
 	}
+	if (pml4_is_accessed (base_pml4, frame->kva)) {
+		/* 커널 매핑은 모든 pml4가 공유한다. pml4_set_accessed가 모든 PCID의
+		 * TLB를 비운다. */
+		pml4_set_accessed (base_pml4, frame->kva, false);
+		accessed = true;
+	}
+	return accessed;
+}
 
-	if(page == NULL){
-		if ((addr == rsp - 8 || (rsp<=addr && addr<USER_STACK) && rsp != NULL)) { // stack growth
-			vm_stack_growth(addr);
+/*** GrilledSalmon ***/
+/* FRAME이 마지막으로 swap in 된 뒤에 수정되었는지 리턴한다.
+ * accessed bit처럼 모든 유저 매핑과 커널 매핑(kva)을 본다. */
+bool
+vm_frame_is_dirty (struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, frame_elem);
+		if (pml4_is_dirty (page->pml4, page->va))
 			return true;
-		}
-		return false;
 	}
-	return vm_do_claim_page (page);
+	return pml4_is_dirty (base_pml4, frame->kva);
 }
 
-/* Free the page.
- * DO NOT MODIFY THIS FUNCTION. */
+/*** GrilledSalmon ***/
+/* FRAME의 dirty bit를 모든 유저 매핑과 커널 매핑에서 지운다. */
 void
-vm_dealloc_page (struct page *page) {
-	destroy (page);
-	free (page);
+vm_frame_clear_dirty (struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, frame_elem);
+		pml4_set_dirty (page->pml4, page->va, false);
+	}
+	pml4_set_dirty (base_pml4, frame->kva, false);
 }
 
-/*** Dongdongbro ***/
-/* Claim the page that allocate on VA. */
-// va를 할당하기 위해 페이지를 선언한다.
+/*** GrilledSalmon ***/
+/* -evict=NAME으로 고를 수 있는 victim 선택 정책. */
+struct evict_policy {
+	const char *name;
+	struct frame *(*get_victim) (void);
+};
+
+static const struct evict_policy evict_policies[] = {
+	{ "clock", victim_clock },
+	{ "2q", victim_2q },
+};
+static const struct evict_policy *evict_policy = &evict_policies[0];
+
+/* Selects the eviction policy called NAME.  Returns false if
+ * there is no such policy. */
 bool
-vm_claim_page (void *va) {
-	struct page *page = spt_find_page(&thread_current()->spt, va);
-	/* TODO: Fill this function */
+vm_set_evict_policy (const char *name) {
+	size_t i;
 
-	if (page != NULL) {
-		return vm_do_claim_page (page);
-	}
+	for (i = 0; i < sizeof evict_policies / sizeof *evict_policies; i++)
+		if (!strcmp (name, evict_policies[i].name)) {
+			evict_policy = &evict_policies[i];
+			return true;
+		}
 	return false;
 }
 
-/*** haein ***/
-/* Claim the PAGE and set up the mmu. */
-/* 페이지 값을 넘겨 받고, 그 페이지와 get frame에서 물리 메모리 공간을 페이지와 연결 시켜준다. */
-static bool
-vm_do_claim_page (struct page *page) { // 이미 만들어진 page => 매핑
-	struct frame *frame = vm_get_frame ();
-	struct thread *t = thread_current();
+/*** GrilledSalmon ***/
+/* Get the struct frame, that will be evicted.
+ * 모든 frame이 pinned이면 NULL을 리턴한다. frame_lock을 잡고 불러야 한다. */
+static struct frame *
+vm_get_victim (void) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	return evict_policy->get_victim ();
+}
 
-	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+/*** GrilledSalmon ***/
+/* Second-chance clock: hand가 가리키는 frame이 최근에 접근되었으면 bit를 지우고
+ * 넘어가고, 아니면 그 frame을 고른다. 두 바퀴 안에 고르지 못하면 모든 frame이
+ * pinned인 것이므로 NULL을 리턴한다. */
+static struct frame *
+victim_clock (void) {
+	size_t scanned;
 
-	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-	if (pml4_get_page (t->pml4, page->va) == NULL && pml4_set_page(t->pml4, page->va, frame->kva, page->writable)) { /*** 고민 필요!!! - true? ***/
-		return swap_in (page, frame->kva); // page fault가 일어났을 때 swap in
-	} else { // 만약 page fault에서 호출했는데 실패했으면 바로 프로세스 종료
-		// 나중에 vm_dealloc_page 써야 할듯? /*** GriiledSalmon ***/
-		return false;
+	for (scanned = 0; scanned < 2 * frame_cnt; scanned++) {
+		struct frame *frame = frame_table[clock_hand];
+
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		if (frame == NULL || frame->pin_cnt > 0 || frame->page_cnt == 0)
+			continue;
+		if (!frame_harvest_accessed (frame))
+			return frame;
 	}
+	return NULL;
 }
 
-/*** Dongdongbro ***/
-/* Initialize new supplemental page table */
-void
-supplemental_page_table_init (struct supplemental_page_table *spt) {
-	/*** 고민 필요!!!(init이 두번 불릴 경우를 고려) ***/
-	/*
-	if(spt->h != NULL){
-		free(spt->h);
-	}
-	*/
+/*** GrilledSalmon ***/
+/* FRAME을 매핑하는 page가 모두 T의 것이면 true. 다른 프로세스와 같이 쓰는 frame은
+ * RSS limit 때문에 내보내지 않는다. */
+static bool
+frame_owned_by (struct frame *frame, const struct thread *t) {
+	struct list_elem *e;
 
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+		if (list_entry (e, struct page, frame_elem)->owner != t)
+			return false;
+	return true;
+}
 
-	if (!hash_init(&spt->h, page_hash, page_less, NULL)){
-		PANIC("There are no memory in Kernel pool(malloc fail)");
+/*** GrilledSalmon ***/
+/* victim_clock과 같지만 T 혼자 쓰는 frame만 고른다. 그런 frame이 없거나 모두
+ * pinned이면 NULL. frame_lock을 잡고 불러야 한다. */
+static struct frame *
+victim_owned (const struct thread *t) {
+	size_t scanned;
+
+	for (scanned = 0; scanned < 2 * frame_cnt; scanned++) {
+		struct frame *frame = frame_table[owned_hand];
+
+		owned_hand = (owned_hand + 1) % frame_cnt;
+		if (frame == NULL || frame->pin_cnt > 0 || frame->page_cnt == 0
+				|| !frame_owned_by (frame, t))
+			continue;
+		if (!frame_harvest_accessed (frame))
+			return frame;
 	}
+	return NULL;
 }
 
 /*** GrilledSalmon ***/
-/* Checking the condition, copy file struct from parent to child. */
-static void copy_parent_file (struct file *parent_file, int parent_remain_cnt, tid_t child_tid, bool is_uninit, void *aux) {
-	if (is_uninit) {
-		struct lazy_info *lazy_info = aux;
-		if (parent_file->copying_child != child_tid) { 	/* First file copy condition */
-			lazy_info->file = file_reopen(parent_file);
-			lazy_info->remain_cnt = malloc(sizeof(int));
+/* active list가 inactive list보다 길지 않게 active list 앞에서부터 본다. 그 사이
+ * 접근된 frame은 active list 끝으로 돌리고, 아니면 inactive list 끝으로 내린다. */
+static void
+active_shrink (void) {
+	size_t budget = active_cnt;
 
-			memcpy(lazy_info->file, parent_file, sizeof(struct file));
-			*lazy_info->remain_cnt = parent_remain_cnt;
+	while (active_cnt > inactive_cnt && budget-- > 0) {
+		struct frame *frame = list_entry (list_pop_front (&active_frames),
+				struct frame, lru_elem);
 
-			parent_file->copying_child = child_tid;
-			parent_file->child_file = lazy_info->file;
-			parent_file->child_remain_cnt = lazy_info->remain_cnt;
-		} else {
-			lazy_info->file = parent_file->child_file;
-			lazy_info->remain_cnt = parent_file->child_remain_cnt;
+		if (frame->pin_cnt == 0 && frame_harvest_accessed (frame)) {
+			list_push_back (&active_frames, &frame->lru_elem);
+			continue;
 		}
-	} else {
-		struct file_page *file_page = aux;
-		if (parent_file->copying_child != child_tid) { 	/* First file copy condition */
-			file_page->file = file_reopen(parent_file);
-			file_page->remain_cnt = malloc(sizeof(int));
-
-			memcpy(file_page->file, parent_file, sizeof(struct file));
-			*file_page->remain_cnt = parent_remain_cnt;
-
-			parent_file->copying_child = child_tid;
-			parent_file->child_file = file_page->file;
-			parent_file->child_remain_cnt = file_page->remain_cnt;
-		} else {
-			file_page->file = parent_file->child_file;
-			file_page->remain_cnt = parent_file->child_remain_cnt;
+		frame->active = false;
+		frame->referenced = false;
+		active_cnt--;
+		list_push_back (&inactive_frames, &frame->lru_elem);
+		inactive_cnt++;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* 2Q: inactive list 앞에서부터 보고, 접근되지 않은 frame을 고른다. 접근된 frame은
+ * 처음이면 표시만 하고 끝으로 돌리며, 표시된 채로 또 접근되었으면 active list로
+ * 올린다. 새 frame은 fault 하면서 한 번 접근되므로, 한 번 읽고 마는 page는 두 번째
+ * 훑을 때 나간다. 고르지 못하면 active list를 줄여 가며 다시 본다. */
+static struct frame *
+victim_2q (void) {
+	size_t scanned;
+
+	for (scanned = 0; scanned < 4 * frame_cnt; scanned++) {
+		struct frame *frame;
+
+		active_shrink ();
+		if (list_empty (&inactive_frames))
+			return NULL;
+		frame = list_entry (list_pop_front (&inactive_frames), struct frame, lru_elem);
+		list_push_back (&inactive_frames, &frame->lru_elem);
+		if (frame->pin_cnt > 0 || frame->page_cnt == 0)
+			continue;
+		if (!frame_harvest_accessed (frame))
+			return frame;
+		if (!frame->referenced) {
+			frame->referenced = true;
+			continue;
 		}
+		list_remove (&frame->lru_elem);
+		inactive_cnt--;
+		frame->active = true;
+		frame->referenced = false;
+		list_push_back (&active_frames, &frame->lru_elem);
+		active_cnt++;
 	}
+	return NULL;
 }
 
-/*** Dongdongbro & GrilledSalmon ***/
-/* Copy supplemental page table from src to dst */
-bool
-supplemental_page_table_copy (struct supplemental_page_table *dst, struct supplemental_page_table *src) {
-	tid_t tid = thread_current()->tid;
-	struct hash_iterator i;
-	hash_first (&i, &src->h);
-	while (hash_next(&i)){
-		struct page *src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
-		enum vm_type type = VM_TYPE (src_page->operations->type);
-		struct lazy_info *dst_lazy_info;
-		struct page *dst_page;
+/*** haein ***/
+/* Evict one page and return the corresponding frame.
+ * Return NULL on error.
+ * 하나의 페이지를 evict 하고 상응하는 frame을 리턴
+ * 에러가 났을 때는 NULL을 리턴
+ * 프레임 테이블에서 없애고 swap table에서도 없앰 (swap out)
+ */
+static struct frame *
+vm_evict_frame (void) {
+	struct frame *frame;
 
-		switch (type)
-		{
-		case VM_UNINIT :
-		{
-			struct lazy_info *src_lazy_info = src_page->uninit.aux;
-			dst_lazy_info = malloc(sizeof(struct lazy_info));
-			memcpy(dst_lazy_info, src_lazy_info, sizeof(struct lazy_info));
-			if (src_page->uninit.type == VM_FILE) {
-				copy_parent_file(src_lazy_info->file, *src_lazy_info->remain_cnt, tid, true, dst_lazy_info);
-			}
+	return vm_evict_batch (&frame, NULL) > 0 ? frame : NULL;
+}
 
-			if(!vm_alloc_page_with_initializer(src_page->uninit.type, src_page->va, src_page->writable, src_page->uninit.init, dst_lazy_info)){
-				return false;
-			};
-		}
+/*** GrilledSalmon ***/
+/* EVICT_BATCH개까지 evict 하고 evict 한 수를 리턴한다. KEEP이 NULL이 아니면 첫
+ * victim은 user pool에 돌려보내지 않고 pinned인 채로 *KEEP에 넣는다. OWNER가
+ * NULL이 아니면 eviction policy 대신 OWNER 혼자 쓰는 frame에서만 고른다. */
+static size_t
+vm_evict_batch (struct frame **keep, struct thread *owner) {
+	struct frame *victims[EVICT_BATCH];
+	size_t victim_cnt, i;
+	struct list_elem *e;
+
+	/* clock을 한 번 돌 때 EVICT_BATCH개까지 골라서 한꺼번에 swap out 한다.
+	 * 이어서 할당되는 anon slot이 연속이라 디스크에서도 붙어서 쓰이고,
+	 * 첫 victim 말고는 user pool로 돌려보내서 다음 몇 번의 fault는 evict 없이
+	 * palloc에서 바로 frame을 얻는다.
+	 * victim을 매핑하는 page를 모두 not present로 만들어 두고 lock을 놓은 채로
+	 * swap out 한다. 그동안 유저는 frame을 고칠 수 없고, 그 page를 건드리는
+	 * 스레드는 frame_wait에서 기다린다. dirty bit는 pml4_clear_page 후에도 남는다. */
+	lock_acquire (&frame_lock);
+	for (victim_cnt = 0; victim_cnt < EVICT_BATCH; victim_cnt++) {
+		struct frame *victim = owner != NULL ? victim_owned (owner) : vm_get_victim ();
+		if (victim == NULL)
 			break;
-
-		case VM_ANON :
-		{	
-			if(!vm_alloc_page(type | src_page->anon.aux_type, src_page->va, src_page->writable) || !vm_claim_page(src_page->va)){
-				return false;
-			};
-			dst_page = spt_find_page(dst, src_page->va);
-			memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+		victim->pin_cnt++;	// 다음 vm_get_victim이 다시 고르지 않는다.
+		victim->evicting = true;
+		for (e = list_begin (&victim->pages); e != list_end (&victim->pages); e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, frame_elem);
+			if (page->pml4 != NULL)
+				pml4_clear_page (page->pml4, page->va); // pml4에서 삭제
 		}
-			break;
+		victims[victim_cnt] = victim;
+	}
+	lock_release (&frame_lock);
+	if (victim_cnt == 0)
+		return 0;
+	thread_current ()->rusage.nevict += victim_cnt;
+	TRACE (evict, victim_cnt, 0);
+
+	for (i = 0; i < victim_cnt; i++) {
+		/* 공유된 frame은 COW anon page이거나 page cache의 file page다. 한 번만 쓰고
+		 * anon은 나머지가 같은 slot을 쓰고, file은 모두 파일에서 다시 읽는다. */
+		struct page *first = list_entry (list_front (&victims[i]->pages), struct page, frame_elem);
+		/* 쓰는 sector는 page 주인의 몫이다. 주인은 frame_wait에서 기다리므로
+		 * 그동안 없어지지 않는다. */
+		thread_current ()->io_owner = first->owner;
+		if (!swap_out (first))
+			PANIC ("swap out failed");
+		thread_current ()->io_owner = NULL;
+		if (VM_TYPE (first->operations->type) != VM_ANON)
+			continue;
+		for (e = list_next (&first->frame_elem); e != list_end (&victims[i]->pages); e = list_next (e))
+			anon_share_slot (list_entry (e, struct page, frame_elem), first);
+	}
 
-		case VM_FILE :
-		{
-			if(!vm_alloc_page_with_initializer(type, src_page->va, src_page->writable, NULL, &src_page->file) || !vm_claim_page(src_page->va)){
-				return false;
-			};
-			dst_page = spt_find_page(dst, src_page->va);
-			memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
-			/*** 부모의 dirty bit를 복사해줘야 할까? 고민 필요!!!!! ***/
-			copy_parent_file(src_page->file.file, *src_page->file.remain_cnt, tid, false, &dst_page->file);
-			break;
-		}
+	lock_acquire (&frame_lock);
+	for (i = 0; i < victim_cnt; i++) {
+		struct frame *victim = victims[i];
 
-		default :
-			PANIC("Cached type");
-			break;
+		while (!list_empty (&victim->pages)) {
+			struct page *page = list_entry (list_front (&victim->pages), struct page, frame_elem);
+
+			frame_unlink (page);
+			/* buffer cache의 page는 spt에 없어서 여기서 해제한다. */
+			if (VM_TYPE (page->operations->type) == VM_PAGE_CACHE)
+				vm_dealloc_page (page);
+		}
+		victim->evicting = false;
+		/* 다 쓸 때까지 page cache에 남아 있어서 같은 위치를 읽으려는 fault는
+		 * cache_find에서 기다렸다가 파일에서 새로 읽는다. */
+		if (victim->inode != NULL)
+			page_cache_remove (victim);
+		if (i > 0 || keep == NULL) {
+			victim->pin_cnt--;
+			frame_release (victim);
 		}
 	}
-	return true;
+	// 첫 victim은 같은 kva, 같은 table 칸을 새 page가 이어서 쓴다.
+	cond_broadcast (&frame_evicted, &frame_lock);
+	lock_release (&frame_lock);
+
+	if (keep != NULL)
+		*keep = victims[0];
+	return victim_cnt;
 }
 
 /*** GrilledSalmon ***/
-void spt_hash_destructor (struct hash_elem *e, void *aux) {
-	struct page *page = hash_entry(e, struct page, hash_elem);
-	/* filebacked할 때 수정 필요!!!(writeback) */
+/* 빈 page가 kswapd_high가 될 때까지 evict 한다. 고를 victim이 없으면 다음에
+ * 넣을 때까지 그만둔다. */
+static void
+kswapd (void *aux UNUSED) {
+	kswapd_wakeups++;
+	while (palloc_user_free_cnt () < kswapd_high) {
+		size_t cnt = vm_evict_batch (NULL, NULL);
+		if (cnt == 0)
+			break;
+		kswapd_reclaimed += cnt;
+	}
+	kswapd_awake = false;
+}
 
-	return vm_dealloc_page(page);
+/* 빈 page가 low watermark 밑이면 kswapd work를 넣는다.  kswapd_awake는 lock 없이
+ * 보므로 가끔 두 번 넣을 수 있지만, 그러면 한 바퀴 더 보고 끝날 뿐이다. */
+static void
+kswapd_poke (void) {
+	if (kswapd_high > 0 && !kswapd_awake && palloc_user_free_cnt () < kswapd_low) {
+		kswapd_awake = true;
+		work_queue (&kswapd_work, WQ_NORMAL);
+	}
 }
 
-/*** GrilledSalmon ***/
-/* Free the resource hold by the supplemental page table */
-void
-supplemental_page_table_kill (struct supplemental_page_table *spt) {
-	/* TODO: Destroy all the supplemental_page_table hold by thread and
-	 * TODO: writeback all the modified contents to the storage. */
+static void
+kswapd_init (void) {
+	if (vm_kswapd_low == 0)
+		return;
+	kswapd_low = vm_kswapd_low > 0 ? (size_t) vm_kswapd_low : frame_cnt / 64;
+	if (kswapd_low < EVICT_BATCH)
+		kswapd_low = EVICT_BATCH;
+	kswapd_high = kswapd_low * 2;
+	if (kswapd_high > frame_cnt / 2) {
+		// 유저 풀이 이만큼 작으면 백그라운드로 비워 둘 여유가 없다.
+		kswapd_low = kswapd_high = 0;
+		return;
+	}
+	work_init (&kswapd_work, kswapd, NULL);
+}
+
+void
+kswapd_print_stats (void) {
+	if (kswapd_high > 0)
+		printf ("kswapd: watermarks %zu/%zu pages, %zu wakeups, %zu frames reclaimed\n",
+				kswapd_low, kswapd_high, kswapd_wakeups, kswapd_reclaimed);
+}
+
+
+/*** GrilledSalmon & haein ***/
+/* palloc() and get frame. If there is no available page, evict the page
+ * and return it. This always return valid address. That is, if the user pool
+ * memory is full, this function evicts the frame to get the available memory
+ * space.*/
+/* palloc()과 프레임을 얻어옵니다. 만약 이용가능한 페이지가 없으면, 페이지를 지우고 이를 리턴합니다.
+항상 유효한 주소값을 반환해야합니다. 만약 유저풀 메모리가 가득 찼다면 이 함수는 사용가능한 메모리 공간을 얻기 위해
+기존에 있던 프레임을 지워야합니다. */
+/* ZERO이면 0으로 채워진 프레임을 준다. */
+/*** GrilledSalmon ***/
+/* 유저 풀에 빈 page가 있으면 frame으로 만들어 리턴하고, 없으면 NULL을 리턴한다. */
+static struct frame *
+frame_from_pool (bool zero) {
+	struct frame *frame;
+	uint64_t *kva = palloc_get_page(PAL_USER | (zero ? PAL_ZERO : 0));
+
+	kswapd_poke ();
+	if (kva == NULL)
+		return NULL;
+	frame = kmem_cache_alloc(vm_frame_cache);
+	ASSERT (frame != NULL);
+	frame->kva = kva;
+	frame_prepare(frame);
+	return frame;
+}
+
+/*** GrilledSalmon ***/
+/* evict 하지 않고 frame을 얻는다. fault around나 stack chunk처럼 당장 필요하지
+ * 않은 page를 위한 것이라 RSS limit를 넘었으면 NULL을 리턴한다. */
+static struct frame *
+vm_try_get_frame (bool zero) {
+	if (rss_over_limit (thread_current ()->leader))
+		return NULL;
+	return frame_from_pool (zero);
+}
+
+static struct frame *
+vm_get_frame (bool zero) {
+	struct frame *frame = NULL;
+
+	/* TODO: Fill this function. */
+	/* RSS limit를 넘은 프로세스는 빈 page가 있어도 자기 frame을 먼저 내보내서
+	 * 다른 프로세스의 page를 밀어내지 않는다. 내보낼 자기 frame이 없으면 평소처럼
+	 * 얻는다. */
+	if (!rss_over_limit (thread_current ()->leader)
+			|| vm_evict_batch (&frame, thread_current ()->leader) == 0) {
+		frame = frame_from_pool (zero);
+		if (frame != NULL)
+			return frame;
+		frame = vm_evict_frame(); //  evict 시킨 frame을 그대로 다시 쓴다.
+	}
+	ASSERT (frame != NULL);
+	if (zero)
+		clear_page(frame->kva);
+	frame_prepare(frame);
+	return frame;
+}
+
+/*** GrilledSalmon ***/
+/* 새로 얻은 FRAME을 비어 있고 pinned인 상태로 frame table에 넣는다. */
+static void
+frame_prepare (struct frame *frame) {
+	list_init(&frame->pages);
+	frame->page_cnt = 0;
+	frame->pin_cnt = 1;	// 받아 간 쪽이 page를 연결하고 내용을 채울 때까지
+	frame->evicting = false;
+	frame->inode = NULL;
+
+	lock_acquire(&frame_lock);
+	frame_table_insert(frame); // frame_table에 추가
+	lock_release(&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* PAGE를 frame에서 떼어낸다. evict 중이면 끝날 때까지 기다린다. 다른 page가
+ * 아직 frame을 공유하고 있으면 PAGE의 매핑만 지워서 pml4_destroy가 kva를 해제하지
+ * 않게 하고, 마지막 page였으면 frame을 frame table에서 빼고 해제한다.
+ * kva는 해제하지 않는다. page가 메모리에 없으면 아무것도 하지 않는다. */
+void
+vm_free_frame (struct page *page) {
+	struct frame *frame;
+
+	/* frame은 page 주인의 fault만 새로 붙이므로 없으면 lock 없이 돌아가도 된다. */
+	if (page->frame == NULL)
+		return;
+	lock_acquire(&frame_lock);
+	frame = frame_wait(page);
+	if (frame == NULL) {
+		lock_release(&frame_lock);
+		return;
+	}
+	frame_unlink(page);
+	if (frame->page_cnt > 0 || frame == &zero_frame) {
+		pml4_clear_page(page->pml4, page->va);
+		lock_release(&frame_lock);
+		return;
+	}
+	frame_table_remove(frame);
+	if (frame->inode != NULL)
+		page_cache_remove(frame);	// 공유하던 read-only segment page
+	lock_release(&frame_lock);
+	kmem_cache_free(vm_frame_cache, frame);
+}
+
+/*** GrilledSalmon ***/
+/* file page인 PAGE를 vm_frame_pin으로 pin 한 FRAME에서 떼어내고 매핑을 지운다.
+ * PAGE가 남긴 dirty bit는 커널 매핑으로 옮겨서 frame을 계속 쓰는 page들이 나중에
+ * 파일에 쓰게 한다. 마지막 page였으면 true를 리턴한다. 그러면 부른 쪽이 파일에
+ * 쓰고 vm_frame_release로 해제하고, 그때까지 같은 위치의 fault는 기다린다. */
+bool
+vm_frame_detach (struct page *page, struct frame *frame) {
+	bool last;
+
+	lock_acquire(&frame_lock);
+	if (pml4_is_dirty(page->pml4, page->va))
+		pml4_set_dirty(base_pml4, frame->kva, true);
+	frame_unlink(page);
+	pml4_clear_page(page->pml4, page->va);
+	frame->pin_cnt--;
+	last = frame->page_cnt == 0;
+	if (last) {
+		ASSERT (frame->pin_cnt == 0);
+		frame->evicting = true;
+	}
+	lock_release(&frame_lock);
+	return last;
+}
+
+/*** GrilledSalmon ***/
+/* FRAME을 쓸 수 있게 매핑한 page가 있으면 true. */
+static bool
+frame_mapped_writable (struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+		if (list_entry (e, struct page, frame_elem)->writable)
+			return true;
+	return false;
+}
+
+/*** GrilledSalmon ***/
+/* write-back daemon이 파일에 쓸 dirty file frame을 MAX개까지 FRAMES에 골라 준다.
+ * page cache에서 DIRTY tag가 붙은 frame만 본다. 고른 frame은 pin 하고 evicting으로
+ * 두어서 쓰는 동안 evict나 munmap이 기다리게 하고, dirty bit는 미리 지운다. 쓰는
+ * 사이에 유저가 고치면 다시 dirty가 되어 다음 번에 또 쓴다. clean이고 쓸 수 있는
+ * 매핑도 없는 frame은 tag를 지운다. 다 쓰면 vm_flush_done으로 놓는다. */
+size_t
+vm_flush_pick (struct frame **frames, size_t max) {
+	struct frame *frame;
+	size_t cnt = 0;
+
+	lock_acquire(&frame_lock);
+	while (cnt < max && (frame = page_cache_next_dirty ()) != NULL) {
+		struct page *page;
+
+		if (frame->page_cnt == 0 || frame->pin_cnt > 0 || frame->evicting)
+			continue;
+		page = list_entry(list_front(&frame->pages), struct page, frame_elem);
+		if (VM_TYPE(page->operations->type) != VM_FILE)
+			continue;
+		if (!vm_frame_is_dirty(frame)) {
+			if (!frame_mapped_writable (frame))
+				page_cache_clear_dirty (frame);
+			continue;
+		}
+		frame->pin_cnt++;
+		frame->evicting = true;
+		vm_frame_clear_dirty(frame);
+		page_cache_set_writeback (frame, true);
+		frames[cnt++] = frame;
+	}
+	lock_release(&frame_lock);
+	return cnt;
+}
+
+/*** GrilledSalmon ***/
+/* msync: file page인 PAGE가 dirty frame에 있으면 vm_flush_pick처럼 pin 하고
+ * evicting으로 둔 다음 dirty bit를 지우고 리턴한다. 부른 쪽이 파일에 쓰고
+ * vm_flush_done으로 놓는다. 메모리에 없거나 clean이면 NULL이다. ASYNC이면 page
+ * cache에 있는 frame은 write-back daemon에 맡기고 NULL을 리턴한다. 쓸 수 있게
+ * 매핑된 frame에는 DIRTY tag가 붙어 있어서 daemon이 다음 주기에 찾아 쓴다. */
+struct frame *
+vm_msync_pick (struct page *page, bool async) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = frame_wait(page);
+	if (frame == NULL || !vm_frame_is_dirty(frame)) {
+		lock_release(&frame_lock);
+		return NULL;
+	}
+	if (async && frame->inode != NULL) {
+		page_cache_mark_dirty (frame);
+		lock_release(&frame_lock);
+		return NULL;
+	}
+	frame->pin_cnt++;
+	frame->evicting = true;
+	vm_frame_clear_dirty(frame);
+	if (frame->inode != NULL)
+		page_cache_set_writeback (frame, true);
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/*** GrilledSalmon ***/
+/* buffer cache에서 밀려난 sector를 담을 frame을 유저 풀에서 받아 VM_PAGE_CACHE page인
+ * PAGE와 연결한다. 유저 매핑이 없는 page라 pml4와 owner는 NULL이다. frame은 다른
+ * 유저 frame과 함께 clock이 고르고, vm_evict_batch가 swap_out으로 알린 다음 PAGE를
+ * 해제한다. 부른 쪽이 bc_lock을 잡고 있을 수 있어서 evict 하지 않고, 빈 page가
+ * 없으면 false를 리턴한다. */
+bool
+vm_cache_frame_get (struct page *page) {
+	struct frame *frame = frame_from_pool (false);
+
+	if (frame == NULL)
+		return false;
+	page->pml4 = NULL;
+	page->owner = NULL;
+	lock_acquire (&frame_lock);
+	frame_link (frame, page);
+	frame->pin_cnt--;
+	lock_release (&frame_lock);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* vm_flush_pick이나 vm_msync_pick으로 고른 CNT개의 FRAMES를 놓는다. */
+void
+vm_flush_done (struct frame **frames, size_t cnt) {
+	size_t i;
+
+	lock_acquire(&frame_lock);
+	for (i = 0; i < cnt; i++) {
+		if (frames[i]->inode != NULL)
+			page_cache_set_writeback (frames[i], false);
+		frames[i]->evicting = false;
+		frames[i]->pin_cnt--;
+	}
+	cond_broadcast(&frame_evicted, &frame_lock);
+	lock_release(&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* vm_frame_detach로 떼어낸 FRAME을 page cache와 frame table에서 빼고 해제한다. */
+void
+vm_frame_release (struct frame *frame) {
+	lock_acquire(&frame_lock);
+	frame->evicting = false;
+	frame_release(frame);
+	cond_broadcast(&frame_evicted, &frame_lock);
+	lock_release(&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* pml4 없이 frame에 연결된 PAGE(shared memory segment의 anchor)를 떼어낸다.
+ * 마지막 page였으면 frame과 kva를 해제한다. evict 중이면 끝날 때까지 기다린다. */
+void
+vm_release_frame (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = frame_wait (page);
+	if (frame != NULL) {
+		frame_unlink (page);
+		if (frame->page_cnt == 0)
+			frame_release (frame);
+	}
+	lock_release (&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* VA에 stack page를 만든다. 이미 page나 mmap 영역이 있으면 false. 유저 풀에 빈 page가
+ * 있으면 미리 0으로 채워 둔 frame을 바로 매핑하고, 없으면 처음 건드릴 때 받는다. */
+static bool
+stack_add_page (void *va) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	struct frame *frame;
+
+	if (va < (void *) (USER_STACK_LIMIT) || spt_find_page (spt, va) != NULL
+			|| vma_find (spt, va) != NULL)
+		return false;
+	if (!vm_alloc_page (VM_STACK, va, true))
+		return false;
+	frame = vm_try_get_frame (true);
+	if (frame != NULL)
+		vm_map_frame (spt_find_page (spt, va), frame);
+	return true;
+}
+
+/*** Dongdongbro ***/
+/* Growing the stack. */
+/* fault 난 page와 함께 모두 vm_stack_chunk_pages개까지 늘린다. 큰 stack 배열은 보통
+ * 낮은 주소부터 채우므로 먼저 위로 이미 있는 stack까지의 빈 곳을 채우고, 남은 만큼
+ * 아래로 더 늘린다. */
+static void
+vm_stack_growth (void *addr) {
+	size_t cnt = 1;
+	void *va;
+
+	addr = pg_round_down(addr);
+
+	if (addr < USER_STACK_LIMIT){
+		goto err;
+	}
+	if (vm_alloc_page(VM_STACK, addr, true) && vm_claim_page(addr)) {
+		for (va = addr + PGSIZE; cnt < vm_stack_chunk_pages && va < (void *) USER_STACK
+				&& stack_add_page (va); va += PGSIZE)
+			cnt++;
+		for (va = addr - PGSIZE; cnt < vm_stack_chunk_pages && stack_add_page (va); va -= PGSIZE)
+			cnt++;
+		return;
+	}
+
+err :
+	PANIC("Stack growth failed!");
+}
+
+/*** GrilledSalmon ***/
+/* exec 한 프로세스가 STACK_RESERVE로 PAGES개의 stack을 달라고 했다. 처음 page 아래로
+ * 나머지를 미리 만들어 두어 그만큼은 stack growth 없이 쓴다. USER_STACK_LIMIT 아래로는
+ * 만들지 않는다. */
+void
+vm_stack_reserve (size_t pages) {
+	void *va = (uint8_t *) USER_STACK - 2 * PGSIZE;
+	size_t i;
+
+	for (i = 1; i < pages && stack_add_page (va); i++)
+		va -= PGSIZE;
+}
+
+/*** GrilledSalmon ***/
+/* PAGE를 매핑하는 PTE를 FRAME을 가리키고 쓰기 권한이 WRITABLE인 것으로 바꾼다.
+ * pml4_clear_page가 현재 pml4의 TLB도 비운다. */
+static bool
+page_remap (struct page *page, struct frame *frame, bool writable) {
+	pml4_clear_page (page->pml4, page->va);
+	return pml4_set_page (page->pml4, page->va, frame->kva, writable);
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 내용 없이 0으로 시작하는 anon page(stack, 통째로 BSS인 segment page)이고
+ * 아직 한 번도 claim 되지 않았으면 true. */
+static bool
+page_is_zero_fill (struct page *page) {
+	return VM_TYPE(page->operations->type) == VM_UNINIT
+		&& VM_TYPE(page->uninit.type) == VM_ANON && page->uninit.init == NULL;
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 아직 claim 되지 않았고 파일 내용으로 채워지는 page(mmap 또는 실행 파일의
+ * segment)이면 true. */
+static bool
+page_is_file_filled (struct page *page) {
+	return VM_TYPE(page->operations->type) == VM_UNINIT && page->uninit.init != NULL
+		&& (VM_TYPE(page->uninit.type) == VM_FILE || page->uninit.type == VM_SEG);
+}
+
+/*** GrilledSalmon ***/
+/* 방금 fault로 채운 PAGE 뒤로 이어지는, 같은 종류의 아직 읽지 않은 page를
+ * CNT개까지 한 번에 읽어 매핑한다. 파일을 순서대로 훑을 때
+ * page마다 fault 나지 않게 한다. 미리 읽자고 남의 page를 evict 하지는 않으므로
+ * 유저 풀이 비면 멈춘다. */
+static void
+vm_fault_around (struct page *page, size_t cnt) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	enum vm_type type = VM_TYPE (page->operations->type) == VM_FILE ? VM_FILE : VM_SEG;
+	size_t i;
+
+	for (i = 1; i <= cnt; i++) {
+		struct page *next = spt_get_page (spt, page->va + i * PGSIZE);
+		struct frame *frame;
+
+		if (next == NULL || !page_is_file_filled (next) || next->uninit.type != type)
+			break;
+		frame = vm_try_get_frame (false);
+		if (frame == NULL || !vm_map_frame (next, frame))
+			break;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* zero-fill PAGE를 처음 읽을 때 frame을 받지 않고 zero_frame에 read-only로 매핑한다. */
+static bool
+vm_map_zero_page (struct page *page) {
+	struct thread *t = thread_current ();
+	bool success;
+
+	/* uninit -> anon. initializer가 없어 kva를 건드리지 않는다. */
+	if (!swap_in (page, NULL))
+		return false;
+
+	lock_acquire (&frame_lock);
+	page->owner = t->leader;
+	frame_link (&zero_frame, page);
+	page->pml4 = t->pml4;
+	success = pml4_set_page (t->pml4, page->va, zero_frame.kva, false);
+	if (!success)
+		frame_unlink (page);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* Handle the fault on write_protected page.
+ * COW: frame을 혼자 쓰고 있으면 쓰기 권한만 다시 주고, 아직 공유 중이면 건드린
+ * 이 page만 새 frame에 복사해서 떼어낸다. zero_frame이면 복사 대신 0으로 채워진
+ * 새 frame을 준다. */
+static bool
+vm_handle_wp (struct page *page) {
+	struct frame *frame, *copy;
+
+	lock_acquire (&frame_lock);
+	frame = frame_wait (page);
+	if (frame == NULL) {
+		/* 그 사이 evict 되었다. 다시 fault 나면서 자기 frame을 받는다. */
+		lock_release (&frame_lock);
+		return true;
+	}
+	if (frame->page_cnt == 1 && frame != &zero_frame) {
+		bool success = page_remap (page, frame, true);
+		lock_release (&frame_lock);
+		return success;
+	}
+	frame->pin_cnt++;	// 복사하는 동안 evict 되지 않게
+	lock_release (&frame_lock);
+
+	copy = vm_get_frame (frame == &zero_frame);
+	if (frame != &zero_frame)
+		copy_page (copy->kva, frame->kva);
+
+	lock_acquire (&frame_lock);
+	frame_unlink (page);
+	frame->pin_cnt--;
+	if (frame->page_cnt == 0 && frame->pin_cnt == 0)
+		frame_release (frame);	// 복사하는 사이 다른 page들이 모두 떠났다.
+	frame_link (copy, page);
+	copy->pin_cnt--;
+	if (!page_remap (page, copy, true)) {
+		lock_release (&frame_lock);
+		return false;
+	}
+	/* 복사하면서 kva로 쓴 것은 수정이 아니다. slot이 있으면 그 내용과 같다. */
+	vm_frame_clear_dirty (copy);
+	lock_release (&frame_lock);
+	return true;
+}
+
+
+/*** GrilledSalmon ***/
+/* Return true on success */
+static bool
+vm_handle_fault (struct intr_frame *f UNUSED, void *addr,
+		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
+	struct thread *t = thread_current();
+	struct page *page = spt_get_page(&t->leader->spt, addr);	// mmap page는 여기서 만든다.
+	void *rsp;
+	/* TODO: Validate the fault */
+	/* TODO: Your code goes here */
+
+	if (is_user_vaddr(f->rsp)) {
+		rsp = f->rsp;
+		t->rsp = rsp;
+	} else {
+		rsp = t->rsp;
+	}
+
+	if(page == NULL){
+		if ((addr == rsp - 8 || (rsp<=addr && addr<USER_STACK) && rsp != NULL)) { // stack growth
+			vm_stack_growth(addr);
+			t->rusage.nstack++;
+			return true;
+		}
+		return false;
+	}
+
+	/* 있는 page에 쓰려다 난 protection fault는 COW page에 쓴 것이다. */
+	if (!not_present)
+		return write && page->writable && vm_handle_wp (page);
+
+	/* evict 중이던 page면 끝나고 나서 다시 읽어 온다. */
+	lock_acquire (&frame_lock);
+	if (frame_wait (page) != NULL) {
+		lock_release (&frame_lock);
+		return true;
+	}
+	lock_release (&frame_lock);
+	/* 읽기만 하는 zero-fill page는 쓰기 전까지 frame을 받지 않는다. */
+	if (!write && page_is_zero_fill (page))
+		return vm_map_zero_page (page);
+	if (!page_is_file_filled (page))
+		return vm_do_claim_page (page);
+	if (!vm_do_claim_page (page))
+		return false;
+	struct vma *vma = vma_find (&t->leader->spt, page->va);
+	if (vma != NULL && vma->sequential) {
+		vm_fault_around (page, vm_fault_around_pages > SEQ_WINDOW_PAGES ?
+				vm_fault_around_pages : SEQ_WINDOW_PAGES);
+		vm_drop_behind (&t->leader->spt, vma, page->va);
+	} else
+		vm_fault_around (page, vm_fault_around_pages);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* 처리하면서 swap이나 파일에서 읽지 않은 fault는 minor fault로 센다.
+ * 읽은 곳(swap_in, lazy load)에서 majflt를 센다. */
+bool
+vm_try_handle_fault (struct intr_frame *f, void *addr,
+		bool user, bool write, bool not_present) {
+	struct thread *t = thread_current();
+	long majflt = t->rusage.majflt;
+	bool success, locked;
+
+	TRACE (page_fault, addr, write << 1 | user);
+	locked = spt_lock (&t->leader->spt);
+	success = vm_handle_fault (f, addr, user, write, not_present);
+	spt_unlock (&t->leader->spt, locked);
+
+	if (success && t->rusage.majflt == majflt)
+		t->rusage.minflt++;
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* SPT의 page 중 지금 frame에 있는 page 수. zero_frame을 같이 쓰는 page는 뺀다. */
+size_t
+vm_resident_pages (struct supplemental_page_table *spt) {
+	struct ohash_iterator i;
+	size_t cnt = 0;
+
+	lock_acquire (&frame_lock);
+	ohash_first (&i, &spt->h);
+	while (ohash_next (&i)) {
+		struct page *page = ohash_entry (ohash_cur (&i), struct page, hash_elem);
+		if (page->frame != NULL && page->frame != &zero_frame)
+			cnt++;
+	}
+	lock_release (&frame_lock);
+	return cnt;
+}
+
+/*** GrilledSalmon ***/
+/* [START, END)의 메모리에 없는 page를 미리 읽어 매핑한다. EVICT가 false이면 다른
+ * page를 evict 하지 않고 유저 풀이 비면 멈춘다(MADV_WILLNEED). true이면 fault가
+ * 난 것처럼 모두 채운다(MAP_POPULATE). zero-fill page는 건드리지 않는다. */
+void
+vm_prefault (void *start, void *end, bool evict) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *va;
+
+	/* MAP_POPULATE는 영역의 page를 모두 만드므로 spt를 미리 키워 둔다. */
+	if (evict)
+		ohash_reserve (&spt->h, ohash_size (&spt->h)
+				+ (pg_round_up (end) - pg_round_down (start)) / PGSIZE);
+	for (va = pg_round_down (start); va < end; va += PGSIZE) {
+		struct page *page = spt_get_page (spt, va);
+		struct frame *frame;
+		bool resident;
+
+		if (page == NULL || page_is_zero_fill (page))
+			continue;
+		lock_acquire (&frame_lock);
+		resident = frame_wait (page) != NULL;
+		lock_release (&frame_lock);
+		if (resident)
+			continue;
+		frame = evict ? vm_get_frame (false) : vm_try_get_frame (false);
+		if (frame == NULL || !vm_map_frame (page, frame))
+			break;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* [UADDR, UADDR + SIZE)의 page를 모두 메모리에 올려 쓸 수 있게 매핑하고 frame을
+ * pin 한다. 커널이 디스크에서 이 버퍼로 바로 읽는 동안 page fault가 나면 디스크
+ * lock을 잡은 채 다시 디스크를 읽으려 하기 때문이다. 없거나 쓸 수 없는 page가
+ * 있으면 pin 한 것을 풀고 false를 리턴한다. 다 쓰면 vm_unpin_user로 푼다. */
+bool
+vm_pin_user (void *uaddr, size_t size) {
+	struct thread *t = thread_current ();
+	struct supplemental_page_table *spt = &t->leader->spt;
+	void *start = pg_round_down (uaddr);
+	void *va;
+	bool locked = spt_lock (spt);
+
+	for (va = start; va < uaddr + size; va += PGSIZE) {
+		struct page *page = spt_get_page (spt, va);
+		struct frame *frame = NULL;
+
+		if (page == NULL || !page->writable) {
+			vm_unpin_user (start, va - start);
+			spt_unlock (spt, locked);
+			return false;
+		}
+		while (frame == NULL) {
+			uint64_t *pte;
+
+			/* 쓰기 fault로 page를 올리고 copy-on-write도 풀어 둔다. 내용은 그대로다. */
+			*(volatile uint8_t *) va = *(volatile uint8_t *) va;
+			frame = vm_frame_pin (page);
+			pte = pml4e_walk (t->pml4, (uint64_t) va, false);
+			if (frame != NULL
+					&& (pte == NULL || !(*pte & PTE_P) || !is_writable (pte))) {
+				/* pin 하기 전에 다시 read-only가 되었다. */
+				lock_acquire (&frame_lock);
+				frame->pin_cnt--;
+				lock_release (&frame_lock);
+				frame = NULL;
+			}
+		}
+	}
+	spt_unlock (spt, locked);
+	return true;
+}
+
+/* vm_pin_user로 pin 한 [UADDR, UADDR + SIZE)의 frame을 푼다. */
+void
+vm_unpin_user (void *uaddr, size_t size) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *va;
+
+	lock_acquire (&frame_lock);
+	for (va = pg_round_down (uaddr); va < uaddr + size; va += PGSIZE) {
+		struct page *page = spt_get_page (spt, va);
+
+		ASSERT (page != NULL && page->frame != NULL);
+		page->frame->pin_cnt--;
+	}
+	lock_release (&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* MADV_SEQUENTIAL인 VMA를 VA까지 읽어 왔으면 SEQ_WINDOW_PAGES만큼 뒤의 page는
+ * 다시 쓰이지 않을 것이다. accessed bit를 지워서 clock이 먼저 고르게 한다. */
+static void
+vm_drop_behind (struct supplemental_page_table *spt, struct vma *vma, void *va) {
+	struct page *page;
+
+	if (va < vma->start + SEQ_WINDOW_PAGES * PGSIZE)
+		return;
+	page = spt_find_page (spt, va - SEQ_WINDOW_PAGES * PGSIZE);
+	if (page == NULL)
+		return;
+	lock_acquire (&frame_lock);
+	if (page->frame != NULL && !page->frame->evicting)
+		frame_harvest_accessed (page->frame);
+	if (page->frame != NULL && page->frame != &zero_frame)
+		page->frame->referenced = false;	// 2Q: active list에 있으면 곧 내려간다.
+	lock_release (&frame_lock);
+}
+
+/*** GrilledSalmon ***/
+/* MADV_DONTNEED: PAGE의 frame과 swap slot을 바로 놓는다. mmap page는 dirty면 파일에
+ * 쓰고 없앤다. 다음에 건드리면 VMA에서 다시 만들어 파일에서 읽는다. anon page는
+ * 0으로 시작하는 새 page로 바꾼다. 실행 파일의 segment page는 다시 읽어 올 곳을
+ * 기억하지 않으므로 그대로 둔다. */
+static void
+vm_drop_page (struct supplemental_page_table *spt, struct page *page) {
+	enum vm_type type = VM_TYPE (page->operations->type);
+	void *va = page->va;
+	bool writable = page->writable;
+	uint64_t *pml4 = thread_current ()->pml4;
+	enum vm_type aux;
+	void *kva;
+
+	if (type == VM_UNINIT) {
+		if (VM_TYPE (page->uninit.type) == VM_FILE)
+			spt_remove_page (spt, page);
+		return;		// 아직 읽지 않은 page는 놓을 것이 없다.
+	}
+	if (type == VM_FILE || type == VM_SHM) {
+		/* file_backed_destroy와 shm_destroy가 매핑까지 정리한다. shm page는 다음
+		 * fault에서 VMA로 다시 만들고 segment의 내용은 그대로다. */
+		spt_remove_page (spt, page);
+		return;
+	}
+
+	aux = page->anon.aux_type;
+	if (aux == VM_AUXTYPE (VM_SEG))
+		return;
+	spt_remove_page (spt, page);
+	/* frame을 혼자 쓰고 있었으면 vm_free_frame은 매핑과 kva를 남겨 둔다. */
+	kva = pml4_get_page (pml4, va);
+	if (kva != NULL) {
+		pml4_clear_page (pml4, va);
+		palloc_free_page (kva);
+	}
+	if (!vm_alloc_page (VM_ANON | aux, va, writable))
+		PANIC ("madvise: cannot re-create page");
+}
+
+/*** GrilledSalmon ***/
+/* madvise 시스템 콜. [ADDR, ADDR + LENGTH)의 모든 page가 있어야 한다. */
+int
+vm_madvise (void *addr, size_t length, int advice) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	void *end = addr + ROUND_UP (length, PGSIZE);
+	void *va;
+
+	if (pg_ofs (addr) != 0 || length == 0 || end <= addr || !is_user_vaddr (end - 1))
+		return -1;
+	for (va = addr; va < end; va += PGSIZE)
+		if (spt_find_page (spt, va) == NULL && vma_find (spt, va) == NULL)
+			return -1;
+
+	switch (advice) {
+	case MADV_NORMAL:
+	case MADV_SEQUENTIAL:
+		for (va = addr; va < end; ) {
+			struct vma *vma = vma_find (spt, va);
+			if (vma == NULL) {
+				va += PGSIZE;
+				continue;
+			}
+			vma->sequential = advice == MADV_SEQUENTIAL;
+			va = vma->end;
+		}
+		return 0;
+
+	case MADV_WILLNEED:
+		vm_prefault (addr, end, false);
+		return 0;
+
+	case MADV_DONTNEED:
+		for (va = addr; va < end; va += PGSIZE) {
+			struct page *page = spt_find_page (spt, va);
+			if (page != NULL)
+				vm_drop_page (spt, page);
+		}
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+/*** GrilledSalmon ***/
+/* Kernel same-page merging. -ksm로 켜면 가장 낮은 우선순위의 ksmd가 frame table을
+ * 돌면서 anon frame의 내용을 hash 하고, 같은 내용의 frame을 찾으면 한쪽의 page들을
+ * 다른 쪽으로 옮겨 read-only로 같이 쓰게 하고 빈 frame을 해제한다. 나중에 쓰면
+ * fork의 COW와 똑같이 vm_handle_wp가 다시 나눈다.
+ * ksm_table은 frame table을 한 바퀴 도는 동안 본 내용의 hash -> kva이고 한 바퀴가
+ * 끝나면 비운다. 그 사이 frame이 해제되었을 수 있어서 합치기 전에 kva로 frame을
+ * 다시 찾고 내용을 끝까지 비교한다. frame_lock이 보호한다. */
+bool vm_ksm_enabled;
+static struct hash ksm_table;
+static size_t ksm_hand;
+static size_t ksm_merged;
+
+/* ksmd가 KSM_INTERVAL tick마다 살펴보는 frame 수. */
+#define KSM_INTERVAL (TIMER_FREQ / 10)
+#define KSM_SCAN_PAGES 32
+
+struct ksm_item {
+	struct hash_elem elem;
+	uint64_t sum;		// kva 내용의 hash_bytes
+	void *kva;
+};
+
+static uint64_t
+ksm_item_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_entry (e, struct ksm_item, elem)->sum;
+}
+
+static bool
+ksm_item_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+	return hash_entry (a, struct ksm_item, elem)->sum < hash_entry (b, struct ksm_item, elem)->sum;
+}
+
+static void
+ksm_item_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct ksm_item, elem));
+}
+
+/* COW로 나누어도 되는 anon frame인지. page cache의 frame과 zero_frame은 빼고,
+ * evict나 복사 중인 frame은 건드리지 않는다. frame_lock을 잡고 불러야 한다. */
+static bool
+ksm_mergeable (struct frame *frame) {
+	struct page *page;
+
+	if (frame == NULL || frame->page_cnt == 0 || frame->pin_cnt > 0
+			|| frame->evicting || frame->inode != NULL)
+		return false;
+	page = list_entry (list_front (&frame->pages), struct page, frame_elem);
+	return VM_TYPE (page->operations->type) == VM_ANON;
+}
+
+/* FRAME의 모든 page를 read-only로 만든다. PTE를 새로 만들면서 지워지는 dirty bit는
+ * 커널 매핑으로 옮겨 둔다. frame_lock을 잡고 불러야 한다. */
+static bool
+ksm_protect (struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, frame_elem);
+
+		if (pml4_is_dirty (page->pml4, page->va))
+			pml4_set_dirty (base_pml4, frame->kva, true);
+		if (!page_remap (page, frame, false))
+			return false;
+	}
+	return true;
+}
+
+/* FRAME이 고쳐졌으면 그 page들의 slot은 낡았으니 놓고 dirty bit를 지운다.
+ * 공유된 frame을 vm_handle_wp가 복사할 때 slot과 내용이 같다고 보기 때문이다. */
+static void
+ksm_drop_stale_slots (struct frame *frame) {
+	struct list_elem *e;
+
+	if (!vm_frame_is_dirty (frame))
+		return;
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+		anon_drop_slot (list_entry (e, struct page, frame_elem));
+	vm_frame_clear_dirty (frame);
+}
+
+/* SRC의 page들을 DST로 옮기고 SRC를 해제한다. 먼저 둘 다 read-only로 만들어서
+ * 비교하는 동안 바뀌지 않게 하고, 내용이 다르면 그대로 둔다. 쓰기 fault가 나면
+ * vm_handle_wp가 쓰기 권한을 돌려준다. frame_lock을 잡고 불러야 한다. */
+static bool
+ksm_merge (struct frame *dst, struct frame *src) {
+	struct page *first;
+
+	if (!ksm_protect (dst) || !ksm_protect (src)
+			|| memcmp (dst->kva, src->kva, PGSIZE) != 0)
+		return false;
+
+	/* 한 frame의 page들은 같은 slot을 쓴다. SRC의 page들은 DST의 slot을 받는다. */
+	ksm_drop_stale_slots (dst);
+	ksm_drop_stale_slots (src);
+	first = list_entry (list_front (&dst->pages), struct page, frame_elem);
+	while (!list_empty (&src->pages)) {
+		struct page *page = list_entry (list_front (&src->pages), struct page, frame_elem);
+
+		frame_unlink (page);
+		frame_link (dst, page);
+		anon_share_slot (page, first);
+		if (!page_remap (page, dst, false))
+			PANIC ("ksm: cannot remap page");
+	}
+	frame_release (src);
+	ksm_merged++;
+	return true;
+}
+
+/* FRAME의 내용을 ksm_table에서 찾아서 같은 내용의 frame이 있으면 합치고,
+ * 없으면 FRAME을 넣는다. frame_lock을 잡고 불러야 한다. */
+static void
+ksm_scan_frame (struct frame *frame) {
+	struct ksm_item key, *item;
+	struct hash_elem *e;
+
+	if (!ksm_mergeable (frame))
+		return;
+	key.sum = hash_bytes (frame->kva, PGSIZE);
+	e = hash_find (&ksm_table, &key.elem);
+	if (e != NULL) {
+		struct frame *other;
+
+		item = hash_entry (e, struct ksm_item, elem);
+		other = frame_table[frame_index (item->kva)];
+		if (other != frame && ksm_mergeable (other) && ksm_merge (other, frame))
+			return;
+		item->kva = frame->kva;		// 해제되었거나 내용이 바뀐 frame 대신
+		return;
+	}
+	item = malloc (sizeof *item);
+	if (item == NULL)
+		return;
+	item->sum = key.sum;
+	item->kva = frame->kva;
+	hash_insert (&ksm_table, &item->elem);
+}
+
+/* ksmd. 다른 스레드가 없을 때만 돈다. */
+static void
+ksm_daemon (void *aux UNUSED) {
+	for (;;) {
+		size_t i;
+
+		timer_sleep (KSM_INTERVAL);
+		for (i = 0; i < KSM_SCAN_PAGES; i++) {
+			lock_acquire (&frame_lock);
+			ksm_scan_frame (frame_table[ksm_hand]);
+			ksm_hand = (ksm_hand + 1) % frame_cnt;
+			if (ksm_hand == 0)
+				hash_clear (&ksm_table, ksm_item_free);
+			lock_release (&frame_lock);
+		}
+	}
+}
+
+static void
+ksm_init (void) {
+	if (!hash_init (&ksm_table, ksm_item_hash, ksm_item_less, NULL))
+		PANIC ("ksm table allocation failed");
+	if (thread_create ("ksmd", PRI_MIN, ksm_daemon, NULL) == TID_ERROR)
+		PANIC ("cannot start ksmd");
+}
+
+void
+ksm_print_stats (void) {
+	if (vm_ksm_enabled)
+		printf ("KSM: %zu frames merged\n", ksm_merged);
+}
+
+/* Free the page.  Pages come from vm_page_cache. */
+void
+vm_dealloc_page (struct page *page) {
+	destroy (page);
+	kmem_cache_free (vm_page_cache, page);
+}
+
+/*** Dongdongbro ***/
+/* Claim the page that allocate on VA. */
+// va를 할당하기 위해 페이지를 선언한다.
+bool
+vm_claim_page (void *va) {
+	struct page *page = spt_get_page(&thread_current()->leader->spt, va);
+	/* TODO: Fill this function */
+
+	if (page != NULL) {
+		return vm_do_claim_page (page);
+	}
+	return false;
+}
+
+/*** haein ***/
+/* Claim the PAGE and set up the mmu. */
+/* 페이지 값을 넘겨 받고, 그 페이지와 get frame에서 물리 메모리 공간을 페이지와 연결 시켜준다. */
+static bool
+vm_do_claim_page (struct page *page) { // 이미 만들어진 page => 매핑
+	struct frame *shared;
+	bool success = false;
+
+	if (VM_TYPE (page->operations->type) == VM_SHM)
+		return vm_map_shm (page);
+
+	/* 다른 프로세스가 이미 읽어 둔 파일 위치면 frame을 새로 받지 않는다. */
+	lock_acquire (&frame_lock);
+	shared = cache_find (page);
+	if (shared != NULL)
+		success = vm_map_shared (page, shared);
+	lock_release (&frame_lock);
+	if (shared != NULL)
+		return success;
+
+	/* initializer 없는 anonymous page(stack 등)는 처음에 0으로 채워져 있어야 한다. */
+	return vm_map_frame (page, vm_get_frame (page_is_zero_fill (page)));
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 page cache로 다른 page와 같은 frame을 쓸 수 있으면 그 내용이 있는 파일의
+ * inode를 리턴하고 위치와 채울 바이트 수를 OFS, READ_BYTES에 넣는다. 아니면 NULL이다.
+ * - mmap 한 file page. 아직 uninit이면 lazy_info이고 이미 file page면 file_page인데
+ *   둘의 앞부분은 같은 모양이다. fork가 부모의 page에서 복사해 올
+ *   page(initializer 없음)는 파일에서 읽지 않으므로 뺀다.
+ * - 아직 읽지 않은 read-only segment page. 실행 파일이 돌고 있는 동안은 쓰기가
+ *   막혀 있어서 내용이 바뀌지 않는다. lazy_load_segment처럼 지금 스레드의
+ *   running에서 읽는다. */
+static struct inode *
+page_file_key (struct page *page, off_t *ofs, size_t *read_bytes) {
+	enum vm_type type = VM_TYPE (page->operations->type);
+	const struct lazy_info *info = NULL;
+	struct file *file = NULL;
+
+	if (type == VM_FILE) {
+		info = (const struct lazy_info *) &page->file;
+		file = info->file;
+	} else if (type == VM_UNINIT && page->uninit.init != NULL) {
+		info = page->uninit.aux;
+		if (VM_TYPE (page->uninit.type) == VM_FILE)
+			file = info->file;
+		else if (page->uninit.type == VM_SEG && !page->writable)
+			file = thread_current ()->leader->running;
+	}
+	if (file == NULL)
+		return NULL;
+	*ofs = info->ofs;
+	*read_bytes = info->read_bytes;
+	return file_get_inode (file);
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 읽을 파일 위치를 이미 담고 있는 frame을 page cache에서 찾는다.
+ * 그 frame이 evict 중이거나 아직 읽는 중이면 끝날 때까지 기다린다. 파일 길이가
+ * 달라져서 채울 바이트 수가 다르면 같이 쓰지 않는다. frame_lock을 잡고 불러야 한다. */
+static struct frame *
+cache_find (struct page *page) {
+	struct inode *inode;
+	off_t ofs;
+	size_t read_bytes;
+	struct frame *frame;
+
+	inode = page_file_key (page, &ofs, &read_bytes);
+	if (inode == NULL)
+		return NULL;
+	while ((frame = page_cache_lookup (inode, ofs)) != NULL && frame->evicting)
+		cond_wait (&frame_evicted, &frame_lock);
+	return frame != NULL && frame->file_bytes == read_bytes ? frame : NULL;
+}
+
+/*** GrilledSalmon ***/
+/* 파일에서 읽어 올 PAGE의 새 FRAME을 page cache에 넣는다. 읽는 동안은 evicting으로
+ * 두어서 같은 위치의 fault가 cache_find에서 기다린다. frame_lock을 잡고 불러야 한다. */
+static void
+cache_insert (struct page *page, struct frame *frame) {
+	frame->inode = page_file_key (page, &frame->file_ofs, &frame->file_bytes);
+	if (frame->inode == NULL)
+		return;
+	if (page_cache_insert (frame))
+		frame->evicting = true;
+	else
+		frame->inode = NULL;	// 채울 바이트 수가 다른 frame이 있다. 혼자 쓴다.
+}
+
+/*** GrilledSalmon ***/
+/* PAGE를 page cache에서 찾은 FRAME에 연결하고 매핑한다. 아직 uninit이면 initializer로
+ * 타입만 바꾸고 읽지 않는다. 실패해도 연결은 남겨서 page의 destroy가 정리한다.
+ * frame_lock을 잡고 불러야 한다. */
+static bool
+vm_map_shared (struct page *page, struct frame *frame) {
+	struct thread *t = thread_current();
+
+	if (VM_TYPE (page->operations->type) == VM_UNINIT) {
+		struct lazy_info *lazy_info = page->uninit.aux;
+
+		page->uninit.page_initializer (page, page->uninit.type, NULL);
+		kmem_cache_free (lazy_info_cache, lazy_info);	// init이 할 일
+	}
+	page->owner = t->leader;
+	frame_link (frame, page);
+	page->pml4 = t->pml4;
+	if (page->writable)
+		page_cache_mark_dirty (frame);
+	return pml4_get_page (t->pml4, page->va) == NULL
+		&& pml4_set_page (t->pml4, page->va, frame->kva, page->writable);
+}
+
+/*** GrilledSalmon ***/
+/* shared memory page인 PAGE를 segment의 frame에 매핑한다. anchor가 frame에 없으면
+ * 새 frame을 anchor에 먼저 연결하고 anchor의 slot에서(처음이면 0으로) 채운다.
+ * 채우는 동안은 evicting으로 두어서 같은 segment page의 다른 fault가 기다린다. */
+static bool
+vm_map_shm (struct page *page) {
+	struct thread *t = thread_current ();
+	struct page *anchor = shm_anchor (page);
+	struct frame *frame, *fresh = NULL;
+	bool success;
+
+	lock_acquire (&frame_lock);
+	while ((frame = frame_wait (anchor)) == NULL) {
+		if (fresh == NULL) {
+			lock_release (&frame_lock);
+			fresh = vm_get_frame (false);
+			lock_acquire (&frame_lock);
+			continue;	// frame을 받는 사이 다른 프로세스가 채웠을 수 있다.
+		}
+		frame_link (fresh, anchor);
+		fresh->evicting = true;
+		lock_release (&frame_lock);
+		swap_in (anchor, fresh->kva);
+		lock_acquire (&frame_lock);
+		vm_frame_clear_dirty (fresh);
+		fresh->evicting = false;
+		fresh->pin_cnt--;
+		cond_broadcast (&frame_evicted, &frame_lock);
+		fresh = NULL;
+	}
+	if (fresh != NULL) {
+		fresh->pin_cnt--;
+		frame_release (fresh);
+	}
+	page->owner = t->leader;
+	frame_link (frame, page);
+	page->pml4 = t->pml4;
+	success = pml4_get_page (t->pml4, page->va) == NULL
+		&& pml4_set_page (t->pml4, page->va, frame->kva, page->writable);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/*** haein ***/
+/* PAGE를 막 받은 FRAME에 연결하고 매핑한 뒤 내용을 채운다. 실패하면 frame을 해제한다. */
+static bool
+vm_map_frame (struct page *page, struct frame *frame) {
+	struct thread *t = thread_current();
+	struct frame *shared;
+	bool success;
+
+	/* Set links */
+	lock_acquire (&frame_lock);
+	/* frame을 받는 사이 다른 프로세스가 같은 파일 위치를 읽어 두었을 수 있다. */
+	shared = cache_find (page);
+	if (shared != NULL) {
+		frame->pin_cnt--;
+		frame_release (frame);
+		success = vm_map_shared (page, shared);
+		lock_release (&frame_lock);
+		return success;
+	}
+	cache_insert (page, frame);
+	page->owner = t->leader;
+	frame_link (frame, page);
+	page->pml4 = t->pml4;
+	if (frame->inode != NULL && page->writable)
+		page_cache_mark_dirty (frame);
+	lock_release (&frame_lock);
+
+	/* TODO: Insert page table entry to map page's VA to frame's PA. */
+	if (pml4_get_page (t->pml4, page->va) == NULL && pml4_set_page(t->pml4, page->va, frame->kva, page->writable)) { /*** 고민 필요!!! - true? ***/
+		success = swap_in (page, frame->kva); // page fault가 일어났을 때 swap in
+		lock_acquire (&frame_lock);
+		/* swap in 하면서 kva로 쓴 것은 수정이 아니다. 이제부터의 쓰기만 dirty로 본다. */
+		if (success)
+			vm_frame_clear_dirty (frame);
+		else if (frame->inode != NULL)
+			page_cache_remove (frame);	// 못 읽은 내용을 다른 프로세스가 쓰지 않게
+		frame->pin_cnt--;
+		frame->evicting = false;
+		cond_broadcast (&frame_evicted, &frame_lock);
+		lock_release (&frame_lock);
+		return success;
+	} else { // 만약 page fault에서 호출했는데 실패했으면 바로 프로세스 종료
+		// 나중에 vm_dealloc_page 써야 할듯? /*** GriiledSalmon ***/
+		lock_acquire (&frame_lock);
+		frame->evicting = false;
+		cond_broadcast (&frame_evicted, &frame_lock);
+		lock_release (&frame_lock);
+		frame_discard (page);
+		return false;
+	}
+}
+
+/*** Dongdongbro ***/
+/* Initialize new supplemental page table */
+void
+supplemental_page_table_init (struct supplemental_page_table *spt) {
+	/*** 고민 필요!!!(init이 두번 불릴 경우를 고려) ***/
+	/*
+	if(spt->h != NULL){
+		free(spt->h);
+	}
+	*/
+
+
+	if (!ohash_init(&spt->h, page_hash, page_eq, NULL)){
+		PANIC("There are no memory in Kernel pool(malloc fail)");
+	}
+	avl_init(&spt->vmas, vma_less, NULL);
+	spt->last = NULL;
+	lock_init (&spt->lock);
+}
+
+/*** GrilledSalmon ***/
+/* fork: 자식의 mmap VMA나 page가 부모와 같은 struct file과 참조 수 REMAIN_CNT를
+ * 같이 쓰도록 참조 하나를 더한다. 파일을 새로 열지 않으므로 fork 비용이 mmap 수에
+ * 따라 늘지 않는다. */
+static void share_parent_file (int *remain_cnt) {
+	__atomic_add_fetch (remain_cnt, 1, __ATOMIC_RELAXED);
+}
+
+/*** GrilledSalmon ***/
+/* fork: 아직 uninit인 anon page DST가 SRC의 frame을 read-only로 같이 쓰게 한다(COW).
+ * SRC가 swap out 되어 있으면 swap slot을 같이 쓴다. 쓰기 fault가 나면
+ * vm_handle_wp가 그때 복사한다. */
+static bool
+vm_share_page (struct page *dst, struct page *src) {
+	struct frame *frame;
+	bool success = true;
+
+	/* uninit -> anon. initializer가 없는 anon page라 kva를 건드리지 않는다. */
+	if (!swap_in (dst, NULL))
+		return false;
+
+	lock_acquire (&frame_lock);
+	frame = frame_wait (src);
+	if (frame != NULL) {
+		struct list_elem *e;
+
+		/* 이미 고쳐진 frame이면 slot의 사본은 낡았다. */
+		if (vm_frame_is_dirty (frame)) {
+			for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+				anon_drop_slot (list_entry (e, struct page, frame_elem));
+			vm_frame_clear_dirty (frame);
+		}
+		if (src->writable)
+			success = page_remap (src, frame, false);
+		dst->owner = thread_current ()->leader;
+		frame_link (frame, dst);
+		dst->pml4 = thread_current ()->pml4;
+		success = success && pml4_set_page (dst->pml4, dst->va, frame->kva, false);
+	}
+	anon_share_slot (dst, src);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* fork: SRC의 내용을 DST가 새로 받은 frame에 복사한다. SRC가 메모리에 없으면
+ * SRC의 swap_in으로 DST의 frame에 바로 읽어 온다. */
+static bool
+vm_copy_page (struct page *dst, struct page *src) {
+	struct frame *frame = vm_frame_pin (src);
+	bool success = true;
+
+	if (frame != NULL) {
+		copy_page (dst->frame->kva, frame->kva);
+		lock_acquire (&frame_lock);
+		frame->pin_cnt--;
+		lock_release (&frame_lock);
+	} else
+		success = swap_in (src, dst->frame->kva);
+	return success;
+}
+
+/*** GrilledSalmon ***/
+/* 메시지 channel이 page를 프로세스 사이에 복사하지 않고 옮길 때 쓰는 carrier.
+ * carrier는 spt에도 pml4에도 없는 anon page다. 보내는 쪽 page의 frame에 shm의
+ * anchor처럼 pml4 없이 연결되고, 받는 쪽이 자기 page를 그 frame에 연결하면
+ * 없어진다. 그 사이 frame은 pin 해 두어서 evict나 ksm이 carrier를 건드리지
+ * 않는다. 보낸 page는 fork처럼 read-only가 되므로 보낸 쪽이 계속 쓰면
+ * vm_handle_wp가 복사하고(COW), 이미 떼어냈으면 받는 쪽이 복사 없이 쓰기 권한만
+ * 받는다. frame이 없으면 slot을 같이 쓰고, 둘 다 없으면 0인 page다. */
+
+/* 현재 프로세스의 VA에 있는 anon page의 내용을 나르는 carrier를 만든다. 아직
+ * 0으로 시작하는 page이면 빈 carrier다. anon page가 아니거나 메모리가 모자라면
+ * NULL이고, 그때는 복사해서 보내야 한다. */
+struct page *
+vm_carrier_create (void *va) {
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	bool locked = spt_lock (spt);
+	struct page *src = spt_get_page (spt, va);
+	struct page *carrier = NULL;
+	struct frame *frame;
+
+	if (src == NULL || (!page_is_zero_fill (src)
+				&& VM_TYPE (src->operations->type) != VM_ANON))
+		goto done;
+	carrier = kmem_cache_alloc (vm_page_cache);
+	if (carrier == NULL)
+		goto done;
+	memset (carrier, 0, sizeof *carrier);
+	anon_initializer (carrier, VM_ANON, NULL);
+	if (VM_TYPE (src->operations->type) != VM_ANON)
+		goto done;
+
+	lock_acquire (&frame_lock);
+	frame = frame_wait (src);
+	if (frame != NULL && frame != &zero_frame) {
+		struct list_elem *e;
+
+		/* vm_share_page처럼 이미 고쳐진 frame이면 slot의 사본은 낡았다. */
+		if (vm_frame_is_dirty (frame)) {
+			for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+				anon_drop_slot (list_entry (e, struct page, frame_elem));
+			vm_frame_clear_dirty (frame);
+		}
+		if (src->writable && !page_remap (src, frame, false)) {
+			lock_release (&frame_lock);
+			kmem_cache_free (vm_page_cache, carrier);
+			carrier = NULL;
+			goto done;
+		}
+		frame_link (frame, carrier);
+		frame->pin_cnt++;
+	}
+	if (frame != &zero_frame)
+		anon_share_slot (carrier, src);
+	lock_release (&frame_lock);
+done:
+	spt_unlock (spt, locked);
+	return carrier;
+}
+
+/* CARRIER의 내용을 KVA에 복사한다. CARRIER는 그대로 남는다. */
+void
+vm_carrier_read (struct page *carrier, void *kva) {
+	if (carrier->frame != NULL)
+		memcpy (kva, carrier->frame->kva, PGSIZE);
+	else if (carrier->anon.slot_number != -1)
+		swap_slot_load (carrier->anon.slot_number, kva);
+	else
+		memset (kva, 0, PGSIZE);
+}
+
+/* CARRIER를 놓는다. frame을 쓰는 page가 더 없으면 frame도 해제한다. */
+void
+vm_carrier_free (struct page *carrier) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = carrier->frame;
+	if (frame != NULL) {
+		frame_unlink (carrier);
+		frame->pin_cnt--;
+		if (frame->page_cnt == 0 && frame->pin_cnt == 0)
+			frame_release (frame);
+	}
+	lock_release (&frame_lock);
+	swap_slot_put (carrier->anon.slot_number);
+	kmem_cache_free (vm_page_cache, carrier);
+}
+
+/* 현재 프로세스의 VA에 있는 쓸 수 있는 anon page를 CARRIER가 나르는 내용으로
+ * 바꾼다. 새 page는 carrier의 frame을 read-only로 같이 쓰고, 처음 쓸 때
+ * vm_handle_wp가 나눈다. CARRIER는 성공하면 없어진다. 그런 page가 아니면
+ * false이고, 그때는 vm_carrier_read로 복사해서 받는다. */
+bool
+vm_carrier_map (struct page *carrier, void *va) {
+	struct thread *t = thread_current ();
+	struct supplemental_page_table *spt = &t->leader->spt;
+	bool locked = spt_lock (spt);
+	struct page *old = spt_get_page (spt, va), *page;
+	struct frame *frame;
+	enum vm_type aux = 0;
+	bool success = true;
+	void *kva;
+
+	if (old == NULL || !old->writable)
+		success = false;
+	else if (page_is_zero_fill (old))
+		aux = VM_AUXTYPE (old->uninit.type);
+	else if (VM_TYPE (old->operations->type) == VM_ANON)
+		aux = old->anon.aux_type;
+	else
+		success = false;
+	if (!success) {
+		spt_unlock (spt, locked);
+		return false;
+	}
+
+	/* vm_drop_page처럼 원래 page를 버린다. frame을 혼자 쓰고 있었으면
+	 * vm_free_frame은 매핑과 kva를 남겨 둔다. */
+	spt_remove_page (spt, old);
+	kva = pml4_get_page (t->pml4, va);
+	if (kva != NULL) {
+		pml4_clear_page (t->pml4, va);
+		palloc_free_page (kva);
+	}
+	if (!vm_alloc_page (VM_ANON | aux, va, true))
+		PANIC ("channel: cannot re-create page");
+	page = spt_find_page (spt, va);
+
+	/* 빈 carrier면 0으로 시작하는 page로 둔다. */
+	if (carrier->frame != NULL || carrier->anon.slot_number != -1) {
+		/* uninit -> anon. initializer가 없는 anon page라 kva를 건드리지 않는다. */
+		if (!swap_in (page, NULL))
+			PANIC ("channel: cannot initialize page");
+		lock_acquire (&frame_lock);
+		frame = carrier->frame;
+		if (frame != NULL) {
+			page->owner = t->leader;
+			frame_link (frame, page);
+			page->pml4 = t->pml4;
+			if (!pml4_set_page (t->pml4, va, frame->kva, false))
+				PANIC ("channel: cannot map page");
+		}
+		anon_share_slot (page, carrier);
+		lock_release (&frame_lock);
+	}
+	spt_unlock (spt, locked);
+	vm_carrier_free (carrier);
+	return true;
+}
+
+/*** Dongdongbro & GrilledSalmon ***/
+/* Copy supplemental page table from src to dst */
+bool
+supplemental_page_table_copy (struct supplemental_page_table *dst, struct supplemental_page_table *src) {
+	struct ohash_iterator i;
+	struct avl_elem *e;
+
+	/* mmap 영역. 부모의 VMA, page와 같은 file, 같은 참조 수를 쓴다. */
+	for (e = avl_first(&src->vmas); e != NULL; e = avl_next(e)) {
+		struct vma *src_vma = avl_entry(e, struct vma, elem);
+		struct vma *dst_vma = malloc(sizeof *dst_vma);
+		if (dst_vma == NULL)
+			return false;
+		*dst_vma = *src_vma;
+		if (src_vma->file.file != NULL)
+			share_parent_file(src_vma->file.remain_cnt);
+		if (src_vma->shm != NULL)
+			shm_seg_share(src_vma->shm);
+		vma_insert(dst, dst_vma);
+	}
+
+	/* 부모의 page 수만큼 한 번에 키워 두고 복사한다. */
+	ohash_reserve (&dst->h, ohash_size (&src->h));
+	ohash_first (&i, &src->h);
+	while (ohash_next(&i)){
+		struct page *src_page = ohash_entry(ohash_cur(&i), struct page, hash_elem);
+		enum vm_type type = VM_TYPE (src_page->operations->type);
+		struct lazy_info *dst_lazy_info;
+		struct page *dst_page;
+
+		switch (type)
+		{
+		case VM_UNINIT :
+		{
+			struct lazy_info *src_lazy_info = src_page->uninit.aux;
+			dst_lazy_info = NULL;	// zero-fill page는 aux가 없다.
+			if (src_lazy_info != NULL) {
+				dst_lazy_info = kmem_cache_alloc(lazy_info_cache);
+				if (dst_lazy_info == NULL)
+					return false;
+				memcpy(dst_lazy_info, src_lazy_info, sizeof(struct lazy_info));
+			}
+			if(!vm_alloc_page_with_initializer(src_page->uninit.type, src_page->va, src_page->writable, src_page->uninit.init, dst_lazy_info)){
+				return false;
+			};
+			if (src_page->uninit.type == VM_FILE)
+				share_parent_file(src_lazy_info->remain_cnt);
+		}
+			break;
+
+		case VM_ANON :
+		{	
+			/* 복사하지 않고 frame을 공유한다(COW). */
+			if(!vm_alloc_page(type | src_page->anon.aux_type, src_page->va, src_page->writable)){
+				return false;
+			};
+			dst_page = spt_find_page(dst, src_page->va);
+			if (!vm_share_page(dst_page, src_page))
+				return false;
+		}
+			break;
+
+		case VM_FILE :
+		{
+			struct frame *frame;
+			bool shared;
+
+			/* page cache에 있거나 메모리에 없는 page는 파일에 있는 내용이 최신이다.
+			 * 자식도 fault가 나면 같은 frame을 쓰거나 파일에서 읽는다. */
+			lock_acquire (&frame_lock);
+			frame = frame_wait (src_page);
+			shared = frame == NULL || frame->inode != NULL;
+			lock_release (&frame_lock);
+			if (shared) {
+				dst_lazy_info = kmem_cache_alloc(lazy_info_cache);
+				if (dst_lazy_info == NULL)
+					return false;
+				memcpy(dst_lazy_info, &src_page->file, sizeof(struct lazy_info));
+				if (!vm_alloc_page_with_initializer(type, src_page->va, src_page->writable, lazy_load_file, dst_lazy_info))
+					return false;
+				share_parent_file(src_page->file.remain_cnt);
+				break;
+			}
+
+			if(!vm_alloc_page_with_initializer(type, src_page->va, src_page->writable, NULL, &src_page->file)){
+				return false;
+			};
+			share_parent_file(src_page->file.remain_cnt);
+			if (!vm_claim_page(src_page->va))
+				return false;
+			dst_page = spt_find_page(dst, src_page->va);
+			if (!vm_copy_page(dst_page, src_page))
+				return false;
+			/*** 부모의 dirty bit를 복사해줘야 할까? 고민 필요!!!!! ***/
+			break;
+		}
+
+		case VM_SHM :
+			/* 자식은 같은 segment를 가리키는 VMA를 물려받았으므로 fault가 나면
+			 * 같은 frame을 매핑한다. */
+			break;
+
+		default :
+			PANIC("Cached type");
+			break;
+		}
+	}
+	return true;
+}
+
+/*** GrilledSalmon ***/
+void spt_hash_destructor (struct ohash_elem *e, void *aux) {
+	struct page *page = ohash_entry(e, struct page, hash_elem);
+	/* filebacked할 때 수정 필요!!!(writeback) */
+
+	return vm_dealloc_page(page);
+}
+
+/*** GrilledSalmon ***/
+/* supplemental_page_table_kill의 첫 단계. anon page를 frame에서 떼어낸다. pml4는 곧
+ * 통째로 없어지므로 혼자 쓰던 frame의 PTE는 그대로 두어 pml4_destroy가 kva를
+ * 돌려주게 하고, 다른 page도 쓰는 frame만 TLB를 비우지 않고 PTE를 지운다.
+ * pin 된 frame은 anon_destroy에 맡긴다. frame_lock을 잡고 불러야 한다. */
+static void
+page_teardown_frame (struct ohash_elem *e, void *aux UNUSED) {
+	struct page *page = ohash_entry (e, struct page, hash_elem);
+	struct frame *frame;
+
+	if (VM_TYPE (page->operations->type) != VM_ANON)
+		return;
+	frame = frame_wait (page);
+	if (frame == NULL || frame->pin_cnt > 0)
+		return;
+	frame_unlink (page);
+	if (frame->page_cnt > 0 || frame == &zero_frame) {
+		pml4_forget_page (page->pml4, page->va);
+		return;
+	}
+	frame_table_remove (frame);
+	if (frame->inode != NULL)
+		page_cache_remove (frame);	// 공유하던 read-only segment page
+	kmem_cache_free (vm_frame_cache, frame);
+}
 
-	hash_destroy(&spt->h, spt_hash_destructor);
+/*** GrilledSalmon ***/
+/* Free the resource hold by the supplemental page table */
+/* 프로세스가 끝날 때 anon page의 frame은 frame_lock을, slot은 swap_lock을 한 번씩만
+ * 잡고 한꺼번에 놓은 뒤 page를 없앤다. 그러면 대부분의 anon_destroy는 놓을 것이
+ * 없다. mmap page는 file_backed_destroy가 하나씩 파일에 쓴다. 다른 프로세스가
+ * 바로 read()로 읽을 수 있어야 하므로 daemon에 미루지 않는다. */
+void
+supplemental_page_table_kill (struct supplemental_page_table *spt) {
+	/* TODO: Destroy all the supplemental_page_table hold by thread and
+	 * TODO: writeback all the modified contents to the storage. */
+
+	lock_acquire (&frame_lock);
+	ohash_apply (&spt->h, page_teardown_frame);
+	lock_release (&frame_lock);
+	anon_drop_slots (&spt->h);
+	spt->last = NULL;
+	ohash_destroy(&spt->h, spt_hash_destructor);
+	while (!avl_empty(&spt->vmas)) {
+		struct vma *vma = avl_entry(avl_first(&spt->vmas), struct vma, elem);
+		vma_remove(spt, vma);
+		vma_destroy(vma);
+	}
 }
 
 
 /*** haein ***/
 /* Returns the page containing the given virtual address, or a null pointer if no such page exists. */
 struct page *
-page_lookup (struct hash *h, const void *va) {
+page_lookup (struct ohash *h, const void *va) {
   struct page p;
-  struct hash_elem *e;
+  struct ohash_elem *e;
 
   p.va = pg_round_down(va); // offset을 0으로 만들고 페이지 주소를 받아옴
 
-  e = hash_find (h, &p.hash_elem);
-  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+  e = ohash_find (h, &p.hash_elem);
+  return e != NULL ? ohash_entry (e, struct page, hash_elem) : NULL;
 }
 
 /*** Dongdongbro ***/
 /* Returns a hash value for page p. */
-unsigned
-page_hash (const struct hash_elem *h_elem, void *aux UNUSED) {
-  const struct page *p = hash_entry (h_elem, struct page, hash_elem);
-  return hash_bytes (&p->va, sizeof p->va);
+uint64_t
+page_hash (const struct ohash_elem *h_elem, void *aux UNUSED) {
+  const struct page *p = ohash_entry (h_elem, struct page, hash_elem);
+  return hash_ptr (p->va);
 }
 
 /*** Dongdongbro ***/
-/* Returns true if page a precedes page b. */
+/* Returns true if page a and page b map the same address. */
 bool
-page_less (const struct hash_elem *h_elem1,
-           const struct hash_elem *h_elem2, void *aux UNUSED) {
-  const struct page *a = hash_entry (h_elem1, struct page, hash_elem);
-  const struct page *b = hash_entry (h_elem2, struct page, hash_elem);
+page_eq (const struct ohash_elem *h_elem1,
+         const struct ohash_elem *h_elem2, void *aux UNUSED) {
+  const struct page *a = ohash_entry (h_elem1, struct page, hash_elem);
+  const struct page *b = ohash_entry (h_elem2, struct page, hash_elem);
 
-  return a->va < b->va;
+  return a->va == b->va;
 }
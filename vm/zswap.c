@@ -0,0 +1,271 @@
+/* zswap.c: Compressed in-memory cache in front of the swap disk. */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "threads/vmalloc.h"
+
+#define WORDS_PER_PAGE (PGSIZE / sizeof (uint64_t))
+
+/* 압축해도 이보다 크면 그냥 디스크에 쓴다. */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 4)
+
+/*** GrilledSalmon ***/
+/* 압축된 page 하나. 모든 word가 같은 값인 page는 VALUE만 가지고,
+ * 나머지는 DATA에 zero-run 형식으로 담는다: zswap_run 헤더 뒤에
+ * LITS개의 word가 오는 것이 page 끝까지 반복된다. */
+struct zswap_entry {
+	struct list_elem elem;      /* lru의 원소. */
+	size_t slot;                /* 이 page의 swap slot. */
+	size_t len;                 /* DATA의 byte 수. same-filled이면 0. */
+	uint64_t value;             /* same-filled page의 word. */
+	uint8_t data[];
+};
+
+/* ZEROS개의 0 word 뒤에 LITS개의 literal word가 온다. */
+struct zswap_run {
+	uint16_t zeros;
+	uint16_t lits;
+};
+
+size_t zswap_limit_kb;
+
+static struct zswap_entry **entries;    /* slot -> entry. 없으면 NULL. */
+static struct list lru;                 /* 오래된 entry가 앞에 온다. */
+static size_t used_bytes;               /* 모든 entry가 차지하는 byte 수. */
+static zswap_writeback_func *writeback_page;
+/* 압축과 write back에 쓰는 page 크기 buffer. zswap_lock이 보호한다. */
+static uint64_t scratch[WORDS_PER_PAGE];
+/* entries, lru, used_bytes, scratch와 통계를 보호한다. */
+static struct lock zswap_lock;
+
+/* 통계. */
+static size_t stored_cnt;       /* cache에 넣은 page 수. */
+static size_t same_cnt;         /* 그중 same-filled page 수. */
+static size_t reject_cnt;       /* 압축이 잘 안 되어 디스크로 보낸 수. */
+static size_t writeback_cnt;    /* cache가 차서 디스크로 내보낸 수. */
+
+/*** GrilledSalmon ***/
+/* SLOT_CNT개의 swap slot을 위한 cache를 준비한다. WRITEBACK은 밀려나는
+ * page를 디스크에 쓸 때 부른다. zswap_limit_kb가 0이면 아무것도 하지 않는다. */
+void
+zswap_init (size_t slot_cnt, zswap_writeback_func *writeback) {
+	if (zswap_limit_kb == 0)
+		return;
+	entries = kvcalloc (slot_cnt, sizeof *entries);
+	if (entries == NULL)
+		PANIC ("zswap table allocation failed");
+	list_init (&lru);
+	lock_init (&zswap_lock);
+	writeback_page = writeback;
+}
+
+/*** GrilledSalmon ***/
+/* PAGE가 모두 같은 word로 채워져 있으면 true를 리턴하고 그 값을 *VALUE에 담는다. */
+static bool
+page_same_filled (const uint64_t *page, uint64_t *value) {
+	size_t i;
+
+	for (i = 1; i < WORDS_PER_PAGE; i++)
+		if (page[i] != page[0])
+			return false;
+	*value = page[0];
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* PAGE를 zero-run 형식으로 scratch에 압축해 길이를 리턴한다.
+ * ZSWAP_MAX_LEN을 넘으면 0을 리턴한다. */
+static size_t
+page_compress (const uint64_t *page) {
+	uint8_t *out = (uint8_t *) scratch;
+	size_t len = 0, i = 0;
+
+	while (i < WORDS_PER_PAGE) {
+		struct zswap_run run = { 0, 0 };
+
+		while (i < WORDS_PER_PAGE && page[i] == 0) {
+			run.zeros++;
+			i++;
+		}
+		/* literal은 다음 0 word 전까지 간다. */
+		while (i + run.lits < WORDS_PER_PAGE && page[i + run.lits] != 0)
+			run.lits++;
+		if (len + sizeof run + run.lits * sizeof (uint64_t) > ZSWAP_MAX_LEN)
+			return 0;
+		memcpy (out + len, &run, sizeof run);
+		len += sizeof run;
+		memcpy (out + len, page + i, run.lits * sizeof (uint64_t));
+		len += run.lits * sizeof (uint64_t);
+		i += run.lits;
+	}
+	return len;
+}
+
+/*** GrilledSalmon ***/
+/* ENTRY를 풀어서 PAGE에 채운다. */
+static void
+entry_decompress (const struct zswap_entry *entry, uint64_t *page) {
+	const uint8_t *in = entry->data;
+	size_t i = 0;
+
+	if (entry->len == 0) {
+		for (i = 0; i < WORDS_PER_PAGE; i++)
+			page[i] = entry->value;
+		return;
+	}
+	while (i < WORDS_PER_PAGE) {
+		struct zswap_run run;
+
+		memcpy (&run, in, sizeof run);
+		in += sizeof run;
+		memset (page + i, 0, run.zeros * sizeof (uint64_t));
+		i += run.zeros;
+		memcpy (page + i, in, run.lits * sizeof (uint64_t));
+		in += run.lits * sizeof (uint64_t);
+		i += run.lits;
+	}
+	ASSERT (in == entry->data + entry->len);
+}
+
+/*** GrilledSalmon ***/
+/* ENTRY가 차지하는 메모리. */
+static size_t
+entry_size (const struct zswap_entry *entry) {
+	return sizeof *entry + entry->len;
+}
+
+/*** GrilledSalmon ***/
+/* ENTRY를 cache에서 빼고 해제한다. zswap_lock을 잡고 불러야 한다. */
+static void
+entry_remove (struct zswap_entry *entry) {
+	list_remove (&entry->elem);
+	entries[entry->slot] = NULL;
+	used_bytes -= entry_size (entry);
+	free (entry);
+}
+
+/*** GrilledSalmon ***/
+/* 상한 안에 들어올 때까지 가장 오래된 entry를 풀어서 디스크의 자기 slot에 쓴다.
+ * zswap_lock을 잡고 불러야 한다. 쓰는 동안 lock을 쥐고 있으므로 그 slot을
+ * load 하려는 쪽은 write가 끝난 뒤에 디스크에서 읽는다. */
+static void
+shrink (void) {
+	while (used_bytes > zswap_limit_kb * 1024 && !list_empty (&lru)) {
+		struct zswap_entry *entry = list_entry (list_front (&lru), struct zswap_entry, elem);
+
+		entry_decompress (entry, scratch);
+		writeback_page (entry->slot, scratch);
+		writeback_cnt++;
+		entry_remove (entry);
+	}
+}
+
+/*** GrilledSalmon ***/
+/* SLOT에 들어갈 PAGE를 압축해서 cache에 넣는다. 넣었으면 true를 리턴하고,
+ * zswap이 꺼져 있거나 압축이 잘 안 되거나 메모리가 없으면 false를 리턴한다.
+ * false이면 부른 쪽이 직접 디스크에 써야 한다. */
+bool
+zswap_store (size_t slot, const void *page) {
+	struct zswap_entry *entry;
+	uint64_t value = 0;
+	size_t len = 0;
+
+	if (entries == NULL)
+		return false;
+
+	lock_acquire (&zswap_lock);
+	ASSERT (entries[slot] == NULL);
+	if (!page_same_filled (page, &value)) {
+		len = page_compress (page);
+		if (len == 0) {
+			reject_cnt++;
+			lock_release (&zswap_lock);
+			return false;
+		}
+	}
+	entry = malloc (sizeof *entry + len);
+	if (entry == NULL) {
+		lock_release (&zswap_lock);
+		return false;
+	}
+	entry->slot = slot;
+	entry->len = len;
+	entry->value = value;
+	memcpy (entry->data, scratch, len);
+
+	entries[slot] = entry;
+	list_push_back (&lru, &entry->elem);
+	used_bytes += entry_size (entry);
+	stored_cnt++;
+	if (len == 0)
+		same_cnt++;
+	shrink ();
+	lock_release (&zswap_lock);
+	return true;
+}
+
+/*** GrilledSalmon ***/
+/* SLOT이 cache에 있으면 PAGE에 풀고 true를 리턴한다. 없으면 false를 리턴하고
+ * 부른 쪽이 디스크에서 읽는다. entry는 slot이 해제될 때까지 남겨 둔다. */
+bool
+zswap_load (size_t slot, void *page) {
+	struct zswap_entry *entry;
+
+	if (entries == NULL)
+		return false;
+
+	lock_acquire (&zswap_lock);
+	entry = entries[slot];
+	if (entry != NULL)
+		entry_decompress (entry, page);
+	lock_release (&zswap_lock);
+	return entry != NULL;
+}
+
+/*** GrilledSalmon ***/
+/* SLOT의 내용이 cache에 있으면 true. 그동안은 디스크의 slot이 낡았을 수 있다. */
+bool
+zswap_contains (size_t slot) {
+	bool found;
+
+	if (entries == NULL)
+		return false;
+
+	lock_acquire (&zswap_lock);
+	found = entries[slot] != NULL;
+	lock_release (&zswap_lock);
+	return found;
+}
+
+/*** GrilledSalmon ***/
+/* 해제되는 SLOT의 entry가 있으면 버린다. */
+void
+zswap_invalidate (size_t slot) {
+	if (entries == NULL)
+		return;
+
+	lock_acquire (&zswap_lock);
+	if (entries[slot] != NULL)
+		entry_remove (entries[slot]);
+	lock_release (&zswap_lock);
+}
+
+/*** GrilledSalmon ***/
+/* Prints zswap statistics. */
+void
+zswap_print_stats (void) {
+	if (entries == NULL)
+		return;
+	printf ("Zswap: %zu pages stored (%zu same-filled), %zu rejected, "
+			"%zu written back, %zu/%zu KB in use\n",
+			stored_cnt, same_cnt, reject_cnt, writeback_cnt,
+			DIV_ROUND_UP (used_bytes, 1024), zswap_limit_kb);
+}